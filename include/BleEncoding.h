@@ -0,0 +1,81 @@
+#ifndef BLE_ENCODING_H
+#define BLE_ENCODING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file BleEncoding.h
+ * @brief BLE特征值的二进制编码: IEEE-11073 16位 SFLOAT 与带序号、时间戳的测量包。
+ * * SFLOAT: 高4位为有符号指数 (-8..7)，低12位为有符号尾数，值 = 尾数 × 10^指数。
+ *   尾数 0x07FF / 0x0800 / 0x07FE / 0x0802 / 0x0801 分别表示 NaN / NRes / +INF / -INF / 保留。
+ * * 测量包格式 (小端序，心率 / 血氧 / 血糖特征值共用):
+ *     0  version      u8   kMeasurementPacketVersion
+ *     1  flags        u8   保留，写0
+ *     2  sequence     u16  每个特征值独立递增，客户端据此发现丢失的通知
+ *     4  timestamp    u32  测量时间 (RTC秒)
+ *     8  value        SFLOAT
+ * * 编码写入调用方提供的定长缓冲区，不分配堆内存。
+ */
+namespace BleEncoding {
+
+constexpr uint16_t kSfloatNaN = 0x07FF;
+constexpr uint16_t kSfloatNRes = 0x0800;
+constexpr uint16_t kSfloatPositiveInfinity = 0x07FE;
+constexpr uint16_t kSfloatNegativeInfinity = 0x0802;
+constexpr uint16_t kSfloatReserved = 0x0801;
+
+constexpr uint8_t kMeasurementPacketVersion = 1;
+constexpr size_t kMeasurementPacketSize = 10;
+
+/**
+ * @brief 将实数编码为SFLOAT，在尾数范围内取尽可能小的指数 (保留最多的有效数字)。
+ * * 绝对值过大时编码为 ±INF，NaN 编码为 NaN。
+ */
+uint16_t toSfloat(float value);
+
+/**
+ * @brief 将SFLOAT解码为实数 (NaN / NRes / 保留值解码为NaN，±INF解码为无穷大)。
+ */
+float fromSfloat(uint16_t sfloat);
+
+/**
+ * @brief 小端序写入/读取SFLOAT (供组合其他包格式使用)。
+ */
+inline void writeSfloat(uint8_t* p, float value) {
+    uint16_t s = toSfloat(value);
+    p[0] = (uint8_t)s;
+    p[1] = (uint8_t)(s >> 8);
+}
+
+inline float readSfloat(const uint8_t* p) {
+    return fromSfloat((uint16_t)(p[0] | (p[1] << 8)));
+}
+
+struct Measurement {
+    uint16_t sequence;
+    uint32_t timestamp;     // RTC秒
+    float value;
+};
+
+/**
+ * @brief 将一次测量编码为BLE通知包。
+ * @return size_t - 写入的字节数 (kMeasurementPacketSize)，out 容量不足时返回0。
+ */
+size_t encodeMeasurement(const Measurement& m, uint8_t* out, size_t capacity);
+
+/**
+ * @brief 解码测量包 (供测试与主机端工具使用)。
+ * @return bool - 长度或版本不符时返回false。
+ */
+bool decodeMeasurement(const uint8_t* packet, size_t length, Measurement* out);
+
+/**
+ * @brief 旧版客户端使用的文本格式 (两位小数，例如 "98.60")。
+ * @return size_t - 写入的字符数 (不含结尾的'\0')，容量不足时返回0。
+ */
+size_t formatText(float value, char* out, size_t capacity);
+
+} // namespace BleEncoding
+
+#endif // BLE_ENCODING_H
@@ -0,0 +1,221 @@
+#ifndef BLE_PERIPHERAL_H
+#define BLE_PERIPHERAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "BleTransport.h"
+#include "GlucoseRecordStore.h"
+#include "GlucoseService.h"
+#include "MpmcQueue.h"
+#include "RollupEngine.h"
+#include "VitalsPublisher.h"
+#include "WaveformStreamer.h"
+
+/**
+ * @class BlePeripheral
+ * @brief BLE外设的协议层: 数值特征值的编码、合并通知、标准血糖服务、原始波形流与模型更新写入，
+ *        与具体的BLE协议栈无关。
+ * * 通过 BleTransport 收发，固件中由 BluetoothController 按 BLE_USE_NIMBLE 选择传输层，
+ *   主机测试中使用假的传输层。
+ * * 波形特征值的写入 [mask u8] 开启对应的数据流: bit0 PPG (IR, Red)，bit1 光信号ADC；写入0关闭。
+ * * 降采样特征值的写入 [tier u8] 选择该层最新的一页，[tier u8][from u32] 选择从 from 开始的一页，
+ *   之后读取得到这一页 (格式见 RollupEngine.h)；新的读数到达时页的内容随之更新。
+ *   连接时默认为1分钟层的最新一页。
+ * * 线程模型: 只有一个任务拥有BLE (调用 poll()，固件中为 start() 启动的BLE任务)。
+ *   update*()/add*() 可在任意任务中调用，只把消息放入无锁队列后立即返回，从不阻塞；
+ *   连接、断开与MTU变化 (Listener 回调，在协议栈的任务中执行) 同样作为事件放入队列，
+ *   由 poll() 按顺序处理。队列满时丢弃新消息并计数，高水位见 getQueueStats()。
+ */
+class BlePeripheral : public BleTransport::Listener {
+public:
+    /**
+     * @brief 模型更新写入的处理函数 (见 ModelStore::handleUpdatePacket)，返回的状态字节通过同一特征值通知客户端。
+     */
+    typedef uint8_t (*UpdateHandler)(const uint8_t* packet, size_t length);
+
+    struct Config {
+        bool compositeNotifications;    // 数值与曲线只更新特征值，由 poll() 发送合并通知
+        bool textValues;                // 数值特征值使用文本 (旧版客户端)，否则为 SFLOAT 测量包
+        int recordsPerPoll;             // 每次 poll() 最多通过 RACP 上报的记录数
+        int maxCurvePoints;             // 预测曲线特征值的最大点数
+        VitalsPublisher::Config vitals;
+        uint8_t ppgPeriodMs;            // MAX30102 FIFO 的样本间隔 (毫秒)
+        int waveformFramesPerPoll;      // 每个波形流每次 poll() 最多发送的帧数
+    };
+
+    // 队列深度 (2的幂)。样本队列按一次测量的ADC批量 (64) 加上 PPG 在一个BLE任务周期内的样本留出余量
+    static constexpr size_t kPublishQueueDepth = 16;
+    static constexpr size_t kSampleQueueDepth = 256;
+    static constexpr size_t kEventQueueDepth = 8;
+
+    struct QueueStats {
+        size_t publishHighWater;        // 各队列出现过的最大长度
+        size_t sampleHighWater;
+        size_t eventHighWater;
+        uint32_t publishDropped;        // 因队列满而丢弃的消息数
+        uint32_t sampleDropped;
+        uint32_t eventDropped;
+    };
+
+    enum WaveformMask : uint8_t {
+        WAVEFORM_PPG = 0x01,
+        WAVEFORM_OPTICAL = 0x02
+    };
+
+    BlePeripheral(BleTransport& transport, const Config& config);
+    ~BlePeripheral();
+
+    /**
+     * @brief 初始化传输层并写入只读的特征值 (Glucose Feature)。
+     */
+    bool begin(const char* deviceName, uint16_t preferredMtu);
+
+    void setUpdateHandler(UpdateHandler handler);
+
+    /**
+     * @brief 启动拥有BLE的任务: 每 periodMs 调用一次 poll() (时间取 steady_clock 与 RTC)。
+     * @param core ESP32上固定的核心号 (-1 表示不固定)；主机上忽略。
+     * @param stackSize ESP32上的线程栈大小 (字节)；主机上忽略。
+     * @param priority ESP32上的任务优先级；主机上忽略。
+     */
+    bool start(int core, uint32_t stackSize, int priority, uint32_t periodMs);
+
+    /**
+     * @brief 停止BLE任务 (等待正在进行的 poll() 完成)。
+     */
+    void stop();
+
+    bool isRunning() const;
+
+    bool isConnected() const;
+
+    // 数值特征值 (任意任务); timestamp 为写入测量包的RTC秒。队列满时返回false
+    bool updateHeartRate(float heartRate, uint32_t timestamp);
+    bool updateSpO2(float spO2, uint32_t timestamp);
+    bool updateGlucose(float glucose, uint32_t timestamp);
+    bool updatePredictionCurve(const float* curveData, int curveSize, const float* lower, const float* upper);
+
+    // 原始波形样本 (任意任务)，对应的数据流未开启时忽略
+    void addPpgSample(uint32_t ir, uint32_t red, uint32_t timestampMs);
+    void addOpticalSample(uint16_t raw, uint32_t timestampMs);
+
+    /**
+     * @brief 是否有波形流已开启 (主循环据此更频繁地读取传感器FIFO)。
+     */
+    bool isWaveformStreaming() const;
+
+    const WaveformStreamer& getPpgStreamer() const;
+    const WaveformStreamer& getOpticalStreamer() const;
+
+    /**
+     * @brief 保存一条历史记录供 RACP 下载 (任意任务，在下一次 poll() 中写入记录存储)。
+     */
+    bool addGlucoseRecord(uint32_t timestamp, float glucose);
+
+    /**
+     * @brief 把一个读数加入降采样的各层 (任意任务，在下一次 poll() 中处理)。
+     */
+    bool addReading(uint32_t timestamp, float glucose);
+
+    /**
+     * @brief 处理队列中的事件与消息，发送合并通知与波形帧、处理挂起的 RACP 请求并继续上报记录
+     *        (只在拥有BLE的任务中调用)。
+     */
+    void poll(uint32_t nowMs, uint32_t timestamp);
+
+    QueueStats getQueueStats() const;
+
+    // 以下状态只在拥有BLE的任务中修改，其他任务读取时需先 stop()
+    const VitalsPublisher& getVitals() const;
+
+    /**
+     * @brief 降采样的各层。启动BLE任务之前可以直接写入 (例如从flash中的读数历史重建)。
+     */
+    RollupEngine& getRollups();
+
+    /**
+     * @brief GLS记录存储。启动BLE任务之前可以直接访问 (例如恢复持久化的序号)。
+     */
+    GlucoseRecordStore& getRecords();
+
+    // BleTransport::Listener (协议栈的任务中调用，只放入事件队列或邮箱)
+    void onConnect(uint32_t connectionIntervalMs) override;
+    void onDisconnect() override;
+    void onMtuChanged(uint16_t mtu) override;
+    void onWrite(GattSink::Characteristic characteristic, const uint8_t* data, size_t length) override;
+
+private:
+    struct Message {
+        enum Type : uint8_t { HEART_RATE, SPO2, GLUCOSE, CURVE, RECORD, READING } type;
+        uint8_t curveSize;
+        bool hasInterval;
+        uint32_t timestamp;
+        float value;
+        float curve[VitalsPublisher::kMaxCurvePoints];
+        float lower[VitalsPublisher::kMaxCurvePoints];
+        float upper[VitalsPublisher::kMaxCurvePoints];
+    };
+
+    struct Sample {
+        uint8_t stream;                 // WaveformCodec::Stream
+        uint32_t timestampMs;
+        int32_t values[2];
+    };
+
+    struct Event {
+        enum Type : uint8_t { CONNECTED, DISCONNECTED, MTU_CHANGED, WAVEFORM_MASK, MODEL_STATUS, ROLLUP_QUERY } type;
+        uint8_t argument;               // ROLLUP_QUERY: 层级，kRollupLatest 表示最新的一页
+        uint32_t value;                 // 连接间隔 (毫秒)、MTU、波形掩码、模型更新的状态字节或查询的起始时间
+    };
+
+    static constexpr uint8_t kRollupLatest = 0x80;
+
+    void postEvent(Event::Type type, uint32_t value, uint8_t argument = 0);
+    void refreshRollupPage();
+    void handleEvent(const Event& event);
+    void handleMessage(const Message& message);
+    void updateValue(GattSink::Characteristic characteristic, uint16_t& sequence, float value, uint32_t timestamp);
+    void publishCurve(const Message& message);
+    void publish(GattSink::Characteristic characteristic, const uint8_t* data, size_t length);
+    void run(uint32_t periodMs);
+
+    BleTransport& _transport;
+    Config _config;
+    UpdateHandler _updateHandler;
+
+    GlucoseRecordStore _records;
+    GlucoseService _glucoseService;
+    VitalsPublisher _vitals;
+    WaveformStreamer _ppg;
+    WaveformStreamer _optical;
+    RollupEngine _rollups;
+
+    MpmcQueue<Message, kPublishQueueDepth> _messages;
+    MpmcQueue<Sample, kSampleQueueDepth> _samples;
+    MpmcQueue<Event, kEventQueueDepth> _events;
+    // 事件队列溢出: 下一次 poll() 按传输层的连接状态重新同步
+    std::atomic<bool> _eventsLost;
+
+    // BLE任务
+    std::mutex _taskMutex;
+    std::condition_variable _taskWake;
+    std::thread _task;
+    std::atomic<bool> _running;
+
+    // 各数值特征值的序号，客户端据此发现丢失的通知
+    uint16_t _heartRateSequence;
+    uint16_t _spO2Sequence;
+    uint16_t _glucoseSequence;
+
+    // 降采样特征值当前的查询；_rollupDirty 表示页需要重新编码
+    RollupEngine::Tier _rollupTier;
+    uint32_t _rollupFrom;
+    bool _rollupLatest;
+    bool _rollupDirty;
+};
+
+#endif // BLE_PERIPHERAL_H
@@ -0,0 +1,52 @@
+#ifndef BLE_TRANSPORT_H
+#define BLE_TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "GattSink.h"
+
+/**
+ * @class BleTransport
+ * @brief BLE协议栈的传输层接口: 建立GATT服务、更新特征值、发送通知/指示，并把连接事件与写入交给 Listener。
+ * * 固件中按 BLE_USE_NIMBLE 选择 BluedroidTransport (Arduino BLE库) 或 NimbleTransport (NimBLE-Arduino)；
+ *   上层 (BlePeripheral) 只依赖本接口，主机测试中使用假的传输层。
+ * * Listener 的回调在协议栈的任务中执行，应尽快返回；isConnected() 可在任意任务中调用。
+ */
+class BleTransport : public GattSink {
+public:
+    class Listener {
+    public:
+        virtual ~Listener() {}
+        /**
+         * @param connectionIntervalMs 协商的连接间隔 (毫秒)。
+         */
+        virtual void onConnect(uint32_t connectionIntervalMs) = 0;
+        virtual void onDisconnect() = 0;
+        virtual void onMtuChanged(uint16_t mtu) = 0;
+        virtual void onWrite(Characteristic characteristic, const uint8_t* data, size_t length) = 0;
+    };
+
+    /**
+     * @brief 初始化协议栈，建立自定义服务与标准血糖服务并开始广播。
+     */
+    virtual bool begin(const char* deviceName, uint16_t preferredMtu, Listener* listener) = 0;
+
+    virtual bool isConnected() const = 0;
+
+    /**
+     * @brief 只更新特征值 (供客户端读取)，不发送通知。
+     */
+    virtual void setValue(Characteristic characteristic, const uint8_t* data, size_t length) = 0;
+
+    /**
+     * @brief 断开连接后重新开始广播 (由拥有BLE的任务在处理断开事件时调用，而不是在协议栈的回调中)。
+     */
+    virtual void startAdvertising() = 0;
+
+    /**
+     * @brief 协议栈名称，用于启动日志 ("Bluedroid" / "NimBLE")。
+     */
+    virtual const char* name() const = 0;
+};
+
+#endif // BLE_TRANSPORT_H
@@ -0,0 +1,23 @@
+#ifndef BLE_UUIDS_H
+#define BLE_UUIDS_H
+
+// UUIDs shared by the Bluedroid and NimBLE transports; clients find the characteristics by these
+// You can generate your own unique UUIDs using an online generator
+#define SERVICE_UUID           "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
+#define HEARTRATE_CHAR_UUID    "beb5483e-36e1-4688-b7f5-ea07361b26a8"
+#define SPO2_CHAR_UUID         "c8c36394-8f48-472e-874b-632467a83a21"
+#define GLUCOSE_CHAR_UUID      "9e3b7e4c-6a8a-479c-897c-b35d37af2137"
+#define PREDICTION_CHAR_UUID   "a2e8a15a-e0a9-4888-a8a5-c344a178d076"
+#define MODEL_UPDATE_CHAR_UUID "5d6c8b1e-2f4a-4c7b-9e3d-8a1f0b6c2d47"
+#define VITALS_CHAR_UUID       "0c1e7a52-3b9d-4f60-a8e4-6d2b5f9c1a73"
+#define WAVEFORM_CHAR_UUID     "7b2f4d18-95c6-4e3a-b1d0-3e8a6c5f2b94"
+#define ROLLUP_CHAR_UUID       "e4a91c37-6d05-4b8e-92f1-5c7d3a0b8e26"
+
+// Bluetooth SIG assigned numbers for the standard Glucose Service
+#define GLS_SERVICE_UUID       (uint16_t)0x1808
+#define GLS_MEASUREMENT_UUID   (uint16_t)0x2A18
+#define GLS_CONTEXT_UUID       (uint16_t)0x2A34
+#define GLS_FEATURE_UUID       (uint16_t)0x2A51
+#define GLS_RACP_UUID          (uint16_t)0x2A52
+
+#endif // BLE_UUIDS_H
@@ -0,0 +1,72 @@
+#ifndef BLUEDROID_TRANSPORT_H
+#define BLUEDROID_TRANSPORT_H
+
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLE2902.h>
+#include <BLESecurity.h>
+#include <atomic>
+#include "BleTransport.h"
+
+// BleTransport on the Bluedroid-based Arduino BLE library (BLE_USE_NIMBLE=0,
+// kept for comparison in env:esp32-s3-bluedroid).
+// Callbacks and CCCD descriptors are members, so begin() does not allocate any of our own objects.
+class BluedroidTransport : public BleTransport {
+public:
+    BluedroidTransport();
+
+    bool begin(const char* deviceName, uint16_t preferredMtu, Listener* listener) override;
+    bool isConnected() const override;
+    void setValue(Characteristic characteristic, const uint8_t* data, size_t length) override;
+    void startAdvertising() override;
+    bool send(Characteristic characteristic, const uint8_t* data, size_t length) override;
+    const char* name() const override;
+
+    // Passkey the phone has to enter when it pairs; writes to the model update characteristic
+    // are only accepted on an encrypted link authenticated with it (MITM). Call before begin().
+    void setUpdatePasskey(uint32_t passkey);
+
+private:
+    BLECharacteristic* createCharacteristic(BLEService* pService, BLEUUID uuid, uint32_t properties,
+                                            Characteristic characteristic);
+
+    // Callback class to handle connect/disconnect and MTU events
+    class ServerCallbacks : public BLEServerCallbacks {
+    public:
+        explicit ServerCallbacks(BluedroidTransport& owner);
+        void onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) override;
+        void onDisconnect(BLEServer* pServer) override;
+        void onMtuChanged(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) override;
+    private:
+        BluedroidTransport& owner;
+    };
+
+    // Callback class that forwards writes on one characteristic to the listener
+    class WriteCallbacks : public BLECharacteristicCallbacks {
+    public:
+        WriteCallbacks(BluedroidTransport& owner, Characteristic characteristic);
+        void onWrite(BLECharacteristic* pCharacteristic) override;
+    private:
+        BluedroidTransport& owner;
+        Characteristic characteristic;
+    };
+
+    BLEServer* pServer;
+    BLECharacteristic* characteristics[kCharacteristicCount];
+    Listener* listener;
+    BLESecurity security;
+    uint32_t updatePasskey;
+    // Written by the stack's callbacks, read from any task
+    std::atomic<bool> deviceConnected;
+
+    ServerCallbacks serverCallbacks;
+    WriteCallbacks modelUpdateCallbacks;
+    WriteCallbacks racpCallbacks;
+    WriteCallbacks waveformCallbacks;
+    WriteCallbacks rollupCallbacks;
+    // One Client Characteristic Configuration descriptor per notifying characteristic
+    BLE2902 cccds[kCharacteristicCount];
+    int cccdCount;
+};
+
+#endif // BLUEDROID_TRANSPORT_H
@@ -1,47 +1,63 @@
 #ifndef BLUETOOTH_CONTROLLER_H
 #define BLUETOOTH_CONTROLLER_H
 
-#include <BLEDevice.h>
-#include <BLEServer.h>
-#include <BLEUtils.h>
 #include <string>
+#include "BlePeripheral.h"
 
-// Forward declaration to avoid including the whole GlucosePredictor header
-class GlucosePredictor;
-
+// Owns the BLE peripheral. The protocol side lives in BlePeripheral (host-testable); the stack
+// is chosen at build time with BLE_USE_NIMBLE (BluedroidTransport or NimbleTransport).
+// With BLE_TASK_ENABLED a dedicated task owns the stack and drains the publish queue; every
+// other method only posts a message and returns without blocking, so it is safe from any task.
 class BluetoothController {
 public:
     static BluetoothController& getInstance();
     BluetoothController(const BluetoothController&) = delete;
     BluetoothController& operator=(const BluetoothController&) = delete;
 
+    // Starts the stack and logs "BLE <stack> init: N us, heap used M bytes, free F bytes"
+    // (parsed by tools/ble_stack_report.py)
     void begin(const std::string& deviceName = "BloodSugar-Monitor");
+    // Scalar values are sent as binary SFLOAT measurement packets (see BleEncoding.h),
+    // or as text when BLE_TEXT_VALUES is set for legacy clients
     void updateHeartRate(float heartRate);
     void updateSpO2(float spO2);
     void updateGlucose(float glucose);
-    void updatePredictionCurve(float* curveData, int curveSize);
+    // Sends the whole curve as one packed binary notification (see PredictionCurve.h).
+    // lower/upper, when given, add the prediction interval to every point.
+    // With BLE_COMPOSITE_NOTIFICATIONS all of the update*() calls only stage values;
+    // poll() sends them together as one composite notification (see VitalsPublisher.h).
+    void updatePredictionCurve(const float* curveData, int curveSize,
+                               const float* lower = nullptr, const float* upper = nullptr);
     bool isDeviceConnected();
 
+    // Raw waveform samples for the opt-in streaming characteristic (see WaveformStreamer.h);
+    // ignored unless a client has enabled the stream
+    void addPpgSample(uint32_t ir, uint32_t red);
+    void addOpticalSample(uint16_t raw);
+    // True while a client streams waveforms; the main loop then drains the sensor FIFO more often
+    bool isWaveformStreaming();
+
+    // Stores a record for the standard Glucose Service history (RACP download)
+    void addGlucoseRecord(uint32_t timestamp, float glucose);
+
+    // Adds every reading to the 1 min / 5 min / 1 h rollups read through the rollup
+    // characteristic (see RollupEngine.h)
+    void addReading(uint32_t timestamp, float glucose);
+
+    // The rollups themselves; only touch them before begin() (e.g. to rebuild them from
+    // the reading history in flash), the BLE task owns them afterwards
+    RollupEngine& getRollups();
+
+    // Publishes the composite notification, processes pending RACP requests and
+    // streams records; call from the main loop (no-op while the BLE task is running)
+    void poll();
+    // High-water marks and drop counts of the publish, sample and event queues
+    BlePeripheral::QueueStats getQueueStats();
+
 private:
     BluetoothController();
 
-    BLEServer* pServer;
-    BLECharacteristic* pHeartRateCharacteristic;
-    BLECharacteristic* pSpO2Characteristic;
-    BLECharacteristic* pGlucoseCharacteristic;
-    BLECharacteristic* pPredictionCharacteristic;
-    
-    bool deviceConnected;
-
-    // Callback class to handle connect/disconnect events
-    class ServerCallbacks : public BLEServerCallbacks {
-    public:
-        ServerCallbacks(bool& connectedFlag);
-        void onConnect(BLEServer* pServer) override;
-        void onDisconnect(BLEServer* pServer) override;
-    private:
-        bool& connectedFlag;
-    };
+    BlePeripheral peripheral;
 };
 
-#endif // BLUETOOTH_CONTROLLER_H
\ No newline at end of file
+#endif // BLUETOOTH_CONTROLLER_H
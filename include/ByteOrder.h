@@ -0,0 +1,49 @@
+#ifndef BYTE_ORDER_H
+#define BYTE_ORDER_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @file ByteOrder.h
+ * @brief 小端序的整数与浮点数读写，flash中的记录与镜像、BLE数据包与快照等二进制格式共用。
+ * * 逐字节读写，不要求对齐，与主机的字节序无关。浮点数按 IEEE-754 的原始位保存 (NAN 原样保留)。
+ */
+namespace ByteOrder {
+
+inline void writeU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+inline void writeU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+inline uint16_t readU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t readU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline void writeF32(uint8_t* p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    writeU32(p, bits);
+}
+
+inline float readF32(const uint8_t* p) {
+    uint32_t bits = readU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+} // namespace ByteOrder
+
+#endif // BYTE_ORDER_H
@@ -3,6 +3,7 @@
 
 #include "config.h"
 #include <DHT.h> // 引入刚才添加的库
+#include "SensorCapture.h"
 
 /**
  * @class Dht22Controller
@@ -46,16 +47,28 @@ public:
      */
     float getHumidity();
 
+    /**
+     * @brief 设置读数的录制/回放 (SensorCapture)，nullptr 表示直接读取传感器且不录制。
+     * * 每次 readData() 的结果 (包括冷却期内的调用) 都被录制，回放时按同样的顺序返回。
+     */
+    void setCapture(SensorCapture* capture);
+
 private:
     // 私有构造函数
     Dht22Controller();
 
+    /**
+     * @brief 读取传感器 (带2秒冷却期)，readData() 的硬件部分。
+     */
+    bool readSensor();
+
     DHT _dht; // 来自库的DHT对象实例
 
     float _lastTemperature; // 缓存的温度值
     float _lastHumidity;    // 缓存的湿度值
     
     unsigned long _lastReadTime; // 上次读取的时间戳
+    SensorCapture* _capture;
 };
 
 #endif // DHT22_CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <stdint.h>
+
+/**
+ * @class Ensemble
+ * @brief 多个小模型 (成员) 对同一个输入窗口做预测，合并为均值与预测区间。
+ * * 区间为 K 个成员预测的95%预测区间: 均值 ± t(K-1) × s × sqrt(1 + 1/K)，s 为成员间的样本标准差，
+ *   t(K-1) 为自由度 K-1 的t分布分位数 (SequentialEstimator::tQuantile975)。成员很少时 1.96 × s 的覆盖率明显不足95%
+ *   (K = 3 时约77%)。只有一个成员参与合并时没有区间 (hasInterval 为false)。
+ * * 所有成员读取同一个已准备好的输入窗口；推理由调用方提供的 MemberFn 完成。
+ * * 节省计算: 上一次完整运行的区间足够窄时，只运行主成员 (第0个)，区间沿用上次的宽度与成员均值相对主成员的偏移；
+ *   主成员的预测相对上次完整运行变化过大，或连续跳过次数达到上限时，重新运行全部成员。
+ */
+class Ensemble {
+public:
+    static constexpr int kMaxMembers = 8;
+    static constexpr int kMaxSteps = 16;
+
+    struct Config {
+        float tightWidth;           // 区间宽度 (各步的最大值) 不超过该值时允许跳过其余成员
+        int maxConsecutiveSkips;    // 连续跳过的上限，之后强制完整运行
+    };
+
+    /**
+     * @brief 运行一个成员。
+     * @param member 成员序号，0为主成员。
+     * @param output 至少 kMaxSteps 个元素。
+     * @param outputSize 写入的预测步数。
+     * @return bool - 推理失败时返回false。
+     */
+    typedef bool (*MemberFn)(void* context, int member, const float* input, float* output, int* outputSize);
+
+    struct Result {
+        int steps;
+        int members;            // 参与合并的成员数 (跳过时为1)
+        bool skipped;           // 本次只运行了主成员
+        bool hasInterval;       // 至少两个成员参与了合并 (或沿用的上次完整运行)；为false时 lower/upper 等于 mean
+        float mean[kMaxSteps];
+        float lower[kMaxSteps];
+        float upper[kMaxSteps];
+    };
+
+    explicit Ensemble(const Config& config);
+
+    /**
+     * @brief 设置成员个数与推理函数 (同时清除上一次的区间)。
+     */
+    void setMembers(int count, MemberFn fn, void* context);
+    int getMemberCount() const;
+
+    /**
+     * @brief 清除上一次的区间，下一次 run() 一定完整运行 (例如读数中断后)。
+     */
+    void reset();
+
+    /**
+     * @brief 对输入窗口运行成员并合并。
+     * @return bool - 主成员推理失败时返回false。
+     */
+    bool run(const float* input, Result* out);
+
+    /**
+     * @brief 合并成员的输出 (outputs[i] 为第i个成员的前 steps 步预测)。
+     */
+    static void aggregate(const float (*outputs)[kMaxSteps], int members, int steps, Result* out);
+
+    /**
+     * @brief 完整运行与跳过的次数 (用于估计节省的计算量)。
+     */
+    uint32_t getFullRuns() const;
+    uint32_t getSkippedRuns() const;
+
+private:
+    bool canSkip(const float* primary, int steps) const;
+
+    Config _config;
+    int _memberCount;
+    MemberFn _fn;
+    void* _context;
+
+    float _outputs[kMaxMembers][kMaxSteps];
+
+    // 上一次完整运行的结果 (至少两个成员参与合并)，跳过时用于构造区间
+    bool _hasFull;
+    int _fullSteps;
+    float _fullPrimary[kMaxSteps];      // 主成员的预测
+    float _fullOffset[kMaxSteps];       // 成员均值 - 主成员预测
+    float _fullHalfWidth[kMaxSteps];
+    float _fullMaxWidth;
+    int _consecutiveSkips;
+
+    uint32_t _fullRuns;
+    uint32_t _skippedRuns;
+};
+
+#endif // ENSEMBLE_H
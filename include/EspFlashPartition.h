@@ -0,0 +1,36 @@
+#ifndef ESP_FLASH_PARTITION_H
+#define ESP_FLASH_PARTITION_H
+
+#include <esp_partition.h>
+#include "FlashPartition.h"
+
+/**
+ * @class EspFlashPartition
+ * @brief 基于 esp_partition_* 的 FlashPartition，直接读写分区表中的数据分区 (不经过文件系统)。
+ */
+class EspFlashPartition : public FlashPartition {
+public:
+    /**
+     * @param subtype 分区子类型 (例如 ESP_PARTITION_SUBTYPE_DATA_SPIFFS)。
+     * @param label 分区名 (custom.csv 中的 Name 列)。
+     */
+    EspFlashPartition(esp_partition_subtype_t subtype, const char* label);
+
+    /**
+     * @brief 查找分区。
+     * @return bool - 分区不存在时返回false。
+     */
+    bool begin();
+
+    uint32_t size() const override;
+    bool read(uint32_t offset, void* out, size_t length) override;
+    bool write(uint32_t offset, const void* data, size_t length) override;
+    bool eraseSector(uint32_t offset) override;
+
+private:
+    esp_partition_subtype_t _subtype;
+    const char* _label;
+    const esp_partition_t* _partition;
+};
+
+#endif // ESP_FLASH_PARTITION_H
@@ -0,0 +1,72 @@
+#ifndef FILE_PARTITION_H
+#define FILE_PARTITION_H
+
+#include <stdio.h>
+#include "FlashPartition.h"
+
+/**
+ * @class FilePartition
+ * @brief 以镜像文件模拟的 FlashPartition，用于在主机上测试存储引擎，以及读取从设备导出的分区镜像
+ *        (esptool.py read_flash)。
+ * * 模拟 NOR flash 语义: 新文件全部为0xFF，写入与原内容按位与，擦除把扇区置为0xFF。
+ * * 掉电注入: setPowerLossAfter(n) 后，再写入/擦除 n 个字节时"掉电" ——
+ *   进行中的操作只完成前面的部分字节，之后所有操作都失败，直到 powerCycle()。
+ *   每次操作后立即 fflush，掉电前写入的内容在重新打开镜像后仍然存在。
+ * * 记录每个扇区的擦除次数，用于检查磨损均衡。
+ */
+class FilePartition : public FlashPartition {
+public:
+    static constexpr uint32_t kMaxSectors = 256;
+
+    /**
+     * @param size 分区大小 (字节)，向下取整到扇区大小的整数倍，最多 kMaxSectors 个扇区。
+     */
+    FilePartition(const char* path, uint32_t size);
+    ~FilePartition();
+
+    FilePartition(const FilePartition&) = delete;
+    FilePartition& operator=(const FilePartition&) = delete;
+
+    /**
+     * @brief 打开镜像文件，不存在或长度不足时补齐为已擦除的内容 (0xFF)。
+     */
+    bool open();
+    void close();
+
+    uint32_t size() const override;
+    bool read(uint32_t offset, void* out, size_t length) override;
+    bool write(uint32_t offset, const void* data, size_t length) override;
+    bool eraseSector(uint32_t offset) override;
+
+    /**
+     * @brief 再写入/擦除 bytes 个字节后掉电 (0 表示下一个写入/擦除操作一个字节也不完成)。
+     */
+    void setPowerLossAfter(uint32_t bytes);
+
+    /**
+     * @brief 取消掉电注入并恢复供电 (相当于重启)。
+     */
+    void powerCycle();
+
+    bool isPoweredOff() const;
+
+    uint32_t getEraseCount(uint32_t sector) const;
+    uint32_t getBytesWritten() const;
+
+private:
+    /**
+     * @brief 按掉电预算计算本次操作能完成的字节数，预算用完时进入掉电状态。
+     */
+    size_t consumeBudget(size_t length);
+
+    const char* _path;
+    uint32_t _size;
+    FILE* _file;
+    bool _powerLossArmed;
+    uint32_t _powerLossBudget;
+    bool _poweredOff;
+    uint32_t _bytesWritten;
+    uint32_t _eraseCounts[kMaxSectors];
+};
+
+#endif // FILE_PARTITION_H
@@ -0,0 +1,36 @@
+#ifndef FLASH_PARTITION_H
+#define FLASH_PARTITION_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @class FlashPartition
+ * @brief 原始flash分区的抽象接口 (NOR flash 语义: 擦除把整个扇区置为0xFF，写入只能把位从1变为0)。
+ * * 固件中由 EspFlashPartition (esp_partition_*) 实现，主机上由 FilePartition (分区镜像文件，可注入掉电) 实现。
+ */
+class FlashPartition {
+public:
+    static constexpr uint32_t kSectorSize = 4096;
+
+    virtual ~FlashPartition() {}
+
+    /**
+     * @brief 分区大小 (字节，扇区大小的整数倍)。
+     */
+    virtual uint32_t size() const = 0;
+
+    virtual bool read(uint32_t offset, void* out, size_t length) = 0;
+
+    /**
+     * @brief 写入已擦除的区域。
+     */
+    virtual bool write(uint32_t offset, const void* data, size_t length) = 0;
+
+    /**
+     * @brief 擦除 offset 所在的扇区 (offset 须按扇区对齐)。
+     */
+    virtual bool eraseSector(uint32_t offset) = 0;
+};
+
+#endif // FLASH_PARTITION_H
@@ -0,0 +1,43 @@
+#ifndef GATT_SINK_H
+#define GATT_SINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @class GattSink
+ * @brief 向已连接的客户端发送通知/指示的抽象接口。
+ * * 固件中由BLE协议栈的传输层实现 (见 BleTransport.h)，主机测试中使用假的GATT层，
+ *   因此 GlucoseService / VitalsPublisher 等协议层可以在主机上测试。
+ */
+class GattSink {
+public:
+    enum class Characteristic {
+        // 自定义服务
+        HEART_RATE,     // 心率，通知 (格式见 BleEncoding.h)
+        SPO2,           // 血氧，通知
+        GLUCOSE,        // 血糖，通知
+        PREDICTION,     // 预测曲线，通知 (格式见 PredictionCurve.h)
+        MODEL_UPDATE,   // 模型更新，写入 + 通知状态 (见 ModelStore.h)
+        VITALS,         // 合并的实时数据 (见 VitalsPublisher.h)，通知
+        WAVEFORM,       // 原始波形流，写入开启 + 通知 (见 WaveformStreamer.h)
+        ROLLUP,         // 分层降采样的历史，写入查询 + 读取 (见 RollupEngine.h)
+        // 标准血糖服务 (0x1808)
+        MEASUREMENT,    // Glucose Measurement (0x2A18)，通知
+        CONTEXT,        // Glucose Measurement Context (0x2A34)，通知
+        FEATURE,        // Glucose Feature (0x2A51)，只读
+        RACP            // Record Access Control Point (0x2A52)，写入 + 指示
+    };
+
+    static constexpr int kCharacteristicCount = 12;
+
+    virtual ~GattSink() {}
+
+    /**
+     * @brief 发送一个通知或指示。
+     * @return bool - 未连接或发送缓冲区已满 (流控) 时返回false，调用方稍后重试。
+     */
+    virtual bool send(Characteristic characteristic, const uint8_t* data, size_t length) = 0;
+};
+
+#endif // GATT_SINK_H
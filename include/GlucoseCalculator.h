@@ -4,6 +4,8 @@
 #include "SignalReader.h"
 #include "Dht22Controller.h"
 #include "Max30102Controller.h"
+#include "GlucoseFilter.h"
+#include "SensorCapture.h"
 // 注意：我们暂时还没有创建DemodulatorController，所以先不包含它
 
 /**
@@ -21,6 +23,17 @@ public:
         ERROR_SENSOR_READ
     };
 
+    /**
+     * @brief 一次测量的统计报告。
+     */
+    struct MeasurementReport {
+        uint16_t subMeasurements;   // 实际使用的子测量次数
+        uint32_t adcSamples;        // 实际使用的ADC采样总数
+        float confidence;           // 测量值的95%置信区间半宽 (mg/dL)，单次测量时为NAN
+        uint32_t elapsedMs;         // 测量耗时 (毫秒)
+        bool converged;             // 是否在预算内达到了目标容差
+    };
+
     /**
      * @brief 获取GlucoseCalculator的全局唯一实例。
      */
@@ -41,22 +54,87 @@ public:
      */
     Status performMeasurement();
 
+    /**
+     * @brief 执行一次自适应的多次测量。
+     * * 持续采集短时子测量，直到均值的置信区间半宽低于容差或耗尽时间预算。
+     * * 信号干净时提前结束以节省LED、ADC与CPU能耗；信号嘈杂时自动延长。
+     * @param toleranceMgdl 目标95%置信区间半宽 (mg/dL)。
+     * @param timeBudgetMs 时间预算 (毫秒)。
+     * @return Status - 返回本次测量的最终状态。
+     */
+    Status performAdaptiveMeasurement(float toleranceMgdl = ADAPTIVE_TOLERANCE_MGDL,
+                                      unsigned long timeBudgetMs = ADAPTIVE_TIME_BUDGET_MS);
+
+    /**
+     * @brief 获取最近一次成功测量的统计报告 (子测量次数、置信度等)。
+     */
+    const MeasurementReport& getLastReport() const;
+
     /**
      * @brief 获取最近一次成功测量的血糖值。
      * @return float - 血糖值 (单位需要您根据模型确定，例如 mg/dL)。
      */
     float getLatestGlucoseValue() const;
     
+    /**
+     * @brief 获取经卡尔曼滤波平滑后的血糖值。
+     * @return float - 平滑血糖值 (mg/dL)。从未成功测量时返回0。
+     */
+    float getSmoothedGlucoseValue() const;
+
+    /**
+     * @brief 获取滤波器估计的血糖变化率。
+     * @return float - 变化率 (mg/dL/min)，正值表示上升。
+     */
+    float getGlucoseVelocity() const;
+
+    /**
+     * @brief 获取平滑血糖值的95%置信区间半宽。
+     * @return float - 半宽 (mg/dL)。
+     */
+    float getGlucoseConfidence() const;
+
+    /**
+     * @brief 获取最近一次测量的信号质量评估。
+     * @return float - 0~1，1表示信号最佳。
+     */
+    float getSignalQuality() const;
+
+    /**
+     * @brief 根据当前读数稳定度给出建议的下一次测量间隔。
+     * * 置信区间足够窄时返回较长的间隔，以降低LED、ADC和CPU的能耗。
+     * @return unsigned long - 建议间隔 (毫秒)。
+     */
+    unsigned long getRecommendedIntervalMs() const;
+
+    /**
+     * @brief 导出/恢复平滑滤波器的状态 (用于重启前后保存到NVS)。
+     */
+    GlucoseFilter::State getFilterState() const;
+    void restoreFilterState(const GlucoseFilter::State& state);
+
     /**
      * @brief 获取当前计算器的状态。
      */
     Status getCurrentStatus() const;
 
+    /**
+     * @brief 设置测量时钟的录制/回放 (与HAL使用同一个 SensorCapture)，nullptr 表示直接使用 millis()。
+     * * 回放时测量的计时与滤波器的时间戳取自录制的数据，子测量之间不再等待。
+     */
+    void setCapture(SensorCapture* capture);
+
 
 private:
     // 私有构造函数
     GlucoseCalculator();
 
+    /**
+     * @brief 更新辅助传感器并检查测量的先决条件。
+     * @return Status - 满足条件时返回 MEASURING，否则返回对应的错误状态。
+     */
+    Status checkPreconditions();
+
     /**
      * @brief 内部计算函数，包含核心算法。
      * @param mainSignalV 主光学信号的电压值。
@@ -67,8 +145,28 @@ private:
      */
     float calculate(float mainSignalV, float temperature, uint32_t irValue, float heartRate);
 
+    /**
+     * @brief 根据灌流(IR)与心率有效性估算本次测量的信号质量。
+     * @return float - 0~1 的质量分数。
+     */
+    float estimateSignalQuality(uint32_t irValue, float heartRate) const;
+
+    /**
+     * @brief 测量使用的时钟 (毫秒)，录制/回放时经过 SensorCapture。
+     */
+    uint32_t now();
+
+    /**
+     * @brief 等待光路稳定或下一次子测量，回放时不等待。
+     */
+    void pause(unsigned long ms);
+
     float _latestGlucoseValue;
+    float _signalQuality;
+    GlucoseFilter _filter;
+    MeasurementReport _lastReport;
     Status _currentStatus;
+    SensorCapture* _capture;
 };
 
 #endif // GLUCOSE_CALCULATOR_H
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef GLUCOSE_FILTER_H
+#define GLUCOSE_FILTER_H
+
+#include <stdint.h>
+
+/**
+ * @class GlucoseFilter
+ * @brief 血糖值的流式状态空间(卡尔曼)滤波器。
+ * * 状态向量为 [血糖值, 变化率]，采用匀速模型 (constant velocity)。
+ * * 测量噪声根据信号质量 (0~1) 动态缩放：质量越差，对新读数的信任越低。
+ * * 每次更新的计算量恒定 (2x2 矩阵)。
+ */
+class GlucoseFilter {
+public:
+    /**
+     * @brief 滤波器的完整状态，用于保存到NVS并在重启后恢复。
+     */
+    struct State {
+        bool initialized;
+        float glucose;
+        float velocity;
+        float p00, p01, p11;
+        uint32_t lastTimestampMs;
+        uint32_t updateCount;
+    };
+
+    /**
+     * @param processNoise 过程噪声谱密度 q，单位 (mg/dL/min)^2 / min，描述血糖变化率的随机游走强度。
+     * @param measurementNoise 信号质量为1时的测量噪声标准差 (mg/dL)。
+     * @param maxGapMs 两次读数间隔超过该值时，认为历史状态已失效并重新初始化。
+     */
+    GlucoseFilter(float processNoise = 0.5f, float measurementNoise = 8.0f, uint32_t maxGapMs = 15UL * 60UL * 1000UL);
+
+    /**
+     * @brief 清空滤波器状态，下一次 update() 将以该读数重新初始化。
+     */
+    void reset();
+
+    /**
+     * @brief 输入一次原始测量值，完成 预测+校正 一步。
+     * @param measurement 原始血糖测量值 (mg/dL)。
+     * @param timestampMs 测量时刻 (毫秒，例如 millis())。
+     * @param quality 信号质量 (0~1)，用于缩放测量噪声。
+     * @param standardError 测量值本身的抽样标准误差 (mg/dL，例如多次子测量均值的标准误差)。
+     *        测量噪声为 R = R0 / q^2 + standardError^2: 光学信号到血糖的模型误差不随子测量次数减小，
+     *        抽样误差只叠加在其上，不能代替它。
+     */
+    void update(float measurement, uint32_t timestampMs, float quality = 1.0f, float standardError = 0.0f);
+
+    /**
+     * @brief 是否已经接收过至少一次测量。
+     */
+    bool isInitialized() const;
+
+    /**
+     * @brief 获取平滑后的血糖值 (mg/dL)。
+     */
+    float getGlucose() const;
+
+    /**
+     * @brief 获取血糖变化率 (mg/dL/min)。
+     */
+    float getVelocity() const;
+
+    /**
+     * @brief 获取平滑血糖值的95%置信区间半宽 (mg/dL)。
+     * * 即真实值大致落在 [getGlucose() - w, getGlucose() + w] 之内。
+     */
+    float getConfidenceHalfWidth() const;
+
+    /**
+     * @brief 获取累计融合的测量次数 (自上次重置以来)。
+     */
+    uint32_t getUpdateCount() const;
+
+    /**
+     * @brief 导出/恢复滤波器状态 (不含构造参数)。
+     */
+    State getState() const;
+    void setState(const State& state);
+
+private:
+    void fuse(float measurement, uint32_t timestampMs, float r);
+
+    float _q;          // 过程噪声谱密度
+    float _r0;         // 质量为1时的测量噪声方差
+    uint32_t _maxGapMs;
+
+    // 状态估计
+    float _glucose;
+    float _velocity;
+    // 协方差矩阵 P (对称，只存三个元素)
+    float _p00, _p01, _p11;
+
+    uint32_t _lastTimestampMs;
+    uint32_t _updateCount;
+    bool _initialized;
+};
+
+#endif // GLUCOSE_FILTER_H
@@ -1,6 +1,16 @@
 #ifndef GLUCOSE_PREDICTOR_H
 #define GLUCOSE_PREDICTOR_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include "PredictionCurve.h"
+#include "StreamingState.h"
+#include "HistoryResampler.h"
+#include "OpProfile.h"
+#include "Ensemble.h"
+#include "SensorCapture.h"
+
 /**
  * @class GlucosePredictor
  * @brief 使用TensorFlow Lite模型进行血糖趋势预测。
@@ -8,6 +18,11 @@
  */
 class GlucosePredictor {
 public:
+    // 模型输入窗口的网格点数 (间隔 PREDICTOR_GRID_STEP_MS)
+    static constexpr int kHistorySize = 10;
+    // 输入的最大长度: 网格值之后可以附带同样长度的间隔特征
+    static constexpr int kMaxInputSize = 2 * kHistorySize;
+
     /**
      * @brief 获取GlucosePredictor的全局唯一实例。
      */
@@ -19,41 +34,249 @@ public:
 
     /**
      * @brief 初始化TFLite解释器。
-     * * 加载模型，分配内存（Tensor Arena）。
+     * * 从 ModelStore 映射的模型分区加载模型 (失败时按A/B策略回滚，最后退回固件内置模型)，
+     *   分配内存（Tensor Arena）。调用前需先执行 ModelStore::begin()。
      * @return bool - 初始化成功返回true。
      */
     bool begin();
 
     /**
      * @brief 向历史数据缓冲区中添加一个新的血糖读数。
+     * * 流式模型会在这里按时间网格运行推理并更新隐藏状态 (读数间隔大于网格时按插值补齐)。
      * @param value 最新的血糖测量值。
+     * @param timestampMs 读数时刻 (millis())。
+     * @param quality 信号质量 0~1，低于 PREDICTOR_MIN_QUALITY 的读数不进入历史。
      */
-    void addGlucoseReading(float value);
+    void addGlucoseReading(float value, uint32_t timestampMs, float quality = 1.0f);
 
     /**
      * @brief 检查是否已收集到足够的历史数据以进行预测。
+     * * 历史需要覆盖整个时间网格，最新读数不能过旧，窗口内也不能有过长的间隔。
      * @return bool - 如果可以进行预测，返回true。
      */
     bool isReadyToPredict() const;
 
+    /**
+     * @brief 当前历史按时间网格重采样的状态 (用于说明为什么还不能预测)。
+     */
+    HistoryResampler::Status getHistoryStatus() const;
+
+    /**
+     * @brief 读数历史 (用于保存检查点)。
+     */
+    const HistoryResampler& getHistory() const;
+
+    /**
+     * @brief 用重启前保存的历史替换当前历史 (时间戳已换算到当前 millis() 时间轴)。
+     * * 流式模型的隐藏状态与网格由自己的快照恢复 (begin() 中)。
+     */
+    void restoreHistory(const HistoryResampler& history);
+
+    /**
+     * @brief 流式模型: 把隐藏状态与最后一个读数的时间写入NVS (与检查点同时写入)，其他模型不做任何事。
+     */
+    void saveStreamingState();
+
     /**
      * @brief 运行模型进行一次预测。
-     * @return float - 预测出的未来血糖值。如果无法预测，返回0.0。
+     * @return float - 预测出的未来血糖值 (多步模型时为曲线的第一步)。如果无法预测，返回0.0。
      */
     float predict();
 
+    /**
+     * @brief 运行一次模型，返回未来 N 步的预测曲线 (间隔 PREDICTION_STEP_MINUTES 分钟)。
+     * * 浮点模型返回的视图直接指向输出张量，不做拷贝；下一次推理前有效。
+     * @return PredictionCurve::Curve - 无法预测时 size 为0。
+     */
+    PredictionCurve::Curve predictCurve();
+
+    /**
+     * @brief 按模型的时间网格重采样出输入窗口 (从旧到新)，供异步推理提交请求使用。
+     * * 模型输入为 [1, 2*kHistorySize] 时，网格值之后附带每个网格点的读数间隔 (分钟)。
+     * @param window 至少 kMaxInputSize 个元素。
+     * @return int - 写入的元素个数，历史数据不可用时返回0。
+     */
+    int getInputWindow(float* window) const;
+
+    /**
+     * @brief 用给定的输入窗口运行一次模型 (由 InferenceService 的推理线程调用)。
+     * * 与 predictCurve() 共用同一个解释器，二者不能在不同线程中同时调用。
+     * * 流式模型不支持整窗口推理，返回空曲线 (结果用 predictCurve() 获取)。
+     */
+    PredictionCurve::Curve runInference(const float* window);
+
+    /**
+     * @brief 当前模型是否为有状态流式模型 (每个读数增量推理一步)。
+     */
+    bool isStreaming() const;
+
+    /**
+     * @brief 当前模型是否为集成模型 (多个小模型共用输入窗口与arena，预测附带区间)。
+     */
+    bool isEnsemble() const;
+
+    /**
+     * @brief 最近一次集成推理的均值与预测区间 (下一次推理前有效)。
+     * * 与 runInference() 在同一线程中读取；异步推理时区间随结果一起返回 (见 main.cpp)。
+     * @return const Ensemble::Result* - 不是集成模型、还没有结果，或只有主成员推理成功 (没有区间) 时返回nullptr。
+     */
+    const Ensemble::Result* getLastEnsembleResult() const;
+
+    /**
+     * @brief 模型输入张量的长度 (kHistorySize，或带间隔特征时为 2*kHistorySize)。
+     */
+    int getInputSize() const;
+
+    /**
+     * @brief 获取 begin() 的耗时 (含算子注册、模型校验与 AllocateTensors)，用于比较启动速度。
+     * @return unsigned long - 微秒。
+     */
+    unsigned long getInitTimeUs() const;
+
+    /**
+     * @brief 获取已分配的 Tensor Arena 大小 (字节)。
+     */
+    size_t getArenaSize() const;
+
+    /**
+     * @brief 获取模型实际使用的 arena 字节数 (interpreter->arena_used_bytes()，即高水位)。
+     */
+    size_t getArenaUsedBytes() const;
+
+    /**
+     * @brief Tensor Arena 是否被放在了PSRAM中 (内部SRAM不足时)。
+     */
+    bool isArenaInPsram() const;
+
+    /**
+     * @brief 当前加载的是否为全整数int8量化模型 (输入输出按张量的 scale/zero_point 换算)。
+     */
+    bool isQuantized() const;
+
+    /**
+     * @brief Invoke() 耗时统计 (微秒)，用于比较浮点模型与int8模型的推理速度。
+     */
+    unsigned long getLastInvokeUs() const;
+    unsigned long getMaxInvokeUs() const;
+    unsigned long getAverageInvokeUs() const;
+
+    /**
+     * @brief 按算子统计的 Invoke() 耗时 (PREDICTOR_PROFILING 为1时)。
+     * * 异步推理时统计在推理任务中更新，读取到的可能是两次推理之间的数值，仅用于诊断。
+     * @return const OpProfile* - 未开启剖析时返回nullptr。
+     */
+    const OpProfile* getOpProfile() const;
+
+    /**
+     * @brief 设置判断历史是否过旧、重采样所用时钟的录制/回放 (与HAL使用同一个 SensorCapture)，
+     *        nullptr 表示直接使用 millis()。只在主循环中读取时钟。
+     */
+    void setCapture(SensorCapture* capture);
+
 private:
     // 私有构造函数
     GlucosePredictor(); 
 
+    /**
+     * @brief 用给定的模型数据构造解释器并校验输入输出张量。
+     * * 模型数据以集成目录开头时 (见 ModelImage.h)，为每个成员构造一个解释器，共用同一个arena。
+     * @param modelData 指向 .tflite flatbuffer 或集成模型 (flash映射区或内置数组)。
+     * @param modelSize 模型数据长度 (字节)。
+     * @param modelId 模型标识 (模型数据的CRC32)，用于校验保存的流式状态。
+     * @return bool - 模型可用时返回true。
+     */
+    bool loadModel(const uint8_t* modelData, size_t modelSize, uint32_t modelId);
+
+    /**
+     * @brief 集成模型: 检查其余成员的输入输出与主模型一致。
+     */
+    bool validateEnsembleMembers(int memberCount);
+
+    /**
+     * @brief 集成模型: 用输入窗口运行第 member 个成员 (Ensemble::MemberFn)。
+     */
+    static bool runEnsembleMember(void* context, int member, const float* input, float* output, int* outputSize);
+
+    /**
+     * @brief 校验流式模型的张量 (输入 [采样值, 状态]，输出 [预测, 新状态]) 并恢复保存的状态。
+     */
+    bool setupStreamingModel(uint32_t modelId);
+
+    /**
+     * @brief 流式模型: 用一个网格点的采样值运行一步并保存新状态。
+     */
+    void stepStreaming(float value);
+
+    /**
+     * @brief StreamingState::feed() 的回调 (StreamingState::StepFn)。
+     */
+    static void stepStreamingCallback(void* context, float value);
+
+    bool restoreStreamingState();
+
+    /**
+     * @brief 检查模型中的每个算子在 OpResolver 中都有实现。
+     * @return bool - 有缺失的算子时打印其名称并返回false。
+     */
+    bool checkModelOps();
+
+    /**
+     * @brief 分配 Tensor Arena: 内部SRAM放得下时优先内部SRAM，否则使用PSRAM。
+     * @return bool - 分配成功返回true。
+     */
+    bool allocateArena();
+
+    /**
+     * @brief 运行一次 Invoke() (开启剖析时记录主模型的各算子耗时)。
+     * @param member 集成模型的成员序号，普通模型为0。
+     */
+    bool invoke(int member = 0);
+
+    /**
+     * @brief 对一个输入窗口运行模型 (普通或集成模型) 并取出预测曲线，失败时曲线为空。
+     */
+    PredictionCurve::Curve invokeWindow(const float* window);
+
+    /**
+     * @brief 累计一次 Invoke() 的耗时。
+     */
+    void recordInvokeTime(unsigned long us);
+
+    /**
+     * @brief 当前时刻 (毫秒)，录制/回放时经过 SensorCapture。
+     */
+    uint32_t nowMs() const;
+
     bool _is_initialized;
+    unsigned long _init_time_us;
+    bool _quantized;
+    int _input_size;                                // 输入张量的元素个数
+    int _output_count;                              // 输出张量的元素个数 (预测步数)
+    float _curve_buffer[PREDICTION_MAX_HORIZON];    // int8模型输出的反量化缓冲区
+
+    // --- 有状态流式模型 ---
+    bool _streaming;
+    StreamingState _stream_state;
+    PredictionCurve::Curve _stream_curve;           // 最近一步的预测
+
+    // --- Invoke() 耗时统计 ---
+    uint32_t _invoke_count;
+    unsigned long _last_invoke_us;
+    unsigned long _max_invoke_us;
+    uint64_t _total_invoke_us;
+#if PREDICTOR_PROFILING
+    OpProfile _op_profile;
+#endif
+
+    // --- 带时间戳的历史读数，按模型的时间网格重采样 ---
+    HistoryResampler _history;
+
+    // --- 集成模型 ---
+    Ensemble _ensemble;
+    Ensemble::Result _ensemble_result;
+    bool _has_ensemble_result;
 
-    // --- 历史数据缓冲区 (使用环形缓冲区实现) ---
-    // 假设模型需要10个历史数据点作为输入
-    static constexpr int kHistorySize = 10; 
-    float _history_buffer[kHistorySize];
-    int _history_index;
-    int _history_count;
+    SensorCapture* _capture;
 };
 
 #endif // GLUCOSE_PREDICTOR_H
\ No newline at end of file
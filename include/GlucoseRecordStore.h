@@ -0,0 +1,70 @@
+#ifndef GLUCOSE_RECORD_STORE_H
+#define GLUCOSE_RECORD_STORE_H
+
+#include <stdint.h>
+#include "KeyValueStore.h"
+
+/**
+ * @class GlucoseRecordStore
+ * @brief 血糖测量记录的环形缓冲区，供标准血糖服务 (GLS) 的历史记录下载使用。
+ * * 每条记录有一个递增的16位序号 (GLS 的 Sequence Number)；缓冲区满时覆盖最旧的记录。
+ * * 序号达到 0xFFFF 后回绕前清空全部记录，保证存储中的序号始终递增，按序号过滤不会出错。
+ * * 记录只在RAM中，重启后丢失；序号可以通过 restoreSequence() 持久化，重启后继续递增而不是从0开始，
+ *   手机按 "大于等于上次收到的序号" 增量下载时不会把新记录当成已经收到过的。
+ */
+class GlucoseRecordStore {
+public:
+    static constexpr int kCapacity = 512;
+    // 每次写入持久化存储时预留的序号数: 每 kSequenceReserve 条记录写一次，重启后跳过未用完的部分
+    static constexpr uint16_t kSequenceReserve = 32;
+
+    struct Record {
+        uint16_t sequence;
+        uint32_t timestamp;     // 测量时间 (RTC秒)
+        float glucose;          // mg/dL
+    };
+
+    GlucoseRecordStore();
+
+    /**
+     * @brief 追加一条记录。
+     * @return uint16_t - 分配给该记录的序号。
+     */
+    uint16_t add(uint32_t timestamp, float glucose);
+
+    /**
+     * @brief 从 store 中读取保存的序号并从那里继续，之后 add() 按 kSequenceReserve 预留并写回。
+     *        没有保存的序号时从当前序号开始。在第一次 add() 之前调用。
+     */
+    void restoreSequence(KeyValueStore& store, const char* key);
+
+    uint16_t nextSequence() const;
+
+    /**
+     * @brief 删除全部记录 (序号继续递增)。
+     */
+    void clear();
+
+    int count() const;
+
+    /**
+     * @brief 第 index 条记录，0为最旧的一条。
+     */
+    const Record& at(int index) const;
+
+    /**
+     * @brief 第一条序号不小于 sequence 的记录的下标，没有时返回 count()。
+     */
+    int lowerBound(uint16_t sequence) const;
+
+private:
+    Record _records[kCapacity];
+    int _head;          // 最旧记录的位置
+    int _count;
+    uint16_t _nextSequence;
+    KeyValueStore* _sequenceStore;
+    const char* _sequenceKey;
+    uint16_t _reservedSequence;     // 持久化的序号: 小于它的序号可能已经用过
+};
+
+#endif // GLUCOSE_RECORD_STORE_H
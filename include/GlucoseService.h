@@ -0,0 +1,137 @@
+#ifndef GLUCOSE_SERVICE_H
+#define GLUCOSE_SERVICE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mutex>
+#include "GlucoseRecordStore.h"
+#include "GattSink.h"
+
+/**
+ * @class GlucoseService
+ * @brief 标准血糖服务 (Glucose Service, 0x1808) 的协议部分: 测量记录的编码与 Record Access Control Point。
+ * * RACP 请求格式: [opCode u8][operator u8][operand...]，operand 的过滤类型只支持序号 (0x01)。
+ *   支持的请求: 上报记录 (0x01)、删除全部记录 (0x02)、中止 (0x03)、上报记录数 (0x04)；
+ *   运算符: 全部、≤N、≥N、[N, M]、第一条、最后一条。
+ * * 手机重新连接后写入 "上报序号 ≥ N 的记录" 即可补齐离线期间的全部测量。
+ * * 写入回调 (BLE任务) 只把请求放入邮箱，处理与记录的逐条发送都在 poll() (主循环) 中完成，
+ *   每次 poll() 最多发送 recordsPerPoll 条记录，发送缓冲区满时停在当前记录，下一次继续。
+ */
+class GlucoseService {
+public:
+    // RACP 操作码、运算符与响应码 (Glucose Profile 规范)
+    enum OpCode : uint8_t {
+        OP_REPORT_RECORDS = 0x01,
+        OP_DELETE_RECORDS = 0x02,
+        OP_ABORT = 0x03,
+        OP_REPORT_NUMBER = 0x04,
+        OP_NUMBER_RESPONSE = 0x05,
+        OP_RESPONSE_CODE = 0x06
+    };
+
+    enum Operator : uint8_t {
+        OPERATOR_NULL = 0x00,
+        OPERATOR_ALL = 0x01,
+        OPERATOR_LESS_OR_EQUAL = 0x02,
+        OPERATOR_GREATER_OR_EQUAL = 0x03,
+        OPERATOR_RANGE = 0x04,
+        OPERATOR_FIRST = 0x05,
+        OPERATOR_LAST = 0x06
+    };
+
+    enum ResponseCode : uint8_t {
+        RESPONSE_SUCCESS = 0x01,
+        RESPONSE_OP_CODE_NOT_SUPPORTED = 0x02,
+        RESPONSE_INVALID_OPERATOR = 0x03,
+        RESPONSE_OPERATOR_NOT_SUPPORTED = 0x04,
+        RESPONSE_INVALID_OPERAND = 0x05,
+        RESPONSE_NO_RECORDS_FOUND = 0x06,
+        RESPONSE_ABORT_UNSUCCESSFUL = 0x07,
+        RESPONSE_PROCEDURE_NOT_COMPLETED = 0x08,
+        RESPONSE_OPERAND_NOT_SUPPORTED = 0x09
+    };
+
+    static constexpr uint8_t kFilterSequenceNumber = 0x01;
+    static constexpr uint8_t kFilterUserFacingTime = 0x02;
+    static constexpr int kMaxRequestSize = 20;
+
+    // Glucose Feature (0x2A51): 不支持任何可选的传感器状态告警
+    static constexpr uint16_t kFeatures = 0x0000;
+
+    static constexpr size_t kMeasurementSize = 13;
+    static constexpr size_t kContextSize = 4;
+
+    /**
+     * @param recordsPerPoll 每次 poll() 最多发送的记录数。
+     */
+    GlucoseService(GlucoseRecordStore& store, GattSink& sink, int recordsPerPoll);
+
+    /**
+     * @brief 收到 RACP 写入 (可在BLE任务中调用)。请求在下一次 poll() 中处理，未处理的旧请求被覆盖。
+     */
+    void handleRacpWrite(const uint8_t* data, size_t length);
+
+    /**
+     * @brief 处理挂起的请求并继续发送记录 (在主循环中调用)。
+     */
+    void poll();
+
+    /**
+     * @brief 是否正在上报记录。
+     */
+    bool isReporting() const;
+
+    /**
+     * @brief 断开连接时调用 (可在BLE任务中调用): 在下一次 poll() 中中止正在进行的上报并丢弃未发送的响应。
+     */
+    void reset();
+
+    /**
+     * @brief 编码 Glucose Measurement: 序号、基准时间 (UTC)、浓度 (kg/L，SFLOAT)、类型与采样位置，
+     *        并标记随后有 Measurement Context。
+     * @return size_t - 写入的字节数 (kMeasurementSize)，容量不足时返回0。
+     */
+    static size_t encodeMeasurement(const GlucoseRecordStore::Record& record, uint8_t* out, size_t capacity);
+
+    /**
+     * @brief 编码 Glucose Measurement Context (只含测试者: 本人)。
+     */
+    static size_t encodeContext(const GlucoseRecordStore::Record& record, uint8_t* out, size_t capacity);
+
+private:
+    void processRequest(const uint8_t* request, size_t length);
+
+    /**
+     * @brief 把请求的运算符与操作数解析为序号范围 [*first, *last]。
+     * @return ResponseCode - 成功时返回 RESPONSE_SUCCESS。
+     */
+    ResponseCode parseRange(const uint8_t* request, size_t length, uint16_t* first, uint16_t* last) const;
+
+    int countInRange(uint16_t first, uint16_t last) const;
+    void respond(uint8_t requestOpCode, uint8_t responseCode);
+    void respondNumber(uint16_t count);
+    bool flushResponse();
+    void sendRecords();
+
+    GlucoseRecordStore& _store;
+    GattSink& _sink;
+    int _recordsPerPoll;
+
+    // BLE任务写入、主循环读取的请求邮箱
+    std::mutex _mutex;
+    uint8_t _request[kMaxRequestSize];
+    size_t _requestLength;
+    bool _hasRequest;
+    bool _resetPending;
+
+    // 正在上报的序号范围，_cursor 为下一条要发送的序号 (超过0xFFFF时结束)
+    bool _reporting;
+    uint32_t _cursor;
+    uint16_t _last;
+    bool _contextPending;   // 当前记录的测量已发出，Context 尚未发出
+
+    uint8_t _response[4];
+    size_t _responseLength;  // 0 表示没有待发送的响应
+};
+
+#endif // GLUCOSE_SERVICE_H
@@ -0,0 +1,84 @@
+#ifndef HISTORY_RESAMPLER_H
+#define HISTORY_RESAMPLER_H
+
+#include <stdint.h>
+
+/**
+ * @class HistoryResampler
+ * @brief 带时间戳的血糖读数历史，以及按模型固定时间网格重采样的输入窗口。
+ * * 读数间隔不均匀 (自适应测量间隔、手指移开、传感器错误) 时，按网格点对相邻读数做线性插值，
+ *   并给出每个网格点所在区间的间隔长度作为特征，避免把不同时间尺度的读数混在一起。
+ * * 网格以最新读数为终点: 最后一个网格值就是最新读数。
+ */
+class HistoryResampler {
+public:
+    static constexpr int kCapacity = 32;    // 保存的原始读数个数
+    static constexpr int kMaxGridSize = 32;
+
+    struct Sample {
+        uint32_t timestampMs;
+        float value;
+        float quality;      // 0~1，低于 Config::minQuality 的读数不进入历史
+    };
+
+    struct Config {
+        uint32_t gridStepMs;        // 模型训练时的采样间隔
+        int gridSize;               // 模型输入窗口长度
+        uint32_t maxGapMs;          // 允许插值跨越的最长读数间隔，更长的间隔使窗口无效
+        uint32_t maxStalenessMs;    // 最新读数距当前时刻的最长时间，超过后窗口无效
+        float minQuality;
+    };
+
+    enum class Status {
+        OK,
+        NOT_ENOUGH_HISTORY,     // 历史尚未覆盖整个网格
+        STALE,                  // 最新读数过旧
+        GAP_TOO_LONG            // 窗口内有超过 maxGapMs 的间隔
+    };
+
+    struct Window {
+        int size;
+        float values[kMaxGridSize];         // 按时间顺序 (从旧到新) 的重采样值
+        float gapMinutes[kMaxGridSize];     // 每个网格点所在读数区间的长度 (分钟)，恰好落在读数上时为0
+        uint32_t longestGapMs;              // 窗口内最长的读数间隔
+    };
+
+    explicit HistoryResampler(const Config& config);
+
+    /**
+     * @brief 加入一个读数。质量过低或时间戳不晚于上一个读数的读数被忽略。
+     * @return bool - 读数被加入时返回true。
+     */
+    bool add(uint32_t timestampMs, float value, float quality = 1.0f);
+
+    void clear();
+
+    int size() const;
+
+    /**
+     * @brief 第 i 个读数 (0 为最旧)。
+     */
+    const Sample& at(int i) const;
+
+    /**
+     * @brief 最新的读数，历史为空时返回nullptr。
+     */
+    const Sample* newest() const;
+
+    /**
+     * @brief 按网格重采样出模型输入窗口。
+     * @param nowMs 当前时刻，用于检查最新读数是否过旧。
+     * @param out 仅在返回 OK 时有效。
+     */
+    Status resample(uint32_t nowMs, Window* out) const;
+
+    const Config& getConfig() const;
+
+private:
+    Config _config;
+    Sample _samples[kCapacity];
+    int _start;
+    int _count;
+};
+
+#endif // HISTORY_RESAMPLER_H
@@ -0,0 +1,125 @@
+#ifndef INFERENCE_SERVICE_H
+#define INFERENCE_SERVICE_H
+
+#include <stdint.h>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * @class InferenceService
+ * @brief 在独立线程 (ESP32上固定到指定核心) 中运行模型推理，避免 Invoke() 阻塞主循环的测量与BLE。
+ * * 请求邮箱只保存最新的一个输入: 推理线程忙时新请求会覆盖尚未开始的旧请求 (合并)，
+ *   因此推理变慢时只会降低预测频率，不会堆积延迟。
+ * * 结果通过回调 (在推理线程中调用) 返回，也可以在主循环中用 takeResult() 轮询。
+ * * 推理本身由 InvokeFn 完成。
+ */
+class InferenceService {
+public:
+    static constexpr int kMaxInputSize = 32;
+    // 集成模型的结果依次为 均值、下界、上界 三段曲线 (见 main.cpp)
+    static constexpr int kMaxOutputSize = 48;
+
+    /**
+     * @brief 推理函数: 用 input 运行模型，把结果写入 output 并设置 *outputSize。
+     * @return bool - 推理成功返回true。
+     */
+    typedef std::function<bool(const float* input, int inputSize, float* output, int* outputSize)> InvokeFn;
+
+    struct Result {
+        uint32_t requestId;
+        bool ok;
+        float output[kMaxOutputSize];
+        int outputSize;
+        uint32_t queueUs;       // 从提交到开始推理的等待时间 (微秒)
+        uint32_t invokeUs;      // 推理耗时 (微秒)
+    };
+
+    typedef std::function<void(const Result&)> ResultCallback;
+
+    struct Stats {
+        uint32_t submitted;
+        uint32_t completed;
+        uint32_t coalesced;     // 被更新的请求覆盖而未执行的请求数
+        uint32_t failed;
+        uint32_t lastQueueUs;
+        uint32_t maxQueueUs;
+        uint32_t lastInvokeUs;
+        uint32_t maxInvokeUs;
+        uint32_t avgInvokeUs;
+    };
+
+    explicit InferenceService(InvokeFn invoke);
+    ~InferenceService();
+
+    InferenceService(const InferenceService&) = delete;
+    InferenceService& operator=(const InferenceService&) = delete;
+
+    /**
+     * @brief 设置结果回调 (需在 start() 之前调用)。回调在推理线程中执行，应尽快返回。
+     */
+    void setResultCallback(ResultCallback callback);
+
+    /**
+     * @brief 启动推理线程。
+     * @param core ESP32上固定的核心号 (-1 表示不固定)；主机上忽略。
+     * @param stackSize ESP32上的线程栈大小 (字节)；主机上忽略。
+     * @param priority ESP32上的任务优先级；主机上忽略。
+     */
+    bool start(int core = -1, uint32_t stackSize = 8192, int priority = 1);
+
+    /**
+     * @brief 停止推理线程 (等待正在进行的推理完成)，未执行的请求被丢弃。
+     */
+    void stop();
+
+    /**
+     * @brief 提交一个推理请求 (拷贝输入，立即返回)。
+     * @return uint32_t - 请求编号，输入过长或服务未启动时返回0。
+     */
+    uint32_t submit(const float* input, int inputSize);
+
+    /**
+     * @brief 取出自上次调用以来最新完成的结果。
+     * @return bool - 有新结果时返回true。
+     */
+    bool takeResult(Result* out);
+
+    /**
+     * @brief 是否有尚未完成的请求 (等待中或正在推理)。
+     */
+    bool isBusy() const;
+
+    Stats getStats() const;
+
+private:
+    void run();
+    static uint32_t nowUs();
+
+    InvokeFn _invoke;
+    ResultCallback _callback;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::thread _thread;
+    bool _running;
+
+    // 请求邮箱 (只保存最新的一个)
+    bool _pending;
+    bool _inFlight;
+    uint32_t _nextId;
+    uint32_t _pendingId;
+    uint32_t _pendingSubmitUs;
+    float _pendingInput[kMaxInputSize];
+    int _pendingInputSize;
+
+    // 最新的结果
+    bool _hasResult;
+    Result _result;
+
+    Stats _stats;
+    uint64_t _totalInvokeUs;
+};
+
+#endif // INFERENCE_SERVICE_H
@@ -0,0 +1,29 @@
+#ifndef KEY_VALUE_STORE_H
+#define KEY_VALUE_STORE_H
+
+#include <stddef.h>
+
+/**
+ * @class KeyValueStore
+ * @brief 持久化键值存储的抽象接口。
+ * * 固件中由 NvsKeyValueStore (基于NVS/Preferences) 实现，主机测试中使用内存实现。
+ */
+class KeyValueStore {
+public:
+    virtual ~KeyValueStore() {}
+
+    /**
+     * @brief 读取键对应的数据。
+     * @return size_t - 读取的字节数，键不存在或 capacity 不足时返回0。
+     */
+    virtual size_t getBytes(const char* key, void* out, size_t capacity) = 0;
+
+    /**
+     * @brief 写入 (覆盖) 键对应的数据。
+     */
+    virtual bool putBytes(const char* key, const void* data, size_t length) = 0;
+
+    virtual bool remove(const char* key) = 0;
+};
+
+#endif // KEY_VALUE_STORE_H
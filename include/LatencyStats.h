@@ -0,0 +1,56 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdint.h>
+
+/**
+ * @class LatencyStats
+ * @brief 收集一组耗时样本并计算分位数 (用于推理基准测试)。
+ * * 样本保存在固定大小的数组中，超过 kMaxSamples 的样本被忽略；summarize() 时原地排序。
+ * * 分位数取 nearest-rank: 排序后第 ceil(p/100 * n) 个样本。
+ */
+class LatencyStats {
+public:
+    static constexpr int kMaxSamples = 1024;
+
+    struct Summary {
+        int count;
+        uint32_t minUs;
+        uint32_t p50Us;
+        uint32_t p90Us;
+        uint32_t p99Us;
+        uint32_t maxUs;
+        uint32_t meanUs;
+    };
+
+    LatencyStats();
+
+    void clear();
+
+    /**
+     * @brief 加入一个样本 (微秒)。
+     * @return bool - 样本已满时返回false。
+     */
+    bool add(uint32_t us);
+
+    int count() const;
+
+    /**
+     * @brief 计算第 p 个百分位数 (0~100)。没有样本时返回0。
+     */
+    uint32_t percentile(float p);
+
+    /**
+     * @brief 计算最小/中位数/P90/P99/最大值与均值。
+     */
+    Summary summarize();
+
+private:
+    void sort();
+
+    uint32_t _samples[kMaxSamples];
+    int _count;
+    bool _sorted;
+};
+
+#endif // LATENCY_STATS_H
@@ -5,6 +5,7 @@
 #include <Wire.h>
 #include "MAX30105.h" // 库名是MAX30105，但它完美兼容MAX30102
 #include "spo2_algorithm.h"
+#include "SensorCapture.h"
 
 /**
  * @class Max30102Controller
@@ -14,6 +15,17 @@
  */
 class Max30102Controller {
 public:
+    // 传感器的采样配置: FIFO 中每个样本是 kSampleAverage 次采样的平均
+    static constexpr uint16_t kSampleRate = 100;
+    static constexpr uint8_t kSampleAverage = 4;
+    // FIFO 样本的间隔 (毫秒)
+    static constexpr uint8_t kSamplePeriodMs = 1000 * kSampleAverage / kSampleRate;
+
+    /**
+     * @brief 每读出一个FIFO样本时调用 (原始波形流等)，参数为IR与Red的原始ADC值。
+     */
+    typedef void (*SampleCallback)(uint32_t ir, uint32_t red);
+
     /**
      * @brief 获取Max30102Controller的全局唯一实例。
      */
@@ -61,11 +73,27 @@ public:
      */
     bool isFingerDetected();
 
+    /**
+     * @brief 设置FIFO样本的回调，nullptr 表示不回调。
+     */
+    void setSampleCallback(SampleCallback callback);
+
+    /**
+     * @brief 设置FIFO样本的录制/回放 (SensorCapture)，nullptr 表示直接读取传感器且不录制。
+     * * 回放时不访问传感器，update() 取出录制时这一次读出的全部样本。
+     */
+    void setCapture(SensorCapture* capture);
+
 
 private:
     // 私有构造函数
     Max30102Controller();
 
+    /**
+     * @brief 把一批FIFO样本送入SpO2算法并回调。
+     */
+    void processSamples(const uint32_t* ir, const uint32_t* red, int count);
+
     MAX30105 _particleSensor; // 来自库的传感器对象
     SpO2Algorithm _spo2_calculator;
 
@@ -73,6 +101,8 @@ private:
     float _spO2;      // 缓存的血氧
     uint32_t _irValue; // 缓存的IR值
     uint32_t _redValue;
+    SampleCallback _sampleCallback;
+    SensorCapture* _capture;
 };
 
 #endif // MAX30102_CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,188 @@
+#ifndef MODEL_IMAGE_H
+#define MODEL_IMAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file ModelImage.h
+ * @brief 独立模型分区 (model_a / model_b) 中模型镜像的格式与A/B槽选择策略。
+ * * 镜像布局: [32字节头][.tflite 模型数据]，所有字段均为小端序。
+ * * 头部格式:
+ *     0  magic         u32  'GMDL'
+ *     4  headerVersion u16
+ *     6  headerSize    u16  (32，模型数据从此偏移开始，保证16字节对齐)
+ *     8  modelVersion  u32  单调递增的模型版本号
+ *    12  modelSize     u32  模型数据长度 (字节)
+ *    16  modelCrc32    u32  模型数据的CRC32 (IEEE 802.3)
+ *    20  flags         u32  低4位为模型精度 (ModelFormat)，其余位保留写0
+ *    24  reserved      u32  保留，写0
+ *    28  headerCrc32   u32  头部前28字节的CRC32
+ * * 模型数据也可以是多个小模型组成的集成模型 (用于给出预测区间)，以目录开头:
+ *     0  magic         u32  'GENS'
+ *     4  count         u32  成员个数 (第一个为主模型)
+ *     8  members       {offset u32, size u32} × count，offset 相对模型数据起始处，16字节对齐
+ */
+namespace ModelImage {
+
+constexpr uint32_t kMagic = 0x4C444D47; // "GMDL"
+constexpr uint16_t kHeaderVersion = 1;
+constexpr size_t kHeaderSize = 32;
+constexpr int kSlotCount = 2;
+
+/**
+ * @brief 模型的数值精度，记录在头部 flags 的低4位。
+ */
+enum class ModelFormat : uint8_t {
+    FLOAT32 = 0,    // 浮点模型
+    INT8 = 1,       // 全整数int8量化模型
+    ANY = 0xFF      // 仅用于启动偏好: 不限精度
+};
+
+constexpr uint32_t kFlagFormatMask = 0x0000000F;
+
+inline ModelFormat formatFromFlags(uint32_t flags) {
+    return (ModelFormat)(flags & kFlagFormatMask);
+}
+
+struct Header {
+    uint32_t magic;
+    uint16_t headerVersion;
+    uint16_t headerSize;
+    uint32_t modelVersion;
+    uint32_t modelSize;
+    uint32_t modelCrc32;
+    uint32_t flags;
+};
+
+enum class ParseResult {
+    OK,
+    BAD_MAGIC,          // 分区为空 (全0xFF) 或不是模型镜像
+    BAD_VERSION,        // 不支持的头部版本
+    BAD_HEADER_CRC,     // 头部损坏
+    BAD_SIZE            // 模型长度为0或超出分区容量
+};
+
+/**
+ * @brief 计算CRC32 (IEEE 802.3, 与 zlib.crc32 一致)，支持分段累加。
+ * @param crc 上一段的返回值，首段传0。
+ */
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+/**
+ * @brief 解析并校验镜像头部 (不校验模型数据)。
+ * @param data 指向分区起始处，至少 kHeaderSize 字节。
+ * @param partitionSize 分区容量，用于检查模型长度。
+ * @param out 解析成功时写入头部字段。
+ */
+ParseResult parseHeader(const uint8_t* data, size_t partitionSize, Header* out);
+
+/**
+ * @brief 将头部序列化为 kHeaderSize 字节 (自动填写magic、版本、长度与头部CRC)。
+ */
+void serializeHeader(const Header& header, uint8_t* out);
+
+/**
+ * @brief 校验模型数据的CRC是否与头部一致。
+ */
+bool verifyPayload(const Header& header, const uint8_t* payload);
+
+/**
+ * @brief 单个槽位的校验结果。
+ */
+struct SlotStatus {
+    bool valid;             // 头部与模型数据CRC均正确
+    uint32_t modelVersion;
+    ModelFormat format;
+};
+
+/**
+ * @brief 持久化的启动状态 (保存在NVS中)。
+ */
+struct BootState {
+    int8_t confirmedSlot;   // 最近一次成功加载并确认的槽位，-1表示无
+    int8_t pendingSlot;     // 新写入、等待试运行确认的槽位，-1表示无
+    uint8_t attempts;       // pendingSlot 已尝试启动的次数
+};
+
+/**
+ * @brief 槽位选择结果。
+ */
+struct SlotDecision {
+    int8_t slot;            // 要加载的槽位，-1表示没有可用的分区模型
+    bool trial;             // 是否为试运行 (加载成功后需要调用确认)
+};
+
+/**
+ * @brief 根据槽位校验结果与启动状态选择本次要加载的模型槽位。
+ * * 1. 待确认的新模型在尝试次数未用完时优先试运行；
+ * * 2. 指定了精度偏好时，选择该精度的有效槽位 (已确认的优先，其次版本最高)；
+ * * 3. 否则使用已确认的槽位 (回滚)；
+ * * 4. 都不可用时，选择版本最高的有效槽位作为试运行。
+ * * 试运行的模型按 recordTrialInference 的结果确认或回滚；确认之前每次启动都计入尝试次数，
+ *   因此推理中崩溃或卡死 (看门狗复位) 的模型在 maxAttempts 次启动后自动回滚。
+ * @param maxAttempts 待确认槽位允许的最大启动尝试次数。
+ * @param preferred 启动时偏好的模型精度，ANY 表示不限。
+ */
+SlotDecision selectSlot(const SlotStatus slots[kSlotCount], const BootState& state, uint8_t maxAttempts,
+                        ModelFormat preferred = ModelFormat::ANY);
+
+/**
+ * @brief 试运行模型的确认条件。
+ */
+struct TrialPolicy {
+    uint16_t requiredInferences;    // 连续成功推理的次数达到后确认
+    float minOutput;                // 输出的合理范围，超出视为模型输出无效
+    float maxOutput;
+};
+
+/**
+ * @brief 试运行的进度 (只保存在RAM中，重启后重新计数)。
+ */
+struct TrialProgress {
+    uint16_t successes;
+};
+
+enum class TrialVerdict {
+    PENDING,    // 继续试运行
+    CONFIRM,    // 确认为新的已确认槽位
+    REJECT      // 放弃试运行，回滚到已确认的槽位
+};
+
+/**
+ * @brief 记录试运行模型的一次推理结果。
+ * * 推理失败、没有输出、或任一输出不是有限值 / 超出 [minOutput, maxOutput] 时判定为 REJECT；
+ * * 第 requiredInferences 次成功时判定为 CONFIRM。
+ * @param invoked 推理是否成功完成。
+ */
+TrialVerdict recordTrialInference(TrialProgress* progress, const TrialPolicy& policy, bool invoked,
+                                  const float* outputs, int count);
+
+/**
+ * @brief 新模型应写入的槽位: 当前正在使用的槽位之外的另一个。
+ * * 正在使用内置模型时，写入已确认槽位之外的槽位；
+ * * 正在试运行且另一个槽位是已确认的回退模型时返回-1: 试运行结束之前不能覆盖回退模型。
+ */
+int8_t updateTargetSlot(int8_t activeSlot, int8_t confirmedSlot);
+
+constexpr uint32_t kEnsembleMagic = 0x534E4547; // "GENS"
+
+/**
+ * @brief 集成模型的一个成员 (指向模型数据内部，不拷贝)。
+ */
+struct EnsembleMember {
+    const uint8_t* data;
+    size_t size;
+};
+
+/**
+ * @brief 解析集成模型目录。
+ * @param payload 模型数据 (镜像头部之后的部分)。
+ * @param members 至少 maxMembers 个元素。
+ * @return int - 成员个数；不是集成模型 (普通 .tflite) 时返回0；目录损坏、成员越界、未对齐或超过 maxMembers 时返回-1。
+ */
+int parseEnsemble(const uint8_t* payload, size_t size, EnsembleMember* members, int maxMembers);
+
+} // namespace ModelImage
+
+#endif // MODEL_IMAGE_H
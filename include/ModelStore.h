@@ -0,0 +1,162 @@
+#ifndef MODEL_STORE_H
+#define MODEL_STORE_H
+
+#include "config.h"
+#include "ModelImage.h"
+#include <esp_partition.h>
+#include <atomic>
+#include <mutex>
+
+/**
+ * @class ModelStore
+ * @brief 管理 model_a / model_b 两个flash分区中的TFLite模型镜像。
+ * * 采用单例模式。
+ * * 启动时校验两个槽位的头部与CRC，按 ModelImage::selectSlot 的A/B策略选择模型，
+ *   并通过 esp_partition_mmap 将其零拷贝映射到地址空间，模型不占用RAM。
+ * * 支持在固件之外单独更新模型: 新模型总是写入未使用的槽位，以试运行方式启动。
+ *   连续 MODEL_TRIAL_CONFIRM_INFERENCES 次推理成功且输出合理 (reportInference) 后才确认；
+ *   推理失败或输出无效时立即回滚并请求重启，确认之前崩溃或卡死的启动计入尝试次数，用完后自动回滚。
+ *   试运行期间不接受新的更新 (BEGIN 返回 BAD_STATE)，已确认的回退模型不会被覆盖。
+ *
+ * 更新协议 (handleUpdatePacket，BLE写入等传输方式共用，多字节字段为小端序):
+ *   0x01 BEGIN  [version u32][size u32][crc32 u32][flags u32 可选]  擦除目标槽位的头部并开始写入 (试运行期间为 BAD_STATE)
+ *   0x02 DATA   [offset u32][bytes...]              按顺序写入模型数据
+ *   0x03 COMMIT                                     校验CRC，写入头部，标记为待确认并请求重启
+ *   0x04 ABORT                                      放弃本次更新
+ *   0x05 SELECT_FORMAT [format u8]                  设置启动时偏好的模型精度 (0: float32, 1: int8, 0xFF: 不限) 并请求重启
+ * 每个数据包返回一个 UpdateStatus 字节作为应答。
+ * 线程: reportInference 可在推理线程中调用，handleUpdatePacket 可在BLE任务中调用，isRestartRequested 由主循环读取。
+ *   启动状态 (_bootState) 与更新状态的读写都在 _mutex 内进行，试运行与重启标志为原子变量。
+ * CRC只用于发现传输中的损坏，不是认证: BLE传输只在经配对码认证的加密连接上接受写入 (BLE_UPDATE_PASSKEY)，
+ * 模型在使用前还要通过flatbuffer结构校验 (GlucosePredictor::loadModel)，校验失败时与加载失败一样回滚。
+ */
+class ModelStore {
+public:
+    enum class UpdateStatus : uint8_t {
+        OK = 0,
+        BAD_REQUEST,    // 数据包格式错误或未知操作码
+        BAD_STATE,      // 未BEGIN就写入、分区不存在，或新模型仍在试运行
+        TOO_LARGE,      // 模型超出槽位容量
+        OUT_OF_ORDER,   // DATA包偏移不连续
+        FLASH_ERROR,    // 擦除/写入flash失败
+        CRC_MISMATCH    // COMMIT时CRC或长度不符
+    };
+
+    /**
+     * @brief 获取ModelStore的全局唯一实例。
+     */
+    static ModelStore& getInstance();
+
+    // 禁止拷贝
+    ModelStore(const ModelStore&) = delete;
+    ModelStore& operator=(const ModelStore&) = delete;
+
+    /**
+     * @brief 查找模型分区，校验两个槽位并映射选中的模型。
+     * @return bool - 找到可用的分区模型时返回true。返回false时可退回固件内置模型。
+     */
+    bool begin();
+
+    /**
+     * @brief 获取当前映射的模型数据 (.tflite flatbuffer)。
+     * @return const uint8_t* - 指向flash映射区，没有可用模型时为nullptr。
+     */
+    const uint8_t* getModelData() const;
+
+    size_t getModelSize() const;
+    uint32_t getModelVersion() const;
+
+    /**
+     * @brief 当前映射模型数据的CRC32 (来自镜像头部)，可作为模型标识。
+     */
+    uint32_t getModelCrc32() const;
+
+    /**
+     * @brief 当前映射模型的精度 (来自镜像头部)，未使用分区模型时返回 ANY。
+     */
+    ModelImage::ModelFormat getModelFormat() const;
+
+    /**
+     * @brief 当前使用的槽位 (0: model_a, 1: model_b)，-1表示未使用分区模型。
+     */
+    int8_t getActiveSlot() const;
+
+    /**
+     * @brief 当前模型是否在试运行 (尚未确认)。
+     */
+    bool isActiveTrial() const;
+
+    /**
+     * @brief 将试运行中的槽位标记为已确认 (通常由 reportInference 在满足确认条件后调用)。
+     */
+    void confirmActiveModel();
+
+    /**
+     * @brief 报告当前模型的一次推理结果。试运行中按 ModelImage::recordTrialInference 的策略确认，
+     *        或放弃试运行并请求重启 (重启后回滚到已确认的模型)。不在试运行时不做任何事。
+     * @param invoked 推理是否成功完成。
+     * @param outputs 预测曲线 (mg/dL)。
+     */
+    void reportInference(bool invoked, const float* outputs, int count);
+
+    /**
+     * @brief 当前模型加载失败时调用，回滚并映射下一个候选槽位。
+     * @return bool - 如果还有其他可用的分区模型，返回true。
+     */
+    bool rejectActiveModel();
+
+    /**
+     * @brief 处理一个模型更新数据包 (格式见类说明)。
+     */
+    UpdateStatus handleUpdatePacket(const uint8_t* packet, size_t length);
+
+    /**
+     * @brief 新模型提交成功后为true，主循环应在合适时机重启以加载新模型。
+     */
+    bool isRestartRequested() const;
+
+private:
+    // 私有构造函数
+    ModelStore();
+
+    UpdateStatus beginUpdate(uint32_t version, uint32_t size, uint32_t crc, uint32_t flags);
+    UpdateStatus selectFormat(ModelImage::ModelFormat format);
+    UpdateStatus writeUpdate(uint32_t offset, const uint8_t* data, size_t length);
+    UpdateStatus commitUpdate();
+    void abortUpdate();
+    void confirmActiveModelLocked();
+
+    void loadBootState();
+    void saveBootState();
+    ModelImage::SlotStatus checkSlot(int slot);
+    bool mapSlot(int8_t slot);
+    void unmapActive();
+    bool selectAndMap();
+
+    const esp_partition_t* _partitions[ModelImage::kSlotCount];
+    ModelImage::SlotStatus _slotStatus[ModelImage::kSlotCount];
+    ModelImage::BootState _bootState;
+    ModelImage::ModelFormat _preferredFormat;
+
+    // 当前映射的模型
+    int8_t _activeSlot;
+    std::atomic<bool> _activeIsTrial;
+    ModelImage::TrialProgress _trialProgress;
+    const uint8_t* _mappedBase;
+    spi_flash_mmap_handle_t _mmapHandle;
+    ModelImage::Header _activeHeader;
+
+    // 进行中的更新
+    bool _updateInProgress;
+    int8_t _updateSlot;
+    ModelImage::Header _updateHeader;
+    uint32_t _updateWritten;    // 已写入的模型数据字节数
+    uint32_t _updateErasedEnd;  // 已擦除区域的结束偏移 (相对分区起始)
+    uint32_t _updateCrc;        // 已写入数据的累计CRC
+
+    // 推理线程、BLE任务与主循环共用
+    std::mutex _mutex;
+    std::atomic<bool> _restartRequested;
+};
+
+#endif // MODEL_STORE_H
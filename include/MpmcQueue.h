@@ -0,0 +1,131 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * @class MpmcQueue
+ * @brief 定长的无锁多生产者多消费者队列 (每个槽位带序号的环形缓冲区，D. Vyukov 的算法)。
+ * * tryPush()/tryPop() 从不阻塞也不分配内存: 队列满时 tryPush() 立即返回false 并计数，
+ *   因此可以在任意任务中调用；T 为平凡可拷贝的小结构体时也可以在中断中调用。
+ * * highWaterMark() 记录出现过的最大长度，用于确定队列深度。
+ * * Capacity 必须是2的幂。
+ */
+template <typename T, size_t Capacity>
+class MpmcQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    MpmcQueue() : _enqueuePos(0), _dequeuePos(0), _highWaterMark(0), _dropped(0) {
+        for (size_t i = 0; i < Capacity; i++) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    /**
+     * @brief 放入一个元素。
+     * @return bool - 队列已满时返回false (元素被丢弃)。
+     */
+    bool tryPush(const T& item) {
+        size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &_cells[pos & (Capacity - 1)];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        updateHighWaterMark(pos + 1 - _dequeuePos.load(std::memory_order_relaxed));
+        return true;
+    }
+
+    /**
+     * @brief 取出一个元素。
+     * @return bool - 队列为空时返回false。
+     */
+    bool tryPop(T* item) {
+        size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &_cells[pos & (Capacity - 1)];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        *item = cell->data;
+        cell->sequence.store(pos + Capacity, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 当前长度 (并发修改时为近似值)。
+     */
+    size_t size() const {
+        size_t enqueued = _enqueuePos.load(std::memory_order_relaxed);
+        size_t dequeued = _dequeuePos.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+    size_t highWaterMark() const {
+        return _highWaterMark.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 因队列满而丢弃的元素数。
+     */
+    uint32_t droppedCount() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    void updateHighWaterMark(size_t length) {
+        // 消费者可能同时在取，长度按无符号差计算时可能短暂地"超过"容量
+        if (length > Capacity) {
+            return;
+        }
+        size_t mark = _highWaterMark.load(std::memory_order_relaxed);
+        while (length > mark && !_highWaterMark.compare_exchange_weak(mark, length, std::memory_order_relaxed)) {
+        }
+    }
+
+    Cell _cells[Capacity];
+    std::atomic<size_t> _enqueuePos;
+    std::atomic<size_t> _dequeuePos;
+    std::atomic<size_t> _highWaterMark;
+    std::atomic<uint32_t> _dropped;
+};
+
+#endif // MPMC_QUEUE_H
@@ -0,0 +1,65 @@
+#ifndef NIMBLE_TRANSPORT_H
+#define NIMBLE_TRANSPORT_H
+
+#include <NimBLEDevice.h>
+#include <atomic>
+#include "BleTransport.h"
+
+// BleTransport on NimBLE-Arduino (the default stack, BLE_USE_NIMBLE=1). NimBLE needs noticeably less heap and
+// flash than Bluedroid and adds the CCCD descriptors itself; the callbacks are members and are
+// registered without handing ownership to the library.
+class NimbleTransport : public BleTransport {
+public:
+    NimbleTransport();
+
+    bool begin(const char* deviceName, uint16_t preferredMtu, Listener* listener) override;
+    bool isConnected() const override;
+    void setValue(Characteristic characteristic, const uint8_t* data, size_t length) override;
+    void startAdvertising() override;
+    bool send(Characteristic characteristic, const uint8_t* data, size_t length) override;
+    const char* name() const override;
+
+    // Passkey the phone has to enter when it pairs; writes to the model update characteristic
+    // are only accepted on an encrypted link authenticated with it (MITM). Call before begin().
+    void setUpdatePasskey(uint32_t passkey);
+
+private:
+    NimBLECharacteristic* createCharacteristic(NimBLEService* pService, const NimBLEUUID& uuid, uint32_t properties,
+                                               Characteristic characteristic);
+
+    // Callback class to handle connect/disconnect and MTU events
+    class ServerCallbacks : public NimBLEServerCallbacks {
+    public:
+        explicit ServerCallbacks(NimbleTransport& owner);
+        void onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) override;
+        void onDisconnect(NimBLEServer* pServer) override;
+        void onMTUChange(uint16_t mtu, ble_gap_conn_desc* desc) override;
+    private:
+        NimbleTransport& owner;
+    };
+
+    // Callback class that forwards writes on one characteristic to the listener
+    class WriteCallbacks : public NimBLECharacteristicCallbacks {
+    public:
+        WriteCallbacks(NimbleTransport& owner, Characteristic characteristic);
+        void onWrite(NimBLECharacteristic* pCharacteristic) override;
+    private:
+        NimbleTransport& owner;
+        Characteristic characteristic;
+    };
+
+    NimBLEServer* pServer;
+    NimBLECharacteristic* characteristics[kCharacteristicCount];
+    Listener* listener;
+    uint32_t updatePasskey;
+    // Written by the stack's callbacks, read from any task
+    std::atomic<bool> deviceConnected;
+
+    ServerCallbacks serverCallbacks;
+    WriteCallbacks modelUpdateCallbacks;
+    WriteCallbacks racpCallbacks;
+    WriteCallbacks waveformCallbacks;
+    WriteCallbacks rollupCallbacks;
+};
+
+#endif // NIMBLE_TRANSPORT_H
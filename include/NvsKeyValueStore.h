@@ -0,0 +1,26 @@
+#ifndef NVS_KEY_VALUE_STORE_H
+#define NVS_KEY_VALUE_STORE_H
+
+#include "KeyValueStore.h"
+
+/**
+ * @class NvsKeyValueStore
+ * @brief 基于NVS (Preferences) 的 KeyValueStore，每个实例对应一个命名空间。
+ * * NVS 本身按页轮换写入 (磨损均衡)，调用方仍应批量写入以减少擦写次数。
+ */
+class NvsKeyValueStore : public KeyValueStore {
+public:
+    /**
+     * @param nvsNamespace NVS命名空间 (最长15个字符)。
+     */
+    explicit NvsKeyValueStore(const char* nvsNamespace);
+
+    size_t getBytes(const char* key, void* out, size_t capacity) override;
+    bool putBytes(const char* key, const void* data, size_t length) override;
+    bool remove(const char* key) override;
+
+private:
+    const char* _namespace;
+};
+
+#endif // NVS_KEY_VALUE_STORE_H
@@ -0,0 +1,89 @@
+#ifndef OP_PROFILE_H
+#define OP_PROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @class OpProfile
+ * @brief 按算子统计 Invoke() 耗时: 每次推理中第 i 个算子的最近/最短/最长/累计耗时。
+ * * 由 TflmOpProfiler (tflite::MicroProfiler 的子类) 在每个算子前后调用 beginOp()/endOp()，
+ *   推理前后调用 beginRun()/endRun()。
+ * * 结果可按 CSV 或 JSON 逐行输出 (例如打印到串口)。
+ */
+class OpProfile {
+public:
+    static constexpr int kMaxOps = 64;
+    static constexpr uint32_t kInvalidHandle = 0xFFFFFFFF;
+
+    struct OpStats {
+        const char* tag;        // 算子名称 (TFLM 内核注册的名称，静态字符串)
+        uint32_t lastUs;
+        uint32_t minUs;
+        uint32_t maxUs;
+        uint64_t totalUs;
+    };
+
+    /**
+     * @brief 逐行输出的回调 (行末不含换行符)。
+     */
+    typedef void (*LineWriter)(const char* line);
+
+    OpProfile();
+
+    /**
+     * @brief 清空所有统计 (例如加载了另一个模型)。
+     */
+    void reset();
+
+    /**
+     * @brief 开始记录一次推理。
+     */
+    void beginRun();
+
+    /**
+     * @brief 记录一个算子开始执行。
+     * @return uint32_t - 传给 endOp() 的句柄，超过 kMaxOps 个算子时返回 kInvalidHandle。
+     */
+    uint32_t beginOp(const char* tag, uint32_t nowUs);
+    void endOp(uint32_t handle, uint32_t nowUs);
+
+    /**
+     * @brief 结束一次推理，把本次各算子的耗时累计到统计中。
+     * * 算子序列与之前的推理不同 (换了模型) 时，先清空旧的统计。
+     */
+    void endRun();
+
+    int getOpCount() const;
+    const OpStats& getOp(int index) const;
+    uint32_t getRunCount() const;
+
+    /**
+     * @brief 最近一次推理中所有算子耗时之和 (微秒)。
+     */
+    uint32_t getLastRunUs() const;
+
+    /**
+     * @brief 按CSV输出: 表头一行，之后每个算子一行 (index,op,last_us,avg_us,min_us,max_us,share_pct)。
+     */
+    void writeCsv(LineWriter write) const;
+
+    /**
+     * @brief 按JSON输出 (多行组成一个对象)，附带 arena 用量。
+     */
+    void writeJson(LineWriter write, size_t arenaUsedBytes, size_t arenaSize) const;
+
+private:
+    OpStats _ops[kMaxOps];
+    int _opCount;
+    uint32_t _runCount;
+    uint64_t _totalRunUs;
+
+    // 当前这次推理的记录
+    const char* _runTags[kMaxOps];
+    uint32_t _runStartUs[kMaxOps];
+    uint32_t _runUs[kMaxOps];
+    int _runOpCount;
+};
+
+#endif // OP_PROFILE_H
@@ -0,0 +1,72 @@
+#ifndef PREDICTION_CURVE_H
+#define PREDICTION_CURVE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file PredictionCurve.h
+ * @brief 多步预测曲线: 从模型输出张量取出曲线，以及BLE通知使用的紧凑二进制格式。
+ * * 曲线包格式 (小端序):
+ *     0  version      u8   kCurvePacketVersion
+ *     1  count        u8   曲线点数 N
+ *     2  stepMinutes  u8   相邻两点的时间间隔 (分钟)，第i点为 (i+1)*stepMinutes 分钟后的预测
+ *     3  flags        u8   bit0: 附带预测区间 (kFlagInterval)，其余位写0
+ *     4  values       i16 × N，单位 0.1 mg/dL，超出范围时饱和
+ *        lower/upper  i16 × N 各一组，仅在 flags 含 kFlagInterval 时存在 (集成模型的区间下界与上界)
+ */
+namespace PredictionCurve {
+
+constexpr uint8_t kCurvePacketVersion = 1;
+constexpr size_t kCurvePacketHeaderSize = 4;
+constexpr uint8_t kFlagInterval = 0x01;
+
+/**
+ * @brief 曲线的只读视图，不拥有数据 (浮点模型时直接指向输出张量)。
+ */
+struct Curve {
+    const float* data;
+    int size;           // 0 表示无可用预测
+};
+
+/**
+ * @brief 从模型输出取出曲线。
+ * * 浮点输出直接返回指向输出张量的视图 (零拷贝)；int8输出按 scale/zero_point 反量化到 buffer 中。
+ * @param output 输出张量的数据指针 (float* 或 int8_t*)。
+ * @param count 输出元素个数。
+ * @param quantized 输出是否为int8。
+ * @param buffer int8输出时的反量化缓冲区，至少 maxCount 个元素。
+ * @param maxCount 曲线的最大点数，超出的部分被截断。
+ */
+Curve fromOutput(const void* output, int count, bool quantized, float scale, int32_t zeroPoint,
+                 float* buffer, int maxCount);
+
+/**
+ * @brief 曲线包所需的字节数。
+ * @param withInterval 是否附带预测区间。
+ */
+constexpr size_t packetSize(int count, bool withInterval = false) {
+    return kCurvePacketHeaderSize + (withInterval ? 6 : 2) * (size_t)(count > 0 ? count : 0);
+}
+
+/**
+ * @brief 将曲线编码为一个BLE通知包。
+ * @param lower, upper 预测区间的下界与上界 (各 curve.size 个)，均为nullptr时不附带区间。
+ * @return size_t - 写入的字节数，out 容量不足或点数超过255时返回0。
+ */
+size_t encodePacket(const Curve& curve, uint8_t stepMinutes, uint8_t* out, size_t capacity,
+                    const float* lower = nullptr, const float* upper = nullptr);
+
+/**
+ * @brief 解码曲线包 (供测试与主机端工具使用)。
+ * @param values 输出的预测值 (mg/dL)，至少 maxCount 个元素。
+ * @param lower, upper 包中附带区间且不为nullptr时写入区间，否则忽略。
+ * @param hasInterval 不为nullptr时写入包中是否附带区间。
+ * @return int - 点数，包格式错误时返回-1。
+ */
+int decodePacket(const uint8_t* packet, size_t length, uint8_t* stepMinutes, float* values, int maxCount,
+                 float* lower = nullptr, float* upper = nullptr, bool* hasInterval = nullptr);
+
+} // namespace PredictionCurve
+
+#endif // PREDICTION_CURVE_H
@@ -0,0 +1,35 @@
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * @file Quantization.h
+ * @brief int8 仿射量化的换算: real = scale * (q - zeroPoint)。
+ * * 与 TFLite 的 TfLiteQuantizationParams 约定一致 (按张量量化，四舍五入并饱和到 [-128, 127])。
+ */
+namespace Quantization {
+
+/**
+ * @brief 将实数量化为int8。
+ * @param scale 张量的量化步长 (必须大于0)。
+ * @param zeroPoint 张量的零点。
+ */
+inline int8_t quantizeInt8(float value, float scale, int32_t zeroPoint) {
+    float scaled = roundf(value / scale) + (float)zeroPoint;
+    if (scaled < -128.0f) return -128;
+    if (scaled > 127.0f) return 127;
+    return (int8_t)scaled;
+}
+
+/**
+ * @brief 将int8反量化为实数。
+ */
+inline float dequantizeInt8(int8_t q, float scale, int32_t zeroPoint) {
+    return scale * (float)((int32_t)q - zeroPoint);
+}
+
+} // namespace Quantization
+
+#endif // QUANTIZATION_H
@@ -0,0 +1,90 @@
+#ifndef READING_LOG_H
+#define READING_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "TimeSeriesStore.h"
+#include "SeriesCodec.h"
+
+/**
+ * @class ReadingLog
+ * @brief 读数的持久化历史: 读数在RAM中压缩进一个定长块 (SeriesCodec)，块满时作为一条 TimeSeriesStore 记录写入flash。
+ * * 每个读数保存血糖、心率、SpO2、温度、湿度与信号质量，按各自的分辨率量化
+ *   (0.1 mg/dL、0.1 bpm、0.1 %、0.1 °C、0.1 %、0.01)。2秒一次的稳定读数约4字节/个，
+ *   原始的 时间戳 + 6个float 为28字节。
+ * * 块可以单独解码，长度不超过 BLE 特征值的上限 (512字节)，同步时可以原样发送。
+ * * 尚未写入的一块在掉电时丢失，计划内的重启前应调用 flush()。
+ * * RTC 在断电后从0开始: 读数时间早于日志中最新的读数时，之后的读数整体平移到最新的时间之后，
+ *   保证存储中的时间不减 (间隔保持不变)。
+ */
+class ReadingLog {
+public:
+    // 类型1是只有血糖的旧格式 (varint 差分)，读取时跳过
+    static constexpr uint8_t kRecordType = 2;
+    static constexpr int kChannels = 6;
+    static constexpr size_t kMinBlockSize = 64;
+    static constexpr size_t kMaxBlockSize = TimeSeriesStore::kMaxPayloadSize;
+
+    struct Reading {
+        uint32_t timestamp;     // 秒
+        float glucose;          // mg/dL
+        float heartRate;        // bpm
+        float spo2;             // %
+        float temperature;      // °C，无效时为NAN
+        float humidity;         // %，无效时为NAN
+        float quality;          // 信号质量 0~1
+    };
+
+    /**
+     * @param blockSize 每条记录 (压缩块) 的字节数 (kMinBlockSize..kMaxBlockSize)。
+     *        每段放下整数条记录时flash利用率最高，例如 492 (每段8条)。
+     */
+    ReadingLog(TimeSeriesStore& store, size_t blockSize);
+
+    /**
+     * @brief 追加一个读数，块满时先把已有的块写入flash。
+     * @return bool - 写入flash失败时返回false (这个读数被丢弃，已有的块留在RAM中，下一次重试)。
+     */
+    bool add(const Reading& reading);
+
+    /**
+     * @brief 把RAM中未满的块写入flash。
+     */
+    bool flush();
+
+    int pending() const;
+
+    /**
+     * @brief 最新读数在日志中的时间 (RTC 回退后为平移过的时间)，没有读数时为0。
+     */
+    uint32_t newestTimestamp() const;
+
+    /**
+     * @brief 读取 [from, to] 内的读数 (按时间顺序，包括尚未写入flash的)。
+     * @return int - 写入 out 的个数。
+     */
+    int read(uint32_t from, uint32_t to, Reading* out, int maxReadings);
+
+    /**
+     * @brief 把一批读数编码为一个块。
+     * @return size_t - 编码长度，count 为0或 capacity 放不下全部读数时返回0。
+     */
+    static size_t encodeBlock(const Reading* readings, int count, uint8_t* out, size_t capacity);
+
+    /**
+     * @brief 解码一个块。
+     * @return int - 读数个数，格式错误或 maxReadings 不足时返回-1。
+     */
+    static int decodeBlock(const uint8_t* data, size_t length, Reading* out, int maxReadings);
+
+private:
+    bool startBlock();
+
+    TimeSeriesStore& _store;
+    size_t _blockSize;
+    SeriesCodec::BlockEncoder _encoder;
+    uint8_t _block[kMaxBlockSize];
+    uint32_t _timeOffset;       // RTC 回退后加到读数时间上的偏移 (秒)
+};
+
+#endif // READING_LOG_H
@@ -0,0 +1,97 @@
+#ifndef REPLAY_DRIVER_H
+#define REPLAY_DRIVER_H
+
+#include <stdint.h>
+#include "config.h"
+
+/**
+ * @class ReplayDriver
+ * @brief 按 SENSOR_CAPTURE_MODE 组织原始传感器数据的录制与回放 (SensorCapture)，主循环只调用几个钩子。
+ * * 采用单例模式。SENSOR_CAPTURE_OFF 时所有钩子都是空操作，也不打开 capture 分区。
+ * * 录制: begin() 开始一个新的会话并接到HAL与处理链路，flush() 在计划内的重启前写入未满的一块。
+ * * 回放: 每轮 loop() 以 beginRound() 开始，以 endRound() 代替两次测量之间的等待。
+ *   一轮的读取全部来自录制的数据时，这一轮 digest() 计入的输出才算入回放的CRC32 (回放在一轮中间结束时丢弃这一轮)，
+ *   同一次录制回放两次的结果相同，算法改动前后可以直接比较。回放结束时输出汇总并恢复直接读取传感器。
+ * * 录制时同样计算输出的CRC32 (flush() 时输出)，与回放的结果相同说明回放逐位重现了录制时的处理。
+ * * 模式默认为 SENSOR_CAPTURE_MODE。主机模拟总是编译录制与回放，可以在 setup() 之前用 setMode() 选择
+ *   (见 test_simulation_replay)。
+ */
+class ReplayDriver {
+public:
+    /**
+     * @brief 获取ReplayDriver的全局唯一实例。
+     */
+    static ReplayDriver& getInstance();
+
+    // 禁止拷贝
+    ReplayDriver(const ReplayDriver&) = delete;
+    ReplayDriver& operator=(const ReplayDriver&) = delete;
+
+    /**
+     * @brief 选择模式 (SENSOR_CAPTURE_OFF / _RECORD / _REPLAY)，在 begin() 之前调用。
+     * * 固件中录制与回放只在 SENSOR_CAPTURE_MODE 不为 OFF 时编译，否则任何模式都不起作用。
+     */
+    void setMode(int mode);
+    int getMode() const;
+
+    /**
+     * @brief 打开 capture 分区，按模式开始录制或回放 (在HAL与处理链路初始化之后调用)。
+     */
+    void begin();
+
+    /**
+     * @brief 是否正在录制。
+     */
+    bool isRecording() const;
+
+    /**
+     * @brief 是否正在回放: 读数不写入历史，推理在主循环中进行 (输出不受推理任务合并请求的影响)。
+     */
+    bool isReplaying() const;
+
+    /**
+     * @brief 处理链路使用的时钟: 录制时记下 nowMs，回放时返回录制的值。
+     */
+    uint32_t clock(uint32_t nowMs);
+
+    /**
+     * @brief 一轮 loop() 开始。
+     * @return bool - 回放已经结束时返回false，主循环不再测量。
+     */
+    bool beginRound();
+
+    /**
+     * @brief 把这一轮的输出计入校验值 (只在录制或回放时)。
+     */
+    void digest(const float* values, int count);
+
+    /**
+     * @brief 一轮 loop() 结束: 回放时取出录制时两次测量之间读出的FIFO样本，回放结束时输出汇总。
+     * @return bool - 回放时返回true，调用方不再等待下一次测量。
+     */
+    bool endRound();
+
+    /**
+     * @brief 录制时把未满的一块写入flash，并输出录制至今的轮数与输出的CRC32。
+     */
+    void flush();
+
+    /**
+     * @brief 已完成的各轮的输出CRC32与轮数 (录制或回放)。
+     */
+    uint32_t getDigest() const;
+    uint32_t getRounds() const;
+
+private:
+    // 私有构造函数
+    ReplayDriver();
+
+    int _mode;
+    bool _replayStarted;
+    bool _replayFinished;
+    uint32_t _digest;           // 已完成的各轮的输出CRC32
+    uint32_t _roundDigest;      // 包括当前一轮的输出
+    uint32_t _rounds;
+};
+
+#endif // REPLAY_DRIVER_H
@@ -0,0 +1,115 @@
+#ifndef ROLLUP_ENGINE_H
+#define ROLLUP_ENGINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @class RollupEngine
+ * @brief 血糖读数的分层降采样: 读数到达时增量维护 1分钟 / 5分钟 / 1小时 的 min/max/mean/count。
+ * * 每层一个定长的环形缓冲区，满时覆盖最旧的一档；add() 对每层 O(1)。
+ *   查询几小时到几天的趋势只需读取几百档，而不是几万个2秒读数。
+ * * 档按时间对齐 (start = timestamp - timestamp % period)，没有读数的时段不占用空间；
+ *   当前未结束的一档也参与查询。时间回退 (早于当前一档) 的读数并入当前一档。
+ * * 数值按 0.1 mg/dL 保存 (每档12字节)，NAN 被忽略。
+ * * BLE 查询页 (encodePage) 的格式 (小端序):
+ *     0  tier      u8   层级
+ *     1  count     u8   档数 N (0..kMaxPageEntries)
+ *     2  period    u16  每档的秒数
+ *     4  entries   N × { start u32, count u16, min u16, max u16, mean u16 }，浓度单位 0.1 mg/dL
+ *   最多 4 + 42 × 12 = 508 字节，不超过 BLE 特征值的上限 (512字节)。
+ */
+class RollupEngine {
+public:
+    enum Tier : uint8_t {
+        MINUTE = 0,             // 1分钟
+        FIVE_MINUTES = 1,       // 5分钟
+        HOUR = 2                // 1小时
+    };
+
+    static constexpr int kTierCount = 3;
+    // 各层保存的档数: 6小时、48小时、64小时 (共约12 KB)。
+    // 启动时从读数历史重建，小时层只需覆盖历史能保存的范围 (444 KB 的 spiffs 分区约2.4天的2秒读数)，更多的档重启后也是空的
+    static constexpr int kMinuteBuckets = 360;
+    static constexpr int kFiveMinuteBuckets = 576;
+    static constexpr int kHourBuckets = 64;
+
+    static constexpr size_t kPageHeaderSize = 4;
+    static constexpr size_t kPageEntrySize = 12;
+    static constexpr int kMaxPageEntries = 42;
+    static constexpr size_t kMaxPageSize = kPageHeaderSize + kMaxPageEntries * kPageEntrySize;
+
+    struct Rollup {
+        uint32_t start;         // 这一档的起始时间 (秒)
+        uint16_t count;         // 读数个数
+        float min;
+        float max;
+        float mean;
+    };
+
+    RollupEngine();
+
+    /**
+     * @brief 加入一个读数，更新每一层的当前一档。
+     */
+    void add(uint32_t timestamp, float glucose);
+
+    /**
+     * @brief 与 [from, to] 相交的档 (按时间顺序)。环中按二分查找定位，不扫描整层。
+     * @return int - 写入 out 的档数。
+     */
+    int query(Tier tier, uint32_t from, uint32_t to, Rollup* out, int maxRollups) const;
+
+    /**
+     * @brief 一层中保存的档数 (包括当前一档)。
+     */
+    int count(Tier tier) const;
+
+    static uint32_t period(Tier tier);
+
+    void clear();
+
+    /**
+     * @brief 编码一页供 BLE 读取: latest 为true时是最新的 kMaxPageEntries 档，否则从与 from 相交的一档开始。
+     * @return size_t - 编码长度，capacity 不足一个页头时返回0。
+     */
+    size_t encodePage(Tier tier, uint32_t from, bool latest, uint8_t* out, size_t capacity) const;
+
+private:
+    struct Bucket {
+        uint32_t start;
+        uint16_t count;
+        int16_t min;            // 0.1 mg/dL
+        int16_t max;
+        int16_t mean;
+    };
+
+    struct Ring {
+        Bucket* buckets;
+        int capacity;
+        uint32_t period;
+        int head;               // 最旧一档的位置
+        int count;              // 已结束的档数
+        // 当前未结束的一档
+        bool open;
+        uint32_t openStart;
+        uint16_t openCount;
+        float openMin;
+        float openMax;
+        float openSum;
+    };
+
+    static void closeOpen(Ring& ring);
+    static Bucket openBucket(const Ring& ring);
+    // 第 index 档 (0为最旧，count 为当前一档)
+    static Bucket at(const Ring& ring, int index);
+    static int total(const Ring& ring);
+    static int lowerBound(const Ring& ring, uint32_t from);
+
+    Bucket _minute[kMinuteBuckets];
+    Bucket _fiveMinute[kFiveMinuteBuckets];
+    Bucket _hour[kHourBuckets];
+    Ring _rings[kTierCount];
+};
+
+#endif // ROLLUP_ENGINE_H
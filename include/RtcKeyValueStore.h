@@ -0,0 +1,33 @@
+#ifndef RTC_KEY_VALUE_STORE_H
+#define RTC_KEY_VALUE_STORE_H
+
+#include <stdint.h>
+#include "KeyValueStore.h"
+
+/**
+ * @class RtcKeyValueStore
+ * @brief 基于RTC内存 (RTC_NOINIT) 的 KeyValueStore，只保存一个键，写入新键时覆盖旧键。
+ * * 内容在软件复位、看门狗复位与异常重启后保留，断电后丢失；与RTC时钟保留的情形相同，
+ *   因此适合只在RTC时间连续时才有效的检查点。写入没有flash擦写，可以每个读数都写入。
+ * * 启动时内容未初始化: 读取时校验 magic、键名与CRC，不通过时视为没有数据。
+ *   固件更新后RTC内存的布局可能改变，同样因校验失败而被丢弃。
+ * * 单例。
+ */
+class RtcKeyValueStore : public KeyValueStore {
+public:
+    static constexpr size_t kCapacity = 512;
+
+    static RtcKeyValueStore& getInstance();
+
+    RtcKeyValueStore(const RtcKeyValueStore&) = delete;
+    RtcKeyValueStore& operator=(const RtcKeyValueStore&) = delete;
+
+    size_t getBytes(const char* key, void* out, size_t capacity) override;
+    bool putBytes(const char* key, const void* data, size_t length) override;
+    bool remove(const char* key) override;
+
+private:
+    RtcKeyValueStore() {}
+};
+
+#endif // RTC_KEY_VALUE_STORE_H
@@ -0,0 +1,178 @@
+#ifndef SENSOR_CAPTURE_H
+#define SENSOR_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "TimeSeriesStore.h"
+
+/**
+ * @class SensorCapture
+ * @brief 原始传感器输入的录制与确定性回放，用于在电脑或设备上重现现场问题、在真实数据上对比算法改动。
+ * * 录制: HAL 把每次读到的原始数据 (ADC采样块、MAX30102 FIFO样本、DHT22读数) 与处理链路读取的时钟
+ *   按调用顺序写成事件，事件压缩进一个定长块，块满时作为一条 TimeSeriesStore 记录写入flash。
+ * * 回放: HAL 不再读取硬件，而是按同样的顺序取出录制的数据 (时钟返回录制的值)，
+ *   处理链路 (SpO2、血糖计算、滤波、预测) 的输出与录制时逐位相同。
+ *   调用顺序与录制时不一致 (代码改动改变了读取传感器的方式) 时回放停止，hasDiverged() 为true。
+ * * 每次 startCapture() 开始一个新的会话，回放总是从会话的第一块开始 (处理链路从初始状态开始)。
+ * * 块格式 (小端序):
+ *     0  version   u8   kBlockVersion
+ *     1  flags     u8   bit0: 会话的第一块
+ *     2  session   u16  会话序号
+ *     4  startMs   u32  第一个事件的时间 (设备 millis())
+ *     8  events    逐个事件: type u8, varint(与上一个事件的时间差 ms)，之后按类型:
+ *        EVENT_ADC    varint(N), N × varint(zigzag(与上一个ADC采样的差))
+ *        EVENT_FIFO   varint(N), N × { varint(zigzag(IR差)), varint(zigzag(Red差)) }
+ *        EVENT_DHT    ok u8, temperature f32, humidity f32 (原始位，NAN 原样保存)
+ *        EVENT_CLOCK  无 (事件时间即时钟的值)
+ *   差分的前一个值在每块开始时为0，每块可以单独解码。
+ */
+class SensorCapture {
+public:
+    static constexpr uint8_t kRecordType = 3;
+    static constexpr uint8_t kBlockVersion = 1;
+    static constexpr size_t kBlockHeaderSize = 8;
+    // 每个事件最多的采样数，更长的读取拆成多个事件
+    static constexpr int kMaxAdcSamples = 64;
+    static constexpr int kMaxFifoSamples = 32;     // MAX30102 FIFO 深度
+    // 最长的事件: FIFO 事件，每个差分最多5字节
+    static constexpr size_t kMaxEventSize = 1 + 5 + 5 + kMaxFifoSamples * 2 * 5;
+    static constexpr size_t kMinBlockSize = kBlockHeaderSize + kMaxEventSize;
+    static constexpr size_t kMaxBlockSize = TimeSeriesStore::kMaxPayloadSize;
+    static constexpr int kLatestSession = -1;
+
+    enum EventType : uint8_t {
+        EVENT_NONE = 0,         // 回放结束
+        EVENT_ADC = 1,
+        EVENT_FIFO = 2,
+        EVENT_DHT = 3,
+        EVENT_CLOCK = 4
+    };
+
+    enum class Mode {
+        IDLE,
+        CAPTURING,
+        REPLAYING
+    };
+
+    struct Stats {
+        uint32_t events;
+        uint32_t adcSamples;
+        uint32_t fifoSamples;
+        uint32_t blocks;            // 写入或读出的块数
+        uint32_t bytes;             // 块的总字节数
+        uint32_t failedWrites;      // 写入flash失败而丢弃的块
+    };
+
+    /**
+     * @param blockSize 每条记录 (块) 的字节数 (kMinBlockSize..kMaxBlockSize)。
+     *        每段放下整数条记录时flash利用率最高，例如 1004 (每段4条)。
+     */
+    SensorCapture(TimeSeriesStore& store, size_t blockSize);
+
+    /**
+     * @brief 开始一个新的录制会话 (会话序号为存储中最新的会话 + 1)。
+     */
+    bool startCapture(uint32_t nowMs);
+
+    /**
+     * @brief 从会话的第一块开始回放 (kLatestSession 为存储中最新的会话)。
+     * @return bool - 会话不存在或第一块已被覆盖时返回false。
+     */
+    bool startReplay(int session = kLatestSession);
+
+    /**
+     * @brief 结束录制 (写入未满的一块) 或回放。
+     */
+    void stop();
+
+    Mode getMode() const;
+    bool isCapturing() const;
+    bool isReplaying() const;
+
+    /**
+     * @brief 回放因调用顺序与录制时不一致而停止。
+     */
+    bool hasDiverged() const;
+
+    uint16_t getSession() const;
+    const Stats& getStats() const;
+
+    /**
+     * @brief 把RAM中未满的块写入flash (录制时)。
+     */
+    bool flush();
+
+    // --- 录制 (不在录制时忽略) ---
+    void recordAdc(uint32_t timeMs, const uint16_t* samples, int count);
+    void recordFifo(uint32_t timeMs, const uint32_t* ir, const uint32_t* red, int count);
+    void recordDht(uint32_t timeMs, bool ok, float temperature, float humidity);
+
+    // --- 回放 (ADC、DHT22 与时钟: 下一个事件的类型不符时停止回放) ---
+    /**
+     * @brief 取出 count 个ADC采样 (与录制时的读取次数相同，可以跨多个事件)。
+     */
+    bool replayAdc(uint16_t* samples, int count);
+
+    /**
+     * @brief 取出下一个FIFO事件的样本 (最多 kMaxFifoSamples 个)。一次 update() 读出的样本较多时
+     *        录制为连续的多个事件，应循环调用直到返回0。
+     * @return int - 样本个数，下一个事件不是FIFO事件 (录制时这次没有读出样本) 时返回0，不在回放时返回-1。
+     */
+    int replayFifo(uint32_t* ir, uint32_t* red);
+
+    bool replayDht(bool* ok, float* temperature, float* humidity);
+
+    /**
+     * @brief 下一个事件的类型 (不取出)，回放结束时为 EVENT_NONE。
+     */
+    EventType peekEvent();
+
+    /**
+     * @brief 处理链路读取时钟: 录制时记下并返回 nowMs，回放时返回录制的值，其他时候原样返回 nowMs。
+     */
+    uint32_t clock(uint32_t nowMs);
+
+private:
+    void startBlock(uint32_t timeMs);
+    // 写入事件头 (类型与时间差)，当前块放不下 maxSize 字节的事件时先把当前块写入flash
+    void beginEvent(uint32_t timeMs, uint8_t type, size_t maxSize);
+    void writeVarint(uint32_t value);
+    uint32_t recordTime(uint32_t timeMs) const;
+
+    // 读入 _cursor 处的下一块，会话结束时返回false (first 为true时是会话的第一块)
+    bool loadBlock(bool first);
+    // 解析下一个事件的类型与时间
+    void prepareNext();
+    // 下一个事件是 type 时返回true，否则停止回放
+    bool readEvent(uint8_t type);
+    bool readVarint(uint32_t* value);
+    void stopReplay();
+
+    TimeSeriesStore& _store;
+    size_t _blockSize;
+    Mode _mode;
+    bool _diverged;
+    uint16_t _session;
+    Stats _stats;
+
+    uint8_t _block[kMaxBlockSize];
+    size_t _length;             // 录制: 已写入的字节数；回放: 块的长度
+    size_t _offset;             // 回放: 下一个事件内容 (时间差之后) 的位置
+    bool _sessionStart;         // 录制: 下一块是会话的第一块
+    uint32_t _lastEventMs;
+    uint32_t _timeBase;         // 录制: 记录时间 (秒) 的起点，保证存储中的时间不减
+    uint32_t _sessionStartMs;
+    uint32_t _lastRecordTime;
+
+    // 块内差分的前一个值
+    uint16_t _lastAdc;
+    uint32_t _lastIr;
+    uint32_t _lastRed;
+
+    // 回放: 读取位置与下一个事件
+    TimeSeriesStore::Cursor _cursor;
+    uint8_t _nextType;
+    uint32_t _nextMs;
+};
+
+#endif // SENSOR_CAPTURE_H
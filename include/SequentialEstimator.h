@@ -0,0 +1,73 @@
+#ifndef SEQUENTIAL_ESTIMATOR_H
+#define SEQUENTIAL_ESTIMATOR_H
+
+#include <stdint.h>
+
+/**
+ * @class SequentialEstimator
+ * @brief 多次子测量的在线均值/方差估计与提前停止判据。
+ * * 使用Welford算法逐个累积子测量，计算均值的95%置信区间半宽 (小样本使用t分布)。
+ * * 当半宽低于容差、耗时超出预算或子测量数达到上限时停止。
+ */
+class SequentialEstimator {
+public:
+    enum class StopReason {
+        NONE,          // 尚未满足停止条件
+        CONVERGED,     // 置信区间已低于容差
+        TIME_BUDGET,   // 时间预算耗尽
+        MAX_SAMPLES    // 子测量次数达到上限
+    };
+
+    struct Config {
+        float tolerance;        // 目标置信区间半宽 (与测量值同单位)
+        uint32_t timeBudgetMs;  // 单次测量允许的最长耗时 (毫秒)
+        uint16_t minSamples;    // 判断收敛前至少需要的子测量数 (>=2)
+        uint16_t maxSamples;    // 子测量数上限
+    };
+
+    explicit SequentialEstimator(const Config& config);
+
+    /**
+     * @brief 清空累积的子测量。
+     */
+    void reset();
+
+    /**
+     * @brief 加入一次子测量结果。
+     */
+    void add(float value);
+
+    /**
+     * @brief 根据当前累积结果与已耗时间判断是否应停止。
+     * @param elapsedMs 自本次测量开始以来的耗时 (毫秒)。
+     * @return StopReason - 为 NONE 时应继续采集。
+     */
+    StopReason shouldStop(uint32_t elapsedMs) const;
+
+    uint16_t getCount() const;
+    float getMean() const;
+
+    /**
+     * @brief 子测量的样本方差 (n-1 归一化)。少于2个样本时返回0。
+     */
+    float getVariance() const;
+
+    /**
+     * @brief 均值的95%置信区间半宽。少于2个样本时返回无穷大。
+     */
+    float getHalfWidth() const;
+
+    /**
+     * @brief 双侧95% t分布分位数 (t_0.975)。自由度超过30时取正态分位数1.96。
+     * @param dof 自由度 (>=1)。
+     */
+    static float tQuantile975(int dof);
+
+private:
+    Config _config;
+    uint16_t _count;
+    double _mean;
+    double _m2; // 与均值之差的平方和
+};
+
+#endif // SEQUENTIAL_ESTIMATOR_H
@@ -0,0 +1,136 @@
+#ifndef SERIES_CODEC_H
+#define SERIES_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file SeriesCodec.h
+ * @brief 多通道时间序列的流式压缩 (Gorilla 风格的位级编码)，用于flash中的读数历史与蓝牙同步。
+ * * 读数写入定长的块，每块可以单独解码 (第一个读数相对0编码，不依赖之前的块)。
+ * * 时间戳: 增量的增量 (delta-of-delta)。读数间隔不变时每个时间戳只需1位。
+ * * 数值，每个通道二选一:
+ *   - QUANTIZED: 按 10^-decimals 量化为整数，编码与上一个值的差。有损，误差不超过半个量化单位，
+ *     适合分辨率已知的传感器数值 (血糖0.1 mg/dL、心率0.1 bpm 等)。NAN 原样保留。
+ *   - XOR_FLOAT: 与上一个值的 float 位模式异或，只写入有效位 (Facebook Gorilla)。无损。
+ * * 有符号整数 (时间戳的增量的增量、量化值的差) 按 zig-zag 后的大小选用4档之一:
+ *     '0' 表示0；'10' + 短；'110' + 中；'1110' + 长；'1111' + 32位
+ * * 块格式 (小端序):
+ *     0  version         u8   kBlockVersion
+ *     1  channels        u8   通道数 C (1..kMaxChannels)
+ *     2  count           u16  读数个数
+ *     4  firstTimestamp  u32  第一个读数的时间
+ *     8  descriptors     C × u8  高4位: 编码方式；低4位: decimals
+ *     8+C bits           按读数顺序: 时间戳 (第一个读数没有)，然后各通道的值，高位在前
+ * * 编码写入调用方提供的缓冲区，不分配堆内存。
+ */
+namespace SeriesCodec {
+
+constexpr uint8_t kBlockVersion = 1;
+constexpr size_t kHeaderSize = 8;
+constexpr int kMaxChannels = 8;
+constexpr uint8_t kMaxDecimals = 6;
+
+enum Encoding : uint8_t {
+    QUANTIZED = 0,
+    XOR_FLOAT = 1
+};
+
+struct Channel {
+    Encoding encoding;
+    uint8_t decimals;       // 仅 QUANTIZED: 量化单位为 10^-decimals
+};
+
+/**
+ * @class BlockEncoder
+ * @brief 向一个定长块追加读数，块满时 append() 返回false，块的内容不变。
+ */
+class BlockEncoder {
+public:
+    BlockEncoder();
+
+    /**
+     * @brief 开始一个新块。
+     * @return bool - 通道定义无效或 capacity 放不下块头时返回false。
+     */
+    bool begin(const Channel* channels, int channelCount, uint8_t* buffer, size_t capacity);
+
+    /**
+     * @brief 追加一个读数，values 为 channelCount 个值。
+     * @return bool - 块已满 (这个读数放不下) 时返回false。
+     */
+    bool append(uint32_t timestamp, const float* values);
+
+    /**
+     * @brief 块的当前长度 (字节)，可以直接写入flash或发送。
+     */
+    size_t size() const;
+
+    int count() const;
+    uint32_t firstTimestamp() const;
+    uint32_t lastTimestamp() const;
+
+private:
+    // 追加失败时恢复到追加之前的状态
+    struct State {
+        uint32_t bitPosition;
+        uint32_t timestamp;
+        uint32_t delta;
+        uint32_t previous[kMaxChannels];    // 量化值或 float 的位模式
+        uint8_t leading[kMaxChannels];      // XOR_FLOAT: 上一个有效位窗口
+        uint8_t trailing[kMaxChannels];
+    };
+
+    Channel _channels[kMaxChannels];
+    int _channelCount;
+    uint8_t* _buffer;
+    size_t _capacity;
+    int _count;
+    uint32_t _firstTimestamp;
+    State _state;
+};
+
+/**
+ * @class BlockDecoder
+ * @brief 按顺序解码一个块中的读数。
+ */
+class BlockDecoder {
+public:
+    BlockDecoder();
+
+    /**
+     * @brief 解析块头。
+     * @return bool - 版本、通道定义或长度无效时返回false。
+     */
+    bool begin(const uint8_t* data, size_t length);
+
+    /**
+     * @brief 解码下一个读数，values 至少要有 channelCount() 个元素。
+     * @return bool - 读完或数据损坏时返回false。
+     */
+    bool next(uint32_t* timestamp, float* values);
+
+    int channelCount() const;
+    int count() const;
+    uint32_t firstTimestamp() const;
+    Channel channel(int index) const;
+
+private:
+    Channel _channels[kMaxChannels];
+    int _channelCount;
+    const uint8_t* _data;
+    size_t _length;
+    int _count;
+    int _decoded;
+    uint32_t _bitPosition;
+    uint32_t _firstTimestamp;
+    uint32_t _timestamp;
+    uint32_t _delta;
+    uint32_t _previous[kMaxChannels];
+    uint8_t _leading[kMaxChannels];
+    uint8_t _trailing[kMaxChannels];
+};
+
+} // namespace SeriesCodec
+
+#endif // SERIES_CODEC_H
@@ -2,6 +2,7 @@
 #define SIGNAL_READER_H
 
 #include "config.h"
+#include "SensorCapture.h"
 
 /**
  * @class SignalReader
@@ -11,6 +12,11 @@
  */
 class SignalReader {
 public:
+    /**
+     * @brief 每次 analogRead() 后调用 (原始波形流等)，参数为单次采样的ADC原始值。
+     */
+    typedef void (*SampleCallback)(uint16_t raw);
+
     /**
      * @brief 获取SignalReader的全局唯一实例。
      * @return SignalReader对象的引用。
@@ -29,21 +35,36 @@ public:
 
     /**
      * @brief 执行一次完整的测量，返回多次采样平均后的ADC原始值。
+     * @param samples 参与平均的采样次数，自适应测量模式下使用较小的值做短时子测量。
      * @return uint16_t 平均后的ADC值 (0-4095 for 12-bit)。
      */
-    uint16_t getRawValue();
+    uint16_t getRawValue(int samples = ADC_SAMPLES_TO_AVERAGE);
 
     /**
      * @brief 执行一次完整的测量，并将其转换为电压值。
+     * @param samples 参与平均的采样次数。
      * @return float 测量到的电压 (V)。
      */
-    float getVoltage();
+    float getVoltage(int samples = ADC_SAMPLES_TO_AVERAGE);
+
+    /**
+     * @brief 设置单次采样的回调，nullptr 表示不回调。
+     */
+    void setSampleCallback(SampleCallback callback);
+
+    /**
+     * @brief 设置原始采样的录制/回放 (SensorCapture)，nullptr 表示直接读取ADC且不录制。
+     * * 回放时不读取ADC，采样取自录制的数据。
+     */
+    void setCapture(SensorCapture* capture);
 
 private:
     // 私有构造函数
     SignalReader(); 
 
     const uint8_t _pin; // ADC输入引脚
+    SampleCallback _sampleCallback;
+    SensorCapture* _capture;
 };
 
 #endif // SIGNAL_READER_H
\ No newline at end of file
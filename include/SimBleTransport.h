@@ -0,0 +1,73 @@
+#ifndef SIM_BLE_TRANSPORT_H
+#define SIM_BLE_TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include "BleTransport.h"
+
+// BleTransport for the host simulation (native-sim env, SIMULATOR=1). There is no radio: a simulated
+// phone connects, writes characteristics and receives every notification, which is counted and kept
+// (last payload per characteristic) so tests and the simulator summary can inspect what the firmware sent.
+// Single-threaded like the rest of the simulation; the listener callbacks run in the caller's thread.
+class SimBleTransport : public BleTransport {
+public:
+    struct Stats {
+        uint32_t notifications;
+        uint32_t bytes;
+        // Notifications longer than the negotiated ATT payload (MTU - 3); the stack would truncate them
+        uint32_t oversized;
+        uint32_t advertisingStarts;
+    };
+
+    static SimBleTransport& getInstance();
+
+    SimBleTransport(const SimBleTransport&) = delete;
+    SimBleTransport& operator=(const SimBleTransport&) = delete;
+
+    // BleTransport
+    bool begin(const char* deviceName, uint16_t preferredMtu, Listener* listener) override;
+    bool isConnected() const override;
+    void setValue(Characteristic characteristic, const uint8_t* data, size_t length) override;
+    void startAdvertising() override;
+    bool send(Characteristic characteristic, const uint8_t* data, size_t length) override;
+    const char* name() const override;
+
+    // Same as the real transports: writes to the model update characteristic need a link paired with this passkey
+    void setUpdatePasskey(uint32_t passkey);
+
+    // Simulated client: connect and exchange the MTU (the smaller of both sides wins), pair with a passkey
+    // (the link stays authenticated until disconnect), disconnect, write. write() returns false when the
+    // stack would reject it (not connected, or insufficient authentication).
+    bool connect(uint32_t connectionIntervalMs = 30, uint16_t clientMtu = 247);
+    bool pair(uint32_t passkey);
+    void disconnect();
+    bool write(Characteristic characteristic, const uint8_t* data, size_t length);
+
+    bool isStarted() const;
+    uint16_t getMtu() const;
+    uint32_t getNotificationCount(Characteristic characteristic) const;
+    // Last notified payload (empty if none), and the value set with setValue()
+    const std::vector<uint8_t>& getLastNotification(Characteristic characteristic) const;
+    const std::vector<uint8_t>& getValue(Characteristic characteristic) const;
+    const Stats& getStats() const;
+    void resetStats();
+
+private:
+    SimBleTransport();
+
+    Listener* listener;
+    bool started;
+    bool connected;
+    bool advertising;
+    bool authenticated;
+    uint32_t updatePasskey;
+    uint16_t preferredMtu;
+    uint16_t mtu;
+    uint32_t notificationCounts[kCharacteristicCount];
+    std::vector<uint8_t> lastNotifications[kCharacteristicCount];
+    std::vector<uint8_t> values[kCharacteristicCount];
+    Stats stats;
+};
+
+#endif // SIM_BLE_TRANSPORT_H
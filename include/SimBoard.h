@@ -0,0 +1,152 @@
+#ifndef SIM_BOARD_H
+#define SIM_BOARD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+#include "SimPhysiology.h"
+
+/**
+ * @class SimBoard
+ * @brief 主机模拟 (native-sim 环境) 中的开发板: 虚拟时钟、引脚与LEDC、串口、flash分区、NVS与合成生理模型。
+ * * 固件 (main.cpp 的 setup()/loop()、HAL 与处理链路) 原样编译；HAL 之下的 Arduino 核心、MAX30105 / DHT 库、
+ *   Preferences、esp_partition 与BLE传输层由 src/sim 中的模拟实现代替，全部读写这个对象。
+ * * 虚拟时钟: millis()/micros() 只在 delay()/delayMicroseconds() 与模拟的外设操作 (ADC转换、I2C读取、
+ *   DHT22 单总线读取、flash擦写) 中按设备上的典型耗时前进，不等待真实时间，一小时的运行在主机上只需几百毫秒。
+ *   time()/gettimeofday() (RTC) 同样来自虚拟时钟，从 setRtcEpoch() 开始计时 (默认0，与设备断电后相同)。
+ * * 确定性: 不读取真实时间，生理模型的噪声使用固定种子的伪随机序列；BLE任务与异步推理在该环境中关闭
+ *   (它们的线程按真实时间调度)，同样的输入每次得到逐位相同的串口输出。
+ * * 单例；只在一个线程中使用 (时钟是原子的，可以在其他线程中读取)。
+ */
+class SimBoard {
+public:
+    typedef void (*SerialSink)(const char* line);
+
+    struct Stats {
+        uint32_t analogReads;
+        uint32_t ppgSamples;            // 从MAX30102 FIFO读出的样本
+        uint32_t i2cTransactions;
+        uint32_t dhtReads;
+        uint32_t flashErases;           // 擦除的扇区数
+        uint32_t flashBytesWritten;
+        uint32_t serialBytes;
+        uint64_t ledOnUs;               // LED点亮的累计时间 (虚拟时间)
+    };
+
+    static SimBoard& getInstance();
+
+    SimBoard(const SimBoard&) = delete;
+    SimBoard& operator=(const SimBoard&) = delete;
+
+    // --- 虚拟时钟 ---
+    uint64_t micros() const;
+    uint32_t millis() const;
+    void advanceMicros(uint64_t us);
+    void setRtcEpoch(uint32_t seconds);
+    uint64_t rtcMicros() const;
+
+    SimPhysiology& getPhysiology();
+
+    // --- 引脚与LEDC (LedController / DemodulatorController) ---
+    void ledcSetup(uint8_t channel, uint32_t frequency, uint8_t resolution);
+    void ledcAttachPin(uint8_t pin, uint8_t channel);
+    void ledcDetachPin(uint8_t pin);
+    void ledcWrite(uint8_t channel, uint32_t duty);
+    void digitalWrite(uint8_t pin, uint8_t level);
+    // 引脚输出的是非零的PWM占空比或高电平
+    bool isPinActive(uint8_t pin) const;
+    bool isLedOn() const;
+    bool isDemodulatorOn() const;
+    uint32_t getPwmFrequency(uint8_t pin) const;
+
+    /**
+     * @brief 一次ADC转换 (PIN_ADC_IN 为光学通道，其他引脚读到0)。
+     */
+    uint16_t analogRead(uint8_t pin);
+
+    // --- 串口 ---
+    /**
+     * @brief 串口输出按行交给 sink (不含换行符)，nullptr 时写到标准输出。
+     */
+    void setSerialSink(SerialSink sink);
+    void serialWrite(const char* data, size_t length);
+    // 模拟从串口输入的字符 (例如剖析命令 'c' / 'j')
+    void serialInput(const char* text);
+    int serialAvailable() const;
+    int serialRead();
+
+    // --- flash分区 (与 custom_capture.csv 中的数据分区相同，初始为擦除后的 0xFF) ---
+    struct Partition {
+        uint8_t type;
+        uint8_t subtype;
+        const char* label;
+        std::vector<uint8_t> data;
+    };
+    Partition* findPartition(uint8_t type, int subtype, const char* label);
+    /**
+     * @brief 用文件替换分区的内容 (例如 esptool.py read_flash 读出的 capture 分区，配合回放使用)。
+     */
+    bool loadPartition(const char* label, const char* path);
+    // 把分区的内容写到文件 (例如模拟中录制的 capture 分区)
+    bool savePartition(const char* label, const char* path);
+    // 擦除/写入计入统计与虚拟时间，越界或未对齐时返回false
+    bool eraseFlash(Partition& partition, size_t offset, size_t length);
+    bool writeFlash(Partition& partition, size_t offset, const void* data, size_t length);
+    bool readFlash(const Partition& partition, size_t offset, void* out, size_t length);
+
+    // --- NVS (Preferences): 键为 "命名空间/键名" ---
+    std::map<std::string, std::vector<uint8_t>>& getNvs();
+
+    // --- 关机 (esp_register_shutdown_handler / ESP.restart) ---
+    bool addShutdownHandler(void (*handler)());
+    void runShutdownHandlers();
+
+    // I2C 传输计入统计与虚拟时间 (字节数含地址与寄存器)
+    void i2cTransfer(size_t bytes);
+    // 读出 MAX30102 FIFO 中的 count 个样本 (每个样本 Red + IR 共6字节)
+    void fifoTransfer(int count);
+    // DHT22 的一次单总线读取
+    void dhtTransfer();
+
+    Stats getStats() const;
+
+private:
+    SimBoard();
+
+    // LED 或光路的开关状态可能变化之后调用
+    void updateOptics();
+
+    static constexpr int kChannels = 16;
+    static constexpr int kPins = 49;
+    static constexpr int kMaxShutdownHandlers = 5;
+
+    std::atomic<uint64_t> _micros;
+    uint32_t _rtcEpoch;
+    SimPhysiology _physiology;
+
+    uint32_t _channelFrequency[kChannels];
+    uint32_t _channelDuty[kChannels];
+    int8_t _pinChannel[kPins];
+    uint8_t _pinLevel[kPins];
+    // LED 点亮、光路 (LED 与解调参考信号同时开启) 开始的时间
+    bool _ledOn;
+    bool _opticsOn;
+    uint64_t _ledOnSinceUs;
+    uint64_t _opticsOnSinceUs;
+
+    SerialSink _serialSink;
+    std::string _serialLine;
+    std::string _serialInput;
+
+    std::vector<Partition> _partitions;
+    std::map<std::string, std::vector<uint8_t>> _nvs;
+    void (*_shutdownHandlers[kMaxShutdownHandlers])();
+    int _shutdownHandlerCount;
+
+    Stats _stats;
+};
+
+#endif // SIM_BOARD_H
@@ -0,0 +1,119 @@
+#ifndef SIM_PHYSIOLOGY_H
+#define SIM_PHYSIOLOGY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @class SimPhysiology
+ * @brief 主机模拟中的合成生理模型: 血糖曲线 (基线 + 餐后响应)、脉搏波 (PPG)、光学测量通道与环境温湿度。
+ * * 给模拟的传感器库使用 (见 SimBoard.h): MAX30105 按采样时刻取 PPG 样本，analogRead() 取光学通道的电压，
+ *   DHT 取温湿度。每个通道使用独立的伪随机序列，给定 seed 与调用顺序时结果完全确定。
+ * * 光学通道按 GlucoseCalculator::calculate() 的占位校准反推 (血糖 = 电压×100 + 温度 - IR/20000)，
+ *   固件算出的血糖在噪声范围内等于 getGlucose()，测试可以直接比较两者。
+ * * 血氧按 SpO2Algorithm 的经验公式 (SpO2 = 104 - 17R) 反推红光与红外的灌注比 R。
+ * * 时间一律为模拟的 millis()。
+ */
+class SimPhysiology {
+public:
+    static constexpr int kMaxMeals = 8;
+
+    struct Profile {
+        float baselineGlucose;      // mg/dL
+        float heartRate;            // bpm
+        float heartRateVariation;   // 呼吸性窦性心律不齐的幅度 (bpm)
+        float spo2;                 // %
+        float perfusionIndex;       // 红外的脉动分量 / 直流分量
+        uint32_t irDc;              // 手指在传感器上时的红外直流分量 (ADC计数)
+        uint32_t redDc;
+        float ppgNoise;             // PPG 的噪声标准差 (ADC计数)
+        float ambientTemperature;   // °C
+        float humidity;             // %
+        float opticalNoiseMgdl;     // 每个ADC采样的白噪声 (折算为 mg/dL)
+        float opticalDriftMgdl;     // 光路的慢变噪声 (折算为 mg/dL，时间常数约200 ms)
+        float dhtFailureRate;       // DHT22 读取失败的概率
+        uint32_t seed;
+    };
+
+    struct Meal {
+        uint32_t timeMs;
+        float peakMgdl;             // 餐后血糖升高的峰值
+    };
+
+    static Profile defaultProfile();
+
+    explicit SimPhysiology(const Profile& profile = defaultProfile());
+
+    /**
+     * @brief 恢复初始状态 (清空餐食、手指放在传感器上、重置随机序列)。
+     */
+    void reset(const Profile& profile);
+    const Profile& getProfile() const;
+
+    /**
+     * @brief 在 timeMs 进餐: 血糖在约40分钟后升高 peakMgdl，之后缓慢回落。
+     */
+    bool addMeal(uint32_t timeMs, float peakMgdl);
+
+    void setFingerPresent(bool present);
+    bool isFingerPresent() const;
+
+    // --- 真值 (测试与固件的输出比较) ---
+    float getGlucose(uint32_t timeMs) const;
+    float getHeartRate(uint32_t timeMs) const;
+    float getSpO2() const;
+    // DHT22 报告的值 (0.1 的分辨率)
+    float getTemperature(uint32_t timeMs) const;
+    float getHumidity(uint32_t timeMs) const;
+
+    // --- 传感器通道 ---
+    /**
+     * @brief MAX30102 在 timeMs 的一个样本 (timeMs 不减)。
+     */
+    void samplePpg(uint32_t timeMs, uint32_t* ir, uint32_t* red);
+
+    /**
+     * @brief 解调后的光学信号 (伏特)。
+     * @param opticsOnMs LED 与解调参考信号同时开启的时长，光路按约2 ms 的时间常数稳定；
+     *        未开启时为负数，输出暗电平。
+     */
+    float sampleOptical(uint32_t timeMs, int32_t opticsOnMs);
+
+    /**
+     * @brief 一次 DHT22 读取，失败时返回false。
+     */
+    bool readDht(uint32_t timeMs, float* temperature, float* humidity);
+
+private:
+    // 每个通道独立的伪随机序列 (线性同余 + Box-Muller)
+    struct Noise {
+        uint32_t state;
+        bool hasSpare;
+        float spare;
+        void seed(uint32_t s);
+        float uniform();
+        float gaussian();
+    };
+
+    float pulseShape(float phase) const;
+
+    Profile _profile;
+    Meal _meals[kMaxMeals];
+    int _mealCount;
+    bool _fingerPresent;
+
+    // PPG: 心跳相位按心率积分
+    float _phase;
+    uint32_t _lastPpgMs;
+    bool _hasPpg;
+
+    // 光学通道的慢变噪声 (一阶自回归，10 ms 一步)
+    float _drift;
+    uint32_t _driftMs;
+
+    Noise _ppgNoise;
+    Noise _opticalNoise;
+    Noise _dhtNoise;
+};
+
+#endif // SIM_PHYSIOLOGY_H
@@ -0,0 +1,84 @@
+#ifndef STATE_CHECKPOINT_H
+#define STATE_CHECKPOINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "KeyValueStore.h"
+#include "HistoryResampler.h"
+#include "GlucoseFilter.h"
+
+/**
+ * @class StateCheckpoint
+ * @brief 把预测历史与滤波器状态定期保存到持久存储，重启后恢复，使预测立即可用。
+ * * 批量写入: 累计 minReadings 个新读数，或最早的未保存读数已等待 maxIntervalMs 时才写入，
+ *   没有新读数时跳过，以减少flash擦写。
+ * * millis() 在重启后从0开始，因此读数时间保存为相对保存时刻的"年龄"，另记录保存时的RTC时间
+ *   (软件复位后继续计时)；恢复时按经过的RTC时间换算回新的 millis() 时间轴。
+ * * 快照格式 (小端序): magic u32 'GCKP', version u16, count u16, savedAtMs u64,
+ *   filter {initialized u32, glucose, velocity, p00, p01, p11 f32, lastAgeMs u32, updateCount u32},
+ *   samples {ageMs u32, value f32, quality f32} × count, crc32 u32。
+ */
+class StateCheckpoint {
+public:
+    struct Policy {
+        uint16_t minReadings;       // 累计多少个新读数后写入
+        uint32_t maxIntervalMs;     // 未保存的读数最长等待多久后写入
+        uint32_t maxAgeMs;          // 恢复时快照允许的最长年龄
+    };
+
+    enum class RestoreResult {
+        OK,
+        NONE,           // 没有保存过
+        CORRUPT,        // 格式或CRC错误
+        STALE           // 过期，或RTC早于保存时刻 (断电后时钟复位)
+    };
+
+    static constexpr size_t kMaxSnapshotSize = 48 + 12 * HistoryResampler::kCapacity + 4;
+
+    StateCheckpoint(KeyValueStore& store, const char* key, const Policy& policy);
+
+    /**
+     * @brief 记录一个新读数 (尚未保存)。
+     * @param rtcNowMs 当前RTC时间 (毫秒)。
+     */
+    void noteReading(uint64_t rtcNowMs);
+
+    /**
+     * @brief 按批量策略判断现在是否应写入。
+     * @param rtcNowMs 当前RTC时间 (毫秒)。
+     */
+    bool shouldSave(uint64_t rtcNowMs) const;
+
+    /**
+     * @brief 写入快照 (无论批量策略如何，例如计划重启前)。自上次写入后没有新读数时跳过实际写入。
+     * @param millisNow 当前 millis()，历史与滤波器的时间戳相对于它保存。
+     * @return bool - 快照已是最新 (写入成功或无需写入) 时返回true。
+     */
+    bool save(const HistoryResampler& history, const GlucoseFilter::State& filter, uint32_t millisNow, uint64_t rtcNowMs);
+
+    /**
+     * @brief 读取快照并把时间戳换算到当前的 millis() 时间轴。
+     * @param history 恢复的读数追加到其中 (应为空)。
+     * @param filter 成功时写入滤波器状态。
+     */
+    RestoreResult restore(HistoryResampler* history, GlucoseFilter::State* filter, uint32_t millisNow, uint64_t rtcNowMs);
+
+    /**
+     * @brief 实际写入存储的次数 (用于估计flash磨损)。
+     */
+    uint32_t getWriteCount() const;
+
+private:
+    size_t serialize(const HistoryResampler& history, const GlucoseFilter::State& filter,
+                     uint32_t millisNow, uint64_t rtcNowMs, uint8_t* out) const;
+
+    KeyValueStore& _store;
+    const char* _key;
+    Policy _policy;
+    uint16_t _pendingReadings;
+    uint64_t _firstPendingRtcMs;    // 最早的未保存读数的时刻
+    bool _saved;
+    uint32_t _writeCount;
+};
+
+#endif // STATE_CHECKPOINT_H
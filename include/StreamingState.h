@@ -0,0 +1,105 @@
+#ifndef STREAMING_STATE_H
+#define STREAMING_STATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @class StreamingState
+ * @brief 有状态流式模型 (RNN / 流式卷积) 在两次推理之间保存的隐藏状态，以及按时间网格运行的步进。
+ * * 流式模型的约定: 输入 [采样值, 状态]，输出 [预测, 新状态]。每个新读数只需运行一步，
+ *   运行后用 commit() 把新状态保存下来，作为下一步的输入。
+ * * feed() 按模型训练时的网格运行: 网格以状态开始时的第一个读数为起点，两个读数之间经过的网格点按线性插值
+ *   各运行一步 (与 HistoryResampler 重采样整窗口的方式相同)；读数间隔超过 maxGapMs 时状态清零重新积累。
+ * * 状态可序列化为快照保存到NVS。快照记下最后一个读数的时间，恢复时换算到新的 millis() 时间轴，
+ *   该读数距今已超过 maxGapMs 的快照不再使用 (与运行中遇到过长的间隔时一样重新积累)。
+ * * 快照格式 (小端序): magic u32 'GSTA', modelId u32, savedAtMs u64 (RTC), steps u32, size u32,
+ *   lastAgeMs u32 (最后一个读数相对保存时刻), lastValue f32, gridPhaseMs u32 (下一个网格点相对最后一个读数),
+ *   state f32 × size, crc32 u32 (前面所有字节)。
+ */
+class StreamingState {
+public:
+    static constexpr int kMaxStateSize = 256;
+    static constexpr size_t kSnapshotHeaderSize = 36;
+
+    /**
+     * @brief 用一个 (插值后的) 采样值运行模型一步，成功时调用 commit() 保存新状态。
+     */
+    typedef void (*StepFn)(void* context, float value);
+
+    StreamingState();
+
+    /**
+     * @brief 为指定模型初始化 (状态清零)。
+     * @param size 状态向量长度 (元素个数)，超过 kMaxStateSize 时返回false。
+     * @param modelId 模型标识 (例如模型数据的CRC32)，用于拒绝其他模型的快照。
+     * @param gridStepMs 模型训练时的采样间隔。
+     * @param maxGapMs 允许插值跨越的最长读数间隔。
+     */
+    bool begin(int size, uint32_t modelId, uint32_t gridStepMs, uint32_t maxGapMs);
+
+    /**
+     * @brief 状态清零，步数归零，下一个读数重新开始网格 (例如长时间中断测量后)。
+     */
+    void reset();
+
+    /**
+     * @brief 输入一个新读数: 运行上一个读数之后到该读数为止经过的每个网格点。
+     * * 第一个读数 (或间隔过长后的读数) 直接运行一步并作为网格起点。时间戳不晚于上一个读数的读数被忽略。
+     */
+    void feed(uint32_t timestampMs, float value, StepFn step, void* context);
+
+    /**
+     * @brief 当前状态，作为下一步推理的状态输入。
+     */
+    const float* data() const;
+    int size() const;
+
+    /**
+     * @brief 保存一步推理输出的新状态。
+     */
+    void commit(const float* newState);
+
+    /**
+     * @brief 自 reset() 以来累计的步数 (从快照恢复时包含快照中的步数)。
+     */
+    uint32_t getSteps() const;
+
+    /**
+     * @brief 状态是否已积累了足够的历史 (步数达到 warmupSteps)。
+     */
+    bool isWarm(uint32_t warmupSteps) const;
+
+    /**
+     * @brief 快照所需的字节数。
+     */
+    size_t snapshotSize() const;
+
+    /**
+     * @brief 写出快照。
+     * @param millisNow 当前 millis()，最后一个读数的时间相对它保存。
+     * @param rtcNowMs 当前RTC时间 (毫秒，软件复位后继续计时)。
+     * @return size_t - 写入的字节数，容量不足或还没有读数时返回0。
+     */
+    size_t saveSnapshot(uint8_t* out, size_t capacity, uint32_t millisNow, uint64_t rtcNowMs) const;
+
+    /**
+     * @brief 从快照恢复。快照损坏、属于其他模型、状态长度不符，或最后一个读数距今超过 maxGapMs
+     *        (包括RTC早于保存时刻，例如断电后时钟复位) 时返回false，状态保持不变。
+     */
+    bool restoreSnapshot(const uint8_t* snapshot, size_t length, uint32_t millisNow, uint64_t rtcNowMs);
+
+private:
+    int _size;
+    uint32_t _modelId;
+    uint32_t _gridStepMs;
+    uint32_t _maxGapMs;
+    uint32_t _steps;
+    bool _hasLast;
+    uint32_t _lastMs;           // 最后一个读数的时刻
+    float _lastValue;
+    uint32_t _nextGridMs;       // 下一个需要运行的网格时刻
+    float _state[kMaxStateSize];
+};
+
+#endif // STREAMING_STATE_H
@@ -0,0 +1,29 @@
+#ifndef TFLM_OP_PROFILER_H
+#define TFLM_OP_PROFILER_H
+
+#include <Arduino.h>
+#include "tensorflow/lite/micro/micro_profiler.h"
+#include "OpProfile.h"
+
+/**
+ * @class TflmOpProfiler
+ * @brief 把 TFLM 解释器的算子事件 (BeginEvent/EndEvent) 记录到 OpProfile 中，时间单位为 micros()。
+ * * 构造解释器时作为 profiler 参数传入；每次 Invoke() 前后由调用方调用 OpProfile 的 beginRun()/endRun()。
+ */
+class TflmOpProfiler : public tflite::MicroProfiler {
+public:
+    explicit TflmOpProfiler(OpProfile& profile) : _profile(profile) {}
+
+    uint32_t BeginEvent(const char* tag) override {
+        return _profile.beginOp(tag, (uint32_t)micros());
+    }
+
+    void EndEvent(uint32_t event_handle) override {
+        _profile.endOp(event_handle, (uint32_t)micros());
+    }
+
+private:
+    OpProfile& _profile;
+};
+
+#endif // TFLM_OP_PROFILER_H
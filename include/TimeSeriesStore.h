@@ -0,0 +1,141 @@
+#ifndef TIME_SERIES_STORE_H
+#define TIME_SERIES_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "FlashPartition.h"
+
+/**
+ * @class TimeSeriesStore
+ * @brief 直接建立在原始flash分区上的追加式时间序列存储 (日志结构，不经过文件系统)。
+ * * 分区按扇区划分为段 (segment)，段按物理顺序循环使用: 写满一段后擦除下一个扇区继续写，
+ *   分区写满时覆盖最旧的段。每个扇区每一轮只擦除一次，擦写次数自然均匀 (磨损均衡)。
+ * * 记录是不透明的数据块 (例如一批压缩后的读数)，带类型与时间范围 [firstTimestamp, lastTimestamp]，
+ *   时间戳必须不减。
+ * * 掉电安全: 段头与每条记录都有CRC。启动时 begin() 扫描段头恢复顺序，CRC 错误的记录 (写入中掉电)
+ *   视为该段的结尾，之后的写入从新的一段开始，已写入的记录不受影响。
+ * * RAM 中只保存每段的起始时间与序号 (kMaxSegments 项)，seek() 按时间二分查找段，再在段内顺序查找。
+ *
+ * 格式 (小端序):
+ *   段头 (每个扇区开头): magic u32 'TSS1', sequence u32, eraseCount u32, crc32 u32 (前12字节)
+ *   记录 (4字节对齐): length u16, type u8, reserved u8 (0xFF), firstTimestamp u32, lastTimestamp u32,
+ *                     payload × length, crc32 u32 (记录头与payload)
+ *   length 为 0xFFFF 表示该段后面未写入。
+ */
+class TimeSeriesStore {
+public:
+    static constexpr uint32_t kMagic = 0x31535354;  // 'TSS1'
+    static constexpr size_t kSegmentHeaderSize = 16;
+    static constexpr size_t kRecordHeaderSize = 12;
+    static constexpr size_t kRecordOverhead = kRecordHeaderSize + 4;
+    static constexpr int kMaxSegments = 128;
+    static constexpr size_t kMaxPayloadSize = 1024;
+
+    struct RecordInfo {
+        uint8_t type;
+        uint32_t firstTimestamp;
+        uint32_t lastTimestamp;
+        uint16_t length;
+    };
+
+    /**
+     * @brief 读取位置: 段的序号与段内偏移。段被覆盖后从最旧的段继续。
+     */
+    struct Cursor {
+        uint32_t sequence;
+        uint32_t offset;
+    };
+
+    struct Stats {
+        int segments;               // 已使用的段数
+        int capacitySegments;       // 分区的总段数
+        uint32_t oldestTimestamp;   // 最旧记录的起始时间 (空时为0)
+        uint32_t newestTimestamp;   // 最新记录的结束时间 (空时为0)
+        uint32_t maxEraseCount;     // 各段头中记录的最大擦除次数
+        uint32_t recoveredTornRecords;  // 启动时发现的损坏记录数 (写入中掉电)
+    };
+
+    explicit TimeSeriesStore(FlashPartition& partition);
+
+    /**
+     * @brief 扫描分区，恢复段的顺序与RAM索引 (每个段头一次读取，每段只校验第一条记录，最新的段完整扫描)。
+     * @return bool - 分区不足两个扇区或读取失败时返回false。
+     */
+    bool begin();
+
+    /**
+     * @brief 追加一条记录。
+     * @return bool - payload 过长、时间戳早于已有的最新记录或flash写入失败时返回false。
+     */
+    bool append(uint8_t type, uint32_t firstTimestamp, uint32_t lastTimestamp, const uint8_t* payload, size_t length);
+
+    /**
+     * @brief 定位到第一条 lastTimestamp >= timestamp 的记录 (O(log 段数) + 段内顺序查找)。
+     */
+    Cursor seek(uint32_t timestamp);
+
+    /**
+     * @brief 最旧的记录。
+     */
+    Cursor first() const;
+
+    /**
+     * @brief 读取游标处的记录并前进 (顺序扫描)。长度超过 capacity 的记录被跳过。
+     * @return bool - 没有更多记录时返回false。
+     */
+    bool next(Cursor* cursor, RecordInfo* info, uint8_t* payload, size_t capacity);
+
+    /**
+     * @brief 擦除全部数据。
+     */
+    bool clear();
+
+    Stats getStats() const;
+
+private:
+    struct Segment {
+        uint32_t sequence;
+        uint32_t firstTimestamp;
+        uint32_t eraseCount;
+        uint16_t sector;
+        bool hasRecords;
+    };
+
+    enum class ReadResult { OK, END, CORRUPT };
+
+    /**
+     * @brief 读取并校验 offset 处的记录 (payload 为 nullptr 时只校验)。
+     */
+    ReadResult readRecord(uint32_t sectorOffset, uint32_t offset, RecordInfo* info, uint8_t* payload, size_t capacity);
+
+    /**
+     * @brief 扫描一段，得到写入位置与最后一条记录的结束时间。
+     * @return bool - 段尾是干净的 (没有损坏的记录) 时返回true。
+     */
+    bool scanSegment(const Segment& segment, uint32_t* end, uint32_t* lastTimestamp, int* records);
+
+    /**
+     * @brief 把游标移到下一条有效记录 (跳过段尾)，读取但不前进。
+     */
+    bool locate(Cursor* cursor, RecordInfo* info, uint8_t* payload, size_t capacity);
+
+    bool openSegment();
+    int findSegment(uint32_t sequence) const;
+    void removeSegmentAt(int index);
+    static uint32_t recordSize(size_t payloadLength);
+
+    FlashPartition& _partition;
+    int _sectorCount;
+    Segment _segments[kMaxSegments];    // 按序号 (时间) 排序
+    int _segmentCount;
+
+    // 写入位置: 最新一段中下一条记录的偏移；_sealed 表示最新一段不能再写入 (段尾有损坏的记录)
+    uint32_t _writeOffset;
+    bool _sealed;
+    uint32_t _newestTimestamp;
+    uint32_t _nextSequence;
+    uint32_t _maxEraseCount;
+    uint32_t _tornRecords;
+};
+
+#endif // TIME_SERIES_STORE_H
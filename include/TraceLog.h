@@ -0,0 +1,185 @@
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// 是否记录热点路径的追踪事件 (TRACE_SCOPE 等宏)。由 build_flags 定义 (esp32-s3-trace / native-sim-trace 环境)，
+// 为0时宏展开为空语句，参数不求值，不产生任何代码
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+
+/**
+ * @class TraceLog
+ * @brief 热点路径的事件日志: 每个核心一个定长的无锁环形缓冲区，写满后覆盖最早的事件。
+ * * 每个槽位16字节 (序号、微秒时间戳、参数，以及事件ID、阶段、核心与任务合成的头部，各4字节)，
+ *   record() 不阻塞也不分配内存，可以在任意任务中调用；同一核心上的任务互相抢占时也不会写坏事件
+ *   (每个槽位带序号，写入时先作废)。
+ * * 事件记下所在的任务: 任务第一次记录时按任务句柄登记一个编号与名称 (最多 kMaxTasks 个，之后的任务记为0)。
+ * * writeChromeJson() 按 Chrome trace 格式 (Perfetto / chrome://tracing 可直接打开) 逐行输出，
+ *   每个任务一条时间线 (tid 为任务编号)，同一核心上交替运行的任务的作用域不会互相嵌套；
+ *   输出时仍在写入的槽位被跳过；时间戳为相对最早一个事件的微秒数。
+ * * 时钟由 begin() 给出 (固件中为 micros()，主机模拟中为虚拟时钟)，之前的事件被丢弃。
+ * * 固件中通过 getInstance() 使用同一个日志；测试中可以单独构造。
+ */
+class TraceLog {
+public:
+    // 每个核心的事件个数 (2的幂)
+    static constexpr uint32_t kRingSize = 512;
+    static constexpr int kCores = 2;
+    // 可登记的任务数，编号 1..kMaxTasks
+    static constexpr int kMaxTasks = 15;
+    static constexpr size_t kTaskNameSize = 16;
+
+    // 事件ID，名称见 TraceLog.cpp
+    enum Id : uint16_t {
+        MEASUREMENT,            // GlucoseCalculator::performMeasurement
+        ADAPTIVE_MEASUREMENT,   // GlucoseCalculator::performAdaptiveMeasurement，参数为时间预算 (ms)
+        SIGNAL_READ,            // SignalReader::getRawValue，参数为ADC采样次数
+        PPG_UPDATE,             // Max30102Controller::update
+        SPO2_CALCULATE,         // SpO2Algorithm::calculate
+        DHT_READ,               // Dht22Controller::readData
+        PREDICT,                // GlucosePredictor::predictCurve
+        INFERENCE,              // GlucosePredictor::runInference
+        BLE_NOTIFY,             // BleTransport::send，参数为 特征值序号<<16 | 字节数
+        ID_COUNT
+    };
+
+    enum Phase : uint8_t {
+        BEGIN,
+        END,
+        INSTANT
+    };
+
+    struct Event {
+        uint32_t timestampUs;
+        uint32_t arg;
+        uint8_t id;
+        uint8_t phase;
+        uint8_t core;
+        uint8_t task;       // 0 表示未登记的任务
+    };
+
+    typedef unsigned long (*Clock)();
+    typedef void (*LineWriter)(const char* line);
+
+    /**
+     * @brief 记录一个作用域的开始与结束 (TRACE_SCOPE)。
+     */
+    class Scope {
+    public:
+        Scope(Id id, uint32_t arg) : _id(id) {
+            TraceLog::getInstance().record(id, BEGIN, arg);
+        }
+        ~Scope() {
+            TraceLog::getInstance().record(_id, END, 0);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        Id _id;
+    };
+
+    static TraceLog& getInstance();
+
+    TraceLog();
+
+    TraceLog(const TraceLog&) = delete;
+    TraceLog& operator=(const TraceLog&) = delete;
+
+    /**
+     * @brief 设置时钟并开始记录 (nullptr 停止记录)。应在启动其他任务之前调用。
+     */
+    void begin(Clock clock);
+
+    /**
+     * @brief 在当前核心的缓冲区中记录当前任务的一个事件。
+     */
+    void record(Id id, Phase phase, uint32_t arg);
+    void record(Id id, Phase phase, uint32_t arg, int core, int task = 0);
+
+    /**
+     * @brief 按时间顺序取出一个核心的缓冲区中仍然保留的事件。
+     * @return int - 取出的个数 (最多 capacity 个，最新的优先保留)。
+     */
+    int snapshot(int core, Event* out, int capacity) const;
+
+    /**
+     * @brief 一个核心记录过的事件总数 (包括已被覆盖的)。
+     */
+    uint32_t getRecordedCount(int core) const;
+
+    /**
+     * @brief 清空所有事件与登记的任务 (不能与 record() 同时调用)。
+     */
+    void clear();
+
+    /**
+     * @brief 按 Chrome trace JSON 输出全部保留的事件: 每个事件一行，任务编号对应 tid，核心记在参数中。
+     */
+    void writeChromeJson(LineWriter write) const;
+
+    static const char* getName(Id id);
+
+    /**
+     * @brief 当前任务的编号，第一次调用时登记 (登记已满时返回0)。
+     */
+    int currentTask();
+
+    /**
+     * @brief 登记的任务名称 (设备上为 FreeRTOS 任务名，主机上为 "thread N")；未登记时返回nullptr。
+     */
+    const char* getTaskName(int task) const;
+
+    /**
+     * @brief 当前代码运行的核心 (主机上为 Arduino loop() 所在的核心1，与设备上的主循环一致)。
+     */
+    static int currentCore();
+
+private:
+    // 序号为 位置+1 时事件完整，写入过程中为0
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        std::atomic<uint32_t> timestampUs;
+        std::atomic<uint32_t> arg;
+        std::atomic<uint32_t> header;      // id | phase << 8 | core << 16 | task << 24
+    };
+
+    struct Ring {
+        std::atomic<uint32_t> head;
+        Slot slots[kRingSize];
+    };
+
+    // 任务句柄为0时空闲；名称写完后 named 才置位
+    struct TaskEntry {
+        std::atomic<uintptr_t> handle;
+        std::atomic<bool> named;
+        char name[kTaskNameSize];
+    };
+
+    static_assert((kRingSize & (kRingSize - 1)) == 0, "kRingSize must be a power of two");
+    static_assert(sizeof(Slot) == 16, "Slot must stay 16 bytes");
+    static_assert(ID_COUNT <= 256 && kMaxTasks < 256, "id and task must fit in 8 bits");
+
+    std::atomic<Clock> _clock;
+    Ring _rings[kCores];
+    TaskEntry _tasks[kMaxTasks];
+};
+
+#if TRACE_ENABLED
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+// 记录所在作用域的开始与结束
+#define TRACE_SCOPE(id) TraceLog::Scope TRACE_CONCAT(traceScope_, __LINE__)(TraceLog::id, 0)
+#define TRACE_SCOPE_ARG(id, arg) TraceLog::Scope TRACE_CONCAT(traceScope_, __LINE__)(TraceLog::id, (uint32_t)(arg))
+// 记录一个瞬时事件
+#define TRACE_INSTANT(id, arg) TraceLog::getInstance().record(TraceLog::id, TraceLog::INSTANT, (uint32_t)(arg))
+#else
+#define TRACE_SCOPE(id) do {} while (0)
+#define TRACE_SCOPE_ARG(id, arg) do {} while (0)
+#define TRACE_INSTANT(id, arg) do {} while (0)
+#endif
+
+#endif // TRACE_LOG_H
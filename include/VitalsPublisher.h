@@ -0,0 +1,150 @@
+#ifndef VITALS_PUBLISHER_H
+#define VITALS_PUBLISHER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "GattSink.h"
+
+/**
+ * @class VitalsPublisher
+ * @brief 把血糖、心率、血氧与预测曲线合并为一个BLE通知 (每个发送间隔最多一次)，减少射频唤醒与手机端处理。
+ * * 合并包格式 (小端序):
+ *     0  version      u8   kPacketVersion
+ *     1  fields       u8   包含的字段: bit0 血糖，bit1 心率，bit2 血氧，bit3 预测曲线
+ *     2  sequence     u16  每发送一个包加1
+ *     4  timestamp    u32  RTC秒
+ *     8  values       SFLOAT × 包含的标量字段数，按 bit 顺序
+ *        curve        预测曲线包 (格式见 PredictionCurve.h)，必须位于最后
+ * * 死区: 与上次发出的值相比变化不超过该字段的死区时不发送该字段；所有字段都没有变化时不发送通知。
+ *   超过 maxSilenceMs 没有发送时，带上所有已知字段发送一次 (客户端据此确认连接仍然有效)。
+ * * 限速: 两次发送的间隔不小于 max(minIntervalMs, 连接间隔)。
+ * * 包长不超过 ATT_MTU - 3；放不下时先去掉曲线的预测区间，再截短曲线。
+ * * setMtu()/setConnectionIntervalMs() 可在BLE任务中调用，其余方法在主循环中调用。
+ */
+class VitalsPublisher {
+public:
+    static constexpr uint8_t kPacketVersion = 1;
+    static constexpr size_t kHeaderSize = 8;
+    static constexpr int kMaxCurvePoints = 16;
+    static constexpr uint16_t kDefaultMtu = 23;
+
+    enum Field : uint8_t {
+        FIELD_GLUCOSE = 0x01,
+        FIELD_HEART_RATE = 0x02,
+        FIELD_SPO2 = 0x04,
+        FIELD_CURVE = 0x08
+    };
+
+    struct Config {
+        float glucoseDeadband;      // mg/dL
+        float heartRateDeadband;    // bpm
+        float spO2Deadband;         // %
+        float curveDeadband;        // 曲线任一点的变化 (mg/dL)
+        uint32_t minIntervalMs;     // 两次发送的最小间隔
+        uint32_t maxSilenceMs;      // 超过该时间没有发送时全量发送一次
+        uint8_t curveStepMinutes;   // 曲线相邻两点的时间间隔
+    };
+
+    explicit VitalsPublisher(const Config& config);
+
+    void setGlucose(float mgdl);
+    void setHeartRate(float bpm);
+    void setSpO2(float percent);
+
+    /**
+     * @brief 设置最新的预测曲线 (超过 kMaxCurvePoints 的点被截断)。
+     * @param lower, upper 预测区间，均为nullptr时不附带区间。
+     */
+    void setCurve(const float* values, int count, const float* lower = nullptr, const float* upper = nullptr);
+
+    /**
+     * @brief 协商后的 ATT MTU (连接或 MTU 交换时调用)。
+     */
+    void setMtu(uint16_t mtu);
+
+    /**
+     * @brief 当前连接的连接间隔 (毫秒)，发送间隔不小于该值。
+     */
+    void setConnectionIntervalMs(uint32_t ms);
+
+    /**
+     * @brief 新的连接: 下一次 poll() 全量发送。MTU 由调用方在连接时另行重置 (setMtu(kDefaultMtu))。
+     */
+    void onConnect();
+
+    /**
+     * @brief 需要时发送一个合并通知。
+     * @param nowMs 当前时间 (millis)。
+     * @param timestamp 写入包头的时间戳 (RTC秒)。
+     * @return bool - 发送了通知时返回true。
+     */
+    bool poll(uint32_t nowMs, uint32_t timestamp, GattSink& sink);
+
+    /**
+     * @brief 按当前的值与死区组包 (不发送、不更新状态)。
+     * @return size_t - 包长，没有需要发送的字段时返回0。
+     */
+    size_t buildPacket(uint32_t nowMs, uint32_t timestamp, uint8_t* out, size_t capacity) const;
+
+    uint32_t getSentCount() const;
+    uint32_t getSuppressedCount() const;
+
+    struct Decoded {
+        uint8_t fields;
+        uint16_t sequence;
+        uint32_t timestamp;
+        float glucose;
+        float heartRate;
+        float spO2;
+        int curveCount;
+        bool curveHasInterval;
+        float curve[kMaxCurvePoints];
+        float lower[kMaxCurvePoints];
+        float upper[kMaxCurvePoints];
+    };
+
+    /**
+     * @brief 解码合并包 (供测试与主机端工具使用)。
+     * @return bool - 包格式错误时返回false。
+     */
+    static bool decode(const uint8_t* packet, size_t length, Decoded* out);
+
+private:
+    struct Scalar {
+        float value;
+        float sentValue;
+        bool known;
+        bool sent;
+    };
+
+    uint8_t changedFields(uint32_t nowMs) const;
+    bool curveChanged() const;
+    static bool scalarChanged(const Scalar& s, float deadband);
+
+    Config _config;
+    std::atomic<uint16_t> _mtu;
+    std::atomic<uint32_t> _connectionIntervalMs;
+
+    Scalar _glucose;
+    Scalar _heartRate;
+    Scalar _spO2;
+
+    int _curveCount;
+    bool _curveHasInterval;
+    float _curve[kMaxCurvePoints];
+    float _lower[kMaxCurvePoints];
+    float _upper[kMaxCurvePoints];
+    // 上次发出的曲线
+    int _sentCurveCount;
+    bool _sentCurveHasInterval;
+    float _sentCurve[kMaxCurvePoints];
+
+    bool _hasSent;
+    uint32_t _lastSendMs;
+    uint16_t _sequence;
+    uint32_t _sentCount;
+    uint32_t _suppressedCount;
+};
+
+#endif // VITALS_PUBLISHER_H
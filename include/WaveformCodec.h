@@ -0,0 +1,111 @@
+#ifndef WAVEFORM_CODEC_H
+#define WAVEFORM_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file WaveformCodec.h
+ * @brief 原始波形帧的压缩编码: 逐通道差分 + zig-zag + varint。
+ * * 帧格式 (小端序):
+ *     0  version      u8   kFrameVersion
+ *     1  stream       u4   高4位: 数据流 (STREAM_PPG / STREAM_OPTICAL)；低4位: 通道数 C (1..kMaxChannels)
+ *     2  sequence     u16  每发送一帧加1，客户端据此发现丢失的通知
+ *     4  firstSample  u32  第一个样本的序号 (自开始采集起计数)，序号不连续表示设备端因缓冲区满丢弃了样本
+ *     8  timestampMs  u32  第一个样本的采集时间 (millis)
+ *    12  periodMs     u8   相邻样本的标称间隔 (毫秒)，0 表示成批采集、间隔未知
+ *    13  count        u8   样本数 N
+ *    14  samples      N × C 个 varint，样本按时间顺序、同一样本的各通道相邻:
+ *                     zigzag(x[i][c] - x[i-1][c])，第一个样本与0相减 (即绝对值)
+ * * PPG 相邻样本的差值通常只有几百，18位的原始值差分后大多只需1~2字节。
+ *   默认 MTU 23 时一帧的数据区只有6字节，恰好放得下一个2通道18位样本的绝对值。
+ * * 编码写入调用方提供的定长缓冲区，不分配堆内存。
+ */
+namespace WaveformCodec {
+
+constexpr uint8_t kFrameVersion = 1;
+constexpr size_t kHeaderSize = 14;
+constexpr int kMaxChannels = 3;
+constexpr int kMaxSamplesPerFrame = 255;
+// 32位值的 varint 最多5字节
+constexpr size_t kMaxVarintSize = 5;
+
+enum Stream : uint8_t {
+    STREAM_PPG = 0,         // MAX30102 FIFO: IR, Red
+    STREAM_OPTICAL = 1      // 解调后的光信号ADC原始采样
+};
+
+struct FrameHeader {
+    uint8_t stream;
+    uint8_t channels;
+    uint16_t sequence;
+    uint32_t firstSample;
+    uint32_t timestampMs;
+    uint8_t periodMs;
+    uint8_t count;
+};
+
+inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/**
+ * @brief 写入一个 varint (每字节低7位为数据，最高位表示后面还有字节)。
+ * @return size_t - 写入的字节数 (1..kMaxVarintSize)。
+ */
+size_t writeVarint(uint32_t value, uint8_t* out);
+
+/**
+ * @brief 读取一个 varint。
+ * @return size_t - 读取的字节数，数据不完整或超过 kMaxVarintSize 字节时返回0。
+ */
+size_t readVarint(const uint8_t* in, size_t length, uint32_t* value);
+
+/**
+ * @class FrameEncoder
+ * @brief 逐个样本地组帧，直到帧放不下下一个样本为止。
+ */
+class FrameEncoder {
+public:
+    /**
+     * @brief 写入帧头并开始一帧 (header.count 被忽略，由 finish() 写入)。
+     * @return bool - 通道数不合法或容量不足以放下帧头时返回false。
+     */
+    bool begin(const FrameHeader& header, uint8_t* out, size_t capacity);
+
+    /**
+     * @brief 追加一个样本 (header.channels 个值)。
+     * @return bool - 帧已满 (容量或 kMaxSamplesPerFrame) 时返回false，帧保持不变。
+     */
+    bool addSample(const int32_t* values);
+
+    int getCount() const { return _count; }
+
+    /**
+     * @brief 写入样本数，返回帧长 (没有样本时返回0)。
+     */
+    size_t finish();
+
+private:
+    uint8_t* _out;
+    size_t _capacity;
+    size_t _length;
+    int _channels;
+    int _count;
+    int32_t _previous[kMaxChannels];
+};
+
+/**
+ * @brief 解码一帧 (供测试与主机端工具使用)。
+ * @param samples 输出的样本，按 样本 × 通道 排列，至少 maxSamples × header->channels 个元素。
+ * @return int - 样本数，格式错误或 maxSamples 不足时返回-1。
+ */
+int decodeFrame(const uint8_t* packet, size_t length, FrameHeader* header, int32_t* samples, int maxSamples);
+
+} // namespace WaveformCodec
+
+#endif // WAVEFORM_CODEC_H
@@ -0,0 +1,88 @@
+#ifndef WAVEFORM_STREAMER_H
+#define WAVEFORM_STREAMER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "GattSink.h"
+#include "WaveformCodec.h"
+
+/**
+ * @class WaveformStreamer
+ * @brief 原始波形流: 缓存采集到的样本，按协商的MTU组成压缩帧 (格式见 WaveformCodec.h) 通过BLE通知发出。
+ * * 只在客户端写入波形特征值开启后采集 (实验与模型训练用)，默认关闭，断开连接时关闭。
+ * * 背压: 样本先进入环形缓冲区 (kCapacity 个样本)；发送失败 (通知队列满) 时帧留在缓冲区中下一次重试，
+ *   缓冲区满时丢弃最旧的样本并计数，客户端通过帧头的 firstSample 发现缺口。
+ *   MTU 太小、一帧连一个样本都放不下时同样丢弃该样本，不会卡住后面的样本。
+ * * 每次 poll() 最多发送 framesPerPoll 帧，避免一次占满协议栈的发送缓冲区。
+ * * isEnabled() 可在任意任务中调用，其余方法只在拥有BLE的任务中调用 (见 BlePeripheral::poll())。
+ */
+class WaveformStreamer {
+public:
+    static constexpr int kCapacity = 256;
+    // 一帧的最大长度 (开启数据长度扩展时一个链路层包可容纳 ATT_MTU 247)
+    static constexpr size_t kMaxFrameSize = 244;
+
+    struct Config {
+        uint8_t stream;         // WaveformCodec::Stream
+        uint8_t channels;       // 1..WaveformCodec::kMaxChannels
+        uint8_t periodMs;       // 样本的标称间隔，0 表示成批采集
+        int framesPerPoll;      // 每次 poll() 最多发送的帧数
+    };
+
+    struct Stats {
+        uint32_t samples;       // 已发出的样本数
+        uint32_t dropped;       // 因缓冲区满或放不进一帧而丢弃的样本数
+        uint32_t frames;        // 已发出的帧数
+        uint32_t bytes;         // 已发出的帧的总字节数 (含帧头)
+    };
+
+    explicit WaveformStreamer(const Config& config);
+
+    /**
+     * @brief 开启或关闭采集。关闭后缓冲区中未发送的样本在下一次 poll() 中丢弃。
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    /**
+     * @brief 协商后的 ATT MTU，帧长不超过 MTU - 3。
+     */
+    void setMtu(uint16_t mtu);
+
+    /**
+     * @brief 追加一个样本 (config.channels 个值)。未开启时忽略。
+     * @param timestampMs 样本的采集时间 (millis)。
+     */
+    void addSample(const int32_t* values, uint32_t timestampMs);
+
+    /**
+     * @brief 发送缓冲区中的样本。
+     * @return int - 本次发出的帧数。
+     */
+    int poll(GattSink& sink);
+
+    /**
+     * @brief 缓冲区中尚未发出的样本数。
+     */
+    int pending() const;
+
+    Stats getStats() const;
+
+private:
+    Config _config;
+    std::atomic<bool> _enabled;
+    std::atomic<uint16_t> _mtu;
+
+    // 环形缓冲区: 最旧的样本位于 _head，其序号为 _firstIndex
+    int32_t _values[kCapacity][WaveformCodec::kMaxChannels];
+    uint32_t _timestamps[kCapacity];
+    int _head;
+    int _count;
+    uint32_t _firstIndex;
+
+    uint16_t _sequence;
+    Stats _stats;
+};
+
+#endif // WAVEFORM_STREAMER_H
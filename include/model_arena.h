@@ -0,0 +1,20 @@
+#ifndef MODEL_ARENA_H
+#define MODEL_ARENA_H
+
+// =============================================================================
+// == 这是由 tools/gen_arena_size.py 自动生成的文件，请勿手动修改。           ==
+// =============================================================================
+// 来源: static estimate of include/model_data.h
+// 未实测: 这是静态估算的上界，没有经过 AllocateTensors() 验证。dry run 成功后
+// 请用 --from-log 重新生成此文件。
+
+#include <stddef.h>
+
+// AllocateTensors() 之后 interpreter->arena_used_bytes() 的实测值，或静态估算值
+constexpr size_t kModelArenaUsedBytes = 81952;
+// true: 实测值; false: 静态估算的上界 (未考虑内存复用)
+constexpr bool kModelArenaMeasured = false;
+// 实际分配的 Tensor Arena 大小 (含 15% 安全余量，16字节对齐)
+constexpr size_t kTensorArenaSize = 94256;
+
+#endif // MODEL_ARENA_H
@@ -6,7 +6,7 @@
 // =============================================================================
 // == 这是一个自动生成的文件，包含了 TensorFlow Lite 模型数据。请勿手动修改。 ==
 // =============================================================================
-unsigned char g_model_data[] = {
+alignas(16) const unsigned char g_model_data[] = {
   0x1c, 0x00, 0x00, 0x00, 0x54, 0x46, 0x4c, 0x33, 0x14, 0x00, 0x20, 0x00,
   0x1c, 0x00, 0x18, 0x00, 0x14, 0x00, 0x10, 0x00, 0x0c, 0x00, 0x00, 0x00,
   0x08, 0x00, 0x04, 0x00, 0x14, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00,
@@ -12742,6 +12742,6 @@ unsigned char g_model_data[] = {
   0x4d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x4d
 };
 
-unsigned int g_model_data_len = 23768;
+const unsigned int g_model_data_len = sizeof(g_model_data);
 
 #endif // TENSORFLOW_LITE_MODEL_DATA_H_
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef MODEL_OPS_H
+#define MODEL_OPS_H
+
+// =============================================================================
+// ==                             重要说明                                   ==
+// =============================================================================
+// == 这是由 tools/gen_op_resolver.py 自动生成的文件，请勿手动修改。           ==
+// =============================================================================
+// 来源模型: include/model_data.h
+// 只注册模型实际使用的算子，替代链接全部内核的 AllOpsResolver。
+
+// 以下自定义算子没有TFLM内核，无法注册。包含它们的模型会在加载时被拒绝 (主机模拟据此与设备一样拒绝内置模型):
+constexpr const char* kModelUnsupportedOps[] = {
+    "FlexTensorListReserve",
+    "FlexTensorListSetItem",
+    "FlexTensorListStack",
+    nullptr
+};
+
+// 主机模拟中没有 TFLite Micro
+#if !SIMULATOR
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+
+constexpr int kModelOpCount = 15;
+using ModelOpResolver = tflite::MicroMutableOpResolver<kModelOpCount>;
+
+inline bool registerModelOps(ModelOpResolver& resolver) {
+    if (resolver.AddAdd() != kTfLiteOk) return false;
+    if (resolver.AddFill() != kTfLiteOk) return false;
+    if (resolver.AddFullyConnected() != kTfLiteOk) return false;
+    if (resolver.AddGather() != kTfLiteOk) return false;
+    if (resolver.AddLess() != kTfLiteOk) return false;
+    if (resolver.AddLogicalAnd() != kTfLiteOk) return false;
+    if (resolver.AddLogistic() != kTfLiteOk) return false;
+    if (resolver.AddMul() != kTfLiteOk) return false;
+    if (resolver.AddPack() != kTfLiteOk) return false;
+    if (resolver.AddShape() != kTfLiteOk) return false;
+    if (resolver.AddSplit() != kTfLiteOk) return false;
+    if (resolver.AddStridedSlice() != kTfLiteOk) return false;
+    if (resolver.AddTanh() != kTfLiteOk) return false;
+    if (resolver.AddTranspose() != kTfLiteOk) return false;
+    if (resolver.AddWhile() != kTfLiteOk) return false;
+    return true;
+}
+#endif // !SIMULATOR
+
+#endif // MODEL_OPS_H
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <string.h> // 用于 memset
 #include <math.h>   // 用于 isnan
+#include "TraceLog.h"
 
 // 算法常量
 #define SAMPLING_FREQUENCY 100
@@ -55,6 +56,7 @@ private:
     }
 
     void calculate() {
+        TRACE_SCOPE(SPO2_CALCULATE);
         uint32_t ir_dc_sum = 0;
         uint32_t red_dc_sum = 0;
         for (int i = 0; i < BUFFER_SIZE; i++) {
@@ -0,0 +1,129 @@
+#include <Arduino.h>
+#include "config.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+#include "model_ops.h"
+#include "model_data.h"
+#include "model_arena.h"
+#include "Quantization.h"
+#include "LatencyStats.h"
+#include "OpProfile.h"
+#include "TflmOpProfiler.h"
+
+// 推理基准测试 (env:esp32-s3-benchmark): 加载固件内置的 g_model_data，用固定输入运行
+// BENCHMARK_ITERATIONS 次 Invoke()，串口输出耗时分位数、arena用量与各算子耗时 (CSV + JSON)。
+//   pio run -e esp32-s3-benchmark -t upload && pio device monitor
+// 主机上的对照测量见 tools/benchmark_model.py。
+
+namespace {
+    tflite::MicroErrorReporter error_reporter;
+    ModelOpResolver resolver;
+    OpProfile op_profile;
+    TflmOpProfiler profiler(op_profile);
+    LatencyStats latency;
+    alignas(16) uint8_t tensor_arena[kTensorArenaSize];
+
+    void printLine(const char* line) {
+        Serial.println(line);
+    }
+
+    // 与 GlucosePredictor::checkModelOps 相同的规则
+    bool modelOpsAvailable(const tflite::Model* model) {
+        const auto* opcodes = model->operator_codes();
+        for (unsigned int i = 0; opcodes != nullptr && i < opcodes->size(); i++) {
+            const tflite::OperatorCode* opcode = opcodes->Get(i);
+            tflite::BuiltinOperator code = tflite::GetBuiltinCode(opcode);
+            if (code == tflite::BuiltinOperator_CUSTOM) {
+                const char* name = opcode->custom_code() != nullptr ? opcode->custom_code()->c_str() : "";
+                if (resolver.FindOp(name) == nullptr) {
+                    Serial.printf("Custom op '%s' has no TFLM kernel.\n", name);
+                    return false;
+                }
+            } else if (resolver.FindOp(code) == nullptr) {
+                Serial.printf("Op %s is not registered.\n", tflite::EnumNameBuiltinOperator(code));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 固定输入: 每个输入张量填入同一段平缓上升的血糖曲线 (int8张量按其量化参数换算)，保证每次运行可比
+    void fillInputs(tflite::MicroInterpreter& interpreter) {
+        for (size_t t = 0; t < interpreter.inputs_size(); t++) {
+            TfLiteTensor* tensor = interpreter.input(t);
+            int count = 1;
+            for (int d = 0; d < tensor->dims->size; d++) count *= tensor->dims->data[d];
+            for (int i = 0; i < count; i++) {
+                float value = 100.0f + 2.0f * (i % 10);
+                if (tensor->type == kTfLiteFloat32) {
+                    tensor->data.f[i] = value;
+                } else if (tensor->type == kTfLiteInt8) {
+                    tensor->data.int8[i] = Quantization::quantizeInt8(value, tensor->params.scale, tensor->params.zero_point);
+                }
+            }
+            if (tensor->type != kTfLiteFloat32 && tensor->type != kTfLiteInt8) {
+                memset(tensor->data.raw, 0, tensor->bytes);
+            }
+        }
+    }
+
+    void runBenchmark() {
+        if (!registerModelOps(resolver)) {
+            Serial.println("FATAL: Failed to register model ops."); return;
+        }
+        const tflite::Model* model = tflite::GetModel(g_model_data);
+        if (model->version() != TFLITE_SCHEMA_VERSION || !modelOpsAvailable(model)) {
+            Serial.println("FATAL: Built-in model cannot run in TFLM, nothing to measure."); return;
+        }
+
+        unsigned long initStart = micros();
+        tflite::MicroInterpreter interpreter(model, resolver, tensor_arena, kTensorArenaSize, &error_reporter, nullptr, &profiler);
+        if (interpreter.AllocateTensors() != kTfLiteOk) {
+            Serial.println("FATAL: AllocateTensors() failed, re-run tools/gen_arena_size.py."); return;
+        }
+        unsigned long initUs = micros() - initStart;
+        fillInputs(interpreter);
+
+        // 预热: 排除首次运行时的cache缺失
+        for (int i = 0; i < BENCHMARK_WARMUP_ITERATIONS; i++) {
+            interpreter.Invoke();
+        }
+
+        latency.clear();
+        op_profile.reset();
+        for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+            op_profile.beginRun();
+            unsigned long start = micros();
+            if (interpreter.Invoke() != kTfLiteOk) {
+                Serial.println("FATAL: Invoke() failed."); return;
+            }
+            latency.add((uint32_t)(micros() - start));
+            op_profile.endRun();
+        }
+
+        LatencyStats::Summary s = latency.summarize();
+        Serial.printf("Model: %u bytes, %s input, init %lu us\n", (unsigned)g_model_data_len,
+                      interpreter.input(0)->type == kTfLiteInt8 ? "int8" : "float32", initUs);
+        Serial.printf("Arena: %u / %u bytes\n", (unsigned)interpreter.arena_used_bytes(), (unsigned)kTensorArenaSize);
+        Serial.printf("Invoke x%d: min %lu, p50 %lu, p90 %lu, p99 %lu, max %lu, mean %lu us\n", s.count,
+                      (unsigned long)s.minUs, (unsigned long)s.p50Us, (unsigned long)s.p90Us,
+                      (unsigned long)s.p99Us, (unsigned long)s.maxUs, (unsigned long)s.meanUs);
+        Serial.println("--- per-op (csv) ---");
+        op_profile.writeCsv(printLine);
+        Serial.println("--- per-op (json) ---");
+        op_profile.writeJson(printLine, interpreter.arena_used_bytes(), kTensorArenaSize);
+    }
+}
+
+void setup() {
+    Serial.begin(SERIAL_BAUD_RATE);
+    delay(2000); // 等待串口监视器连接
+    Serial.println("\n--- Inference benchmark ---");
+    runBenchmark();
+}
+
+void loop() {
+    delay(1000);
+}
@@ -94,5 +94,249 @@
 // 示例: 温度补偿系数 (单位: 测量单位 / 摄氏度)
 // #define TEMP_COMPENSATION_COEFFICIENT -0.05
 
+/*
+ * 血糖平滑滤波 (卡尔曼滤波器) 配置
+ */
+// 过程噪声谱密度 ((mg/dL/min)^2 / min)。越大，滤波器越快跟随血糖变化。
+#define GLUCOSE_FILTER_PROCESS_NOISE 0.5f
+// 信号质量最佳时的单次测量噪声标准差 (mg/dL)。
+#define GLUCOSE_FILTER_MEASUREMENT_NOISE 8.0f
+// 两次成功测量间隔超过此值 (毫秒)，滤波器重新初始化。
+#define GLUCOSE_FILTER_MAX_GAP_MS (15UL * 60UL * 1000UL)
+// 当95%置信区间半宽低于此值 (mg/dL) 时，认为读数已稳定，可降低测量频率。
+#define GLUCOSE_FILTER_STABLE_CI 6.0f
+
+/*
+ * 测量节奏配置
+ */
+// 默认测量间隔 (毫秒)
+#define MEASUREMENT_INTERVAL_MS 2000
+// 读数稳定时的测量间隔 (毫秒)，用于降低LED/ADC占空比
+#define MEASUREMENT_INTERVAL_STABLE_MS 4000
+
+/*
+ * 自适应多次测量 (提前停止) 配置
+ * 每次测量由若干短时子测量组成，当均值的95%置信区间半宽低于容差时提前结束。
+ */
+// 是否启用自适应测量模式 (1: 启用, 0: 使用固定的单次测量)
+#define ADAPTIVE_MEASUREMENT_ENABLED 1
+// 目标置信区间半宽 (mg/dL)
+#define ADAPTIVE_TOLERANCE_MGDL 3.0f
+// 单次测量的时间预算 (毫秒)
+#define ADAPTIVE_TIME_BUDGET_MS 1500
+// 判断收敛前至少需要的子测量次数
+#define ADAPTIVE_MIN_SUBMEASUREMENTS 3
+// 子测量次数上限
+#define ADAPTIVE_MAX_SUBMEASUREMENTS 48
+// 每次子测量的ADC平均采样数
+#define ADAPTIVE_ADC_SAMPLES 16
+// 相邻子测量之间的间隔 (毫秒)，让MAX30102有新的样本进入FIFO
+#define ADAPTIVE_SUBMEASUREMENT_INTERVAL_MS 20
+// 测量间隙关闭LED与解调参考信号以节能；重新开启后需等待光路稳定的时间 (毫秒)
+#define ADAPTIVE_GATE_OPTICS 1
+#define OPTICAL_SETTLE_MS 10
+
+
+// =================================================================
+// ================= 预测模型配置 (Prediction Model) ==================
+// =================================================================
+
+/*
+ * 模型分区 (见 custom.csv 中的 model_a / model_b)
+ */
+// 模型分区的标签与子类型
+#define MODEL_PARTITION_LABEL_A "model_a"
+#define MODEL_PARTITION_LABEL_B "model_b"
+#define MODEL_PARTITION_SUBTYPE 0x40
+// 新写入的模型允许试运行的启动次数，超过后自动回滚到上一个确认过的模型
+// (试运行中崩溃、或推理卡死被看门狗复位，都计为一次失败的启动)
+#define MODEL_MAX_BOOT_ATTEMPTS 2
+// 试运行的模型连续成功推理多少次 (输出均为合理范围内的有限值) 后才确认；推理失败或输出无效时立即回滚
+#define MODEL_TRIAL_CONFIRM_INFERENCES 20
+// 试运行时预测值的合理范围 (mg/dL)
+#define MODEL_TRIAL_MIN_OUTPUT_MGDL 20.0f
+#define MODEL_TRIAL_MAX_OUTPUT_MGDL 600.0f
+// 试运行时一次推理的最长耗时 (秒)，超过后由任务看门狗复位
+#define MODEL_TRIAL_INVOKE_TIMEOUT_S 10
+// 两个模型分区都不可用时，是否退回固件内置的 g_model_data (1: 是, 0: 否)
+#define MODEL_EMBEDDED_FALLBACK 1
+// 启动时默认偏好的模型精度 (0: float32, 1: int8, 0xFF: 不限)。可通过BLE的 SELECT_FORMAT 命令修改并保存到NVS
+#define MODEL_PREFERRED_FORMAT 0xFF
+
+/*
+ * Tensor Arena 配置 (大小见 include/model_arena.h)
+ */
+// 分配arena后内部SRAM至少还需保留的空闲空间 (字节)，供BLE协议栈等系统组件使用
+#define TENSOR_ARENA_INTERNAL_RESERVE (48 * 1024)
+
+/*
+ * 预测曲线 (多输出模型一次 Invoke() 输出未来 N 步的预测)
+ */
+// 模型输出相邻两步之间的时间间隔 (分钟)
+#define PREDICTION_STEP_MINUTES 5
+// 曲线的最大点数 (5分钟一步时为60分钟)，超出的输出被截断
+#define PREDICTION_MAX_HORIZON 12
+// 连接后向手机请求的ATT MTU，使整条曲线 (含预测区间) 能在一次通知中发出 (4 + 6*N 字节；合并通知另加14字节)
+#define BLE_PREFERRED_MTU 96
+// BLE协议栈 (1: NimBLE，默认，只实现BLE，占用的堆与闪存更少；0: Arduino自带的Bluedroid，用于对照，
+// 由 esp32-s3-bluedroid 环境的 build_flags 定义)。对比报告: python tools/ble_stack_report.py
+#ifndef BLE_USE_NIMBLE
+#define BLE_USE_NIMBLE 1
+#endif
+// 模型更新特征值只接受已加密且经配对码认证 (MITM) 的连接。配对码 (6位数字) 0 表示首次启动时随机生成并存入NVS，
+// 每次启动从串口打印；非0时所有设备使用同一个固定值 (仅用于调试)
+#define BLE_UPDATE_PASSKEY 0
+// 主机模拟 (1: BLE使用 SimBleTransport，见 include/SimBoard.h)。由 native-sim 环境的 build_flags 定义
+#ifndef SIMULATOR
+#define SIMULATOR 0
+#endif
+// 心率 / 血氧 / 血糖特征值的格式 (0: 带序号与时间戳的SFLOAT二进制包，见 BleEncoding.h；1: 旧版客户端使用的文本，如 "98.60")
+#define BLE_TEXT_VALUES 0
+
+/*
+ * 合并通知 (VitalsPublisher): 血糖、心率、血氧与预测曲线合并为一个通知
+ */
+// 是否使用合并通知 (1: 是，各数值的单独特征值只更新值、不再通知；0: 否，每个数值单独通知)
+#define BLE_COMPOSITE_NOTIFICATIONS 1
+// 两次通知的最小间隔 (毫秒)，连接间隔更长时按连接间隔
+#define BLE_MIN_NOTIFY_INTERVAL_MS 1000
+// 数值都没有超出死区时，最长多久全量发送一次 (毫秒)
+#define BLE_MAX_SILENCE_MS 30000
+// 各字段的死区: 与上次发出的值相比变化不超过该值时不发送
+#define BLE_DEADBAND_GLUCOSE_MGDL 1.0f
+#define BLE_DEADBAND_HEART_RATE_BPM 1.0f
+#define BLE_DEADBAND_SPO2_PERCENT 0.5f
+#define BLE_DEADBAND_CURVE_MGDL 2.0f
+
+/*
+ * BLE任务: 唯一调用 BlePeripheral::poll() 的任务，其他任务与协议栈的回调只把消息/事件放入无锁队列
+ * (队列深度见 BlePeripheral::kPublishQueueDepth 等，高水位见 BluetoothController::getQueueStats())
+ */
+// 是否启动BLE任务 (1: 是，主循环中的 poll() 不再执行；0: 否，由主循环调用 poll())。
+// native-sim 环境的 build_flags 定义为0: 任务按真实时间运行，与虚拟时钟不同步
+#ifndef BLE_TASK_ENABLED
+#define BLE_TASK_ENABLED 1
+#endif
+// BLE任务固定的核心 (与协议栈的任务同在核心0) 、栈大小 (字节) 与优先级
+#define BLE_TASK_CORE 0
+#define BLE_TASK_STACK_SIZE 6144
+#define BLE_TASK_PRIORITY 2
+// 两次排空队列的间隔 (毫秒)，PPG 100 sps 时每次约2个样本
+#define BLE_TASK_PERIOD_MS 20
+
+/*
+ * 原始波形流 (WaveformStreamer): 实验与模型训练用，客户端写入波形特征值后开始发送
+ */
+// 是否编译波形流 (关闭时不注册传感器的采样回调)
+#define WAVEFORM_STREAMING_ENABLED 1
+// 每个数据流每次 poll() 最多发送的帧数。MTU 96 时一帧约30个PPG样本，25 sps 下每秒不到1帧，
+// MTU 23 时一帧只有1~2个样本，需要每秒十几帧
+#define WAVEFORM_FRAMES_PER_POLL 16
+// 波形流开启时主循环两次测量之间读取传感器FIFO并发送的间隔 (毫秒)，须小于FIFO (32个样本) 填满的时间
+#define WAVEFORM_POLL_INTERVAL_MS 200
+
+/*
+ * 标准血糖服务 (Glucose Service 0x1808) 与历史记录下载
+ */
+// 写入一条历史记录的最小间隔 (毫秒)，记录存储容量见 GlucoseRecordStore::kCapacity
+#define GLUCOSE_RECORD_INTERVAL_MS 60000
+// 每次主循环最多通过 RACP 上报的记录数
+#define GLS_RECORDS_PER_POLL 32
+
+/*
+ * 读数历史 (TimeSeriesStore / ReadingLog): 每个读数写入 spiffs 分区 (直接读写原始分区，不使用文件系统)，断电不丢失
+ */
+// 是否保存读数历史
+#define READING_LOG_ENABLED 1
+// 使用的数据分区 (custom.csv 中的 Name 列)
+#define READING_LOG_PARTITION_LABEL "spiffs"
+// 每条flash记录 (压缩块) 的字节数。492 使每个4 KB 扇区恰好放下8条记录；
+// 一块约120个读数，未写入的一块在意外断电时丢失 (2秒一次测量时约4分钟)
+#define READING_LOG_BLOCK_SIZE 492
+
+/*
+ * 原始传感器录制与回放 (SensorCapture): 把 GlucoseCalculator 的全部输入写入 capture 分区，
+ * 之后用同样的数据重新运行处理链路，用于重现现场问题、在真实数据上对比算法改动
+ */
+#define SENSOR_CAPTURE_OFF 0
+// 开机后录制: ADC采样块、MAX30102 FIFO样本、DHT22读数与处理链路读取的时钟 (约150字节/秒，1 MB 约2小时)。
+// 录制时不恢复检查点，处理链路从初始状态开始，回放的结果才与录制时相同
+#define SENSOR_CAPTURE_RECORD 1
+// 开机后回放最近一次录制: 不读取传感器、不等待，串口输出每次测量与全部输出的CRC32，不写入读数历史与检查点
+#define SENSOR_CAPTURE_REPLAY 2
+#ifndef SENSOR_CAPTURE_MODE
+#define SENSOR_CAPTURE_MODE SENSOR_CAPTURE_OFF
+#endif
+// 使用的数据分区 (custom_capture.csv 中的 Name 列，默认的 custom.csv 中没有，见 env:esp32-s3-capture)
+#define SENSOR_CAPTURE_PARTITION_LABEL "capture"
+// 每条flash记录 (块) 的字节数。1004 使每个4 KB 扇区恰好放下4条记录
+#define SENSOR_CAPTURE_BLOCK_SIZE 1004
+
+/*
+ * 预测区间 (集成模型: 多个小模型的预测合并为均值与95%预测区间，见 Ensemble)
+ */
+// 上一次完整运行的区间宽度不超过该值 (mg/dL) 时，只运行主模型并沿用上次的区间
+#define ENSEMBLE_TIGHT_WIDTH_MGDL 10.0f
+// 连续只运行主模型的次数上限，之后重新运行全部模型
+#define ENSEMBLE_MAX_CONSECUTIVE_SKIPS 5
+
+/*
+ * 异步推理 (InferenceService)
+ */
+// 是否在独立任务中运行 Invoke() (1: 是，主循环只提交请求；0: 在 loop() 中同步推理)。
+// native-sim 环境的 build_flags 定义为0，模拟的结果不受线程调度影响
+#ifndef PREDICTOR_ASYNC_ENABLED
+#define PREDICTOR_ASYNC_ENABLED 1
+#endif
+// 推理任务固定的核心 (Arduino 的 loop() 运行在核心1)
+#define INFERENCE_TASK_CORE 0
+// 推理任务的栈大小 (字节) 与优先级
+#define INFERENCE_TASK_STACK_SIZE 8192
+#define INFERENCE_TASK_PRIORITY 1
+
+/*
+ * 性能剖析与基准测试
+ */
+// 是否按算子记录 Invoke() 耗时 (1: 是，串口输入 'c' / 'j' 按CSV / JSON输出；0: 否，不增加任何开销)
+#ifndef PREDICTOR_PROFILING
+#define PREDICTOR_PROFILING 0
+#endif
+// 是否记录热点路径的追踪事件 (1: 是，串口输入 't' 按 Chrome trace JSON 输出，见 TraceLog.h；0: 否，不增加任何开销)。
+// 由 esp32-s3-trace / native-sim-trace 环境的 build_flags 定义
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+// 基准测试 (env:esp32-s3-benchmark) 的预热次数与计时的推理次数 (不超过 LatencyStats::kMaxSamples)
+#define BENCHMARK_WARMUP_ITERATIONS 10
+#define BENCHMARK_ITERATIONS 500
+
+/*
+ * 预测历史 (按模型的时间网格重采样)
+ */
+// 模型训练时相邻两个输入读数的时间间隔 (毫秒)
+#define PREDICTOR_GRID_STEP_MS 2000
+// 允许插值跨越的最长读数间隔 (毫秒)，窗口内有更长的间隔 (例如手指移开) 时暂停预测
+#define PREDICTOR_MAX_GAP_MS 10000
+// 最新读数的最长有效时间 (毫秒)，超过后暂停预测
+#define PREDICTOR_MAX_STALENESS_MS 15000
+// 读数进入预测历史所需的最低信号质量 (0~1)
+#define PREDICTOR_MIN_QUALITY 0.2f
+
+/*
+ * 预测历史与滤波器状态的检查点 (重启后无需重新积累历史)
+ * 检查点只在重启后的第一个读数距快照中最后一个读数不超过 PREDICTOR_MAX_GAP_MS 时有用，
+ * 否则重采样遇到过长的间隔，历史照样要重新积累。因此每个读数之后都写入RTC内存 (RtcKeyValueStore，
+ * 软件复位、看门狗与异常重启后保留，没有flash擦写)；NVS只在计划内的重启前 (关机回调) 写入一次，
+ * 用于固件更新后RTC内存布局改变的情形。
+ * 有状态流式模型的隐藏状态随NVS检查点一起写入，同样超过 PREDICTOR_MAX_GAP_MS 后不再使用
+ */
+// 累计多少个新读数后写入一次RTC内存: 稳定时测量间隔为 MEASUREMENT_INTERVAL_STABLE_MS，
+// 再加上重启与第一次测量的耗时，只有每个读数都写入才能保持在 PREDICTOR_MAX_GAP_MS 之内
+#define PREDICTOR_CHECKPOINT_READINGS 1
+// 未保存的读数最长等待多久后写入 (毫秒)
+#define PREDICTOR_CHECKPOINT_INTERVAL_MS MEASUREMENT_INTERVAL_MS
+// 重启后检查点的最长有效时间 (毫秒)，与重采样允许的最长间隔相同
+#define PREDICTOR_CHECKPOINT_MAX_AGE_MS PREDICTOR_MAX_GAP_MS
+
 
 #endif // CONFIG_H
\ No newline at end of file
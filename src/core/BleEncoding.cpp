@@ -0,0 +1,91 @@
+#include "BleEncoding.h"
+#include "ByteOrder.h"
+#include <math.h>
+#include <stdio.h>
+
+namespace BleEncoding {
+
+namespace {
+    constexpr int kMinExponent = -8;
+    constexpr int kMaxExponent = 7;
+    // 有限值的尾数范围，避开 ±2046..2048 这些特殊值的编码
+    constexpr int32_t kMaxMantissa = 2045;
+
+    const float kPowersOfTen[] = {
+        1e-8f, 1e-7f, 1e-6f, 1e-5f, 1e-4f, 1e-3f, 1e-2f, 1e-1f,
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f
+    };
+
+    // 10^e，e 在 [-8, 8] 范围内
+    float powerOfTen(int e) {
+        return kPowersOfTen[e + 8];
+    }
+}
+
+uint16_t toSfloat(float value) {
+    if (isnan(value)) {
+        return kSfloatNaN;
+    }
+    if (value == 0.0f) {
+        return 0x0000;
+    }
+    for (int e = kMinExponent; e <= kMaxExponent; e++) {
+        float scaled = roundf(value / powerOfTen(e));
+        if (fabsf(scaled) <= (float)kMaxMantissa) {
+            int32_t mantissa = (int32_t)scaled;
+            return (uint16_t)(((e & 0x0F) << 12) | (mantissa & 0x0FFF));
+        }
+    }
+    return value > 0.0f ? kSfloatPositiveInfinity : kSfloatNegativeInfinity;
+}
+
+float fromSfloat(uint16_t sfloat) {
+    switch (sfloat) {
+        case kSfloatPositiveInfinity: return INFINITY;
+        case kSfloatNegativeInfinity: return -INFINITY;
+        case kSfloatNaN:
+        case kSfloatNRes:
+        case kSfloatReserved:
+            return NAN;
+        default:
+            break;
+    }
+    int32_t mantissa = sfloat & 0x0FFF;
+    if (mantissa >= 0x0800) mantissa -= 0x1000;
+    int exponent = (sfloat >> 12) & 0x0F;
+    if (exponent >= 0x08) exponent -= 0x10;
+    return (float)mantissa * powerOfTen(exponent);
+}
+
+size_t encodeMeasurement(const Measurement& m, uint8_t* out, size_t capacity) {
+    if (capacity < kMeasurementPacketSize) {
+        return 0;
+    }
+    out[0] = kMeasurementPacketVersion;
+    out[1] = 0;
+    ByteOrder::writeU16(out + 2, m.sequence);
+    ByteOrder::writeU16(out + 4, (uint16_t)m.timestamp);
+    ByteOrder::writeU16(out + 6, (uint16_t)(m.timestamp >> 16));
+    writeSfloat(out + 8, m.value);
+    return kMeasurementPacketSize;
+}
+
+bool decodeMeasurement(const uint8_t* packet, size_t length, Measurement* out) {
+    if (length != kMeasurementPacketSize || packet[0] != kMeasurementPacketVersion) {
+        return false;
+    }
+    out->sequence = ByteOrder::readU16(packet + 2);
+    out->timestamp = ByteOrder::readU16(packet + 4) | ((uint32_t)ByteOrder::readU16(packet + 6) << 16);
+    out->value = readSfloat(packet + 8);
+    return true;
+}
+
+size_t formatText(float value, char* out, size_t capacity) {
+    int n = snprintf(out, capacity, "%.2f", value);
+    if (n < 0 || (size_t)n >= capacity) {
+        return 0;
+    }
+    return (size_t)n;
+}
+
+} // namespace BleEncoding
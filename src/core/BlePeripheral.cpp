@@ -0,0 +1,462 @@
+#include "BlePeripheral.h"
+#include "ByteOrder.h"
+#include "BleEncoding.h"
+#include "PredictionCurve.h"
+#include <time.h>
+#include <chrono>
+#ifdef ESP_PLATFORM
+#include <esp_pthread.h>
+#endif
+
+namespace {
+    // 预测曲线特征值的缓冲区按合并通知的最大点数分配，Config::maxCurvePoints 不能超过它
+    constexpr int kMaxCurvePoints = VitalsPublisher::kMaxCurvePoints;
+
+    WaveformStreamer::Config ppgConfig(const BlePeripheral::Config& c) {
+        WaveformStreamer::Config w = { WaveformCodec::STREAM_PPG, 2, c.ppgPeriodMs, c.waveformFramesPerPoll };
+        return w;
+    }
+
+    // ADC 的原始采样成批采集 (一次测量内连续多次 analogRead)，间隔未知
+    WaveformStreamer::Config opticalConfig(const BlePeripheral::Config& c) {
+        WaveformStreamer::Config w = { WaveformCodec::STREAM_OPTICAL, 1, 0, c.waveformFramesPerPoll };
+        return w;
+    }
+
+    // 数值特征值的缓冲区: 文本 ("98.60") 或 SFLOAT 测量包
+    constexpr size_t kValueBufferSize = 16;
+    static_assert(BleEncoding::kMeasurementPacketSize <= kValueBufferSize, "value buffer too small");
+
+    uint32_t nowMs() {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+BlePeripheral::BlePeripheral(BleTransport& transport, const Config& config) :
+    _transport(transport),
+    _config(config),
+    _updateHandler(nullptr),
+    _glucoseService(_records, transport, config.recordsPerPoll),
+    _vitals(config.vitals),
+    _ppg(ppgConfig(config)),
+    _optical(opticalConfig(config)),
+    _eventsLost(false),
+    _running(false),
+    _heartRateSequence(0),
+    _spO2Sequence(0),
+    _glucoseSequence(0),
+    _rollupTier(RollupEngine::MINUTE),
+    _rollupFrom(0),
+    _rollupLatest(true),
+    _rollupDirty(true)
+{
+    if (_config.maxCurvePoints > kMaxCurvePoints) {
+        _config.maxCurvePoints = kMaxCurvePoints;
+    }
+}
+
+BlePeripheral::~BlePeripheral() {
+    stop();
+}
+
+bool BlePeripheral::begin(const char* deviceName, uint16_t preferredMtu) {
+    if (!_transport.begin(deviceName, preferredMtu, this)) {
+        return false;
+    }
+    uint8_t features[2] = { (uint8_t)GlucoseService::kFeatures, (uint8_t)(GlucoseService::kFeatures >> 8) };
+    _transport.setValue(GattSink::Characteristic::FEATURE, features, sizeof(features));
+    refreshRollupPage();
+    return true;
+}
+
+void BlePeripheral::setUpdateHandler(UpdateHandler handler) {
+    _updateHandler = handler;
+}
+
+bool BlePeripheral::isConnected() const {
+    return _transport.isConnected();
+}
+
+// --- BLE任务 ---
+
+bool BlePeripheral::start(int core, uint32_t stackSize, int priority, uint32_t periodMs) {
+    std::lock_guard<std::mutex> lock(_taskMutex);
+    if (_running) {
+        return true;
+    }
+
+#ifdef ESP_PLATFORM
+    // 与 InferenceService 相同: 创建 std::thread 前设置的 pthread 配置决定任务的核心、栈与优先级
+    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+    cfg.stack_size = stackSize;
+    cfg.prio = priority;
+    cfg.pin_to_core = core;
+    cfg.thread_name = "ble";
+    if (esp_pthread_set_cfg(&cfg) != ESP_OK) {
+        return false;
+    }
+#else
+    (void)core;
+    (void)stackSize;
+    (void)priority;
+#endif
+
+    _running = true;
+    _task = std::thread(&BlePeripheral::run, this, periodMs);
+
+#ifdef ESP_PLATFORM
+    esp_pthread_cfg_t defaults = esp_pthread_get_default_config();
+    esp_pthread_set_cfg(&defaults);
+#endif
+    return true;
+}
+
+void BlePeripheral::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_taskMutex);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+    }
+    _taskWake.notify_one();
+    if (_task.joinable()) {
+        _task.join();
+    }
+}
+
+bool BlePeripheral::isRunning() const {
+    return _running;
+}
+
+void BlePeripheral::run(uint32_t periodMs) {
+    std::unique_lock<std::mutex> lock(_taskMutex);
+    while (_running) {
+        lock.unlock();
+        poll(nowMs(), (uint32_t)time(nullptr));
+        lock.lock();
+        // 生产者不唤醒本任务 (中断中不能通知条件变量)，按固定周期排空队列
+        _taskWake.wait_for(lock, std::chrono::milliseconds(periodMs), [this] { return !_running; });
+    }
+}
+
+// --- Listener ---
+
+void BlePeripheral::postEvent(Event::Type type, uint32_t value, uint8_t argument) {
+    Event event = { type, argument, value };
+    if (!_events.tryPush(event)) {
+        _eventsLost = true;
+    }
+}
+
+void BlePeripheral::onConnect(uint32_t connectionIntervalMs) {
+    postEvent(Event::CONNECTED, connectionIntervalMs);
+}
+
+void BlePeripheral::onDisconnect() {
+    postEvent(Event::DISCONNECTED, 0);
+}
+
+void BlePeripheral::onMtuChanged(uint16_t mtu) {
+    postEvent(Event::MTU_CHANGED, mtu);
+}
+
+void BlePeripheral::onWrite(GattSink::Characteristic characteristic, const uint8_t* data, size_t length) {
+    switch (characteristic) {
+        case GattSink::Characteristic::RACP:
+            _glucoseService.handleRacpWrite(data, length);
+            break;
+        case GattSink::Characteristic::MODEL_UPDATE:
+            if (_updateHandler != nullptr) {
+                // 每个包都应答，客户端据此控制写入节奏
+                postEvent(Event::MODEL_STATUS, _updateHandler(data, length));
+            }
+            break;
+        case GattSink::Characteristic::WAVEFORM:
+            // 与连接事件同一队列，保证断开前的关闭不会覆盖新连接的开启
+            if (length >= 1) {
+                postEvent(Event::WAVEFORM_MASK, data[0]);
+            }
+            break;
+        case GattSink::Characteristic::ROLLUP:
+            if (length == 1 && data[0] < RollupEngine::kTierCount) {
+                postEvent(Event::ROLLUP_QUERY, 0, data[0] | kRollupLatest);
+            } else if (length >= 5 && data[0] < RollupEngine::kTierCount) {
+                uint32_t from = ByteOrder::readU32(data + 1);
+                postEvent(Event::ROLLUP_QUERY, from, data[0]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void BlePeripheral::handleEvent(const Event& event) {
+    switch (event.type) {
+        case Event::CONNECTED:
+            // 新的客户端从完整的快照开始；MTU 交换的结果随后作为 MTU_CHANGED 到达
+            _vitals.setMtu(VitalsPublisher::kDefaultMtu);
+            _ppg.setMtu(VitalsPublisher::kDefaultMtu);
+            _optical.setMtu(VitalsPublisher::kDefaultMtu);
+            _vitals.setConnectionIntervalMs(event.value);
+            _vitals.onConnect();
+            break;
+        case Event::DISCONNECTED:
+            // 记录下载不跨连接保留，客户端重新连接后从它收到的最后一个序号重新请求
+            _glucoseService.reset();
+            // 波形流只对开启它的客户端有效
+            _ppg.setEnabled(false);
+            _optical.setEnabled(false);
+            // 下一个客户端从默认的查询开始
+            _rollupTier = RollupEngine::MINUTE;
+            _rollupLatest = true;
+            _rollupDirty = true;
+            // 广播在这里而不是协议栈的回调中重新开始
+            _transport.startAdvertising();
+            break;
+        case Event::MTU_CHANGED:
+            _vitals.setMtu((uint16_t)event.value);
+            _ppg.setMtu((uint16_t)event.value);
+            _optical.setMtu((uint16_t)event.value);
+            break;
+        case Event::WAVEFORM_MASK:
+            _ppg.setEnabled((event.value & WAVEFORM_PPG) != 0);
+            _optical.setEnabled((event.value & WAVEFORM_OPTICAL) != 0);
+            break;
+        case Event::MODEL_STATUS: {
+            uint8_t status = (uint8_t)event.value;
+            _transport.send(GattSink::Characteristic::MODEL_UPDATE, &status, 1);
+            break;
+        }
+        case Event::ROLLUP_QUERY:
+            _rollupTier = (RollupEngine::Tier)(event.argument & ~kRollupLatest);
+            _rollupLatest = (event.argument & kRollupLatest) != 0;
+            _rollupFrom = event.value;
+            _rollupDirty = true;
+            break;
+    }
+}
+
+// --- 数值特征值 ---
+
+void BlePeripheral::publish(GattSink::Characteristic characteristic, const uint8_t* data, size_t length) {
+    // 合并通知时只更新值供读取，由 poll() 统一通知
+    if (_config.compositeNotifications) {
+        _transport.setValue(characteristic, data, length);
+    } else {
+        _transport.send(characteristic, data, length);
+    }
+}
+
+// 编码到栈上的缓冲区，这条路径上没有堆分配
+void BlePeripheral::updateValue(GattSink::Characteristic characteristic, uint16_t& sequence, float value, uint32_t timestamp) {
+    if (!_transport.isConnected()) {
+        return;
+    }
+    size_t length;
+    uint8_t packet[kValueBufferSize];
+    if (_config.textValues) {
+        length = BleEncoding::formatText(value, (char*)packet, sizeof(packet));
+    } else {
+        BleEncoding::Measurement m = { sequence, timestamp, value };
+        length = BleEncoding::encodeMeasurement(m, packet, sizeof(packet));
+    }
+    if (length == 0) {
+        return;
+    }
+    publish(characteristic, packet, length);
+    sequence++;
+}
+
+void BlePeripheral::publishCurve(const Message& message) {
+    const float* lower = message.hasInterval ? message.lower : nullptr;
+    const float* upper = message.hasInterval ? message.upper : nullptr;
+    _vitals.setCurve(message.curve, message.curveSize, lower, upper);
+    if (!_transport.isConnected()) {
+        return;
+    }
+    // 每次推理一个二进制通知 (格式见 PredictionCurve.h)
+    uint8_t packet[PredictionCurve::packetSize(kMaxCurvePoints, true)];
+    int size = message.curveSize < _config.maxCurvePoints ? message.curveSize : _config.maxCurvePoints;
+    PredictionCurve::Curve curve = { message.curve, size };
+    size_t length = PredictionCurve::encodePacket(curve, _config.vitals.curveStepMinutes, packet, sizeof(packet), lower, upper);
+    if (length == 0) {
+        return;
+    }
+    publish(GattSink::Characteristic::PREDICTION, packet, length);
+}
+
+void BlePeripheral::handleMessage(const Message& message) {
+    switch (message.type) {
+        case Message::HEART_RATE:
+            _vitals.setHeartRate(message.value);
+            updateValue(GattSink::Characteristic::HEART_RATE, _heartRateSequence, message.value, message.timestamp);
+            break;
+        case Message::SPO2:
+            _vitals.setSpO2(message.value);
+            updateValue(GattSink::Characteristic::SPO2, _spO2Sequence, message.value, message.timestamp);
+            break;
+        case Message::GLUCOSE:
+            _vitals.setGlucose(message.value);
+            updateValue(GattSink::Characteristic::GLUCOSE, _glucoseSequence, message.value, message.timestamp);
+            break;
+        case Message::CURVE:
+            publishCurve(message);
+            break;
+        case Message::RECORD:
+            _records.add(message.timestamp, message.value);
+            break;
+        case Message::READING:
+            _rollups.add(message.timestamp, message.value);
+            _rollupDirty = true;
+            break;
+    }
+}
+
+void BlePeripheral::refreshRollupPage() {
+    uint8_t page[RollupEngine::kMaxPageSize];
+    size_t length = _rollups.encodePage(_rollupTier, _rollupFrom, _rollupLatest, page, sizeof(page));
+    _transport.setValue(GattSink::Characteristic::ROLLUP, page, length);
+    _rollupDirty = false;
+}
+
+// --- 生产者 (任意任务) ---
+
+bool BlePeripheral::updateHeartRate(float heartRate, uint32_t timestamp) {
+    Message message;
+    message.type = Message::HEART_RATE;
+    message.timestamp = timestamp;
+    message.value = heartRate;
+    return _messages.tryPush(message);
+}
+
+bool BlePeripheral::updateSpO2(float spO2, uint32_t timestamp) {
+    Message message;
+    message.type = Message::SPO2;
+    message.timestamp = timestamp;
+    message.value = spO2;
+    return _messages.tryPush(message);
+}
+
+bool BlePeripheral::updateGlucose(float glucose, uint32_t timestamp) {
+    Message message;
+    message.type = Message::GLUCOSE;
+    message.timestamp = timestamp;
+    message.value = glucose;
+    return _messages.tryPush(message);
+}
+
+bool BlePeripheral::updatePredictionCurve(const float* curveData, int curveSize, const float* lower, const float* upper) {
+    Message message;
+    message.type = Message::CURVE;
+    int size = curveSize < 0 ? 0 : (curveSize > kMaxCurvePoints ? kMaxCurvePoints : curveSize);
+    message.curveSize = (uint8_t)size;
+    message.hasInterval = lower != nullptr && upper != nullptr;
+    for (int i = 0; i < size; i++) {
+        message.curve[i] = curveData[i];
+        message.lower[i] = message.hasInterval ? lower[i] : curveData[i];
+        message.upper[i] = message.hasInterval ? upper[i] : curveData[i];
+    }
+    return _messages.tryPush(message);
+}
+
+bool BlePeripheral::addGlucoseRecord(uint32_t timestamp, float glucose) {
+    Message message;
+    message.type = Message::RECORD;
+    message.timestamp = timestamp;
+    message.value = glucose;
+    return _messages.tryPush(message);
+}
+
+bool BlePeripheral::addReading(uint32_t timestamp, float glucose) {
+    Message message;
+    message.type = Message::READING;
+    message.timestamp = timestamp;
+    message.value = glucose;
+    return _messages.tryPush(message);
+}
+
+void BlePeripheral::addPpgSample(uint32_t ir, uint32_t red, uint32_t timestampMs) {
+    if (!_ppg.isEnabled()) {
+        return;
+    }
+    Sample sample = { WaveformCodec::STREAM_PPG, timestampMs, { (int32_t)ir, (int32_t)red } };
+    _samples.tryPush(sample);
+}
+
+void BlePeripheral::addOpticalSample(uint16_t raw, uint32_t timestampMs) {
+    if (!_optical.isEnabled()) {
+        return;
+    }
+    Sample sample = { WaveformCodec::STREAM_OPTICAL, timestampMs, { raw, 0 } };
+    _samples.tryPush(sample);
+}
+
+bool BlePeripheral::isWaveformStreaming() const {
+    return _ppg.isEnabled() || _optical.isEnabled();
+}
+
+const WaveformStreamer& BlePeripheral::getPpgStreamer() const {
+    return _ppg;
+}
+
+const WaveformStreamer& BlePeripheral::getOpticalStreamer() const {
+    return _optical;
+}
+
+void BlePeripheral::poll(uint32_t nowMs, uint32_t timestamp) {
+    // 事件先于消息处理: 新连接的快照包含随后排队的数值
+    Event event;
+    while (_events.tryPop(&event)) {
+        handleEvent(event);
+    }
+    if (_eventsLost.exchange(false)) {
+        // 事件队列溢出，丢失的 (最新的) 事件无法重放: 按当前的连接状态从头开始，MTU 回到默认值
+        Event resync = { _transport.isConnected() ? Event::CONNECTED : Event::DISCONNECTED, 0, 0 };
+        handleEvent(resync);
+    }
+    Message message;
+    while (_messages.tryPop(&message)) {
+        handleMessage(message);
+    }
+    Sample sample;
+    while (_samples.tryPop(&sample)) {
+        if (sample.stream == WaveformCodec::STREAM_PPG) {
+            _ppg.addSample(sample.values, sample.timestampMs);
+        } else {
+            _optical.addSample(sample.values, sample.timestampMs);
+        }
+    }
+    if (_rollupDirty) {
+        refreshRollupPage();
+    }
+
+    if (_config.compositeNotifications && _transport.isConnected()) {
+        _vitals.poll(nowMs, timestamp, _transport);
+    }
+    // 数据流关闭 (包括断开连接) 后，poll() 丢弃缓冲区中剩余的样本
+    _ppg.poll(_transport);
+    _optical.poll(_transport);
+    _glucoseService.poll();
+}
+
+BlePeripheral::QueueStats BlePeripheral::getQueueStats() const {
+    QueueStats stats = {
+        _messages.highWaterMark(), _samples.highWaterMark(), _events.highWaterMark(),
+        _messages.droppedCount(), _samples.droppedCount(), _events.droppedCount()
+    };
+    return stats;
+}
+
+const VitalsPublisher& BlePeripheral::getVitals() const {
+    return _vitals;
+}
+
+RollupEngine& BlePeripheral::getRollups() {
+    return _rollups;
+}
+
+GlucoseRecordStore& BlePeripheral::getRecords() {
+    return _records;
+}
@@ -0,0 +1,148 @@
+#include "FilePartition.h"
+#include <string.h>
+
+FilePartition::FilePartition(const char* path, uint32_t size) :
+    _path(path),
+    _size(size / kSectorSize * kSectorSize),
+    _file(nullptr),
+    _powerLossArmed(false),
+    _powerLossBudget(0),
+    _poweredOff(false),
+    _bytesWritten(0)
+{
+    if (_size > kMaxSectors * kSectorSize) {
+        _size = kMaxSectors * kSectorSize;
+    }
+    memset(_eraseCounts, 0, sizeof(_eraseCounts));
+}
+
+FilePartition::~FilePartition() {
+    close();
+}
+
+bool FilePartition::open() {
+    close();
+    _file = fopen(_path, "r+b");
+    if (_file == nullptr) {
+        _file = fopen(_path, "w+b");
+        if (_file == nullptr) {
+            return false;
+        }
+    }
+    fseek(_file, 0, SEEK_END);
+    long length = ftell(_file);
+    if (length < (long)_size) {
+        uint8_t erased[256];
+        memset(erased, 0xFF, sizeof(erased));
+        for (long pos = length; pos < (long)_size; pos += sizeof(erased)) {
+            size_t n = (long)_size - pos < (long)sizeof(erased) ? (size_t)(_size - pos) : sizeof(erased);
+            if (fwrite(erased, 1, n, _file) != n) {
+                close();
+                return false;
+            }
+        }
+        fflush(_file);
+    }
+    return true;
+}
+
+void FilePartition::close() {
+    if (_file != nullptr) {
+        fclose(_file);
+        _file = nullptr;
+    }
+}
+
+uint32_t FilePartition::size() const {
+    return _size;
+}
+
+bool FilePartition::read(uint32_t offset, void* out, size_t length) {
+    if (_file == nullptr || _poweredOff || offset > _size || length > _size - offset) {
+        return false;
+    }
+    return fseek(_file, (long)offset, SEEK_SET) == 0 && fread(out, 1, length, _file) == length;
+}
+
+size_t FilePartition::consumeBudget(size_t length) {
+    if (!_powerLossArmed) {
+        return length;
+    }
+    if (length < _powerLossBudget) {
+        _powerLossBudget -= (uint32_t)length;
+        return length;
+    }
+    size_t done = _powerLossBudget;
+    _powerLossBudget = 0;
+    _poweredOff = true;
+    return done;
+}
+
+bool FilePartition::write(uint32_t offset, const void* data, size_t length) {
+    if (_file == nullptr || _poweredOff || offset > _size || length > _size - offset) {
+        return false;
+    }
+    size_t done = consumeBudget(length);
+    // NOR flash: 写入只能清除位
+    const uint8_t* src = (const uint8_t*)data;
+    uint8_t chunk[256];
+    for (size_t pos = 0; pos < done; pos += sizeof(chunk)) {
+        size_t n = done - pos < sizeof(chunk) ? done - pos : sizeof(chunk);
+        if (fseek(_file, (long)(offset + pos), SEEK_SET) != 0 || fread(chunk, 1, n, _file) != n) {
+            return false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            chunk[i] &= src[pos + i];
+        }
+        if (fseek(_file, (long)(offset + pos), SEEK_SET) != 0 || fwrite(chunk, 1, n, _file) != n) {
+            return false;
+        }
+    }
+    fflush(_file);
+    _bytesWritten += (uint32_t)done;
+    return done == length;
+}
+
+bool FilePartition::eraseSector(uint32_t offset) {
+    if (_file == nullptr || _poweredOff || offset % kSectorSize != 0 || offset >= _size) {
+        return false;
+    }
+    // 中断的擦除只把扇区前面的部分置为0xFF，其余保持原内容
+    size_t done = consumeBudget(kSectorSize);
+    uint8_t erased[256];
+    memset(erased, 0xFF, sizeof(erased));
+    if (fseek(_file, (long)offset, SEEK_SET) != 0) {
+        return false;
+    }
+    for (size_t pos = 0; pos < done; pos += sizeof(erased)) {
+        size_t n = done - pos < sizeof(erased) ? done - pos : sizeof(erased);
+        if (fwrite(erased, 1, n, _file) != n) {
+            return false;
+        }
+    }
+    fflush(_file);
+    _eraseCounts[offset / kSectorSize]++;
+    return done == kSectorSize;
+}
+
+void FilePartition::setPowerLossAfter(uint32_t bytes) {
+    _powerLossArmed = true;
+    _powerLossBudget = bytes;
+}
+
+void FilePartition::powerCycle() {
+    _powerLossArmed = false;
+    _poweredOff = false;
+}
+
+bool FilePartition::isPoweredOff() const {
+    return _poweredOff;
+}
+
+uint32_t FilePartition::getEraseCount(uint32_t sector) const {
+    return sector < kMaxSectors ? _eraseCounts[sector] : 0;
+}
+
+uint32_t FilePartition::getBytesWritten() const {
+    return _bytesWritten;
+}
@@ -1,5 +1,9 @@
 #include <GlucoseCalculator.h>
 #include <config.h> // 引入配置文件以使用校准参数
+#include <LedController.h>
+#include <DemodulatorController.h>
+#include <SequentialEstimator.h>
+#include <TraceLog.h>
 
 // 获取单例实例
 GlucoseCalculator& GlucoseCalculator::getInstance() {
@@ -10,16 +14,20 @@ GlucoseCalculator& GlucoseCalculator::getInstance() {
 // 私有构造函数
 GlucoseCalculator::GlucoseCalculator() :
     _latestGlucoseValue(0.0f),
-    _currentStatus(Status::IDLE)
+    _signalQuality(0.0f),
+    _filter(GLUCOSE_FILTER_PROCESS_NOISE, GLUCOSE_FILTER_MEASUREMENT_NOISE, GLUCOSE_FILTER_MAX_GAP_MS),
+    _currentStatus(Status::IDLE),
+    _capture(nullptr)
 {
+    _lastReport = {0, 0, NAN, 0, false};
 }
 
 void GlucoseCalculator::begin() {
-    // 可以在这里进行一些初始化，目前为空
+    _filter.reset();
     _currentStatus = Status::IDLE;
 }
 
-GlucoseCalculator::Status GlucoseCalculator::performMeasurement() {
+GlucoseCalculator::Status GlucoseCalculator::checkPreconditions() {
     _currentStatus = Status::MEASURING;
 
     // 1. 更新所有传感器数据
@@ -34,7 +42,16 @@ GlucoseCalculator::Status GlucoseCalculator::performMeasurement() {
         _currentStatus = Status::ERROR_NO_FINGER;
         return _currentStatus;
     }
-    
+    return _currentStatus;
+}
+
+GlucoseCalculator::Status GlucoseCalculator::performMeasurement() {
+    TRACE_SCOPE(MEASUREMENT);
+    uint32_t startTime = now();
+    if (checkPreconditions() != Status::MEASURING) {
+        return _currentStatus;
+    }
+
     // 3. 获取所有需要的输入数据
     float mainSignal = SignalReader::getInstance().getVoltage();
     float temp = Dht22Controller::getInstance().getTemperature();
@@ -44,18 +61,163 @@ GlucoseCalculator::Status GlucoseCalculator::performMeasurement() {
     // 4. 调用核心算法进行计算
     _latestGlucoseValue = calculate(mainSignal, temp, ir, hr);
 
+    // 5. 按信号质量加权，融合进平滑滤波器
+    _signalQuality = estimateSignalQuality(ir, hr);
+    _filter.update(_latestGlucoseValue, now(), _signalQuality);
+
+    _lastReport = {1, ADC_SAMPLES_TO_AVERAGE, NAN, now() - startTime, false};
+    _currentStatus = Status::SUCCESS;
+    return _currentStatus;
+}
+
+GlucoseCalculator::Status GlucoseCalculator::performAdaptiveMeasurement(float toleranceMgdl, unsigned long timeBudgetMs) {
+    TRACE_SCOPE_ARG(ADAPTIVE_MEASUREMENT, timeBudgetMs);
+    uint32_t startTime = now();
+    if (checkPreconditions() != Status::MEASURING) {
+        return _currentStatus;
+    }
+
+#if ADAPTIVE_GATE_OPTICS
+    // 只在测量期间点亮LED并输出解调参考信号
+    LedController::getInstance().startPulsing();
+    DemodulatorController::getInstance().start();
+    pause(OPTICAL_SETTLE_MS);
+#endif
+
+    SequentialEstimator::Config config = {
+        toleranceMgdl,
+        (uint32_t)timeBudgetMs,
+        ADAPTIVE_MIN_SUBMEASUREMENTS,
+        ADAPTIVE_MAX_SUBMEASUREMENTS
+    };
+    SequentialEstimator estimator(config);
+
+    float temp = Dht22Controller::getInstance().getTemperature();
+    float qualitySum = 0.0f;
+    SequentialEstimator::StopReason reason = SequentialEstimator::StopReason::NONE;
+
+    // 逐个采集子测量，直到满足停止条件
+    while (reason == SequentialEstimator::StopReason::NONE) {
+        Max30102Controller::getInstance().update();
+        float mainSignal = SignalReader::getInstance().getVoltage(ADAPTIVE_ADC_SAMPLES);
+        uint32_t ir = Max30102Controller::getInstance().getIRValue();
+        float hr = Max30102Controller::getInstance().getHeartRate();
+
+        estimator.add(calculate(mainSignal, temp, ir, hr));
+        qualitySum += estimateSignalQuality(ir, hr);
+
+        reason = estimator.shouldStop(now() - startTime);
+        if (reason == SequentialEstimator::StopReason::NONE) {
+            pause(ADAPTIVE_SUBMEASUREMENT_INTERVAL_MS);
+        }
+    }
+
+#if ADAPTIVE_GATE_OPTICS
+    LedController::getInstance().stopPulsing();
+    DemodulatorController::getInstance().stop();
+#endif
+
+    // 手指在子测量过程中移开时，本次结果无效
+    if (!Max30102Controller::getInstance().isFingerDetected()) {
+        _currentStatus = Status::ERROR_NO_FINGER;
+        return _currentStatus;
+    }
+
+    uint16_t n = estimator.getCount();
+    _latestGlucoseValue = estimator.getMean();
+    if (_latestGlucoseValue < 0) {
+        _latestGlucoseValue = 0;
+    }
+    _signalQuality = qualitySum / n;
+
+    // 测量噪声: 按信号质量缩放的单次读数噪声，加上子测量均值的标准误差
+    float halfWidth = estimator.getHalfWidth();
+    float standardError = n >= 2 ? sqrtf(estimator.getVariance() / n) : 0.0f;
+    _filter.update(_latestGlucoseValue, now(), _signalQuality, standardError);
+
+    _lastReport = {
+        n,
+        (uint32_t)n * ADAPTIVE_ADC_SAMPLES,
+        halfWidth,
+        now() - startTime,
+        reason == SequentialEstimator::StopReason::CONVERGED
+    };
     _currentStatus = Status::SUCCESS;
     return _currentStatus;
 }
 
+const GlucoseCalculator::MeasurementReport& GlucoseCalculator::getLastReport() const {
+    return _lastReport;
+}
+
 float GlucoseCalculator::getLatestGlucoseValue() const {
     return _latestGlucoseValue;
 }
 
+float GlucoseCalculator::getSmoothedGlucoseValue() const {
+    return _filter.getGlucose();
+}
+
+float GlucoseCalculator::getGlucoseVelocity() const {
+    return _filter.getVelocity();
+}
+
+float GlucoseCalculator::getGlucoseConfidence() const {
+    return _filter.getConfidenceHalfWidth();
+}
+
+float GlucoseCalculator::getSignalQuality() const {
+    return _signalQuality;
+}
+
+unsigned long GlucoseCalculator::getRecommendedIntervalMs() const {
+    // 至少融合3次读数后才信任置信区间，避免初始化阶段过早降频
+    if (_filter.getUpdateCount() >= 3 && _filter.getConfidenceHalfWidth() < GLUCOSE_FILTER_STABLE_CI) {
+        return MEASUREMENT_INTERVAL_STABLE_MS;
+    }
+    return MEASUREMENT_INTERVAL_MS;
+}
+
+GlucoseFilter::State GlucoseCalculator::getFilterState() const {
+    return _filter.getState();
+}
+
+void GlucoseCalculator::restoreFilterState(const GlucoseFilter::State& state) {
+    _filter.setState(state);
+}
+
 GlucoseCalculator::Status GlucoseCalculator::getCurrentStatus() const {
     return _currentStatus;
 }
 
+void GlucoseCalculator::setCapture(SensorCapture* capture) {
+    _capture = capture;
+}
+
+uint32_t GlucoseCalculator::now() {
+    return _capture != nullptr ? _capture->clock(millis()) : millis();
+}
+
+void GlucoseCalculator::pause(unsigned long ms) {
+    if (_capture == nullptr || !_capture->isReplaying()) {
+        delay(ms);
+    }
+}
+
+float GlucoseCalculator::estimateSignalQuality(uint32_t irValue, float heartRate) const {
+    // 灌流分量: IR读数在手指检测阈值(50000)附近时质量最低，达到150000以上视为充分灌流
+    float perfusion = ((float)irValue - 50000.0f) / 100000.0f;
+    if (perfusion < 0.0f) perfusion = 0.0f;
+    if (perfusion > 1.0f) perfusion = 1.0f;
+
+    // 心率无效(为0)通常意味着运动伪影或接触不良，质量减半
+    float quality = 0.2f + 0.8f * perfusion;
+    if (heartRate <= 0.0f) {
+        quality *= 0.5f;
+    }
+    return quality;
+}
+
 
 // =======================================================================
 // ==                     核心算法占位符 (Placeholder)                     ==
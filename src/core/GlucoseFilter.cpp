@@ -0,0 +1,120 @@
+#include "GlucoseFilter.h"
+#include <math.h>
+
+namespace {
+    // 质量下限，防止质量为0时测量噪声趋于无穷
+    constexpr float kMinQuality = 0.05f;
+    // 初始化时变化率的先验方差 ((mg/dL/min)^2)，对应约 ±2 mg/dL/min 的标准差
+    constexpr float kInitialVelocityVariance = 4.0f;
+    // 95% 置信区间对应的正态分位数
+    constexpr float kZ95 = 1.96f;
+}
+
+GlucoseFilter::GlucoseFilter(float processNoise, float measurementNoise, uint32_t maxGapMs) :
+    _q(processNoise),
+    _r0(measurementNoise * measurementNoise),
+    _maxGapMs(maxGapMs)
+{
+    reset();
+}
+
+void GlucoseFilter::reset() {
+    _glucose = 0.0f;
+    _velocity = 0.0f;
+    _p00 = 0.0f;
+    _p01 = 0.0f;
+    _p11 = 0.0f;
+    _lastTimestampMs = 0;
+    _updateCount = 0;
+    _initialized = false;
+}
+
+void GlucoseFilter::update(float measurement, uint32_t timestampMs, float quality, float standardError) {
+    // 根据信号质量缩放测量噪声: R = R0 / q^2，再加上测量值自身的抽样方差
+    if (isnan(quality) || quality < kMinQuality) quality = kMinQuality;
+    if (quality > 1.0f) quality = 1.0f;
+    if (isnan(standardError) || standardError < 0.0f) standardError = 0.0f;
+    fuse(measurement, timestampMs, _r0 / (quality * quality) + standardError * standardError);
+}
+
+void GlucoseFilter::fuse(float measurement, uint32_t timestampMs, float r) {
+    if (isnan(measurement)) {
+        return;
+    }
+
+    // 1. 首次测量或间隔过长: 直接用测量值初始化
+    uint32_t elapsedMs = timestampMs - _lastTimestampMs; // 无符号减法可正确处理 millis() 回绕
+    if (!_initialized || elapsedMs > _maxGapMs) {
+        _glucose = measurement;
+        _velocity = 0.0f;
+        _p00 = r;
+        _p01 = 0.0f;
+        _p11 = kInitialVelocityVariance;
+        _lastTimestampMs = timestampMs;
+        _updateCount = 1;
+        _initialized = true;
+        return;
+    }
+
+    // 2. 预测: x = F x, P = F P F' + Q  (F = [1 dt; 0 1], dt 单位为分钟)
+    const float dt = elapsedMs / 60000.0f;
+    _glucose += _velocity * dt;
+
+    const float dt2 = dt * dt;
+    const float p00 = _p00 + 2.0f * dt * _p01 + dt2 * _p11 + _q * dt2 * dt / 3.0f;
+    const float p01 = _p01 + dt * _p11 + _q * dt2 / 2.0f;
+    const float p11 = _p11 + _q * dt;
+
+    // 3. 校正: H = [1 0]
+    const float s = p00 + r;          // 新息方差
+    const float k0 = p00 / s;         // 卡尔曼增益
+    const float k1 = p01 / s;
+    const float innovation = measurement - _glucose;
+
+    _glucose += k0 * innovation;
+    _velocity += k1 * innovation;
+
+    // P = (I - K H) P
+    _p00 = (1.0f - k0) * p00;
+    _p01 = (1.0f - k0) * p01;
+    _p11 = p11 - k1 * p01;
+
+    _lastTimestampMs = timestampMs;
+    _updateCount++;
+}
+
+bool GlucoseFilter::isInitialized() const {
+    return _initialized;
+}
+
+float GlucoseFilter::getGlucose() const {
+    return _glucose;
+}
+
+float GlucoseFilter::getVelocity() const {
+    return _velocity;
+}
+
+float GlucoseFilter::getConfidenceHalfWidth() const {
+    return kZ95 * sqrtf(_p00 > 0.0f ? _p00 : 0.0f);
+}
+
+uint32_t GlucoseFilter::getUpdateCount() const {
+    return _updateCount;
+}
+
+GlucoseFilter::State GlucoseFilter::getState() const {
+    State s = { _initialized, _glucose, _velocity, _p00, _p01, _p11, _lastTimestampMs, _updateCount };
+    return s;
+}
+
+void GlucoseFilter::setState(const State& state) {
+    _initialized = state.initialized;
+    _glucose = state.glucose;
+    _velocity = state.velocity;
+    _p00 = state.p00;
+    _p01 = state.p01;
+    _p11 = state.p11;
+    _lastTimestampMs = state.lastTimestampMs;
+    _updateCount = state.updateCount;
+}
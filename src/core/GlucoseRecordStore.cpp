@@ -0,0 +1,80 @@
+#include "GlucoseRecordStore.h"
+#include "ByteOrder.h"
+
+GlucoseRecordStore::GlucoseRecordStore() :
+    _head(0),
+    _count(0),
+    _nextSequence(0),
+    _sequenceStore(nullptr),
+    _sequenceKey(nullptr),
+    _reservedSequence(0)
+{
+}
+
+void GlucoseRecordStore::restoreSequence(KeyValueStore& store, const char* key) {
+    uint8_t raw[2];
+    if (store.getBytes(key, raw, sizeof(raw)) == sizeof(raw)) {
+        _nextSequence = ByteOrder::readU16(raw);
+    }
+    _sequenceStore = &store;
+    _sequenceKey = key;
+    // 下一次 add() 先预留
+    _reservedSequence = _nextSequence;
+}
+
+uint16_t GlucoseRecordStore::nextSequence() const {
+    return _nextSequence;
+}
+
+uint16_t GlucoseRecordStore::add(uint32_t timestamp, float glucose) {
+    if (_count > 0 && _nextSequence == 0) {
+        // 序号回绕: 旧记录的序号会大于新记录，清空后重新开始
+        clear();
+    }
+    if (_sequenceStore != nullptr && _nextSequence == _reservedSequence) {
+        // 先写入再使用: 掉电后从预留块的末尾继续，不会重复分配已经上报过的序号
+        _reservedSequence = (uint16_t)(_nextSequence + kSequenceReserve);
+        uint8_t raw[2];
+        ByteOrder::writeU16(raw, _reservedSequence);
+        _sequenceStore->putBytes(_sequenceKey, raw, sizeof(raw));
+    }
+    int slot = (_head + _count) % kCapacity;
+    if (_count == kCapacity) {
+        _head = (_head + 1) % kCapacity;
+    } else {
+        _count++;
+    }
+    Record& r = _records[slot];
+    r.sequence = _nextSequence++;
+    r.timestamp = timestamp;
+    r.glucose = glucose;
+    return r.sequence;
+}
+
+void GlucoseRecordStore::clear() {
+    _head = 0;
+    _count = 0;
+}
+
+int GlucoseRecordStore::count() const {
+    return _count;
+}
+
+const GlucoseRecordStore::Record& GlucoseRecordStore::at(int index) const {
+    return _records[(_head + index) % kCapacity];
+}
+
+int GlucoseRecordStore::lowerBound(uint16_t sequence) const {
+    // 存储中的序号严格递增，二分查找
+    int lo = 0;
+    int hi = _count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (at(mid).sequence < sequence) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
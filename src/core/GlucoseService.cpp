@@ -0,0 +1,310 @@
+#include "GlucoseService.h"
+#include "ByteOrder.h"
+#include "BleEncoding.h"
+#include <string.h>
+#include <time.h>
+
+namespace {
+    // Glucose Measurement flags
+    constexpr uint8_t kFlagConcentrationPresent = 0x02;    // 浓度、类型与采样位置存在，单位 kg/L
+    constexpr uint8_t kFlagContextFollows = 0x10;
+
+    // 类型: 未确定的全血 (非侵入式测量)；采样位置: 手指
+    constexpr uint8_t kTypeUndeterminedWholeBlood = 0x07;
+    constexpr uint8_t kLocationFinger = 0x01;
+
+    // Context flags: 只含 测试者/健康状况 字节；测试者为本人，健康状况不可用
+    constexpr uint8_t kContextFlagTesterHealth = 0x04;
+    constexpr uint8_t kTesterSelf = 0x01;
+    constexpr uint8_t kHealthNotAvailable = 0x0F;
+
+    // 1 mg/dL = 1e-5 kg/L
+    constexpr float kMgdlToKgPerL = 1e-5f;
+}
+
+GlucoseService::GlucoseService(GlucoseRecordStore& store, GattSink& sink, int recordsPerPoll) :
+    _store(store),
+    _sink(sink),
+    _recordsPerPoll(recordsPerPoll > 0 ? recordsPerPoll : 1),
+    _requestLength(0),
+    _hasRequest(false),
+    _resetPending(false),
+    _reporting(false),
+    _cursor(0),
+    _last(0),
+    _contextPending(false),
+    _responseLength(0)
+{
+}
+
+void GlucoseService::handleRacpWrite(const uint8_t* data, size_t length) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // 过长的请求截断后仍交给 processRequest，由其按长度判为无效操作数
+    _requestLength = length < (size_t)kMaxRequestSize ? length : (size_t)kMaxRequestSize;
+    memcpy(_request, data, _requestLength);
+    _hasRequest = true;
+}
+
+void GlucoseService::reset() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _hasRequest = false;
+    _resetPending = true;
+}
+
+bool GlucoseService::isReporting() const {
+    return _reporting;
+}
+
+void GlucoseService::poll() {
+    uint8_t request[kMaxRequestSize];
+    size_t length = 0;
+    bool hasRequest = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_resetPending) {
+            _resetPending = false;
+            _reporting = false;
+            _contextPending = false;
+            _responseLength = 0;
+        }
+        if (_hasRequest) {
+            memcpy(request, _request, _requestLength);
+            length = _requestLength;
+            hasRequest = true;
+            _hasRequest = false;
+        }
+    }
+
+    // 上一个响应还没发出时先不处理新请求 (请求留在局部变量中会丢失，因此放回邮箱)
+    if (!flushResponse()) {
+        if (hasRequest) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_hasRequest) {
+                memcpy(_request, request, length);
+                _requestLength = length;
+                _hasRequest = true;
+            }
+        }
+        return;
+    }
+    if (hasRequest) {
+        processRequest(request, length);
+        flushResponse();
+    }
+    if (_reporting && _responseLength == 0) {
+        sendRecords();
+        flushResponse();
+    }
+}
+
+void GlucoseService::processRequest(const uint8_t* request, size_t length) {
+    if (length < 2) {
+        respond(length > 0 ? request[0] : 0, RESPONSE_INVALID_OPERAND);
+        return;
+    }
+    uint8_t opCode = request[0];
+    uint8_t op = request[1];
+
+    if (opCode == OP_ABORT) {
+        if (op != OPERATOR_NULL || length != 2) {
+            respond(opCode, RESPONSE_INVALID_OPERATOR);
+            return;
+        }
+        _reporting = false;
+        _contextPending = false;
+        respond(opCode, RESPONSE_SUCCESS);
+        return;
+    }
+    if (opCode != OP_REPORT_RECORDS && opCode != OP_DELETE_RECORDS && opCode != OP_REPORT_NUMBER) {
+        respond(opCode, RESPONSE_OP_CODE_NOT_SUPPORTED);
+        return;
+    }
+    if (_reporting) {
+        // 一次只能进行一个上报，客户端应先等待完成或发送中止
+        respond(opCode, RESPONSE_PROCEDURE_NOT_COMPLETED);
+        return;
+    }
+
+    uint16_t first = 0;
+    uint16_t last = 0;
+    ResponseCode rc = parseRange(request, length, &first, &last);
+    if (rc != RESPONSE_SUCCESS) {
+        respond(opCode, rc);
+        return;
+    }
+    int count = countInRange(first, last);
+
+    switch (opCode) {
+        case OP_REPORT_NUMBER:
+            respondNumber((uint16_t)count);
+            break;
+        case OP_DELETE_RECORDS:
+            // 环形缓冲区只支持整体删除
+            if (op != OPERATOR_ALL) {
+                respond(opCode, RESPONSE_OPERATOR_NOT_SUPPORTED);
+                break;
+            }
+            _store.clear();
+            respond(opCode, RESPONSE_SUCCESS);
+            break;
+        default:
+            if (count == 0) {
+                respond(opCode, RESPONSE_NO_RECORDS_FOUND);
+                break;
+            }
+            _reporting = true;
+            _contextPending = false;
+            _cursor = first;
+            _last = last;
+            break;
+    }
+}
+
+GlucoseService::ResponseCode GlucoseService::parseRange(const uint8_t* request, size_t length,
+                                                        uint16_t* first, uint16_t* last) const {
+    uint8_t op = request[1];
+    bool empty = _store.count() == 0;
+    uint16_t oldest = empty ? 0 : _store.at(0).sequence;
+    uint16_t newest = empty ? 0 : _store.at(_store.count() - 1).sequence;
+
+    switch (op) {
+        case OPERATOR_NULL:
+            return RESPONSE_INVALID_OPERATOR;
+        case OPERATOR_ALL:
+        case OPERATOR_FIRST:
+        case OPERATOR_LAST:
+            if (length != 2) {
+                return RESPONSE_INVALID_OPERAND;
+            }
+            *first = op == OPERATOR_LAST ? newest : oldest;
+            *last = op == OPERATOR_FIRST ? oldest : newest;
+            return RESPONSE_SUCCESS;
+        case OPERATOR_LESS_OR_EQUAL:
+        case OPERATOR_GREATER_OR_EQUAL:
+        case OPERATOR_RANGE: {
+            size_t expected = op == OPERATOR_RANGE ? 7 : 5;
+            if (length < 3) {
+                return RESPONSE_INVALID_OPERAND;
+            }
+            if (request[2] == kFilterUserFacingTime) {
+                return RESPONSE_OPERAND_NOT_SUPPORTED;
+            }
+            if (request[2] != kFilterSequenceNumber || length != expected) {
+                return RESPONSE_INVALID_OPERAND;
+            }
+            uint16_t a = ByteOrder::readU16(request + 3);
+            if (op == OPERATOR_LESS_OR_EQUAL) {
+                *first = 0;
+                *last = a;
+            } else if (op == OPERATOR_GREATER_OR_EQUAL) {
+                *first = a;
+                *last = 0xFFFF;
+            } else {
+                uint16_t b = ByteOrder::readU16(request + 5);
+                if (a > b) {
+                    return RESPONSE_INVALID_OPERAND;
+                }
+                *first = a;
+                *last = b;
+            }
+            return RESPONSE_SUCCESS;
+        }
+        default:
+            return RESPONSE_OPERATOR_NOT_SUPPORTED;
+    }
+}
+
+int GlucoseService::countInRange(uint16_t first, uint16_t last) const {
+    if (_store.count() == 0) {
+        return 0;
+    }
+    int begin = _store.lowerBound(first);
+    int end = last == 0xFFFF ? _store.count() : _store.lowerBound((uint16_t)(last + 1));
+    return end > begin ? end - begin : 0;
+}
+
+void GlucoseService::sendRecords() {
+    for (int sent = 0; sent < _recordsPerPoll; sent++) {
+        // 按序号定位，上报期间被覆盖的旧记录自动跳过
+        int index = _cursor > 0xFFFF ? _store.count() : _store.lowerBound((uint16_t)_cursor);
+        if (index >= _store.count() || _store.at(index).sequence > _last) {
+            _reporting = false;
+            respond(OP_REPORT_RECORDS, RESPONSE_SUCCESS);
+            return;
+        }
+        const GlucoseRecordStore::Record& record = _store.at(index);
+        if (!_contextPending) {
+            uint8_t measurement[kMeasurementSize];
+            encodeMeasurement(record, measurement, sizeof(measurement));
+            if (!_sink.send(GattSink::Characteristic::MEASUREMENT, measurement, sizeof(measurement))) {
+                return;
+            }
+            _contextPending = true;
+        }
+        uint8_t context[kContextSize];
+        encodeContext(record, context, sizeof(context));
+        if (!_sink.send(GattSink::Characteristic::CONTEXT, context, sizeof(context))) {
+            return;
+        }
+        _contextPending = false;
+        _cursor = (uint32_t)record.sequence + 1;
+    }
+}
+
+void GlucoseService::respond(uint8_t requestOpCode, uint8_t responseCode) {
+    _response[0] = OP_RESPONSE_CODE;
+    _response[1] = OPERATOR_NULL;
+    _response[2] = requestOpCode;
+    _response[3] = responseCode;
+    _responseLength = 4;
+}
+
+void GlucoseService::respondNumber(uint16_t count) {
+    _response[0] = OP_NUMBER_RESPONSE;
+    _response[1] = OPERATOR_NULL;
+    ByteOrder::writeU16(_response + 2, count);
+    _responseLength = 4;
+}
+
+bool GlucoseService::flushResponse() {
+    if (_responseLength == 0) {
+        return true;
+    }
+    if (!_sink.send(GattSink::Characteristic::RACP, _response, _responseLength)) {
+        return false;
+    }
+    _responseLength = 0;
+    return true;
+}
+
+size_t GlucoseService::encodeMeasurement(const GlucoseRecordStore::Record& record, uint8_t* out, size_t capacity) {
+    if (capacity < kMeasurementSize) {
+        return 0;
+    }
+    time_t t = (time_t)record.timestamp;
+    struct tm utc;
+    gmtime_r(&t, &utc);
+
+    out[0] = kFlagConcentrationPresent | kFlagContextFollows;
+    ByteOrder::writeU16(out + 1, record.sequence);
+    // Base Time: 年 u16，月、日、时、分、秒各 u8
+    ByteOrder::writeU16(out + 3, (uint16_t)(utc.tm_year + 1900));
+    out[5] = (uint8_t)(utc.tm_mon + 1);
+    out[6] = (uint8_t)utc.tm_mday;
+    out[7] = (uint8_t)utc.tm_hour;
+    out[8] = (uint8_t)utc.tm_min;
+    out[9] = (uint8_t)utc.tm_sec;
+    BleEncoding::writeSfloat(out + 10, record.glucose * kMgdlToKgPerL);
+    out[12] = (uint8_t)((kLocationFinger << 4) | kTypeUndeterminedWholeBlood);
+    return kMeasurementSize;
+}
+
+size_t GlucoseService::encodeContext(const GlucoseRecordStore::Record& record, uint8_t* out, size_t capacity) {
+    if (capacity < kContextSize) {
+        return 0;
+    }
+    out[0] = kContextFlagTesterHealth;
+    ByteOrder::writeU16(out + 1, record.sequence);
+    out[3] = (uint8_t)((kHealthNotAvailable << 4) | kTesterSelf);
+    return kContextSize;
+}
@@ -0,0 +1,63 @@
+#include "LatencyStats.h"
+#include <algorithm>
+#include <math.h>
+
+LatencyStats::LatencyStats() :
+    _count(0),
+    _sorted(true)
+{
+}
+
+void LatencyStats::clear() {
+    _count = 0;
+    _sorted = true;
+}
+
+bool LatencyStats::add(uint32_t us) {
+    if (_count >= kMaxSamples) {
+        return false;
+    }
+    _samples[_count++] = us;
+    _sorted = false;
+    return true;
+}
+
+int LatencyStats::count() const {
+    return _count;
+}
+
+void LatencyStats::sort() {
+    if (!_sorted) {
+        std::sort(_samples, _samples + _count);
+        _sorted = true;
+    }
+}
+
+uint32_t LatencyStats::percentile(float p) {
+    if (_count == 0) {
+        return 0;
+    }
+    sort();
+    int rank = (int)ceilf(p / 100.0f * _count);
+    if (rank < 1) rank = 1;
+    if (rank > _count) rank = _count;
+    return _samples[rank - 1];
+}
+
+LatencyStats::Summary LatencyStats::summarize() {
+    Summary s = { _count, 0, 0, 0, 0, 0, 0 };
+    if (_count == 0) {
+        return s;
+    }
+    uint64_t total = 0;
+    for (int i = 0; i < _count; i++) {
+        total += _samples[i];
+    }
+    s.p50Us = percentile(50.0f);
+    s.p90Us = percentile(90.0f);
+    s.p99Us = percentile(99.0f);
+    s.minUs = _samples[0];
+    s.maxUs = _samples[_count - 1];
+    s.meanUs = (uint32_t)(total / _count);
+    return s;
+}
@@ -0,0 +1,167 @@
+#include "ModelImage.h"
+#include "ByteOrder.h"
+#include <string.h>
+#include <math.h>
+
+namespace ModelImage {
+
+namespace {
+    // 半字节查表法的CRC32 (多项式 0xEDB88320)，只需64字节表，适合放在MCU上
+    const uint32_t kCrcNibbleTable[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    // 头部中参与CRC计算的长度 (除最后的 headerCrc32 字段)
+    constexpr size_t kHeaderCrcOffset = 28;
+}
+
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ kCrcNibbleTable[crc & 0x0F];
+        crc = (crc >> 4) ^ kCrcNibbleTable[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+ParseResult parseHeader(const uint8_t* data, size_t partitionSize, Header* out) {
+    Header h;
+    h.magic = ByteOrder::readU32(data + 0);
+    h.headerVersion = ByteOrder::readU16(data + 4);
+    h.headerSize = ByteOrder::readU16(data + 6);
+    h.modelVersion = ByteOrder::readU32(data + 8);
+    h.modelSize = ByteOrder::readU32(data + 12);
+    h.modelCrc32 = ByteOrder::readU32(data + 16);
+    h.flags = ByteOrder::readU32(data + 20);
+
+    if (h.magic != kMagic) {
+        return ParseResult::BAD_MAGIC;
+    }
+    if (h.headerVersion != kHeaderVersion || h.headerSize != kHeaderSize) {
+        return ParseResult::BAD_VERSION;
+    }
+    if (ByteOrder::readU32(data + kHeaderCrcOffset) != crc32(data, kHeaderCrcOffset)) {
+        return ParseResult::BAD_HEADER_CRC;
+    }
+    if (h.modelSize == 0 || partitionSize < kHeaderSize || h.modelSize > partitionSize - kHeaderSize) {
+        return ParseResult::BAD_SIZE;
+    }
+
+    *out = h;
+    return ParseResult::OK;
+}
+
+void serializeHeader(const Header& header, uint8_t* out) {
+    memset(out, 0, kHeaderSize);
+    ByteOrder::writeU32(out + 0, kMagic);
+    ByteOrder::writeU16(out + 4, kHeaderVersion);
+    ByteOrder::writeU16(out + 6, (uint16_t)kHeaderSize);
+    ByteOrder::writeU32(out + 8, header.modelVersion);
+    ByteOrder::writeU32(out + 12, header.modelSize);
+    ByteOrder::writeU32(out + 16, header.modelCrc32);
+    ByteOrder::writeU32(out + 20, header.flags);
+    ByteOrder::writeU32(out + kHeaderCrcOffset, crc32(out, kHeaderCrcOffset));
+}
+
+bool verifyPayload(const Header& header, const uint8_t* payload) {
+    return crc32(payload, header.modelSize) == header.modelCrc32;
+}
+
+SlotDecision selectSlot(const SlotStatus slots[kSlotCount], const BootState& state, uint8_t maxAttempts,
+                        ModelFormat preferred) {
+    SlotDecision decision = { -1, false };
+    bool pendingInRange = state.pendingSlot >= 0 && state.pendingSlot < kSlotCount;
+    bool confirmedInRange = state.confirmedSlot >= 0 && state.confirmedSlot < kSlotCount;
+
+    // 1. 新写入的模型: 在尝试次数内进行试运行
+    if (pendingInRange && slots[state.pendingSlot].valid && state.attempts < maxAttempts) {
+        decision.slot = state.pendingSlot;
+        decision.trial = true;
+        return decision;
+    }
+
+    // 2. 按精度偏好选择 (已试运行失败的待确认槽位除外)
+    if (preferred != ModelFormat::ANY) {
+        for (int8_t i = 0; i < kSlotCount; i++) {
+            if (!slots[i].valid || slots[i].format != preferred) continue;
+            if (pendingInRange && i == state.pendingSlot) continue;
+            if (decision.slot < 0 || i == state.confirmedSlot ||
+                (decision.slot != state.confirmedSlot && slots[i].modelVersion > slots[decision.slot].modelVersion)) {
+                decision.slot = i;
+            }
+        }
+        if (decision.slot >= 0) {
+            decision.trial = decision.slot != state.confirmedSlot;
+            return decision;
+        }
+    }
+
+    // 3. 回滚到已确认的模型
+    if (confirmedInRange && slots[state.confirmedSlot].valid) {
+        decision.slot = state.confirmedSlot;
+        return decision;
+    }
+
+    // 4. 没有确认记录 (例如通过串口直接烧写分区): 选择版本最高的有效槽位，
+    //    但排除已经试运行失败的待确认槽位
+    for (int8_t i = 0; i < kSlotCount; i++) {
+        if (!slots[i].valid) continue;
+        if (pendingInRange && i == state.pendingSlot) continue;
+        if (decision.slot < 0 || slots[i].modelVersion > slots[decision.slot].modelVersion) {
+            decision.slot = i;
+        }
+    }
+    decision.trial = decision.slot >= 0;
+    return decision;
+}
+
+TrialVerdict recordTrialInference(TrialProgress* progress, const TrialPolicy& policy, bool invoked,
+                                  const float* outputs, int count) {
+    if (!invoked || outputs == nullptr || count <= 0) {
+        return TrialVerdict::REJECT;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!isfinite(outputs[i]) || outputs[i] < policy.minOutput || outputs[i] > policy.maxOutput) {
+            return TrialVerdict::REJECT;
+        }
+    }
+    if (progress->successes < policy.requiredInferences) {
+        progress->successes++;
+    }
+    return progress->successes >= policy.requiredInferences ? TrialVerdict::CONFIRM : TrialVerdict::PENDING;
+}
+
+int8_t updateTargetSlot(int8_t activeSlot, int8_t confirmedSlot) {
+    if (activeSlot < 0) {
+        return confirmedSlot == 0 ? 1 : 0;
+    }
+    int8_t target = activeSlot == 0 ? 1 : 0;
+    return target == confirmedSlot ? -1 : target;
+}
+
+int parseEnsemble(const uint8_t* payload, size_t size, EnsembleMember* members, int maxMembers) {
+    if (size < 8 || ByteOrder::readU32(payload) != kEnsembleMagic) {
+        return 0;
+    }
+    uint32_t count = ByteOrder::readU32(payload + 4);
+    if (count == 0 || count > (uint32_t)maxMembers || 8 + 8 * (size_t)count > size) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t offset = ByteOrder::readU32(payload + 8 + 8 * i);
+        uint32_t length = ByteOrder::readU32(payload + 12 + 8 * i);
+        // flatbuffer 要求模型数据对齐，成员不能与目录重叠
+        if (offset % 16 != 0 || offset < 8 + 8 * count || length == 0 || offset > size || length > size - offset) {
+            return -1;
+        }
+        members[i].data = payload + offset;
+        members[i].size = length;
+    }
+    return (int)count;
+}
+
+} // namespace ModelImage
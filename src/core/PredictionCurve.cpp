@@ -0,0 +1,95 @@
+#include "PredictionCurve.h"
+#include "ByteOrder.h"
+#include "Quantization.h"
+#include <math.h>
+
+namespace PredictionCurve {
+
+namespace {
+    // 0.1 mg/dL 为单位的 int16 可表示 ±3276.7 mg/dL，远超生理范围
+    int16_t toFixed(float mgdl) {
+        float scaled = roundf(mgdl * 10.0f);
+        if (scaled > 32767.0f) return 32767;
+        if (scaled < -32768.0f) return -32768;
+        return (int16_t)scaled;
+    }
+
+    uint8_t* writeValues(uint8_t* p, const float* values, int count) {
+        for (int i = 0; i < count; i++) {
+            ByteOrder::writeU16(p, (uint16_t)toFixed(values[i]));
+            p += 2;
+        }
+        return p;
+    }
+
+    const uint8_t* readValues(const uint8_t* p, float* values, int count) {
+        for (int i = 0; i < count; i++, p += 2) {
+            if (values != nullptr) {
+                values[i] = (int16_t)ByteOrder::readU16(p) / 10.0f;
+            }
+        }
+        return p;
+    }
+}
+
+Curve fromOutput(const void* output, int count, bool quantized, float scale, int32_t zeroPoint,
+                 float* buffer, int maxCount) {
+    Curve curve = { nullptr, 0 };
+    if (output == nullptr || count <= 0) {
+        return curve;
+    }
+    curve.size = count < maxCount ? count : maxCount;
+    if (!quantized) {
+        curve.data = (const float*)output;
+        return curve;
+    }
+
+    const int8_t* q = (const int8_t*)output;
+    for (int i = 0; i < curve.size; i++) {
+        buffer[i] = Quantization::dequantizeInt8(q[i], scale, zeroPoint);
+    }
+    curve.data = buffer;
+    return curve;
+}
+
+size_t encodePacket(const Curve& curve, uint8_t stepMinutes, uint8_t* out, size_t capacity,
+                    const float* lower, const float* upper) {
+    bool withInterval = lower != nullptr && upper != nullptr;
+    if (curve.size < 0 || curve.size > 255 || capacity < packetSize(curve.size, withInterval)) {
+        return 0;
+    }
+    out[0] = kCurvePacketVersion;
+    out[1] = (uint8_t)curve.size;
+    out[2] = stepMinutes;
+    out[3] = withInterval ? kFlagInterval : 0;
+    uint8_t* p = writeValues(out + kCurvePacketHeaderSize, curve.data, curve.size);
+    if (withInterval) {
+        p = writeValues(p, lower, curve.size);
+        writeValues(p, upper, curve.size);
+    }
+    return packetSize(curve.size, withInterval);
+}
+
+int decodePacket(const uint8_t* packet, size_t length, uint8_t* stepMinutes, float* values, int maxCount,
+                 float* lower, float* upper, bool* hasInterval) {
+    if (length < kCurvePacketHeaderSize || packet[0] != kCurvePacketVersion) {
+        return -1;
+    }
+    int count = packet[1];
+    bool withInterval = (packet[3] & kFlagInterval) != 0;
+    if (length != packetSize(count, withInterval) || count > maxCount) {
+        return -1;
+    }
+    *stepMinutes = packet[2];
+    const uint8_t* p = readValues(packet + kCurvePacketHeaderSize, values, count);
+    if (withInterval) {
+        p = readValues(p, lower, count);
+        readValues(p, upper, count);
+    }
+    if (hasInterval != nullptr) {
+        *hasInterval = withInterval;
+    }
+    return count;
+}
+
+} // namespace PredictionCurve
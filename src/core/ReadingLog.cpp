@@ -0,0 +1,143 @@
+#include "ReadingLog.h"
+
+namespace {
+    // 通道顺序与 Reading 的字段一致
+    const SeriesCodec::Channel kLayout[ReadingLog::kChannels] = {
+        { SeriesCodec::QUANTIZED, 1 },  // 血糖 0.1 mg/dL
+        { SeriesCodec::QUANTIZED, 1 },  // 心率 0.1 bpm
+        { SeriesCodec::QUANTIZED, 1 },  // SpO2 0.1 %
+        { SeriesCodec::QUANTIZED, 1 },  // 温度 0.1 °C (DHT22 的分辨率)
+        { SeriesCodec::QUANTIZED, 1 },  // 湿度 0.1 %
+        { SeriesCodec::QUANTIZED, 2 }   // 信号质量 0.01
+    };
+
+    void toValues(const ReadingLog::Reading& reading, float* values) {
+        values[0] = reading.glucose;
+        values[1] = reading.heartRate;
+        values[2] = reading.spo2;
+        values[3] = reading.temperature;
+        values[4] = reading.humidity;
+        values[5] = reading.quality;
+    }
+
+    void fromValues(uint32_t timestamp, const float* values, ReadingLog::Reading* reading) {
+        reading->timestamp = timestamp;
+        reading->glucose = values[0];
+        reading->heartRate = values[1];
+        reading->spo2 = values[2];
+        reading->temperature = values[3];
+        reading->humidity = values[4];
+        reading->quality = values[5];
+    }
+
+    // 把块中 [from, to] 内的读数写入 out
+    int readRange(const uint8_t* data, size_t length, uint32_t from, uint32_t to, ReadingLog::Reading* out, int maxReadings) {
+        SeriesCodec::BlockDecoder decoder;
+        if (!decoder.begin(data, length) || decoder.channelCount() != ReadingLog::kChannels) {
+            return 0;
+        }
+        int n = 0;
+        uint32_t timestamp;
+        float values[ReadingLog::kChannels];
+        while (n < maxReadings && decoder.next(&timestamp, values)) {
+            if (timestamp > to) {
+                break;
+            }
+            if (timestamp >= from) {
+                fromValues(timestamp, values, &out[n++]);
+            }
+        }
+        return n;
+    }
+}
+
+ReadingLog::ReadingLog(TimeSeriesStore& store, size_t blockSize) :
+    _store(store),
+    _blockSize(blockSize < kMinBlockSize ? kMinBlockSize : (blockSize > kMaxBlockSize ? kMaxBlockSize : blockSize)),
+    _timeOffset(0)
+{
+    _encoder.begin(kLayout, kChannels, _block, _blockSize);
+}
+
+bool ReadingLog::add(const Reading& reading) {
+    uint32_t latest = newestTimestamp();
+    uint32_t adjusted = reading.timestamp + _timeOffset;
+    if (adjusted < latest) {
+        _timeOffset += latest - adjusted;
+        adjusted = latest;
+    }
+    float values[kChannels];
+    toValues(reading, values);
+    if (_encoder.append(adjusted, values)) {
+        return true;
+    }
+    // 块满: 写入flash后放进新的一块
+    return flush() && _encoder.append(adjusted, values);
+}
+
+bool ReadingLog::flush() {
+    if (_encoder.count() == 0) {
+        return true;
+    }
+    if (!_store.append(kRecordType, _encoder.firstTimestamp(), _encoder.lastTimestamp(), _block, _encoder.size())) {
+        return false;
+    }
+    _encoder.begin(kLayout, kChannels, _block, _blockSize);
+    return true;
+}
+
+int ReadingLog::pending() const {
+    return _encoder.count();
+}
+
+uint32_t ReadingLog::newestTimestamp() const {
+    return _encoder.count() > 0 ? _encoder.lastTimestamp() : _store.getStats().newestTimestamp;
+}
+
+int ReadingLog::read(uint32_t from, uint32_t to, Reading* out, int maxReadings) {
+    int n = 0;
+    TimeSeriesStore::Cursor cursor = _store.seek(from);
+    TimeSeriesStore::RecordInfo info;
+    uint8_t payload[kMaxBlockSize];
+    while (n < maxReadings && _store.next(&cursor, &info, payload, sizeof(payload))) {
+        if (info.firstTimestamp > to) {
+            break;
+        }
+        if (info.type == kRecordType) {
+            n += readRange(payload, info.length, from, to, out + n, maxReadings - n);
+        }
+    }
+    if (n < maxReadings && _encoder.count() > 0) {
+        n += readRange(_block, _encoder.size(), from, to, out + n, maxReadings - n);
+    }
+    return n;
+}
+
+size_t ReadingLog::encodeBlock(const Reading* readings, int count, uint8_t* out, size_t capacity) {
+    SeriesCodec::BlockEncoder encoder;
+    if (count < 1 || !encoder.begin(kLayout, kChannels, out, capacity)) {
+        return 0;
+    }
+    float values[kChannels];
+    for (int i = 0; i < count; i++) {
+        toValues(readings[i], values);
+        if (!encoder.append(readings[i].timestamp, values)) {
+            return 0;
+        }
+    }
+    return encoder.size();
+}
+
+int ReadingLog::decodeBlock(const uint8_t* data, size_t length, Reading* out, int maxReadings) {
+    SeriesCodec::BlockDecoder decoder;
+    if (!decoder.begin(data, length) || decoder.channelCount() != kChannels || decoder.count() > maxReadings) {
+        return -1;
+    }
+    uint32_t timestamp;
+    float values[kChannels];
+    int n = 0;
+    while (decoder.next(&timestamp, values)) {
+        fromValues(timestamp, values, &out[n++]);
+    }
+    return n == decoder.count() ? n : -1;
+}
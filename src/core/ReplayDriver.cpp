@@ -0,0 +1,162 @@
+#include "ReplayDriver.h"
+#include <Arduino.h>
+#include "ModelImage.h"
+
+// 录制与回放的代码只在选择了其中一种模式时编译；主机模拟总是编译，模式在运行时选择
+#define CAPTURE_COMPILED (SENSOR_CAPTURE_MODE != SENSOR_CAPTURE_OFF || SIMULATOR)
+
+#if CAPTURE_COMPILED
+#include "EspFlashPartition.h"
+#include "TimeSeriesStore.h"
+#include "SensorCapture.h"
+#include "SignalReader.h"
+#include "Max30102Controller.h"
+#include "Dht22Controller.h"
+#include "GlucoseCalculator.h"
+#include "GlucosePredictor.h"
+
+namespace {
+    // 直接写入 capture 分区
+    EspFlashPartition capturePartition(ESP_PARTITION_SUBTYPE_DATA_SPIFFS, SENSOR_CAPTURE_PARTITION_LABEL);
+    TimeSeriesStore captureStore(capturePartition);
+    SensorCapture sensorCapture(captureStore, SENSOR_CAPTURE_BLOCK_SIZE);
+
+    // 把录制/回放接到HAL与处理链路 (nullptr 恢复直接读取传感器)
+    void attachCapture(SensorCapture* capture) {
+        SignalReader::getInstance().setCapture(capture);
+        Max30102Controller::getInstance().setCapture(capture);
+        Dht22Controller::getInstance().setCapture(capture);
+        GlucoseCalculator::getInstance().setCapture(capture);
+        GlucosePredictor::getInstance().setCapture(capture);
+    }
+}
+#endif
+
+ReplayDriver& ReplayDriver::getInstance() {
+    static ReplayDriver instance;
+    return instance;
+}
+
+ReplayDriver::ReplayDriver() :
+    _mode(SENSOR_CAPTURE_MODE),
+    _replayStarted(false),
+    _replayFinished(false),
+    _digest(0),
+    _roundDigest(0),
+    _rounds(0)
+{
+}
+
+void ReplayDriver::setMode(int mode) {
+    _mode = mode;
+}
+
+int ReplayDriver::getMode() const {
+    return _mode;
+}
+
+void ReplayDriver::begin() {
+#if CAPTURE_COMPILED
+    if (_mode == SENSOR_CAPTURE_OFF) {
+        return;
+    }
+    if (!capturePartition.begin() || !captureStore.begin()) {
+        Serial.println("WARNING: Capture partition not available.");
+        return;
+    }
+    if (_mode == SENSOR_CAPTURE_RECORD) {
+        sensorCapture.startCapture(millis());
+        attachCapture(&sensorCapture);
+        Serial.printf("Capturing raw sensor data (session %u)\n", sensorCapture.getSession());
+    } else if (sensorCapture.startReplay()) {
+        attachCapture(&sensorCapture);
+        _replayStarted = true;
+        Serial.printf("Replaying capture session %u\n", sensorCapture.getSession());
+    } else {
+        Serial.println("WARNING: No capture to replay, using the sensors.");
+    }
+#endif
+}
+
+bool ReplayDriver::isReplaying() const {
+    return _replayStarted && !_replayFinished;
+}
+
+uint32_t ReplayDriver::clock(uint32_t nowMs) {
+#if CAPTURE_COMPILED
+    return sensorCapture.clock(nowMs);
+#else
+    return nowMs;
+#endif
+}
+
+bool ReplayDriver::beginRound() {
+    if (_replayFinished) {
+        return false;
+    }
+    _roundDigest = _digest;
+    return true;
+}
+
+void ReplayDriver::digest(const float* values, int count) {
+    if (isRecording() || isReplaying()) {
+        _roundDigest = ModelImage::crc32((const uint8_t*)values, sizeof(float) * count, _roundDigest);
+    }
+}
+
+bool ReplayDriver::endRound() {
+#if CAPTURE_COMPILED
+    if (isRecording()) {
+        _digest = _roundDigest;
+        _rounds++;
+        return false;
+    }
+    if (!isReplaying()) {
+        return false;
+    }
+    if (sensorCapture.isReplaying()) {
+        _digest = _roundDigest;
+        _rounds++;
+        Max30102Controller::getInstance().update();
+    }
+    if (sensorCapture.peekEvent() == SensorCapture::EVENT_NONE) {
+        const SensorCapture::Stats& stats = sensorCapture.getStats();
+        Serial.printf("Replay of session %u %s: %u rounds, %u events (%u ADC, %u FIFO samples), output CRC32 %08X\n",
+                      sensorCapture.getSession(), sensorCapture.hasDiverged() ? "diverged" : "finished",
+                      (unsigned)_rounds, (unsigned)stats.events, (unsigned)stats.adcSamples,
+                      (unsigned)stats.fifoSamples, (unsigned)_digest);
+        sensorCapture.stop();
+        attachCapture(nullptr);
+        _replayFinished = true;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ReplayDriver::flush() {
+#if CAPTURE_COMPILED
+    if (isRecording()) {
+        sensorCapture.flush();
+        Serial.printf("Capture of session %u: %u rounds, output CRC32 %08X\n", sensorCapture.getSession(),
+                      (unsigned)_rounds, (unsigned)_digest);
+    }
+#endif
+}
+
+bool ReplayDriver::isRecording() const {
+#if CAPTURE_COMPILED
+    return sensorCapture.getMode() == SensorCapture::Mode::CAPTURING;
+#else
+    return false;
+#endif
+}
+
+uint32_t ReplayDriver::getDigest() const {
+    return _digest;
+}
+
+uint32_t ReplayDriver::getRounds() const {
+    return _rounds;
+}
@@ -0,0 +1,167 @@
+#include "RollupEngine.h"
+#include "ByteOrder.h"
+#include <math.h>
+
+namespace {
+    int16_t quantize(float glucose) {
+        float scaled = roundf(glucose * 10.0f);
+        if (scaled > 32767.0f) return 32767;
+        if (scaled < -32768.0f) return -32768;
+        return (int16_t)scaled;
+    }
+
+    const uint32_t kPeriods[RollupEngine::kTierCount] = { 60, 300, 3600 };
+}
+
+RollupEngine::RollupEngine() {
+    Bucket* storage[kTierCount] = { _minute, _fiveMinute, _hour };
+    const int capacities[kTierCount] = { kMinuteBuckets, kFiveMinuteBuckets, kHourBuckets };
+    for (int t = 0; t < kTierCount; t++) {
+        _rings[t].buckets = storage[t];
+        _rings[t].capacity = capacities[t];
+        _rings[t].period = kPeriods[t];
+    }
+    clear();
+}
+
+void RollupEngine::clear() {
+    for (int t = 0; t < kTierCount; t++) {
+        _rings[t].head = 0;
+        _rings[t].count = 0;
+        _rings[t].open = false;
+        _rings[t].openStart = 0;
+        _rings[t].openCount = 0;
+        _rings[t].openMin = 0.0f;
+        _rings[t].openMax = 0.0f;
+        _rings[t].openSum = 0.0f;
+    }
+}
+
+uint32_t RollupEngine::period(Tier tier) {
+    return kPeriods[tier];
+}
+
+void RollupEngine::add(uint32_t timestamp, float glucose) {
+    if (isnan(glucose)) {
+        return;
+    }
+    for (int t = 0; t < kTierCount; t++) {
+        Ring& ring = _rings[t];
+        uint32_t start = timestamp - timestamp % ring.period;
+        // 一档满 65535 个读数时也结束，计数不会溢出 (只在时间停滞时发生)
+        if (ring.open && (start > ring.openStart || ring.openCount == 0xFFFF)) {
+            closeOpen(ring);
+        }
+        if (!ring.open) {
+            ring.open = true;
+            ring.openStart = start;
+            ring.openCount = 0;
+            ring.openMin = glucose;
+            ring.openMax = glucose;
+            ring.openSum = 0.0f;
+        }
+        ring.openCount++;
+        ring.openSum += glucose;
+        if (glucose < ring.openMin) ring.openMin = glucose;
+        if (glucose > ring.openMax) ring.openMax = glucose;
+    }
+}
+
+void RollupEngine::closeOpen(Ring& ring) {
+    Bucket bucket = openBucket(ring);
+    if (ring.count == ring.capacity) {
+        // 覆盖最旧的一档
+        ring.buckets[ring.head] = bucket;
+        ring.head = (ring.head + 1) % ring.capacity;
+    } else {
+        ring.buckets[(ring.head + ring.count) % ring.capacity] = bucket;
+        ring.count++;
+    }
+    ring.open = false;
+}
+
+RollupEngine::Bucket RollupEngine::openBucket(const Ring& ring) {
+    Bucket bucket;
+    bucket.start = ring.openStart;
+    bucket.count = ring.openCount;
+    bucket.min = quantize(ring.openMin);
+    bucket.max = quantize(ring.openMax);
+    bucket.mean = quantize(ring.openSum / ring.openCount);
+    return bucket;
+}
+
+int RollupEngine::total(const Ring& ring) {
+    return ring.count + (ring.open ? 1 : 0);
+}
+
+RollupEngine::Bucket RollupEngine::at(const Ring& ring, int index) {
+    if (index == ring.count) {
+        return openBucket(ring);
+    }
+    return ring.buckets[(ring.head + index) % ring.capacity];
+}
+
+int RollupEngine::lowerBound(const Ring& ring, uint32_t from) {
+    // 第一档 start + period > from (与 from 相交或在其后)
+    int low = 0;
+    int high = total(ring);
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if ((uint64_t)at(ring, mid).start + ring.period > from) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+int RollupEngine::query(Tier tier, uint32_t from, uint32_t to, Rollup* out, int maxRollups) const {
+    const Ring& ring = _rings[tier];
+    int n = 0;
+    for (int i = lowerBound(ring, from); i < total(ring) && n < maxRollups; i++) {
+        Bucket bucket = at(ring, i);
+        if (bucket.start > to) {
+            break;
+        }
+        out[n].start = bucket.start;
+        out[n].count = bucket.count;
+        out[n].min = bucket.min / 10.0f;
+        out[n].max = bucket.max / 10.0f;
+        out[n].mean = bucket.mean / 10.0f;
+        n++;
+    }
+    return n;
+}
+
+int RollupEngine::count(Tier tier) const {
+    return total(_rings[tier]);
+}
+
+size_t RollupEngine::encodePage(Tier tier, uint32_t from, bool latest, uint8_t* out, size_t capacity) const {
+    if (capacity < kPageHeaderSize || tier >= kTierCount) {
+        return 0;
+    }
+    const Ring& ring = _rings[tier];
+    int available = total(ring);
+    int maxEntries = (int)((capacity - kPageHeaderSize) / kPageEntrySize);
+    if (maxEntries > kMaxPageEntries) {
+        maxEntries = kMaxPageEntries;
+    }
+    int first = latest ? (available > maxEntries ? available - maxEntries : 0) : lowerBound(ring, from);
+    int entries = available - first < maxEntries ? available - first : maxEntries;
+
+    out[0] = tier;
+    out[1] = (uint8_t)entries;
+    ByteOrder::writeU16(out + 2, (uint16_t)ring.period);
+    uint8_t* p = out + kPageHeaderSize;
+    for (int i = 0; i < entries; i++, p += kPageEntrySize) {
+        Bucket bucket = at(ring, first + i);
+        ByteOrder::writeU32(p, bucket.start);
+        ByteOrder::writeU16(p + 4, bucket.count);
+        ByteOrder::writeU16(p + 6, (uint16_t)bucket.min);
+        ByteOrder::writeU16(p + 8, (uint16_t)bucket.max);
+        ByteOrder::writeU16(p + 10, (uint16_t)bucket.mean);
+    }
+    return kPageHeaderSize + entries * kPageEntrySize;
+}
@@ -0,0 +1,391 @@
+#include "SensorCapture.h"
+#include "ByteOrder.h"
+#include "WaveformCodec.h"
+#include <string.h>
+
+namespace {
+    constexpr uint8_t kFlagSessionStart = 0x01;
+    // 16位采样的 zigzag 差分最多17位
+    constexpr size_t kMaxAdcDeltaSize = 3;
+
+    // 差分按无符号运算，回绕后解码时同样回绕
+    uint32_t delta(uint32_t value, uint32_t previous) {
+        return WaveformCodec::zigzag((int32_t)(value - previous));
+    }
+
+    bool isBlockHeader(const uint8_t* block, size_t length) {
+        return length >= SensorCapture::kBlockHeaderSize && block[0] == SensorCapture::kBlockVersion;
+    }
+}
+
+SensorCapture::SensorCapture(TimeSeriesStore& store, size_t blockSize) :
+    _store(store),
+    _blockSize(blockSize < kMinBlockSize ? kMinBlockSize : (blockSize > kMaxBlockSize ? kMaxBlockSize : blockSize)),
+    _mode(Mode::IDLE),
+    _diverged(false),
+    _session(0),
+    _length(0),
+    _offset(0),
+    _sessionStart(false),
+    _lastEventMs(0),
+    _timeBase(0),
+    _sessionStartMs(0),
+    _lastRecordTime(0),
+    _lastAdc(0),
+    _lastIr(0),
+    _lastRed(0),
+    _cursor{0, 0},
+    _nextType(EVENT_NONE),
+    _nextMs(0)
+{
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+bool SensorCapture::startCapture(uint32_t nowMs) {
+    stop();
+    // 最新的会话在最后几条记录中
+    TimeSeriesStore::Stats storeStats = _store.getStats();
+    TimeSeriesStore::Cursor cursor = _store.seek(storeStats.newestTimestamp);
+    TimeSeriesStore::RecordInfo info;
+    uint16_t latest = 0;
+    while (_store.next(&cursor, &info, _block, sizeof(_block))) {
+        if (info.type == kRecordType && isBlockHeader(_block, info.length)) {
+            latest = ByteOrder::readU16(_block + 2);
+        }
+    }
+
+    memset(&_stats, 0, sizeof(_stats));
+    _diverged = false;
+    _session = (uint16_t)(latest + 1);
+    _sessionStart = true;
+    _timeBase = storeStats.newestTimestamp;
+    _sessionStartMs = nowMs;
+    _lastRecordTime = _timeBase;
+    _mode = Mode::CAPTURING;
+    startBlock(nowMs);
+    return true;
+}
+
+void SensorCapture::startBlock(uint32_t timeMs) {
+    _block[0] = kBlockVersion;
+    _block[1] = _sessionStart ? kFlagSessionStart : 0;
+    ByteOrder::writeU16(_block + 2, _session);
+    ByteOrder::writeU32(_block + 4, timeMs);
+    _length = kBlockHeaderSize;
+    _lastEventMs = timeMs;
+    _lastAdc = 0;
+    _lastIr = 0;
+    _lastRed = 0;
+}
+
+uint32_t SensorCapture::recordTime(uint32_t timeMs) const {
+    uint32_t time = _timeBase + (timeMs - _sessionStartMs) / 1000;
+    return time < _lastRecordTime ? _lastRecordTime : time;
+}
+
+bool SensorCapture::flush() {
+    if (_mode != Mode::CAPTURING) {
+        return false;
+    }
+    if (_length <= kBlockHeaderSize) {
+        return true;
+    }
+    uint32_t first = recordTime(ByteOrder::readU32(_block + 4));
+    uint32_t last = recordTime(_lastEventMs);
+    bool ok = _store.append(kRecordType, first, last, _block, _length);
+    if (ok) {
+        _stats.blocks++;
+        _stats.bytes += _length;
+        _lastRecordTime = last;
+        _sessionStart = false;
+    } else {
+        // 丢弃这一块，之后的块仍可解码 (会话的第一块丢失时下一块重新标记为第一块)
+        _stats.failedWrites++;
+    }
+    startBlock(_lastEventMs);
+    return ok;
+}
+
+void SensorCapture::beginEvent(uint32_t timeMs, uint8_t type, size_t maxSize) {
+    if (_length + maxSize > _blockSize) {
+        flush();
+    }
+    _block[_length++] = type;
+    writeVarint(timeMs - _lastEventMs);
+    _lastEventMs = timeMs;
+    _stats.events++;
+}
+
+void SensorCapture::writeVarint(uint32_t value) {
+    _length += WaveformCodec::writeVarint(value, _block + _length);
+}
+
+void SensorCapture::recordAdc(uint32_t timeMs, const uint16_t* samples, int count) {
+    if (_mode != Mode::CAPTURING) {
+        return;
+    }
+    for (int first = 0; first < count; first += kMaxAdcSamples) {
+        int n = count - first < kMaxAdcSamples ? count - first : kMaxAdcSamples;
+        beginEvent(timeMs, EVENT_ADC, 1 + 5 + 5 + n * kMaxAdcDeltaSize);
+        writeVarint((uint32_t)n);
+        for (int i = first; i < first + n; i++) {
+            writeVarint(delta(samples[i], _lastAdc));
+            _lastAdc = samples[i];
+        }
+        _stats.adcSamples += n;
+    }
+}
+
+void SensorCapture::recordFifo(uint32_t timeMs, const uint32_t* ir, const uint32_t* red, int count) {
+    if (_mode != Mode::CAPTURING) {
+        return;
+    }
+    for (int first = 0; first < count; first += kMaxFifoSamples) {
+        int n = count - first < kMaxFifoSamples ? count - first : kMaxFifoSamples;
+        beginEvent(timeMs, EVENT_FIFO, 1 + 5 + 5 + n * 2 * WaveformCodec::kMaxVarintSize);
+        writeVarint((uint32_t)n);
+        for (int i = first; i < first + n; i++) {
+            writeVarint(delta(ir[i], _lastIr));
+            writeVarint(delta(red[i], _lastRed));
+            _lastIr = ir[i];
+            _lastRed = red[i];
+        }
+        _stats.fifoSamples += n;
+    }
+}
+
+void SensorCapture::recordDht(uint32_t timeMs, bool ok, float temperature, float humidity) {
+    if (_mode != Mode::CAPTURING) {
+        return;
+    }
+    beginEvent(timeMs, EVENT_DHT, 1 + 5 + 9);
+    _block[_length++] = ok ? 1 : 0;
+    ByteOrder::writeF32(_block + _length, temperature);
+    ByteOrder::writeF32(_block + _length + 4, humidity);
+    _length += 8;
+}
+
+uint32_t SensorCapture::clock(uint32_t nowMs) {
+    if (_mode == Mode::CAPTURING) {
+        beginEvent(nowMs, EVENT_CLOCK, 1 + 5);
+        return nowMs;
+    }
+    if (_mode == Mode::REPLAYING && readEvent(EVENT_CLOCK)) {
+        uint32_t recorded = _nextMs;
+        prepareNext();
+        return recorded;
+    }
+    return nowMs;
+}
+
+bool SensorCapture::startReplay(int session) {
+    stop();
+    // 找到会话的第一块 (kLatestSession 时为最后一个会话的第一块)
+    TimeSeriesStore::Cursor cursor = _store.first();
+    TimeSeriesStore::Cursor found = cursor;
+    bool hasFound = false;
+    TimeSeriesStore::RecordInfo info;
+    while (true) {
+        TimeSeriesStore::Cursor before = cursor;
+        if (!_store.next(&cursor, &info, _block, sizeof(_block))) {
+            break;
+        }
+        if (info.type != kRecordType || !isBlockHeader(_block, info.length) || (_block[1] & kFlagSessionStart) == 0) {
+            continue;
+        }
+        uint16_t id = ByteOrder::readU16(_block + 2);
+        if (session == kLatestSession || id == (uint16_t)session) {
+            found = before;
+            hasFound = true;
+            _session = id;
+            if (session != kLatestSession) {
+                break;
+            }
+        }
+    }
+    if (!hasFound) {
+        return false;
+    }
+
+    memset(&_stats, 0, sizeof(_stats));
+    _diverged = false;
+    _cursor = found;
+    if (!loadBlock(true)) {
+        return false;
+    }
+    _mode = Mode::REPLAYING;
+    prepareNext();
+    return true;
+}
+
+bool SensorCapture::loadBlock(bool first) {
+    TimeSeriesStore::RecordInfo info;
+    while (_store.next(&_cursor, &info, _block, sizeof(_block))) {
+        if (info.type != kRecordType) {
+            continue;
+        }
+        // 下一个会话开始或格式不符时本会话结束
+        if (!isBlockHeader(_block, info.length) || ByteOrder::readU16(_block + 2) != _session ||
+            ((_block[1] & kFlagSessionStart) != 0) != first) {
+            return false;
+        }
+        _length = info.length;
+        _offset = kBlockHeaderSize;
+        _lastEventMs = ByteOrder::readU32(_block + 4);
+        _lastAdc = 0;
+        _lastIr = 0;
+        _lastRed = 0;
+        _stats.blocks++;
+        _stats.bytes += info.length;
+        return true;
+    }
+    return false;
+}
+
+void SensorCapture::prepareNext() {
+    while (_offset >= _length) {
+        if (!loadBlock(false)) {
+            _nextType = EVENT_NONE;
+            return;
+        }
+    }
+    uint32_t elapsed;
+    _nextType = _block[_offset++];
+    if (!readVarint(&elapsed)) {
+        _nextType = EVENT_NONE;
+        return;
+    }
+    _nextMs = _lastEventMs + elapsed;
+    _lastEventMs = _nextMs;
+}
+
+bool SensorCapture::readEvent(uint8_t type) {
+    if (_mode != Mode::REPLAYING) {
+        return false;
+    }
+    if (_nextType != type) {
+        // 会话正常结束，或者调用顺序与录制时不一致
+        _diverged = _nextType != EVENT_NONE;
+        stopReplay();
+        return false;
+    }
+    _stats.events++;
+    return true;
+}
+
+bool SensorCapture::readVarint(uint32_t* value) {
+    size_t n = WaveformCodec::readVarint(_block + _offset, _length - _offset, value);
+    _offset += n;
+    return n > 0;
+}
+
+bool SensorCapture::replayAdc(uint16_t* samples, int count) {
+    int done = 0;
+    while (done < count) {
+        uint32_t n;
+        if (!readEvent(EVENT_ADC) || !readVarint(&n) || n > (uint32_t)(count - done) || n > kMaxAdcSamples) {
+            _diverged = _diverged || _mode == Mode::REPLAYING;
+            stopReplay();
+            return false;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t z;
+            if (!readVarint(&z)) {
+                stopReplay();
+                return false;
+            }
+            _lastAdc = (uint16_t)(_lastAdc + WaveformCodec::unzigzag(z));
+            samples[done++] = _lastAdc;
+        }
+        _stats.adcSamples += n;
+        prepareNext();
+    }
+    return true;
+}
+
+int SensorCapture::replayFifo(uint32_t* ir, uint32_t* red) {
+    if (_mode != Mode::REPLAYING) {
+        return -1;
+    }
+    if (_nextType != EVENT_FIFO) {
+        return 0;
+    }
+    uint32_t n;
+    if (!readEvent(EVENT_FIFO) || !readVarint(&n) || n > kMaxFifoSamples) {
+        stopReplay();
+        return -1;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t zIr, zRed;
+        if (!readVarint(&zIr) || !readVarint(&zRed)) {
+            stopReplay();
+            return -1;
+        }
+        _lastIr += (uint32_t)WaveformCodec::unzigzag(zIr);
+        _lastRed += (uint32_t)WaveformCodec::unzigzag(zRed);
+        ir[i] = _lastIr;
+        red[i] = _lastRed;
+    }
+    _stats.fifoSamples += n;
+    prepareNext();
+    return (int)n;
+}
+
+bool SensorCapture::replayDht(bool* ok, float* temperature, float* humidity) {
+    if (!readEvent(EVENT_DHT)) {
+        return false;
+    }
+    if (_length - _offset < 9) {
+        stopReplay();
+        return false;
+    }
+    *ok = _block[_offset] != 0;
+    *temperature = ByteOrder::readF32(_block + _offset + 1);
+    *humidity = ByteOrder::readF32(_block + _offset + 5);
+    _offset += 9;
+    prepareNext();
+    return true;
+}
+
+SensorCapture::EventType SensorCapture::peekEvent() {
+    return _mode == Mode::REPLAYING ? (EventType)_nextType : EVENT_NONE;
+}
+
+void SensorCapture::stopReplay() {
+    if (_mode == Mode::REPLAYING) {
+        _mode = Mode::IDLE;
+    }
+    _nextType = EVENT_NONE;
+}
+
+void SensorCapture::stop() {
+    if (_mode == Mode::CAPTURING) {
+        flush();
+    }
+    _mode = Mode::IDLE;
+    _nextType = EVENT_NONE;
+}
+
+SensorCapture::Mode SensorCapture::getMode() const {
+    return _mode;
+}
+
+bool SensorCapture::isCapturing() const {
+    return _mode == Mode::CAPTURING;
+}
+
+bool SensorCapture::isReplaying() const {
+    return _mode == Mode::REPLAYING;
+}
+
+bool SensorCapture::hasDiverged() const {
+    return _diverged;
+}
+
+uint16_t SensorCapture::getSession() const {
+    return _session;
+}
+
+const SensorCapture::Stats& SensorCapture::getStats() const {
+    return _stats;
+}
@@ -0,0 +1,68 @@
+#include "SequentialEstimator.h"
+#include <math.h>
+
+namespace {
+    // 双侧95% t分布分位数，下标为自由度 (1~10)
+    const float kT975[] = { 0.0f, 12.706f, 4.303f, 3.182f, 2.776f, 2.571f, 2.447f, 2.365f, 2.306f, 2.262f, 2.228f };
+}
+
+float SequentialEstimator::tQuantile975(int dof) {
+    if (dof <= 10) return kT975[dof < 1 ? 1 : dof];
+    if (dof <= 15) return 2.131f;
+    if (dof <= 20) return 2.086f;
+    if (dof <= 30) return 2.042f;
+    return 1.96f;
+}
+
+SequentialEstimator::SequentialEstimator(const Config& config) :
+    _config(config)
+{
+    if (_config.minSamples < 2) _config.minSamples = 2;
+    if (_config.maxSamples < _config.minSamples) _config.maxSamples = _config.minSamples;
+    reset();
+}
+
+void SequentialEstimator::reset() {
+    _count = 0;
+    _mean = 0.0;
+    _m2 = 0.0;
+}
+
+void SequentialEstimator::add(float value) {
+    _count++;
+    double delta = value - _mean;
+    _mean += delta / _count;
+    _m2 += delta * (value - _mean);
+}
+
+SequentialEstimator::StopReason SequentialEstimator::shouldStop(uint32_t elapsedMs) const {
+    if (_count >= _config.minSamples && getHalfWidth() <= _config.tolerance) {
+        return StopReason::CONVERGED;
+    }
+    if (_count >= _config.maxSamples) {
+        return StopReason::MAX_SAMPLES;
+    }
+    // 至少要有一个结果才允许因超时退出
+    if (_count > 0 && elapsedMs >= _config.timeBudgetMs) {
+        return StopReason::TIME_BUDGET;
+    }
+    return StopReason::NONE;
+}
+
+uint16_t SequentialEstimator::getCount() const {
+    return _count;
+}
+
+float SequentialEstimator::getMean() const {
+    return (float)_mean;
+}
+
+float SequentialEstimator::getVariance() const {
+    if (_count < 2) return 0.0f;
+    return (float)(_m2 / (_count - 1));
+}
+
+float SequentialEstimator::getHalfWidth() const {
+    if (_count < 2) return INFINITY;
+    return tQuantile975(_count - 1) * sqrtf(getVariance() / _count);
+}
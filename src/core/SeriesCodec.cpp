@@ -0,0 +1,391 @@
+#include "SeriesCodec.h"
+#include "ByteOrder.h"
+#include <math.h>
+#include <string.h>
+
+namespace SeriesCodec {
+
+namespace {
+    // 有符号整数4档的位宽 (前缀 '10' '110' '1110' '1111')
+    const uint8_t kTimestampWidths[4] = { 7, 9, 12, 32 };
+    const uint8_t kValueWidths[4] = { 5, 9, 16, 32 };
+
+    const double kPow10[kMaxDecimals + 1] = { 1.0, 10.0, 100.0, 1e3, 1e4, 1e5, 1e6 };
+
+    // NAN 的量化值；正常值限制在它之外
+    const uint32_t kQuantizedNan = 0x80000000u;
+    const double kQuantizedLimit = 2147483647.0;
+
+    uint32_t zigzag(int32_t v) {
+        return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+    }
+
+    int32_t unzigzag(uint32_t v) {
+        return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+    }
+
+    uint32_t floatBits(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    float bitsFloat(uint32_t bits) {
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint32_t quantize(float value, uint8_t decimals) {
+        if (isnan(value)) {
+            return kQuantizedNan;
+        }
+        double scaled = floor((double)value * kPow10[decimals] + 0.5);
+        if (scaled > kQuantizedLimit) scaled = kQuantizedLimit;
+        if (scaled < -kQuantizedLimit) scaled = -kQuantizedLimit;
+        return (uint32_t)(int32_t)scaled;
+    }
+
+    float dequantize(uint32_t value, uint8_t decimals) {
+        if (value == kQuantizedNan) {
+            return NAN;
+        }
+        return (float)((int32_t)value / kPow10[decimals]);
+    }
+
+    /**
+     * @brief 在 position 处写入 value 的低 bits 位 (高位在前)。会清除原有的位，因此可以覆盖回滚后的数据。
+     */
+    bool writeBits(uint8_t* buffer, uint32_t capacityBits, uint32_t* position, uint32_t value, int bits) {
+        if (*position + bits > capacityBits) {
+            return false;
+        }
+        while (bits > 0) {
+            uint32_t pos = *position;
+            int free = 8 - (int)(pos & 7);
+            int take = bits < free ? bits : free;
+            uint32_t chunk = (value >> (bits - take)) & ((1u << take) - 1);
+            int shift = free - take;
+            uint8_t mask = (uint8_t)(((1u << take) - 1) << shift);
+            buffer[pos >> 3] = (uint8_t)((buffer[pos >> 3] & ~mask) | (chunk << shift));
+            *position = pos + take;
+            bits -= take;
+        }
+        return true;
+    }
+
+    bool readBits(const uint8_t* data, uint32_t lengthBits, uint32_t* position, int bits, uint32_t* value) {
+        if (*position + bits > lengthBits) {
+            return false;
+        }
+        uint32_t result = 0;
+        while (bits > 0) {
+            uint32_t pos = *position;
+            int available = 8 - (int)(pos & 7);
+            int take = bits < available ? bits : available;
+            uint32_t chunk = ((uint32_t)data[pos >> 3] >> (available - take)) & ((1u << take) - 1);
+            result = (result << take) | chunk;
+            *position = pos + take;
+            bits -= take;
+        }
+        *value = result;
+        return true;
+    }
+
+    bool writeSigned(uint8_t* buffer, uint32_t capacityBits, uint32_t* position, int32_t value, const uint8_t* widths) {
+        if (value == 0) {
+            return writeBits(buffer, capacityBits, position, 0, 1);
+        }
+        uint32_t encoded = zigzag(value);
+        for (int i = 0; i < 4; i++) {
+            if (widths[i] == 32 || encoded < (1u << widths[i])) {
+                // 前缀: i+1 个1，后跟一个0 (最后一档没有0)
+                int prefixBits = i < 3 ? i + 2 : 4;
+                uint32_t prefix = i < 3 ? ((1u << (i + 1)) - 1) << 1 : 0xF;
+                return writeBits(buffer, capacityBits, position, prefix, prefixBits) &&
+                       writeBits(buffer, capacityBits, position, encoded, widths[i]);
+            }
+        }
+        return false;
+    }
+
+    bool readSigned(const uint8_t* data, uint32_t lengthBits, uint32_t* position, const uint8_t* widths, int32_t* value) {
+        int ones = 0;
+        uint32_t bit = 1;
+        while (ones < 4) {
+            if (!readBits(data, lengthBits, position, 1, &bit)) {
+                return false;
+            }
+            if (bit == 0) {
+                break;
+            }
+            ones++;
+        }
+        if (ones == 0) {
+            *value = 0;
+            return true;
+        }
+        uint32_t encoded;
+        if (!readBits(data, lengthBits, position, widths[ones - 1], &encoded)) {
+            return false;
+        }
+        *value = unzigzag(encoded);
+        return true;
+    }
+
+    bool validChannel(const Channel& channel) {
+        return (channel.encoding == QUANTIZED && channel.decimals <= kMaxDecimals) ||
+               (channel.encoding == XOR_FLOAT && channel.decimals == 0);
+    }
+
+    const uint8_t kNoWindow = 0xFF;
+}
+
+BlockEncoder::BlockEncoder() :
+    _channelCount(0),
+    _buffer(nullptr),
+    _capacity(0),
+    _count(0),
+    _firstTimestamp(0)
+{
+    memset(&_state, 0, sizeof(_state));
+}
+
+bool BlockEncoder::begin(const Channel* channels, int channelCount, uint8_t* buffer, size_t capacity) {
+    _buffer = nullptr;
+    _count = 0;
+    if (channelCount < 1 || channelCount > kMaxChannels || capacity < kHeaderSize + channelCount || capacity > 0xFFFFFFF) {
+        return false;
+    }
+    for (int i = 0; i < channelCount; i++) {
+        if (!validChannel(channels[i])) {
+            return false;
+        }
+        _channels[i] = channels[i];
+        buffer[kHeaderSize + i] = (uint8_t)((channels[i].encoding << 4) | channels[i].decimals);
+    }
+    buffer[0] = kBlockVersion;
+    buffer[1] = (uint8_t)channelCount;
+    memset(buffer + 2, 0, kHeaderSize - 2);
+    _channelCount = channelCount;
+    _buffer = buffer;
+    _capacity = capacity;
+    _firstTimestamp = 0;
+    memset(&_state, 0, sizeof(_state));
+    _state.bitPosition = (uint32_t)(kHeaderSize + channelCount) * 8;
+    memset(_state.leading, kNoWindow, sizeof(_state.leading));
+    return true;
+}
+
+bool BlockEncoder::append(uint32_t timestamp, const float* values) {
+    if (_buffer == nullptr || _count == 0xFFFF) {
+        return false;
+    }
+    State state = _state;
+    uint32_t capacityBits = (uint32_t)_capacity * 8;
+
+    if (_count > 0) {
+        uint32_t delta = timestamp - state.timestamp;
+        if (!writeSigned(_buffer, capacityBits, &state.bitPosition, (int32_t)(delta - state.delta), kTimestampWidths)) {
+            return false;
+        }
+        state.delta = delta;
+    }
+    state.timestamp = timestamp;
+
+    for (int c = 0; c < _channelCount; c++) {
+        if (_channels[c].encoding == QUANTIZED) {
+            uint32_t value = quantize(values[c], _channels[c].decimals);
+            if (!writeSigned(_buffer, capacityBits, &state.bitPosition, (int32_t)(value - state.previous[c]), kValueWidths)) {
+                return false;
+            }
+            state.previous[c] = value;
+            continue;
+        }
+
+        uint32_t bits = floatBits(values[c]);
+        uint32_t x = bits ^ state.previous[c];
+        state.previous[c] = bits;
+        if (x == 0) {
+            if (!writeBits(_buffer, capacityBits, &state.bitPosition, 0, 1)) {
+                return false;
+            }
+            continue;
+        }
+        uint8_t leading = (uint8_t)__builtin_clz(x);
+        uint8_t trailing = (uint8_t)__builtin_ctz(x);
+        if (state.leading[c] != kNoWindow && leading >= state.leading[c] && trailing >= state.trailing[c]) {
+            // 有效位落在上一个窗口内: '10' + 窗口内的位
+            int width = 32 - state.leading[c] - state.trailing[c];
+            if (!writeBits(_buffer, capacityBits, &state.bitPosition, 0x2, 2) ||
+                !writeBits(_buffer, capacityBits, &state.bitPosition, x >> state.trailing[c], width)) {
+                return false;
+            }
+        } else {
+            // '11' + 前导零个数 (5位) + 有效位数-1 (5位) + 有效位
+            int width = 32 - leading - trailing;
+            if (!writeBits(_buffer, capacityBits, &state.bitPosition, 0x3, 2) ||
+                !writeBits(_buffer, capacityBits, &state.bitPosition, leading, 5) ||
+                !writeBits(_buffer, capacityBits, &state.bitPosition, (uint32_t)(width - 1), 5) ||
+                !writeBits(_buffer, capacityBits, &state.bitPosition, x >> trailing, width)) {
+                return false;
+            }
+            state.leading[c] = leading;
+            state.trailing[c] = trailing;
+        }
+    }
+
+    if (_count == 0) {
+        _firstTimestamp = timestamp;
+        ByteOrder::writeU32(_buffer + 4, timestamp);
+    }
+    _state = state;
+    _count++;
+    ByteOrder::writeU16(_buffer + 2, (uint16_t)_count);
+    return true;
+}
+
+size_t BlockEncoder::size() const {
+    return _buffer == nullptr ? 0 : (_state.bitPosition + 7) / 8;
+}
+
+int BlockEncoder::count() const {
+    return _count;
+}
+
+uint32_t BlockEncoder::firstTimestamp() const {
+    return _firstTimestamp;
+}
+
+uint32_t BlockEncoder::lastTimestamp() const {
+    return _count > 0 ? _state.timestamp : 0;
+}
+
+BlockDecoder::BlockDecoder() :
+    _channelCount(0),
+    _data(nullptr),
+    _length(0),
+    _count(0),
+    _decoded(0),
+    _bitPosition(0),
+    _firstTimestamp(0),
+    _timestamp(0),
+    _delta(0)
+{
+}
+
+bool BlockDecoder::begin(const uint8_t* data, size_t length) {
+    _data = nullptr;
+    if (length < kHeaderSize || data[0] != kBlockVersion || data[1] < 1 || data[1] > kMaxChannels ||
+        length < kHeaderSize + data[1] || length > 0xFFFFFFF) {
+        return false;
+    }
+    _channelCount = data[1];
+    for (int i = 0; i < _channelCount; i++) {
+        uint8_t descriptor = data[kHeaderSize + i];
+        _channels[i].encoding = (Encoding)(descriptor >> 4);
+        _channels[i].decimals = descriptor & 0x0F;
+        if (!validChannel(_channels[i])) {
+            return false;
+        }
+        _previous[i] = 0;
+        _leading[i] = kNoWindow;
+        _trailing[i] = 0;
+    }
+    _count = ByteOrder::readU16(data + 2);
+    _firstTimestamp = ByteOrder::readU32(data + 4);
+    _timestamp = _firstTimestamp;
+    _delta = 0;
+    _decoded = 0;
+    _bitPosition = (uint32_t)(kHeaderSize + _channelCount) * 8;
+    _data = data;
+    _length = length;
+    return true;
+}
+
+bool BlockDecoder::next(uint32_t* timestamp, float* values) {
+    if (_data == nullptr || _decoded >= _count) {
+        return false;
+    }
+    uint32_t lengthBits = (uint32_t)_length * 8;
+    if (_decoded > 0) {
+        int32_t deltaOfDelta;
+        if (!readSigned(_data, lengthBits, &_bitPosition, kTimestampWidths, &deltaOfDelta)) {
+            _data = nullptr;
+            return false;
+        }
+        _delta += (uint32_t)deltaOfDelta;
+        _timestamp += _delta;
+    }
+
+    for (int c = 0; c < _channelCount; c++) {
+        if (_channels[c].encoding == QUANTIZED) {
+            int32_t delta;
+            if (!readSigned(_data, lengthBits, &_bitPosition, kValueWidths, &delta)) {
+                _data = nullptr;
+                return false;
+            }
+            _previous[c] += (uint32_t)delta;
+            values[c] = dequantize(_previous[c], _channels[c].decimals);
+            continue;
+        }
+
+        uint32_t control;
+        if (!readBits(_data, lengthBits, &_bitPosition, 1, &control)) {
+            _data = nullptr;
+            return false;
+        }
+        if (control != 0) {
+            uint32_t x;
+            if (!readBits(_data, lengthBits, &_bitPosition, 1, &control)) {
+                _data = nullptr;
+                return false;
+            }
+            if (control == 0) {
+                if (_leading[c] == kNoWindow ||
+                    !readBits(_data, lengthBits, &_bitPosition, 32 - _leading[c] - _trailing[c], &x)) {
+                    _data = nullptr;
+                    return false;
+                }
+                x <<= _trailing[c];
+            } else {
+                uint32_t leading;
+                uint32_t width;
+                if (!readBits(_data, lengthBits, &_bitPosition, 5, &leading) ||
+                    !readBits(_data, lengthBits, &_bitPosition, 5, &width) ||
+                    leading + width + 1 > 32 ||
+                    !readBits(_data, lengthBits, &_bitPosition, (int)width + 1, &x)) {
+                    _data = nullptr;
+                    return false;
+                }
+                _leading[c] = (uint8_t)leading;
+                _trailing[c] = (uint8_t)(32 - leading - width - 1);
+                x <<= _trailing[c];
+            }
+            _previous[c] ^= x;
+        }
+        values[c] = bitsFloat(_previous[c]);
+    }
+
+    *timestamp = _timestamp;
+    _decoded++;
+    return true;
+}
+
+int BlockDecoder::channelCount() const {
+    return _channelCount;
+}
+
+int BlockDecoder::count() const {
+    return _count;
+}
+
+uint32_t BlockDecoder::firstTimestamp() const {
+    return _firstTimestamp;
+}
+
+Channel BlockDecoder::channel(int index) const {
+    return _channels[index];
+}
+
+} // namespace SeriesCodec
@@ -0,0 +1,137 @@
+#include "StateCheckpoint.h"
+#include "ByteOrder.h"
+#include "ModelImage.h"
+#include <string.h>
+
+namespace {
+    constexpr uint32_t kMagic = 0x504B4347; // "GCKP"
+    constexpr uint16_t kVersion = 1;
+    constexpr size_t kHeaderSize = 48;
+    constexpr size_t kSampleSize = 12;
+}
+
+StateCheckpoint::StateCheckpoint(KeyValueStore& store, const char* key, const Policy& policy) :
+    _store(store),
+    _key(key),
+    _policy(policy),
+    _pendingReadings(0),
+    _firstPendingRtcMs(0),
+    _saved(false),
+    _writeCount(0)
+{
+}
+
+void StateCheckpoint::noteReading(uint64_t rtcNowMs) {
+    if (_pendingReadings == 0) {
+        _firstPendingRtcMs = rtcNowMs;
+    }
+    if (_pendingReadings < 0xFFFF) {
+        _pendingReadings++;
+    }
+}
+
+bool StateCheckpoint::shouldSave(uint64_t rtcNowMs) const {
+    if (_pendingReadings == 0) {
+        return false;
+    }
+    if (_pendingReadings >= _policy.minReadings) {
+        return true;
+    }
+    // 读数很少时 (例如测量间隔变长) 也不让未保存的读数等待太久
+    return rtcNowMs < _firstPendingRtcMs || rtcNowMs - _firstPendingRtcMs >= _policy.maxIntervalMs;
+}
+
+size_t StateCheckpoint::serialize(const HistoryResampler& history, const GlucoseFilter::State& filter,
+                                  uint32_t millisNow, uint64_t rtcNowMs, uint8_t* out) const {
+    int count = history.size();
+    ByteOrder::writeU32(out + 0, kMagic);
+    ByteOrder::writeU16(out + 4, kVersion);
+    ByteOrder::writeU16(out + 6, (uint16_t)count);
+    ByteOrder::writeU32(out + 8, (uint32_t)rtcNowMs);
+    ByteOrder::writeU32(out + 12, (uint32_t)(rtcNowMs >> 32));
+
+    ByteOrder::writeU32(out + 16, filter.initialized ? 1 : 0);
+    ByteOrder::writeF32(out + 20, filter.glucose);
+    ByteOrder::writeF32(out + 24, filter.velocity);
+    ByteOrder::writeF32(out + 28, filter.p00);
+    ByteOrder::writeF32(out + 32, filter.p01);
+    ByteOrder::writeF32(out + 36, filter.p11);
+    ByteOrder::writeU32(out + 40, millisNow - filter.lastTimestampMs);
+    ByteOrder::writeU32(out + 44, filter.updateCount);
+
+    uint8_t* p = out + kHeaderSize;
+    for (int i = 0; i < count; i++, p += kSampleSize) {
+        const HistoryResampler::Sample& s = history.at(i);
+        ByteOrder::writeU32(p, millisNow - s.timestampMs);
+        ByteOrder::writeF32(p + 4, s.value);
+        ByteOrder::writeF32(p + 8, s.quality);
+    }
+    size_t length = kHeaderSize + kSampleSize * count;
+    ByteOrder::writeU32(out + length, ModelImage::crc32(out, length));
+    return length + 4;
+}
+
+bool StateCheckpoint::save(const HistoryResampler& history, const GlucoseFilter::State& filter,
+                           uint32_t millisNow, uint64_t rtcNowMs) {
+    if (_saved && _pendingReadings == 0) {
+        return true; // 存储中的快照已是最新
+    }
+    uint8_t buffer[kMaxSnapshotSize];
+    size_t length = serialize(history, filter, millisNow, rtcNowMs, buffer);
+    if (!_store.putBytes(_key, buffer, length)) {
+        return false;
+    }
+    _writeCount++;
+    _pendingReadings = 0;
+    _saved = true;
+    return true;
+}
+
+StateCheckpoint::RestoreResult StateCheckpoint::restore(HistoryResampler* history, GlucoseFilter::State* filter,
+                                                        uint32_t millisNow, uint64_t rtcNowMs) {
+    uint8_t buffer[kMaxSnapshotSize];
+    size_t length = _store.getBytes(_key, buffer, sizeof(buffer));
+    if (length == 0) {
+        return RestoreResult::NONE;
+    }
+
+    if (length < kHeaderSize + 4 || ByteOrder::readU32(buffer) != kMagic || ByteOrder::readU16(buffer + 4) != kVersion) {
+        return RestoreResult::CORRUPT;
+    }
+    int count = ByteOrder::readU16(buffer + 6);
+    if (count > HistoryResampler::kCapacity || length != kHeaderSize + kSampleSize * count + 4 ||
+        ByteOrder::readU32(buffer + length - 4) != ModelImage::crc32(buffer, length - 4)) {
+        return RestoreResult::CORRUPT;
+    }
+
+    uint64_t savedAt = (uint64_t)ByteOrder::readU32(buffer + 8) | ((uint64_t)ByteOrder::readU32(buffer + 12) << 32);
+    if (rtcNowMs < savedAt || rtcNowMs - savedAt > _policy.maxAgeMs) {
+        return RestoreResult::STALE;
+    }
+    uint32_t elapsed = (uint32_t)(rtcNowMs - savedAt);
+
+    // 时间戳换算: 新时间轴上的时刻 = 现在 - (保存后经过的时间 + 保存时的年龄)
+    // 重启后 millis() 很小，结果可能回绕为很大的无符号数，历史与滤波器均按差值计算，不受影响
+    filter->initialized = ByteOrder::readU32(buffer + 16) != 0;
+    filter->glucose = ByteOrder::readF32(buffer + 20);
+    filter->velocity = ByteOrder::readF32(buffer + 24);
+    filter->p00 = ByteOrder::readF32(buffer + 28);
+    filter->p01 = ByteOrder::readF32(buffer + 32);
+    filter->p11 = ByteOrder::readF32(buffer + 36);
+    filter->lastTimestampMs = millisNow - (elapsed + ByteOrder::readU32(buffer + 40));
+    filter->updateCount = ByteOrder::readU32(buffer + 44);
+
+    const uint8_t* p = buffer + kHeaderSize;
+    for (int i = 0; i < count; i++, p += kSampleSize) {
+        history->add(millisNow - (elapsed + ByteOrder::readU32(p)), ByteOrder::readF32(p + 4), ByteOrder::readF32(p + 8));
+    }
+
+    // 恢复的内容与存储一致，不需要立即重写
+    _saved = true;
+    _pendingReadings = 0;
+    return RestoreResult::OK;
+}
+
+uint32_t StateCheckpoint::getWriteCount() const {
+    return _writeCount;
+}
@@ -0,0 +1,375 @@
+#include "TimeSeriesStore.h"
+#include "ByteOrder.h"
+#include "ModelImage.h"
+#include <string.h>
+
+namespace {
+    constexpr uint32_t kSectorSize = FlashPartition::kSectorSize;
+    constexpr uint16_t kErasedLength = 0xFFFF;
+}
+
+TimeSeriesStore::TimeSeriesStore(FlashPartition& partition) :
+    _partition(partition),
+    _sectorCount(0),
+    _segmentCount(0),
+    _writeOffset(0),
+    _sealed(true),
+    _newestTimestamp(0),
+    _nextSequence(1),
+    _maxEraseCount(0),
+    _tornRecords(0)
+{
+}
+
+uint32_t TimeSeriesStore::recordSize(size_t payloadLength) {
+    return (uint32_t)((kRecordOverhead + payloadLength + 3) & ~(size_t)3);
+}
+
+bool TimeSeriesStore::begin() {
+    _sectorCount = (int)(_partition.size() / kSectorSize);
+    if (_sectorCount > kMaxSegments) {
+        _sectorCount = kMaxSegments;
+    }
+    _segmentCount = 0;
+    _sealed = true;
+    _writeOffset = 0;
+    _newestTimestamp = 0;
+    _nextSequence = 1;
+    _maxEraseCount = 0;
+    _tornRecords = 0;
+    if (_sectorCount < 2) {
+        return false;
+    }
+
+    // 1. 读取所有段头，按序号插入排序 (段数很少)
+    for (int sector = 0; sector < _sectorCount; sector++) {
+        uint8_t header[kSegmentHeaderSize];
+        if (!_partition.read(sector * kSectorSize, header, sizeof(header))) {
+            return false;
+        }
+        if (ByteOrder::readU32(header) != kMagic || ByteOrder::readU32(header + 12) != ModelImage::crc32(header, 12)) {
+            continue;   // 未使用，或擦除/写段头时掉电
+        }
+        Segment segment = { ByteOrder::readU32(header + 4), 0, ByteOrder::readU32(header + 8), (uint16_t)sector, false };
+        int i = _segmentCount++;
+        while (i > 0 && _segments[i - 1].sequence > segment.sequence) {
+            _segments[i] = _segments[i - 1];
+            i--;
+        }
+        _segments[i] = segment;
+        if (segment.eraseCount > _maxEraseCount) {
+            _maxEraseCount = segment.eraseCount;
+        }
+    }
+    if (_segmentCount == 0) {
+        return true;
+    }
+    _nextSequence = _segments[_segmentCount - 1].sequence + 1;
+
+    // 2. 较旧的段只读第一条记录作为索引；没有有效记录的段 (只可能是写第一条记录时掉电) 不再使用
+    for (int i = 0; i < _segmentCount - 1; ) {
+        RecordInfo info;
+        uint32_t sectorOffset = _segments[i].sector * kSectorSize;
+        ReadResult result = readRecord(sectorOffset, kSegmentHeaderSize, &info, nullptr, 0);
+        if (result == ReadResult::OK) {
+            _segments[i].firstTimestamp = info.firstTimestamp;
+            _segments[i].hasRecords = true;
+            i++;
+        } else {
+            if (result == ReadResult::CORRUPT) {
+                _tornRecords++;
+            }
+            removeSegmentAt(i);
+        }
+    }
+
+    // 3. 最新的段完整扫描，得到写入位置与最新的时间
+    Segment& head = _segments[_segmentCount - 1];
+    uint32_t lastTimestamp = 0;
+    int records = 0;
+    bool clean = scanSegment(head, &_writeOffset, &lastTimestamp, &records);
+    if (!clean) {
+        // 段尾有写入中掉电的记录: 这些字节无法重写，之后的记录写到新的一段
+        _tornRecords++;
+        _sealed = true;
+    } else {
+        _sealed = false;
+    }
+    if (records > 0) {
+        RecordInfo info;
+        readRecord(head.sector * kSectorSize, kSegmentHeaderSize, &info, nullptr, 0);
+        head.firstTimestamp = info.firstTimestamp;
+        head.hasRecords = true;
+        _newestTimestamp = lastTimestamp;
+    } else if (_segmentCount >= 2) {
+        // 刚开始的空段: 最新的时间在上一段中
+        uint32_t end;
+        int previousRecords;
+        scanSegment(_segments[_segmentCount - 2], &end, &_newestTimestamp, &previousRecords);
+        head.firstTimestamp = _newestTimestamp;
+    }
+    return true;
+}
+
+TimeSeriesStore::ReadResult TimeSeriesStore::readRecord(uint32_t sectorOffset, uint32_t offset, RecordInfo* info,
+                                                        uint8_t* payload, size_t capacity) {
+    if (offset + kRecordOverhead > kSectorSize) {
+        return ReadResult::END;
+    }
+    uint8_t header[kRecordHeaderSize];
+    if (!_partition.read(sectorOffset + offset, header, sizeof(header))) {
+        return ReadResult::CORRUPT;
+    }
+    uint16_t length = ByteOrder::readU16(header);
+    if (length == kErasedLength) {
+        return ReadResult::END;
+    }
+    if (length > kMaxPayloadSize || offset + recordSize(length) > kSectorSize) {
+        return ReadResult::CORRUPT;
+    }
+
+    // CRC 覆盖记录头与payload；不需要payload时分块读取校验
+    uint32_t crc = ModelImage::crc32(header, sizeof(header));
+    uint32_t payloadOffset = sectorOffset + offset + kRecordHeaderSize;
+    if (payload != nullptr && length <= capacity) {
+        if (!_partition.read(payloadOffset, payload, length)) {
+            return ReadResult::CORRUPT;
+        }
+        crc = ModelImage::crc32(payload, length, crc);
+    } else {
+        uint8_t chunk[64];
+        for (uint32_t pos = 0; pos < length; pos += sizeof(chunk)) {
+            size_t n = length - pos < sizeof(chunk) ? length - pos : sizeof(chunk);
+            if (!_partition.read(payloadOffset + pos, chunk, n)) {
+                return ReadResult::CORRUPT;
+            }
+            crc = ModelImage::crc32(chunk, n, crc);
+        }
+    }
+    uint8_t stored[4];
+    if (!_partition.read(payloadOffset + length, stored, sizeof(stored)) || ByteOrder::readU32(stored) != crc) {
+        return ReadResult::CORRUPT;
+    }
+
+    info->type = header[2];
+    info->firstTimestamp = ByteOrder::readU32(header + 4);
+    info->lastTimestamp = ByteOrder::readU32(header + 8);
+    info->length = length;
+    return ReadResult::OK;
+}
+
+bool TimeSeriesStore::scanSegment(const Segment& segment, uint32_t* end, uint32_t* lastTimestamp, int* records) {
+    uint32_t offset = kSegmentHeaderSize;
+    *records = 0;
+    while (true) {
+        RecordInfo info;
+        ReadResult result = readRecord(segment.sector * kSectorSize, offset, &info, nullptr, 0);
+        if (result != ReadResult::OK) {
+            *end = offset;
+            return result == ReadResult::END;
+        }
+        *lastTimestamp = info.lastTimestamp;
+        (*records)++;
+        offset += recordSize(info.length);
+    }
+}
+
+int TimeSeriesStore::findSegment(uint32_t sequence) const {
+    int lo = 0;
+    int hi = _segmentCount - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (_segments[mid].sequence == sequence) {
+            return mid;
+        }
+        if (_segments[mid].sequence < sequence) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -1;
+}
+
+void TimeSeriesStore::removeSegmentAt(int index) {
+    for (int i = index; i < _segmentCount - 1; i++) {
+        _segments[i] = _segments[i + 1];
+    }
+    _segmentCount--;
+}
+
+bool TimeSeriesStore::openSegment() {
+    // 段按物理顺序循环使用，分区写满时下一个扇区就是最旧的段
+    int sector = _segmentCount > 0 ? (_segments[_segmentCount - 1].sector + 1) % _sectorCount : 0;
+    for (int i = 0; i < _segmentCount; i++) {
+        if (_segments[i].sector == sector) {
+            removeSegmentAt(i);
+            break;
+        }
+    }
+
+    uint8_t header[kSegmentHeaderSize];
+    uint32_t eraseCount = 1;
+    if (_partition.read(sector * kSectorSize, header, sizeof(header)) &&
+        ByteOrder::readU32(header) == kMagic && ByteOrder::readU32(header + 12) == ModelImage::crc32(header, 12)) {
+        eraseCount = ByteOrder::readU32(header + 8) + 1;
+    }
+    _sealed = true;
+    if (!_partition.eraseSector(sector * kSectorSize)) {
+        return false;
+    }
+    ByteOrder::writeU32(header, kMagic);
+    ByteOrder::writeU32(header + 4, _nextSequence);
+    ByteOrder::writeU32(header + 8, eraseCount);
+    ByteOrder::writeU32(header + 12, ModelImage::crc32(header, 12));
+    if (!_partition.write(sector * kSectorSize, header, sizeof(header))) {
+        return false;
+    }
+
+    Segment segment = { _nextSequence, _newestTimestamp, eraseCount, (uint16_t)sector, false };
+    _segments[_segmentCount++] = segment;
+    _nextSequence++;
+    _writeOffset = kSegmentHeaderSize;
+    _sealed = false;
+    if (eraseCount > _maxEraseCount) {
+        _maxEraseCount = eraseCount;
+    }
+    return true;
+}
+
+bool TimeSeriesStore::append(uint8_t type, uint32_t firstTimestamp, uint32_t lastTimestamp,
+                             const uint8_t* payload, size_t length) {
+    if (_sectorCount < 2 || length > kMaxPayloadSize || lastTimestamp < firstTimestamp ||
+        firstTimestamp < _newestTimestamp) {
+        return false;
+    }
+    uint32_t size = recordSize(length);
+    if (_sealed || _segmentCount == 0 || _writeOffset + size > kSectorSize) {
+        if (!openSegment()) {
+            return false;
+        }
+    }
+
+    // 按顺序写入记录头、payload 与 CRC；中途掉电只留下一段前缀，CRC 校验失败
+    Segment& head = _segments[_segmentCount - 1];
+    uint32_t offset = head.sector * kSectorSize + _writeOffset;
+    uint8_t header[kRecordHeaderSize];
+    ByteOrder::writeU16(header, (uint16_t)length);
+    header[2] = type;
+    header[3] = 0xFF;
+    ByteOrder::writeU32(header + 4, firstTimestamp);
+    ByteOrder::writeU32(header + 8, lastTimestamp);
+    uint8_t crc[4];
+    ByteOrder::writeU32(crc, ModelImage::crc32(payload, length, ModelImage::crc32(header, sizeof(header))));
+    if (!_partition.write(offset, header, sizeof(header)) ||
+        (length > 0 && !_partition.write(offset + kRecordHeaderSize, payload, length)) ||
+        !_partition.write(offset + kRecordHeaderSize + length, crc, sizeof(crc))) {
+        _sealed = true;
+        return false;
+    }
+
+    _writeOffset += size;
+    if (!head.hasRecords) {
+        head.firstTimestamp = firstTimestamp;
+        head.hasRecords = true;
+    }
+    _newestTimestamp = lastTimestamp;
+    return true;
+}
+
+TimeSeriesStore::Cursor TimeSeriesStore::first() const {
+    Cursor cursor = { _segmentCount > 0 ? _segments[0].sequence : _nextSequence, (uint32_t)kSegmentHeaderSize };
+    return cursor;
+}
+
+bool TimeSeriesStore::locate(Cursor* cursor, RecordInfo* info, uint8_t* payload, size_t capacity) {
+    int index = findSegment(cursor->sequence);
+    if (index < 0) {
+        if (_segmentCount == 0 || cursor->sequence > _segments[_segmentCount - 1].sequence) {
+            return false;   // 已在末尾 (之后写入的记录仍可读到)
+        }
+        // 游标所在的段已被覆盖: 从最旧的段继续
+        *cursor = first();
+        index = 0;
+    }
+    while (true) {
+        ReadResult result = readRecord(_segments[index].sector * kSectorSize, cursor->offset, info, payload, capacity);
+        if (result == ReadResult::OK) {
+            return true;
+        }
+        if (index + 1 >= _segmentCount) {
+            return false;
+        }
+        index++;
+        cursor->sequence = _segments[index].sequence;
+        cursor->offset = kSegmentHeaderSize;
+    }
+}
+
+bool TimeSeriesStore::next(Cursor* cursor, RecordInfo* info, uint8_t* payload, size_t capacity) {
+    while (locate(cursor, info, payload, capacity)) {
+        cursor->offset += recordSize(info->length);
+        if (info->length <= capacity) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TimeSeriesStore::Cursor TimeSeriesStore::seek(uint32_t timestamp) {
+    // 最后一个起始时间早于 timestamp 的段: 时间戳不减，之前各段的记录都在该段开始前结束
+    int lo = 0;
+    int hi = _segmentCount - 1;
+    int start = 0;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (_segments[mid].firstTimestamp < timestamp) {
+            start = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    Cursor cursor = first();
+    if (_segmentCount > 0) {
+        cursor.sequence = _segments[start].sequence;
+    }
+    RecordInfo info;
+    while (locate(&cursor, &info, nullptr, 0)) {
+        if (info.lastTimestamp >= timestamp) {
+            break;
+        }
+        cursor.offset += recordSize(info.length);
+    }
+    return cursor;
+}
+
+bool TimeSeriesStore::clear() {
+    for (int sector = 0; sector < _sectorCount; sector++) {
+        if (!_partition.eraseSector(sector * kSectorSize)) {
+            return false;
+        }
+    }
+    _segmentCount = 0;
+    _sealed = true;
+    _writeOffset = 0;
+    _newestTimestamp = 0;
+    return true;
+}
+
+TimeSeriesStore::Stats TimeSeriesStore::getStats() const {
+    Stats stats;
+    stats.segments = _segmentCount;
+    stats.capacitySegments = _sectorCount;
+    stats.oldestTimestamp = 0;
+    for (int i = 0; i < _segmentCount; i++) {
+        if (_segments[i].hasRecords) {
+            stats.oldestTimestamp = _segments[i].firstTimestamp;
+            break;
+        }
+    }
+    stats.newestTimestamp = _newestTimestamp;
+    stats.maxEraseCount = _maxEraseCount;
+    stats.recoveredTornRecords = _tornRecords;
+    return stats;
+}
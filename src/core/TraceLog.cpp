@@ -0,0 +1,218 @@
+#include "TraceLog.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+namespace {
+    const char* const kNames[TraceLog::ID_COUNT] = {
+        "GlucoseCalculator::performMeasurement",
+        "GlucoseCalculator::performAdaptiveMeasurement",
+        "SignalReader::getRawValue",
+        "Max30102Controller::update",
+        "SpO2Algorithm::calculate",
+        "Dht22Controller::readData",
+        "GlucosePredictor::predictCurve",
+        "GlucosePredictor::runInference",
+        "BleTransport::send"
+    };
+
+    const char kPhases[] = { 'B', 'E', 'i' };
+
+    // 主机上的事件都记在 Arduino loop() 所在的核心上
+    constexpr int kHostCore = 1;
+
+#ifndef ESP_PLATFORM
+    // 主机上以线程局部变量的地址区分线程
+    thread_local char hostThreadTag;
+#endif
+
+    uintptr_t currentTaskHandle() {
+#ifdef ESP_PLATFORM
+        return (uintptr_t)xTaskGetCurrentTaskHandle();
+#else
+        return (uintptr_t)&hostThreadTag;
+#endif
+    }
+}
+
+TraceLog& TraceLog::getInstance() {
+    static TraceLog instance;
+    return instance;
+}
+
+TraceLog::TraceLog() : _clock(nullptr) {
+    clear();
+}
+
+void TraceLog::begin(Clock clock) {
+    _clock.store(clock, std::memory_order_release);
+}
+
+void TraceLog::clear() {
+    for (int c = 0; c < kCores; c++) {
+        _rings[c].head.store(0, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < kRingSize; i++) {
+            _rings[c].slots[i].sequence.store(0, std::memory_order_relaxed);
+        }
+    }
+    for (int t = 0; t < kMaxTasks; t++) {
+        _tasks[t].named.store(false, std::memory_order_relaxed);
+        _tasks[t].handle.store(0, std::memory_order_relaxed);
+    }
+}
+
+int TraceLog::currentCore() {
+#ifdef ESP_PLATFORM
+    return (int)xPortGetCoreID();
+#else
+    return kHostCore;
+#endif
+}
+
+// 按任务句柄查找，固件中任务不多，线性查找即可。已删除的任务的句柄被新任务复用时沿用原来的编号与名称
+int TraceLog::currentTask() {
+    uintptr_t handle = currentTaskHandle();
+    for (int t = 0; t < kMaxTasks; t++) {
+        TaskEntry& entry = _tasks[t];
+        uintptr_t owner = entry.handle.load(std::memory_order_acquire);
+        if (owner == 0) {
+            // 空闲的位置: 只有抢到的任务写入名称，没抢到的继续向后找
+            if (!entry.handle.compare_exchange_strong(owner, handle, std::memory_order_acq_rel)) {
+                continue;
+            }
+#ifdef ESP_PLATFORM
+            strncpy(entry.name, pcTaskGetName(nullptr), kTaskNameSize - 1);
+            entry.name[kTaskNameSize - 1] = '\0';
+#else
+            snprintf(entry.name, kTaskNameSize, "thread %u", (unsigned)(uint8_t)(t + 1));
+#endif
+            entry.named.store(true, std::memory_order_release);
+            return t + 1;
+        }
+        if (owner == handle) {
+            return t + 1;
+        }
+    }
+    return 0;
+}
+
+const char* TraceLog::getTaskName(int task) const {
+    if (task < 1 || task > kMaxTasks || !_tasks[task - 1].named.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return _tasks[task - 1].name;
+}
+
+void TraceLog::record(Id id, Phase phase, uint32_t arg) {
+    if (_clock.load(std::memory_order_relaxed) == nullptr) {
+        return;
+    }
+    record(id, phase, arg, currentCore(), currentTask());
+}
+
+void TraceLog::record(Id id, Phase phase, uint32_t arg, int core, int task) {
+    Clock clock = _clock.load(std::memory_order_acquire);
+    if (clock == nullptr || core < 0 || core >= kCores || task < 0 || task > kMaxTasks) {
+        return;
+    }
+    Ring& ring = _rings[core];
+    uint32_t position = ring.head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = ring.slots[position & (kRingSize - 1)];
+    // 先作废槽位，读取方看到序号不变才使用读出的内容。各字段按 release 写入: 读取方 (acquire) 读到新的字段时
+    // 一定也能看到作废，不需要单独的内存屏障 (ThreadSanitizer 不支持 atomic_thread_fence)
+    slot.sequence.store(0, std::memory_order_relaxed);
+    slot.timestampUs.store((uint32_t)clock(), std::memory_order_release);
+    slot.arg.store(arg, std::memory_order_release);
+    slot.header.store((uint32_t)id | ((uint32_t)phase << 8) | ((uint32_t)core << 16) | ((uint32_t)task << 24),
+                      std::memory_order_release);
+    slot.sequence.store(position + 1, std::memory_order_release);
+}
+
+int TraceLog::snapshot(int core, Event* out, int capacity) const {
+    if (core < 0 || core >= kCores || capacity <= 0) {
+        return 0;
+    }
+    const Ring& ring = _rings[core];
+    uint32_t head = ring.head.load(std::memory_order_acquire);
+    uint32_t count = head < kRingSize ? head : kRingSize;
+    if (count > (uint32_t)capacity) {
+        count = (uint32_t)capacity;
+    }
+    int n = 0;
+    for (uint32_t position = head - count; position != head; position++) {
+        const Slot& slot = ring.slots[position & (kRingSize - 1)];
+        uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != position + 1) {
+            continue;   // 正在写入或已被更新的事件覆盖
+        }
+        Event event;
+        event.timestampUs = slot.timestampUs.load(std::memory_order_acquire);
+        event.arg = slot.arg.load(std::memory_order_acquire);
+        uint32_t header = slot.header.load(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+        event.id = (uint8_t)header;
+        event.phase = (uint8_t)(header >> 8);
+        event.core = (uint8_t)(header >> 16);
+        event.task = (uint8_t)(header >> 24);
+        out[n++] = event;
+    }
+    return n;
+}
+
+uint32_t TraceLog::getRecordedCount(int core) const {
+    return core >= 0 && core < kCores ? _rings[core].head.load(std::memory_order_relaxed) : 0;
+}
+
+const char* TraceLog::getName(Id id) {
+    return id < ID_COUNT ? kNames[id] : "unknown";
+}
+
+void TraceLog::writeChromeJson(LineWriter write) const {
+    // 每个核心 kRingSize 个12字节的 Event，约12 KB，放在静态区而不占用调用方任务的栈
+    static Event events[kCores][kRingSize];
+    int counts[kCores];
+    // 时间戳相对所有核心中最早的事件 (按有符号差比较，micros() 的32位回绕不影响)
+    bool hasBase = false;
+    uint32_t base = 0;
+    for (int c = 0; c < kCores; c++) {
+        counts[c] = snapshot(c, events[c], kRingSize);
+        if (counts[c] > 0 && (!hasBase || (int32_t)(events[c][0].timestampUs - base) < 0)) {
+            base = events[c][0].timestampUs;
+            hasBase = true;
+        }
+    }
+
+    // 每个任务一条时间线: 同一核心上被抢占的任务的 B/E 不会与抢占它的任务交错。
+    // 任务在核心之间迁移时事件分在两个缓冲区中，查看器按 ts 排序，不影响配对
+    char line[160];
+    const char* separator = "";
+    write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (int t = 1; t <= kMaxTasks; t++) {
+        const char* name = getTaskName(t);
+        if (name == nullptr) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                 separator, t, name);
+        write(line);
+        separator = ",";
+    }
+    for (int c = 0; c < kCores; c++) {
+        for (int i = 0; i < counts[c]; i++) {
+            const Event& e = events[c][i];
+            const char* scope = e.phase == INSTANT ? ",\"s\":\"t\"" : "";
+            snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%u,\"pid\":1,\"tid\":%u%s,"
+                     "\"args\":{\"arg\":%u,\"core\":%u}}",
+                     separator, getName((Id)e.id), e.phase <= INSTANT ? kPhases[e.phase] : 'i',
+                     (unsigned)(e.timestampUs - base), (unsigned)e.task, scope, (unsigned)e.arg, (unsigned)e.core);
+            write(line);
+            separator = ",";
+        }
+    }
+    write("]}");
+}
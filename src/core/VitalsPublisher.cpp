@@ -0,0 +1,215 @@
+#include "VitalsPublisher.h"
+#include "ByteOrder.h"
+#include "BleEncoding.h"
+#include "PredictionCurve.h"
+#include <math.h>
+#include <string.h>
+
+namespace {
+    // ATT 通知的头部 (opcode + handle)
+    constexpr size_t kAttNotifyOverhead = 3;
+    constexpr size_t kMaxPacketSize = VitalsPublisher::kHeaderSize + 3 * 2 +
+                                      PredictionCurve::packetSize(VitalsPublisher::kMaxCurvePoints, true);
+}
+
+VitalsPublisher::VitalsPublisher(const Config& config) :
+    _config(config),
+    _mtu(kDefaultMtu),
+    _connectionIntervalMs(0),
+    _curveCount(0),
+    _curveHasInterval(false),
+    _sentCurveCount(0),
+    _sentCurveHasInterval(false),
+    _hasSent(false),
+    _lastSendMs(0),
+    _sequence(0),
+    _sentCount(0),
+    _suppressedCount(0)
+{
+    Scalar empty = { 0.0f, 0.0f, false, false };
+    _glucose = empty;
+    _heartRate = empty;
+    _spO2 = empty;
+}
+
+void VitalsPublisher::setGlucose(float mgdl) {
+    _glucose.value = mgdl;
+    _glucose.known = true;
+}
+
+void VitalsPublisher::setHeartRate(float bpm) {
+    _heartRate.value = bpm;
+    _heartRate.known = true;
+}
+
+void VitalsPublisher::setSpO2(float percent) {
+    _spO2.value = percent;
+    _spO2.known = true;
+}
+
+void VitalsPublisher::setCurve(const float* values, int count, const float* lower, const float* upper) {
+    _curveCount = count < 0 ? 0 : (count > kMaxCurvePoints ? kMaxCurvePoints : count);
+    _curveHasInterval = lower != nullptr && upper != nullptr;
+    for (int i = 0; i < _curveCount; i++) {
+        _curve[i] = values[i];
+        _lower[i] = _curveHasInterval ? lower[i] : values[i];
+        _upper[i] = _curveHasInterval ? upper[i] : values[i];
+    }
+}
+
+void VitalsPublisher::setMtu(uint16_t mtu) {
+    _mtu = mtu > kDefaultMtu ? mtu : kDefaultMtu;
+}
+
+void VitalsPublisher::setConnectionIntervalMs(uint32_t ms) {
+    _connectionIntervalMs = ms;
+}
+
+void VitalsPublisher::onConnect() {
+    _hasSent = false;
+    _glucose.sent = false;
+    _heartRate.sent = false;
+    _spO2.sent = false;
+    _sentCurveCount = 0;
+}
+
+bool VitalsPublisher::scalarChanged(const Scalar& s, float deadband) {
+    return s.known && (!s.sent || fabsf(s.value - s.sentValue) > deadband);
+}
+
+bool VitalsPublisher::curveChanged() const {
+    if (_curveCount != _sentCurveCount || _curveHasInterval != _sentCurveHasInterval) {
+        return true;
+    }
+    for (int i = 0; i < _curveCount; i++) {
+        if (fabsf(_curve[i] - _sentCurve[i]) > _config.curveDeadband) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t VitalsPublisher::changedFields(uint32_t nowMs) const {
+    bool heartbeat = !_hasSent || nowMs - _lastSendMs >= _config.maxSilenceMs;
+    uint8_t fields = 0;
+    if (_glucose.known && (heartbeat || scalarChanged(_glucose, _config.glucoseDeadband))) fields |= FIELD_GLUCOSE;
+    if (_heartRate.known && (heartbeat || scalarChanged(_heartRate, _config.heartRateDeadband))) fields |= FIELD_HEART_RATE;
+    if (_spO2.known && (heartbeat || scalarChanged(_spO2, _config.spO2Deadband))) fields |= FIELD_SPO2;
+    if (_curveCount > 0 && (heartbeat || curveChanged())) fields |= FIELD_CURVE;
+    return fields;
+}
+
+size_t VitalsPublisher::buildPacket(uint32_t nowMs, uint32_t timestamp, uint8_t* out, size_t capacity) const {
+    uint8_t fields = changedFields(nowMs);
+    if (fields == 0) {
+        return 0;
+    }
+    size_t limit = (size_t)_mtu - kAttNotifyOverhead;
+    if (capacity < limit) limit = capacity;
+    if (limit < kHeaderSize + 3 * 2) {
+        return 0;
+    }
+
+    out[0] = kPacketVersion;
+    ByteOrder::writeU16(out + 2, _sequence);
+    ByteOrder::writeU16(out + 4, (uint16_t)timestamp);
+    ByteOrder::writeU16(out + 6, (uint16_t)(timestamp >> 16));
+    size_t length = kHeaderSize;
+    if (fields & FIELD_GLUCOSE) { BleEncoding::writeSfloat(out + length, _glucose.value); length += 2; }
+    if (fields & FIELD_HEART_RATE) { BleEncoding::writeSfloat(out + length, _heartRate.value); length += 2; }
+    if (fields & FIELD_SPO2) { BleEncoding::writeSfloat(out + length, _spO2.value); length += 2; }
+
+    if (fields & FIELD_CURVE) {
+        // 放不下时先去掉预测区间，再截短曲线
+        size_t room = limit - length;
+        bool withInterval = _curveHasInterval && PredictionCurve::packetSize(_curveCount, true) <= room;
+        int count = _curveCount;
+        if (!withInterval && PredictionCurve::packetSize(count) > room) {
+            count = room > PredictionCurve::kCurvePacketHeaderSize ? (int)((room - PredictionCurve::kCurvePacketHeaderSize) / 2) : 0;
+        }
+        PredictionCurve::Curve curve = { _curve, count };
+        size_t curveLength = count > 0
+            ? PredictionCurve::encodePacket(curve, _config.curveStepMinutes, out + length, room,
+                                            withInterval ? _lower : nullptr, withInterval ? _upper : nullptr)
+            : 0;
+        if (curveLength == 0) {
+            fields &= ~FIELD_CURVE;
+        }
+        length += curveLength;
+    }
+    if (fields == 0) {
+        return 0;
+    }
+    out[1] = fields;
+    return length;
+}
+
+bool VitalsPublisher::poll(uint32_t nowMs, uint32_t timestamp, GattSink& sink) {
+    uint32_t minInterval = _config.minIntervalMs > _connectionIntervalMs ? _config.minIntervalMs : (uint32_t)_connectionIntervalMs;
+    if (_hasSent && nowMs - _lastSendMs < minInterval) {
+        _suppressedCount++;
+        return false;
+    }
+    uint8_t packet[kMaxPacketSize];
+    size_t length = buildPacket(nowMs, timestamp, packet, sizeof(packet));
+    if (length == 0) {
+        _suppressedCount++;
+        return false;
+    }
+    if (!sink.send(GattSink::Characteristic::VITALS, packet, length)) {
+        return false;   // 未连接或发送缓冲区已满，下一次重试
+    }
+
+    uint8_t fields = packet[1];
+    if (fields & FIELD_GLUCOSE) { _glucose.sentValue = _glucose.value; _glucose.sent = true; }
+    if (fields & FIELD_HEART_RATE) { _heartRate.sentValue = _heartRate.value; _heartRate.sent = true; }
+    if (fields & FIELD_SPO2) { _spO2.sentValue = _spO2.value; _spO2.sent = true; }
+    if (fields & FIELD_CURVE) {
+        // 因MTU截短时也记为已发送，否则每次都会重发同一条曲线
+        _sentCurveCount = _curveCount;
+        _sentCurveHasInterval = _curveHasInterval;
+        memcpy(_sentCurve, _curve, sizeof(float) * _curveCount);
+    }
+    _hasSent = true;
+    _lastSendMs = nowMs;
+    _sequence++;
+    _sentCount++;
+    return true;
+}
+
+uint32_t VitalsPublisher::getSentCount() const {
+    return _sentCount;
+}
+
+uint32_t VitalsPublisher::getSuppressedCount() const {
+    return _suppressedCount;
+}
+
+bool VitalsPublisher::decode(const uint8_t* packet, size_t length, Decoded* out) {
+    if (length < kHeaderSize || packet[0] != kPacketVersion) {
+        return false;
+    }
+    out->fields = packet[1];
+    out->sequence = ByteOrder::readU16(packet + 2);
+    out->timestamp = ByteOrder::readU16(packet + 4) | ((uint32_t)ByteOrder::readU16(packet + 6) << 16);
+    out->glucose = out->heartRate = out->spO2 = NAN;
+    out->curveCount = 0;
+    out->curveHasInterval = false;
+
+    size_t pos = kHeaderSize;
+    float* scalars[3] = { &out->glucose, &out->heartRate, &out->spO2 };
+    for (int i = 0; i < 3; i++) {
+        if (out->fields & (1 << i)) {
+            if (pos + 2 > length) return false;
+            *scalars[i] = BleEncoding::readSfloat(packet + pos);
+            pos += 2;
+        }
+    }
+    if (out->fields & FIELD_CURVE) {
+        uint8_t step = 0;
+        out->curveCount = PredictionCurve::decodePacket(packet + pos, length - pos, &step, out->curve, kMaxCurvePoints,
+                                                        out->lower, out->upper, &out->curveHasInterval);
+        return out->curveCount > 0;
+    }
+    return pos == length;
+}
@@ -0,0 +1,124 @@
+#include "WaveformCodec.h"
+#include "ByteOrder.h"
+
+namespace WaveformCodec {
+
+namespace {
+    // 差分按无符号运算，相差超过 int32 范围时回绕，解码时同样回绕
+    int32_t difference(int32_t a, int32_t b) {
+        return (int32_t)((uint32_t)a - (uint32_t)b);
+    }
+}
+
+size_t writeVarint(uint32_t value, uint8_t* out) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+size_t readVarint(const uint8_t* in, size_t length, uint32_t* value) {
+    uint32_t v = 0;
+    for (size_t i = 0; i < length && i < kMaxVarintSize; i++) {
+        v |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+        if ((in[i] & 0x80) == 0) {
+            *value = v;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+bool FrameEncoder::begin(const FrameHeader& header, uint8_t* out, size_t capacity) {
+    _out = out;
+    _capacity = capacity;
+    _length = 0;
+    _count = 0;
+    _channels = header.channels;
+    if (header.channels < 1 || header.channels > kMaxChannels || header.stream > 0x0F || capacity < kHeaderSize) {
+        _channels = 0;
+        return false;
+    }
+    for (int c = 0; c < kMaxChannels; c++) {
+        _previous[c] = 0;
+    }
+    out[0] = kFrameVersion;
+    out[1] = (uint8_t)((header.stream << 4) | header.channels);
+    ByteOrder::writeU16(out + 2, header.sequence);
+    ByteOrder::writeU32(out + 4, header.firstSample);
+    ByteOrder::writeU32(out + 8, header.timestampMs);
+    out[12] = header.periodMs;
+    out[13] = 0;
+    _length = kHeaderSize;
+    return true;
+}
+
+bool FrameEncoder::addSample(const int32_t* values) {
+    if (_channels == 0 || _count >= kMaxSamplesPerFrame) {
+        return false;
+    }
+    // 先编码到临时缓冲区，放不下时帧保持不变
+    uint8_t encoded[kMaxChannels * kMaxVarintSize];
+    size_t n = 0;
+    for (int c = 0; c < _channels; c++) {
+        n += writeVarint(zigzag(difference(values[c], _previous[c])), encoded + n);
+    }
+    if (_length + n > _capacity) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        _out[_length + i] = encoded[i];
+    }
+    _length += n;
+    for (int c = 0; c < _channels; c++) {
+        _previous[c] = values[c];
+    }
+    _count++;
+    return true;
+}
+
+size_t FrameEncoder::finish() {
+    if (_channels == 0 || _count == 0) {
+        return 0;
+    }
+    _out[13] = (uint8_t)_count;
+    return _length;
+}
+
+int decodeFrame(const uint8_t* packet, size_t length, FrameHeader* header, int32_t* samples, int maxSamples) {
+    if (length < kHeaderSize || packet[0] != kFrameVersion) {
+        return -1;
+    }
+    header->stream = packet[1] >> 4;
+    header->channels = packet[1] & 0x0F;
+    header->sequence = ByteOrder::readU16(packet + 2);
+    header->firstSample = ByteOrder::readU32(packet + 4);
+    header->timestampMs = ByteOrder::readU32(packet + 8);
+    header->periodMs = packet[12];
+    header->count = packet[13];
+    int channels = header->channels;
+    if (channels < 1 || channels > kMaxChannels || header->count > maxSamples) {
+        return -1;
+    }
+
+    int32_t previous[kMaxChannels] = { 0 };
+    size_t pos = kHeaderSize;
+    for (int i = 0; i < header->count; i++) {
+        for (int c = 0; c < channels; c++) {
+            uint32_t v;
+            size_t n = readVarint(packet + pos, length - pos, &v);
+            if (n == 0) {
+                return -1;
+            }
+            pos += n;
+            previous[c] = (int32_t)((uint32_t)previous[c] + (uint32_t)unzigzag(v));
+            samples[i * channels + c] = previous[c];
+        }
+    }
+    return pos == length ? header->count : -1;
+}
+
+} // namespace WaveformCodec
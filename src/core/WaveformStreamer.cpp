@@ -0,0 +1,113 @@
+#include "WaveformStreamer.h"
+
+namespace {
+    // ATT 通知的头部 (opcode + handle)
+    constexpr size_t kAttNotifyOverhead = 3;
+    constexpr uint16_t kDefaultMtu = 23;
+}
+
+WaveformStreamer::WaveformStreamer(const Config& config) :
+    _config(config),
+    _enabled(false),
+    _mtu(kDefaultMtu),
+    _head(0),
+    _count(0),
+    _firstIndex(0),
+    _sequence(0)
+{
+    if (_config.channels > WaveformCodec::kMaxChannels) {
+        _config.channels = WaveformCodec::kMaxChannels;
+    }
+    _stats = {0, 0, 0, 0};
+}
+
+void WaveformStreamer::setEnabled(bool enabled) {
+    _enabled = enabled;
+}
+
+bool WaveformStreamer::isEnabled() const {
+    return _enabled;
+}
+
+void WaveformStreamer::setMtu(uint16_t mtu) {
+    _mtu = mtu > kDefaultMtu ? mtu : kDefaultMtu;
+}
+
+void WaveformStreamer::addSample(const int32_t* values, uint32_t timestampMs) {
+    if (!_enabled) {
+        return;
+    }
+    if (_count == kCapacity) {
+        // 发送跟不上: 丢弃最旧的样本，序号照常推进，客户端从 firstSample 的缺口得知
+        _head = (_head + 1) % kCapacity;
+        _count--;
+        _firstIndex++;
+        _stats.dropped++;
+    }
+    int slot = (_head + _count) % kCapacity;
+    for (int c = 0; c < _config.channels; c++) {
+        _values[slot][c] = values[c];
+    }
+    _timestamps[slot] = timestampMs;
+    _count++;
+}
+
+int WaveformStreamer::poll(GattSink& sink) {
+    if (!_enabled) {
+        _firstIndex += _count;
+        _head = 0;
+        _count = 0;
+        return 0;
+    }
+    size_t capacity = (size_t)_mtu - kAttNotifyOverhead;
+    if (capacity > kMaxFrameSize) {
+        capacity = kMaxFrameSize;
+    }
+
+    int sent = 0;
+    while (_count > 0 && sent < _config.framesPerPoll) {
+        WaveformCodec::FrameHeader header = {
+            _config.stream, _config.channels, _sequence, _firstIndex, _timestamps[_head], _config.periodMs, 0
+        };
+        uint8_t frame[kMaxFrameSize];
+        WaveformCodec::FrameEncoder encoder;
+        if (!encoder.begin(header, frame, capacity)) {
+            break;
+        }
+        for (int i = 0; i < _count; i++) {
+            if (!encoder.addSample(_values[(_head + i) % kCapacity])) {
+                break;
+            }
+        }
+        size_t length = encoder.finish();
+        if (length == 0) {
+            // 最旧的样本单独也放不进一帧: 丢弃它，否则会一直卡在这里
+            _head = (_head + 1) % kCapacity;
+            _count--;
+            _firstIndex++;
+            _stats.dropped++;
+            continue;
+        }
+        if (!sink.send(GattSink::Characteristic::WAVEFORM, frame, length)) {
+            break;  // 通知队列已满或未连接，样本留在缓冲区中下一次重试
+        }
+        int n = encoder.getCount();
+        _head = (_head + n) % kCapacity;
+        _count -= n;
+        _firstIndex += n;
+        _sequence++;
+        _stats.samples += n;
+        _stats.frames++;
+        _stats.bytes += length;
+        sent++;
+    }
+    return sent;
+}
+
+int WaveformStreamer::pending() const {
+    return _count;
+}
+
+WaveformStreamer::Stats WaveformStreamer::getStats() const {
+    return _stats;
+}
@@ -0,0 +1,150 @@
+#include "config.h"
+
+#if !BLE_USE_NIMBLE
+
+#include "BluedroidTransport.h"
+#include "BleUuids.h"
+#include "TraceLog.h"
+
+// --- ServerCallbacks Implementation ---
+BluedroidTransport::ServerCallbacks::ServerCallbacks(BluedroidTransport& owner) : owner(owner) {}
+
+void BluedroidTransport::ServerCallbacks::onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+    owner.deviceConnected = true;
+    // The connection interval is in units of 1.25 ms
+    owner.listener->onConnect(param->connect.conn_params.interval * 5 / 4);
+}
+
+void BluedroidTransport::ServerCallbacks::onDisconnect(BLEServer* pServer) {
+    owner.deviceConnected = false;
+    // Advertising is restarted by the BLE task when it handles the disconnect event
+    owner.listener->onDisconnect();
+}
+
+void BluedroidTransport::ServerCallbacks::onMtuChanged(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+    owner.listener->onMtuChanged(param->mtu.mtu);
+}
+
+// --- WriteCallbacks Implementation ---
+BluedroidTransport::WriteCallbacks::WriteCallbacks(BluedroidTransport& owner, Characteristic characteristic)
+    : owner(owner), characteristic(characteristic) {}
+
+void BluedroidTransport::WriteCallbacks::onWrite(BLECharacteristic* pCharacteristic) {
+    std::string value = pCharacteristic->getValue();
+    owner.listener->onWrite(characteristic, (const uint8_t*)value.data(), value.size());
+}
+
+// --- BluedroidTransport Implementation ---
+BluedroidTransport::BluedroidTransport()
+    : pServer(nullptr), listener(nullptr), updatePasskey(0), deviceConnected(false), serverCallbacks(*this),
+      modelUpdateCallbacks(*this, Characteristic::MODEL_UPDATE), racpCallbacks(*this, Characteristic::RACP),
+      waveformCallbacks(*this, Characteristic::WAVEFORM), rollupCallbacks(*this, Characteristic::ROLLUP),
+      cccdCount(0) {
+    for (int i = 0; i < kCharacteristicCount; i++) {
+        characteristics[i] = nullptr;
+    }
+}
+
+BLECharacteristic* BluedroidTransport::createCharacteristic(BLEService* pService, BLEUUID uuid, uint32_t properties,
+                                                            Characteristic characteristic) {
+    BLECharacteristic* pChar = pService->createCharacteristic(uuid, properties);
+    if (properties & (BLECharacteristic::PROPERTY_NOTIFY | BLECharacteristic::PROPERTY_INDICATE)) {
+        pChar->addDescriptor(&cccds[cccdCount++]);
+    }
+    characteristics[(int)characteristic] = pChar;
+    return pChar;
+}
+
+void BluedroidTransport::setUpdatePasskey(uint32_t passkey) {
+    updatePasskey = passkey;
+}
+
+bool BluedroidTransport::begin(const char* deviceName, uint16_t preferredMtu, Listener* listener) {
+    this->listener = listener;
+    BLEDevice::init(deviceName);
+    // Ask for a larger MTU so a whole prediction curve fits in one notification
+    BLEDevice::setMTU(preferredMtu);
+    // Bonded LE Secure Connections with a static passkey shown to the user (we "display" it on the
+    // serial log); only the model update characteristic requires it, the others stay open
+    security.setStaticPIN(updatePasskey);
+    security.setAuthenticationMode(ESP_LE_AUTH_REQ_SC_MITM_BOND);
+    pServer = BLEDevice::createServer();
+    pServer->setCallbacks(&serverCallbacks);
+
+    const uint32_t readNotify = BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY;
+    // The default of 15 handles is too few: every notifying characteristic takes three
+    BLEService* pService = pServer->createService(BLEUUID(SERVICE_UUID), 32);
+    createCharacteristic(pService, BLEUUID(HEARTRATE_CHAR_UUID), readNotify, Characteristic::HEART_RATE);
+    createCharacteristic(pService, BLEUUID(SPO2_CHAR_UUID), readNotify, Characteristic::SPO2);
+    createCharacteristic(pService, BLEUUID(GLUCOSE_CHAR_UUID), readNotify, Characteristic::GLUCOSE);
+    createCharacteristic(pService, BLEUUID(PREDICTION_CHAR_UUID), readNotify, Characteristic::PREDICTION);
+    // Model update (see ModelStore.h for the packet format): writes need an encrypted, MITM-authenticated link
+    BLECharacteristic* pModelUpdate = createCharacteristic(pService, BLEUUID(MODEL_UPDATE_CHAR_UUID),
+                                                           BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_NOTIFY,
+                                                           Characteristic::MODEL_UPDATE);
+    pModelUpdate->setAccessPermissions(ESP_GATT_PERM_WRITE_ENC_MITM);
+    pModelUpdate->setCallbacks(&modelUpdateCallbacks);
+    // Composite vitals (see VitalsPublisher.h for the packet format)
+    createCharacteristic(pService, BLEUUID(VITALS_CHAR_UUID), readNotify, Characteristic::VITALS);
+    // Raw waveform stream, enabled by a write (see WaveformStreamer.h)
+    createCharacteristic(pService, BLEUUID(WAVEFORM_CHAR_UUID), BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_NOTIFY,
+                         Characteristic::WAVEFORM)->setCallbacks(&waveformCallbacks);
+    // Rollup history: a write selects the page, a read returns it (see RollupEngine.h)
+    createCharacteristic(pService, BLEUUID(ROLLUP_CHAR_UUID), BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_WRITE,
+                         Characteristic::ROLLUP)->setCallbacks(&rollupCallbacks);
+    pService->start();
+
+    // Standard Glucose Service: live measurements plus history download through RACP
+    BLEService* pGlsService = pServer->createService(BLEUUID(GLS_SERVICE_UUID));
+    createCharacteristic(pGlsService, BLEUUID(GLS_MEASUREMENT_UUID), BLECharacteristic::PROPERTY_NOTIFY, Characteristic::MEASUREMENT);
+    createCharacteristic(pGlsService, BLEUUID(GLS_CONTEXT_UUID), BLECharacteristic::PROPERTY_NOTIFY, Characteristic::CONTEXT);
+    createCharacteristic(pGlsService, BLEUUID(GLS_FEATURE_UUID), BLECharacteristic::PROPERTY_READ, Characteristic::FEATURE);
+    createCharacteristic(pGlsService, BLEUUID(GLS_RACP_UUID),
+                         BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_INDICATE,
+                         Characteristic::RACP)->setCallbacks(&racpCallbacks);
+    pGlsService->start();
+
+    // Start advertising
+    BLEAdvertising* pAdvertising = BLEDevice::getAdvertising();
+    pAdvertising->addServiceUUID(SERVICE_UUID);
+    pAdvertising->addServiceUUID(BLEUUID(GLS_SERVICE_UUID));
+    pAdvertising->setScanResponse(true);
+    BLEDevice::startAdvertising();
+    return true;
+}
+
+bool BluedroidTransport::isConnected() const {
+    return deviceConnected;
+}
+
+void BluedroidTransport::startAdvertising() {
+    BLEDevice::startAdvertising();
+}
+
+void BluedroidTransport::setValue(Characteristic characteristic, const uint8_t* data, size_t length) {
+    BLECharacteristic* pChar = characteristics[(int)characteristic];
+    if (pChar != nullptr) {
+        pChar->setValue((uint8_t*)data, length);
+    }
+}
+
+bool BluedroidTransport::send(Characteristic characteristic, const uint8_t* data, size_t length) {
+    BLECharacteristic* pChar = characteristics[(int)characteristic];
+    if (!deviceConnected || pChar == nullptr) {
+        return false;
+    }
+    TRACE_SCOPE_ARG(BLE_NOTIFY, ((uint32_t)characteristic << 16) | length);
+    pChar->setValue((uint8_t*)data, length);
+    if (characteristic == Characteristic::RACP) {
+        pChar->indicate();
+    } else {
+        pChar->notify();
+    }
+    return true;
+}
+
+const char* BluedroidTransport::name() const {
+    return "Bluedroid";
+}
+
+#endif // !BLE_USE_NIMBLE
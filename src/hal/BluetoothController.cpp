@@ -1,111 +1,162 @@
 #include "BluetoothController.h"
-#include <BLE2902.h>
-#include <Arduino.h> // For String and dtostrf
-
-// You can generate your own unique UUIDs using an online generator
-#define SERVICE_UUID           "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
-#define HEARTRATE_CHAR_UUID    "beb5483e-36e1-4688-b7f5-ea07361b26a8"
-#define SPO2_CHAR_UUID         "c8c36394-8f48-472e-874b-632467a83a21"
-#define GLUCOSE_CHAR_UUID      "9e3b7e4c-6a8a-479c-897c-b35d37af2137"
-#define PREDICTION_CHAR_UUID   "a2e8a15a-e0a9-4888-a8a5-c344a178d076"
-
-// --- ServerCallbacks Implementation ---
-BluetoothController::ServerCallbacks::ServerCallbacks(bool& connectedFlag) : connectedFlag(connectedFlag) {}
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_system.h>
+#include <time.h>
+#include "config.h"
+#include "ModelStore.h"
+#include "Max30102Controller.h"
+#include "NvsKeyValueStore.h"
+
+#if SIMULATOR
+#include "SimBleTransport.h"
+#elif BLE_USE_NIMBLE
+#include "NimbleTransport.h"
+#else
+#include "BluedroidTransport.h"
+#endif
+
+namespace {
+    // The transport is a static object, so begin() only allocates what the stack itself needs
+#if SIMULATOR
+    // The host simulation's phone client drives this transport directly
+    SimBleTransport& transport = SimBleTransport::getInstance();
+#elif BLE_USE_NIMBLE
+    NimbleTransport transport;
+#else
+    BluedroidTransport transport;
+#endif
+
+    // Next GLS record sequence number, so a reboot doesn't hand out numbers the phone already has
+    NvsKeyValueStore recordSequenceStore("gls");
+
+    BlePeripheral::Config peripheralConfig() {
+        BlePeripheral::Config c;
+        c.compositeNotifications = BLE_COMPOSITE_NOTIFICATIONS;
+        c.textValues = BLE_TEXT_VALUES;
+        c.recordsPerPoll = GLS_RECORDS_PER_POLL;
+        c.maxCurvePoints = PREDICTION_MAX_HORIZON;
+        c.vitals.glucoseDeadband = BLE_DEADBAND_GLUCOSE_MGDL;
+        c.vitals.heartRateDeadband = BLE_DEADBAND_HEART_RATE_BPM;
+        c.vitals.spO2Deadband = BLE_DEADBAND_SPO2_PERCENT;
+        c.vitals.curveDeadband = BLE_DEADBAND_CURVE_MGDL;
+        c.vitals.minIntervalMs = BLE_MIN_NOTIFY_INTERVAL_MS;
+        c.vitals.maxSilenceMs = BLE_MAX_SILENCE_MS;
+        c.vitals.curveStepMinutes = PREDICTION_STEP_MINUTES;
+        c.ppgPeriodMs = Max30102Controller::kSamplePeriodMs;
+        c.waveformFramesPerPoll = WAVEFORM_FRAMES_PER_POLL;
+        return c;
+    }
 
-void BluetoothController::ServerCallbacks::onConnect(BLEServer* pServer) {
-    connectedFlag = true;
-    Serial.println("BLE Client Connected");
-}
+    // Pairing passkey for the model update characteristic: BLE_UPDATE_PASSKEY when set, otherwise a random
+    // 6-digit value generated on first boot and kept in NVS so bonded phones stay valid
+    uint32_t updatePasskey() {
+        if (BLE_UPDATE_PASSKEY != 0) {
+            return BLE_UPDATE_PASSKEY;
+        }
+        Preferences prefs;
+        prefs.begin("ble", false);
+        uint32_t passkey = prefs.getUInt("passkey", 0);
+        if (passkey == 0) {
+            passkey = 100000 + esp_random() % 900000;
+            prefs.putUInt("passkey", passkey);
+        }
+        prefs.end();
+        return passkey;
+    }
 
-void BluetoothController::ServerCallbacks::onDisconnect(BLEServer* pServer) {
-    connectedFlag = false;
-    Serial.println("BLE Client Disconnected");
-    // Restart advertising to allow new connections
-    pServer->getAdvertising()->start();
+    // Forwards model update packets to ModelStore; the status byte is notified back to the client
+    uint8_t handleModelUpdate(const uint8_t* packet, size_t length) {
+        return (uint8_t)ModelStore::getInstance().handleUpdatePacket(packet, length);
+    }
 }
 
-// --- BluetoothController Implementation ---
 BluetoothController& BluetoothController::getInstance() {
     static BluetoothController instance;
     return instance;
 }
 
-BluetoothController::BluetoothController() : pServer(nullptr), deviceConnected(false) {}
+BluetoothController::BluetoothController() : peripheral(transport, peripheralConfig()) {}
 
 void BluetoothController::begin(const std::string& deviceName) {
-    BLEDevice::init(deviceName);
-    pServer = BLEDevice::createServer();
-    pServer->setCallbacks(new ServerCallbacks(deviceConnected));
-    
-    BLEService *pService = pServer->createService(SERVICE_UUID);
-
-    // Create Heart Rate Characteristic
-    pHeartRateCharacteristic = pService->createCharacteristic(HEARTRATE_CHAR_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
-    pHeartRateCharacteristic->addDescriptor(new BLE2902());
-
-    // Create SpO2 Characteristic
-    pSpO2Characteristic = pService->createCharacteristic(SPO2_CHAR_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
-    pSpO2Characteristic->addDescriptor(new BLE2902());
-    
-    // Create Glucose Characteristic
-    pGlucoseCharacteristic = pService->createCharacteristic(GLUCOSE_CHAR_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
-    pGlucoseCharacteristic->addDescriptor(new BLE2902());
-
-    // Create Prediction Curve Characteristic
-    pPredictionCharacteristic = pService->createCharacteristic(PREDICTION_CHAR_UUID, BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
-    pPredictionCharacteristic->addDescriptor(new BLE2902());
-    
-    pService->start();
-    
-    // Start advertising
-    BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
-    pAdvertising->addServiceUUID(SERVICE_UUID);
-    pAdvertising->setScanResponse(true);
-    BLEDevice::startAdvertising();
-    
+    peripheral.setUpdateHandler(handleModelUpdate);
+    peripheral.getRecords().restoreSequence(recordSequenceStore, "next");
+    uint32_t passkey = updatePasskey();
+    transport.setUpdatePasskey(passkey);
+
+    uint32_t heapBefore = ESP.getFreeHeap();
+    uint32_t start = micros();
+    bool ok = peripheral.begin(deviceName.c_str(), BLE_PREFERRED_MTU);
+    uint32_t elapsed = micros() - start;
+    uint32_t heapAfter = ESP.getFreeHeap();
+    Serial.printf("BLE %s init: %u us, heap used %u bytes, free %u bytes\n", transport.name(),
+                  (unsigned)elapsed, (unsigned)(heapBefore - heapAfter), (unsigned)heapAfter);
+
+    if (!ok) {
+        Serial.println("Bluetooth service failed to start");
+        return;
+    }
+#if BLE_TASK_ENABLED
+    if (!peripheral.start(BLE_TASK_CORE, BLE_TASK_STACK_SIZE, BLE_TASK_PRIORITY, BLE_TASK_PERIOD_MS)) {
+        Serial.println("BLE task failed to start, polling from the main loop");
+    }
+#endif
+    Serial.printf("BLE model update passkey: %06u\n", (unsigned)passkey);
     Serial.println("Bluetooth service started. Waiting for a client connection...");
 }
 
 bool BluetoothController::isDeviceConnected() {
-    return deviceConnected;
+    return peripheral.isConnected();
 }
 
-// Helper function to convert float to string and update characteristic
-void updateCharacteristic(BLECharacteristic* pChar, float value) {
-    char buffer[10];
-    dtostrf(value, 4, 2, buffer); // Convert float to string, 4 total width, 2 decimal places
-    pChar->setValue(buffer);
-    pChar->notify();
+void BluetoothController::addPpgSample(uint32_t ir, uint32_t red) {
+    peripheral.addPpgSample(ir, red, millis());
 }
 
-void BluetoothController::updateHeartRate(float heartRate) {
-    if (deviceConnected) {
-        updateCharacteristic(pHeartRateCharacteristic, heartRate);
+void BluetoothController::addOpticalSample(uint16_t raw) {
+    peripheral.addOpticalSample(raw, millis());
+}
+
+bool BluetoothController::isWaveformStreaming() {
+    return peripheral.isWaveformStreaming();
+}
+
+void BluetoothController::addGlucoseRecord(uint32_t timestamp, float glucose) {
+    peripheral.addGlucoseRecord(timestamp, glucose);
+}
+
+void BluetoothController::addReading(uint32_t timestamp, float glucose) {
+    peripheral.addReading(timestamp, glucose);
+}
+
+RollupEngine& BluetoothController::getRollups() {
+    return peripheral.getRollups();
+}
+
+void BluetoothController::poll() {
+    // The BLE task owns poll() while it runs
+    if (!peripheral.isRunning()) {
+        peripheral.poll(millis(), (uint32_t)time(nullptr));
     }
 }
 
+BlePeripheral::QueueStats BluetoothController::getQueueStats() {
+    return peripheral.getQueueStats();
+}
+
+void BluetoothController::updateHeartRate(float heartRate) {
+    peripheral.updateHeartRate(heartRate, (uint32_t)time(nullptr));
+}
+
 void BluetoothController::updateSpO2(float spO2) {
-    if (deviceConnected) {
-        updateCharacteristic(pSpO2Characteristic, spO2);
-    }
+    peripheral.updateSpO2(spO2, (uint32_t)time(nullptr));
 }
 
 void BluetoothController::updateGlucose(float glucose) {
-    if (deviceConnected) {
-        updateCharacteristic(pGlucoseCharacteristic, glucose);
-    }
+    peripheral.updateGlucose(glucose, (uint32_t)time(nullptr));
 }
 
-void BluetoothController::updatePredictionCurve(float* curveData, int curveSize) {
-    if (deviceConnected) {
-        String payload = "";
-        for (int i = 0; i < curveSize; i++) {
-            payload += String(curveData[i], 1); // Append value with 1 decimal place
-            if (i < curveSize - 1) {
-                payload += ","; // Use comma as a separator
-            }
-        }
-        pPredictionCharacteristic->setValue(payload.c_str());
-        pPredictionCharacteristic->notify();
-    }
-}
\ No newline at end of file
+void BluetoothController::updatePredictionCurve(const float* curveData, int curveSize,
+                                                const float* lower, const float* upper) {
+    peripheral.updatePredictionCurve(curveData, curveSize, lower, upper);
+}
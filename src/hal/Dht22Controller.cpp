@@ -1,4 +1,5 @@
 #include "Dht22Controller.h"
+#include "TraceLog.h"
 
 // 获取单例实例
 Dht22Controller& Dht22Controller::getInstance() {
@@ -11,7 +12,8 @@ Dht22Controller::Dht22Controller() :
     _dht(PIN_DHT22_DATA, DHT22), // 告诉库我们用的是哪个引脚和哪个型号(DHT22)
     _lastTemperature(NAN),       // 使用NAN (Not-A-Number) 表示无效读数
     _lastHumidity(NAN),
-    _lastReadTime(0)
+    _lastReadTime(0),
+    _capture(nullptr)
 {
 }
 
@@ -20,6 +22,27 @@ void Dht22Controller::begin() {
 }
 
 bool Dht22Controller::readData() {
+    TRACE_SCOPE(DHT_READ);
+    if (_capture != nullptr && _capture->isReplaying()) {
+        bool ok;
+        float temperature;
+        float humidity;
+        if (!_capture->replayDht(&ok, &temperature, &humidity)) {
+            return false;
+        }
+        _lastTemperature = temperature;
+        _lastHumidity = humidity;
+        return ok;
+    }
+
+    bool ok = readSensor();
+    if (_capture != nullptr) {
+        _capture->recordDht(millis(), ok, _lastTemperature, _lastHumidity);
+    }
+    return ok;
+}
+
+bool Dht22Controller::readSensor() {
     // DHT22传感器两次读取之间至少需要2秒间隔。
     // millis() 返回开机以来的毫秒数。
     // 如果距离上次读取不足2000毫秒，则直接返回true，不执行新的硬件读取。
@@ -52,4 +75,8 @@ float Dht22Controller::getTemperature() {
 
 float Dht22Controller::getHumidity() {
     return _lastHumidity;
+}
+
+void Dht22Controller::setCapture(SensorCapture* capture) {
+    _capture = capture;
 }
\ No newline at end of file
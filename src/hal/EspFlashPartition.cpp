@@ -0,0 +1,30 @@
+#include "EspFlashPartition.h"
+
+EspFlashPartition::EspFlashPartition(esp_partition_subtype_t subtype, const char* label) :
+    _subtype(subtype),
+    _label(label),
+    _partition(nullptr)
+{
+}
+
+bool EspFlashPartition::begin() {
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, _subtype, _label);
+    return _partition != nullptr;
+}
+
+uint32_t EspFlashPartition::size() const {
+    // 不足一个扇区的尾部不使用
+    return _partition != nullptr ? _partition->size / kSectorSize * kSectorSize : 0;
+}
+
+bool EspFlashPartition::read(uint32_t offset, void* out, size_t length) {
+    return _partition != nullptr && esp_partition_read(_partition, offset, out, length) == ESP_OK;
+}
+
+bool EspFlashPartition::write(uint32_t offset, const void* data, size_t length) {
+    return _partition != nullptr && esp_partition_write(_partition, offset, data, length) == ESP_OK;
+}
+
+bool EspFlashPartition::eraseSector(uint32_t offset) {
+    return _partition != nullptr && esp_partition_erase_range(_partition, offset, kSectorSize) == ESP_OK;
+}
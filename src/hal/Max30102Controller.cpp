@@ -1,4 +1,5 @@
 #include <Max30102Controller.h>
+#include <TraceLog.h>
 
 // 获取单例实例
 Max30102Controller& Max30102Controller::getInstance() {
@@ -11,7 +12,9 @@ Max30102Controller::Max30102Controller() :
     _heartRate(0.0f),
     _spO2(0.0f),
     _irValue(0),
-    _redValue(0)
+    _redValue(0),
+    _sampleCallback(nullptr),
+    _capture(nullptr)
 {
 }
 
@@ -21,9 +24,9 @@ bool Max30102Controller::begin() {
     }
     
     // Configure sensor settings for SpO2 calculation
-    uint8_t sampleAverage = 4;      // Options: 1, 2, 4, 8, 16, 32
+    uint8_t sampleAverage = kSampleAverage; // Options: 1, 2, 4, 8, 16, 32
     uint8_t ledMode = 2;            // Options: 1 = Red only, 2 = Red + IR, 3 = Red + IR + Green. We need 2.
-    uint16_t sampleRate = 100;      // Options: 50, 100, 200, 400... Must match FS in algorithm.
+    uint16_t sampleRate = kSampleRate;      // Options: 50, 100, 200, 400... Must match FS in algorithm.
     uint16_t pulseWidth = 411;      // Options: 69, 118, 215, 411. This fixes the warning.
     uint16_t adcRange = 4096;       // Options: 2048, 4096, 8192, 16384
     uint8_t ledBrightness = 0x24;   // A good starting point (~7mA). Range: 0-255.
@@ -37,15 +40,34 @@ bool Max30102Controller::begin() {
 }
 
 void Max30102Controller::update() {
-    // Check the sensor for new data
-    _particleSensor.check();
+    TRACE_SCOPE(PPG_UPDATE);
+    uint32_t ir[SensorCapture::kMaxFifoSamples];
+    uint32_t red[SensorCapture::kMaxFifoSamples];
+    int n = 0;
 
-    // Process all available samples from the FIFO buffer
-    while (_particleSensor.available()) {
-        _irValue = _particleSensor.getIR();
-        _redValue = _particleSensor.getRed();
-        _spo2_calculator.update(_irValue, _redValue);
-        _particleSensor.nextSample();
+    if (_capture != nullptr && _capture->isReplaying()) {
+        // Replay: the samples this update() read while capturing
+        while ((n = _capture->replayFifo(ir, red)) > 0) {
+            processSamples(ir, red, n);
+        }
+    } else {
+        // Check the sensor for new data
+        _particleSensor.check();
+
+        // Process all available samples from the FIFO buffer
+        while (_particleSensor.available()) {
+            // getIR()/getRed() 会先等待下一个新样本再返回最新的样本，循环中要按顺序取出缓冲区中的样本
+            ir[n] = _particleSensor.getFIFOIR();
+            red[n] = _particleSensor.getFIFORed();
+            _particleSensor.nextSample();
+            if (++n == SensorCapture::kMaxFifoSamples || !_particleSensor.available()) {
+                processSamples(ir, red, n);
+                if (_capture != nullptr) {
+                    _capture->recordFifo(millis(), ir, red, n);
+                }
+                n = 0;
+            }
+        }
     }
 
     _heartRate = _spo2_calculator.get_heart_rate();
@@ -64,6 +86,25 @@ uint32_t Max30102Controller::getIRValue() {
     return _irValue;
 }
 
+void Max30102Controller::processSamples(const uint32_t* ir, const uint32_t* red, int count) {
+    for (int i = 0; i < count; i++) {
+        _irValue = ir[i];
+        _redValue = red[i];
+        _spo2_calculator.update(_irValue, _redValue);
+        if (_sampleCallback != nullptr) {
+            _sampleCallback(_irValue, _redValue);
+        }
+    }
+}
+
+void Max30102Controller::setSampleCallback(SampleCallback callback) {
+    _sampleCallback = callback;
+}
+
+void Max30102Controller::setCapture(SensorCapture* capture) {
+    _capture = capture;
+}
+
 bool Max30102Controller::isFingerDetected() {
     // A simple check. For a real product, a more robust finger detection
     // algorithm would be needed (e.g., checking signal quality).
@@ -0,0 +1,407 @@
+#include "ModelStore.h"
+#include "ByteOrder.h"
+#include <Preferences.h>
+
+namespace {
+    const char* const kPartitionLabels[ModelImage::kSlotCount] = { MODEL_PARTITION_LABEL_A, MODEL_PARTITION_LABEL_B };
+    const char* const kPrefsNamespace = "model";
+    constexpr uint32_t kSectorSize = 4096;
+}
+
+// 获取单例实例
+ModelStore& ModelStore::getInstance() {
+    static ModelStore instance;
+    return instance;
+}
+
+// 私有构造函数
+ModelStore::ModelStore() :
+    _activeSlot(-1),
+    _activeIsTrial(false),
+    _mappedBase(nullptr),
+    _mmapHandle(0),
+    _updateInProgress(false),
+    _updateSlot(-1),
+    _updateWritten(0),
+    _updateErasedEnd(0),
+    _updateCrc(0),
+    _restartRequested(false)
+{
+    for (int i = 0; i < ModelImage::kSlotCount; i++) {
+        _partitions[i] = nullptr;
+        _slotStatus[i] = { false, 0, ModelImage::ModelFormat::FLOAT32 };
+    }
+    _bootState = { -1, -1, 0 };
+    _trialProgress = { 0 };
+    _preferredFormat = ModelImage::ModelFormat::ANY;
+}
+
+bool ModelStore::begin() {
+    for (int i = 0; i < ModelImage::kSlotCount; i++) {
+        _partitions[i] = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                  (esp_partition_subtype_t)MODEL_PARTITION_SUBTYPE,
+                                                  kPartitionLabels[i]);
+        _slotStatus[i] = checkSlot(i);
+        Serial.printf("Model slot %s: %s (version %u, %s)\n", kPartitionLabels[i],
+                      _slotStatus[i].valid ? "valid" : "empty/invalid", (unsigned)_slotStatus[i].modelVersion,
+                      _slotStatus[i].format == ModelImage::ModelFormat::INT8 ? "int8" : "float32");
+    }
+
+    loadBootState();
+    return selectAndMap();
+}
+
+ModelImage::SlotStatus ModelStore::checkSlot(int slot) {
+    ModelImage::SlotStatus status = { false, 0, ModelImage::ModelFormat::FLOAT32 };
+    const esp_partition_t* part = _partitions[slot];
+    if (part == nullptr) {
+        return status;
+    }
+
+    uint8_t raw[ModelImage::kHeaderSize];
+    ModelImage::Header header;
+    if (esp_partition_read(part, 0, raw, sizeof(raw)) != ESP_OK ||
+        ModelImage::parseHeader(raw, part->size, &header) != ModelImage::ParseResult::OK) {
+        return status;
+    }
+
+    // 通过映射区直接计算CRC，无需把模型读入RAM
+    const void* mapped = nullptr;
+    spi_flash_mmap_handle_t handle;
+    if (esp_partition_mmap(part, 0, ModelImage::kHeaderSize + header.modelSize,
+                           ESP_PARTITION_MMAP_DATA, &mapped, &handle) != ESP_OK) {
+        return status;
+    }
+    status.valid = ModelImage::verifyPayload(header, (const uint8_t*)mapped + ModelImage::kHeaderSize);
+    status.modelVersion = header.modelVersion;
+    status.format = ModelImage::formatFromFlags(header.flags);
+    spi_flash_munmap(handle);
+    return status;
+}
+
+bool ModelStore::selectAndMap() {
+    unmapActive();
+
+    ModelImage::SlotDecision decision = ModelImage::selectSlot(_slotStatus, _bootState, MODEL_MAX_BOOT_ATTEMPTS, _preferredFormat);
+    if (decision.slot < 0) {
+        return false;
+    }
+
+    if (decision.trial) {
+        // 试运行前先记录尝试次数: 如果加载过程中崩溃重启，次数用完后会自动回滚
+        if (_bootState.pendingSlot != decision.slot) {
+            _bootState.pendingSlot = decision.slot;
+            _bootState.attempts = 0;
+        }
+        _bootState.attempts++;
+        saveBootState();
+    }
+
+    if (!mapSlot(decision.slot)) {
+        _slotStatus[decision.slot].valid = false;
+        return selectAndMap();
+    }
+    _activeIsTrial = decision.trial;
+    _trialProgress = { 0 };
+    Serial.printf("Model: using %s, version %u%s\n", kPartitionLabels[_activeSlot],
+                  (unsigned)_activeHeader.modelVersion, _activeIsTrial ? " (trial)" : "");
+    return true;
+}
+
+bool ModelStore::mapSlot(int8_t slot) {
+    const esp_partition_t* part = _partitions[slot];
+    uint8_t raw[ModelImage::kHeaderSize];
+    if (esp_partition_read(part, 0, raw, sizeof(raw)) != ESP_OK ||
+        ModelImage::parseHeader(raw, part->size, &_activeHeader) != ModelImage::ParseResult::OK) {
+        return false;
+    }
+
+    const void* mapped = nullptr;
+    if (esp_partition_mmap(part, 0, ModelImage::kHeaderSize + _activeHeader.modelSize,
+                           ESP_PARTITION_MMAP_DATA, &mapped, &_mmapHandle) != ESP_OK) {
+        return false;
+    }
+    _mappedBase = (const uint8_t*)mapped;
+    _activeSlot = slot;
+    return true;
+}
+
+void ModelStore::unmapActive() {
+    if (_mappedBase != nullptr) {
+        spi_flash_munmap(_mmapHandle);
+        _mappedBase = nullptr;
+    }
+    _activeSlot = -1;
+    _activeIsTrial = false;
+}
+
+const uint8_t* ModelStore::getModelData() const {
+    return _mappedBase != nullptr ? _mappedBase + ModelImage::kHeaderSize : nullptr;
+}
+
+size_t ModelStore::getModelSize() const {
+    return _mappedBase != nullptr ? _activeHeader.modelSize : 0;
+}
+
+uint32_t ModelStore::getModelVersion() const {
+    return _mappedBase != nullptr ? _activeHeader.modelVersion : 0;
+}
+
+uint32_t ModelStore::getModelCrc32() const {
+    return _mappedBase != nullptr ? _activeHeader.modelCrc32 : 0;
+}
+
+int8_t ModelStore::getActiveSlot() const {
+    return _activeSlot;
+}
+
+bool ModelStore::isActiveTrial() const {
+    return _activeSlot >= 0 && _activeIsTrial;
+}
+
+void ModelStore::confirmActiveModel() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    confirmActiveModelLocked();
+}
+
+void ModelStore::confirmActiveModelLocked() {
+    if (_activeSlot < 0 || !_activeIsTrial) {
+        return;
+    }
+    _bootState.confirmedSlot = _activeSlot;
+    _bootState.pendingSlot = -1;
+    _bootState.attempts = 0;
+    _activeIsTrial = false;
+    saveBootState();
+    Serial.printf("Model: %s confirmed\n", kPartitionLabels[_activeSlot]);
+}
+
+void ModelStore::reportInference(bool invoked, const float* outputs, int count) {
+    if (!isActiveTrial()) {
+        return;
+    }
+    static const ModelImage::TrialPolicy policy = {
+        MODEL_TRIAL_CONFIRM_INFERENCES, MODEL_TRIAL_MIN_OUTPUT_MGDL, MODEL_TRIAL_MAX_OUTPUT_MGDL
+    };
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!isActiveTrial()) {
+        // 等待锁期间另一次报告已经作出了结论
+        return;
+    }
+    switch (ModelImage::recordTrialInference(&_trialProgress, policy, invoked, outputs, count)) {
+        case ModelImage::TrialVerdict::CONFIRM:
+            confirmActiveModelLocked();
+            break;
+        case ModelImage::TrialVerdict::REJECT:
+            // 用完尝试次数: 下次启动时 selectSlot 回滚到已确认的槽位
+            Serial.printf("Model: %s produced an invalid prediction during trial, rolling back\n",
+                          kPartitionLabels[_activeSlot]);
+            _bootState.attempts = MODEL_MAX_BOOT_ATTEMPTS;
+            _activeIsTrial = false;
+            saveBootState();
+            _restartRequested = true;
+            break;
+        case ModelImage::TrialVerdict::PENDING:
+            break;
+    }
+}
+
+bool ModelStore::rejectActiveModel() {
+    if (_activeSlot < 0) {
+        return false;
+    }
+    Serial.printf("Model: %s failed to load, rolling back\n", kPartitionLabels[_activeSlot]);
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // 本次启动内不再尝试该槽位；如果它是待确认槽位，则放弃试运行
+    _slotStatus[_activeSlot].valid = false;
+    if (_bootState.pendingSlot == _activeSlot) {
+        _bootState.pendingSlot = -1;
+        _bootState.attempts = 0;
+    }
+    if (_bootState.confirmedSlot == _activeSlot) {
+        _bootState.confirmedSlot = -1;
+    }
+    saveBootState();
+    return selectAndMap();
+}
+
+bool ModelStore::isRestartRequested() const {
+    return _restartRequested;
+}
+
+void ModelStore::loadBootState() {
+    Preferences prefs;
+    prefs.begin(kPrefsNamespace, true);
+    _bootState.confirmedSlot = prefs.getChar("confirmed", -1);
+    _bootState.pendingSlot = prefs.getChar("pending", -1);
+    _bootState.attempts = prefs.getUChar("attempts", 0);
+    _preferredFormat = (ModelImage::ModelFormat)prefs.getUChar("format", MODEL_PREFERRED_FORMAT);
+    prefs.end();
+}
+
+void ModelStore::saveBootState() {
+    Preferences prefs;
+    prefs.begin(kPrefsNamespace, false);
+    prefs.putChar("confirmed", _bootState.confirmedSlot);
+    prefs.putChar("pending", _bootState.pendingSlot);
+    prefs.putUChar("attempts", _bootState.attempts);
+    prefs.end();
+}
+
+// =======================================================================
+// ==                         模型更新 (Model Update)                      ==
+// =======================================================================
+
+ModelStore::UpdateStatus ModelStore::handleUpdatePacket(const uint8_t* packet, size_t length) {
+    if (length < 1) {
+        return UpdateStatus::BAD_REQUEST;
+    }
+
+    // 与推理线程中的试运行结论互斥: 两者都会改写启动状态
+    std::lock_guard<std::mutex> lock(_mutex);
+    switch (packet[0]) {
+        case 0x01: // BEGIN (flags 可选，缺省为浮点模型)
+            if (length != 13 && length != 17) return UpdateStatus::BAD_REQUEST;
+            return beginUpdate(ByteOrder::readU32(packet + 1), ByteOrder::readU32(packet + 5), ByteOrder::readU32(packet + 9),
+                               length == 17 ? ByteOrder::readU32(packet + 13) : 0);
+        case 0x02: // DATA
+            if (length < 5) return UpdateStatus::BAD_REQUEST;
+            return writeUpdate(ByteOrder::readU32(packet + 1), packet + 5, length - 5);
+        case 0x03: // COMMIT
+            return commitUpdate();
+        case 0x04: // ABORT
+            abortUpdate();
+            return UpdateStatus::OK;
+        case 0x05: // SELECT_FORMAT
+            if (length != 2) return UpdateStatus::BAD_REQUEST;
+            return selectFormat((ModelImage::ModelFormat)packet[1]);
+        default:
+            return UpdateStatus::BAD_REQUEST;
+    }
+}
+
+ModelStore::UpdateStatus ModelStore::beginUpdate(uint32_t version, uint32_t size, uint32_t crc, uint32_t flags) {
+    int8_t target = ModelImage::updateTargetSlot(_activeSlot, _bootState.confirmedSlot);
+    if (target < 0) {
+        // 试运行结束之前另一个槽位是唯一的回退模型
+        return UpdateStatus::BAD_STATE;
+    }
+    const esp_partition_t* part = _partitions[target];
+    if (part == nullptr) {
+        return UpdateStatus::BAD_STATE;
+    }
+    if (size == 0 || size > part->size - ModelImage::kHeaderSize) {
+        return UpdateStatus::TOO_LARGE;
+    }
+
+    // 先擦除头部所在扇区，使目标槽位立即失效；其余扇区在写入时按需擦除，避免长时间阻塞
+    if (esp_partition_erase_range(part, 0, kSectorSize) != ESP_OK) {
+        return UpdateStatus::FLASH_ERROR;
+    }
+
+    _updateInProgress = true;
+    _updateSlot = target;
+    _updateHeader.modelVersion = version;
+    _updateHeader.modelSize = size;
+    _updateHeader.modelCrc32 = crc;
+    _updateHeader.flags = flags;
+    _updateWritten = 0;
+    _updateErasedEnd = kSectorSize;
+    _updateCrc = 0;
+    _slotStatus[target].valid = false;
+    Serial.printf("Model update: writing %u bytes (version %u) to %s\n",
+                  (unsigned)size, (unsigned)version, kPartitionLabels[target]);
+    return UpdateStatus::OK;
+}
+
+ModelStore::UpdateStatus ModelStore::writeUpdate(uint32_t offset, const uint8_t* data, size_t length) {
+    if (!_updateInProgress) {
+        return UpdateStatus::BAD_STATE;
+    }
+    if (offset != _updateWritten) {
+        return UpdateStatus::OUT_OF_ORDER;
+    }
+    if (length > _updateHeader.modelSize - _updateWritten) {
+        return UpdateStatus::TOO_LARGE;
+    }
+
+    const esp_partition_t* part = _partitions[_updateSlot];
+    uint32_t start = ModelImage::kHeaderSize + offset;
+    uint32_t end = start + length;
+    while (_updateErasedEnd < end) {
+        if (esp_partition_erase_range(part, _updateErasedEnd, kSectorSize) != ESP_OK) {
+            abortUpdate();
+            return UpdateStatus::FLASH_ERROR;
+        }
+        _updateErasedEnd += kSectorSize;
+    }
+    if (esp_partition_write(part, start, data, length) != ESP_OK) {
+        abortUpdate();
+        return UpdateStatus::FLASH_ERROR;
+    }
+
+    _updateCrc = ModelImage::crc32(data, length, _updateCrc);
+    _updateWritten += length;
+    return UpdateStatus::OK;
+}
+
+ModelStore::UpdateStatus ModelStore::commitUpdate() {
+    if (!_updateInProgress) {
+        return UpdateStatus::BAD_STATE;
+    }
+    if (_updateWritten != _updateHeader.modelSize || _updateCrc != _updateHeader.modelCrc32) {
+        abortUpdate();
+        return UpdateStatus::CRC_MISMATCH;
+    }
+
+    // 头部最后写入: 掉电发生在此之前时，槽位保持无效
+    uint8_t raw[ModelImage::kHeaderSize];
+    ModelImage::serializeHeader(_updateHeader, raw);
+    if (esp_partition_write(_partitions[_updateSlot], 0, raw, sizeof(raw)) != ESP_OK) {
+        abortUpdate();
+        return UpdateStatus::FLASH_ERROR;
+    }
+
+    // 再次从flash完整校验一遍写入结果
+    _slotStatus[_updateSlot] = checkSlot(_updateSlot);
+    if (!_slotStatus[_updateSlot].valid) {
+        abortUpdate();
+        return UpdateStatus::CRC_MISMATCH;
+    }
+
+    _bootState.pendingSlot = _updateSlot;
+    _bootState.attempts = 0;
+    saveBootState();
+
+    _updateInProgress = false;
+    _restartRequested = true;
+    Serial.printf("Model update: %s committed, restart to activate\n", kPartitionLabels[_updateSlot]);
+    return UpdateStatus::OK;
+}
+
+ModelStore::UpdateStatus ModelStore::selectFormat(ModelImage::ModelFormat format) {
+    if (format != ModelImage::ModelFormat::FLOAT32 && format != ModelImage::ModelFormat::INT8 &&
+        format != ModelImage::ModelFormat::ANY) {
+        return UpdateStatus::BAD_REQUEST;
+    }
+    Preferences prefs;
+    prefs.begin(kPrefsNamespace, false);
+    prefs.putUChar("format", (uint8_t)format);
+    prefs.end();
+
+    // 精度偏好在启动时生效
+    _preferredFormat = format;
+    _restartRequested = true;
+    return UpdateStatus::OK;
+}
+
+ModelImage::ModelFormat ModelStore::getModelFormat() const {
+    return _mappedBase != nullptr ? ModelImage::formatFromFlags(_activeHeader.flags) : ModelImage::ModelFormat::ANY;
+}
+
+void ModelStore::abortUpdate() {
+    _updateInProgress = false;
+    _updateSlot = -1;
+    _updateWritten = 0;
+}
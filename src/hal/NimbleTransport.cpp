@@ -0,0 +1,147 @@
+#include "config.h"
+
+#if BLE_USE_NIMBLE
+
+#include "NimbleTransport.h"
+#include "BleUuids.h"
+#include "TraceLog.h"
+
+// --- ServerCallbacks Implementation ---
+NimbleTransport::ServerCallbacks::ServerCallbacks(NimbleTransport& owner) : owner(owner) {}
+
+void NimbleTransport::ServerCallbacks::onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
+    owner.deviceConnected = true;
+    // The connection interval is in units of 1.25 ms
+    owner.listener->onConnect(desc->conn_itvl * 5 / 4);
+}
+
+void NimbleTransport::ServerCallbacks::onDisconnect(NimBLEServer* pServer) {
+    owner.deviceConnected = false;
+    // Advertising is restarted by the BLE task when it handles the disconnect event
+    owner.listener->onDisconnect();
+}
+
+void NimbleTransport::ServerCallbacks::onMTUChange(uint16_t mtu, ble_gap_conn_desc* desc) {
+    owner.listener->onMtuChanged(mtu);
+}
+
+// --- WriteCallbacks Implementation ---
+NimbleTransport::WriteCallbacks::WriteCallbacks(NimbleTransport& owner, Characteristic characteristic)
+    : owner(owner), characteristic(characteristic) {}
+
+void NimbleTransport::WriteCallbacks::onWrite(NimBLECharacteristic* pCharacteristic) {
+    NimBLEAttValue value = pCharacteristic->getValue();
+    owner.listener->onWrite(characteristic, value.data(), value.length());
+}
+
+// --- NimbleTransport Implementation ---
+NimbleTransport::NimbleTransport()
+    : pServer(nullptr), listener(nullptr), updatePasskey(0), deviceConnected(false), serverCallbacks(*this),
+      modelUpdateCallbacks(*this, Characteristic::MODEL_UPDATE), racpCallbacks(*this, Characteristic::RACP),
+      waveformCallbacks(*this, Characteristic::WAVEFORM), rollupCallbacks(*this, Characteristic::ROLLUP) {
+    for (int i = 0; i < kCharacteristicCount; i++) {
+        characteristics[i] = nullptr;
+    }
+}
+
+NimBLECharacteristic* NimbleTransport::createCharacteristic(NimBLEService* pService, const NimBLEUUID& uuid,
+                                                            uint32_t properties, Characteristic characteristic) {
+    // NimBLE adds the 0x2902 descriptor to notifying/indicating characteristics itself
+    NimBLECharacteristic* pChar = pService->createCharacteristic(uuid, properties);
+    characteristics[(int)characteristic] = pChar;
+    return pChar;
+}
+
+void NimbleTransport::setUpdatePasskey(uint32_t passkey) {
+    updatePasskey = passkey;
+}
+
+bool NimbleTransport::begin(const char* deviceName, uint16_t preferredMtu, Listener* listener) {
+    this->listener = listener;
+    NimBLEDevice::init(deviceName);
+    // Ask for a larger MTU so a whole prediction curve fits in one notification
+    NimBLEDevice::setMTU(preferredMtu);
+    // Bonded LE Secure Connections with a static passkey shown to the user (we "display" it on the
+    // serial log); only the model update characteristic requires it, the others stay open
+    NimBLEDevice::setSecurityAuth(true, true, true);
+    NimBLEDevice::setSecurityIOCap(BLE_HS_IO_DISPLAY_ONLY);
+    NimBLEDevice::setSecurityPasskey(updatePasskey);
+    pServer = NimBLEDevice::createServer();
+    // false: the callbacks are members, the server must not delete them
+    pServer->setCallbacks(&serverCallbacks, false);
+    // The BLE task restarts advertising after it has handled the disconnect (see startAdvertising())
+    pServer->advertiseOnDisconnect(false);
+
+    const uint32_t readNotify = NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY;
+    NimBLEService* pService = pServer->createService(SERVICE_UUID);
+    createCharacteristic(pService, NimBLEUUID(HEARTRATE_CHAR_UUID), readNotify, Characteristic::HEART_RATE);
+    createCharacteristic(pService, NimBLEUUID(SPO2_CHAR_UUID), readNotify, Characteristic::SPO2);
+    createCharacteristic(pService, NimBLEUUID(GLUCOSE_CHAR_UUID), readNotify, Characteristic::GLUCOSE);
+    createCharacteristic(pService, NimBLEUUID(PREDICTION_CHAR_UUID), readNotify, Characteristic::PREDICTION);
+    // Model update (see ModelStore.h for the packet format): writes need an encrypted, MITM-authenticated link
+    createCharacteristic(pService, NimBLEUUID(MODEL_UPDATE_CHAR_UUID),
+                         NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_ENC | NIMBLE_PROPERTY::WRITE_AUTHEN |
+                         NIMBLE_PROPERTY::NOTIFY,
+                         Characteristic::MODEL_UPDATE)->setCallbacks(&modelUpdateCallbacks);
+    // Composite vitals (see VitalsPublisher.h for the packet format)
+    createCharacteristic(pService, NimBLEUUID(VITALS_CHAR_UUID), readNotify, Characteristic::VITALS);
+    // Raw waveform stream, enabled by a write (see WaveformStreamer.h)
+    createCharacteristic(pService, NimBLEUUID(WAVEFORM_CHAR_UUID), NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY,
+                         Characteristic::WAVEFORM)->setCallbacks(&waveformCallbacks);
+    // Rollup history: a write selects the page, a read returns it (see RollupEngine.h)
+    createCharacteristic(pService, NimBLEUUID(ROLLUP_CHAR_UUID), NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE,
+                         Characteristic::ROLLUP)->setCallbacks(&rollupCallbacks);
+    pService->start();
+
+    // Standard Glucose Service: live measurements plus history download through RACP
+    NimBLEService* pGlsService = pServer->createService(NimBLEUUID(GLS_SERVICE_UUID));
+    createCharacteristic(pGlsService, NimBLEUUID(GLS_MEASUREMENT_UUID), NIMBLE_PROPERTY::NOTIFY, Characteristic::MEASUREMENT);
+    createCharacteristic(pGlsService, NimBLEUUID(GLS_CONTEXT_UUID), NIMBLE_PROPERTY::NOTIFY, Characteristic::CONTEXT);
+    createCharacteristic(pGlsService, NimBLEUUID(GLS_FEATURE_UUID), NIMBLE_PROPERTY::READ, Characteristic::FEATURE);
+    createCharacteristic(pGlsService, NimBLEUUID(GLS_RACP_UUID), NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::INDICATE,
+                         Characteristic::RACP)->setCallbacks(&racpCallbacks);
+    pGlsService->start();
+
+    // Start advertising
+    NimBLEAdvertising* pAdvertising = NimBLEDevice::getAdvertising();
+    pAdvertising->addServiceUUID(SERVICE_UUID);
+    pAdvertising->addServiceUUID(NimBLEUUID(GLS_SERVICE_UUID));
+    pAdvertising->setScanResponse(true);
+    return pAdvertising->start();
+}
+
+bool NimbleTransport::isConnected() const {
+    return deviceConnected;
+}
+
+void NimbleTransport::startAdvertising() {
+    NimBLEDevice::startAdvertising();
+}
+
+void NimbleTransport::setValue(Characteristic characteristic, const uint8_t* data, size_t length) {
+    NimBLECharacteristic* pChar = characteristics[(int)characteristic];
+    if (pChar != nullptr) {
+        pChar->setValue(data, length);
+    }
+}
+
+bool NimbleTransport::send(Characteristic characteristic, const uint8_t* data, size_t length) {
+    NimBLECharacteristic* pChar = characteristics[(int)characteristic];
+    if (!deviceConnected || pChar == nullptr) {
+        return false;
+    }
+    TRACE_SCOPE_ARG(BLE_NOTIFY, ((uint32_t)characteristic << 16) | length);
+    pChar->setValue(data, length);
+    if (characteristic == Characteristic::RACP) {
+        pChar->indicate();
+    } else {
+        pChar->notify();
+    }
+    return true;
+}
+
+const char* NimbleTransport::name() const {
+    return "NimBLE";
+}
+
+#endif // BLE_USE_NIMBLE
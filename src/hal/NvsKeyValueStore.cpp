@@ -0,0 +1,42 @@
+#include "NvsKeyValueStore.h"
+#include <Preferences.h>
+
+NvsKeyValueStore::NvsKeyValueStore(const char* nvsNamespace) :
+    _namespace(nvsNamespace)
+{
+}
+
+size_t NvsKeyValueStore::getBytes(const char* key, void* out, size_t capacity) {
+    Preferences prefs;
+    if (!prefs.begin(_namespace, true)) {
+        return 0;
+    }
+    size_t length = prefs.getBytesLength(key);
+    if (length == 0 || length > capacity) {
+        prefs.end();
+        return 0;
+    }
+    length = prefs.getBytes(key, out, capacity);
+    prefs.end();
+    return length;
+}
+
+bool NvsKeyValueStore::putBytes(const char* key, const void* data, size_t length) {
+    Preferences prefs;
+    if (!prefs.begin(_namespace, false)) {
+        return false;
+    }
+    bool ok = prefs.putBytes(key, data, length) == length;
+    prefs.end();
+    return ok;
+}
+
+bool NvsKeyValueStore::remove(const char* key) {
+    Preferences prefs;
+    if (!prefs.begin(_namespace, false)) {
+        return false;
+    }
+    bool ok = prefs.remove(key);
+    prefs.end();
+    return ok;
+}
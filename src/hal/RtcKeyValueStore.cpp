@@ -0,0 +1,59 @@
+#include "RtcKeyValueStore.h"
+#include "ModelImage.h"
+#include <esp_attr.h>
+#include <string.h>
+
+namespace {
+    constexpr uint32_t kMagic = 0x4B435452; // "RTCK"
+
+    struct Slot {
+        uint32_t magic;         // 写入完成后才设置，写入中途复位时内容无效
+        uint32_t keyCrc;
+        uint32_t length;
+        uint32_t crc;
+        uint8_t data[RtcKeyValueStore::kCapacity];
+    };
+
+    RTC_NOINIT_ATTR Slot slot;
+
+    uint32_t keyCrc(const char* key) {
+        return ModelImage::crc32((const uint8_t*)key, strlen(key));
+    }
+}
+
+RtcKeyValueStore& RtcKeyValueStore::getInstance() {
+    static RtcKeyValueStore instance;
+    return instance;
+}
+
+size_t RtcKeyValueStore::getBytes(const char* key, void* out, size_t capacity) {
+    if (slot.magic != kMagic || slot.keyCrc != keyCrc(key) || slot.length == 0 ||
+        slot.length > kCapacity || slot.length > capacity) {
+        return 0;
+    }
+    if (ModelImage::crc32(slot.data, slot.length) != slot.crc) {
+        return 0;
+    }
+    memcpy(out, slot.data, slot.length);
+    return slot.length;
+}
+
+bool RtcKeyValueStore::putBytes(const char* key, const void* data, size_t length) {
+    if (length == 0 || length > kCapacity) {
+        return false;
+    }
+    slot.magic = 0;
+    memcpy(slot.data, data, length);
+    slot.length = (uint32_t)length;
+    slot.keyCrc = keyCrc(key);
+    slot.crc = ModelImage::crc32(slot.data, length);
+    slot.magic = kMagic;
+    return true;
+}
+
+bool RtcKeyValueStore::remove(const char* key) {
+    if (slot.magic == kMagic && slot.keyCrc == keyCrc(key)) {
+        slot.magic = 0;
+    }
+    return true;
+}
@@ -1,4 +1,5 @@
 #include <SignalReader.h>
+#include <TraceLog.h>
 
 // 获取单例实例
 SignalReader& SignalReader::getInstance() {
@@ -8,7 +9,9 @@ SignalReader& SignalReader::getInstance() {
 
 // 私有构造函数
 SignalReader::SignalReader() :
-    _pin(PIN_ADC_IN) 
+    _pin(PIN_ADC_IN),
+    _sampleCallback(nullptr),
+    _capture(nullptr)
 {
     // 构造函数体为空
 }
@@ -20,22 +23,54 @@ void SignalReader::begin() {
     analogSetPinAttenuation(_pin, (adc_attenuation_t)ADC_ATTENUATION);
 }
 
-uint16_t SignalReader::getRawValue() {
+uint16_t SignalReader::getRawValue(int samples) {
+    TRACE_SCOPE_ARG(SIGNAL_READ, samples);
+    if (samples < 1) {
+        samples = 1;
+    }
+
     uint32_t sum = 0;
+    uint16_t block[SensorCapture::kMaxAdcSamples];
     
-    // 进行多次采样以求平均值，有效滤除高频噪声
-    for (int i = 0; i < ADC_SAMPLES_TO_AVERAGE; i++) {
-        sum += analogRead(_pin);
-        // 短暂延时可能有助于提高某些情况下ADC的稳定性，但对于快速采样可以省略
-        // delayMicroseconds(20); 
+    // 进行多次采样以求平均值，有效滤除高频噪声。按块读取，录制/回放时每块是一个事件
+    for (int first = 0; first < samples; first += SensorCapture::kMaxAdcSamples) {
+        int n = samples - first < SensorCapture::kMaxAdcSamples ? samples - first : SensorCapture::kMaxAdcSamples;
+        if (_capture != nullptr && _capture->isReplaying()) {
+            if (!_capture->replayAdc(block, n)) {
+                memset(block, 0, sizeof(block));    // 回放结束
+            }
+        } else {
+            for (int i = 0; i < n; i++) {
+                block[i] = analogRead(_pin);
+                // 短暂延时可能有助于提高某些情况下ADC的稳定性，但对于快速采样可以省略
+                // delayMicroseconds(20); 
+            }
+            if (_capture != nullptr) {
+                _capture->recordAdc(millis(), block, n);
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            sum += block[i];
+            if (_sampleCallback != nullptr) {
+                _sampleCallback(block[i]);
+            }
+        }
     }
 
-    return (uint16_t)(sum / ADC_SAMPLES_TO_AVERAGE);
+    return (uint16_t)(sum / samples);
+}
+
+void SignalReader::setSampleCallback(SampleCallback callback) {
+    _sampleCallback = callback;
+}
+
+void SignalReader::setCapture(SensorCapture* capture) {
+    _capture = capture;
 }
 
-float SignalReader::getVoltage() {
+float SignalReader::getVoltage(int samples) {
     // 1. 获取平均后的原始ADC值
-    uint16_t rawValue = getRawValue();
+    uint16_t rawValue = getRawValue(samples);
 
     // 2. 将12位ADC原始值 (0-4095) 转换为电压值。
     // 注意：ESP32的V_REF（参考电压）理论上是3.3V，但实际上可能存在偏差。
@@ -7,11 +7,259 @@
 #include "BluetoothController.h" 
 #include "LedController.h"
 #include "DemodulatorController.h"
+#include "ModelStore.h"
+#include "InferenceService.h"
+#include "NvsKeyValueStore.h"
+#include "RtcKeyValueStore.h"
+#include "StateCheckpoint.h"
+#include "EspFlashPartition.h"
+#include "TimeSeriesStore.h"
+#include "ReadingLog.h"
+#include "ReplayDriver.h"
+#include "TraceLog.h"
+#include <sys/time.h>
+#include <esp_system.h>
 
+// 暂时不能预测的原因
+const char* historyStatusText(HistoryResampler::Status status) {
+  switch (status) {
+    case HistoryResampler::Status::STALE:        return "Waiting for fresh readings...";
+    case HistoryResampler::Status::GAP_TOO_LONG: return "Gap in readings, re-collecting...";
+    default:                                     return "Collecting data for prediction...";
+  }
+}
+
+// RTC时间 (毫秒)，软件复位后继续计时，断电后从0开始
+uint64_t rtcNowMs() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return (uint64_t)tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+}
+
+// 预测历史与滤波器状态的检查点，重启后预测无需重新积累历史:
+// 每个读数之后写入RTC内存 (意外复位)，计划内的重启前另写入NVS (固件更新后RTC内存布局可能改变)
+const StateCheckpoint::Policy checkpointPolicy{
+  PREDICTOR_CHECKPOINT_READINGS, PREDICTOR_CHECKPOINT_INTERVAL_MS, PREDICTOR_CHECKPOINT_MAX_AGE_MS };
+StateCheckpoint rtcCheckpoint(RtcKeyValueStore::getInstance(), "state", checkpointPolicy);
+NvsKeyValueStore checkpointStore("checkpoint");
+StateCheckpoint checkpoint(checkpointStore, "state", checkpointPolicy);
+
+// 预测器是否加载成功，失败时只测量不预测
+bool predictorAvailable = false;
+
+// 上一次写入血糖服务历史记录的时间 (millis)
+unsigned long lastGlucoseRecordMs = 0;
+bool hasGlucoseRecord = false;
+
+#if READING_LOG_ENABLED
+// 读数历史，直接写入 spiffs 分区
+EspFlashPartition historyPartition(ESP_PARTITION_SUBTYPE_DATA_SPIFFS, READING_LOG_PARTITION_LABEL);
+TimeSeriesStore historyStore(historyPartition);
+ReadingLog readingLog(historyStore, READING_LOG_BLOCK_SIZE);
+bool readingLogReady = false;
+
+// 从flash中的读数历史重建降采样 (BLE任务启动之前)
+void rebuildRollups() {
+  static ReadingLog::Reading chunk[128];
+  RollupEngine& rollups = BluetoothController::getInstance().getRollups();
+  uint32_t startMs = millis();
+  uint32_t from = 0;
+  int total = 0;
+  int n;
+  while ((n = readingLog.read(from, 0xFFFFFFFF, chunk, 128)) > 0) {
+    for (int i = 0; i < n; i++) {
+      rollups.add(chunk[i].timestamp, chunk[i].glucose);
+    }
+    total += n;
+    // 与上一批最后一个读数同一秒的读数 (只在 RTC 复位后出现) 被跳过
+    if (chunk[n - 1].timestamp == 0xFFFFFFFF) break;
+    from = chunk[n - 1].timestamp + 1;
+  }
+  Serial.printf("Rollups rebuilt from %d readings in %u ms\n", total, (unsigned)(millis() - startMs));
+}
+#endif
+
+// 计入录制/回放输出的校验值 (只在录制或回放时)
+void digestOutputs(const float* values, int count) {
+  ReplayDriver::getInstance().digest(values, count);
+}
+
+// 恢复重启前的历史与滤波器状态 (仅限复位后不久，断电后RTC复位则重新积累)，RTC内存中的检查点较新，优先使用
+bool restoreCheckpoint() {
+  StateCheckpoint* sources[] = { &rtcCheckpoint, &checkpoint };
+  for (StateCheckpoint* source : sources) {
+    HistoryResampler restoredHistory(GlucosePredictor::getInstance().getHistory().getConfig());
+    GlucoseFilter::State restoredFilter;
+    if (source->restore(&restoredHistory, &restoredFilter, millis(), rtcNowMs()) == StateCheckpoint::RestoreResult::OK) {
+      GlucosePredictor::getInstance().restoreHistory(restoredHistory);
+      GlucoseCalculator::getInstance().restoreFilterState(restoredFilter);
+      Serial.print("Restored "); Serial.print(restoredHistory.size()); Serial.println(" readings from checkpoint.");
+      return true;
+    }
+  }
+  return false;
+}
+
+// 计划内的重启前 (关机回调) 写入最新状态
+void saveCheckpoint() {
+  ReplayDriver::getInstance().flush();
+  // 回放得到的状态不保存
+  if (ReplayDriver::getInstance().getMode() != SENSOR_CAPTURE_REPLAY) {
+    checkpoint.save(GlucosePredictor::getInstance().getHistory(), GlucoseCalculator::getInstance().getFilterState(),
+                    millis(), rtcNowMs());
+    GlucosePredictor::getInstance().saveStreamingState();
+  }
+#if READING_LOG_ENABLED
+  // 计划内的重启前写入未满的一块读数
+  if (readingLogReady) {
+    readingLog.flush();
+  }
+#endif
+}
+
+#if PREDICTOR_PROFILING || TRACE_ENABLED
+void printLine(const char* line) {
+  Serial.println(line);
+}
+
+// 串口命令: 'c' 按CSV、'j' 按JSON输出各算子的 Invoke() 耗时与arena用量；'t' 按 Chrome trace JSON 输出追踪事件
+void handleProfilingCommands() {
+  while (Serial.available() > 0) {
+    int command = Serial.read();
+#if PREDICTOR_PROFILING
+    const OpProfile* profile = GlucosePredictor::getInstance().getOpProfile();
+    if (command == 'c') {
+      profile->writeCsv(printLine);
+    } else if (command == 'j') {
+      profile->writeJson(printLine, GlucosePredictor::getInstance().getArenaUsedBytes(),
+                         GlucosePredictor::getInstance().getArenaSize());
+    }
+#endif
+#if TRACE_ENABLED
+    if (command == 't') {
+      TraceLog::getInstance().writeChromeJson(printLine);
+    }
+#endif
+  }
+}
+#endif
+
+// 串口输出预测曲线，有预测区间时每个点输出为 均值[下界..上界]
+void printPrediction(const float* curve, int size, const float* lower, const float* upper) {
+  for (int i = 0; i < size; i++) {
+    if (i > 0) Serial.print(",");
+    Serial.print(curve[i], 1);
+    if (lower != nullptr && upper != nullptr) {
+      Serial.print("["); Serial.print(lower[i], 1); Serial.print(".."); Serial.print(upper[i], 1); Serial.print("]");
+    }
+  }
+}
+
+// 预测曲线的唯一输出路径: 串口打印、计入回放的校验值，并通过蓝牙把整条曲线打包为一个通知发送
+void publishPrediction(const char* prefix, const float* curve, int size, const float* lower, const float* upper) {
+  Serial.print(prefix);
+  printPrediction(curve, size, lower, upper);
+  digestOutputs(curve, size);
+  BluetoothController& ble = BluetoothController::getInstance();
+  if (ble.isDeviceConnected() && size > 0) {
+    ble.updatePredictionCurve(curve, size, lower, upper);
+  }
+}
+
+#if WAVEFORM_STREAMING_ENABLED
+// 传感器的原始采样转发给BLE波形流 (客户端未开启时直接丢弃)
+void onPpgSample(uint32_t ir, uint32_t red) {
+  BluetoothController::getInstance().addPpgSample(ir, red);
+}
+
+void onOpticalSample(uint16_t raw) {
+  BluetoothController::getInstance().addOpticalSample(raw);
+}
+#endif
+
+// 两次测量之间的等待。波形流开启时分段等待，期间读出传感器FIFO并发送，避免FIFO溢出丢样本
+void waitForNextMeasurement(unsigned long intervalMs) {
+  // 回放时不等待
+  if (ReplayDriver::getInstance().endRound()) {
+    return;
+  }
+#if WAVEFORM_STREAMING_ENABLED
+  unsigned long start = millis();
+  while (BluetoothController::getInstance().isWaveformStreaming() && millis() - start < intervalMs) {
+    Max30102Controller::getInstance().update();
+    BluetoothController::getInstance().poll();
+    unsigned long remaining = intervalMs - (millis() - start);
+    delay(remaining < WAVEFORM_POLL_INTERVAL_MS ? remaining : WAVEFORM_POLL_INTERVAL_MS);
+  }
+  unsigned long elapsed = millis() - start;
+  if (elapsed < intervalMs) {
+    delay(intervalMs - elapsed);
+  }
+#else
+  delay(intervalMs);
+#endif
+}
+
+#if PREDICTOR_ASYNC_ENABLED
+// 在推理任务中运行模型，结果拷贝到请求的结果中 (集成模型依次拷贝均值、下界、上界)
+bool invokePredictor(const float* input, int inputSize, float* output, int* outputSize) {
+  PredictionCurve::Curve curve = GlucosePredictor::getInstance().runInference(input);
+  if (curve.size == 0) {
+    return false;
+  }
+  const Ensemble::Result* interval = GlucosePredictor::getInstance().getLastEnsembleResult();
+  int parts = interval != nullptr ? 3 : 1;
+  int size = curve.size < InferenceService::kMaxOutputSize / parts ? curve.size : InferenceService::kMaxOutputSize / parts;
+  memcpy(output, curve.data, sizeof(float) * size);
+  if (interval != nullptr) {
+    memcpy(output + size, interval->lower, sizeof(float) * size);
+    memcpy(output + 2 * size, interval->upper, sizeof(float) * size);
+  }
+  *outputSize = parts * size;
+  return true;
+}
+
+InferenceService inferenceService(invokePredictor);
+#endif
+
+// 一次推理得到未来 N 步的预测曲线 (单输出模型时 N = 1)，集成模型同时给出预测区间。
+// 异步推理时只提交请求，推理在另一个核心上进行 (推理变慢时未开始的旧请求会被新请求覆盖)，结果在 loop() 末尾取回。
+// 流式模型在 addGlucoseReading() 中已增量推理一步，开销很小，直接取结果；回放时也在主循环中推理，输出不受请求合并的影响
+void runPrediction() {
+  if (!predictorAvailable) {
+    Serial.print(" | Prediction unavailable");
+    return;
+  }
+  GlucosePredictor& predictor = GlucosePredictor::getInstance();
+  if (!predictor.isReadyToPredict()) {
+    Serial.print(" | "); Serial.print(historyStatusText(predictor.getHistoryStatus()));
+    return;
+  }
+#if PREDICTOR_ASYNC_ENABLED
+  if (!predictor.isStreaming() && !ReplayDriver::getInstance().isReplaying()) {
+    float window[GlucosePredictor::kMaxInputSize];
+    int windowSize = predictor.getInputWindow(window);
+    if (windowSize > 0) {
+      inferenceService.submit(window, windowSize);
+    }
+    return;
+  }
+#endif
+  PredictionCurve::Curve curve = predictor.predictCurve();
+  const Ensemble::Result* interval = predictor.getLastEnsembleResult();
+  publishPrediction(" | Predicted: ", curve.data, curve.size, interval != nullptr ? interval->lower : nullptr,
+                    interval != nullptr ? interval->upper : nullptr);
+  Serial.print(predictor.isStreaming() ? " (step " : " (invoke "); Serial.print(predictor.getLastInvokeUs());
+  Serial.print(" us, avg "); Serial.print(predictor.getAverageInvokeUs()); Serial.print(" us)");
+}
 
 void setup() {
   Serial.begin(SERIAL_BAUD_RATE);
   Serial.println("\n--- Non-invasive Glucose Monitor with Prediction ---");
+#if TRACE_ENABLED
+  // 在启动BLE与推理任务之前开始记录
+  TraceLog::getInstance().begin(micros);
+#endif
 
   // 初始化I2C
   Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL, I2C_CLOCK_SPEED);
@@ -25,38 +273,128 @@ void setup() {
     Serial.println("FATAL: MAX30102 sensor not found!"); while (1);
   }
 
+  // 校验并映射模型分区 (A/B槽)
+  if (!ModelStore::getInstance().begin()) {
+    Serial.println("WARNING: No valid model partition found.");
+  }
+
   // 初始化Core层
   GlucoseCalculator::getInstance().begin();
   
   // 初始化Prediction层
-  if (!GlucosePredictor::getInstance().begin()) {
-      Serial.println("FATAL: Failed to initialize TensorFlow Lite!"); while(1);
+  // 模型不能加载时 (例如包含没有TFLM内核的算子) 测量、记录与BLE照常运行，只是不预测
+  predictorAvailable = GlucosePredictor::getInstance().begin();
+  if (predictorAvailable) {
+    Serial.print("Predictor init: "); Serial.print(GlucosePredictor::getInstance().getInitTimeUs());
+    Serial.println(GlucosePredictor::getInstance().isQuantized() ? " us (int8 model)" : " us (float32 model)");
+    Serial.print("Tensor arena: "); Serial.print(GlucosePredictor::getInstance().getArenaUsedBytes());
+    Serial.print(" / "); Serial.print(GlucosePredictor::getInstance().getArenaSize());
+    Serial.println(GlucosePredictor::getInstance().isArenaInPsram() ? " bytes (PSRAM)" : " bytes (internal SRAM)");
+  } else {
+    Serial.println("ERROR: Failed to initialize TensorFlow Lite, running without prediction.");
   }
 
+  // 录制与回放都从初始状态开始，回放的结果才与录制时相同
+  if (ReplayDriver::getInstance().getMode() == SENSOR_CAPTURE_OFF) {
+    restoreCheckpoint();
+  }
+#if READING_LOG_ENABLED
+  readingLogReady = historyPartition.begin() && historyStore.begin();
+  if (readingLogReady) {
+    TimeSeriesStore::Stats stats = historyStore.getStats();
+    Serial.printf("Reading history: %d/%d segments, %u..%u, max erase count %u, %u torn records recovered\n",
+                  stats.segments, stats.capacitySegments, (unsigned)stats.oldestTimestamp,
+                  (unsigned)stats.newestTimestamp, (unsigned)stats.maxEraseCount, (unsigned)stats.recoveredTornRecords);
+    rebuildRollups();
+  } else {
+    Serial.println("WARNING: Reading history partition not available.");
+  }
+#endif
+
+  ReplayDriver::getInstance().begin();
+#if READING_LOG_ENABLED
+  if (ReplayDriver::getInstance().isReplaying()) {
+    // 回放的读数不写入历史
+    readingLogReady = false;
+  }
+#endif
+
+  // 计划内的重启 (例如提交新模型) 前把最新状态写入NVS
+  esp_register_shutdown_handler(saveCheckpoint);
+
+#if PREDICTOR_ASYNC_ENABLED
+  if (!inferenceService.start(INFERENCE_TASK_CORE, INFERENCE_TASK_STACK_SIZE, INFERENCE_TASK_PRIORITY)) {
+      Serial.println("FATAL: Failed to start the inference task!"); while(1);
+  }
+#endif
+
   // 2. 初始化蓝牙控制器，并设置设备名称
   BluetoothController::getInstance().begin("ESP32-Glucose-Monitor"); 
+#if WAVEFORM_STREAMING_ENABLED
+  Max30102Controller::getInstance().setSampleCallback(onPpgSample);
+  SignalReader::getInstance().setSampleCallback(onOpticalSample);
+#endif
 
-  // 开启信号源
+  // 开启信号源 (自适应测量模式下由 GlucoseCalculator 在每次测量时按需开启)
+#if !ADAPTIVE_GATE_OPTICS || !ADAPTIVE_MEASUREMENT_ENABLED
   LedController::getInstance().startPulsing();
   DemodulatorController::getInstance().start();
+#endif
 
   Serial.println("System ready. Place your finger on the sensor.");
 }
 
 void loop() {
+  // 回放结束后不再测量
+  if (!ReplayDriver::getInstance().beginRound()) {
+    delay(1000);
+    return;
+  }
+
+  // 通过BLE上传的新模型已提交，重启后以试运行方式加载
+  if (ModelStore::getInstance().isRestartRequested()) {
+    Serial.println("New model committed. Restarting...");
+    delay(500);
+    ESP.restart();
+  }
+
+#if PREDICTOR_PROFILING || TRACE_ENABLED
+  handleProfilingCommands();
+#endif
+
+#if ADAPTIVE_MEASUREMENT_ENABLED
+  GlucoseCalculator::Status status = GlucoseCalculator::getInstance().performAdaptiveMeasurement();
+#else
   GlucoseCalculator::Status status = GlucoseCalculator::getInstance().performMeasurement();
+#endif
 
   if (status == GlucoseCalculator::Status::SUCCESS) {
     // --- 步骤 1: 获取所有传感器和计算数据 ---
-    float glucose = GlucoseCalculator::getInstance().getLatestGlucoseValue();
+    // 使用卡尔曼平滑后的血糖值，原始值仅用于调试输出
+    float rawGlucose = GlucoseCalculator::getInstance().getLatestGlucoseValue();
+    float glucose = GlucoseCalculator::getInstance().getSmoothedGlucoseValue();
+    float trend = GlucoseCalculator::getInstance().getGlucoseVelocity();
+    float confidence = GlucoseCalculator::getInstance().getGlucoseConfidence();
     float heartRate = Max30102Controller::getInstance().getHeartRate();
     float spO2 = Max30102Controller::getInstance().getSpO2();
 
     // --- 步骤 2: 在串口监视器打印调试信息 ---
     Serial.print("Glucose: "); Serial.print(glucose, 2);
-    Serial.print(" mg/dL | HR: "); Serial.print(heartRate, 1);
+    Serial.print(" +/- "); Serial.print(confidence, 1);
+    Serial.print(" mg/dL (raw "); Serial.print(rawGlucose, 2);
+    Serial.print(", trend "); Serial.print(trend, 2);
+    Serial.print(" mg/dL/min) | HR: "); Serial.print(heartRate, 1);
     Serial.print(" bpm | SpO2: "); Serial.print(spO2, 1); Serial.print("%");
 
+    const GlucoseCalculator::MeasurementReport& report = GlucoseCalculator::getInstance().getLastReport();
+    Serial.print(" | Samples: "); Serial.print(report.subMeasurements);
+    Serial.print(" ("); Serial.print(report.elapsedMs); Serial.print(" ms, CI +/- ");
+    Serial.print(report.confidence, 2); Serial.print(report.converged ? ")" : ", budget)");
+
+    float outputs[] = { rawGlucose, glucose, trend, confidence, heartRate, spO2,
+                        GlucoseCalculator::getInstance().getSignalQuality() };
+    digestOutputs(outputs, sizeof(outputs) / sizeof(outputs[0]));
+
     // --- 步骤 3: 通过蓝牙发送实时数据 ---
     // 获取蓝牙控制器实例
     BluetoothController& ble = BluetoothController::getInstance();
@@ -65,29 +403,73 @@ void loop() {
         ble.updateHeartRate(heartRate);
         ble.updateSpO2(spO2);
     }
+    uint32_t readingTimestamp = (uint32_t)(rtcNowMs() / 1000);
+#if READING_LOG_ENABLED
+    if (readingLogReady) {
+      ReadingLog::Reading reading;
+      reading.timestamp = readingTimestamp;
+      reading.glucose = glucose;
+      reading.heartRate = heartRate;
+      reading.spo2 = spO2;
+      reading.temperature = Dht22Controller::getInstance().getTemperature();
+      reading.humidity = Dht22Controller::getInstance().getHumidity();
+      reading.quality = GlucoseCalculator::getInstance().getSignalQuality();
+      readingLog.add(reading);
+      // 降采样使用日志中的时间 (RTC 复位后平移过)，重启后从历史重建的结果与之一致
+      readingTimestamp = readingLog.newestTimestamp();
+    }
+#endif
+    ble.addReading(readingTimestamp, glucose);
+    // 无论是否连接都写入历史记录，手机重新连接后通过 RACP 补齐离线期间的测量。
+    // 与读数日志和降采样使用同一个时间，RTC 复位后 GLS 记录的时间同样不会回退
+    if (!hasGlucoseRecord || millis() - lastGlucoseRecordMs >= GLUCOSE_RECORD_INTERVAL_MS) {
+        ble.addGlucoseRecord(readingTimestamp, glucose);
+        lastGlucoseRecordMs = millis();
+        hasGlucoseRecord = true;
+    }
     
     // --- 步骤 4: 处理并发送预测数据 ---
-    GlucosePredictor::getInstance().addGlucoseReading(glucose);
-    if (GlucosePredictor::getInstance().isReadyToPredict()) {
-      // 注意: 当前 predict() 返回单个浮点数。
-      // 将来您实现曲线预测后，它会返回一个浮点数数组。
-      float predicted_glucose = GlucosePredictor::getInstance().predict();
-      
-      Serial.print(" | Predicted: "); Serial.print(predicted_glucose, 2);
-      
-      // 通过蓝牙发送预测数据
-      // 为了兼容，我们暂时将这个单点预测值作为只有一个元素的“曲线”来发送
-      if (ble.isDeviceConnected()) {
-          ble.updatePredictionCurve(&predicted_glucose, 1);
+    GlucosePredictor::getInstance().addGlucoseReading(glucose, ReplayDriver::getInstance().clock(millis()), GlucoseCalculator::getInstance().getSignalQuality());
+    if (ReplayDriver::getInstance().getMode() != SENSOR_CAPTURE_REPLAY) {
+      checkpoint.noteReading(rtcNowMs());
+      rtcCheckpoint.noteReading(rtcNowMs());
+      if (rtcCheckpoint.shouldSave(rtcNowMs())) {
+        rtcCheckpoint.save(GlucosePredictor::getInstance().getHistory(), GlucoseCalculator::getInstance().getFilterState(),
+                           millis(), rtcNowMs());
       }
-    } else {
-      Serial.print(" | Collecting data for prediction...");
     }
+    runPrediction();
     Serial.println(); // 换行
 
   } else if (status == GlucoseCalculator::Status::ERROR_NO_FINGER) {
     Serial.println("No finger detected. Please place your finger on the sensor.");
   }
 
-  delay(2000); // 每2秒测量一次
+#if PREDICTOR_ASYNC_ENABLED
+  // --- 取回异步推理的结果并发送 ---
+  InferenceService::Result result;
+  if (inferenceService.takeResult(&result) && result.ok) {
+    // 集成模型的结果依次为 均值、下界、上界 三段 (见 invokePredictor)
+    int size = result.outputSize;
+    const float* lower = nullptr;
+    const float* upper = nullptr;
+    if (GlucosePredictor::getInstance().isEnsemble()) {
+      size = result.outputSize / 3;
+      lower = result.output + size;
+      upper = result.output + 2 * size;
+    }
+    publishPrediction("Predicted: ", result.output, size, lower, upper);
+    InferenceService::Stats stats = inferenceService.getStats();
+    Serial.print(" (queue "); Serial.print(result.queueUs);
+    Serial.print(" us, invoke "); Serial.print(result.invokeUs);
+    Serial.print(" us, avg "); Serial.print(stats.avgInvokeUs);
+    Serial.print(" us, coalesced "); Serial.print(stats.coalesced); Serial.println(")");
+  }
+#endif
+
+  // 处理血糖服务的 RACP 请求，分批上报历史记录 (BLE任务运行时由该任务处理)
+  BluetoothController::getInstance().poll();
+
+  // 读数稳定后自动降低测量频率，不稳定时保持每2秒测量一次
+  waitForNextMeasurement(GlucoseCalculator::getInstance().getRecommendedIntervalMs());
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "Ensemble.h"
+#include "SequentialEstimator.h"
+#include <math.h>
+
+Ensemble::Ensemble(const Config& config) :
+    _config(config),
+    _memberCount(0),
+    _fn(nullptr),
+    _context(nullptr),
+    _fullRuns(0),
+    _skippedRuns(0)
+{
+    reset();
+}
+
+void Ensemble::setMembers(int count, MemberFn fn, void* context) {
+    _memberCount = count < 0 ? 0 : (count > kMaxMembers ? kMaxMembers : count);
+    _fn = fn;
+    _context = context;
+    reset();
+}
+
+int Ensemble::getMemberCount() const {
+    return _memberCount;
+}
+
+void Ensemble::reset() {
+    _hasFull = false;
+    _fullSteps = 0;
+    _fullMaxWidth = 0.0f;
+    _consecutiveSkips = 0;
+}
+
+bool Ensemble::canSkip(const float* primary, int steps) const {
+    if (!_hasFull || _memberCount < 2 || steps != _fullSteps ||
+        _consecutiveSkips >= _config.maxConsecutiveSkips || _fullMaxWidth > _config.tightWidth) {
+        return false;
+    }
+    // 主成员的预测变化超过区间允许的宽度时，上次的区间已不能代表当前的不确定度
+    for (int i = 0; i < steps; i++) {
+        if (fabsf(primary[i] - _fullPrimary[i]) > _config.tightWidth) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Ensemble::run(const float* input, Result* out) {
+    if (_memberCount == 0 || _fn == nullptr) {
+        return false;
+    }
+    int steps = 0;
+    if (!_fn(_context, 0, input, _outputs[0], &steps) || steps <= 0) {
+        return false;
+    }
+    if (steps > kMaxSteps) steps = kMaxSteps;
+
+    if (canSkip(_outputs[0], steps)) {
+        out->steps = steps;
+        out->members = 1;
+        out->skipped = true;
+        out->hasInterval = true;
+        for (int i = 0; i < steps; i++) {
+            out->mean[i] = _outputs[0][i] + _fullOffset[i];
+            out->lower[i] = out->mean[i] - _fullHalfWidth[i];
+            out->upper[i] = out->mean[i] + _fullHalfWidth[i];
+        }
+        _consecutiveSkips++;
+        _skippedRuns++;
+        return true;
+    }
+
+    // 完整运行: 推理失败的成员不参与合并，所有成员取共同的步数
+    int members = 1;
+    for (int m = 1; m < _memberCount; m++) {
+        int memberSteps = 0;
+        if (!_fn(_context, m, input, _outputs[members], &memberSteps) || memberSteps <= 0) {
+            continue;
+        }
+        if (memberSteps < steps) steps = memberSteps;
+        members++;
+    }
+    aggregate(_outputs, members, steps, out);
+    _consecutiveSkips = 0;
+    _fullRuns++;
+    if (!out->hasInterval) {
+        // 其余成员全部失败: 宽度为0的区间不能代表不确定度，也不能作为跳过的依据
+        _hasFull = false;
+        return true;
+    }
+
+    _hasFull = true;
+    _fullSteps = steps;
+    _fullMaxWidth = 0.0f;
+    for (int i = 0; i < steps; i++) {
+        _fullPrimary[i] = _outputs[0][i];
+        _fullOffset[i] = out->mean[i] - _outputs[0][i];
+        _fullHalfWidth[i] = 0.5f * (out->upper[i] - out->lower[i]);
+        if (out->upper[i] - out->lower[i] > _fullMaxWidth) {
+            _fullMaxWidth = out->upper[i] - out->lower[i];
+        }
+    }
+    return true;
+}
+
+void Ensemble::aggregate(const float (*outputs)[kMaxSteps], int members, int steps, Result* out) {
+    out->steps = steps;
+    out->members = members;
+    out->skipped = false;
+    out->hasInterval = members > 1;
+    // 新成员预测的95%预测区间: 样本标准差按 t 分布与均值本身的不确定度放大
+    float scale = members > 1 ? SequentialEstimator::tQuantile975(members - 1) * sqrtf(1.0f + 1.0f / members) : 0.0f;
+    for (int i = 0; i < steps; i++) {
+        float sum = 0.0f;
+        for (int m = 0; m < members; m++) {
+            sum += outputs[m][i];
+        }
+        float mean = sum / members;
+        float halfWidth = 0.0f;
+        if (members > 1) {
+            float squares = 0.0f;
+            for (int m = 0; m < members; m++) {
+                float d = outputs[m][i] - mean;
+                squares += d * d;
+            }
+            halfWidth = scale * sqrtf(squares / (members - 1));
+        }
+        out->mean[i] = mean;
+        out->lower[i] = mean - halfWidth;
+        out->upper[i] = mean + halfWidth;
+    }
+}
+
+uint32_t Ensemble::getFullRuns() const {
+    return _fullRuns;
+}
+
+uint32_t Ensemble::getSkippedRuns() const {
+    return _skippedRuns;
+}
@@ -1,12 +1,27 @@
 #include "GlucosePredictor.h"
-#include "tensorflow/lite/micro/all_ops_resolver.h"
-#include "tensorflow/lite/micro/micro_interpreter.h"
-#include "tensorflow/lite/schema/schema_generated.h"
-#include "tensorflow/lite/micro/all_ops_resolver.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/schema/schema_generated.h"
-#include "model_data.h" // 包含我们之前创建的模型占位符
+#include "tensorflow/lite/schema/schema_utils.h"
+#ifdef PREDICTOR_USE_ALL_OPS_RESOLVER
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#else
+#include "model_ops.h" // 由 tools/gen_op_resolver.py 根据模型生成
+#endif
+#if PREDICTOR_PROFILING
+#include "TflmOpProfiler.h"
+#endif
+#include "ModelStore.h"
+#include "Quantization.h"
+#include "TraceLog.h"
+#include "model_data.h" // 固件内置的后备模型 (const，位于flash中)
+#include "model_arena.h" // 由 tools/gen_arena_size.py 生成的 Tensor Arena 大小
+#include <esp_heap_caps.h>
+#include <esp_task_wdt.h>
+#include <Arduino.h>
+#include <Preferences.h>
+#include <sys/time.h>
+#include <new>
 
 // TFLite 命名空间
 namespace {
@@ -18,10 +33,106 @@ namespace {
     TfLiteTensor* output_tensor = nullptr;
 
     // Tensor Arena: TFLM运行时所需的内存池。
-    // !!重要!! 这个大小需要根据您的模型进行调整。如果太小，程序会崩溃。
-    // 您可以在模型加载后通过 interpreter->arena_used_bytes() 获取建议值。
-    constexpr int kTensorArenaSize = 4 * 1024; // 先分配4KB
-    uint8_t tensor_arena[kTensorArenaSize];
+    // 大小 kTensorArenaSize 由 tools/gen_arena_size.py 根据 dry run 测得的 arena_used_bytes() 生成 (见 model_arena.h)；
+    // 无法执行 dry run 时 (kModelArenaMeasured 为 false) 只是静态估算，启动时打印警告。
+    // 在 begin() 中动态分配: 内部SRAM放得下时优先使用内部SRAM，否则放到PSRAM。
+    uint8_t* tensor_arena = nullptr;
+    bool tensor_arena_in_psram = false;
+
+    // OpResolver: 默认只注册模型用到的算子；定义 PREDICTOR_USE_ALL_OPS_RESOLVER 时链接全部内核作对照
+#ifdef PREDICTOR_USE_ALL_OPS_RESOLVER
+    tflite::AllOpsResolver resolver;
+#else
+    ModelOpResolver resolver;
+#endif
+
+    // 解释器的静态存储 (集成模型时每个成员一个，第0个为主模型 interpreter)。
+    // 加载失败时需要换一个模型重新构造，因此使用placement new
+    alignas(tflite::MicroInterpreter) uint8_t interpreter_buffers[Ensemble::kMaxMembers][sizeof(tflite::MicroInterpreter)];
+    tflite::MicroInterpreter* interpreters[Ensemble::kMaxMembers] = {};
+    int interpreter_count = 0;
+
+#if PREDICTOR_PROFILING
+    // 把各算子的耗时记录到 GlucosePredictor::_op_profile
+    tflite::MicroProfiler* profiler = nullptr;
+#endif
+
+    // 流式模型的状态输入/输出张量
+    TfLiteTensor* state_input_tensor = nullptr;
+    TfLiteTensor* state_output_tensor = nullptr;
+
+    const char* const kPrefsNamespace = "predictor";
+
+    int tensorElementCount(const TfLiteTensor* tensor) {
+        int count = 1;
+        for (int i = 0; i < tensor->dims->size; i++) {
+            count *= tensor->dims->data[i];
+        }
+        return count;
+    }
+
+    Ensemble::Config ensembleConfig() {
+        Ensemble::Config c;
+        c.tightWidth = ENSEMBLE_TIGHT_WIDTH_MGDL;
+        c.maxConsecutiveSkips = ENSEMBLE_MAX_CONSECUTIVE_SKIPS;
+        return c;
+    }
+
+    void releaseInterpreters() {
+        for (int i = interpreter_count - 1; i >= 0; i--) {
+            interpreters[i]->~MicroInterpreter();
+            interpreters[i] = nullptr;
+        }
+        interpreter_count = 0;
+        interpreter = nullptr;
+    }
+
+    // allocator 不为空时 (集成模型) 多个解释器共用它所管理的arena
+    tflite::MicroInterpreter* createInterpreter(int index, const tflite::Model* m, tflite::MicroAllocator* allocator) {
+#if PREDICTOR_PROFILING
+        // 只剖析主模型，避免不同成员的算子序列互相覆盖统计
+        tflite::MicroProfiler* p = index == 0 ? profiler : nullptr;
+        if (allocator != nullptr) {
+            return new (interpreter_buffers[index]) tflite::MicroInterpreter(m, resolver, allocator, error_reporter, nullptr, p);
+        }
+        return new (interpreter_buffers[index]) tflite::MicroInterpreter(m, resolver, tensor_arena, kTensorArenaSize,
+                                                                         error_reporter, nullptr, p);
+#else
+        if (allocator != nullptr) {
+            return new (interpreter_buffers[index]) tflite::MicroInterpreter(m, resolver, allocator, error_reporter);
+        }
+        return new (interpreter_buffers[index]) tflite::MicroInterpreter(m, resolver, tensor_arena, kTensorArenaSize,
+                                                                         error_reporter);
+#endif
+    }
+
+    // 把输入窗口写入输入张量 (int8模型按张量的 scale/zero_point 量化)
+    void fillInputTensor(TfLiteTensor* tensor, const float* window, int size) {
+        for (int i = 0; i < size; ++i) {
+            if (tensor->type == kTfLiteInt8) {
+                tensor->data.int8[i] = Quantization::quantizeInt8(window[i], tensor->params.scale, tensor->params.zero_point);
+            } else {
+                tensor->data.f[i] = window[i];
+            }
+        }
+    }
+
+    HistoryResampler::Config historyConfig() {
+        HistoryResampler::Config c;
+        c.gridStepMs = PREDICTOR_GRID_STEP_MS;
+        c.gridSize = GlucosePredictor::kHistorySize;
+        c.maxGapMs = PREDICTOR_MAX_GAP_MS;
+        c.maxStalenessMs = PREDICTOR_MAX_STALENESS_MS;
+        c.minQuality = PREDICTOR_MIN_QUALITY;
+        return c;
+    }
+
+    // RTC时间 (毫秒)。软件复位后继续计时，断电后从0开始，用于换算快照中最后一个读数的时间
+    uint64_t rtcNowMs() {
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        return (uint64_t)tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+    }
 }
 
 // 获取单例实例
@@ -33,83 +144,547 @@ GlucosePredictor& GlucosePredictor::getInstance() {
 // 私有构造函数
 GlucosePredictor::GlucosePredictor() :
     _is_initialized(false),
-    _history_index(0),
-    _history_count(0) 
+    _init_time_us(0),
+    _quantized(false),
+    _input_size(0),
+    _output_count(0),
+    _streaming(false),
+    _stream_curve{ nullptr, 0 },
+    _invoke_count(0),
+    _last_invoke_us(0),
+    _max_invoke_us(0),
+    _total_invoke_us(0),
+    _history(historyConfig()),
+    _ensemble(ensembleConfig()),
+    _has_ensemble_result(false),
+    _capture(nullptr)
 {
 }
 
 bool GlucosePredictor::begin() {
+    unsigned long startTime = micros();
+
     // 1. 设置错误报告器
     static tflite::MicroErrorReporter micro_error_reporter;
     error_reporter = &micro_error_reporter;
 
-    // 2. 加载模型数据
-    model = tflite::GetModel(g_model_data);
-    if (model->version() != TFLITE_SCHEMA_VERSION) {
-        error_reporter->Report("Model provided is schema version %d not equal to supported version %d.", model->version(), TFLITE_SCHEMA_VERSION);
+#if PREDICTOR_PROFILING
+    static TflmOpProfiler op_profiler(_op_profile);
+    profiler = &op_profiler;
+#endif
+
+    if (!allocateArena()) {
+        error_reporter->Report("Failed to allocate %u bytes for the tensor arena.", (unsigned)kTensorArenaSize);
         return false;
     }
+    if (!kModelArenaMeasured) {
+        error_reporter->Report("WARNING: tensor arena size %u is an unmeasured static estimate (see model_arena.h).",
+                               (unsigned)kTensorArenaSize);
+    }
+
+#ifndef PREDICTOR_USE_ALL_OPS_RESOLVER
+    static bool ops_registered = false;
+    if (!ops_registered) {
+        if (!registerModelOps(resolver)) {
+            error_reporter->Report("Failed to register model ops.");
+            return false;
+        }
+        ops_registered = true;
+    }
+#endif
+
+    // 2. 优先使用模型分区中的模型 (零拷贝映射)，加载失败时回滚到另一个槽位
+    //    试运行的模型在这里只是加载成功，之后按推理结果确认 (ModelStore::reportInference)
+    ModelStore& store = ModelStore::getInstance();
+    while (store.getModelData() != nullptr) {
+        if (loadModel(store.getModelData(), store.getModelSize(), store.getModelCrc32())) {
+            if (store.isActiveTrial()) {
+                // 试运行期间推理卡死时看门狗复位 (而不只是打印警告)，计为一次失败的启动
+                esp_task_wdt_init(MODEL_TRIAL_INVOKE_TIMEOUT_S, true);
+            }
+            _is_initialized = true;
+            _init_time_us = micros() - startTime;
+            return true;
+        }
+        if (!store.rejectActiveModel()) {
+            break;
+        }
+    }
 
-    // 3. 创建OpResolver，它包含了模型所需的操作(OP)的实现
-    static tflite::AllOpsResolver resolver;
+#if MODEL_EMBEDDED_FALLBACK
+    // 3. 两个分区都不可用时，退回固件内置模型
+    error_reporter->Report("No valid model partition, using built-in model.");
+    _is_initialized = loadModel(g_model_data, g_model_data_len, ModelImage::crc32(g_model_data, g_model_data_len));
+#endif
+    _init_time_us = micros() - startTime;
+    return _is_initialized;
+}
 
-    // 4. 实例化解释器
-    static tflite::MicroInterpreter static_interpreter(model, resolver, tensor_arena, kTensorArenaSize, error_reporter);
-    interpreter = &static_interpreter;
+bool GlucosePredictor::loadModel(const uint8_t* modelData, size_t modelSize, uint32_t modelId) {
+    _ensemble.setMembers(0, nullptr, nullptr);
+    _has_ensemble_result = false;
 
-    // 5. 在内存池(Tensor Arena)中为模型的输入输出张量分配内存
-    if (interpreter->AllocateTensors() != kTfLiteOk) {
-        error_reporter->Report("AllocateTensors() failed.");
+    // 1. 拆分集成模型 (普通模型视为只有一个成员)
+    ModelImage::EnsembleMember members[Ensemble::kMaxMembers];
+    int memberCount = ModelImage::parseEnsemble(modelData, modelSize, members, Ensemble::kMaxMembers);
+    if (memberCount < 0) {
+        error_reporter->Report("Bad ensemble directory (at most %d members).", Ensemble::kMaxMembers);
         return false;
     }
+    if (memberCount == 0) {
+        members[0].data = modelData;
+        members[0].size = modelSize;
+        memberCount = 1;
+    }
+
+    // 如果之前尝试过其他模型，先析构旧的解释器
+    releaseInterpreters();
+
+    // 集成模型的成员共用一个arena: 各成员的持久数据依次放在arena尾部，
+    // 推理时的临时张量在头部复用 (成员依次运行，不会同时使用)
+    tflite::MicroAllocator* allocator = nullptr;
+    if (memberCount > 1) {
+        allocator = tflite::MicroAllocator::Create(tensor_arena, kTensorArenaSize, error_reporter);
+        if (allocator == nullptr) {
+            error_reporter->Report("Failed to create the shared arena allocator.");
+            return false;
+        }
+    }
+
+    for (int i = 0; i < memberCount; i++) {
+        // 2. 加载模型数据。先校验flatbuffer的结构 (偏移与长度都在缓冲区内)，CRC只能发现传输中的损坏，
+        //    构造出的畸形模型会让解释器越界读取
+        flatbuffers::Verifier verifier(members[i].data, members[i].size);
+        if (!tflite::VerifyModelBuffer(verifier)) {
+            error_reporter->Report("Model %d of %d failed flatbuffer verification.", i + 1, memberCount);
+            return false;
+        }
+        model = tflite::GetModel(members[i].data);
+        if (model->version() != TFLITE_SCHEMA_VERSION) {
+            error_reporter->Report("Model provided is schema version %d not equal to supported version %d.", model->version(), TFLITE_SCHEMA_VERSION);
+            return false;
+        }
+
+        // 3. 检查模型用到的每个算子都已注册，缺失时给出明确的错误而不是在 AllocateTensors() 中失败
+        if (!checkModelOps()) {
+            return false;
+        }
+
+        // 4. 实例化解释器
+        interpreters[i] = createInterpreter(i, model, allocator);
+        interpreter_count = i + 1;
+
+        // 5. 在内存池(Tensor Arena)中为模型的输入输出张量分配内存
+        if (interpreters[i]->AllocateTensors() != kTfLiteOk) {
+            error_reporter->Report("AllocateTensors() failed for model %d of %d (arena %u bytes). Re-run tools/gen_arena_size.py for this model.",
+                                   i + 1, memberCount, (unsigned)kTensorArenaSize);
+            return false;
+        }
+    }
+    model = tflite::GetModel(members[0].data);
+    interpreter = interpreters[0];
 
     // 6. 获取指向输入和输出张量的指针
     input_tensor = interpreter->input(0);
     output_tensor = interpreter->output(0);
+
+    // 两个输入两个输出的模型为有状态流式模型
+    _streaming = interpreter->inputs_size() == 2 && interpreter->outputs_size() == 2;
+    if (_streaming) {
+        if (memberCount > 1) {
+            error_reporter->Report("Streaming models cannot be combined into an ensemble.");
+            return false;
+        }
+        return setupStreamingModel(modelId);
+    }
     
     // 验证输入/输出张量的格式是否符合预期
-    // 假设模型输入是 [1, 10] 的浮点数，输出是 [1, 1] 的浮点数
-    if (input_tensor->dims->size != 2 || input_tensor->dims->data[0] != 1 || input_tensor->dims->data[1] != kHistorySize || input_tensor->type != kTfLiteFloat32) {
+    // 模型输入是 [1, 10] 的网格值，或 [1, 20] 的网格值 + 间隔特征；浮点模型与全整数int8量化模型均可
+    _input_size = input_tensor->dims->size == 2 ? input_tensor->dims->data[1] : 0;
+    if (input_tensor->dims->size != 2 || input_tensor->dims->data[0] != 1 ||
+        (_input_size != kHistorySize && _input_size != 2 * kHistorySize) ||
+        (input_tensor->type != kTfLiteFloat32 && input_tensor->type != kTfLiteInt8)) {
         error_reporter->Report("Bad input tensor parameters.");
         return false;
     }
+    // 输出可以是 [1] / [1, 1] 的单点预测，也可以是 [1, N] 的多步曲线
+    _output_count = tensorElementCount(output_tensor);
+    if (_output_count < 1) {
+        error_reporter->Report("Bad output tensor parameters.");
+        return false;
+    }
+    if (_output_count > PREDICTION_MAX_HORIZON) {
+        error_reporter->Report("Model predicts %d steps, only the first %d are used.", _output_count, PREDICTION_MAX_HORIZON);
+    }
+    if (output_tensor->type != input_tensor->type) {
+        error_reporter->Report("Input and output tensors must both be float32 or both be int8.");
+        return false;
+    }
+    _quantized = input_tensor->type == kTfLiteInt8;
+    if (_quantized && (input_tensor->params.scale <= 0.0f || output_tensor->params.scale <= 0.0f)) {
+        error_reporter->Report("int8 model is missing per-tensor quantization parameters.");
+        return false;
+    }
 
-    _is_initialized = true;
+    if (memberCount > 1) {
+        if (!validateEnsembleMembers(memberCount)) {
+            return false;
+        }
+        _ensemble.setMembers(memberCount, runEnsembleMember, this);
+    }
+    return true;
+}
+
+bool GlucosePredictor::validateEnsembleMembers(int memberCount) {
+    for (int i = 1; i < memberCount; i++) {
+        tflite::MicroInterpreter* member = interpreters[i];
+        TfLiteTensor* in = member->input(0);
+        TfLiteTensor* out = member->output(0);
+        // 所有成员读取同一个输入窗口，输出同样单位的预测曲线
+        if (member->inputs_size() != 1 || member->outputs_size() != 1 ||
+            in->type != input_tensor->type || tensorElementCount(in) != _input_size ||
+            out->type != input_tensor->type || tensorElementCount(out) < 1 ||
+            (_quantized && (in->params.scale <= 0.0f || out->params.scale <= 0.0f))) {
+            error_reporter->Report("Ensemble model %d does not match the input/output format of the first model.", i + 1);
+            return false;
+        }
+    }
     return true;
 }
 
-void GlucosePredictor::addGlucoseReading(float value) {
-    _history_buffer[_history_index] = value;
-    _history_index = (_history_index + 1) % kHistorySize;
-    if (_history_count < kHistorySize) {
-        _history_count++;
+bool GlucosePredictor::runEnsembleMember(void* context, int member, const float* input, float* output, int* outputSize) {
+    GlucosePredictor* self = (GlucosePredictor*)context;
+    fillInputTensor(interpreters[member]->input(0), input, self->_input_size);
+    if (!self->invoke(member)) {
+        return false;
+    }
+    const TfLiteTensor* out = interpreters[member]->output(0);
+    int count = tensorElementCount(out);
+    if (count > Ensemble::kMaxSteps) count = Ensemble::kMaxSteps;
+    for (int i = 0; i < count; i++) {
+        output[i] = out->type == kTfLiteInt8
+            ? Quantization::dequantizeInt8(out->data.int8[i], out->params.scale, out->params.zero_point)
+            : out->data.f[i];
     }
+    *outputSize = count;
+    return true;
+}
+
+bool GlucosePredictor::setupStreamingModel(uint32_t modelId) {
+    // 约定: 输入 [采样值 [1,1], 状态 [1,H]]，输出 [预测 [1,N], 新状态 [1,H]]，均为浮点
+    state_input_tensor = interpreter->input(1);
+    state_output_tensor = interpreter->output(1);
+    int stateSize = tensorElementCount(state_input_tensor);
+    if (tensorElementCount(input_tensor) != 1 || input_tensor->type != kTfLiteFloat32 ||
+        state_input_tensor->type != kTfLiteFloat32 || state_output_tensor->type != kTfLiteFloat32 ||
+        output_tensor->type != kTfLiteFloat32 || tensorElementCount(state_output_tensor) != stateSize) {
+        error_reporter->Report("Bad streaming model tensors (expected float [sample, state] -> [prediction, state]).");
+        return false;
+    }
+    if (!_stream_state.begin(stateSize, modelId, PREDICTOR_GRID_STEP_MS, PREDICTOR_MAX_GAP_MS)) {
+        error_reporter->Report("Streaming state of %d values exceeds %d.", stateSize, StreamingState::kMaxStateSize);
+        return false;
+    }
+    _input_size = 1;
+    _output_count = tensorElementCount(output_tensor);
+    _quantized = false;
+    _stream_curve = PredictionCurve::Curve{ nullptr, 0 };
+
+    // 热重启时从NVS恢复隐藏状态，省去重新积累历史的时间
+    if (restoreStreamingState()) {
+        error_reporter->Report("Streaming state restored (%u steps).", (unsigned)_stream_state.getSteps());
+    }
+    return true;
+}
+
+void GlucosePredictor::stepStreaming(float value) {
+    input_tensor->data.f[0] = value;
+    memcpy(state_input_tensor->data.f, _stream_state.data(), sizeof(float) * _stream_state.size());
+
+    unsigned long invokeStart = micros();
+    if (!invoke()) {
+        _stream_curve = PredictionCurve::Curve{ nullptr, 0 };
+        ModelStore::getInstance().reportInference(false, nullptr, 0);
+        return;
+    }
+    recordInvokeTime(micros() - invokeStart);
+
+    _stream_state.commit(state_output_tensor->data.f);
+    _stream_curve = PredictionCurve::fromOutput(output_tensor->data.raw, _output_count, false, 0.0f, 0,
+                                                _curve_buffer, PREDICTION_MAX_HORIZON);
+    ModelStore::getInstance().reportInference(true, _stream_curve.data, _stream_curve.size);
+}
+
+void GlucosePredictor::stepStreamingCallback(void* context, float value) {
+    static_cast<GlucosePredictor*>(context)->stepStreaming(value);
+}
+
+void GlucosePredictor::saveStreamingState() {
+    if (!_is_initialized || !_streaming) {
+        return;
+    }
+    uint8_t snapshot[StreamingState::kSnapshotHeaderSize + sizeof(float) * StreamingState::kMaxStateSize + 4];
+    size_t length = _stream_state.saveSnapshot(snapshot, sizeof(snapshot), nowMs(), rtcNowMs());
+    if (length == 0) {
+        return;
+    }
+    Preferences prefs;
+    prefs.begin(kPrefsNamespace, false);
+    prefs.putBytes("state", snapshot, length);
+    prefs.end();
+}
+
+bool GlucosePredictor::restoreStreamingState() {
+    uint8_t snapshot[StreamingState::kSnapshotHeaderSize + sizeof(float) * StreamingState::kMaxStateSize + 4];
+    Preferences prefs;
+    prefs.begin(kPrefsNamespace, true);
+    size_t length = prefs.getBytes("state", snapshot, sizeof(snapshot));
+    prefs.end();
+    return length > 0 && _stream_state.restoreSnapshot(snapshot, length, nowMs(), rtcNowMs());
+}
+
+bool GlucosePredictor::isStreaming() const {
+    return _streaming;
+}
+
+bool GlucosePredictor::isEnsemble() const {
+    return _ensemble.getMemberCount() > 1;
+}
+
+const Ensemble::Result* GlucosePredictor::getLastEnsembleResult() const {
+    return _has_ensemble_result && _ensemble_result.hasInterval ? &_ensemble_result : nullptr;
+}
+
+bool GlucosePredictor::allocateArena() {
+    if (tensor_arena != nullptr) {
+        return true;
+    }
+
+    // 内部SRAM的最大连续空闲块在预留给BLE等系统组件的余量之外仍能容纳arena时，放在内部SRAM
+    size_t largestInternal = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (largestInternal >= kTensorArenaSize + TENSOR_ARENA_INTERNAL_RESERVE) {
+        tensor_arena = (uint8_t*)heap_caps_aligned_alloc(16, kTensorArenaSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        tensor_arena_in_psram = false;
+    }
+    if (tensor_arena == nullptr) {
+        tensor_arena = (uint8_t*)heap_caps_aligned_alloc(16, kTensorArenaSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        tensor_arena_in_psram = tensor_arena != nullptr;
+    }
+    return tensor_arena != nullptr;
+}
+
+size_t GlucosePredictor::getArenaSize() const {
+    return tensor_arena != nullptr ? kTensorArenaSize : 0;
+}
+
+size_t GlucosePredictor::getArenaUsedBytes() const {
+    return (_is_initialized && interpreter != nullptr) ? interpreter->arena_used_bytes() : 0;
+}
+
+bool GlucosePredictor::isArenaInPsram() const {
+    return tensor_arena_in_psram;
+}
+
+bool GlucosePredictor::checkModelOps() {
+    const auto* opcodes = model->operator_codes();
+    if (opcodes == nullptr) {
+        return true;
+    }
+    for (unsigned int i = 0; i < opcodes->size(); i++) {
+        const tflite::OperatorCode* opcode = opcodes->Get(i);
+        tflite::BuiltinOperator code = tflite::GetBuiltinCode(opcode);
+        if (code == tflite::BuiltinOperator_CUSTOM) {
+            const char* name = opcode->custom_code() != nullptr ? opcode->custom_code()->c_str() : "";
+            if (resolver.FindOp(name) == nullptr) {
+                error_reporter->Report("Model requires custom op '%s' which has no TFLM kernel.", name);
+                return false;
+            }
+        } else if (resolver.FindOp(code) == nullptr) {
+            error_reporter->Report("Model requires op %s which is not registered. Re-run tools/gen_op_resolver.py.",
+                                   tflite::EnumNameBuiltinOperator(code));
+            return false;
+        }
+    }
+    return true;
+}
+
+unsigned long GlucosePredictor::getInitTimeUs() const {
+    return _init_time_us;
+}
+
+bool GlucosePredictor::isQuantized() const {
+    return _quantized;
+}
+
+bool GlucosePredictor::invoke(int member) {
+#if PREDICTOR_PROFILING
+    if (member == 0) _op_profile.beginRun();
+#endif
+    // 试运行中的模型由任务看门狗监视 (超时见 MODEL_TRIAL_INVOKE_TIMEOUT_S)
+    bool watched = ModelStore::getInstance().isActiveTrial();
+    if (watched) {
+        esp_task_wdt_add(nullptr);
+    }
+    bool ok = interpreters[member]->Invoke() == kTfLiteOk;
+    if (watched) {
+        esp_task_wdt_delete(nullptr);
+    }
+    if (!ok) {
+        error_reporter->Report("Invoke failed.");
+        return false;
+    }
+#if PREDICTOR_PROFILING
+    if (member == 0) _op_profile.endRun();
+#endif
+    return true;
+}
+
+void GlucosePredictor::recordInvokeTime(unsigned long us) {
+    _last_invoke_us = us;
+    if (us > _max_invoke_us) {
+        _max_invoke_us = us;
+    }
+    _total_invoke_us += us;
+    _invoke_count++;
+}
+
+uint32_t GlucosePredictor::nowMs() const {
+    return _capture != nullptr ? _capture->clock(millis()) : millis();
+}
+
+void GlucosePredictor::setCapture(SensorCapture* capture) {
+    _capture = capture;
+}
+
+unsigned long GlucosePredictor::getLastInvokeUs() const {
+    return _last_invoke_us;
+}
+
+unsigned long GlucosePredictor::getMaxInvokeUs() const {
+    return _max_invoke_us;
+}
+
+unsigned long GlucosePredictor::getAverageInvokeUs() const {
+    return _invoke_count > 0 ? (unsigned long)(_total_invoke_us / _invoke_count) : 0;
+}
+
+const OpProfile* GlucosePredictor::getOpProfile() const {
+#if PREDICTOR_PROFILING
+    return &_op_profile;
+#else
+    return nullptr;
+#endif
+}
+
+void GlucosePredictor::addGlucoseReading(float value, uint32_t timestampMs, float quality) {
+    if (!_history.add(timestampMs, value, quality)) {
+        return; // 信号质量过低或时间戳无效
+    }
+
+    // 流式模型: 每个网格点只运行一步，隐藏状态保存了之前的历史
+    if (_is_initialized && _streaming) {
+        _stream_state.feed(timestampMs, value, stepStreamingCallback, this);
+    }
+}
+
+HistoryResampler::Status GlucosePredictor::getHistoryStatus() const {
+    if (_streaming) {
+        const HistoryResampler::Sample* last = _history.newest();
+        if (last == nullptr || (int32_t)(nowMs() - last->timestampMs) > (int32_t)PREDICTOR_MAX_STALENESS_MS) {
+            return last == nullptr ? HistoryResampler::Status::NOT_ENOUGH_HISTORY : HistoryResampler::Status::STALE;
+        }
+        // 状态需要积累与整窗口模型相同长度的历史
+        return _stream_state.isWarm(kHistorySize) ? HistoryResampler::Status::OK : HistoryResampler::Status::NOT_ENOUGH_HISTORY;
+    }
+    HistoryResampler::Window window;
+    return _history.resample(nowMs(), &window);
+}
+
+const HistoryResampler& GlucosePredictor::getHistory() const {
+    return _history;
+}
+
+void GlucosePredictor::restoreHistory(const HistoryResampler& history) {
+    _history = history;
 }
 
 bool GlucosePredictor::isReadyToPredict() const {
-    return _history_count >= kHistorySize;
+    return getHistoryStatus() == HistoryResampler::Status::OK;
+}
+
+int GlucosePredictor::getInputSize() const {
+    return _input_size;
 }
 
 float GlucosePredictor::predict() {
-    if (!_is_initialized || !isReadyToPredict()) {
-        return 0.0f; // 返回一个无效值
+    PredictionCurve::Curve curve = predictCurve();
+    return curve.size > 0 ? curve.data[0] : 0.0f; // 无法预测时返回一个无效值
+}
+
+PredictionCurve::Curve GlucosePredictor::predictCurve() {
+    TRACE_SCOPE(PREDICT);
+    if (_streaming) {
+        // 已在 addGlucoseReading() 中完成推理
+        return isReadyToPredict() ? _stream_curve : PredictionCurve::Curve{ nullptr, 0 };
     }
+    float window[kMaxInputSize];
+    if (getInputWindow(window) == 0) {
+        return PredictionCurve::Curve{ nullptr, 0 };
+    }
+    return runInference(window);
+}
 
-    // 将环形缓冲区中的数据按正确的顺序填充到模型的输入张量中
-    int current_idx = _history_index;
+int GlucosePredictor::getInputWindow(float* window) const {
+    HistoryResampler::Window resampled;
+    if (_streaming || _input_size == 0 || _history.resample(nowMs(), &resampled) != HistoryResampler::Status::OK) {
+        return 0;
+    }
+    // 网格值按时间顺序 (从旧到新)，带间隔特征的模型在其后附加每个网格点的读数间隔
     for (int i = 0; i < kHistorySize; ++i) {
-        // 计算在环形缓冲区中的实际索引
-        int buffer_idx = (current_idx + i) % kHistorySize;
-        input_tensor->data.f[i] = _history_buffer[buffer_idx];
+        window[i] = resampled.values[i];
+        if (_input_size == 2 * kHistorySize) {
+            window[kHistorySize + i] = resampled.gapMinutes[i];
+        }
     }
+    return _input_size;
+}
+
+PredictionCurve::Curve GlucosePredictor::runInference(const float* window) {
+    TRACE_SCOPE(INFERENCE);
+    if (!_is_initialized || _streaming) {
+        return PredictionCurve::Curve{ nullptr, 0 };
+    }
+    PredictionCurve::Curve curve = invokeWindow(window);
+    // 试运行中的分区模型按推理结果确认或回滚
+    ModelStore::getInstance().reportInference(curve.size > 0, curve.data, curve.size);
+    return curve;
+}
+
+PredictionCurve::Curve GlucosePredictor::invokeWindow(const float* window) {
+    PredictionCurve::Curve none = { nullptr, 0 };
+    unsigned long invokeStart = micros();
+    if (_ensemble.getMemberCount() > 1) {
+        // 集成模型: 所有成员读取同一个输入窗口，曲线为成员均值，区间见 getLastEnsembleResult()
+        _has_ensemble_result = _ensemble.run(window, &_ensemble_result);
+        if (!_has_ensemble_result) {
+            return none;
+        }
+        recordInvokeTime(micros() - invokeStart);
+        int steps = _ensemble_result.steps < PREDICTION_MAX_HORIZON ? _ensemble_result.steps : PREDICTION_MAX_HORIZON;
+        return PredictionCurve::Curve{ _ensemble_result.mean, steps };
+    }
+
+    // 将输入窗口填充到模型的输入张量中 (int8模型按输入张量的 scale/zero_point 量化)
+    fillInputTensor(input_tensor, window, _input_size);
 
     // 运行推理
-    if (interpreter->Invoke() != kTfLiteOk) {
-        error_reporter->Report("Invoke failed.");
-        return 0.0f;
+    if (!invoke()) {
+        return none;
     }
+    recordInvokeTime(micros() - invokeStart);
 
-    // 从输出张量中获取预测结果
-    float prediction = output_tensor->data.f[0];
-    return prediction;
+    // 从输出张量中获取预测曲线 (浮点模型零拷贝，int8模型反量化)
+    return PredictionCurve::fromOutput(output_tensor->data.raw, _output_count, _quantized,
+                                       output_tensor->params.scale, output_tensor->params.zero_point,
+                                       _curve_buffer, PREDICTION_MAX_HORIZON);
 }
\ No newline at end of file
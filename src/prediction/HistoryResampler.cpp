@@ -0,0 +1,102 @@
+#include "HistoryResampler.h"
+
+HistoryResampler::HistoryResampler(const Config& config) :
+    _config(config),
+    _start(0),
+    _count(0)
+{
+    if (_config.gridSize < 1) _config.gridSize = 1;
+    if (_config.gridSize > kMaxGridSize) _config.gridSize = kMaxGridSize;
+    if (_config.gridStepMs == 0) _config.gridStepMs = 1;
+}
+
+bool HistoryResampler::add(uint32_t timestampMs, float value, float quality) {
+    if (quality < _config.minQuality) {
+        return false;
+    }
+    const Sample* last = newest();
+    if (last != nullptr && (int32_t)(timestampMs - last->timestampMs) <= 0) {
+        return false;
+    }
+
+    Sample s = { timestampMs, value, quality };
+    if (_count < kCapacity) {
+        _samples[(_start + _count) % kCapacity] = s;
+        _count++;
+    } else {
+        // 环形缓冲区已满: 覆盖最旧的读数
+        _samples[_start] = s;
+        _start = (_start + 1) % kCapacity;
+    }
+    return true;
+}
+
+void HistoryResampler::clear() {
+    _start = 0;
+    _count = 0;
+}
+
+int HistoryResampler::size() const {
+    return _count;
+}
+
+const HistoryResampler::Sample& HistoryResampler::at(int i) const {
+    return _samples[(_start + i) % kCapacity];
+}
+
+const HistoryResampler::Sample* HistoryResampler::newest() const {
+    return _count > 0 ? &at(_count - 1) : nullptr;
+}
+
+const HistoryResampler::Config& HistoryResampler::getConfig() const {
+    return _config;
+}
+
+HistoryResampler::Status HistoryResampler::resample(uint32_t nowMs, Window* out) const {
+    if (_count == 0) {
+        return Status::NOT_ENOUGH_HISTORY;
+    }
+    const Sample& last = at(_count - 1);
+    // 时间戳使用 millis()，按无符号差值计算以正确处理约49天后的回绕
+    if ((int32_t)(nowMs - last.timestampMs) > (int32_t)_config.maxStalenessMs) {
+        return Status::STALE;
+    }
+
+    uint32_t span = _config.gridStepMs * (uint32_t)(_config.gridSize - 1);
+    if (last.timestampMs - at(0).timestampMs < span) {
+        return Status::NOT_ENOUGH_HISTORY;
+    }
+
+    // 从最新读数往回扫描，网格点也从新到旧依次处理
+    out->size = _config.gridSize;
+    out->longestGapMs = 0;
+    int upper = _count - 1;
+    for (int k = _config.gridSize - 1; k >= 0; k--) {
+        uint32_t offset = _config.gridStepMs * (uint32_t)(_config.gridSize - 1 - k); // 距最新读数的时间
+        uint32_t t = last.timestampMs - offset;
+
+        // 找到包含 t 的区间 [at(upper-1), at(upper)]
+        while (upper > 0 && (int32_t)(at(upper - 1).timestampMs - t) >= 0) {
+            upper--;
+        }
+        const Sample& b = at(upper);
+        if (b.timestampMs == t) {
+            out->values[k] = b.value;
+            out->gapMinutes[k] = 0.0f;
+            continue;
+        }
+
+        const Sample& a = at(upper - 1); // 覆盖检查保证 upper > 0
+        uint32_t gap = b.timestampMs - a.timestampMs;
+        if (gap > _config.maxGapMs) {
+            return Status::GAP_TOO_LONG;
+        }
+        if (gap > out->longestGapMs) {
+            out->longestGapMs = gap;
+        }
+        float w = (float)(t - a.timestampMs) / (float)gap;
+        out->values[k] = a.value + w * (b.value - a.value);
+        out->gapMinutes[k] = gap / 60000.0f;
+    }
+    return Status::OK;
+}
@@ -0,0 +1,184 @@
+#include "InferenceService.h"
+#include <string.h>
+#include <chrono>
+#ifdef ESP_PLATFORM
+#include <esp_pthread.h>
+#endif
+
+InferenceService::InferenceService(InvokeFn invoke) :
+    _invoke(invoke),
+    _running(false),
+    _pending(false),
+    _inFlight(false),
+    _nextId(1),
+    _pendingId(0),
+    _pendingSubmitUs(0),
+    _pendingInputSize(0),
+    _hasResult(false),
+    _totalInvokeUs(0)
+{
+    memset(&_result, 0, sizeof(_result));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+InferenceService::~InferenceService() {
+    stop();
+}
+
+void InferenceService::setResultCallback(ResultCallback callback) {
+    _callback = callback;
+}
+
+bool InferenceService::start(int core, uint32_t stackSize, int priority) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running) {
+        return true;
+    }
+
+#ifdef ESP_PLATFORM
+    // std::thread 在ESP-IDF上基于pthread实现，创建前设置的配置决定任务的核心、栈与优先级
+    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+    cfg.stack_size = stackSize;
+    cfg.prio = priority;
+    cfg.pin_to_core = core;
+    cfg.thread_name = "inference";
+    if (esp_pthread_set_cfg(&cfg) != ESP_OK) {
+        return false;
+    }
+#else
+    (void)core;
+    (void)stackSize;
+    (void)priority;
+#endif
+
+    _running = true;
+    _thread = std::thread(&InferenceService::run, this);
+
+#ifdef ESP_PLATFORM
+    // 恢复默认配置，避免影响之后创建的其他线程
+    esp_pthread_cfg_t defaults = esp_pthread_get_default_config();
+    esp_pthread_set_cfg(&defaults);
+#endif
+    return true;
+}
+
+void InferenceService::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running) {
+            return;
+        }
+        _running = false;
+        _pending = false;
+    }
+    _wake.notify_one();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+uint32_t InferenceService::submit(const float* input, int inputSize) {
+    if (inputSize <= 0 || inputSize > kMaxInputSize) {
+        return 0;
+    }
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_running) {
+            return 0;
+        }
+        if (_pending) {
+            // 推理线程还没取走上一个请求: 用新输入覆盖
+            _stats.coalesced++;
+        }
+        id = _nextId++;
+        if (_nextId == 0) _nextId = 1; // 0 保留为无效编号
+        memcpy(_pendingInput, input, sizeof(float) * inputSize);
+        _pendingInputSize = inputSize;
+        _pendingId = id;
+        _pendingSubmitUs = nowUs();
+        _pending = true;
+        _stats.submitted++;
+    }
+    _wake.notify_one();
+    return id;
+}
+
+bool InferenceService::takeResult(Result* out) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_hasResult) {
+        return false;
+    }
+    *out = _result;
+    _hasResult = false;
+    return true;
+}
+
+bool InferenceService::isBusy() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pending || _inFlight;
+}
+
+InferenceService::Stats InferenceService::getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+void InferenceService::run() {
+    float input[kMaxInputSize];
+    Result result;
+
+    while (true) {
+        int inputSize;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [this] { return _pending || !_running; });
+            if (!_running) {
+                break;
+            }
+            // 取走邮箱中的请求，推理期间不持有锁，主循环可以继续提交
+            memcpy(input, _pendingInput, sizeof(float) * _pendingInputSize);
+            inputSize = _pendingInputSize;
+            result.requestId = _pendingId;
+            result.queueUs = nowUs() - _pendingSubmitUs;
+            _pending = false;
+            _inFlight = true;
+        }
+
+        uint32_t start = nowUs();
+        result.outputSize = 0;
+        result.ok = _invoke(input, inputSize, result.output, &result.outputSize);
+        result.invokeUs = nowUs() - start;
+        if (result.outputSize < 0 || result.outputSize > kMaxOutputSize) {
+            result.ok = false;
+            result.outputSize = 0;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _inFlight = false;
+            _result = result;
+            _hasResult = true;
+            if (result.ok) {
+                _stats.completed++;
+            } else {
+                _stats.failed++;
+            }
+            _stats.lastQueueUs = result.queueUs;
+            if (result.queueUs > _stats.maxQueueUs) _stats.maxQueueUs = result.queueUs;
+            _stats.lastInvokeUs = result.invokeUs;
+            if (result.invokeUs > _stats.maxInvokeUs) _stats.maxInvokeUs = result.invokeUs;
+            _totalInvokeUs += result.invokeUs;
+            _stats.avgInvokeUs = (uint32_t)(_totalInvokeUs / (_stats.completed + _stats.failed));
+        }
+
+        if (_callback) {
+            _callback(result);
+        }
+    }
+}
+
+uint32_t InferenceService::nowUs() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
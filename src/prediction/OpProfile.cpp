@@ -0,0 +1,122 @@
+#include "OpProfile.h"
+#include <stdio.h>
+#include <string.h>
+
+OpProfile::OpProfile() {
+    reset();
+    _runOpCount = 0;
+}
+
+void OpProfile::reset() {
+    _opCount = 0;
+    _runCount = 0;
+    _totalRunUs = 0;
+}
+
+void OpProfile::beginRun() {
+    _runOpCount = 0;
+}
+
+uint32_t OpProfile::beginOp(const char* tag, uint32_t nowUs) {
+    if (_runOpCount >= kMaxOps) {
+        return kInvalidHandle;
+    }
+    int i = _runOpCount++;
+    _runTags[i] = tag != nullptr ? tag : "?";
+    _runStartUs[i] = nowUs;
+    _runUs[i] = 0;
+    return (uint32_t)i;
+}
+
+void OpProfile::endOp(uint32_t handle, uint32_t nowUs) {
+    if (handle >= (uint32_t)_runOpCount) {
+        return;
+    }
+    _runUs[handle] = nowUs - _runStartUs[handle];
+}
+
+void OpProfile::endRun() {
+    if (_runOpCount == 0) {
+        return;
+    }
+
+    // 算子序列变化说明换了模型，旧的统计不再有意义
+    bool sameGraph = _opCount == _runOpCount;
+    for (int i = 0; sameGraph && i < _opCount; i++) {
+        sameGraph = strcmp(_ops[i].tag, _runTags[i]) == 0;
+    }
+    if (!sameGraph) {
+        reset();
+        _opCount = _runOpCount;
+        for (int i = 0; i < _opCount; i++) {
+            _ops[i].tag = _runTags[i];
+            _ops[i].minUs = 0xFFFFFFFF;
+            _ops[i].maxUs = 0;
+            _ops[i].totalUs = 0;
+        }
+    }
+
+    uint32_t runUs = 0;
+    for (int i = 0; i < _opCount; i++) {
+        OpStats& op = _ops[i];
+        uint32_t us = _runUs[i];
+        op.lastUs = us;
+        if (us < op.minUs) op.minUs = us;
+        if (us > op.maxUs) op.maxUs = us;
+        op.totalUs += us;
+        runUs += us;
+    }
+    _totalRunUs += runUs;
+    _runCount++;
+}
+
+int OpProfile::getOpCount() const {
+    return _opCount;
+}
+
+const OpProfile::OpStats& OpProfile::getOp(int index) const {
+    return _ops[index];
+}
+
+uint32_t OpProfile::getRunCount() const {
+    return _runCount;
+}
+
+uint32_t OpProfile::getLastRunUs() const {
+    uint32_t sum = 0;
+    for (int i = 0; i < _opCount; i++) {
+        sum += _ops[i].lastUs;
+    }
+    return sum;
+}
+
+void OpProfile::writeCsv(LineWriter write) const {
+    char line[128];
+    write("index,op,last_us,avg_us,min_us,max_us,share_pct");
+    for (int i = 0; i < _opCount; i++) {
+        const OpStats& op = _ops[i];
+        // 占比按累计耗时计算，不受单次抖动影响
+        float share = _totalRunUs > 0 ? 100.0f * (float)op.totalUs / (float)_totalRunUs : 0.0f;
+        snprintf(line, sizeof(line), "%d,%s,%lu,%lu,%lu,%lu,%.1f", i, op.tag,
+                 (unsigned long)op.lastUs, (unsigned long)(op.totalUs / _runCount),
+                 (unsigned long)op.minUs, (unsigned long)op.maxUs, share);
+        write(line);
+    }
+}
+
+void OpProfile::writeJson(LineWriter write, size_t arenaUsedBytes, size_t arenaSize) const {
+    char line[160];
+    snprintf(line, sizeof(line), "{\"runs\":%lu,\"last_us\":%lu,\"avg_us\":%lu,\"arena_used\":%lu,\"arena_size\":%lu,\"ops\":[",
+             (unsigned long)_runCount, (unsigned long)getLastRunUs(),
+             (unsigned long)(_runCount > 0 ? _totalRunUs / _runCount : 0),
+             (unsigned long)arenaUsedBytes, (unsigned long)arenaSize);
+    write(line);
+    for (int i = 0; i < _opCount; i++) {
+        const OpStats& op = _ops[i];
+        snprintf(line, sizeof(line), "{\"op\":\"%s\",\"last_us\":%lu,\"avg_us\":%lu,\"min_us\":%lu,\"max_us\":%lu}%s",
+                 op.tag, (unsigned long)op.lastUs, (unsigned long)(op.totalUs / _runCount),
+                 (unsigned long)op.minUs, (unsigned long)op.maxUs, i + 1 < _opCount ? "," : "");
+        write(line);
+    }
+    write("]}");
+}
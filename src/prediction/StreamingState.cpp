@@ -0,0 +1,142 @@
+#include "StreamingState.h"
+#include "ByteOrder.h"
+#include "ModelImage.h"
+#include <string.h>
+
+namespace {
+    constexpr uint32_t kSnapshotMagic = 0x41545347; // "GSTA"
+}
+
+StreamingState::StreamingState() :
+    _size(0),
+    _modelId(0),
+    _gridStepMs(1),
+    _maxGapMs(0),
+    _steps(0),
+    _hasLast(false),
+    _lastMs(0),
+    _lastValue(0.0f),
+    _nextGridMs(0)
+{
+    memset(_state, 0, sizeof(_state));
+}
+
+bool StreamingState::begin(int size, uint32_t modelId, uint32_t gridStepMs, uint32_t maxGapMs) {
+    if (size <= 0 || size > kMaxStateSize) {
+        return false;
+    }
+    _size = size;
+    _modelId = modelId;
+    _gridStepMs = gridStepMs > 0 ? gridStepMs : 1;
+    _maxGapMs = maxGapMs;
+    reset();
+    return true;
+}
+
+void StreamingState::reset() {
+    memset(_state, 0, sizeof(_state));
+    _steps = 0;
+    _hasLast = false;
+}
+
+void StreamingState::feed(uint32_t timestampMs, float value, StepFn step, void* context) {
+    if (_hasLast) {
+        uint32_t gap = timestampMs - _lastMs;
+        if ((int32_t)gap <= 0) {
+            return;
+        }
+        if (gap > _maxGapMs) {
+            // 间隔过长，隐藏状态已不能代表最近的历史: 从头积累
+            reset();
+        } else {
+            // 读数间隔大于网格时插值补齐，小于网格时可能一步都不运行
+            while ((int32_t)(timestampMs - _nextGridMs) >= 0) {
+                float w = (float)(int32_t)(_nextGridMs - _lastMs) / (float)gap;
+                if (w < 0.0f) w = 0.0f;
+                step(context, _lastValue + w * (value - _lastValue));
+                _nextGridMs += _gridStepMs;
+            }
+            _lastMs = timestampMs;
+            _lastValue = value;
+            return;
+        }
+    }
+    step(context, value);
+    _hasLast = true;
+    _lastMs = timestampMs;
+    _lastValue = value;
+    _nextGridMs = timestampMs + _gridStepMs;
+}
+
+const float* StreamingState::data() const {
+    return _state;
+}
+
+int StreamingState::size() const {
+    return _size;
+}
+
+void StreamingState::commit(const float* newState) {
+    memcpy(_state, newState, sizeof(float) * _size);
+    _steps++;
+}
+
+uint32_t StreamingState::getSteps() const {
+    return _steps;
+}
+
+bool StreamingState::isWarm(uint32_t warmupSteps) const {
+    return _steps >= warmupSteps;
+}
+
+size_t StreamingState::snapshotSize() const {
+    return kSnapshotHeaderSize + sizeof(float) * _size + 4;
+}
+
+size_t StreamingState::saveSnapshot(uint8_t* out, size_t capacity, uint32_t millisNow, uint64_t rtcNowMs) const {
+    size_t total = snapshotSize();
+    if (_size == 0 || !_hasLast || capacity < total) {
+        return 0;
+    }
+    ByteOrder::writeU32(out + 0, kSnapshotMagic);
+    ByteOrder::writeU32(out + 4, _modelId);
+    ByteOrder::writeU32(out + 8, (uint32_t)rtcNowMs);
+    ByteOrder::writeU32(out + 12, (uint32_t)(rtcNowMs >> 32));
+    ByteOrder::writeU32(out + 16, _steps);
+    ByteOrder::writeU32(out + 20, (uint32_t)_size);
+    ByteOrder::writeU32(out + 24, millisNow - _lastMs);
+    ByteOrder::writeF32(out + 28, _lastValue);
+    ByteOrder::writeU32(out + 32, _nextGridMs - _lastMs);
+    // ESP32 与主机均为小端序，状态按原始字节保存
+    memcpy(out + kSnapshotHeaderSize, _state, sizeof(float) * _size);
+    ByteOrder::writeU32(out + total - 4, ModelImage::crc32(out, total - 4));
+    return total;
+}
+
+bool StreamingState::restoreSnapshot(const uint8_t* snapshot, size_t length, uint32_t millisNow, uint64_t rtcNowMs) {
+    if (_size == 0 || length != snapshotSize()) {
+        return false;
+    }
+    if (ByteOrder::readU32(snapshot) != kSnapshotMagic || ByteOrder::readU32(snapshot + length - 4) != ModelImage::crc32(snapshot, length - 4)) {
+        return false;
+    }
+    if (ByteOrder::readU32(snapshot + 4) != _modelId || ByteOrder::readU32(snapshot + 20) != (uint32_t)_size) {
+        return false;
+    }
+    uint64_t savedAt = (uint64_t)ByteOrder::readU32(snapshot + 8) | ((uint64_t)ByteOrder::readU32(snapshot + 12) << 32);
+    if (rtcNowMs < savedAt) {
+        return false;
+    }
+    // 最后一个读数距今的时间: 保存时的年龄加上之后经过的RTC时间 (包括停机时间)
+    uint64_t lastAge = ByteOrder::readU32(snapshot + 24) + (rtcNowMs - savedAt);
+    if (lastAge > _maxGapMs) {
+        return false;
+    }
+    _steps = ByteOrder::readU32(snapshot + 16);
+    _hasLast = true;
+    _lastMs = millisNow - (uint32_t)lastAge;
+    _lastValue = ByteOrder::readF32(snapshot + 28);
+    _nextGridMs = _lastMs + ByteOrder::readU32(snapshot + 32);
+    memcpy(_state, snapshot + kSnapshotHeaderSize, sizeof(float) * _size);
+    return true;
+}
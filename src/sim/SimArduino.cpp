@@ -0,0 +1,197 @@
+#include <Arduino.h>
+#include <stdarg.h>
+#include "SimBoard.h"
+
+namespace {
+    // 固件启动后剩余的堆 (设备上的典型值，模拟中不变)
+    constexpr uint32_t kFreeHeap = 280 * 1024;
+}
+
+HardwareSerial Serial;
+EspClass ESP;
+
+unsigned long millis() {
+    return SimBoard::getInstance().millis();
+}
+
+unsigned long micros() {
+    return (unsigned long)(uint32_t)SimBoard::getInstance().micros();
+}
+
+void delay(uint32_t ms) {
+    SimBoard::getInstance().advanceMicros((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+    SimBoard::getInstance().advanceMicros(us);
+}
+
+void yield() {
+}
+
+time_t sim_time(time_t* out) {
+    time_t seconds = (time_t)(SimBoard::getInstance().rtcMicros() / 1000000);
+    if (out != nullptr) {
+        *out = seconds;
+    }
+    return seconds;
+}
+
+int sim_gettimeofday(struct timeval* tv, void* tz) {
+    (void)tz;
+    uint64_t us = SimBoard::getInstance().rtcMicros();
+    tv->tv_sec = (time_t)(us / 1000000);
+    tv->tv_usec = (suseconds_t)(us % 1000000);
+    return 0;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    SimBoard::getInstance().digitalWrite(pin, level);
+}
+
+double ledcSetup(uint8_t channel, double frequency, uint8_t resolution) {
+    SimBoard::getInstance().ledcSetup(channel, (uint32_t)frequency, resolution);
+    return frequency;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel) {
+    SimBoard::getInstance().ledcAttachPin(pin, channel);
+}
+
+void ledcDetachPin(uint8_t pin) {
+    SimBoard::getInstance().ledcDetachPin(pin);
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+    SimBoard::getInstance().ledcWrite(channel, duty);
+}
+
+uint16_t analogRead(uint8_t pin) {
+    return SimBoard::getInstance().analogRead(pin);
+}
+
+void analogSetPinAttenuation(uint8_t pin, adc_attenuation_t attenuation) {
+    (void)pin;
+    (void)attenuation;
+}
+
+// --- HardwareSerial ---
+void HardwareSerial::begin(unsigned long baud) {
+    (void)baud;
+}
+
+int HardwareSerial::available() {
+    return SimBoard::getInstance().serialAvailable();
+}
+
+int HardwareSerial::read() {
+    return SimBoard::getInstance().serialRead();
+}
+
+void HardwareSerial::flush() {
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    SimBoard::getInstance().serialWrite((const char*)buffer, size);
+    return size;
+}
+
+size_t HardwareSerial::print(const char* text) {
+    return write((const uint8_t*)text, strlen(text));
+}
+
+size_t HardwareSerial::print(char c) {
+    return write((uint8_t)c);
+}
+
+size_t HardwareSerial::print(unsigned char value, int base) {
+    return printNumber(value, base);
+}
+
+size_t HardwareSerial::print(int value, int base) {
+    return print((long long)value, base);
+}
+
+size_t HardwareSerial::print(unsigned int value, int base) {
+    return printNumber(value, base);
+}
+
+size_t HardwareSerial::print(long value, int base) {
+    return print((long long)value, base);
+}
+
+size_t HardwareSerial::print(unsigned long value, int base) {
+    return printNumber(value, base);
+}
+
+size_t HardwareSerial::print(long long value, int base) {
+    // 与 Arduino 的 Print 相同: 只有十进制输出负号
+    if (base == DEC && value < 0) {
+        return print('-') + printNumber(0ULL - (unsigned long long)value, base);
+    }
+    return printNumber((unsigned long long)value, base);
+}
+
+size_t HardwareSerial::print(unsigned long long value, int base) {
+    return printNumber(value, base);
+}
+
+size_t HardwareSerial::print(double value, int digits) {
+    if (isnan(value)) return print("nan");
+    if (isinf(value)) return print("inf");
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return print(buffer);
+}
+
+size_t HardwareSerial::println() {
+    return print("\r\n");
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) {
+        return 0;
+    }
+    return write((const uint8_t*)buffer, (size_t)length < sizeof(buffer) ? (size_t)length : sizeof(buffer) - 1);
+}
+
+size_t HardwareSerial::printNumber(unsigned long long value, int base) {
+    if (base < 2) {
+        base = DEC;
+    }
+    char buffer[8 * sizeof(value) + 1];
+    char* p = buffer + sizeof(buffer) - 1;
+    *p = '\0';
+    do {
+        int digit = (int)(value % base);
+        *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= base;
+    } while (value != 0);
+    return print(p);
+}
+
+// --- EspClass ---
+void EspClass::restart() {
+    SimBoard::getInstance().runShutdownHandlers();
+    Serial.println("Restart requested, simulation ends.");
+    fflush(stdout);
+    exit(0);
+}
+
+uint32_t EspClass::getFreeHeap() {
+    return kFreeHeap;
+}
@@ -0,0 +1,147 @@
+#include "SimBleTransport.h"
+#include "TraceLog.h"
+#include <string.h>
+
+namespace {
+    // ATT notification header (opcode + handle)
+    constexpr uint16_t kAttHeaderSize = 3;
+    constexpr uint16_t kDefaultMtu = 23;
+
+    int indexOf(GattSink::Characteristic characteristic) {
+        return (int)characteristic;
+    }
+}
+
+SimBleTransport& SimBleTransport::getInstance() {
+    static SimBleTransport instance;
+    return instance;
+}
+
+SimBleTransport::SimBleTransport() :
+    listener(nullptr),
+    started(false),
+    connected(false),
+    advertising(false),
+    authenticated(false),
+    updatePasskey(0),
+    preferredMtu(kDefaultMtu),
+    mtu(kDefaultMtu)
+{
+    memset(notificationCounts, 0, sizeof(notificationCounts));
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool SimBleTransport::begin(const char* deviceName, uint16_t preferredMtu, Listener* listener) {
+    (void)deviceName;
+    this->listener = listener;
+    this->preferredMtu = preferredMtu;
+    started = true;
+    startAdvertising();
+    return true;
+}
+
+void SimBleTransport::setUpdatePasskey(uint32_t passkey) {
+    updatePasskey = passkey;
+}
+
+bool SimBleTransport::isConnected() const {
+    return connected;
+}
+
+void SimBleTransport::setValue(Characteristic characteristic, const uint8_t* data, size_t length) {
+    values[indexOf(characteristic)].assign(data, data + length);
+}
+
+void SimBleTransport::startAdvertising() {
+    advertising = true;
+    stats.advertisingStarts++;
+}
+
+bool SimBleTransport::send(Characteristic characteristic, const uint8_t* data, size_t length) {
+    if (!connected) {
+        return false;
+    }
+    TRACE_SCOPE_ARG(BLE_NOTIFY, ((uint32_t)characteristic << 16) | length);
+    int index = indexOf(characteristic);
+    notificationCounts[index]++;
+    lastNotifications[index].assign(data, data + length);
+    stats.notifications++;
+    stats.bytes += length;
+    if (length > (size_t)(mtu - kAttHeaderSize)) {
+        stats.oversized++;
+    }
+    return true;
+}
+
+const char* SimBleTransport::name() const {
+    return "Simulated";
+}
+
+bool SimBleTransport::connect(uint32_t connectionIntervalMs, uint16_t clientMtu) {
+    if (!started || connected || !advertising) {
+        return false;
+    }
+    connected = true;
+    advertising = false;
+    mtu = kDefaultMtu;
+    listener->onConnect(connectionIntervalMs);
+    uint16_t negotiated = clientMtu < preferredMtu ? clientMtu : preferredMtu;
+    if (negotiated > kDefaultMtu) {
+        mtu = negotiated;
+        listener->onMtuChanged(mtu);
+    }
+    return true;
+}
+
+void SimBleTransport::disconnect() {
+    if (!connected) {
+        return;
+    }
+    connected = false;
+    authenticated = false;
+    mtu = kDefaultMtu;
+    listener->onDisconnect();
+}
+
+bool SimBleTransport::pair(uint32_t passkey) {
+    authenticated = connected && passkey == updatePasskey;
+    return authenticated;
+}
+
+bool SimBleTransport::write(Characteristic characteristic, const uint8_t* data, size_t length) {
+    if (!connected || (characteristic == Characteristic::MODEL_UPDATE && !authenticated)) {
+        return false;
+    }
+    values[indexOf(characteristic)].assign(data, data + length);
+    listener->onWrite(characteristic, data, length);
+    return true;
+}
+
+bool SimBleTransport::isStarted() const {
+    return started;
+}
+
+uint16_t SimBleTransport::getMtu() const {
+    return mtu;
+}
+
+uint32_t SimBleTransport::getNotificationCount(Characteristic characteristic) const {
+    return notificationCounts[indexOf(characteristic)];
+}
+
+const std::vector<uint8_t>& SimBleTransport::getLastNotification(Characteristic characteristic) const {
+    return lastNotifications[indexOf(characteristic)];
+}
+
+const std::vector<uint8_t>& SimBleTransport::getValue(Characteristic characteristic) const {
+    return values[indexOf(characteristic)];
+}
+
+const SimBleTransport::Stats& SimBleTransport::getStats() const {
+    return stats;
+}
+
+void SimBleTransport::resetStats() {
+    memset(notificationCounts, 0, sizeof(notificationCounts));
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,315 @@
+#include "SimBoard.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "config.h"
+
+namespace {
+    // 外设操作在设备上的典型耗时 (虚拟时钟按此前进)
+    constexpr uint64_t kAnalogReadUs = 20;
+    constexpr uint64_t kI2cTransactionUs = 20;
+    constexpr uint64_t kI2cByteUs = 23;             // 400 kHz，每字节9位
+    constexpr uint64_t kDhtReadUs = 5000;           // 起始信号 + 40位数据
+    constexpr uint64_t kFlashSectorEraseUs = 45000;
+    constexpr uint64_t kFlashPageProgramUs = 700;   // 每256字节
+    constexpr size_t kFlashSectorSize = 4096;
+    constexpr size_t kFlashPageSize = 256;
+
+    constexpr uint8_t kPartitionTypeData = 0x01;
+    constexpr int kPartitionSubtypeAny = 0xFF;
+}
+
+SimBoard& SimBoard::getInstance() {
+    static SimBoard instance;
+    return instance;
+}
+
+SimBoard::SimBoard() :
+    _micros(0),
+    _rtcEpoch(0),
+    _ledOn(false),
+    _opticsOn(false),
+    _ledOnSinceUs(0),
+    _opticsOnSinceUs(0),
+    _serialSink(nullptr),
+    _shutdownHandlerCount(0)
+{
+    memset(_channelFrequency, 0, sizeof(_channelFrequency));
+    memset(_channelDuty, 0, sizeof(_channelDuty));
+    memset(_pinChannel, -1, sizeof(_pinChannel));
+    memset(_pinLevel, 0, sizeof(_pinLevel));
+    memset(&_stats, 0, sizeof(_stats));
+
+    // 与 custom_capture.csv (custom.csv 加上 capture 分区) 中的数据分区相同 (nvs 由 Preferences 模拟)
+    struct Entry { uint8_t subtype; const char* label; size_t size; };
+    const Entry table[] = {
+        { MODEL_PARTITION_SUBTYPE, MODEL_PARTITION_LABEL_A, 256 * 1024 },
+        { MODEL_PARTITION_SUBTYPE, MODEL_PARTITION_LABEL_B, 256 * 1024 },
+        { 0x99, "eeprom", 4 * 1024 },
+        { 0x82, "spiffs", 444 * 1024 },
+        { 0x82, "capture", 1024 * 1024 }
+    };
+    for (const Entry& entry : table) {
+        Partition partition;
+        partition.type = kPartitionTypeData;
+        partition.subtype = entry.subtype;
+        partition.label = entry.label;
+        partition.data.assign(entry.size, 0xFF);
+        _partitions.push_back(partition);
+    }
+}
+
+uint64_t SimBoard::micros() const {
+    return _micros.load();
+}
+
+uint32_t SimBoard::millis() const {
+    return (uint32_t)(_micros.load() / 1000);
+}
+
+void SimBoard::advanceMicros(uint64_t us) {
+    _micros += us;
+}
+
+void SimBoard::setRtcEpoch(uint32_t seconds) {
+    _rtcEpoch = seconds;
+}
+
+uint64_t SimBoard::rtcMicros() const {
+    return (uint64_t)_rtcEpoch * 1000000ULL + _micros.load();
+}
+
+SimPhysiology& SimBoard::getPhysiology() {
+    return _physiology;
+}
+
+void SimBoard::ledcSetup(uint8_t channel, uint32_t frequency, uint8_t resolution) {
+    (void)resolution;
+    if (channel < kChannels) {
+        _channelFrequency[channel] = frequency;
+    }
+}
+
+void SimBoard::ledcAttachPin(uint8_t pin, uint8_t channel) {
+    if (pin < kPins && channel < kChannels) {
+        _pinChannel[pin] = (int8_t)channel;
+        updateOptics();
+    }
+}
+
+void SimBoard::ledcDetachPin(uint8_t pin) {
+    if (pin < kPins) {
+        _pinChannel[pin] = -1;
+        updateOptics();
+    }
+}
+
+void SimBoard::ledcWrite(uint8_t channel, uint32_t duty) {
+    if (channel < kChannels) {
+        _channelDuty[channel] = duty;
+        updateOptics();
+    }
+}
+
+void SimBoard::digitalWrite(uint8_t pin, uint8_t level) {
+    if (pin < kPins) {
+        _pinLevel[pin] = level;
+        updateOptics();
+    }
+}
+
+bool SimBoard::isPinActive(uint8_t pin) const {
+    if (pin >= kPins) {
+        return false;
+    }
+    int channel = _pinChannel[pin];
+    return channel >= 0 ? _channelDuty[channel] > 0 : _pinLevel[pin] != 0;
+}
+
+bool SimBoard::isLedOn() const {
+    return isPinActive(PIN_LED_CTRL);
+}
+
+bool SimBoard::isDemodulatorOn() const {
+    return isPinActive(PIN_DEMOD_REF);
+}
+
+uint32_t SimBoard::getPwmFrequency(uint8_t pin) const {
+    return pin < kPins && _pinChannel[pin] >= 0 ? _channelFrequency[_pinChannel[pin]] : 0;
+}
+
+void SimBoard::updateOptics() {
+    uint64_t now = _micros.load();
+    bool ledOn = isLedOn();
+    if (ledOn != _ledOn) {
+        if (_ledOn) {
+            _stats.ledOnUs += now - _ledOnSinceUs;
+        }
+        _ledOn = ledOn;
+        _ledOnSinceUs = now;
+    }
+    bool opticsOn = ledOn && isDemodulatorOn();
+    if (opticsOn != _opticsOn) {
+        _opticsOn = opticsOn;
+        _opticsOnSinceUs = now;
+    }
+}
+
+uint16_t SimBoard::analogRead(uint8_t pin) {
+    _stats.analogReads++;
+    advanceMicros(kAnalogReadUs);
+    if (pin != PIN_ADC_IN) {
+        return 0;
+    }
+    int32_t opticsOnMs = _opticsOn ? (int32_t)((_micros.load() - _opticsOnSinceUs) / 1000) : -1;
+    float voltage = _physiology.sampleOptical(millis(), opticsOnMs);
+    long raw = lroundf(voltage * 4095.0f / 3.3f);
+    return (uint16_t)(raw < 0 ? 0 : (raw > 4095 ? 4095 : raw));
+}
+
+void SimBoard::setSerialSink(SerialSink sink) {
+    _serialSink = sink;
+}
+
+void SimBoard::serialWrite(const char* data, size_t length) {
+    _stats.serialBytes += length;
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] == '\n') {
+            if (_serialSink != nullptr) {
+                _serialSink(_serialLine.c_str());
+            } else {
+                puts(_serialLine.c_str());
+            }
+            _serialLine.clear();
+        } else if (data[i] != '\r') {
+            _serialLine += data[i];
+        }
+    }
+}
+
+void SimBoard::serialInput(const char* text) {
+    _serialInput += text;
+}
+
+int SimBoard::serialAvailable() const {
+    return (int)_serialInput.size();
+}
+
+int SimBoard::serialRead() {
+    if (_serialInput.empty()) {
+        return -1;
+    }
+    int c = (uint8_t)_serialInput[0];
+    _serialInput.erase(0, 1);
+    return c;
+}
+
+SimBoard::Partition* SimBoard::findPartition(uint8_t type, int subtype, const char* label) {
+    for (Partition& partition : _partitions) {
+        if (partition.type == type && (subtype == kPartitionSubtypeAny || partition.subtype == subtype) &&
+            (label == nullptr || strcmp(partition.label, label) == 0)) {
+            return &partition;
+        }
+    }
+    return nullptr;
+}
+
+bool SimBoard::loadPartition(const char* label, const char* path) {
+    Partition* partition = findPartition(kPartitionTypeData, kPartitionSubtypeAny, label);
+    FILE* file = partition != nullptr ? fopen(path, "rb") : nullptr;
+    if (file == nullptr) {
+        return false;
+    }
+    std::vector<uint8_t> image(partition->data.size() + 1);
+    size_t length = fread(image.data(), 1, image.size(), file);
+    fclose(file);
+    if (length > partition->data.size()) {
+        return false;
+    }
+    memcpy(partition->data.data(), image.data(), length);
+    memset(partition->data.data() + length, 0xFF, partition->data.size() - length);
+    return true;
+}
+
+bool SimBoard::savePartition(const char* label, const char* path) {
+    Partition* partition = findPartition(kPartitionTypeData, kPartitionSubtypeAny, label);
+    FILE* file = partition != nullptr ? fopen(path, "wb") : nullptr;
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(partition->data.data(), 1, partition->data.size(), file) == partition->data.size();
+    return fclose(file) == 0 && ok;
+}
+
+bool SimBoard::eraseFlash(Partition& partition, size_t offset, size_t length) {
+    if (offset % kFlashSectorSize != 0 || length % kFlashSectorSize != 0 || offset + length > partition.data.size()) {
+        return false;
+    }
+    memset(partition.data.data() + offset, 0xFF, length);
+    _stats.flashErases += length / kFlashSectorSize;
+    advanceMicros(length / kFlashSectorSize * kFlashSectorEraseUs);
+    return true;
+}
+
+bool SimBoard::writeFlash(Partition& partition, size_t offset, const void* data, size_t length) {
+    if (offset + length > partition.data.size()) {
+        return false;
+    }
+    // NOR flash 只能把位从1写成0，未擦除的位置写入的结果是新旧数据按位与
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < length; i++) {
+        partition.data[offset + i] &= bytes[i];
+    }
+    _stats.flashBytesWritten += length;
+    advanceMicros((length + kFlashPageSize - 1) / kFlashPageSize * kFlashPageProgramUs);
+    return true;
+}
+
+bool SimBoard::readFlash(const Partition& partition, size_t offset, void* out, size_t length) {
+    if (offset + length > partition.data.size()) {
+        return false;
+    }
+    memcpy(out, partition.data.data() + offset, length);
+    return true;
+}
+
+std::map<std::string, std::vector<uint8_t>>& SimBoard::getNvs() {
+    return _nvs;
+}
+
+bool SimBoard::addShutdownHandler(void (*handler)()) {
+    if (_shutdownHandlerCount >= kMaxShutdownHandlers) {
+        return false;
+    }
+    _shutdownHandlers[_shutdownHandlerCount++] = handler;
+    return true;
+}
+
+void SimBoard::runShutdownHandlers() {
+    for (int i = _shutdownHandlerCount - 1; i >= 0; i--) {
+        _shutdownHandlers[i]();
+    }
+}
+
+void SimBoard::i2cTransfer(size_t bytes) {
+    _stats.i2cTransactions++;
+    advanceMicros(kI2cTransactionUs + bytes * kI2cByteUs);
+}
+
+void SimBoard::fifoTransfer(int count) {
+    _stats.ppgSamples += count;
+    i2cTransfer(2 + 6 * count);
+}
+
+void SimBoard::dhtTransfer() {
+    _stats.dhtReads++;
+    advanceMicros(kDhtReadUs);
+}
+
+SimBoard::Stats SimBoard::getStats() const {
+    Stats stats = _stats;
+    if (_ledOn) {
+        stats.ledOnUs += _micros.load() - _ledOnSinceUs;
+    }
+    return stats;
+}
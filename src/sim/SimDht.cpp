@@ -0,0 +1,47 @@
+#include <DHT.h>
+#include "SimBoard.h"
+
+DHT::DHT(uint8_t pin, uint8_t type, uint8_t count) :
+    _pin(pin),
+    _type(type),
+    _lastReadTime(0),
+    _lastResult(false),
+    _temperature(NAN),
+    _humidity(NAN)
+{
+    (void)count;
+}
+
+void DHT::begin(uint8_t pullTimeUs) {
+    (void)pullTimeUs;
+    // 与库相同: 第一次读取不受间隔限制
+    _lastReadTime = millis() - kMinIntervalMs;
+}
+
+bool DHT::read(bool force) {
+    uint32_t now = millis();
+    if (!force && now - _lastReadTime < kMinIntervalMs) {
+        return _lastResult;
+    }
+    _lastReadTime = now;
+
+    SimBoard& board = SimBoard::getInstance();
+    board.dhtTransfer();
+    _lastResult = board.getPhysiology().readDht(board.millis(), &_temperature, &_humidity);
+    if (!_lastResult) {
+        _temperature = NAN;
+        _humidity = NAN;
+    }
+    return _lastResult;
+}
+
+float DHT::readTemperature(bool fahrenheit, bool force) {
+    if (!read(force)) {
+        return NAN;
+    }
+    return fahrenheit ? _temperature * 1.8f + 32.0f : _temperature;
+}
+
+float DHT::readHumidity(bool force) {
+    return read(force) ? _humidity : NAN;
+}
@@ -0,0 +1,102 @@
+#include <esp_partition.h>
+#include <esp_system.h>
+#include <string.h>
+#include "SimBoard.h"
+
+namespace {
+    constexpr int kMaxPartitions = 8;
+    // 第一个数据分区之后的地址仅用于显示
+    constexpr uint32_t kFirstPartitionAddress = 0x310000;
+
+    // 返回给固件的分区描述，与 SimBoard 中的分区一一对应 (地址不变，可以长期保存指针)
+    esp_partition_t descriptors[kMaxPartitions];
+    int descriptorCount = 0;
+
+    SimBoard::Partition* boardPartition(const esp_partition_t* partition) {
+        return SimBoard::getInstance().findPartition(partition->type, partition->subtype, partition->label);
+    }
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    SimBoard::Partition* found = SimBoard::getInstance().findPartition(type, subtype, label);
+    if (found == nullptr) {
+        return nullptr;
+    }
+    uint32_t address = kFirstPartitionAddress;
+    for (int i = 0; i < descriptorCount; i++) {
+        if (strcmp(descriptors[i].label, found->label) == 0) {
+            return &descriptors[i];
+        }
+        address = descriptors[i].address + descriptors[i].size;
+    }
+    if (descriptorCount >= kMaxPartitions) {
+        return nullptr;
+    }
+    esp_partition_t& descriptor = descriptors[descriptorCount++];
+    descriptor.type = (esp_partition_type_t)found->type;
+    descriptor.subtype = (esp_partition_subtype_t)found->subtype;
+    descriptor.address = address;
+    descriptor.size = (uint32_t)found->data.size();
+    strncpy(descriptor.label, found->label, sizeof(descriptor.label) - 1);
+    descriptor.label[sizeof(descriptor.label) - 1] = '\0';
+    descriptor.encrypted = false;
+    return &descriptor;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* out, size_t size) {
+    SimBoard::Partition* target = partition != nullptr ? boardPartition(partition) : nullptr;
+    if (target == nullptr || out == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return SimBoard::getInstance().readFlash(*target, offset, out, size) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset, const void* data, size_t size) {
+    SimBoard::Partition* target = partition != nullptr ? boardPartition(partition) : nullptr;
+    if (target == nullptr || data == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return SimBoard::getInstance().writeFlash(*target, offset, data, size) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    SimBoard::Partition* target = partition != nullptr ? boardPartition(partition) : nullptr;
+    if (target == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return SimBoard::getInstance().eraseFlash(*target, offset, size) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void** out, spi_flash_mmap_handle_t* handle) {
+    (void)memory;
+    SimBoard::Partition* target = partition != nullptr ? boardPartition(partition) : nullptr;
+    if (target == nullptr || out == nullptr || handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (offset + size > target->data.size()) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // 分区内容的大小不变，映射直接指向模拟的flash (之后的写入同样可见，与设备上的cache行为不同)
+    *out = target->data.data() + offset;
+    *handle = 1;
+    return ESP_OK;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle) {
+    (void)handle;
+}
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) {
+    return SimBoard::getInstance().addShutdownHandler(handler) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+uint32_t esp_random(void) {
+    // xorshift32
+    static uint32_t state = 0x2545F491;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
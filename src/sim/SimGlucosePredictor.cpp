@@ -0,0 +1,240 @@
+#include "GlucosePredictor.h"
+#include "ModelStore.h"
+#include "TraceLog.h"
+#include "model_ops.h"
+#include <Arduino.h>
+#include <math.h>
+
+// 主机模拟 (native-sim 环境) 中代替 src/prediction/GlucosePredictor.cpp 的实现。
+// 主机上没有 TFLite Micro，推理换成阻尼线性趋势: 对输入窗口做最小二乘斜率，
+// 曲线为 最新值 + 斜率·τ·(1 - e^(-t/τ))。历史、重采样与接口的行为与固件相同，
+// 因此主循环、检查点、BLE曲线与异步/同步推理的路径都按原样运行。
+
+namespace {
+    // 趋势衰减的时间常数 (分钟)
+    constexpr float kTrendTauMinutes = 5.0f;
+    // 一次推理在设备上的典型耗时 (虚拟时钟按此前进)
+    constexpr uint32_t kInvokeUs = 1000;
+
+    Ensemble::Config ensembleConfig() {
+        Ensemble::Config c;
+        c.tightWidth = ENSEMBLE_TIGHT_WIDTH_MGDL;
+        c.maxConsecutiveSkips = ENSEMBLE_MAX_CONSECUTIVE_SKIPS;
+        return c;
+    }
+
+    HistoryResampler::Config historyConfig() {
+        HistoryResampler::Config c;
+        c.gridStepMs = PREDICTOR_GRID_STEP_MS;
+        c.gridSize = GlucosePredictor::kHistorySize;
+        c.maxGapMs = PREDICTOR_MAX_GAP_MS;
+        c.maxStalenessMs = PREDICTOR_MAX_STALENESS_MS;
+        c.minQuality = PREDICTOR_MIN_QUALITY;
+        return c;
+    }
+}
+
+GlucosePredictor& GlucosePredictor::getInstance() {
+    static GlucosePredictor instance;
+    return instance;
+}
+
+GlucosePredictor::GlucosePredictor() :
+    _is_initialized(false),
+    _init_time_us(0),
+    _quantized(false),
+    _input_size(0),
+    _output_count(0),
+    _streaming(false),
+    _stream_curve{ nullptr, 0 },
+    _invoke_count(0),
+    _last_invoke_us(0),
+    _max_invoke_us(0),
+    _total_invoke_us(0),
+    _history(historyConfig()),
+    _ensemble(ensembleConfig()),
+    _has_ensemble_result(false),
+    _capture(nullptr)
+{
+}
+
+bool GlucosePredictor::begin() {
+    unsigned long startTime = micros();
+    // 分区中的模型不能在主机上运行，按加载成功处理，A/B槽的试运行与确认流程与设备相同 (见 runInference)
+    if (ModelStore::getInstance().getModelData() == nullptr) {
+#if MODEL_EMBEDDED_FALLBACK
+        // 内置模型与设备上一样检查算子，包含没有TFLM内核的自定义算子时加载失败
+        Serial.println("No valid model partition, using built-in model.");
+        if (kModelUnsupportedOps[0] != nullptr) {
+            Serial.printf("Model requires custom op '%s' which has no TFLM kernel.\n", kModelUnsupportedOps[0]);
+            _init_time_us = micros() - startTime;
+            return false;
+        }
+#else
+        return false;
+#endif
+    }
+    _input_size = kHistorySize;
+    _output_count = PREDICTION_MAX_HORIZON;
+    _is_initialized = true;
+    _init_time_us = micros() - startTime;
+    return true;
+}
+
+void GlucosePredictor::addGlucoseReading(float value, uint32_t timestampMs, float quality) {
+    _history.add(timestampMs, value, quality);
+}
+
+HistoryResampler::Status GlucosePredictor::getHistoryStatus() const {
+    HistoryResampler::Window window;
+    return _history.resample(nowMs(), &window);
+}
+
+const HistoryResampler& GlucosePredictor::getHistory() const {
+    return _history;
+}
+
+void GlucosePredictor::restoreHistory(const HistoryResampler& history) {
+    _history = history;
+}
+
+void GlucosePredictor::saveStreamingState() {
+    // 模拟中的模型不是流式模型
+}
+
+bool GlucosePredictor::isReadyToPredict() const {
+    return getHistoryStatus() == HistoryResampler::Status::OK;
+}
+
+float GlucosePredictor::predict() {
+    PredictionCurve::Curve curve = predictCurve();
+    return curve.size > 0 ? curve.data[0] : 0.0f;
+}
+
+PredictionCurve::Curve GlucosePredictor::predictCurve() {
+    TRACE_SCOPE(PREDICT);
+    float window[kMaxInputSize];
+    if (getInputWindow(window) == 0) {
+        return PredictionCurve::Curve{ nullptr, 0 };
+    }
+    return runInference(window);
+}
+
+int GlucosePredictor::getInputWindow(float* window) const {
+    HistoryResampler::Window resampled;
+    if (_input_size == 0 || _history.resample(nowMs(), &resampled) != HistoryResampler::Status::OK) {
+        return 0;
+    }
+    for (int i = 0; i < kHistorySize; ++i) {
+        window[i] = resampled.values[i];
+    }
+    return _input_size;
+}
+
+PredictionCurve::Curve GlucosePredictor::runInference(const float* window) {
+    TRACE_SCOPE(INFERENCE);
+    if (!_is_initialized) {
+        return PredictionCurve::Curve{ nullptr, 0 };
+    }
+    unsigned long invokeStart = micros();
+
+    // 网格点 i 相对窗口中点的时间 (分钟) 与最小二乘斜率 (mg/dL/min)
+    const float stepMinutes = PREDICTOR_GRID_STEP_MS / 60000.0f;
+    float mean = 0.0f;
+    for (int i = 0; i < kHistorySize; i++) {
+        mean += window[i];
+    }
+    mean /= kHistorySize;
+    float covariance = 0.0f;
+    float variance = 0.0f;
+    for (int i = 0; i < kHistorySize; i++) {
+        float t = (i - (kHistorySize - 1) / 2.0f) * stepMinutes;
+        covariance += t * (window[i] - mean);
+        variance += t * t;
+    }
+    float slope = covariance / variance;
+
+    float last = window[kHistorySize - 1];
+    for (int k = 0; k < _output_count; k++) {
+        float t = (k + 1) * (float)PREDICTION_STEP_MINUTES;
+        _curve_buffer[k] = last + slope * kTrendTauMinutes * (1.0f - expf(-t / kTrendTauMinutes));
+    }
+
+    delayMicroseconds(kInvokeUs);
+    recordInvokeTime(micros() - invokeStart);
+    ModelStore::getInstance().reportInference(true, _curve_buffer, _output_count);
+    return PredictionCurve::Curve{ _curve_buffer, _output_count };
+}
+
+bool GlucosePredictor::isStreaming() const {
+    return false;
+}
+
+bool GlucosePredictor::isEnsemble() const {
+    return false;
+}
+
+const Ensemble::Result* GlucosePredictor::getLastEnsembleResult() const {
+    return nullptr;
+}
+
+int GlucosePredictor::getInputSize() const {
+    return _input_size;
+}
+
+unsigned long GlucosePredictor::getInitTimeUs() const {
+    return _init_time_us;
+}
+
+size_t GlucosePredictor::getArenaSize() const {
+    return 0;
+}
+
+size_t GlucosePredictor::getArenaUsedBytes() const {
+    return 0;
+}
+
+bool GlucosePredictor::isArenaInPsram() const {
+    return false;
+}
+
+bool GlucosePredictor::isQuantized() const {
+    return false;
+}
+
+unsigned long GlucosePredictor::getLastInvokeUs() const {
+    return _last_invoke_us;
+}
+
+unsigned long GlucosePredictor::getMaxInvokeUs() const {
+    return _max_invoke_us;
+}
+
+unsigned long GlucosePredictor::getAverageInvokeUs() const {
+    return _invoke_count > 0 ? (unsigned long)(_total_invoke_us / _invoke_count) : 0;
+}
+
+const OpProfile* GlucosePredictor::getOpProfile() const {
+#if PREDICTOR_PROFILING
+    return &_op_profile;
+#else
+    return nullptr;
+#endif
+}
+
+void GlucosePredictor::setCapture(SensorCapture* capture) {
+    _capture = capture;
+}
+
+void GlucosePredictor::recordInvokeTime(unsigned long us) {
+    _last_invoke_us = us;
+    if (us > _max_invoke_us) {
+        _max_invoke_us = us;
+    }
+    _total_invoke_us += us;
+    _invoke_count++;
+}
+
+uint32_t GlucosePredictor::nowMs() const {
+    return _capture != nullptr ? _capture->clock(millis()) : millis();
+}
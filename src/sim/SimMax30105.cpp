@@ -0,0 +1,135 @@
+#include <MAX30105.h>
+#include "SimBoard.h"
+
+namespace {
+    // 读取 FIFO_WR_PTR / FIFO_RD_PTR (寄存器地址与数据)
+    constexpr size_t kPointerReadBytes = 4;
+}
+
+TwoWire Wire;
+
+MAX30105::MAX30105() :
+    _writePointer(0),
+    _readPointer(0),
+    _samplePeriodUs(10000),
+    _nextSampleUs(0),
+    _running(false),
+    _head(0),
+    _tail(0)
+{
+    memset(_fifoIr, 0, sizeof(_fifoIr));
+    memset(_fifoRed, 0, sizeof(_fifoRed));
+    memset(_ir, 0, sizeof(_ir));
+    memset(_red, 0, sizeof(_red));
+}
+
+bool MAX30105::begin(TwoWire& wirePort, uint32_t i2cSpeed, uint8_t address) {
+    (void)wirePort;
+    (void)i2cSpeed;
+    (void)address;
+    // 读取 PART_ID
+    SimBoard::getInstance().i2cTransfer(3);
+    return true;
+}
+
+void MAX30105::setup(uint8_t powerLevel, uint8_t sampleAverage, uint8_t ledMode, int sampleRate,
+                     int pulseWidth, int adcRange) {
+    (void)powerLevel;
+    (void)ledMode;
+    (void)pulseWidth;
+    (void)adcRange;
+    // 软复位与配置寄存器的写入
+    for (int i = 0; i < 8; i++) {
+        SimBoard::getInstance().i2cTransfer(3);
+    }
+    if (sampleAverage == 0) sampleAverage = 1;
+    if (sampleRate <= 0) sampleRate = 400;
+    _samplePeriodUs = 1000000ULL * sampleAverage / sampleRate;
+    _running = true;
+    clearFIFO();
+}
+
+void MAX30105::clearFIFO() {
+    SimBoard::getInstance().i2cTransfer(9);
+    _writePointer = 0;
+    _readPointer = 0;
+    _nextSampleUs = SimBoard::getInstance().micros() + _samplePeriodUs;
+}
+
+void MAX30105::sample() {
+    if (!_running) {
+        return;
+    }
+    SimBoard& board = SimBoard::getInstance();
+    uint64_t now = board.micros();
+    // 很长时间未读取时只需要产生最后一轮FIFO中的样本
+    if (now >= _nextSampleUs + kFifoDepth * _samplePeriodUs) {
+        uint64_t skipped = (now - _nextSampleUs) / _samplePeriodUs + 1 - kFifoDepth;
+        _writePointer = (uint8_t)((_writePointer + skipped) % kFifoDepth);
+        _nextSampleUs += skipped * _samplePeriodUs;
+    }
+    while (_nextSampleUs <= now) {
+        board.getPhysiology().samplePpg((uint32_t)(_nextSampleUs / 1000), &_fifoIr[_writePointer],
+                                        &_fifoRed[_writePointer]);
+        _writePointer = (_writePointer + 1) % kFifoDepth;
+        _nextSampleUs += _samplePeriodUs;
+    }
+}
+
+uint16_t MAX30105::check() {
+    sample();
+    SimBoard& board = SimBoard::getInstance();
+    board.i2cTransfer(kPointerReadBytes);
+    // 与芯片相同: FIFO满后读写指针重合，看起来没有新样本
+    int count = (_writePointer - _readPointer + kFifoDepth) % kFifoDepth;
+    if (count == 0) {
+        return 0;
+    }
+    board.fifoTransfer(count);
+    for (int i = 0; i < count; i++) {
+        _head = (_head + 1) % kStorageSize;
+        _ir[_head] = _fifoIr[_readPointer];
+        _red[_head] = _fifoRed[_readPointer];
+        _readPointer = (_readPointer + 1) % kFifoDepth;
+    }
+    return (uint16_t)count;
+}
+
+bool MAX30105::safeCheck(uint8_t maxTimeToCheck) {
+    uint32_t start = millis();
+    while (true) {
+        if (millis() - start > maxTimeToCheck) {
+            return false;
+        }
+        if (check() > 0) {
+            return true;
+        }
+        delay(1);
+    }
+}
+
+uint8_t MAX30105::available() {
+    return (uint8_t)((_head - _tail + kStorageSize) % kStorageSize);
+}
+
+void MAX30105::nextSample() {
+    if (available() > 0) {
+        _tail = (_tail + 1) % kStorageSize;
+    }
+}
+
+uint32_t MAX30105::getFIFORed() {
+    return _red[_tail];
+}
+
+uint32_t MAX30105::getFIFOIR() {
+    return _ir[_tail];
+}
+
+uint32_t MAX30105::getRed() {
+    return safeCheck(250) ? _red[_head] : 0;
+}
+
+uint32_t MAX30105::getIR() {
+    return safeCheck(250) ? _ir[_head] : 0;
+}
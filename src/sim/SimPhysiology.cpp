@@ -0,0 +1,204 @@
+#include "SimPhysiology.h"
+#include <math.h>
+
+namespace {
+    constexpr float kTwoPi = 6.28318530718f;
+    // 餐后响应 x·e^(1-x) 达到峰值的时间
+    constexpr float kMealPeakMs = 40.0f * 60000.0f;
+    // 呼吸周期 (心率随呼吸的变化) 与温湿度缓慢变化的周期
+    constexpr uint32_t kBreathPeriodMs = 4000;
+    constexpr uint32_t kTemperaturePeriodMs = 3600000;
+    constexpr uint32_t kHumidityPeriodMs = 5400000;
+    // 光路稳定的时间常数与慢变噪声的时间常数 (毫秒)
+    constexpr float kOpticsSettleMs = 2.0f;
+    constexpr float kDriftTauMs = 200.0f;
+    constexpr uint32_t kDriftStepMs = 10;
+    // 手指不在传感器上时的环境光与暗电平
+    constexpr uint32_t kAmbientIr = 1500;
+    constexpr uint32_t kAmbientRed = 1200;
+    constexpr float kDarkVoltage = 0.02f;
+    constexpr float kMaxPpgCount = 262143.0f;   // 18位ADC
+
+    float quantize(float value, float step) {
+        return roundf(value / step) * step;
+    }
+
+    float cycle(uint32_t timeMs, uint32_t periodMs) {
+        return sinf(kTwoPi * (timeMs % periodMs) / (float)periodMs);
+    }
+}
+
+SimPhysiology::Profile SimPhysiology::defaultProfile() {
+    Profile p;
+    p.baselineGlucose = 100.0f;
+    p.heartRate = 72.0f;
+    p.heartRateVariation = 3.0f;
+    p.spo2 = 97.0f;
+    p.perfusionIndex = 0.015f;
+    p.irDc = 120000;
+    p.redDc = 90000;
+    p.ppgNoise = 8.0f;
+    p.ambientTemperature = 24.5f;
+    p.humidity = 45.0f;
+    p.opticalNoiseMgdl = 4.0f;
+    p.opticalDriftMgdl = 2.5f;
+    p.dhtFailureRate = 0.0f;
+    p.seed = 1;
+    return p;
+}
+
+SimPhysiology::SimPhysiology(const Profile& profile) {
+    reset(profile);
+}
+
+void SimPhysiology::reset(const Profile& profile) {
+    _profile = profile;
+    _mealCount = 0;
+    _fingerPresent = true;
+    _phase = 0.0f;
+    _lastPpgMs = 0;
+    _hasPpg = false;
+    _drift = 0.0f;
+    _driftMs = 0;
+    _ppgNoise.seed(profile.seed * 3 + 1);
+    _opticalNoise.seed(profile.seed * 3 + 2);
+    _dhtNoise.seed(profile.seed * 3 + 3);
+}
+
+const SimPhysiology::Profile& SimPhysiology::getProfile() const {
+    return _profile;
+}
+
+bool SimPhysiology::addMeal(uint32_t timeMs, float peakMgdl) {
+    if (_mealCount >= kMaxMeals) {
+        return false;
+    }
+    _meals[_mealCount++] = Meal{ timeMs, peakMgdl };
+    return true;
+}
+
+void SimPhysiology::setFingerPresent(bool present) {
+    _fingerPresent = present;
+}
+
+bool SimPhysiology::isFingerPresent() const {
+    return _fingerPresent;
+}
+
+float SimPhysiology::getGlucose(uint32_t timeMs) const {
+    float glucose = _profile.baselineGlucose;
+    for (int i = 0; i < _mealCount; i++) {
+        if (timeMs >= _meals[i].timeMs) {
+            float x = (timeMs - _meals[i].timeMs) / kMealPeakMs;
+            glucose += _meals[i].peakMgdl * x * expf(1.0f - x);
+        }
+    }
+    return glucose;
+}
+
+float SimPhysiology::getHeartRate(uint32_t timeMs) const {
+    return _profile.heartRate + _profile.heartRateVariation * cycle(timeMs, kBreathPeriodMs);
+}
+
+float SimPhysiology::getSpO2() const {
+    return _profile.spo2;
+}
+
+float SimPhysiology::getTemperature(uint32_t timeMs) const {
+    return quantize(_profile.ambientTemperature + 0.3f * cycle(timeMs, kTemperaturePeriodMs), 0.1f);
+}
+
+float SimPhysiology::getHumidity(uint32_t timeMs) const {
+    return quantize(_profile.humidity + 2.0f * cycle(timeMs, kHumidityPeriodMs), 0.1f);
+}
+
+float SimPhysiology::pulseShape(float phase) const {
+    // 收缩期的主波与舒张期的重搏波，峰值约为1
+    float systolic = (phase - 0.2f) / 0.08f;
+    float dicrotic = (phase - 0.5f) / 0.1f;
+    return expf(-systolic * systolic) + 0.3f * expf(-dicrotic * dicrotic);
+}
+
+void SimPhysiology::samplePpg(uint32_t timeMs, uint32_t* ir, uint32_t* red) {
+    if (!_hasPpg) {
+        _lastPpgMs = timeMs;
+        _hasPpg = true;
+    }
+    _phase += (timeMs - _lastPpgMs) / 60000.0f * getHeartRate(timeMs);
+    _phase -= floorf(_phase);
+    _lastPpgMs = timeMs;
+
+    float irValue;
+    float redValue;
+    if (_fingerPresent) {
+        // 收缩期血容量增加，吸收增多，反射光减弱；SpO2 = 104 - 17R
+        float ratio = (104.0f - _profile.spo2) / 17.0f;
+        float pulse = pulseShape(_phase);
+        irValue = _profile.irDc * (1.0f - _profile.perfusionIndex * pulse);
+        redValue = _profile.redDc * (1.0f - _profile.perfusionIndex * ratio * pulse);
+    } else {
+        irValue = (float)kAmbientIr;
+        redValue = (float)kAmbientRed;
+    }
+    irValue += _profile.ppgNoise * _ppgNoise.gaussian();
+    redValue += _profile.ppgNoise * _ppgNoise.gaussian();
+    *ir = (uint32_t)fminf(fmaxf(irValue, 0.0f), kMaxPpgCount);
+    *red = (uint32_t)fminf(fmaxf(redValue, 0.0f), kMaxPpgCount);
+}
+
+float SimPhysiology::sampleOptical(uint32_t timeMs, int32_t opticsOnMs) {
+    // 慢变噪声按时间推进 (间隔很长时直接取平稳分布)
+    uint32_t steps = (timeMs - _driftMs) / kDriftStepMs;
+    if (steps > 200) {
+        _drift = _profile.opticalDriftMgdl * _opticalNoise.gaussian();
+    } else {
+        float rho = expf(-(float)kDriftStepMs / kDriftTauMs);
+        float innovation = _profile.opticalDriftMgdl * sqrtf(1.0f - rho * rho);
+        for (uint32_t i = 0; i < steps; i++) {
+            _drift = rho * _drift + innovation * _opticalNoise.gaussian();
+        }
+    }
+    _driftMs += steps * kDriftStepMs;
+
+    float white = _profile.opticalNoiseMgdl * _opticalNoise.gaussian();
+    if (opticsOnMs < 0 || !_fingerPresent) {
+        return kDarkVoltage + white / 1000.0f;
+    }
+    // GlucoseCalculator::calculate() 的反函数
+    float glucose = getGlucose(timeMs) + _drift + white;
+    float voltage = (glucose - getTemperature(timeMs) + _profile.irDc / 20000.0f) / 100.0f;
+    float settle = 1.0f - expf(-(float)opticsOnMs / kOpticsSettleMs);
+    return kDarkVoltage + (voltage - kDarkVoltage) * settle;
+}
+
+bool SimPhysiology::readDht(uint32_t timeMs, float* temperature, float* humidity) {
+    if (_dhtNoise.uniform() < _profile.dhtFailureRate) {
+        return false;
+    }
+    *temperature = getTemperature(timeMs);
+    *humidity = getHumidity(timeMs);
+    return true;
+}
+
+void SimPhysiology::Noise::seed(uint32_t s) {
+    state = s;
+    hasSpare = false;
+    spare = 0.0f;
+}
+
+float SimPhysiology::Noise::uniform() {
+    state = state * 1664525u + 1013904223u;
+    return ((state >> 8) + 0.5f) / 16777216.0f;
+}
+
+float SimPhysiology::Noise::gaussian() {
+    if (hasSpare) {
+        hasSpare = false;
+        return spare;
+    }
+    float radius = sqrtf(-2.0f * logf(uniform()));
+    float angle = kTwoPi * uniform();
+    spare = radius * sinf(angle);
+    hasSpare = true;
+    return radius * cosf(angle);
+}
@@ -0,0 +1,132 @@
+#include <Preferences.h>
+#include "SimBoard.h"
+
+namespace {
+    constexpr size_t kMaxNameLength = 15;
+}
+
+Preferences::Preferences() :
+    _started(false),
+    _readOnly(false)
+{
+}
+
+Preferences::~Preferences() {
+    end();
+}
+
+bool Preferences::begin(const char* name, bool readOnly, const char* partitionLabel) {
+    (void)partitionLabel;
+    if (_started || name == nullptr || strlen(name) == 0 || strlen(name) > kMaxNameLength) {
+        return false;
+    }
+    _namespace = name;
+    _readOnly = readOnly;
+    _started = true;
+    return true;
+}
+
+void Preferences::end() {
+    _started = false;
+}
+
+bool Preferences::fullKey(const char* key, std::string* out) const {
+    if (!_started || key == nullptr || strlen(key) == 0 || strlen(key) > kMaxNameLength) {
+        return false;
+    }
+    *out = _namespace + "/" + key;
+    return true;
+}
+
+bool Preferences::clear() {
+    if (!_started || _readOnly) {
+        return false;
+    }
+    std::map<std::string, std::vector<uint8_t>>& nvs = SimBoard::getInstance().getNvs();
+    std::string prefix = _namespace + "/";
+    for (auto it = nvs.begin(); it != nvs.end();) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            it = nvs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    std::string name;
+    if (_readOnly || !fullKey(key, &name)) {
+        return false;
+    }
+    return SimBoard::getInstance().getNvs().erase(name) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    std::string name;
+    return fullKey(key, &name) && SimBoard::getInstance().getNvs().count(name) > 0;
+}
+
+size_t Preferences::putChar(const char* key, int8_t value) {
+    return putBytes(key, &value, sizeof(value));
+}
+
+size_t Preferences::putUChar(const char* key, uint8_t value) {
+    return putBytes(key, &value, sizeof(value));
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return putBytes(key, &value, sizeof(value));
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    std::string name;
+    if (_readOnly || value == nullptr || length == 0 || !fullKey(key, &name)) {
+        return 0;
+    }
+    const uint8_t* bytes = (const uint8_t*)value;
+    SimBoard::getInstance().getNvs()[name].assign(bytes, bytes + length);
+    return length;
+}
+
+int8_t Preferences::getChar(const char* key, int8_t defaultValue) {
+    int8_t value;
+    return getBytesLength(key) == sizeof(value) && getBytes(key, &value, sizeof(value)) == sizeof(value) ?
+           value : defaultValue;
+}
+
+uint8_t Preferences::getUChar(const char* key, uint8_t defaultValue) {
+    uint8_t value;
+    return getBytesLength(key) == sizeof(value) && getBytes(key, &value, sizeof(value)) == sizeof(value) ?
+           value : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    uint32_t value;
+    return getBytesLength(key) == sizeof(value) && getBytes(key, &value, sizeof(value)) == sizeof(value) ?
+           value : defaultValue;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    std::string name;
+    if (!fullKey(key, &name)) {
+        return 0;
+    }
+    std::map<std::string, std::vector<uint8_t>>& nvs = SimBoard::getInstance().getNvs();
+    auto it = nvs.find(name);
+    return it != nvs.end() ? it->second.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLength) {
+    std::string name;
+    if (buffer == nullptr || !fullKey(key, &name)) {
+        return 0;
+    }
+    std::map<std::string, std::vector<uint8_t>>& nvs = SimBoard::getInstance().getNvs();
+    auto it = nvs.find(name);
+    if (it == nvs.end() || it->second.size() > maxLength) {
+        return 0;
+    }
+    memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+}
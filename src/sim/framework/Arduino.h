@@ -0,0 +1,113 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// 主机模拟 (native-sim 环境) 中代替 Arduino-ESP32 核心的头文件，只提供固件用到的接口，
+// 由 src/sim/SimArduino.cpp 转给 SimBoard (虚拟时钟、引脚、串口)。不定义 ARDUINO / ESP_PLATFORM。
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/time.h>
+
+typedef uint8_t byte;
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+// --- 时间 (虚拟时钟) ---
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// RTC: 固件中的 time()/gettimeofday() 读取虚拟时钟 (只替换包含本头文件之后的调用)
+time_t sim_time(time_t* out);
+int sim_gettimeofday(struct timeval* tv, void* tz);
+#define time(out) sim_time(out)
+#define gettimeofday(tv, tz) sim_gettimeofday(tv, tz)
+
+// --- GPIO / LEDC / ADC ---
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+double ledcSetup(uint8_t channel, double frequency, uint8_t resolution);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcDetachPin(uint8_t pin);
+void ledcWrite(uint8_t channel, uint32_t duty);
+
+typedef enum {
+    ADC_0db,
+    ADC_2_5db,
+    ADC_6db,
+    ADC_11db
+} adc_attenuation_t;
+
+uint16_t analogRead(uint8_t pin);
+void analogSetPinAttenuation(uint8_t pin, adc_attenuation_t attenuation);
+
+// --- 串口 ---
+class HardwareSerial {
+public:
+    void begin(unsigned long baud);
+    int available();
+    int read();
+    void flush();
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buffer, size_t size);
+
+    size_t print(const char* text);
+    size_t print(char c);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(long long value, int base = DEC);
+    size_t print(unsigned long long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    template <typename T>
+    size_t println(T value) {
+        size_t n = print(value);
+        return n + println();
+    }
+    template <typename T>
+    size_t println(T value, int format) {
+        size_t n = print(value, format);
+        return n + println();
+    }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+    size_t printNumber(unsigned long long value, int base);
+};
+
+extern HardwareSerial Serial;
+
+// --- 芯片 ---
+class EspClass {
+public:
+    /**
+     * @brief 与设备相同先运行关机回调，之后结束模拟程序 (单例无法重新构造，不能真正重启)。
+     */
+    [[noreturn]] void restart();
+    uint32_t getFreeHeap();
+};
+
+extern EspClass ESP;
+
+#endif // SIM_ARDUINO_H
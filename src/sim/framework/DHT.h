@@ -0,0 +1,32 @@
+#ifndef SIM_DHT_H
+#define SIM_DHT_H
+
+// 主机模拟中的 Adafruit DHT 库: 读数来自 SimPhysiology，与库相同两次读取间隔小于2秒时返回上一次的结果
+
+#include <Arduino.h>
+
+#define DHT11 11
+#define DHT21 21
+#define DHT22 22
+
+class DHT {
+public:
+    DHT(uint8_t pin, uint8_t type, uint8_t count = 6);
+
+    void begin(uint8_t pullTimeUs = 55);
+    float readTemperature(bool fahrenheit = false, bool force = false);
+    float readHumidity(bool force = false);
+    bool read(bool force = false);
+
+private:
+    static constexpr uint32_t kMinIntervalMs = 2000;
+
+    uint8_t _pin;
+    uint8_t _type;
+    uint32_t _lastReadTime;
+    bool _lastResult;
+    float _temperature;
+    float _humidity;
+};
+
+#endif // SIM_DHT_H
@@ -0,0 +1,62 @@
+#ifndef SIM_MAX30105_H
+#define SIM_MAX30105_H
+
+// 主机模拟中的 SparkFun MAX3010x 库。芯片按 setup() 的采样率与平均次数产生样本 (来自 SimPhysiology)，
+// 与设备相同写入32个样本的FIFO (满后覆盖，读指针不变)；check() 按读写指针读出新样本，
+// 存入库中只有 kStorageSize 个位置的环形缓冲区，I2C 传输计入虚拟时间。
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define MAX30105_ADDRESS 0x57
+#define I2C_SPEED_STANDARD 100000
+#define I2C_SPEED_FAST 400000
+
+class MAX30105 {
+public:
+    MAX30105();
+
+    bool begin(TwoWire& wirePort = Wire, uint32_t i2cSpeed = I2C_SPEED_STANDARD, uint8_t address = MAX30105_ADDRESS);
+    void setup(uint8_t powerLevel = 0x1F, uint8_t sampleAverage = 4, uint8_t ledMode = 3, int sampleRate = 400,
+               int pulseWidth = 411, int adcRange = 4096);
+
+    // 读出芯片FIFO中的新样本，返回读出的个数
+    uint16_t check();
+    // 等待新样本，最多 maxTimeToCheck 毫秒
+    bool safeCheck(uint8_t maxTimeToCheck);
+    void clearFIFO();
+
+    // 库中缓冲区的未读样本数
+    uint8_t available();
+    void nextSample();
+    // 与库相同返回 tail 位置的样本 (库的实现中比最早的未读样本晚一个，连续读取时只是延迟一个样本)
+    uint32_t getFIFORed();
+    uint32_t getFIFOIR();
+    // 与库相同: 先等待新样本 (safeCheck(250))，再返回最新的样本
+    uint32_t getRed();
+    uint32_t getIR();
+
+private:
+    static constexpr int kFifoDepth = 32;
+    static constexpr int kStorageSize = 4;      // 与库的 STORAGE_SIZE 相同
+
+    // 产生到当前时间为止的样本
+    void sample();
+
+    // 芯片FIFO
+    uint32_t _fifoIr[kFifoDepth];
+    uint32_t _fifoRed[kFifoDepth];
+    uint8_t _writePointer;
+    uint8_t _readPointer;
+    uint64_t _samplePeriodUs;
+    uint64_t _nextSampleUs;
+    bool _running;
+
+    // 库中的缓冲区
+    uint32_t _ir[kStorageSize];
+    uint32_t _red[kStorageSize];
+    uint8_t _head;
+    uint8_t _tail;
+};
+
+#endif // SIM_MAX30105_H
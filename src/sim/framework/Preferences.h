@@ -0,0 +1,42 @@
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+// 主机模拟中的NVS (Arduino Preferences)，键值保存在 SimBoard 中，跨"重启"保留。
+// 与设备相同: 命名空间与键名最长15个字符，只读打开时写入失败，缓冲区不够时 getBytes() 返回0。
+
+#include <Arduino.h>
+#include <string>
+
+class Preferences {
+public:
+    Preferences();
+    ~Preferences();
+
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putChar(const char* key, int8_t value);
+    size_t putUChar(const char* key, uint8_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putBytes(const char* key, const void* value, size_t length);
+
+    int8_t getChar(const char* key, int8_t defaultValue = 0);
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t maxLength);
+
+private:
+    // 打开的命名空间中的完整键名，键名无效或未打开时返回false
+    bool fullKey(const char* key, std::string* out) const;
+
+    bool _started;
+    bool _readOnly;
+    std::string _namespace;
+};
+
+#endif // SIM_PREFERENCES_H
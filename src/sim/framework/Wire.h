@@ -0,0 +1,27 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+// 主机模拟中的I2C总线: 传输由各模拟外设计入 SimBoard 的统计与虚拟时间
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+    bool begin(int sda, int scl, uint32_t frequency) {
+        (void)sda;
+        (void)scl;
+        _frequency = frequency;
+        return true;
+    }
+
+    uint32_t getClock() const {
+        return _frequency;
+    }
+
+private:
+    uint32_t _frequency = 100000;
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
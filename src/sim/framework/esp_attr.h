@@ -0,0 +1,7 @@
+#ifndef SIM_ESP_ATTR_H
+#define SIM_ESP_ATTR_H
+
+// 主机上没有RTC内存，RTC_NOINIT 变量是普通的全局变量 (模拟中不发生复位)
+#define RTC_NOINIT_ATTR
+
+#endif // SIM_ESP_ATTR_H
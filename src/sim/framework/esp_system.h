@@ -0,0 +1,15 @@
+#ifndef SIM_ESP_SYSTEM_H
+#define SIM_ESP_SYSTEM_H
+
+// 关机回调由 ESP.restart() 运行 (见 SimBoard)；esp_random() 为固定种子的伪随机数，每次运行相同
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef void (*shutdown_handler_t)(void);
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler);
+
+uint32_t esp_random(void);
+
+#endif // SIM_ESP_SYSTEM_H
@@ -0,0 +1,136 @@
+#ifndef PIO_UNIT_TESTING
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "SimBoard.h"
+#include "SimBleTransport.h"
+#include "TraceLog.h"
+
+// 主机模拟的入口: 运行固件的 setup()，之后反复调用 loop() 直到虚拟时间达到指定的秒数。
+// 用法: program [秒] [--seed N] [--meal 分钟:峰值mg/dL]... [--connect] [--flash 分区=文件]... [--dump 分区=文件]...
+//       [--trace 文件]
+//   --connect  启动后模拟的手机立即连接 (之后的BLE通知计入汇总)
+//   --flash    用文件替换分区的内容 (例如设备上读出的 capture 分区，配合 SENSOR_CAPTURE_MODE=2 回放；
+//              或 model_a 分区的模型镜像，没有时与设备上一样只测量不预测)
+//   --dump     结束时把分区的内容写到文件 (例如 SENSOR_CAPTURE_MODE=1 时模拟中录制的 capture 分区)
+//   --trace    结束时把追踪事件按 Chrome trace JSON 写到文件 (需要 TRACE_ENABLED=1，即 native-sim-trace 环境)
+
+void setup();
+void loop();
+
+namespace {
+    void usage(const char* program) {
+        fprintf(stderr, "usage: %s [seconds] [--seed N] [--meal minute:peak]... [--connect] [--flash label=file]... "
+                "[--dump label=file]... [--trace file]\n", program);
+        exit(2);
+    }
+
+    FILE* traceFile = nullptr;
+
+    void writeTraceLine(const char* line) {
+        fputs(line, traceFile);
+        fputc('\n', traceFile);
+    }
+}
+
+int main(int argc, char** argv) {
+    SimBoard& board = SimBoard::getInstance();
+    SimPhysiology::Profile profile = SimPhysiology::defaultProfile();
+    uint64_t durationUs = 600ULL * 1000000ULL;
+    bool connect = false;
+    struct Meal { uint32_t minute; float peak; };
+    Meal meals[SimPhysiology::kMaxMeals];
+    int mealCount = 0;
+    std::vector<std::string> dumps;
+    const char* tracePath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--seed") == 0 && i + 1 < argc) {
+            profile.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(arg, "--meal") == 0 && i + 1 < argc) {
+            unsigned minute;
+            float peak;
+            if (mealCount >= SimPhysiology::kMaxMeals || sscanf(argv[++i], "%u:%f", &minute, &peak) != 2) {
+                usage(argv[0]);
+            }
+            meals[mealCount++] = Meal{ minute, peak };
+        } else if (strcmp(arg, "--connect") == 0) {
+            connect = true;
+        } else if (strcmp(arg, "--flash") == 0 && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t separator = spec.find('=');
+            if (separator == std::string::npos ||
+                !board.loadPartition(spec.substr(0, separator).c_str(), spec.c_str() + separator + 1)) {
+                fprintf(stderr, "cannot load partition image '%s'\n", spec.c_str());
+                return 1;
+            }
+        } else if (strcmp(arg, "--dump") == 0 && i + 1 < argc) {
+            dumps.push_back(argv[++i]);
+        } else if (strcmp(arg, "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+            if (!TRACE_ENABLED) {
+                fprintf(stderr, "--trace needs a build with TRACE_ENABLED=1 (env:native-sim-trace)\n");
+                return 1;
+            }
+        } else if (arg[0] != '-' && atof(arg) > 0) {
+            durationUs = (uint64_t)(atof(arg) * 1e6);
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    board.getPhysiology().reset(profile);
+    for (int i = 0; i < mealCount; i++) {
+        board.getPhysiology().addMeal(meals[i].minute * 60000, meals[i].peak);
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+    setup();
+    if (connect) {
+        SimBleTransport::getInstance().connect();
+    }
+    while (board.micros() < durationUs) {
+        loop();
+    }
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+    // 与计划内的重启相同，先写入缓存的数据 (读数历史、录制) 再保存分区
+    board.runShutdownHandlers();
+    for (const std::string& spec : dumps) {
+        size_t separator = spec.find('=');
+        if (separator == std::string::npos ||
+            !board.savePartition(spec.substr(0, separator).c_str(), spec.c_str() + separator + 1)) {
+            fprintf(stderr, "cannot save partition image '%s'\n", spec.c_str());
+            return 1;
+        }
+    }
+    if (tracePath != nullptr) {
+        traceFile = fopen(tracePath, "w");
+        if (traceFile == nullptr) {
+            fprintf(stderr, "cannot write trace '%s'\n", tracePath);
+            return 1;
+        }
+        TraceLog::getInstance().writeChromeJson(writeTraceLine);
+        fclose(traceFile);
+    }
+
+    SimBoard::Stats stats = board.getStats();
+    const SimBleTransport::Stats& ble = SimBleTransport::getInstance().getStats();
+    double virtualSeconds = board.micros() / 1e6;
+    printf("\n--- Simulation: %.1f s virtual in %.1f ms wall (%.0fx) ---\n", virtualSeconds, wallMs,
+           wallMs > 0 ? virtualSeconds * 1000.0 / wallMs : 0.0);
+    printf("ADC conversions %u, PPG samples %u, I2C transactions %u, DHT reads %u\n", (unsigned)stats.analogReads,
+           (unsigned)stats.ppgSamples, (unsigned)stats.i2cTransactions, (unsigned)stats.dhtReads);
+    printf("Flash sectors erased %u, bytes written %u, serial bytes %u, LED on %.1f%% of the time\n",
+           (unsigned)stats.flashErases, (unsigned)stats.flashBytesWritten, (unsigned)stats.serialBytes,
+           board.micros() > 0 ? 100.0 * stats.ledOnUs / board.micros() : 0.0);
+    printf("BLE notifications %u (%u bytes, %u oversized)\n", (unsigned)ble.notifications, (unsigned)ble.bytes,
+           (unsigned)ble.oversized);
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
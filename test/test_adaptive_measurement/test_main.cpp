@@ -0,0 +1,153 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <SequentialEstimator.h>
+
+// 自适应多次测量的主机仿真:
+//   pio test -e native -f test_adaptive_measurement -v
+// 以 -v 运行可看到不同噪声水平下的 能耗(子测量数) / 精度 对比表。
+
+namespace {
+    uint32_t rng_state = 1;
+
+    float uniform01() {
+        rng_state = rng_state * 1664525UL + 1013904223UL;
+        return ((rng_state >> 8) + 0.5f) / 16777216.0f;
+    }
+
+    float gaussian(float sigma) {
+        return sigma * sqrtf(-2.0f * logf(uniform01())) * cosf(6.2831853f * uniform01());
+    }
+
+    // 与 config.h 中的默认配置保持一致
+    constexpr uint32_t kSubMeasurementMs = 20;
+    const SequentialEstimator::Config kConfig = { 3.0f, 1500, 3, 48 };
+
+    struct SimResult {
+        float meanSubMeasurements;
+        float meanElapsedMs;
+        float rmsError;
+        float convergedRatio;
+    };
+
+    // 对给定噪声水平重复仿真多次测量，统计平均子测量数与误差
+    SimResult simulate(float noiseSigma, int trials) {
+        const float truth = 110.0f;
+        float subSum = 0.0f, timeSum = 0.0f, errSq = 0.0f;
+        int converged = 0;
+
+        for (int t = 0; t < trials; t++) {
+            SequentialEstimator estimator(kConfig);
+            uint32_t elapsed = 0;
+            SequentialEstimator::StopReason reason = SequentialEstimator::StopReason::NONE;
+            while (reason == SequentialEstimator::StopReason::NONE) {
+                estimator.add(truth + gaussian(noiseSigma));
+                elapsed += kSubMeasurementMs;
+                reason = estimator.shouldStop(elapsed);
+            }
+            subSum += estimator.getCount();
+            timeSum += elapsed;
+            errSq += (estimator.getMean() - truth) * (estimator.getMean() - truth);
+            if (reason == SequentialEstimator::StopReason::CONVERGED) converged++;
+        }
+
+        SimResult r = { subSum / trials, timeSum / trials, sqrtf(errSq / trials), (float)converged / trials };
+        return r;
+    }
+}
+
+void setUp(void) {
+    rng_state = 1;
+}
+
+void tearDown(void) {
+}
+
+void test_mean_and_variance_match_closed_form(void) {
+    SequentialEstimator estimator(kConfig);
+    const float values[] = { 2.0f, 4.0f, 4.0f, 4.0f, 5.0f, 5.0f, 7.0f, 9.0f };
+    for (float v : values) estimator.add(v);
+
+    TEST_ASSERT_EQUAL_UINT16(8, estimator.getCount());
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 5.0f, estimator.getMean());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 32.0f / 7.0f, estimator.getVariance());
+    // t(0.975, 7) = 2.365
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 2.365f * sqrtf(32.0f / 7.0f / 8.0f), estimator.getHalfWidth());
+}
+
+void test_does_not_stop_before_min_samples(void) {
+    SequentialEstimator estimator(kConfig);
+    estimator.add(100.0f);
+    estimator.add(100.0f);
+    // 两个相同的值半宽为0，但尚未达到最少子测量数
+    TEST_ASSERT_TRUE(estimator.shouldStop(40) == SequentialEstimator::StopReason::NONE);
+    estimator.add(100.0f);
+    TEST_ASSERT_TRUE(estimator.shouldStop(60) == SequentialEstimator::StopReason::CONVERGED);
+}
+
+void test_time_budget_and_sample_cap(void) {
+    SequentialEstimator estimator(kConfig);
+    TEST_ASSERT_TRUE(estimator.shouldStop(5000) == SequentialEstimator::StopReason::NONE); // 没有任何结果时不退出
+    estimator.add(80.0f);
+    estimator.add(140.0f);
+    TEST_ASSERT_TRUE(estimator.shouldStop(1500) == SequentialEstimator::StopReason::TIME_BUDGET);
+
+    SequentialEstimator::Config capped = { 0.001f, 100000, 3, 5 };
+    SequentialEstimator small(capped);
+    for (int i = 0; i < 5; i++) small.add((float)(i * 10));
+    TEST_ASSERT_TRUE(small.shouldStop(0) == SequentialEstimator::StopReason::MAX_SAMPLES);
+}
+
+/**
+ * @brief 信号干净时应显著少于固定预算的子测量数，嘈杂时自动延长。
+ */
+void test_clean_signal_stops_early_noisy_signal_extends(void) {
+    SimResult clean = simulate(2.0f, 200);
+    SimResult noisy = simulate(8.0f, 200);
+
+    TEST_ASSERT_TRUE(clean.meanSubMeasurements < 6.0f);
+    TEST_ASSERT_TRUE(noisy.meanSubMeasurements > 3.0f * clean.meanSubMeasurements);
+    TEST_ASSERT_TRUE(clean.convergedRatio > 0.95f);
+    // 两种情况下精度都应接近目标容差 (半宽3 mg/dL -> 标准误差约1.5)
+    TEST_ASSERT_TRUE(clean.rmsError < 3.0f);
+    TEST_ASSERT_TRUE(noisy.rmsError < 3.0f);
+}
+
+/**
+ * @brief 打印能耗/精度权衡表 (子测量数正比于LED、ADC与CPU的工作时间)。
+ */
+void test_report_energy_accuracy_tradeoff(void) {
+    const float sigmas[] = { 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 32.0f };
+    char line[128];
+    TEST_MESSAGE("noise_sd  subs   time_ms  rms_err  converged  (cap: 48 subs, 960 ms)");
+    for (float sigma : sigmas) {
+        SimResult r = simulate(sigma, 200);
+        snprintf(line, sizeof(line), "%8.1f  %5.1f  %7.0f  %7.2f  %8.0f%%",
+                 sigma, r.meanSubMeasurements, r.meanElapsedMs, r.rmsError, r.convergedRatio * 100.0f);
+        TEST_MESSAGE(line);
+        TEST_ASSERT_TRUE(r.meanSubMeasurements <= kConfig.maxSamples);
+    }
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_mean_and_variance_match_closed_form);
+    RUN_TEST(test_does_not_stop_before_min_samples);
+    RUN_TEST(test_time_budget_and_sample_cap);
+    RUN_TEST(test_clean_signal_stops_early_noisy_signal_extends);
+    RUN_TEST(test_report_energy_accuracy_tradeoff);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,108 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <BleEncoding.h>
+
+// BLE特征值二进制编码的测试 (IEEE-11073 SFLOAT 与测量包的编解码往返):
+//   pio test -e native -f test_ble_encoding
+
+using namespace BleEncoding;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_sfloat_known_values(void) {
+    // 98.6 = 986 × 10^-1 -> 指数 0xF，尾数 0x3DA
+    TEST_ASSERT_EQUAL_HEX16(0xF3DA, toSfloat(98.6f));
+    TEST_ASSERT_EQUAL_HEX16(0x0000, toSfloat(0.0f));
+    // -12.5 = -1250 × 10^-2
+    TEST_ASSERT_EQUAL_HEX16(0xEB1E, toSfloat(-12.5f));
+    TEST_ASSERT_EQUAL_FLOAT(98.6f, fromSfloat(0xF3DA));
+    TEST_ASSERT_EQUAL_FLOAT(-12.5f, fromSfloat(0xEB1E));
+    // 正指数: 72 × 10^2
+    TEST_ASSERT_EQUAL_FLOAT(7200.0f, fromSfloat(0x2048));
+}
+
+void test_sfloat_round_trip_keeps_precision(void) {
+    // 生理范围内的数值保留至少三位有效数字
+    const float values[] = { 0.05f, 1.0f, 54.3f, 97.0f, 120.25f, 399.9f, 1999.0f, -40.0f };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        float decoded = fromSfloat(toSfloat(values[i]));
+        TEST_ASSERT_FLOAT_WITHIN(fabsf(values[i]) * 1e-3f, values[i], decoded);
+    }
+    // 尾数放不下时降低精度: 12345 -> 1235 × 10^1
+    TEST_ASSERT_EQUAL_FLOAT(12350.0f, fromSfloat(toSfloat(12345.0f)));
+}
+
+void test_sfloat_special_values(void) {
+    TEST_ASSERT_EQUAL_HEX16(kSfloatNaN, toSfloat(NAN));
+    TEST_ASSERT_EQUAL_HEX16(kSfloatPositiveInfinity, toSfloat(1e12f));
+    TEST_ASSERT_EQUAL_HEX16(kSfloatNegativeInfinity, toSfloat(-1e12f));
+    TEST_ASSERT_TRUE(isnan(fromSfloat(kSfloatNaN)));
+    TEST_ASSERT_TRUE(isnan(fromSfloat(kSfloatNRes)));
+    TEST_ASSERT_TRUE(isnan(fromSfloat(kSfloatReserved)));
+    TEST_ASSERT_TRUE(isinf(fromSfloat(kSfloatPositiveInfinity)) && fromSfloat(kSfloatPositiveInfinity) > 0);
+    TEST_ASSERT_TRUE(isinf(fromSfloat(kSfloatNegativeInfinity)) && fromSfloat(kSfloatNegativeInfinity) < 0);
+}
+
+void test_measurement_round_trip(void) {
+    Measurement m = { 0xBEEF, 1700000123u, 104.5f };
+    uint8_t packet[kMeasurementPacketSize];
+    TEST_ASSERT_EQUAL_UINT32(kMeasurementPacketSize, encodeMeasurement(m, packet, sizeof(packet)));
+    TEST_ASSERT_EQUAL_UINT8(kMeasurementPacketVersion, packet[0]);
+    TEST_ASSERT_EQUAL_UINT8(0xEF, packet[2]);   // 小端序
+    TEST_ASSERT_EQUAL_UINT8(0xBE, packet[3]);
+
+    Measurement decoded;
+    TEST_ASSERT_TRUE(decodeMeasurement(packet, sizeof(packet), &decoded));
+    TEST_ASSERT_EQUAL_UINT16(m.sequence, decoded.sequence);
+    TEST_ASSERT_EQUAL_UINT32(m.timestamp, decoded.timestamp);
+    TEST_ASSERT_EQUAL_FLOAT(m.value, decoded.value);
+}
+
+void test_measurement_rejects_bad_input(void) {
+    Measurement m = { 1, 2, 3.0f };
+    uint8_t packet[kMeasurementPacketSize];
+    TEST_ASSERT_EQUAL_UINT32(0, encodeMeasurement(m, packet, sizeof(packet) - 1));
+
+    encodeMeasurement(m, packet, sizeof(packet));
+    Measurement decoded;
+    TEST_ASSERT_FALSE(decodeMeasurement(packet, sizeof(packet) - 1, &decoded));
+    packet[0] = kMeasurementPacketVersion + 1;
+    TEST_ASSERT_FALSE(decodeMeasurement(packet, sizeof(packet), &decoded));
+}
+
+void test_legacy_text_format(void) {
+    char text[10];
+    TEST_ASSERT_EQUAL_UINT32(5, formatText(98.6f, text, sizeof(text)));
+    TEST_ASSERT_EQUAL_STRING("98.60", text);
+    // 容量不足时不输出被截断的数值
+    TEST_ASSERT_EQUAL_UINT32(0, formatText(12345.0f, text, 6));
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sfloat_known_values);
+    RUN_TEST(test_sfloat_round_trip_keeps_precision);
+    RUN_TEST(test_sfloat_special_values);
+    RUN_TEST(test_measurement_round_trip);
+    RUN_TEST(test_measurement_rejects_bad_input);
+    RUN_TEST(test_legacy_text_format);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
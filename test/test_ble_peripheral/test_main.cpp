@@ -0,0 +1,330 @@
+#include <unity.h>
+#include <string.h>
+#include <BlePeripheral.h>
+#include <BleEncoding.h>
+
+// BLE协议层的测试: 用假的传输层代替 Bluedroid/NimBLE，检查连接事件、写入的分发与通知:
+//   pio test -e native -f test_ble_peripheral
+
+namespace {
+    // 假的传输层: 记录每个特征值的当前值与发出的通知
+    class FakeTransport : public BleTransport {
+    public:
+        Listener* listener = nullptr;
+        bool connected = false;
+        uint16_t preferredMtu = 0;
+        int advertisingStarts = 0;
+        uint8_t values[GattSink::kCharacteristicCount][512];
+        size_t valueLengths[GattSink::kCharacteristicCount];
+        int notifications[GattSink::kCharacteristicCount];
+        uint8_t lastSent[GattSink::kCharacteristicCount][128];
+        size_t lastSentLengths[GattSink::kCharacteristicCount];
+
+        FakeTransport() {
+            memset(valueLengths, 0, sizeof(valueLengths));
+            memset(notifications, 0, sizeof(notifications));
+            memset(lastSentLengths, 0, sizeof(lastSentLengths));
+        }
+
+        bool begin(const char*, uint16_t mtu, Listener* l) override {
+            listener = l;
+            preferredMtu = mtu;
+            return true;
+        }
+
+        bool isConnected() const override {
+            return connected;
+        }
+
+        void setValue(Characteristic c, const uint8_t* data, size_t length) override {
+            memcpy(values[(int)c], data, length);
+            valueLengths[(int)c] = length;
+        }
+
+        bool send(Characteristic c, const uint8_t* data, size_t length) override {
+            if (!connected) {
+                return false;
+            }
+            memcpy(lastSent[(int)c], data, length);
+            lastSentLengths[(int)c] = length;
+            notifications[(int)c]++;
+            return true;
+        }
+
+        void startAdvertising() override {
+            advertisingStarts++;
+        }
+
+        const char* name() const override {
+            return "Fake";
+        }
+
+        void connect(uint32_t intervalMs) {
+            connected = true;
+            listener->onConnect(intervalMs);
+        }
+
+        int sent(Characteristic c) const {
+            return notifications[(int)c];
+        }
+    };
+
+    FakeTransport* transport;
+    uint8_t lastUpdate[8];
+    size_t lastUpdateLength;
+
+    uint8_t updateHandler(const uint8_t* packet, size_t length) {
+        memcpy(lastUpdate, packet, length);
+        lastUpdateLength = length;
+        return 0x42;
+    }
+
+    BlePeripheral::Config config(bool composite) {
+        BlePeripheral::Config c;
+        c.compositeNotifications = composite;
+        c.textValues = false;
+        c.recordsPerPoll = 32;
+        c.maxCurvePoints = 12;
+        c.vitals.glucoseDeadband = 1.0f;
+        c.vitals.heartRateDeadband = 1.0f;
+        c.vitals.spO2Deadband = 0.5f;
+        c.vitals.curveDeadband = 2.0f;
+        c.vitals.minIntervalMs = 1000;
+        c.vitals.maxSilenceMs = 30000;
+        c.vitals.curveStepMinutes = 5;
+        c.ppgPeriodMs = 10;
+        c.waveformFramesPerPoll = 8;
+        return c;
+    }
+}
+
+void setUp(void) {
+    transport = new FakeTransport();
+    lastUpdateLength = 0;
+}
+
+void tearDown(void) {
+    delete transport;
+}
+
+void test_begin_sets_glucose_feature(void) {
+    BlePeripheral p(*transport, config(true));
+    TEST_ASSERT_TRUE(p.begin("test", 96));
+    TEST_ASSERT_EQUAL_UINT16(96, transport->preferredMtu);
+    TEST_ASSERT_EQUAL_UINT32(2, transport->valueLengths[(int)GattSink::Characteristic::FEATURE]);
+    TEST_ASSERT_FALSE(p.isConnected());
+}
+
+void test_separate_notifications_with_sequence(void) {
+    BlePeripheral p(*transport, config(false));
+    p.begin("test", 96);
+
+    // 未连接时不发送，序号不增加
+    TEST_ASSERT_TRUE(p.updateGlucose(100.0f, 10));
+    p.poll(0, 0);
+    TEST_ASSERT_EQUAL_INT(0, transport->sent(GattSink::Characteristic::GLUCOSE));
+
+    // update*() 只放入队列，由 poll() 发送
+    transport->connect(30);
+    p.updateGlucose(100.0f, 10);
+    p.updateGlucose(110.0f, 20);
+    TEST_ASSERT_EQUAL_INT(0, transport->sent(GattSink::Characteristic::GLUCOSE));
+    p.poll(0, 0);
+    TEST_ASSERT_EQUAL_INT(2, transport->sent(GattSink::Characteristic::GLUCOSE));
+    BleEncoding::Measurement m;
+    TEST_ASSERT_TRUE(BleEncoding::decodeMeasurement(transport->lastSent[(int)GattSink::Characteristic::GLUCOSE],
+                                                    transport->lastSentLengths[(int)GattSink::Characteristic::GLUCOSE], &m));
+    TEST_ASSERT_EQUAL_UINT16(1, m.sequence);
+    TEST_ASSERT_EQUAL_UINT32(20, m.timestamp);
+    TEST_ASSERT_EQUAL_FLOAT(110.0f, m.value);
+
+    // 没有合并通知时 poll() 不发送合并包
+    p.poll(1, 0);
+    TEST_ASSERT_EQUAL_INT(0, transport->sent(GattSink::Characteristic::VITALS));
+}
+
+void test_composite_mode_only_sets_values(void) {
+    BlePeripheral p(*transport, config(true));
+    p.begin("test", 96);
+    transport->connect(30);
+    transport->listener->onMtuChanged(96);
+
+    p.updateHeartRate(72.0f, 0);
+    p.updateSpO2(98.0f, 0);
+    float curve[12];
+    for (int i = 0; i < 12; i++) curve[i] = 100.0f + i;
+    p.updatePredictionCurve(curve, 12, nullptr, nullptr);
+
+    // 一次 poll() 只更新各数值特征值，发出一个包含全部字段的合并通知
+    // (MTU 交换的结果在连接事件之后处理，仍然有效)
+    p.poll(0, 0);
+    TEST_ASSERT_EQUAL_INT(0, transport->sent(GattSink::Characteristic::HEART_RATE));
+    TEST_ASSERT_EQUAL_INT(0, transport->sent(GattSink::Characteristic::PREDICTION));
+    TEST_ASSERT_EQUAL_UINT32(BleEncoding::kMeasurementPacketSize,
+                             transport->valueLengths[(int)GattSink::Characteristic::HEART_RATE]);
+    TEST_ASSERT_EQUAL_INT(1, transport->sent(GattSink::Characteristic::VITALS));
+    VitalsPublisher::Decoded d;
+    TEST_ASSERT_TRUE(VitalsPublisher::decode(transport->lastSent[(int)GattSink::Characteristic::VITALS],
+                                             transport->lastSentLengths[(int)GattSink::Characteristic::VITALS], &d));
+    TEST_ASSERT_EQUAL_HEX8(VitalsPublisher::FIELD_HEART_RATE | VitalsPublisher::FIELD_SPO2 | VitalsPublisher::FIELD_CURVE, d.fields);
+    TEST_ASSERT_EQUAL_INT(12, d.curveCount);
+}
+
+void test_reconnect_sends_full_snapshot(void) {
+    BlePeripheral p(*transport, config(true));
+    p.begin("test", 96);
+    transport->connect(30);
+    p.updateGlucose(100.0f, 0);
+    p.poll(0, 0);
+    p.poll(5000, 0);    // 没有变化: 不发送
+    TEST_ASSERT_EQUAL_INT(1, transport->sent(GattSink::Characteristic::VITALS));
+
+    transport->connected = false;
+    transport->listener->onDisconnect();
+    TEST_ASSERT_EQUAL_INT(0, transport->advertisingStarts);
+    transport->connect(30);
+    p.poll(5100, 0);
+    TEST_ASSERT_EQUAL_INT(2, transport->sent(GattSink::Characteristic::VITALS));
+    // 广播由 poll() 在处理断开事件时重新开始
+    TEST_ASSERT_EQUAL_INT(1, transport->advertisingStarts);
+}
+
+void test_writes_are_dispatched(void) {
+    BlePeripheral p(*transport, config(true));
+    p.setUpdateHandler(updateHandler);
+    p.begin("test", 96);
+    transport->connect(30);
+
+    // 模型更新: 在协议栈的任务中交给处理函数，状态由 poll() 通知
+    uint8_t packet[3] = { 0x02, 0xAA, 0xBB };
+    transport->listener->onWrite(GattSink::Characteristic::MODEL_UPDATE, packet, sizeof(packet));
+    TEST_ASSERT_EQUAL_UINT32(3, lastUpdateLength);
+    TEST_ASSERT_EQUAL_INT(0, transport->sent(GattSink::Characteristic::MODEL_UPDATE));
+    p.poll(0, 0);
+    TEST_ASSERT_EQUAL_INT(1, transport->sent(GattSink::Characteristic::MODEL_UPDATE));
+    TEST_ASSERT_EQUAL_HEX8(0x42, transport->lastSent[(int)GattSink::Characteristic::MODEL_UPDATE][0]);
+
+    // RACP: 在 poll() 中处理，记录与响应都经过传输层
+    for (int i = 0; i < 3; i++) {
+        p.addGlucoseRecord(1700000000 + i * 60, 100.0f + i);
+    }
+    uint8_t racp[2] = { GlucoseService::OP_REPORT_RECORDS, GlucoseService::OPERATOR_ALL };
+    transport->listener->onWrite(GattSink::Characteristic::RACP, racp, sizeof(racp));
+    TEST_ASSERT_EQUAL_INT(0, transport->sent(GattSink::Characteristic::MEASUREMENT));
+    p.poll(0, 0);
+    p.poll(1, 0);
+    TEST_ASSERT_EQUAL_INT(3, transport->sent(GattSink::Characteristic::MEASUREMENT));
+    TEST_ASSERT_EQUAL_INT(1, transport->sent(GattSink::Characteristic::RACP));
+}
+
+void test_waveform_stream_opt_in(void) {
+    BlePeripheral p(*transport, config(true));
+    p.begin("test", 96);
+    transport->connect(30);
+
+    // 未开启时不采集
+    p.addPpgSample(120000, 95000, 0);
+    p.poll(0, 0);
+    TEST_ASSERT_EQUAL_INT(0, transport->sent(GattSink::Characteristic::WAVEFORM));
+
+    transport->listener->onMtuChanged(96);
+    uint8_t enable = BlePeripheral::WAVEFORM_PPG;
+    transport->listener->onWrite(GattSink::Characteristic::WAVEFORM, &enable, 1);
+    TEST_ASSERT_FALSE(p.isWaveformStreaming());
+    p.poll(50, 0);
+    TEST_ASSERT_TRUE(p.isWaveformStreaming());
+    for (int i = 0; i < 10; i++) {
+        p.addPpgSample(120000 + i, 95000 - i, i * 10);
+        p.addOpticalSample(2048, i * 10);     // 光信号流未开启
+    }
+    p.poll(100, 0);
+    TEST_ASSERT_EQUAL_INT(1, transport->sent(GattSink::Characteristic::WAVEFORM));
+    TEST_ASSERT_EQUAL_UINT32(10, p.getPpgStreamer().getStats().samples);
+    TEST_ASSERT_EQUAL_UINT32(0, p.getOpticalStreamer().getStats().samples);
+
+    // 断开连接后关闭
+    transport->connected = false;
+    transport->listener->onDisconnect();
+    p.poll(200, 0);
+    TEST_ASSERT_FALSE(p.isWaveformStreaming());
+}
+
+void test_rollup_query_selects_page(void) {
+    BlePeripheral p(*transport, config(true));
+    p.begin("test", 96);
+    const int rollup = (int)GattSink::Characteristic::ROLLUP;
+    // 初始为1分钟层的最新一页 (空)
+    TEST_ASSERT_EQUAL_UINT32(RollupEngine::kPageHeaderSize, transport->valueLengths[rollup]);
+
+    // 读数在 poll() 中加入各层，页随之更新: 2小时的2秒读数
+    const uint32_t start = 1700000000 - 1700000000 % 3600;
+    for (int i = 0; i < 3600; i++) {
+        p.addReading(start + i * 2, 100.0f + (i % 10));
+        if (i % 8 == 7) {
+            p.poll(i, 0);
+        }
+    }
+    p.poll(4000, 0);
+    TEST_ASSERT_EQUAL_UINT8(RollupEngine::MINUTE, transport->values[rollup][0]);
+    TEST_ASSERT_EQUAL_UINT8(RollupEngine::kMaxPageEntries, transport->values[rollup][1]);
+    TEST_ASSERT_EQUAL_UINT32(RollupEngine::kMaxPageSize, transport->valueLengths[rollup]);
+
+    // 写入 [tier] 选择1小时层的最新一页
+    uint8_t hour = RollupEngine::HOUR;
+    transport->connect(30);
+    transport->listener->onWrite(GattSink::Characteristic::ROLLUP, &hour, 1);
+    p.poll(4100, 0);
+    const uint8_t* page = transport->values[rollup];
+    TEST_ASSERT_EQUAL_UINT8(RollupEngine::HOUR, page[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, page[1]);
+    TEST_ASSERT_EQUAL_UINT16(3600, page[2] | (page[3] << 8));
+    TEST_ASSERT_EQUAL_UINT32(start, page[4] | (page[5] << 8) | (page[6] << 16) | ((uint32_t)page[7] << 24));
+    TEST_ASSERT_EQUAL_UINT16(1800, page[8] | (page[9] << 8));
+    TEST_ASSERT_EQUAL_UINT16(1000, page[10] | (page[11] << 8));     // min 100.0
+    TEST_ASSERT_EQUAL_UINT16(1090, page[12] | (page[13] << 8));     // max 109.0
+    TEST_ASSERT_EQUAL_UINT16(1045, page[14] | (page[15] << 8));     // mean 104.5
+
+    // 写入 [tier][from] 选择从 from 开始的一页
+    uint32_t from = start + 100 * 60;
+    uint8_t query[5] = { RollupEngine::MINUTE, (uint8_t)from, (uint8_t)(from >> 8), (uint8_t)(from >> 16), (uint8_t)(from >> 24) };
+    transport->listener->onWrite(GattSink::Characteristic::ROLLUP, query, sizeof(query));
+    p.poll(4200, 0);
+    TEST_ASSERT_EQUAL_UINT8(20, page[1]);
+    TEST_ASSERT_EQUAL_UINT32(from, page[4] | (page[5] << 8) | (page[6] << 16) | ((uint32_t)page[7] << 24));
+
+    // 无效的层级被忽略；断开后回到默认的查询
+    uint8_t bad = RollupEngine::kTierCount;
+    transport->listener->onWrite(GattSink::Characteristic::ROLLUP, &bad, 1);
+    p.poll(4300, 0);
+    TEST_ASSERT_EQUAL_UINT8(RollupEngine::MINUTE, page[0]);
+    TEST_ASSERT_EQUAL_UINT8(20, page[1]);
+    transport->connected = false;
+    transport->listener->onDisconnect();
+    p.poll(4400, 0);
+    TEST_ASSERT_EQUAL_UINT8(RollupEngine::kMaxPageEntries, page[1]);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_sets_glucose_feature);
+    RUN_TEST(test_separate_notifications_with_sequence);
+    RUN_TEST(test_composite_mode_only_sets_values);
+    RUN_TEST(test_reconnect_sends_full_snapshot);
+    RUN_TEST(test_writes_are_dispatched);
+    RUN_TEST(test_waveform_stream_opt_in);
+    RUN_TEST(test_rollup_query_selects_page);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
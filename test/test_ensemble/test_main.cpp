@@ -0,0 +1,234 @@
+#include <unity.h>
+#include <math.h>
+#include <Ensemble.h>
+
+// 集成模型预测区间的测试 (假模型: 合并为均值与区间、区间较窄时跳过其余成员):
+//   pio test -e native -f test_ensemble
+
+namespace {
+    // 假模型: 第m个成员预测 最新读数 + bias[m] + 每步 slope
+    struct DummyModels {
+        float bias[Ensemble::kMaxMembers];
+        int steps[Ensemble::kMaxMembers];
+        bool fail[Ensemble::kMaxMembers];
+        int calls[Ensemble::kMaxMembers];
+        float slope;
+    };
+
+    DummyModels models;
+
+    bool runDummy(void* context, int member, const float* input, float* output, int* outputSize) {
+        DummyModels* d = (DummyModels*)context;
+        d->calls[member]++;
+        if (d->fail[member]) {
+            return false;
+        }
+        for (int i = 0; i < d->steps[member]; i++) {
+            output[i] = input[9] + d->bias[member] + d->slope * (i + 1);
+        }
+        *outputSize = d->steps[member];
+        return true;
+    }
+
+    Ensemble::Config config() {
+        Ensemble::Config c;
+        c.tightWidth = 10.0f;
+        c.maxConsecutiveSkips = 3;
+        return c;
+    }
+
+    // 输入窗口: 最新读数为 value
+    void window(float value, float* out) {
+        for (int i = 0; i < 10; i++) out[i] = value;
+    }
+
+    int totalCalls() {
+        int n = 0;
+        for (int m = 0; m < Ensemble::kMaxMembers; m++) n += models.calls[m];
+        return n;
+    }
+}
+
+void setUp(void) {
+    for (int m = 0; m < Ensemble::kMaxMembers; m++) {
+        models.bias[m] = 0.0f;
+        models.steps[m] = 3;
+        models.fail[m] = false;
+        models.calls[m] = 0;
+    }
+    models.slope = -2.0f;
+}
+
+void tearDown(void) {
+}
+
+void test_aggregate_mean_and_interval(void) {
+    const float outputs[4][Ensemble::kMaxSteps] = { { 100, 90 }, { 102, 94 }, { 98, 86 }, { 100, 90 } };
+    Ensemble::Result r;
+    Ensemble::aggregate(outputs, 4, 2, &r);
+    TEST_ASSERT_EQUAL_INT(2, r.steps);
+    TEST_ASSERT_EQUAL_INT(4, r.members);
+    TEST_ASSERT_TRUE(r.hasInterval);
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, r.mean[0]);
+    TEST_ASSERT_EQUAL_FLOAT(90.0f, r.mean[1]);
+    // 样本标准差 sqrt(8/3) 与 sqrt(32/3)，自由度3的t分位数3.182，新成员预测的方差放大 (1 + 1/4)
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 100.0f - 3.182f * sqrtf(8.0f / 3.0f * 1.25f), r.lower[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 90.0f + 3.182f * sqrtf(32.0f / 3.0f * 1.25f), r.upper[1]);
+
+    // 单个成员没有区间
+    Ensemble::aggregate(outputs, 1, 2, &r);
+    TEST_ASSERT_FALSE(r.hasInterval);
+    TEST_ASSERT_EQUAL_FLOAT(r.mean[0], r.lower[0]);
+    TEST_ASSERT_EQUAL_FLOAT(r.mean[0], r.upper[0]);
+}
+
+void test_run_all_members_through_shared_input(void) {
+    models.bias[0] = 0.0f; models.bias[1] = 20.0f; models.bias[2] = -20.0f;
+    Ensemble e(config());
+    e.setMembers(3, runDummy, &models);
+
+    float input[10];
+    window(120.0f, input);
+    Ensemble::Result r;
+    TEST_ASSERT_TRUE(e.run(input, &r));
+    TEST_ASSERT_FALSE(r.skipped);
+    TEST_ASSERT_EQUAL_INT(3, r.members);
+    TEST_ASSERT_EQUAL_INT(3, r.steps);
+    TEST_ASSERT_EQUAL_FLOAT(118.0f, r.mean[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 4.303f * 20.0f * sqrtf(4.0f / 3.0f), r.upper[0] - r.mean[0]);
+    TEST_ASSERT_EQUAL_INT(1, models.calls[0]);
+    TEST_ASSERT_EQUAL_INT(1, models.calls[2]);
+
+    // 区间较宽时不跳过
+    TEST_ASSERT_TRUE(e.run(input, &r));
+    TEST_ASSERT_FALSE(r.skipped);
+    TEST_ASSERT_EQUAL_INT(6, totalCalls());
+}
+
+void test_tight_interval_skips_other_members(void) {
+    models.bias[1] = 1.0f; models.bias[2] = -1.0f; models.bias[3] = 2.0f;
+    Ensemble e(config());
+    e.setMembers(4, runDummy, &models);
+
+    float input[10];
+    window(100.0f, input);
+    Ensemble::Result full;
+    TEST_ASSERT_TRUE(e.run(input, &full));
+    TEST_ASSERT_FALSE(full.skipped);
+    TEST_ASSERT_EQUAL_INT(4, totalCalls());
+
+    // 输入小幅变化: 只运行主成员，区间平移
+    window(103.0f, input);
+    Ensemble::Result r;
+    TEST_ASSERT_TRUE(e.run(input, &r));
+    TEST_ASSERT_TRUE(r.skipped);
+    TEST_ASSERT_EQUAL_INT(1, r.members);
+    TEST_ASSERT_TRUE(r.hasInterval);
+    TEST_ASSERT_EQUAL_INT(5, totalCalls());
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, full.mean[i] + 3.0f, r.mean[i]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f, full.upper[i] - full.lower[i], r.upper[i] - r.lower[i]);
+    }
+
+    // 连续跳过达到上限 (3次) 后强制完整运行
+    TEST_ASSERT_TRUE(e.run(input, &r));
+    TEST_ASSERT_TRUE(e.run(input, &r));
+    TEST_ASSERT_TRUE(r.skipped);
+    TEST_ASSERT_TRUE(e.run(input, &r));
+    TEST_ASSERT_FALSE(r.skipped);
+    TEST_ASSERT_EQUAL_UINT32(2, e.getFullRuns());
+    TEST_ASSERT_EQUAL_UINT32(3, e.getSkippedRuns());
+}
+
+void test_large_change_forces_full_run(void) {
+    models.bias[1] = 1.0f; models.bias[2] = -1.0f;
+    Ensemble e(config());
+    e.setMembers(3, runDummy, &models);
+
+    float input[10];
+    window(100.0f, input);
+    Ensemble::Result r;
+    TEST_ASSERT_TRUE(e.run(input, &r));
+
+    // 血糖快速下降 (例如低血糖前)，主成员的预测变化超过 tightWidth
+    window(85.0f, input);
+    TEST_ASSERT_TRUE(e.run(input, &r));
+    TEST_ASSERT_FALSE(r.skipped);
+    TEST_ASSERT_EQUAL_INT(2, models.calls[1]);
+
+    // reset() 之后也不跳过
+    e.reset();
+    TEST_ASSERT_TRUE(e.run(input, &r));
+    TEST_ASSERT_FALSE(r.skipped);
+}
+
+void test_failed_members_and_mismatched_steps(void) {
+    models.bias[1] = 4.0f; models.bias[2] = -4.0f;
+    models.fail[2] = true;
+    models.steps[1] = 2;
+    Ensemble e(config());
+    e.setMembers(3, runDummy, &models);
+
+    float input[10];
+    window(100.0f, input);
+    Ensemble::Result r;
+    TEST_ASSERT_TRUE(e.run(input, &r));
+    TEST_ASSERT_EQUAL_INT(2, r.members);
+    TEST_ASSERT_EQUAL_INT(2, r.steps);
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, r.mean[0]);
+
+    // 主成员失败时没有结果
+    models.fail[0] = true;
+    TEST_ASSERT_FALSE(e.run(input, &r));
+}
+
+void test_single_surviving_member_has_no_interval(void) {
+    models.fail[1] = true;
+    models.fail[2] = true;
+    Ensemble e(config());
+    e.setMembers(3, runDummy, &models);
+
+    // 其余成员全部失败: 只有主成员的预测，没有区间
+    float input[10];
+    window(100.0f, input);
+    Ensemble::Result r;
+    TEST_ASSERT_TRUE(e.run(input, &r));
+    TEST_ASSERT_EQUAL_INT(1, r.members);
+    TEST_ASSERT_FALSE(r.skipped);
+    TEST_ASSERT_FALSE(r.hasInterval);
+    TEST_ASSERT_EQUAL_FLOAT(98.0f, r.mean[0]);
+
+    // 宽度为0的结果不能作为跳过的依据: 成员恢复后仍然完整运行
+    models.fail[1] = false;
+    models.fail[2] = false;
+    models.bias[1] = 1.0f; models.bias[2] = -1.0f;
+    TEST_ASSERT_TRUE(e.run(input, &r));
+    TEST_ASSERT_FALSE(r.skipped);
+    TEST_ASSERT_EQUAL_INT(3, r.members);
+    TEST_ASSERT_TRUE(r.hasInterval);
+    TEST_ASSERT_EQUAL_INT(2, models.calls[1]);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_aggregate_mean_and_interval);
+    RUN_TEST(test_run_all_members_through_shared_input);
+    RUN_TEST(test_tight_interval_skips_other_members);
+    RUN_TEST(test_large_change_forces_full_run);
+    RUN_TEST(test_failed_members_and_mismatched_steps);
+    RUN_TEST(test_single_surviving_member_has_no_interval);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,177 @@
+#include <unity.h>
+#include <math.h>
+#include <GlucoseFilter.h>
+
+// 本测试不依赖硬件，可在 native 环境 (主机) 与开发板上运行:
+//   pio test -e native -f test_glucose_filter
+
+namespace {
+    // 确定性的伪随机高斯噪声 (LCG + Box-Muller)，保证每次运行结果一致
+    uint32_t rng_state = 12345;
+
+    float uniform01() {
+        rng_state = rng_state * 1664525UL + 1013904223UL;
+        return ((rng_state >> 8) + 0.5f) / 16777216.0f;
+    }
+
+    float gaussian(float sigma) {
+        float u1 = uniform01();
+        float u2 = uniform01();
+        return sigma * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+    }
+
+    constexpr uint32_t kStepMs = 2000; // 与主循环的测量间隔一致
+}
+
+void setUp(void) {
+    rng_state = 12345;
+}
+
+void tearDown(void) {
+}
+
+/**
+ * @brief 恒定血糖 + 高斯噪声: 平滑后的误差应明显小于原始测量误差。
+ */
+void test_constant_glucose_noise_is_reduced(void) {
+    GlucoseFilter filter(0.5f, 8.0f);
+    float rawSq = 0.0f, smoothSq = 0.0f;
+    int counted = 0;
+
+    for (int i = 0; i < 300; i++) {
+        float raw = 100.0f + gaussian(8.0f);
+        filter.update(raw, i * kStepMs, 1.0f);
+        if (i >= 30) { // 跳过收敛阶段
+            rawSq += (raw - 100.0f) * (raw - 100.0f);
+            smoothSq += (filter.getGlucose() - 100.0f) * (filter.getGlucose() - 100.0f);
+            counted++;
+        }
+    }
+
+    float rawRms = sqrtf(rawSq / counted);
+    float smoothRms = sqrtf(smoothSq / counted);
+    TEST_ASSERT_TRUE(smoothRms < 0.5f * rawRms);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 0.0f, filter.getVelocity());
+}
+
+/**
+ * @brief 线性上升的血糖曲线: 变化率估计应收敛到真实斜率。
+ */
+void test_ramp_velocity_is_tracked(void) {
+    GlucoseFilter filter(0.5f, 8.0f);
+    const float slope = 2.0f; // mg/dL/min
+
+    for (int i = 0; i < 600; i++) {
+        float minutes = i * kStepMs / 60000.0f;
+        float truth = 90.0f + slope * minutes;
+        filter.update(truth + gaussian(5.0f), i * kStepMs, 1.0f);
+    }
+
+    float finalTruth = 90.0f + slope * (599 * kStepMs / 60000.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, slope, filter.getVelocity());
+    TEST_ASSERT_FLOAT_WITHIN(5.0f, finalTruth, filter.getGlucose());
+}
+
+/**
+ * @brief 置信区间应随读数积累而收窄，并覆盖真实值。
+ */
+void test_confidence_interval_shrinks_and_covers_truth(void) {
+    GlucoseFilter filter(0.5f, 8.0f);
+    filter.update(100.0f + gaussian(8.0f), 0, 1.0f);
+    float initialWidth = filter.getConfidenceHalfWidth();
+
+    int covered = 0;
+    for (int i = 1; i < 200; i++) {
+        filter.update(100.0f + gaussian(8.0f), i * kStepMs, 1.0f);
+        if (fabsf(filter.getGlucose() - 100.0f) <= filter.getConfidenceHalfWidth()) {
+            covered++;
+        }
+    }
+
+    TEST_ASSERT_TRUE(filter.getConfidenceHalfWidth() < 0.5f * initialWidth);
+    TEST_ASSERT_TRUE(covered > 180); // 约95%的覆盖率
+}
+
+/**
+ * @brief 低质量读数对估计的影响应小于高质量读数。
+ */
+void test_low_quality_measurement_has_less_weight(void) {
+    GlucoseFilter good(0.5f, 8.0f);
+    GlucoseFilter poor(0.5f, 8.0f);
+    for (int i = 0; i < 50; i++) {
+        good.update(100.0f, i * kStepMs, 1.0f);
+        poor.update(100.0f, i * kStepMs, 1.0f);
+    }
+
+    // 同样的离群值，一个以高质量输入，一个以低质量输入
+    good.update(160.0f, 50 * kStepMs, 1.0f);
+    poor.update(160.0f, 50 * kStepMs, 0.2f);
+
+    TEST_ASSERT_TRUE(poor.getGlucose() - 100.0f < 0.5f * (good.getGlucose() - 100.0f));
+}
+
+/**
+ * @brief 子测量均值的标准误差叠加在按质量缩放的模型噪声上: 一组读数很集中时也不低于单次读数的噪声，
+ *        质量差时更宽。
+ */
+void test_standard_error_adds_to_quality_scaled_noise(void) {
+    GlucoseFilter tight(0.5f, 8.0f);
+    tight.update(100.0f, 0, 1.0f, 0.1f);
+    TEST_ASSERT_TRUE(tight.getConfidenceHalfWidth() >= 1.96f * 8.0f);
+
+    GlucoseFilter scattered(0.5f, 8.0f);
+    scattered.update(100.0f, 0, 1.0f, 6.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.96f * 10.0f, scattered.getConfidenceHalfWidth());
+
+    GlucoseFilter poor(0.5f, 8.0f);
+    poor.update(100.0f, 0, 0.5f, 0.1f);
+    TEST_ASSERT_TRUE(poor.getConfidenceHalfWidth() >= 1.96f * 16.0f);
+
+    // 持续输入集中的读数，置信区间收窄的速度与单次读数相同，不会塌缩到抽样误差
+    GlucoseFilter single(0.5f, 8.0f);
+    single.update(100.0f, 0, 1.0f);
+    for (int i = 1; i < 30; i++) {
+        tight.update(100.0f, i * kStepMs, 1.0f, 0.1f);
+        single.update(100.0f, i * kStepMs, 1.0f);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, single.getConfidenceHalfWidth(), tight.getConfidenceHalfWidth());
+}
+
+/**
+ * @brief 间隔过长时滤波器应重新初始化，而不是沿用旧的趋势外推。
+ */
+void test_long_gap_reinitializes(void) {
+    GlucoseFilter filter(0.5f, 8.0f, 60000);
+    for (int i = 0; i < 30; i++) {
+        filter.update(100.0f + i, i * kStepMs, 1.0f);
+    }
+    filter.update(150.0f, 29 * kStepMs + 120000, 1.0f);
+
+    TEST_ASSERT_EQUAL_UINT32(1, filter.getUpdateCount());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 150.0f, filter.getGlucose());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, filter.getVelocity());
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_constant_glucose_noise_is_reduced);
+    RUN_TEST(test_ramp_velocity_is_tracked);
+    RUN_TEST(test_confidence_interval_shrinks_and_covers_truth);
+    RUN_TEST(test_low_quality_measurement_has_less_weight);
+    RUN_TEST(test_standard_error_adds_to_quality_scaled_noise);
+    RUN_TEST(test_long_gap_reinitializes);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
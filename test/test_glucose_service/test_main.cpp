@@ -0,0 +1,361 @@
+#include <unity.h>
+#include <string.h>
+#include <math.h>
+#include <GlucoseService.h>
+#include <GlucoseRecordStore.h>
+#include <BleEncoding.h>
+
+// 标准血糖服务 (GLS) 的测试: 记录存储、测量编码、RACP 请求解析与带流控的记录上报。
+// 用假的GATT层记录发出的通知/指示:
+//   pio test -e native -f test_glucose_service
+
+namespace {
+    struct Packet {
+        GattSink::Characteristic characteristic;
+        uint8_t data[20];
+        size_t length;
+    };
+
+    // 假的GATT层: 记录发出的包；budget 为还能发送的包数 (<0 表示不限)，用完后模拟发送缓冲区已满
+    class FakeGatt : public GattSink {
+    public:
+        Packet packets[2048];
+        int count = 0;
+        int budget = -1;
+
+        bool send(Characteristic characteristic, const uint8_t* data, size_t length) override {
+            if (budget == 0) {
+                return false;
+            }
+            if (budget > 0) budget--;
+            Packet& p = packets[count++];
+            p.characteristic = characteristic;
+            memcpy(p.data, data, length);
+            p.length = length;
+            return true;
+        }
+
+        int countOf(Characteristic c) const {
+            int n = 0;
+            for (int i = 0; i < count; i++) if (packets[i].characteristic == c) n++;
+            return n;
+        }
+
+        const Packet* last(Characteristic c) const {
+            for (int i = count - 1; i >= 0; i--) if (packets[i].characteristic == c) return &packets[i];
+            return nullptr;
+        }
+
+        // 第 n 条测量的序号
+        uint16_t measurementSequence(int n) const {
+            for (int i = 0; i < count; i++) {
+                if (packets[i].characteristic == Characteristic::MEASUREMENT && n-- == 0) {
+                    return (uint16_t)(packets[i].data[1] | (packets[i].data[2] << 8));
+                }
+            }
+            return 0xFFFF;
+        }
+    };
+
+    // 内存中的键值存储 (一个键)，统计写入次数
+    class MemoryStore : public KeyValueStore {
+    public:
+        uint8_t data[8];
+        size_t length = 0;
+        int writes = 0;
+
+        size_t getBytes(const char*, void* out, size_t capacity) override {
+            if (length == 0 || length > capacity) return 0;
+            memcpy(out, data, length);
+            return length;
+        }
+        bool putBytes(const char*, const void* src, size_t len) override {
+            if (len > sizeof(data)) return false;
+            memcpy(data, src, len);
+            length = len;
+            writes++;
+            return true;
+        }
+        bool remove(const char*) override {
+            length = 0;
+            return true;
+        }
+    };
+
+    GlucoseRecordStore store;
+    FakeGatt gatt;
+
+    void addRecords(int n) {
+        for (int i = 0; i < n; i++) {
+            store.add(1700000000u + 60u * i, 100.0f + i);
+        }
+    }
+
+    void write(std::initializer_list<uint8_t> request, GlucoseService& service) {
+        uint8_t data[32];
+        size_t n = 0;
+        for (uint8_t b : request) data[n++] = b;
+        service.handleRacpWrite(data, n);
+    }
+
+    void pollUntilIdle(GlucoseService& service) {
+        for (int i = 0; i < 1000; i++) {
+            service.poll();
+        }
+    }
+
+    void assertResponse(uint8_t requestOpCode, uint8_t code) {
+        const Packet* p = gatt.last(GattSink::Characteristic::RACP);
+        TEST_ASSERT_NOT_NULL(p);
+        TEST_ASSERT_EQUAL_UINT32(4, p->length);
+        TEST_ASSERT_EQUAL_UINT8(GlucoseService::OP_RESPONSE_CODE, p->data[0]);
+        TEST_ASSERT_EQUAL_UINT8(requestOpCode, p->data[2]);
+        TEST_ASSERT_EQUAL_UINT8(code, p->data[3]);
+    }
+}
+
+void setUp(void) {
+    store = GlucoseRecordStore();
+    gatt.count = 0;
+    gatt.budget = -1;
+}
+
+void tearDown(void) {
+}
+
+void test_record_store_overwrites_oldest(void) {
+    addRecords(GlucoseRecordStore::kCapacity + 10);
+    TEST_ASSERT_EQUAL_INT(GlucoseRecordStore::kCapacity, store.count());
+    TEST_ASSERT_EQUAL_UINT16(10, store.at(0).sequence);
+    TEST_ASSERT_EQUAL_INT(0, store.lowerBound(3));
+    TEST_ASSERT_EQUAL_INT(5, store.lowerBound(15));
+    TEST_ASSERT_EQUAL_INT(store.count(), store.lowerBound(60000));
+
+    // 清空后序号继续递增
+    store.clear();
+    TEST_ASSERT_EQUAL_UINT16(GlucoseRecordStore::kCapacity + 10, store.add(0, 90.0f));
+}
+
+void test_record_sequence_continues_after_restart(void) {
+    MemoryStore nvs;
+    store.restoreSequence(nvs, "next");
+    addRecords(40);
+    // 每 kSequenceReserve 条记录写一次
+    TEST_ASSERT_EQUAL_INT(2, nvs.writes);
+    TEST_ASSERT_EQUAL_UINT16(40, store.nextSequence());
+
+    // 重启 (RAM中的记录丢失): 从预留块的末尾继续，序号不重复
+    GlucoseRecordStore rebooted;
+    rebooted.restoreSequence(nvs, "next");
+    TEST_ASSERT_EQUAL_INT(0, rebooted.count());
+    uint16_t first = rebooted.add(1700003000u, 95.0f);
+    TEST_ASSERT_EQUAL_UINT16(2 * GlucoseRecordStore::kSequenceReserve, first);
+    TEST_ASSERT_EQUAL_INT(3, nvs.writes);
+
+    // 掉电发生在预留之后、用完之前: 仍然跳过已经预留的序号
+    GlucoseRecordStore again;
+    again.restoreSequence(nvs, "next");
+    TEST_ASSERT_EQUAL_UINT16(3 * GlucoseRecordStore::kSequenceReserve, again.add(1700003060u, 96.0f));
+
+    // 没有保存的序号时从0开始
+    MemoryStore empty;
+    GlucoseRecordStore fresh;
+    fresh.restoreSequence(empty, "next");
+    TEST_ASSERT_EQUAL_UINT16(0, fresh.add(1700000000u, 90.0f));
+}
+
+void test_measurement_encoding(void) {
+    GlucoseRecordStore::Record r = { 0x0102, 1700000000u, 123.4f };   // 2023-11-14 22:13:20 UTC
+    uint8_t m[GlucoseService::kMeasurementSize];
+    TEST_ASSERT_EQUAL_UINT32(GlucoseService::kMeasurementSize, GlucoseService::encodeMeasurement(r, m, sizeof(m)));
+    TEST_ASSERT_EQUAL_HEX8(0x12, m[0]);                 // 浓度存在 (kg/L) + 随后有 Context
+    TEST_ASSERT_EQUAL_HEX8(0x02, m[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, m[2]);
+    TEST_ASSERT_EQUAL_UINT16(2023, m[3] | (m[4] << 8));
+    TEST_ASSERT_EQUAL_UINT8(11, m[5]);
+    TEST_ASSERT_EQUAL_UINT8(14, m[6]);
+    TEST_ASSERT_EQUAL_UINT8(22, m[7]);
+    TEST_ASSERT_EQUAL_UINT8(13, m[8]);
+    TEST_ASSERT_EQUAL_UINT8(20, m[9]);
+    // 123.4 mg/dL = 0.001234 kg/L
+    TEST_ASSERT_FLOAT_WITHIN(1e-7f, 0.001234f, BleEncoding::readSfloat(m + 10));
+    TEST_ASSERT_EQUAL_HEX8(0x17, m[12]);                // 手指，未确定的全血
+
+    uint8_t c[GlucoseService::kContextSize];
+    TEST_ASSERT_EQUAL_UINT32(GlucoseService::kContextSize, GlucoseService::encodeContext(r, c, sizeof(c)));
+    TEST_ASSERT_EQUAL_HEX8(0x02, c[1]);
+    TEST_ASSERT_EQUAL_HEX8(0xF1, c[3]);
+    TEST_ASSERT_EQUAL_UINT32(0, GlucoseService::encodeMeasurement(r, m, sizeof(m) - 1));
+}
+
+void test_report_records_greater_or_equal(void) {
+    addRecords(20);
+    GlucoseService service(store, gatt, 4);
+    // 上报序号 ≥ 15 的记录
+    write({ 0x01, 0x03, 0x01, 15, 0 }, service);
+    pollUntilIdle(service);
+
+    TEST_ASSERT_FALSE(service.isReporting());
+    TEST_ASSERT_EQUAL_INT(5, gatt.countOf(GattSink::Characteristic::MEASUREMENT));
+    TEST_ASSERT_EQUAL_INT(5, gatt.countOf(GattSink::Characteristic::CONTEXT));
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_UINT16(15 + i, gatt.measurementSequence(i));
+    }
+    // 每条测量后紧跟它的 Context，最后是成功响应
+    TEST_ASSERT_TRUE(gatt.packets[1].characteristic == GattSink::Characteristic::CONTEXT);
+    TEST_ASSERT_TRUE(gatt.packets[gatt.count - 1].characteristic == GattSink::Characteristic::RACP);
+    assertResponse(0x01, GlucoseService::RESPONSE_SUCCESS);
+}
+
+void test_report_is_paced_and_resumes_after_congestion(void) {
+    addRecords(10);
+    GlucoseService service(store, gatt, 3);
+    write({ 0x01, 0x01 }, service);
+
+    // 每次 poll() 最多发送3条记录
+    service.poll();
+    TEST_ASSERT_EQUAL_INT(3, gatt.countOf(GattSink::Characteristic::MEASUREMENT));
+    TEST_ASSERT_TRUE(service.isReporting());
+
+    // 发送缓冲区在一条测量与其 Context 之间满了: 下一次只补发 Context，不重复测量
+    gatt.budget = 1;
+    service.poll();
+    TEST_ASSERT_EQUAL_INT(4, gatt.countOf(GattSink::Characteristic::MEASUREMENT));
+    TEST_ASSERT_EQUAL_INT(3, gatt.countOf(GattSink::Characteristic::CONTEXT));
+    gatt.budget = -1;
+    pollUntilIdle(service);
+
+    TEST_ASSERT_EQUAL_INT(10, gatt.countOf(GattSink::Characteristic::MEASUREMENT));
+    TEST_ASSERT_EQUAL_INT(10, gatt.countOf(GattSink::Characteristic::CONTEXT));
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_UINT16(i, gatt.measurementSequence(i));
+    }
+    assertResponse(0x01, GlucoseService::RESPONSE_SUCCESS);
+}
+
+void test_report_number_first_last_and_range(void) {
+    addRecords(8);
+    GlucoseService service(store, gatt, 4);
+
+    write({ 0x04, 0x01 }, service);
+    service.poll();
+    const Packet* p = gatt.last(GattSink::Characteristic::RACP);
+    TEST_ASSERT_EQUAL_UINT8(GlucoseService::OP_NUMBER_RESPONSE, p->data[0]);
+    TEST_ASSERT_EQUAL_UINT16(8, p->data[2] | (p->data[3] << 8));
+
+    // [2, 5] 共4条
+    write({ 0x04, 0x04, 0x01, 2, 0, 5, 0 }, service);
+    service.poll();
+    p = gatt.last(GattSink::Characteristic::RACP);
+    TEST_ASSERT_EQUAL_UINT16(4, p->data[2] | (p->data[3] << 8));
+
+    // ≤ 2 共3条
+    write({ 0x04, 0x02, 0x01, 2, 0 }, service);
+    service.poll();
+    p = gatt.last(GattSink::Characteristic::RACP);
+    TEST_ASSERT_EQUAL_UINT16(3, p->data[2] | (p->data[3] << 8));
+
+    write({ 0x01, 0x06 }, service);
+    pollUntilIdle(service);
+    TEST_ASSERT_EQUAL_INT(1, gatt.countOf(GattSink::Characteristic::MEASUREMENT));
+    TEST_ASSERT_EQUAL_UINT16(7, gatt.measurementSequence(0));
+}
+
+void test_abort_and_delete(void) {
+    addRecords(50);
+    GlucoseService service(store, gatt, 2);
+    write({ 0x01, 0x01 }, service);
+    service.poll();
+    TEST_ASSERT_TRUE(service.isReporting());
+
+    // 上报进行中，其他请求被拒绝
+    write({ 0x04, 0x01 }, service);
+    service.poll();
+    assertResponse(0x04, GlucoseService::RESPONSE_PROCEDURE_NOT_COMPLETED);
+
+    write({ 0x03, 0x00 }, service);
+    service.poll();
+    TEST_ASSERT_FALSE(service.isReporting());
+    assertResponse(0x03, GlucoseService::RESPONSE_SUCCESS);
+    int sent = gatt.countOf(GattSink::Characteristic::MEASUREMENT);
+    pollUntilIdle(service);
+    TEST_ASSERT_EQUAL_INT(sent, gatt.countOf(GattSink::Characteristic::MEASUREMENT));
+
+    write({ 0x02, 0x03, 0x01, 10, 0 }, service);
+    service.poll();
+    assertResponse(0x02, GlucoseService::RESPONSE_OPERATOR_NOT_SUPPORTED);
+    write({ 0x02, 0x01 }, service);
+    service.poll();
+    assertResponse(0x02, GlucoseService::RESPONSE_SUCCESS);
+    TEST_ASSERT_EQUAL_INT(0, store.count());
+
+    write({ 0x01, 0x01 }, service);
+    service.poll();
+    assertResponse(0x01, GlucoseService::RESPONSE_NO_RECORDS_FOUND);
+}
+
+void test_invalid_requests(void) {
+    addRecords(3);
+    GlucoseService service(store, gatt, 4);
+
+    write({ 0x09, 0x01 }, service);
+    service.poll();
+    assertResponse(0x09, GlucoseService::RESPONSE_OP_CODE_NOT_SUPPORTED);
+
+    write({ 0x01, 0x00 }, service);
+    service.poll();
+    assertResponse(0x01, GlucoseService::RESPONSE_INVALID_OPERATOR);
+
+    write({ 0x01, 0x07 }, service);
+    service.poll();
+    assertResponse(0x01, GlucoseService::RESPONSE_OPERATOR_NOT_SUPPORTED);
+
+    // 缺少操作数 / 范围颠倒
+    write({ 0x01, 0x03, 0x01 }, service);
+    service.poll();
+    assertResponse(0x01, GlucoseService::RESPONSE_INVALID_OPERAND);
+    write({ 0x01, 0x04, 0x01, 5, 0, 2, 0 }, service);
+    service.poll();
+    assertResponse(0x01, GlucoseService::RESPONSE_INVALID_OPERAND);
+
+    // 按时间过滤不支持
+    write({ 0x01, 0x03, 0x02, 0xE8, 0x07, 1, 1, 0, 0, 0 }, service);
+    service.poll();
+    assertResponse(0x01, GlucoseService::RESPONSE_OPERAND_NOT_SUPPORTED);
+
+    // 响应发送失败时下一次重试
+    gatt.budget = 0;
+    write({ 0x03, 0x00 }, service);
+    service.poll();
+    int before = gatt.count;
+    gatt.budget = -1;
+    service.poll();
+    TEST_ASSERT_EQUAL_INT(before + 1, gatt.count);
+    assertResponse(0x03, GlucoseService::RESPONSE_SUCCESS);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_record_store_overwrites_oldest);
+    RUN_TEST(test_record_sequence_continues_after_restart);
+    RUN_TEST(test_measurement_encoding);
+    RUN_TEST(test_report_records_greater_or_equal);
+    RUN_TEST(test_report_is_paced_and_resumes_after_congestion);
+    RUN_TEST(test_report_number_first_last_and_range);
+    RUN_TEST(test_abort_and_delete);
+    RUN_TEST(test_invalid_requests);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,144 @@
+#include <unity.h>
+#include <HistoryResampler.h>
+
+// 带时间戳的历史与按模型时间网格重采样的测试 (间隔插值、过期与间隔上限):
+//   pio test -e native -f test_history_resampler
+
+namespace {
+    HistoryResampler::Config config() {
+        HistoryResampler::Config c;
+        c.gridStepMs = 2000;        // 模型按2秒一个读数训练
+        c.gridSize = 10;
+        c.maxGapMs = 10000;
+        c.maxStalenessMs = 10000;
+        c.minQuality = 0.2f;
+        return c;
+    }
+
+    // 血糖按 1 mg/dL 每2秒线性上升，便于检查插值结果
+    float truth(uint32_t t) {
+        return 100.0f + t / 2000.0f;
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_regular_readings_pass_through(void) {
+    HistoryResampler h(config());
+    for (uint32_t t = 0; t <= 18000; t += 2000) h.add(t, truth(t));
+
+    HistoryResampler::Window w;
+    TEST_ASSERT_TRUE(h.resample(18000, &w) == HistoryResampler::Status::OK);
+    TEST_ASSERT_EQUAL_INT(10, w.size);
+    for (int k = 0; k < 10; k++) {
+        TEST_ASSERT_EQUAL_FLOAT(truth(k * 2000), w.values[k]);
+        TEST_ASSERT_EQUAL_FLOAT(0.0f, w.gapMinutes[k]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, w.longestGapMs);
+}
+
+void test_irregular_readings_are_interpolated_onto_grid(void) {
+    HistoryResampler h(config());
+    // 稳定后间隔变为4秒以上，中间还有一次手指移开造成的8秒间隔
+    const uint32_t times[] = { 0, 3100, 7300, 11500, 19500, 23700, 27900 };
+    for (uint32_t t : times) h.add(t, truth(t));
+
+    HistoryResampler::Window w;
+    TEST_ASSERT_TRUE(h.resample(28500, &w) == HistoryResampler::Status::OK);
+    // 网格以最新读数为终点: 27900, 25900, ..., 9900
+    for (int k = 0; k < 10; k++) {
+        uint32_t t = 27900 - 2000 * (9 - k);
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, truth(t), w.values[k]);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, w.gapMinutes[9]);
+    // 13900 与 17900 落在 [11500, 19500] 区间内
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 8000 / 60000.0f, w.gapMinutes[2]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 8000 / 60000.0f, w.gapMinutes[4]);
+    TEST_ASSERT_EQUAL_UINT32(8000, w.longestGapMs);
+}
+
+void test_gap_longer_than_limit_invalidates_window(void) {
+    HistoryResampler h(config());
+    for (uint32_t t = 0; t <= 8000; t += 2000) h.add(t, truth(t));
+    for (uint32_t t = 20000; t <= 30000; t += 2000) h.add(t, truth(t)); // 12秒没有读数
+
+    HistoryResampler::Window w;
+    TEST_ASSERT_TRUE(h.resample(30000, &w) == HistoryResampler::Status::GAP_TOO_LONG);
+
+    // 间隔移出窗口后恢复
+    for (uint32_t t = 32000; t <= 38000; t += 2000) h.add(t, truth(t));
+    TEST_ASSERT_TRUE(h.resample(38000, &w) == HistoryResampler::Status::OK);
+}
+
+void test_staleness_cutoff(void) {
+    HistoryResampler h(config());
+    for (uint32_t t = 0; t <= 18000; t += 2000) h.add(t, truth(t));
+
+    HistoryResampler::Window w;
+    TEST_ASSERT_TRUE(h.resample(28000, &w) == HistoryResampler::Status::OK);    // 刚好10秒
+    TEST_ASSERT_TRUE(h.resample(28001, &w) == HistoryResampler::Status::STALE);
+}
+
+void test_not_enough_history(void) {
+    HistoryResampler h(config());
+    HistoryResampler::Window w;
+    TEST_ASSERT_TRUE(h.resample(0, &w) == HistoryResampler::Status::NOT_ENOUGH_HISTORY);
+
+    // 读数个数够了，但时间跨度不够 (每秒一个读数，只覆盖9秒)
+    for (uint32_t t = 0; t <= 9000; t += 1000) h.add(t, truth(t));
+    TEST_ASSERT_TRUE(h.resample(9000, &w) == HistoryResampler::Status::NOT_ENOUGH_HISTORY);
+    h.add(18000, truth(18000));
+    TEST_ASSERT_TRUE(h.resample(18000, &w) == HistoryResampler::Status::OK);
+}
+
+void test_rejects_low_quality_and_out_of_order(void) {
+    HistoryResampler h(config());
+    TEST_ASSERT_TRUE(h.add(1000, 100.0f, 0.9f));
+    TEST_ASSERT_FALSE(h.add(2000, 300.0f, 0.1f));   // 信号质量差
+    TEST_ASSERT_FALSE(h.add(1000, 101.0f));         // 重复时间戳
+    TEST_ASSERT_FALSE(h.add(500, 99.0f));           // 时间倒退
+    TEST_ASSERT_EQUAL_INT(1, h.size());
+}
+
+void test_ring_keeps_newest_and_handles_millis_wraparound(void) {
+    HistoryResampler h(config());
+    uint32_t start = 0xFFFFFFFFu - 30000; // 约49.7天后 millis() 回绕
+    for (int i = 0; i < 40; i++) h.add(start + i * 2000u, 100.0f + i);
+    TEST_ASSERT_EQUAL_INT(HistoryResampler::kCapacity, h.size());
+    TEST_ASSERT_EQUAL_FLOAT(108.0f, h.at(0).value);
+
+    HistoryResampler::Window w;
+    uint32_t last = start + 39 * 2000u;
+    TEST_ASSERT_TRUE(h.resample(last + 500, &w) == HistoryResampler::Status::OK);
+    TEST_ASSERT_EQUAL_FLOAT(130.0f, w.values[0]);
+    TEST_ASSERT_EQUAL_FLOAT(139.0f, w.values[9]);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_regular_readings_pass_through);
+    RUN_TEST(test_irregular_readings_are_interpolated_onto_grid);
+    RUN_TEST(test_gap_longer_than_limit_invalidates_window);
+    RUN_TEST(test_staleness_cutoff);
+    RUN_TEST(test_not_enough_history);
+    RUN_TEST(test_rejects_low_quality_and_out_of_order);
+    RUN_TEST(test_ring_keeps_newest_and_handles_millis_wraparound);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,220 @@
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <InferenceService.h>
+
+// 异步推理服务的测试。用桩函数代替 TFLite 解释器，在主机上使用 std::thread 运行:
+//   pio test -e native -f test_inference_service
+
+namespace {
+    // 桩解释器: 输出 = 输入均值 + 步数，可以在推理中途阻塞，以便构造请求堆积的场景
+    struct StubInterpreter {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool gateOpen = true;
+        int entered = 0;
+        bool fail = false;
+        std::vector<float> firstInputs; // 每次推理收到的第一个输入值
+
+        bool invoke(const float* input, int inputSize, float* output, int* outputSize) {
+            std::unique_lock<std::mutex> lock(mutex);
+            entered++;
+            firstInputs.push_back(input[0]);
+            cv.notify_all();
+            cv.wait(lock, [this] { return gateOpen; });
+            if (fail) return false;
+            float sum = 0.0f;
+            for (int i = 0; i < inputSize; i++) sum += input[i];
+            for (int i = 0; i < 3; i++) output[i] = sum / inputSize + (i + 1);
+            *outputSize = 3;
+            return true;
+        }
+
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex);
+            gateOpen = false;
+        }
+
+        void open() {
+            std::lock_guard<std::mutex> lock(mutex);
+            gateOpen = true;
+            cv.notify_all();
+        }
+
+        bool waitEntered(int n) {
+            std::unique_lock<std::mutex> lock(mutex);
+            return cv.wait_for(lock, std::chrono::seconds(2), [&] { return entered >= n; });
+        }
+    };
+
+    StubInterpreter* stub = nullptr;
+
+    InferenceService::InvokeFn stubFn() {
+        return [](const float* in, int n, float* out, int* outN) { return stub->invoke(in, n, out, outN); };
+    }
+
+    bool waitResult(InferenceService& service, InferenceService::Result* out) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (service.takeResult(out)) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    void fillWindow(float* window, float value) {
+        for (int i = 0; i < 10; i++) window[i] = value;
+    }
+}
+
+void setUp(void) {
+    stub = new StubInterpreter();
+}
+
+void tearDown(void) {
+    delete stub;
+    stub = nullptr;
+}
+
+void test_single_request_returns_result(void) {
+    InferenceService service(stubFn());
+    std::atomic<int> callbacks(0);
+    std::atomic<uint32_t> callbackId(0);
+    service.setResultCallback([&](const InferenceService::Result& r) {
+        callbackId = r.requestId;
+        callbacks++;
+    });
+    TEST_ASSERT_TRUE(service.start());
+
+    float window[10];
+    fillWindow(window, 120.0f);
+    uint32_t id = service.submit(window, 10);
+    TEST_ASSERT_TRUE(id != 0);
+
+    InferenceService::Result r;
+    TEST_ASSERT_TRUE(waitResult(service, &r));
+    TEST_ASSERT_EQUAL_UINT32(id, r.requestId);
+    TEST_ASSERT_TRUE(r.ok);
+    TEST_ASSERT_EQUAL_INT(3, r.outputSize);
+    TEST_ASSERT_EQUAL_FLOAT(121.0f, r.output[0]);
+    TEST_ASSERT_EQUAL_FLOAT(123.0f, r.output[2]);
+
+    service.stop();
+    TEST_ASSERT_EQUAL_INT(1, callbacks.load());
+    TEST_ASSERT_EQUAL_UINT32(id, callbackId.load());
+    TEST_ASSERT_FALSE(service.takeResult(&r)); // 结果只取一次
+}
+
+void test_backlog_is_coalesced_to_newest_input(void) {
+    InferenceService service(stubFn());
+    TEST_ASSERT_TRUE(service.start());
+
+    // 第一个请求开始推理后阻塞，期间再提交三个请求
+    stub->close();
+    float window[10];
+    fillWindow(window, 100.0f);
+    service.submit(window, 10);
+    TEST_ASSERT_TRUE(stub->waitEntered(1));
+
+    uint32_t last = 0;
+    for (int i = 1; i <= 3; i++) {
+        fillWindow(window, 100.0f + i);
+        last = service.submit(window, 10);
+    }
+    TEST_ASSERT_TRUE(service.isBusy());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    stub->open();
+
+    TEST_ASSERT_TRUE(stub->waitEntered(2));
+    InferenceService::Result r;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (service.isBusy() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    TEST_ASSERT_TRUE(service.takeResult(&r));
+    service.stop();
+
+    // 只执行了第一个和最新的请求
+    TEST_ASSERT_EQUAL_INT(2, (int)stub->firstInputs.size());
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, stub->firstInputs[0]);
+    TEST_ASSERT_EQUAL_FLOAT(103.0f, stub->firstInputs[1]);
+    TEST_ASSERT_EQUAL_UINT32(last, r.requestId);
+
+    InferenceService::Stats s = service.getStats();
+    TEST_ASSERT_EQUAL_UINT32(4, s.submitted);
+    TEST_ASSERT_EQUAL_UINT32(2, s.completed);
+    TEST_ASSERT_EQUAL_UINT32(2, s.coalesced);
+    // 最新请求在队列中至少等待了第一次推理被阻塞的时间
+    TEST_ASSERT_GREATER_OR_EQUAL(15000u, s.maxQueueUs);
+    TEST_ASSERT_GREATER_OR_EQUAL(15000u, s.maxInvokeUs);
+}
+
+void test_failed_invoke_is_reported(void) {
+    stub->fail = true;
+    InferenceService service(stubFn());
+    TEST_ASSERT_TRUE(service.start());
+
+    float window[10];
+    fillWindow(window, 90.0f);
+    service.submit(window, 10);
+    InferenceService::Result r;
+    TEST_ASSERT_TRUE(waitResult(service, &r));
+    service.stop();
+
+    TEST_ASSERT_FALSE(r.ok);
+    TEST_ASSERT_EQUAL_UINT32(1, service.getStats().failed);
+    TEST_ASSERT_EQUAL_UINT32(0, service.getStats().completed);
+}
+
+void test_rejects_bad_requests_and_stops_cleanly(void) {
+    InferenceService service(stubFn());
+    float window[InferenceService::kMaxInputSize + 1] = { 0 };
+
+    // 未启动
+    TEST_ASSERT_EQUAL_UINT32(0, service.submit(window, 10));
+
+    TEST_ASSERT_TRUE(service.start());
+    TEST_ASSERT_EQUAL_UINT32(0, service.submit(window, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, service.submit(window, InferenceService::kMaxInputSize + 1));
+
+    // 推理阻塞时停止: 等待当前推理完成，丢弃未执行的请求
+    stub->close();
+    service.submit(window, 10);
+    TEST_ASSERT_TRUE(stub->waitEntered(1));
+    service.submit(window, 10);
+    std::thread opener([] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stub->open();
+    });
+    service.stop();
+    opener.join();
+    TEST_ASSERT_EQUAL_INT(1, stub->entered);
+    TEST_ASSERT_FALSE(service.isBusy());
+    TEST_ASSERT_EQUAL_UINT32(0, service.submit(window, 10));
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_single_request_returns_result);
+    RUN_TEST(test_backlog_is_coalesced_to_newest_input);
+    RUN_TEST(test_failed_invoke_is_reported);
+    RUN_TEST(test_rejects_bad_requests_and_stops_cleanly);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,77 @@
+#include <unity.h>
+#include <LatencyStats.h>
+
+// 推理基准测试的耗时分位数计算测试:
+//   pio test -e native -f test_latency_stats
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_percentiles_nearest_rank(void) {
+    LatencyStats stats;
+    // 乱序加入 1..100
+    for (uint32_t i = 0; i < 100; i++) {
+        stats.add((i * 37) % 100 + 1);
+    }
+    LatencyStats::Summary s = stats.summarize();
+    TEST_ASSERT_EQUAL_INT(100, s.count);
+    TEST_ASSERT_EQUAL_UINT32(1, s.minUs);
+    TEST_ASSERT_EQUAL_UINT32(50, s.p50Us);
+    TEST_ASSERT_EQUAL_UINT32(90, s.p90Us);
+    TEST_ASSERT_EQUAL_UINT32(99, s.p99Us);
+    TEST_ASSERT_EQUAL_UINT32(100, s.maxUs);
+    TEST_ASSERT_EQUAL_UINT32(50, s.meanUs); // 50.5 向下取整
+}
+
+void test_tail_latency_outlier(void) {
+    LatencyStats stats;
+    for (int i = 0; i < 99; i++) stats.add(1000);
+    stats.add(25000); // 例如推理被flash写入阻塞
+    TEST_ASSERT_EQUAL_UINT32(1000, stats.percentile(50.0f));
+    TEST_ASSERT_EQUAL_UINT32(1000, stats.percentile(99.0f));
+    TEST_ASSERT_EQUAL_UINT32(25000, stats.percentile(100.0f));
+
+    // 排序后继续加入样本
+    stats.clear();
+    stats.add(7);
+    TEST_ASSERT_EQUAL_UINT32(7, stats.percentile(0.0f));
+    stats.add(3);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.percentile(50.0f));
+}
+
+void test_empty_and_full(void) {
+    LatencyStats stats;
+    LatencyStats::Summary s = stats.summarize();
+    TEST_ASSERT_EQUAL_INT(0, s.count);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.percentile(50.0f));
+
+    for (int i = 0; i < LatencyStats::kMaxSamples; i++) {
+        TEST_ASSERT_TRUE(stats.add(10));
+    }
+    TEST_ASSERT_FALSE(stats.add(10));
+    TEST_ASSERT_EQUAL_INT(LatencyStats::kMaxSamples, stats.count());
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_percentiles_nearest_rank);
+    RUN_TEST(test_tail_latency_outlier);
+    RUN_TEST(test_empty_and_full);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,302 @@
+#include <unity.h>
+#include <string.h>
+#include <math.h>
+#include <ModelImage.h>
+
+// 模型分区镜像头部解析与A/B槽选择策略的测试:
+//   pio test -e native -f test_model_image
+
+using namespace ModelImage;
+
+namespace {
+    // 由 tools/make_model_image.py 对 include/model_data.h 生成的头部 (version 1)
+    const uint8_t kToolHeader[kHeaderSize] = {
+        0x47, 0x4d, 0x44, 0x4c, 0x01, 0x00, 0x20, 0x00, 0x01, 0x00, 0x00, 0x00,
+        0xd8, 0x54, 0x02, 0x00, 0xe9, 0x3c, 0xdb, 0x5b, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x1f, 0x05, 0x64, 0xca
+    };
+
+    constexpr size_t kSlotSize = 256 * 1024;
+    constexpr uint8_t kMaxAttempts = 2;
+
+    SlotStatus slot(bool valid, uint32_t version, ModelFormat format = ModelFormat::FLOAT32) {
+        SlotStatus s = { valid, version, format };
+        return s;
+    }
+
+    BootState state(int8_t confirmed, int8_t pending, uint8_t attempts) {
+        BootState s = { confirmed, pending, attempts };
+        return s;
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_crc32_matches_reference(void) {
+    const uint8_t check[] = "123456789";
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, crc32(check, 9));
+    // 分段累加与一次性计算结果一致
+    uint32_t partial = crc32(check, 4);
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, crc32(check + 4, 5, partial));
+}
+
+void test_parse_header_generated_by_tool(void) {
+    Header h;
+    TEST_ASSERT_TRUE(parseHeader(kToolHeader, kSlotSize, &h) == ParseResult::OK);
+    TEST_ASSERT_EQUAL_UINT32(1, h.modelVersion);
+    TEST_ASSERT_EQUAL_UINT32(152792, h.modelSize);
+    TEST_ASSERT_EQUAL_HEX32(0x5bdb3ce9, h.modelCrc32);
+}
+
+void test_serialize_round_trip(void) {
+    Header in = { 0, 0, 0, 42, 1000, 0xDEADBEEF, 0 };
+    uint8_t raw[kHeaderSize];
+    serializeHeader(in, raw);
+
+    Header out;
+    TEST_ASSERT_TRUE(parseHeader(raw, kSlotSize, &out) == ParseResult::OK);
+    TEST_ASSERT_EQUAL_UINT32(42, out.modelVersion);
+    TEST_ASSERT_EQUAL_UINT32(1000, out.modelSize);
+    TEST_ASSERT_EQUAL_HEX32(0xDEADBEEF, out.modelCrc32);
+}
+
+void test_parse_header_rejects_bad_images(void) {
+    Header h;
+    uint8_t raw[kHeaderSize];
+
+    // 擦除后的空分区
+    memset(raw, 0xFF, sizeof(raw));
+    TEST_ASSERT_TRUE(parseHeader(raw, kSlotSize, &h) == ParseResult::BAD_MAGIC);
+
+    // 头部任意一位翻转
+    memcpy(raw, kToolHeader, sizeof(raw));
+    raw[9] ^= 0x01;
+    TEST_ASSERT_TRUE(parseHeader(raw, kSlotSize, &h) == ParseResult::BAD_HEADER_CRC);
+
+    // 不支持的头部版本
+    memcpy(raw, kToolHeader, sizeof(raw));
+    raw[4] = 2;
+    TEST_ASSERT_TRUE(parseHeader(raw, kSlotSize, &h) == ParseResult::BAD_VERSION);
+
+    // 模型长度超出分区
+    TEST_ASSERT_TRUE(parseHeader(kToolHeader, 64 * 1024, &h) == ParseResult::BAD_SIZE);
+}
+
+void test_verify_payload(void) {
+    uint8_t payload[256];
+    for (int i = 0; i < 256; i++) payload[i] = (uint8_t)(i * 7);
+    Header h = { 0, 0, 0, 1, sizeof(payload), crc32(payload, sizeof(payload)), 0 };
+    TEST_ASSERT_TRUE(verifyPayload(h, payload));
+    payload[100] ^= 0x80;
+    TEST_ASSERT_FALSE(verifyPayload(h, payload));
+}
+
+void test_parse_ensemble_directory(void) {
+    // 与 tools/make_model_image.py 打包多个模型时的布局相同: 目录之后每个成员按16字节对齐
+    alignas(16) uint8_t payload[96] = {};
+    const uint8_t directory[] = {
+        0x47, 0x45, 0x4e, 0x53, 0x02, 0x00, 0x00, 0x00,   // 'GENS', count 2
+        0x20, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00,   // offset 32, size 24
+        0x40, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00    // offset 64, size 32
+    };
+    memcpy(payload, directory, sizeof(directory));
+
+    EnsembleMember members[4];
+    TEST_ASSERT_EQUAL_INT(2, parseEnsemble(payload, sizeof(payload), members, 4));
+    TEST_ASSERT_TRUE(members[0].data == payload + 32);
+    TEST_ASSERT_EQUAL_UINT32(24, members[0].size);
+    TEST_ASSERT_TRUE(members[1].data == payload + 64);
+    TEST_ASSERT_EQUAL_UINT32(32, members[1].size);
+
+    // 超过调用方能容纳的成员数
+    TEST_ASSERT_EQUAL_INT(-1, parseEnsemble(payload, sizeof(payload), members, 1));
+    // 成员越界 (数据被截断)
+    TEST_ASSERT_EQUAL_INT(-1, parseEnsemble(payload, 90, members, 4));
+    // 未对齐
+    payload[16] = 0x44;
+    TEST_ASSERT_EQUAL_INT(-1, parseEnsemble(payload, sizeof(payload), members, 4));
+}
+
+void test_plain_model_is_not_an_ensemble(void) {
+    // 普通 .tflite: 偏移4处为 "TFL3"
+    const uint8_t tflite[16] = { 0x1c, 0x00, 0x00, 0x00, 'T', 'F', 'L', '3' };
+    EnsembleMember members[4];
+    TEST_ASSERT_EQUAL_INT(0, parseEnsemble(tflite, sizeof(tflite), members, 4));
+}
+
+void test_select_prefers_confirmed_slot(void) {
+    SlotStatus slots[kSlotCount] = { slot(true, 3), slot(true, 5) };
+    SlotDecision d = selectSlot(slots, state(0, -1, 0), kMaxAttempts);
+    TEST_ASSERT_EQUAL_INT(0, d.slot);
+    TEST_ASSERT_FALSE(d.trial);
+}
+
+void test_select_trials_pending_slot_then_rolls_back(void) {
+    SlotStatus slots[kSlotCount] = { slot(true, 3), slot(true, 4) };
+
+    SlotDecision d = selectSlot(slots, state(0, 1, 0), kMaxAttempts);
+    TEST_ASSERT_EQUAL_INT(1, d.slot);
+    TEST_ASSERT_TRUE(d.trial);
+
+    d = selectSlot(slots, state(0, 1, 1), kMaxAttempts);
+    TEST_ASSERT_EQUAL_INT(1, d.slot);
+
+    // 尝试次数用完 (新模型反复导致崩溃) -> 回滚到已确认的槽位
+    d = selectSlot(slots, state(0, 1, kMaxAttempts), kMaxAttempts);
+    TEST_ASSERT_EQUAL_INT(0, d.slot);
+    TEST_ASSERT_FALSE(d.trial);
+}
+
+void test_select_rolls_back_when_pending_slot_is_corrupt(void) {
+    SlotStatus slots[kSlotCount] = { slot(true, 3), slot(false, 0) };
+    SlotDecision d = selectSlot(slots, state(0, 1, 0), kMaxAttempts);
+    TEST_ASSERT_EQUAL_INT(0, d.slot);
+    TEST_ASSERT_FALSE(d.trial);
+}
+
+void test_select_without_history_picks_newest_valid(void) {
+    SlotStatus slots[kSlotCount] = { slot(true, 2), slot(true, 7) };
+    SlotDecision d = selectSlot(slots, state(-1, -1, 0), kMaxAttempts);
+    TEST_ASSERT_EQUAL_INT(1, d.slot);
+    TEST_ASSERT_TRUE(d.trial);
+
+    // 已失败的待确认槽位不会被再次选中
+    d = selectSlot(slots, state(-1, 1, kMaxAttempts), kMaxAttempts);
+    TEST_ASSERT_EQUAL_INT(0, d.slot);
+}
+
+void test_select_returns_none_when_no_valid_slot(void) {
+    SlotStatus slots[kSlotCount] = { slot(false, 0), slot(false, 0) };
+    SlotDecision d = selectSlot(slots, state(0, 1, 0), kMaxAttempts);
+    TEST_ASSERT_EQUAL_INT(-1, d.slot);
+    TEST_ASSERT_FALSE(d.trial);
+}
+
+void test_select_by_preferred_format(void) {
+    SlotStatus slots[kSlotCount] = { slot(true, 3, ModelFormat::FLOAT32), slot(true, 2, ModelFormat::INT8) };
+
+    // 偏好int8: 选择int8槽位，未确认过时作为试运行
+    SlotDecision d = selectSlot(slots, state(0, -1, 0), kMaxAttempts, ModelFormat::INT8);
+    TEST_ASSERT_EQUAL_INT(1, d.slot);
+    TEST_ASSERT_TRUE(d.trial);
+
+    // 已确认的槽位满足偏好时不需要试运行
+    d = selectSlot(slots, state(1, -1, 0), kMaxAttempts, ModelFormat::INT8);
+    TEST_ASSERT_EQUAL_INT(1, d.slot);
+    TEST_ASSERT_FALSE(d.trial);
+
+    // 没有满足偏好的槽位时按常规规则回退
+    SlotStatus floats[kSlotCount] = { slot(true, 3), slot(true, 4) };
+    d = selectSlot(floats, state(0, -1, 0), kMaxAttempts, ModelFormat::INT8);
+    TEST_ASSERT_EQUAL_INT(0, d.slot);
+    TEST_ASSERT_FALSE(d.trial);
+
+    // 待确认的新模型仍然优先于精度偏好
+    d = selectSlot(slots, state(1, 0, 0), kMaxAttempts, ModelFormat::INT8);
+    TEST_ASSERT_EQUAL_INT(0, d.slot);
+    TEST_ASSERT_TRUE(d.trial);
+}
+
+void test_update_targets_inactive_slot(void) {
+    TEST_ASSERT_EQUAL_INT(1, updateTargetSlot(0, 0));
+    TEST_ASSERT_EQUAL_INT(0, updateTargetSlot(1, 1));
+    TEST_ASSERT_EQUAL_INT(0, updateTargetSlot(-1, -1)); // 正在使用内置模型
+    // 使用内置模型时不覆盖已确认的槽位 (它在本次启动中加载失败，但仍是回退候选)
+    TEST_ASSERT_EQUAL_INT(1, updateTargetSlot(-1, 0));
+    // 没有确认记录时试运行的槽位之外的槽位可以覆盖
+    TEST_ASSERT_EQUAL_INT(0, updateTargetSlot(1, -1));
+}
+
+void test_update_rejected_while_trial_would_overwrite_fallback(void) {
+    // 槽位1试运行中，槽位0是已确认的回退模型
+    TEST_ASSERT_EQUAL_INT(-1, updateTargetSlot(1, 0));
+    TEST_ASSERT_EQUAL_INT(-1, updateTargetSlot(0, 1));
+}
+
+void test_trial_confirms_after_required_successful_inferences(void) {
+    TrialPolicy policy = { 3, 20.0f, 600.0f };
+    TrialProgress progress = { 0 };
+    const float curve[4] = { 110.0f, 115.0f, 121.0f, 126.0f };
+
+    TEST_ASSERT_TRUE(recordTrialInference(&progress, policy, true, curve, 4) == TrialVerdict::PENDING);
+    TEST_ASSERT_TRUE(recordTrialInference(&progress, policy, true, curve, 4) == TrialVerdict::PENDING);
+    TEST_ASSERT_TRUE(recordTrialInference(&progress, policy, true, curve, 4) == TrialVerdict::CONFIRM);
+    TEST_ASSERT_EQUAL_UINT16(3, progress.successes);
+}
+
+void test_trial_rejects_failed_or_implausible_inference(void) {
+    TrialPolicy policy = { 3, 20.0f, 600.0f };
+    const float good[3] = { 100.0f, 101.0f, 102.0f };
+    const float nan[3] = { 100.0f, NAN, 102.0f };
+    const float inf[3] = { 100.0f, INFINITY, 102.0f };
+    const float low[3] = { 100.0f, 5.0f, 102.0f };
+    const float high[3] = { 100.0f, 101.0f, 1.0e6f };
+
+    TrialProgress progress = { 0 };
+    TEST_ASSERT_TRUE(recordTrialInference(&progress, policy, true, good, 3) == TrialVerdict::PENDING);
+    // Invoke() 失败
+    TEST_ASSERT_TRUE(recordTrialInference(&progress, policy, false, good, 3) == TrialVerdict::REJECT);
+    // 没有输出
+    TEST_ASSERT_TRUE(recordTrialInference(&progress, policy, true, nullptr, 0) == TrialVerdict::REJECT);
+    TEST_ASSERT_TRUE(recordTrialInference(&progress, policy, true, good, 0) == TrialVerdict::REJECT);
+    // 输出无效
+    TEST_ASSERT_TRUE(recordTrialInference(&progress, policy, true, nan, 3) == TrialVerdict::REJECT);
+    TEST_ASSERT_TRUE(recordTrialInference(&progress, policy, true, inf, 3) == TrialVerdict::REJECT);
+    TEST_ASSERT_TRUE(recordTrialInference(&progress, policy, true, low, 3) == TrialVerdict::REJECT);
+    TEST_ASSERT_TRUE(recordTrialInference(&progress, policy, true, high, 3) == TrialVerdict::REJECT);
+}
+
+void test_unconfirmed_trial_rolls_back_after_crashing_boots(void) {
+    // 新模型加载成功但每次推理时崩溃: 每次启动都计入尝试次数，确认之前不会清零
+    SlotStatus slots[kSlotCount] = { slot(true, 3), slot(true, 4) };
+    BootState s = state(0, 1, 0);
+    for (uint8_t boot = 0; boot < kMaxAttempts; boot++) {
+        SlotDecision d = selectSlot(slots, s, kMaxAttempts);
+        TEST_ASSERT_EQUAL_INT(1, d.slot);
+        TEST_ASSERT_TRUE(d.trial);
+        s.attempts++;
+    }
+    SlotDecision d = selectSlot(slots, s, kMaxAttempts);
+    TEST_ASSERT_EQUAL_INT(0, d.slot);
+    TEST_ASSERT_FALSE(d.trial);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc32_matches_reference);
+    RUN_TEST(test_parse_header_generated_by_tool);
+    RUN_TEST(test_serialize_round_trip);
+    RUN_TEST(test_parse_header_rejects_bad_images);
+    RUN_TEST(test_verify_payload);
+    RUN_TEST(test_parse_ensemble_directory);
+    RUN_TEST(test_plain_model_is_not_an_ensemble);
+    RUN_TEST(test_select_prefers_confirmed_slot);
+    RUN_TEST(test_select_trials_pending_slot_then_rolls_back);
+    RUN_TEST(test_select_rolls_back_when_pending_slot_is_corrupt);
+    RUN_TEST(test_select_without_history_picks_newest_valid);
+    RUN_TEST(test_select_returns_none_when_no_valid_slot);
+    RUN_TEST(test_select_by_preferred_format);
+    RUN_TEST(test_update_targets_inactive_slot);
+    RUN_TEST(test_update_rejected_while_trial_would_overwrite_fallback);
+    RUN_TEST(test_trial_confirms_after_required_successful_inferences);
+    RUN_TEST(test_trial_rejects_failed_or_implausible_inference);
+    RUN_TEST(test_unconfirmed_trial_rolls_back_after_crashing_boots);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,136 @@
+#include <unity.h>
+#include <string>
+#include <vector>
+#include <OpProfile.h>
+
+// 按算子统计推理耗时的测试 (累计、换模型时清空、CSV/JSON输出):
+//   pio test -e native -f test_op_profile
+
+namespace {
+    std::vector<std::string> lines;
+
+    void collect(const char* line) {
+        lines.push_back(line);
+    }
+
+    // 模拟一次推理: 每个算子依次执行 durations[i] 微秒
+    void run(OpProfile& profile, const char* const* tags, const uint32_t* durations, int count, uint32_t startUs) {
+        profile.beginRun();
+        uint32_t now = startUs;
+        for (int i = 0; i < count; i++) {
+            uint32_t handle = profile.beginOp(tags[i], now);
+            now += durations[i];
+            profile.endOp(handle, now);
+        }
+        profile.endRun();
+    }
+
+    const char* const kTags[] = { "FULLY_CONNECTED", "RELU", "FULLY_CONNECTED" };
+}
+
+void setUp(void) {
+    lines.clear();
+}
+
+void tearDown(void) {
+}
+
+void test_accumulates_per_op_statistics(void) {
+    OpProfile profile;
+    const uint32_t first[] = { 100, 10, 40 };
+    const uint32_t second[] = { 300, 20, 40 };
+    run(profile, kTags, first, 3, 0);
+    run(profile, kTags, second, 3, 0xFFFFFF00u); // micros() 回绕也不影响
+
+    TEST_ASSERT_EQUAL_UINT32(2, profile.getRunCount());
+    TEST_ASSERT_EQUAL_INT(3, profile.getOpCount());
+    const OpProfile::OpStats& fc = profile.getOp(0);
+    TEST_ASSERT_EQUAL_STRING("FULLY_CONNECTED", fc.tag);
+    TEST_ASSERT_EQUAL_UINT32(300, fc.lastUs);
+    TEST_ASSERT_EQUAL_UINT32(100, fc.minUs);
+    TEST_ASSERT_EQUAL_UINT32(300, fc.maxUs);
+    TEST_ASSERT_EQUAL_UINT32(400, (uint32_t)fc.totalUs);
+    TEST_ASSERT_EQUAL_UINT32(20, profile.getOp(1).lastUs);
+    TEST_ASSERT_EQUAL_UINT32(360, profile.getLastRunUs());
+}
+
+void test_different_graph_resets_statistics(void) {
+    OpProfile profile;
+    const uint32_t durations[] = { 100, 10, 40 };
+    run(profile, kTags, durations, 3, 0);
+    run(profile, kTags, durations, 3, 0);
+
+    const char* const otherTags[] = { "CONV_2D", "FULLY_CONNECTED" };
+    const uint32_t other[] = { 500, 50 };
+    run(profile, otherTags, other, 2, 0);
+
+    TEST_ASSERT_EQUAL_UINT32(1, profile.getRunCount());
+    TEST_ASSERT_EQUAL_INT(2, profile.getOpCount());
+    TEST_ASSERT_EQUAL_STRING("CONV_2D", profile.getOp(0).tag);
+    TEST_ASSERT_EQUAL_UINT32(500, profile.getOp(0).minUs);
+}
+
+void test_ops_beyond_capacity_are_ignored(void) {
+    OpProfile profile;
+    profile.beginRun();
+    for (int i = 0; i < OpProfile::kMaxOps; i++) {
+        profile.endOp(profile.beginOp("ADD", 0), 1);
+    }
+    uint32_t handle = profile.beginOp("ADD", 0);
+    TEST_ASSERT_EQUAL_UINT32(OpProfile::kInvalidHandle, handle);
+    profile.endOp(handle, 5);
+    profile.endRun();
+    TEST_ASSERT_EQUAL_INT(OpProfile::kMaxOps, profile.getOpCount());
+    TEST_ASSERT_EQUAL_UINT32(OpProfile::kMaxOps, profile.getLastRunUs());
+}
+
+void test_csv_output(void) {
+    OpProfile profile;
+    const uint32_t durations[] = { 150, 10, 40 };
+    run(profile, kTags, durations, 3, 0);
+    profile.writeCsv(collect);
+
+    TEST_ASSERT_EQUAL_INT(4, (int)lines.size());
+    TEST_ASSERT_EQUAL_STRING("index,op,last_us,avg_us,min_us,max_us,share_pct", lines[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("0,FULLY_CONNECTED,150,150,150,150,75.0", lines[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("1,RELU,10,10,10,10,5.0", lines[2].c_str());
+}
+
+void test_json_output(void) {
+    OpProfile profile;
+    const uint32_t durations[] = { 150, 10, 40 };
+    run(profile, kTags, durations, 3, 0);
+    profile.writeJson(collect, 3000, 4096);
+
+    std::string json;
+    for (size_t i = 0; i < lines.size(); i++) json += lines[i];
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"runs\":1,\"last_us\":200,\"avg_us\":200,\"arena_used\":3000,\"arena_size\":4096,\"ops\":["
+        "{\"op\":\"FULLY_CONNECTED\",\"last_us\":150,\"avg_us\":150,\"min_us\":150,\"max_us\":150},"
+        "{\"op\":\"RELU\",\"last_us\":10,\"avg_us\":10,\"min_us\":10,\"max_us\":10},"
+        "{\"op\":\"FULLY_CONNECTED\",\"last_us\":40,\"avg_us\":40,\"min_us\":40,\"max_us\":40}"
+        "]}", json.c_str());
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_accumulates_per_op_statistics);
+    RUN_TEST(test_different_graph_resets_statistics);
+    RUN_TEST(test_ops_beyond_capacity_are_ignored);
+    RUN_TEST(test_csv_output);
+    RUN_TEST(test_json_output);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,165 @@
+#include <unity.h>
+#include <stdint.h>
+#include <PredictionCurve.h>
+#include <Quantization.h>
+
+// 多步预测曲线的取出与BLE打包测试。用数组代替模型输出张量 (stub model):
+//   pio test -e native -f test_prediction_curve
+
+using namespace PredictionCurve;
+
+namespace {
+    constexpr int kHorizon = 12;        // 5分钟一步，预测未来60分钟
+    constexpr uint8_t kStepMinutes = 5;
+    constexpr int kMaxCurve = 16;
+
+    // stub model: 一次 Invoke() 后输出张量中的 N 步预测
+    float stub_float_output[kHorizon];
+    int8_t stub_int8_output[kHorizon];
+    constexpr float kOutScale = 400.0f / 255.0f;
+    constexpr int32_t kOutZeroPoint = -128;
+
+    void stubInvoke(float start, float slopePerStep) {
+        for (int i = 0; i < kHorizon; i++) {
+            stub_float_output[i] = start + slopePerStep * (i + 1);
+            stub_int8_output[i] = Quantization::quantizeInt8(stub_float_output[i], kOutScale, kOutZeroPoint);
+        }
+    }
+}
+
+void setUp(void) {
+    stubInvoke(110.0f, 2.5f);
+}
+
+void tearDown(void) {
+}
+
+void test_float_output_is_zero_copy(void) {
+    float buffer[kMaxCurve];
+    Curve c = fromOutput(stub_float_output, kHorizon, false, 0.0f, 0, buffer, kMaxCurve);
+    TEST_ASSERT_EQUAL_INT(kHorizon, c.size);
+    TEST_ASSERT_TRUE(c.data == stub_float_output);
+
+    // 下一次推理的结果直接反映在视图中
+    stubInvoke(90.0f, -1.0f);
+    TEST_ASSERT_EQUAL_FLOAT(89.0f, c.data[0]);
+}
+
+void test_int8_output_is_dequantized(void) {
+    float buffer[kMaxCurve];
+    Curve c = fromOutput(stub_int8_output, kHorizon, true, kOutScale, kOutZeroPoint, buffer, kMaxCurve);
+    TEST_ASSERT_EQUAL_INT(kHorizon, c.size);
+    TEST_ASSERT_TRUE(c.data == buffer);
+    for (int i = 0; i < kHorizon; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(kOutScale * 0.5f + 1e-4f, stub_float_output[i], c.data[i]);
+    }
+}
+
+void test_single_output_model_and_truncation(void) {
+    float buffer[kMaxCurve];
+    Curve c = fromOutput(stub_float_output, 1, false, 0.0f, 0, buffer, kMaxCurve);
+    TEST_ASSERT_EQUAL_INT(1, c.size);
+
+    c = fromOutput(stub_float_output, kHorizon, false, 0.0f, 0, buffer, 4);
+    TEST_ASSERT_EQUAL_INT(4, c.size);
+
+    c = fromOutput(nullptr, kHorizon, false, 0.0f, 0, buffer, kMaxCurve);
+    TEST_ASSERT_EQUAL_INT(0, c.size);
+}
+
+void test_packet_round_trip(void) {
+    float buffer[kMaxCurve];
+    Curve c = fromOutput(stub_float_output, kHorizon, false, 0.0f, 0, buffer, kMaxCurve);
+
+    uint8_t packet[64];
+    size_t len = encodePacket(c, kStepMinutes, packet, sizeof(packet));
+    TEST_ASSERT_EQUAL_size_t(packetSize(kHorizon), len);
+    TEST_ASSERT_EQUAL_size_t(28, len); // 一次通知即可发送完整的60分钟曲线
+
+    float values[kMaxCurve];
+    uint8_t step = 0;
+    TEST_ASSERT_EQUAL_INT(kHorizon, decodePacket(packet, len, &step, values, kMaxCurve));
+    TEST_ASSERT_EQUAL_UINT8(kStepMinutes, step);
+    for (int i = 0; i < kHorizon; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.05f + 1e-4f, stub_float_output[i], values[i]);
+    }
+}
+
+void test_packet_with_interval(void) {
+    float buffer[kMaxCurve];
+    Curve c = fromOutput(stub_float_output, kHorizon, false, 0.0f, 0, buffer, kMaxCurve);
+    float lower[kHorizon], upper[kHorizon];
+    for (int i = 0; i < kHorizon; i++) {
+        lower[i] = stub_float_output[i] - 3.0f - i;
+        upper[i] = stub_float_output[i] + 3.0f + i;
+    }
+
+    uint8_t packet[96];
+    size_t len = encodePacket(c, kStepMinutes, packet, sizeof(packet), lower, upper);
+    TEST_ASSERT_EQUAL_size_t(76, len);
+    TEST_ASSERT_EQUAL_HEX8(kFlagInterval, packet[3]);
+
+    float values[kMaxCurve], lo[kMaxCurve], hi[kMaxCurve];
+    uint8_t step = 0;
+    bool hasInterval = false;
+    TEST_ASSERT_EQUAL_INT(kHorizon, decodePacket(packet, len, &step, values, kMaxCurve, lo, hi, &hasInterval));
+    TEST_ASSERT_TRUE(hasInterval);
+    for (int i = 0; i < kHorizon; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.05f + 1e-4f, stub_float_output[i], values[i]);
+        TEST_ASSERT_FLOAT_WITHIN(0.05f + 1e-4f, lower[i], lo[i]);
+        TEST_ASSERT_FLOAT_WITHIN(0.05f + 1e-4f, upper[i], hi[i]);
+    }
+
+    // 只关心曲线的解码方也能读取带区间的包
+    TEST_ASSERT_EQUAL_INT(kHorizon, decodePacket(packet, len, &step, values, kMaxCurve));
+    // 没有区间的包长度不变
+    TEST_ASSERT_EQUAL_size_t(28, encodePacket(c, kStepMinutes, packet, sizeof(packet)));
+    TEST_ASSERT_EQUAL_INT(kHorizon, decodePacket(packet, 28, &step, values, kMaxCurve, lo, hi, &hasInterval));
+    TEST_ASSERT_FALSE(hasInterval);
+}
+
+void test_packet_rejects_bad_input(void) {
+    float curve_data[2] = { 5000.0f, -5000.0f };
+    Curve c = { curve_data, 2 };
+    uint8_t packet[8];
+
+    // 容量不足
+    TEST_ASSERT_EQUAL_size_t(0, encodePacket(c, kStepMinutes, packet, 7));
+
+    // 超出 int16 范围的值饱和
+    size_t len = encodePacket(c, kStepMinutes, packet, sizeof(packet));
+    float values[2];
+    uint8_t step;
+    TEST_ASSERT_EQUAL_INT(2, decodePacket(packet, len, &step, values, 2));
+    TEST_ASSERT_EQUAL_FLOAT(3276.7f, values[0]);
+    TEST_ASSERT_EQUAL_FLOAT(-3276.8f, values[1]);
+
+    // 长度与点数不符、版本错误
+    TEST_ASSERT_EQUAL_INT(-1, decodePacket(packet, len - 1, &step, values, 2));
+    packet[0] = 0x7F;
+    TEST_ASSERT_EQUAL_INT(-1, decodePacket(packet, len, &step, values, 2));
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_float_output_is_zero_copy);
+    RUN_TEST(test_int8_output_is_dequantized);
+    RUN_TEST(test_single_output_model_and_truncation);
+    RUN_TEST(test_packet_round_trip);
+    RUN_TEST(test_packet_with_interval);
+    RUN_TEST(test_packet_rejects_bad_input);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,332 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <MpmcQueue.h>
+#include <BlePeripheral.h>
+
+// 无锁发布队列与BLE任务的多线程测试。在主机上用 std::thread 模拟多个生产者任务与协议栈的任务，
+// 应在 ThreadSanitizer 下运行以检查数据竞争:
+//   pio test -e native-tsan -f test_publish_queue
+// 不带 TSan 也可以运行:
+//   pio test -e native -f test_publish_queue
+
+namespace {
+    struct Item {
+        uint32_t producer;
+        uint32_t sequence;
+    };
+
+    // 可从多个线程调用的假传输层
+    class FakeTransport : public BleTransport {
+    public:
+        Listener* listener = nullptr;
+        std::atomic<bool> connected;
+        std::atomic<int> advertisingStarts;
+
+        FakeTransport() : connected(false), advertisingStarts(0) {
+            memset(notifications, 0, sizeof(notifications));
+            memset(lastRacp, 0, sizeof(lastRacp));
+        }
+
+        bool begin(const char*, uint16_t, Listener* l) override {
+            listener = l;
+            return true;
+        }
+
+        bool isConnected() const override {
+            return connected;
+        }
+
+        void setValue(Characteristic, const uint8_t*, size_t) override {}
+
+        void startAdvertising() override {
+            advertisingStarts++;
+        }
+
+        bool send(Characteristic c, const uint8_t* data, size_t length) override {
+            if (!connected) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            notifications[(int)c]++;
+            if (c == Characteristic::RACP && length <= sizeof(lastRacp)) {
+                memcpy(lastRacp, data, length);
+            }
+            return true;
+        }
+
+        const char* name() const override {
+            return "Fake";
+        }
+
+        int sent(Characteristic c) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return notifications[(int)c];
+        }
+
+        std::mutex mutex;
+        int notifications[GattSink::kCharacteristicCount];
+        uint8_t lastRacp[8];
+    };
+
+    BlePeripheral::Config config() {
+        BlePeripheral::Config c;
+        c.compositeNotifications = true;
+        c.textValues = false;
+        c.recordsPerPoll = 32;
+        c.maxCurvePoints = 12;
+        c.vitals.glucoseDeadband = 1.0f;
+        c.vitals.heartRateDeadband = 1.0f;
+        c.vitals.spO2Deadband = 0.5f;
+        c.vitals.curveDeadband = 2.0f;
+        c.vitals.minIntervalMs = 0;
+        c.vitals.maxSilenceMs = 30000;
+        c.vitals.curveStepMinutes = 5;
+        c.ppgPeriodMs = 10;
+        c.waveformFramesPerPoll = 8;
+        return c;
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_queue_is_fifo_and_rejects_when_full(void) {
+    MpmcQueue<int, 4> q;
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(q.tryPush(i));
+    }
+    TEST_ASSERT_FALSE(q.tryPush(99));
+    TEST_ASSERT_EQUAL_UINT32(1, q.droppedCount());
+    TEST_ASSERT_EQUAL_UINT32(4, q.size());
+    TEST_ASSERT_EQUAL_UINT32(4, q.highWaterMark());
+
+    int v;
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(q.tryPop(&v));
+        TEST_ASSERT_EQUAL_INT(i, v);
+    }
+    TEST_ASSERT_FALSE(q.tryPop(&v));
+
+    // 回绕后仍然可用，高水位保留
+    TEST_ASSERT_TRUE(q.tryPush(5));
+    TEST_ASSERT_TRUE(q.tryPop(&v));
+    TEST_ASSERT_EQUAL_INT(5, v);
+    TEST_ASSERT_EQUAL_UINT32(4, q.highWaterMark());
+}
+
+void test_queue_concurrent_producers_and_consumers(void) {
+    const int kProducers = 4;
+    const int kConsumers = 2;
+    const uint32_t kPerProducer = 20000;
+    MpmcQueue<Item, 64> q;
+    std::atomic<bool> producing(true);
+    std::vector<Item> received[kConsumers];
+
+    std::vector<std::thread> threads;
+    for (int c = 0; c < kConsumers; c++) {
+        threads.push_back(std::thread([&q, &producing, &received, c] {
+            Item item;
+            while (true) {
+                if (q.tryPop(&item)) {
+                    received[c].push_back(item);
+                } else if (!producing) {
+                    // 生产者结束后再排空一次
+                    while (q.tryPop(&item)) {
+                        received[c].push_back(item);
+                    }
+                    break;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.push_back(std::thread([&q, p, kPerProducer] {
+            for (uint32_t i = 0; i < kPerProducer; i++) {
+                Item item = { (uint32_t)p, i };
+                while (!q.tryPush(item)) {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < producers.size(); i++) {
+        producers[i].join();
+    }
+    producing = false;
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    // 每个元素恰好被取出一次，同一消费者看到的同一生产者的元素保持顺序
+    std::vector<uint8_t> seen(kProducers * kPerProducer, 0);
+    size_t total = 0;
+    for (int c = 0; c < kConsumers; c++) {
+        uint32_t last[kProducers];
+        bool hasLast[kProducers] = { false };
+        for (size_t i = 0; i < received[c].size(); i++) {
+            const Item& item = received[c][i];
+            TEST_ASSERT_TRUE(item.producer < (uint32_t)kProducers && item.sequence < kPerProducer);
+            if (hasLast[item.producer]) {
+                TEST_ASSERT_TRUE(item.sequence > last[item.producer]);
+            }
+            last[item.producer] = item.sequence;
+            hasLast[item.producer] = true;
+            seen[item.producer * kPerProducer + item.sequence]++;
+        }
+        total += received[c].size();
+    }
+    TEST_ASSERT_EQUAL_UINT32(kProducers * kPerProducer, total);
+    for (size_t i = 0; i < seen.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT8(1, seen[i]);
+    }
+    TEST_ASSERT_TRUE(q.highWaterMark() <= q.capacity());
+
+    char message[96];
+    snprintf(message, sizeof(message), "high water %u/%u, full retries %u",
+             (unsigned)q.highWaterMark(), (unsigned)q.capacity(), (unsigned)q.droppedCount());
+    TEST_MESSAGE(message);
+}
+
+void test_event_overflow_resyncs_connection(void) {
+    FakeTransport transport;
+    BlePeripheral p(transport, config());
+    p.begin("test", 96);
+
+    // poll() 之前协议栈产生的事件多于队列深度: 丢失的事件由连接状态重新同步
+    transport.connected = true;
+    transport.listener->onConnect(30);
+    for (int i = 0; i < 20; i++) {
+        transport.listener->onMtuChanged((uint16_t)(30 + i));
+    }
+    p.updateGlucose(100.0f, 0);
+    p.poll(0, 0);
+
+    BlePeripheral::QueueStats stats = p.getQueueStats();
+    TEST_ASSERT_EQUAL_UINT32(BlePeripheral::kEventQueueDepth, stats.eventHighWater);
+    TEST_ASSERT_EQUAL_UINT32(21 - BlePeripheral::kEventQueueDepth, stats.eventDropped);
+    TEST_ASSERT_EQUAL_INT(1, transport.sent(GattSink::Characteristic::VITALS));
+
+    // 断开事件丢失时同样按断开处理并重新开始广播
+    transport.connected = false;
+    for (int i = 0; i < 20; i++) {
+        transport.listener->onMtuChanged(23);
+    }
+    transport.listener->onDisconnect();
+    p.poll(100, 0);
+    TEST_ASSERT_EQUAL_INT(1, transport.advertisingStarts.load());
+}
+
+void test_peripheral_with_concurrent_producers(void) {
+    const int kProducers = 3;
+    const int kRecordsPerProducer = 100;
+    const int kValuesPerProducer = 2000;
+    FakeTransport transport;
+    BlePeripheral p(transport, config());
+    p.begin("test", 96);
+    transport.connected = true;
+    transport.listener->onConnect(30);
+    uint8_t enable = BlePeripheral::WAVEFORM_PPG | BlePeripheral::WAVEFORM_OPTICAL;
+    transport.listener->onWrite(GattSink::Characteristic::WAVEFORM, &enable, 1);
+
+    TEST_ASSERT_TRUE(p.start(-1, 8192, 1, 1));
+    TEST_ASSERT_TRUE(p.isRunning());
+
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> valuesPosted(0);
+    for (int t = 0; t < kProducers; t++) {
+        threads.push_back(std::thread([&p, &valuesPosted, t, kRecordsPerProducer, kValuesPerProducer] {
+            for (int i = 0; i < kValuesPerProducer; i++) {
+                float value = 90.0f + (float)((i + t) % 40);
+                if (p.updateGlucose(value, i) && p.updateHeartRate(60.0f + (float)(i % 30), i)) {
+                    valuesPosted++;
+                }
+                if (i % 50 == 0) {
+                    float curve[12];
+                    for (int k = 0; k < 12; k++) curve[k] = value + k;
+                    p.updatePredictionCurve(curve, 12, nullptr, nullptr);
+                }
+                if (i < kRecordsPerProducer) {
+                    // 历史记录不能丢: 队列满时重试
+                    while (!p.addGlucoseRecord(1700000000 + t * 1000 + i, value)) {
+                        std::this_thread::yield();
+                    }
+                }
+                p.addPpgSample(120000 + i, 95000 - i, i * 10);
+                p.addOpticalSample((uint16_t)(2048 + i % 100), i * 10);
+            }
+        }));
+    }
+    // 协议栈的任务: MTU 变化、断开与重新连接
+    threads.push_back(std::thread([&transport, enable] {
+        for (int i = 0; i < 20; i++) {
+            transport.listener->onMtuChanged((uint16_t)(64 + i * 8));
+            std::this_thread::yield();
+            transport.connected = false;
+            transport.listener->onDisconnect();
+            transport.connected = true;
+            transport.listener->onConnect(30);
+            transport.listener->onWrite(GattSink::Characteristic::WAVEFORM, &enable, 1);
+        }
+    }));
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    p.stop();
+    TEST_ASSERT_FALSE(p.isRunning());
+
+    // 任务停止后在本线程中排空队列，并通过 RACP 确认所有记录都已写入
+    p.poll(100000, 0);
+    uint8_t racp[2] = { GlucoseService::OP_REPORT_NUMBER, GlucoseService::OPERATOR_ALL };
+    transport.listener->onWrite(GattSink::Characteristic::RACP, racp, sizeof(racp));
+    p.poll(100001, 0);
+    TEST_ASSERT_EQUAL_HEX8(GlucoseService::OP_NUMBER_RESPONSE, transport.lastRacp[0]);
+    uint16_t records = (uint16_t)(transport.lastRacp[2] | (transport.lastRacp[3] << 8));
+    TEST_ASSERT_EQUAL_UINT16(kProducers * kRecordsPerProducer, records);
+
+    BlePeripheral::QueueStats stats = p.getQueueStats();
+    TEST_ASSERT_TRUE(stats.publishHighWater > 0 && stats.publishHighWater <= BlePeripheral::kPublishQueueDepth);
+    TEST_ASSERT_TRUE(stats.sampleHighWater <= BlePeripheral::kSampleQueueDepth);
+    TEST_ASSERT_TRUE(stats.eventHighWater <= BlePeripheral::kEventQueueDepth);
+    TEST_ASSERT_TRUE(valuesPosted.load() > 0);
+    // 每个断开事件要么由BLE任务处理 (重新开始广播)，要么因队列满而计入丢弃
+    TEST_ASSERT_TRUE(transport.advertisingStarts.load() + (int)stats.eventDropped >= 20);
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "publish high water %u/%u (dropped %u), samples %u/%u (dropped %u), events %u/%u (dropped %u)",
+             (unsigned)stats.publishHighWater, (unsigned)BlePeripheral::kPublishQueueDepth, (unsigned)stats.publishDropped,
+             (unsigned)stats.sampleHighWater, (unsigned)BlePeripheral::kSampleQueueDepth, (unsigned)stats.sampleDropped,
+             (unsigned)stats.eventHighWater, (unsigned)BlePeripheral::kEventQueueDepth, (unsigned)stats.eventDropped);
+    TEST_MESSAGE(message);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_queue_is_fifo_and_rejects_when_full);
+    RUN_TEST(test_queue_concurrent_producers_and_consumers);
+    RUN_TEST(test_event_overflow_resyncs_connection);
+    RUN_TEST(test_peripheral_with_concurrent_producers);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,65 @@
+#include <unity.h>
+#include <Quantization.h>
+
+// int8 量化/反量化换算的测试 (与TFLite的仿射量化约定一致):
+//   pio test -e native -f test_quantization
+
+using namespace Quantization;
+
+namespace {
+    // 典型的血糖输入量化参数: 覆盖 [0, 400] mg/dL (TFLite要求量化范围包含0)
+    constexpr float kScale = 400.0f / 255.0f;
+    constexpr int32_t kZeroPoint = -128;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_round_trip_within_half_step(void) {
+    for (float v = 0.0f; v <= 400.0f; v += 0.37f) {
+        float back = dequantizeInt8(quantizeInt8(v, kScale, kZeroPoint), kScale, kZeroPoint);
+        TEST_ASSERT_FLOAT_WITHIN(kScale * 0.5f + 1e-4f, v, back);
+    }
+}
+
+void test_zero_point_maps_to_zero(void) {
+    TEST_ASSERT_EQUAL_INT8(-128, quantizeInt8(0.0f, kScale, kZeroPoint));
+    TEST_ASSERT_EQUAL_INT8(5, quantizeInt8(0.0f, 0.1f, 5));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, dequantizeInt8(5, 0.1f, 5));
+}
+
+void test_rounds_to_nearest(void) {
+    TEST_ASSERT_EQUAL_INT8(3, quantizeInt8(0.26f, 0.1f, 0));
+    TEST_ASSERT_EQUAL_INT8(2, quantizeInt8(0.24f, 0.1f, 0));
+    TEST_ASSERT_EQUAL_INT8(-3, quantizeInt8(-0.26f, 0.1f, 0));
+}
+
+void test_saturates_out_of_range(void) {
+    TEST_ASSERT_EQUAL_INT8(127, quantizeInt8(1000.0f, kScale, kZeroPoint));
+    TEST_ASSERT_EQUAL_INT8(-128, quantizeInt8(-1000.0f, kScale, kZeroPoint));
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_within_half_step);
+    RUN_TEST(test_zero_point_maps_to_zero);
+    RUN_TEST(test_rounds_to_nearest);
+    RUN_TEST(test_saturates_out_of_range);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
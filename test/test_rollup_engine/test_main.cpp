@@ -0,0 +1,227 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <RollupEngine.h>
+
+// 分层降采样的测试: 与逐个读数的暴力聚合比较 min/max/mean/count，检查环形覆盖、时间查询与 BLE 页的编码:
+//   pio test -e native -f test_rollup_engine
+
+namespace {
+    constexpr int kMaxReadings = 200000;
+    uint32_t timestamps[kMaxReadings];
+    float glucose[kMaxReadings];
+    int readingCount = 0;
+
+    uint32_t seed;
+    float noise() {
+        seed = seed * 1103515245u + 12345u;
+        return ((seed >> 16) & 0x7FFF) / 32767.0f - 0.5f;
+    }
+
+    // 2秒一次的读数，带随机的间隔抖动与长时间的缺口 (手指离开、设备关机)
+    void makeReadings(int count, uint32_t start) {
+        seed = 7;
+        uint32_t t = start;
+        for (int i = 0; i < count; i++) {
+            t += 2 + (noise() > 0.45f ? 3 : 0);
+            if (i % 5000 == 4999) {
+                t += 4 * 3600;
+            }
+            timestamps[i] = t;
+            glucose[i] = 120.0f + 40.0f * sinf(i / 2000.0f) + noise() * 6.0f;
+        }
+        readingCount = count;
+    }
+
+    // 暴力聚合: 扫描全部读数得到 [start, start + period) 内的统计
+    bool bruteForce(uint32_t start, uint32_t period, RollupEngine::Rollup* out) {
+        int count = 0;
+        double sum = 0.0;
+        float min = 0.0f;
+        float max = 0.0f;
+        for (int i = 0; i < readingCount; i++) {
+            if (timestamps[i] < start || timestamps[i] - start >= period) {
+                continue;
+            }
+            if (count == 0 || glucose[i] < min) min = glucose[i];
+            if (count == 0 || glucose[i] > max) max = glucose[i];
+            sum += glucose[i];
+            count++;
+        }
+        out->start = start;
+        out->count = (uint16_t)count;
+        out->min = min;
+        out->max = max;
+        out->mean = count > 0 ? (float)(sum / count) : 0.0f;
+        return count > 0;
+    }
+
+    void checkTier(RollupEngine& engine, RollupEngine::Tier tier, int capacity) {
+        static RollupEngine::Rollup rollups[1000];
+        uint32_t period = RollupEngine::period(tier);
+        int n = engine.query(tier, 0, 0xFFFFFFFF, rollups, 1000);
+        TEST_ASSERT_EQUAL_INT(engine.count(tier), n);
+        TEST_ASSERT_TRUE(n <= capacity + 1);
+
+        // 每一档都与暴力聚合一致 (0.1 mg/dL 的量化误差)
+        for (int i = 0; i < n; i++) {
+            RollupEngine::Rollup expected;
+            TEST_ASSERT_EQUAL_UINT32(0, rollups[i].start % period);
+            TEST_ASSERT_TRUE(bruteForce(rollups[i].start, period, &expected));
+            TEST_ASSERT_EQUAL_UINT16(expected.count, rollups[i].count);
+            TEST_ASSERT_FLOAT_WITHIN(0.051f, expected.min, rollups[i].min);
+            TEST_ASSERT_FLOAT_WITHIN(0.051f, expected.max, rollups[i].max);
+            TEST_ASSERT_FLOAT_WITHIN(0.06f, expected.mean, rollups[i].mean);
+            if (i > 0) {
+                TEST_ASSERT_TRUE(rollups[i].start > rollups[i - 1].start);
+            }
+        }
+        // 保留的是最新的档: 最后一档包含最后一个读数，且比最旧一档更新的有读数的档都在
+        TEST_ASSERT_EQUAL_UINT32(timestamps[readingCount - 1] - timestamps[readingCount - 1] % period, rollups[n - 1].start);
+        int expectedCount = 0;
+        uint32_t last = 0xFFFFFFFF;
+        for (int i = 0; i < readingCount; i++) {
+            uint32_t start = timestamps[i] - timestamps[i] % period;
+            if (start >= rollups[0].start && start != last) {
+                expectedCount++;
+                last = start;
+            }
+        }
+        TEST_ASSERT_EQUAL_INT(expectedCount, n);
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_tiers_match_brute_force(void) {
+    static RollupEngine engine;
+    engine.clear();
+    // 约9天的读数 (含缺口)，各层都已回绕
+    makeReadings(kMaxReadings / 2, 1700000000);
+    for (int i = 0; i < readingCount; i++) {
+        engine.add(timestamps[i], glucose[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(RollupEngine::kMinuteBuckets + 1, engine.count(RollupEngine::MINUTE));
+    TEST_ASSERT_EQUAL_INT(RollupEngine::kFiveMinuteBuckets + 1, engine.count(RollupEngine::FIVE_MINUTES));
+    TEST_ASSERT_EQUAL_INT(RollupEngine::kHourBuckets + 1, engine.count(RollupEngine::HOUR));
+    checkTier(engine, RollupEngine::MINUTE, RollupEngine::kMinuteBuckets);
+    checkTier(engine, RollupEngine::FIVE_MINUTES, RollupEngine::kFiveMinuteBuckets);
+    checkTier(engine, RollupEngine::HOUR, RollupEngine::kHourBuckets);
+}
+
+void test_hour_ring_overwrites_oldest(void) {
+    static RollupEngine engine;
+    engine.clear();
+    // 每小时一个读数，超过小时层的容量
+    const int hours = RollupEngine::kHourBuckets + 50;
+    for (int h = 0; h < hours; h++) {
+        engine.add(1700002800 + h * 3600, 100.0f + h % 7);
+    }
+    RollupEngine::Rollup rollups[4];
+    TEST_ASSERT_EQUAL_INT(RollupEngine::kHourBuckets + 1, engine.count(RollupEngine::HOUR));
+    // 最旧的50档已被覆盖
+    TEST_ASSERT_EQUAL_INT(1, engine.query(RollupEngine::HOUR, 0, 1700002800 + 50 * 3600 - 1, rollups, 4));
+    TEST_ASSERT_EQUAL_UINT32(1700002800 + 50 * 3600 - 3600, rollups[0].start);
+}
+
+void test_query_touches_only_the_range(void) {
+    static RollupEngine engine;
+    engine.clear();
+    makeReadings(40000, 1700000000);
+    for (int i = 0; i < readingCount; i++) {
+        engine.add(timestamps[i], glucose[i]);
+    }
+    // 一天的趋势: 1小时层最多24~25档，而不是约3万个读数
+    uint32_t to = timestamps[readingCount - 1];
+    uint32_t from = to - 86400;
+    RollupEngine::Rollup rollups[64];
+    int n = engine.query(RollupEngine::HOUR, from, to, rollups, 64);
+    int readings = 0;
+    for (int i = 0; i < readingCount; i++) {
+        if (timestamps[i] >= from && timestamps[i] <= to) readings++;
+    }
+    TEST_ASSERT_TRUE(n > 0 && n <= 25);
+    // 与范围相交的档: 第一档包含 from 或在其后，最后一档不晚于 to
+    TEST_ASSERT_TRUE(rollups[0].start + 3600 > from);
+    TEST_ASSERT_TRUE(rollups[n - 1].start <= to);
+    char line[96];
+    snprintf(line, sizeof(line), "24 h query: %d hour rollups instead of %d readings", n, readings);
+    TEST_MESSAGE(line);
+
+    // 范围之外没有档
+    TEST_ASSERT_EQUAL_INT(0, engine.query(RollupEngine::HOUR, to + 3600, 0xFFFFFFFF, rollups, 64));
+    TEST_ASSERT_EQUAL_INT(0, engine.query(RollupEngine::MINUTE, 0, 1000, rollups, 64));
+}
+
+void test_nan_and_clock_going_back(void) {
+    static RollupEngine engine;
+    engine.clear();
+    engine.add(6000, 100.0f);
+    engine.add(6010, NAN);
+    engine.add(6020, 110.0f);
+    // 早于当前一档的读数并入当前一档
+    engine.add(100, 90.0f);
+    RollupEngine::Rollup rollups[4];
+    TEST_ASSERT_EQUAL_INT(1, engine.query(RollupEngine::MINUTE, 0, 0xFFFFFFFF, rollups, 4));
+    TEST_ASSERT_EQUAL_UINT32(6000, rollups[0].start);
+    TEST_ASSERT_EQUAL_UINT16(3, rollups[0].count);
+    TEST_ASSERT_EQUAL_FLOAT(90.0f, rollups[0].min);
+    TEST_ASSERT_EQUAL_FLOAT(110.0f, rollups[0].max);
+    TEST_ASSERT_EQUAL_FLOAT(100.0f, rollups[0].mean);
+}
+
+void test_page_encoding(void) {
+    static RollupEngine engine;
+    engine.clear();
+    uint8_t page[RollupEngine::kMaxPageSize];
+    TEST_ASSERT_EQUAL_size_t(RollupEngine::kPageHeaderSize, engine.encodePage(RollupEngine::MINUTE, 0, true, page, sizeof(page)));
+    TEST_ASSERT_EQUAL_UINT8(0, page[1]);
+
+    for (int i = 0; i < 100 * 30; i++) {
+        engine.add(1700000040 + i * 2, 100.0f + (i / 30) * 0.5f);
+    }
+    // 最新的一页: 最后 kMaxPageEntries 档
+    size_t length = engine.encodePage(RollupEngine::MINUTE, 0, true, page, sizeof(page));
+    TEST_ASSERT_EQUAL_size_t(RollupEngine::kMaxPageSize, length);
+    TEST_ASSERT_EQUAL_UINT8(RollupEngine::kMaxPageEntries, page[1]);
+    TEST_ASSERT_EQUAL_UINT16(60, page[2] | (page[3] << 8));
+    const uint8_t* last = page + RollupEngine::kPageHeaderSize + (RollupEngine::kMaxPageEntries - 1) * RollupEngine::kPageEntrySize;
+    TEST_ASSERT_EQUAL_UINT32(1700000040 + 99 * 60, last[0] | (last[1] << 8) | (last[2] << 16) | ((uint32_t)last[3] << 24));
+    TEST_ASSERT_EQUAL_UINT16(30, last[4] | (last[5] << 8));
+    TEST_ASSERT_EQUAL_UINT16(1495, last[10] | (last[11] << 8));
+
+    // 从 from 开始、受 capacity 限制的一页
+    length = engine.encodePage(RollupEngine::MINUTE, 1700000040 + 10 * 60 + 5, false, page, 4 + 3 * 12 + 5);
+    TEST_ASSERT_EQUAL_size_t(4 + 3 * 12, length);
+    TEST_ASSERT_EQUAL_UINT8(3, page[1]);
+    TEST_ASSERT_EQUAL_UINT32(1700000040 + 10 * 60, page[4] | (page[5] << 8) | (page[6] << 16) | ((uint32_t)page[7] << 24));
+    TEST_ASSERT_EQUAL_size_t(0, engine.encodePage(RollupEngine::MINUTE, 0, true, page, 3));
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_tiers_match_brute_force);
+    RUN_TEST(test_hour_ring_overwrites_oldest);
+    RUN_TEST(test_query_touches_only_the_range);
+    RUN_TEST(test_nan_and_clock_going_back);
+    RUN_TEST(test_page_encoding);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
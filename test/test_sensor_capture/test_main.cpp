@@ -0,0 +1,206 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <FilePartition.h>
+#include <TimeSeriesStore.h>
+#include <SensorCapture.h>
+
+// 原始传感器录制格式的测试: 逐位往返、会话、调用顺序不一致与掉电:
+//   pio test -e native -f test_sensor_capture
+// 整个固件录制后回放的输出比较见 test_simulation_replay。
+
+namespace {
+    const char* kImagePath = "test_sensor_capture.bin";
+    const uint32_t kPartitionSize = 64 * FlashPartition::kSectorSize;
+    const size_t kBlockSize = 1004;
+}
+
+void setUp(void) {
+    remove(kImagePath);
+}
+
+void tearDown(void) {
+    remove(kImagePath);
+}
+
+void test_round_trip_is_bit_exact(void) {
+    FilePartition part(kImagePath, kPartitionSize);
+    TEST_ASSERT_TRUE(part.open());
+    TimeSeriesStore store(part);
+    TEST_ASSERT_TRUE(store.begin());
+    SensorCapture capture(store, kBlockSize);
+
+    // 含回绕的大跨度FIFO值、满量程的ADC、NAN 与 -0 的DHT读数，跨越很多块
+    TEST_ASSERT_TRUE(capture.startCapture(1000));
+    uint32_t ir[40], red[40];
+    uint16_t adc[100];
+    for (int round = 0; round < 200; round++) {
+        for (int i = 0; i < 40; i++) {
+            ir[i] = (round * 40 + i) % 7 == 0 ? 0xFFFFFFF0u + i : 100000u + round * 13 + i;
+            red[i] = (uint32_t)(round * 977 + i * 31);
+        }
+        for (int i = 0; i < 100; i++) {
+            adc[i] = (uint16_t)((round * 100 + i) % 11 == 0 ? 4095 : (i * 37) % 4096);
+        }
+        uint32_t t = 1000 + round * 250;
+        capture.recordFifo(t, ir, red, 1 + round % 40);
+        capture.recordAdc(t + 1, adc, 1 + round % 100);
+        capture.recordDht(t + 2, round % 3 != 0, round % 5 == 0 ? NAN : -0.0f + round * 0.1f, 40.0f + round);
+        TEST_ASSERT_EQUAL_UINT32(t + 3, capture.clock(t + 3));
+    }
+    capture.stop();
+    const SensorCapture::Stats& written = capture.getStats();
+    TEST_ASSERT_TRUE(written.blocks > 10);
+    TEST_ASSERT_EQUAL_UINT32(0, written.failedWrites);
+    uint32_t writtenBytes = written.bytes;
+
+    TEST_ASSERT_TRUE(capture.startReplay());
+    for (int round = 0; round < 200; round++) {
+        for (int i = 0; i < 40; i++) {
+            ir[i] = (round * 40 + i) % 7 == 0 ? 0xFFFFFFF0u + i : 100000u + round * 13 + i;
+            red[i] = (uint32_t)(round * 977 + i * 31);
+        }
+        uint32_t gotIr[SensorCapture::kMaxFifoSamples], gotRed[SensorCapture::kMaxFifoSamples];
+        int total = 0, n;
+        TEST_ASSERT_EQUAL(SensorCapture::EVENT_FIFO, capture.peekEvent());
+        while ((n = capture.replayFifo(gotIr, gotRed)) > 0) {
+            TEST_ASSERT_EQUAL_UINT32_ARRAY(ir + total, gotIr, n);
+            TEST_ASSERT_EQUAL_UINT32_ARRAY(red + total, gotRed, n);
+            total += n;
+        }
+        TEST_ASSERT_EQUAL_INT(1 + round % 40, total);
+
+        uint16_t gotAdc[100];
+        TEST_ASSERT_TRUE(capture.replayAdc(gotAdc, 1 + round % 100));
+        for (int i = 0; i < 1 + round % 100; i++) {
+            TEST_ASSERT_EQUAL_UINT16((uint16_t)((round * 100 + i) % 11 == 0 ? 4095 : (i * 37) % 4096), gotAdc[i]);
+        }
+
+        bool ok;
+        float t, h;
+        TEST_ASSERT_TRUE(capture.replayDht(&ok, &t, &h));
+        float expectedT = round % 5 == 0 ? NAN : -0.0f + round * 0.1f;
+        float expectedH = 40.0f + round;
+        TEST_ASSERT_EQUAL(round % 3 != 0, ok);
+        TEST_ASSERT_EQUAL_MEMORY(&expectedT, &t, sizeof(float));
+        TEST_ASSERT_EQUAL_MEMORY(&expectedH, &h, sizeof(float));
+        TEST_ASSERT_EQUAL_UINT32(1000 + round * 250 + 3, capture.clock(0));
+    }
+    TEST_ASSERT_EQUAL(SensorCapture::EVENT_NONE, capture.peekEvent());
+    TEST_ASSERT_FALSE(capture.hasDiverged());
+    TEST_ASSERT_EQUAL_UINT32(writtenBytes, capture.getStats().bytes);
+    // 回放结束后时钟原样返回
+    TEST_ASSERT_EQUAL_UINT32(77, capture.clock(77));
+    TEST_ASSERT_FALSE(capture.isReplaying());
+}
+
+void test_sessions_and_divergence(void) {
+    FilePartition part(kImagePath, kPartitionSize);
+    TEST_ASSERT_TRUE(part.open());
+    TimeSeriesStore store(part);
+    TEST_ASSERT_TRUE(store.begin());
+    SensorCapture capture(store, kBlockSize);
+    uint16_t adc[4] = { 1, 2, 3, 4 };
+
+    for (int session = 1; session <= 3; session++) {
+        TEST_ASSERT_TRUE(capture.startCapture(0));
+        TEST_ASSERT_EQUAL_UINT16(session, capture.getSession());
+        capture.recordAdc(10, adc, session);
+        capture.clock(20 * session);
+        capture.stop();
+    }
+    // 重新挂载后序号继续
+    TimeSeriesStore remounted(part);
+    TEST_ASSERT_TRUE(remounted.begin());
+    SensorCapture again(remounted, kBlockSize);
+    TEST_ASSERT_FALSE(again.startReplay(7));
+    TEST_ASSERT_TRUE(again.startReplay());
+    TEST_ASSERT_EQUAL_UINT16(3, again.getSession());
+
+    // 第2个会话: 回放在第3个会话开始前结束
+    TEST_ASSERT_TRUE(again.startReplay(2));
+    uint16_t got[4];
+    TEST_ASSERT_TRUE(again.replayAdc(got, 2));
+    TEST_ASSERT_EQUAL_UINT16(2, got[1]);
+    TEST_ASSERT_EQUAL_UINT32(40, again.clock(0));
+    TEST_ASSERT_EQUAL(SensorCapture::EVENT_NONE, again.peekEvent());
+    TEST_ASSERT_FALSE(again.hasDiverged());
+
+    // 读取的次数不同: 录制时一次读2个，回放时一次读1个
+    TEST_ASSERT_TRUE(again.startReplay(2));
+    TEST_ASSERT_FALSE(again.replayAdc(got, 1));
+    TEST_ASSERT_TRUE(again.hasDiverged());
+    TEST_ASSERT_FALSE(again.isReplaying());
+
+    // 读取的顺序不同
+    TEST_ASSERT_TRUE(again.startReplay(2));
+    bool ok;
+    float t, h;
+    TEST_ASSERT_FALSE(again.replayDht(&ok, &t, &h));
+    TEST_ASSERT_TRUE(again.hasDiverged());
+
+    TEST_ASSERT_TRUE(again.startCapture(0));
+    TEST_ASSERT_EQUAL_UINT16(4, again.getSession());
+    again.stop();
+}
+
+void test_power_loss_keeps_written_blocks(void) {
+    FilePartition part(kImagePath, kPartitionSize);
+    TEST_ASSERT_TRUE(part.open());
+    TimeSeriesStore store(part);
+    TEST_ASSERT_TRUE(store.begin());
+    SensorCapture capture(store, kBlockSize);
+    uint16_t adc[64];
+    for (int i = 0; i < 64; i++) {
+        adc[i] = (uint16_t)(2000 + i * 7 % 50);
+    }
+
+    TEST_ASSERT_TRUE(capture.startCapture(0));
+    for (int i = 0; i < 200; i++) {
+        if (i == 150) {
+            part.setPowerLossAfter(300);
+        }
+        capture.recordAdc(i * 10, adc, 64);
+        capture.clock(i * 10 + 5);
+    }
+    TEST_ASSERT_TRUE(capture.getStats().failedWrites > 0);
+    part.powerCycle();
+
+    TimeSeriesStore remounted(part);
+    TEST_ASSERT_TRUE(remounted.begin());
+    SensorCapture replay(remounted, kBlockSize);
+    TEST_ASSERT_TRUE(replay.startReplay());
+    // 掉电前写入的块完整回放，之后正常结束
+    int rounds = 0;
+    uint16_t got[64];
+    while (replay.peekEvent() == SensorCapture::EVENT_ADC) {
+        TEST_ASSERT_TRUE(replay.replayAdc(got, 64));
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(adc, got, 64);
+        TEST_ASSERT_EQUAL_UINT32(rounds * 10 + 5, replay.clock(0));
+        rounds++;
+    }
+    TEST_ASSERT_FALSE(replay.hasDiverged());
+    TEST_ASSERT_TRUE(rounds > 100 && rounds <= 150);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_is_bit_exact);
+    RUN_TEST(test_sessions_and_divergence);
+    RUN_TEST(test_power_loss_keeps_written_blocks);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,361 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <SeriesCodec.h>
+
+// 读数历史压缩 (SeriesCodec) 的测试: 位级往返编解码、块满回滚、块独立解码与损坏检测，
+// 并打印合成序列 (以及 SERIES_CODEC_CSV 指定的录制序列) 的压缩率与编解码吞吐量:
+//   pio test -e native -f test_series_codec
+//   SERIES_CODEC_CSV=readings.csv pio test -e native -f test_series_codec
+
+namespace {
+    using SeriesCodec::Channel;
+
+    constexpr int kChannels = 6;
+    // 与 ReadingLog 相同的布局: 血糖、心率、SpO2、温度、湿度、信号质量
+    const Channel kQuantizedLayout[kChannels] = {
+        { SeriesCodec::QUANTIZED, 1 }, { SeriesCodec::QUANTIZED, 1 }, { SeriesCodec::QUANTIZED, 1 },
+        { SeriesCodec::QUANTIZED, 1 }, { SeriesCodec::QUANTIZED, 1 }, { SeriesCodec::QUANTIZED, 2 }
+    };
+    const Channel kXorLayout[kChannels] = {
+        { SeriesCodec::XOR_FLOAT, 0 }, { SeriesCodec::XOR_FLOAT, 0 }, { SeriesCodec::XOR_FLOAT, 0 },
+        { SeriesCodec::XOR_FLOAT, 0 }, { SeriesCodec::XOR_FLOAT, 0 }, { SeriesCodec::XOR_FLOAT, 0 }
+    };
+    // 原始格式: 时间戳 u32 + 6个 float
+    constexpr size_t kRawBytesPerReading = 4 + kChannels * 4;
+    constexpr size_t kBlockSize = 492;
+
+    constexpr int kMaxSeries = 20000;
+    uint32_t timestamps[kMaxSeries];
+    float values[kMaxSeries][kChannels];
+    int seriesLength = 0;
+
+    uint32_t seed;
+    float noise() {
+        seed = seed * 1103515245u + 12345u;
+        return ((seed >> 16) & 0x7FFF) / 32767.0f - 0.5f;
+    }
+
+    // 合成的读数: 2秒一次 (偶尔4秒与丢失的测量)，血糖缓慢变化，心率与SpO2带噪声，温湿度几乎不变。
+    // 传感器读数按各自的分辨率取整，与设备上的浮点值一样带有舍入误差。
+    void makeSyntheticSeries(int length) {
+        seed = 2024;
+        uint32_t t = 1700000000;
+        for (int i = 0; i < length; i++) {
+            t += (i % 97 == 0) ? 4 : ((i % 311 == 0) ? 10 : 2);
+            timestamps[i] = t;
+            values[i][0] = 110.0f + 25.0f * sinf(i / 900.0f) + noise() * 1.5f;
+            values[i][1] = roundf((72.0f + 6.0f * sinf(i / 120.0f) + noise() * 2.0f) * 10.0f) / 10.0f;
+            values[i][2] = roundf((97.5f + noise()) * 10.0f) / 10.0f;
+            values[i][3] = roundf((31.0f + 0.5f * sinf(i / 3000.0f)) * 10.0f) / 10.0f;
+            values[i][4] = roundf((45.0f + 2.0f * sinf(i / 5000.0f)) * 10.0f) / 10.0f;
+            values[i][5] = 0.85f + noise() * 0.2f;
+        }
+        seriesLength = length;
+    }
+
+    // 录制的读数: CSV 每行 timestamp,glucose,heart_rate,spo2,temperature,humidity,quality (第一行可以是表头)
+    bool loadCsv(const char* path) {
+        FILE* file = fopen(path, "r");
+        if (file == nullptr) {
+            return false;
+        }
+        char line[256];
+        seriesLength = 0;
+        while (seriesLength < kMaxSeries && fgets(line, sizeof(line), file) != nullptr) {
+            unsigned long t;
+            float* v = values[seriesLength];
+            if (sscanf(line, "%lu,%f,%f,%f,%f,%f,%f", &t, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) == 7) {
+                timestamps[seriesLength++] = (uint32_t)t;
+            }
+        }
+        fclose(file);
+        return seriesLength > 1;
+    }
+
+    constexpr int kMaxBlocks = 2000;
+    uint8_t blocks[kMaxBlocks][kBlockSize];
+    size_t blockLengths[kMaxBlocks];
+
+    // 把整个序列编码为定长块，返回块数
+    int encodeSeries(const Channel* layout) {
+        SeriesCodec::BlockEncoder encoder;
+        int blockCount = 0;
+        TEST_ASSERT_TRUE(encoder.begin(layout, kChannels, blocks[0], kBlockSize));
+        for (int i = 0; i < seriesLength; i++) {
+            if (!encoder.append(timestamps[i], values[i])) {
+                blockLengths[blockCount++] = encoder.size();
+                TEST_ASSERT_TRUE(blockCount < kMaxBlocks);
+                TEST_ASSERT_TRUE(encoder.begin(layout, kChannels, blocks[blockCount], kBlockSize));
+                TEST_ASSERT_TRUE(encoder.append(timestamps[i], values[i]));
+            }
+        }
+        blockLengths[blockCount++] = encoder.size();
+        return blockCount;
+    }
+
+    // 解码全部块并与原始序列比较: QUANTIZED 误差不超过半个量化单位，XOR_FLOAT 逐位相等
+    void checkSeries(int blockCount, const Channel* layout) {
+        int index = 0;
+        for (int b = 0; b < blockCount; b++) {
+            SeriesCodec::BlockDecoder decoder;
+            TEST_ASSERT_TRUE(decoder.begin(blocks[b], blockLengths[b]));
+            uint32_t t;
+            float decoded[kChannels];
+            while (decoder.next(&t, decoded)) {
+                TEST_ASSERT_EQUAL_UINT32(timestamps[index], t);
+                for (int c = 0; c < kChannels; c++) {
+                    if (isnan(values[index][c])) {
+                        TEST_ASSERT_FLOAT_IS_NAN(decoded[c]);
+                    } else if (layout[c].encoding == SeriesCodec::XOR_FLOAT) {
+                        TEST_ASSERT_EQUAL_MEMORY(&values[index][c], &decoded[c], sizeof(float));
+                    } else {
+                        TEST_ASSERT_FLOAT_WITHIN(0.5001 / pow(10.0, layout[c].decimals) + fabs(values[index][c]) * 1e-6,
+                                                 values[index][c], decoded[c]);
+                    }
+                }
+                index++;
+            }
+        }
+        TEST_ASSERT_EQUAL_INT(seriesLength, index);
+    }
+
+    // 编码与解码整个序列 repeat 次，打印压缩率与吞吐量，返回压缩率
+    float benchmark(const char* name, const Channel* layout, int repeat) {
+        auto start = std::chrono::steady_clock::now();
+        int blockCount = 0;
+        for (int r = 0; r < repeat; r++) {
+            blockCount = encodeSeries(layout);
+        }
+        auto encoded = std::chrono::steady_clock::now();
+        int decodedCount = 0;
+        for (int r = 0; r < repeat; r++) {
+            for (int b = 0; b < blockCount; b++) {
+                SeriesCodec::BlockDecoder decoder;
+                decoder.begin(blocks[b], blockLengths[b]);
+                uint32_t t;
+                float decoded[kChannels];
+                while (decoder.next(&t, decoded)) {
+                    decodedCount++;
+                }
+            }
+        }
+        auto decoded = std::chrono::steady_clock::now();
+        TEST_ASSERT_EQUAL_INT(seriesLength * repeat, decodedCount);
+        checkSeries(blockCount, layout);
+
+        // 按flash占用计算: 每块占满 kBlockSize (定长块)
+        double rawBytes = (double)seriesLength * kRawBytesPerReading;
+        double storedBytes = (double)blockCount * kBlockSize;
+        double encodeUs = std::chrono::duration<double, std::micro>(encoded - start).count() / repeat;
+        double decodeUs = std::chrono::duration<double, std::micro>(decoded - encoded).count() / repeat;
+        char line[200];
+        snprintf(line, sizeof(line),
+                 "%-22s %6d readings, %4d blocks, %.2f B/reading, ratio %.1fx, encode %.1f M readings/s (%.0f MB/s raw), "
+                 "decode %.1f M readings/s",
+                 name, seriesLength, blockCount, storedBytes / seriesLength, rawBytes / storedBytes,
+                 seriesLength / encodeUs, rawBytes / encodeUs, seriesLength / decodeUs);
+        TEST_MESSAGE(line);
+        return (float)(rawBytes / storedBytes);
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_round_trip_covers_every_bucket(void) {
+    // 时间戳: 不变的间隔、小/中/大的变化、回退与32位的跳变
+    const uint32_t times[] = { 1000, 1002, 1004, 1004, 1070, 1100, 1400, 5000, 4990, 0xFFFFFFF0u, 7, 9, 11 };
+    const int n = sizeof(times) / sizeof(times[0]);
+    const Channel layout[3] = { { SeriesCodec::QUANTIZED, 1 }, { SeriesCodec::QUANTIZED, 0 }, { SeriesCodec::XOR_FLOAT, 0 } };
+    const float q1[n] = { 0.0f, 0.1f, -0.1f, 1.5f, 100.0f, -2000.0f, NAN, 3.0f, 3.0f, 1e9f, -1e12f, 1e12f, 0.3f };
+    const float q0[n] = { 5.0f, 5.0f, 6.0f, -6.0f, 255.0f, 70000.0f, -70000.0f, 0.0f, NAN, NAN, 1.0f, 2.0f, 3.0f };
+    const float x[n] = { 1.0f, 1.0f, 1.5f, -0.0f, 0.0f, INFINITY, -INFINITY, NAN, 3.14159f, 1e-30f, 123456.789f, 1.0f, 1.0f };
+
+    uint8_t buffer[256];
+    SeriesCodec::BlockEncoder encoder;
+    TEST_ASSERT_TRUE(encoder.begin(layout, 3, buffer, sizeof(buffer)));
+    for (int i = 0; i < n; i++) {
+        float v[3] = { q1[i], q0[i], x[i] };
+        TEST_ASSERT_TRUE(encoder.append(times[i], v));
+    }
+    TEST_ASSERT_EQUAL_INT(n, encoder.count());
+    TEST_ASSERT_EQUAL_UINT32(1000, encoder.firstTimestamp());
+    TEST_ASSERT_EQUAL_UINT32(11, encoder.lastTimestamp());
+
+    SeriesCodec::BlockDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.begin(buffer, encoder.size()));
+    TEST_ASSERT_EQUAL_INT(3, decoder.channelCount());
+    TEST_ASSERT_EQUAL_INT(n, decoder.count());
+    TEST_ASSERT_EQUAL_UINT32(1000, decoder.firstTimestamp());
+    TEST_ASSERT_EQUAL_UINT8(SeriesCodec::XOR_FLOAT, decoder.channel(2).encoding);
+    for (int i = 0; i < n; i++) {
+        uint32_t t;
+        float v[3];
+        TEST_ASSERT_TRUE(decoder.next(&t, v));
+        TEST_ASSERT_EQUAL_UINT32(times[i], t);
+        // 超出32位量化范围的值被限制在范围内
+        float expected1 = fabsf(q1[i]) > 2e8f ? copysignf(2147483647.0f / 10.0f, q1[i]) : q1[i];
+        if (isnan(q1[i])) {
+            TEST_ASSERT_FLOAT_IS_NAN(v[0]);
+        } else {
+            TEST_ASSERT_FLOAT_WITHIN(0.05f + fabsf(expected1) * 1e-6f, expected1, v[0]);
+        }
+        if (isnan(q0[i])) {
+            TEST_ASSERT_FLOAT_IS_NAN(v[1]);
+        } else {
+            TEST_ASSERT_EQUAL_FLOAT(q0[i], v[1]);
+        }
+        TEST_ASSERT_EQUAL_MEMORY(&x[i], &v[2], sizeof(float));
+    }
+    uint32_t t;
+    float v[3];
+    TEST_ASSERT_FALSE(decoder.next(&t, v));
+}
+
+void test_constant_series_costs_one_bit_per_field(void) {
+    uint8_t buffer[512];
+    SeriesCodec::BlockEncoder encoder;
+    TEST_ASSERT_TRUE(encoder.begin(kQuantizedLayout, kChannels, buffer, sizeof(buffer)));
+    float v[kChannels] = { 100.0f, 70.0f, 98.0f, 30.0f, 50.0f, 1.0f };
+    TEST_ASSERT_TRUE(encoder.append(1000, v));
+    size_t first = encoder.size();
+    for (int i = 1; i <= 500; i++) {
+        TEST_ASSERT_TRUE(encoder.append(1000 + i * 2, v));
+    }
+    // 第一个间隔用去9位，之后每个读数7位 (时间戳 + 6个通道各1位)
+    size_t bits = (encoder.size() - first) * 8;
+    TEST_ASSERT_TRUE(bits >= 9 + 499 * 7 && bits <= 9 + 499 * 7 + 8 + 8 * 7);
+}
+
+void test_full_block_keeps_its_content(void) {
+    makeSyntheticSeries(500);
+    uint8_t buffer[96];
+    SeriesCodec::BlockEncoder encoder;
+    TEST_ASSERT_TRUE(encoder.begin(kQuantizedLayout, kChannels, buffer, sizeof(buffer)));
+    int count = 0;
+    while (encoder.append(timestamps[count], values[count])) {
+        count++;
+    }
+    TEST_ASSERT_TRUE(count > 2);
+    size_t size = encoder.size();
+    TEST_ASSERT_TRUE(size <= sizeof(buffer));
+    uint8_t copy[96];
+    memcpy(copy, buffer, size);
+    // 放不下的读数不改变块的内容
+    TEST_ASSERT_FALSE(encoder.append(timestamps[count], values[count]));
+    TEST_ASSERT_EQUAL_INT(count, encoder.count());
+    TEST_ASSERT_EQUAL_size_t(size, encoder.size());
+    TEST_ASSERT_EQUAL_MEMORY(copy, buffer, size);
+
+    SeriesCodec::BlockDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.begin(buffer, size));
+    uint32_t t;
+    float v[kChannels];
+    int decoded = 0;
+    while (decoder.next(&t, v)) {
+        TEST_ASSERT_EQUAL_UINT32(timestamps[decoded], t);
+        decoded++;
+    }
+    TEST_ASSERT_EQUAL_INT(count, decoded);
+}
+
+void test_blocks_decode_independently(void) {
+    makeSyntheticSeries(3000);
+    int blockCount = encodeSeries(kXorLayout);
+    TEST_ASSERT_TRUE(blockCount >= 3);
+    // 从中间的块开始解码，不需要之前的块
+    SeriesCodec::BlockDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.begin(blocks[2], blockLengths[2]));
+    int offset = 0;
+    while (timestamps[offset] != decoder.firstTimestamp()) {
+        offset++;
+    }
+    uint32_t t;
+    float v[kChannels];
+    for (int i = 0; i < decoder.count(); i++) {
+        TEST_ASSERT_TRUE(decoder.next(&t, v));
+        TEST_ASSERT_EQUAL_UINT32(timestamps[offset + i], t);
+        TEST_ASSERT_EQUAL_MEMORY(values[offset + i], v, sizeof(v));
+    }
+}
+
+void test_corrupt_blocks_are_rejected(void) {
+    makeSyntheticSeries(100);
+    uint8_t buffer[kBlockSize];
+    SeriesCodec::BlockEncoder encoder;
+    TEST_ASSERT_TRUE(encoder.begin(kQuantizedLayout, kChannels, buffer, sizeof(buffer)));
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_TRUE(encoder.append(timestamps[i], values[i]));
+    }
+    SeriesCodec::BlockDecoder decoder;
+    // 截断: 读到结尾之前停止
+    TEST_ASSERT_TRUE(decoder.begin(buffer, encoder.size() / 2));
+    uint32_t t;
+    float v[kChannels];
+    int decoded = 0;
+    while (decoder.next(&t, v)) {
+        decoded++;
+    }
+    TEST_ASSERT_TRUE(decoded < 100);
+    // 块头无效
+    TEST_ASSERT_FALSE(decoder.begin(buffer, 4));
+    buffer[0] = SeriesCodec::kBlockVersion + 1;
+    TEST_ASSERT_FALSE(decoder.begin(buffer, encoder.size()));
+    buffer[0] = SeriesCodec::kBlockVersion;
+    buffer[SeriesCodec::kHeaderSize] = 0x27;
+    TEST_ASSERT_FALSE(decoder.begin(buffer, encoder.size()));
+    // 无效的通道定义
+    const Channel bad[1] = { { SeriesCodec::QUANTIZED, 9 } };
+    TEST_ASSERT_FALSE(encoder.begin(bad, 1, buffer, sizeof(buffer)));
+    TEST_ASSERT_FALSE(encoder.begin(kQuantizedLayout, kChannels, buffer, SeriesCodec::kHeaderSize));
+}
+
+void test_synthetic_ratio_and_throughput(void) {
+    makeSyntheticSeries(kMaxSeries);
+    float quantized = benchmark("synthetic quantized", kQuantizedLayout, 20);
+    float xorFloat = benchmark("synthetic xor-float", kXorLayout, 20);
+    TEST_ASSERT_TRUE(quantized >= 5.0f);
+    TEST_ASSERT_TRUE(xorFloat > 1.0f);
+}
+
+void test_recorded_ratio_and_throughput(void) {
+    const char* path = getenv("SERIES_CODEC_CSV");
+    if (path == nullptr) {
+        TEST_IGNORE_MESSAGE("SERIES_CODEC_CSV not set, no recorded series");
+    }
+    TEST_ASSERT_TRUE(loadCsv(path));
+    benchmark("recorded quantized", kQuantizedLayout, 20);
+    benchmark("recorded xor-float", kXorLayout, 20);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_covers_every_bucket);
+    RUN_TEST(test_constant_series_costs_one_bit_per_field);
+    RUN_TEST(test_full_block_keeps_its_content);
+    RUN_TEST(test_blocks_decode_independently);
+    RUN_TEST(test_corrupt_blocks_are_rejected);
+    RUN_TEST(test_synthetic_ratio_and_throughput);
+    RUN_TEST(test_recorded_ratio_and_throughput);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
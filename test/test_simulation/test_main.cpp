@@ -0,0 +1,276 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <SimBoard.h>
+#include <SimBleTransport.h>
+#include <RtcKeyValueStore.h>
+#include <StateCheckpoint.h>
+#include <GlucosePredictor.h>
+#include <ModelImage.h>
+#include <esp_partition.h>
+#include <config.h>
+
+// 整个固件在主机模拟中的测试: setup()/loop() 原样运行，传感器、LED与BLE由 src/sim 中的模拟实现代替，
+// 虚拟时钟不等待真实时间。检查启动、血糖跟随合成的生理模型、BLE通知、手指移开/放回与模型更新的配对要求:
+//   pio test -e native-sim -f test_simulation
+// 各测试共用固件的单例状态，按顺序运行。
+
+void setup();
+void loop();
+bool restoreCheckpoint();
+
+namespace {
+    struct Line {
+        uint32_t timeMs;
+        std::string text;
+    };
+
+    std::vector<Line> lines;
+
+    void captureLine(const char* line) {
+        lines.push_back(Line{ SimBoard::getInstance().millis(), line });
+    }
+
+    SimBoard& board() {
+        return SimBoard::getInstance();
+    }
+
+    void runForSeconds(uint32_t seconds) {
+        uint64_t end = board().micros() + (uint64_t)seconds * 1000000ULL;
+        while (board().micros() < end) {
+            loop();
+        }
+    }
+
+    int countLines(const char* prefix, size_t from = 0) {
+        int count = 0;
+        for (size_t i = from; i < lines.size(); i++) {
+            if (lines[i].text.compare(0, strlen(prefix), prefix) == 0) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // 在 model_a 分区写入一个模型镜像。模拟中分区模型按加载成功处理 (不解析模型数据)，
+    // 没有分区模型时内置模型与设备上一样因自定义算子而加载失败 (见 test_simulation_no_model)
+    void flashModelImage() {
+        uint8_t payload[256];
+        for (size_t i = 0; i < sizeof(payload); i++) {
+            payload[i] = (uint8_t)i;
+        }
+        ModelImage::Header header = {};
+        header.modelVersion = 1;
+        header.modelSize = sizeof(payload);
+        header.modelCrc32 = ModelImage::crc32(payload, sizeof(payload));
+        header.flags = (uint32_t)ModelImage::ModelFormat::FLOAT32;
+        uint8_t raw[ModelImage::kHeaderSize];
+        ModelImage::serializeHeader(header, raw);
+        SimBoard::Partition* partition = board().findPartition(ESP_PARTITION_TYPE_DATA, MODEL_PARTITION_SUBTYPE,
+                                                               MODEL_PARTITION_LABEL_A);
+        TEST_ASSERT_NOT_NULL(partition);
+        memcpy(partition->data.data(), raw, sizeof(raw));
+        memcpy(partition->data.data() + sizeof(raw), payload, sizeof(payload));
+    }
+
+    bool hasLine(const char* text) {
+        for (const Line& line : lines) {
+            if (line.text.find(text) != std::string::npos) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_boot_reaches_ready_with_a_model_partition() {
+    board().setSerialSink(captureLine);
+    board().getPhysiology().reset(SimPhysiology::defaultProfile());
+    flashModelImage();
+    setup();
+
+    TEST_ASSERT_TRUE(hasLine("System ready"));
+    TEST_ASSERT_FALSE(hasLine("WARNING: No valid model partition found."));
+    TEST_ASSERT_TRUE(hasLine("Predictor init: "));
+    TEST_ASSERT_FALSE(hasLine("FATAL"));
+    TEST_ASSERT_FALSE(hasLine("ERROR"));
+    TEST_ASSERT_TRUE(SimBleTransport::getInstance().isStarted());
+    TEST_ASSERT_FALSE(SimBleTransport::getInstance().isConnected());
+    // 启动只用了虚拟时间
+    TEST_ASSERT_TRUE(board().millis() < 1000);
+}
+
+void test_glucose_tracks_the_physiology_model() {
+    SimPhysiology& body = board().getPhysiology();
+    uint32_t startMs = board().millis();
+    body.addMeal(startMs + 60000, 60.0f);
+    size_t first = lines.size();
+    runForSeconds(40 * 60);
+
+    // 第一分钟内滤波器还在收敛，之后比较每次测量的平滑值与真实血糖
+    double squares = 0.0;
+    float maxError = 0.0f;
+    float peak = 0.0f;
+    int n = 0;
+    for (size_t i = first; i < lines.size(); i++) {
+        float glucose;
+        if (lines[i].timeMs < startMs + 60000 || sscanf(lines[i].text.c_str(), "Glucose: %f", &glucose) != 1) {
+            continue;
+        }
+        float error = glucose - body.getGlucose(lines[i].timeMs);
+        squares += error * error;
+        maxError = fmaxf(maxError, fabsf(error));
+        peak = fmaxf(peak, glucose);
+        n++;
+    }
+    float rmse = (float)sqrt(squares / n);
+    char message[128];
+    snprintf(message, sizeof(message), "%d readings, RMSE %.2f mg/dL, max error %.2f mg/dL, peak %.1f mg/dL",
+             n, rmse, maxError, peak);
+    TEST_MESSAGE(message);
+
+    // 测量间隔最长4秒，加上测量本身的耗时
+    TEST_ASSERT_TRUE(n > 39 * 60 / 5);
+    TEST_ASSERT_TRUE(rmse < 4.0f);
+    TEST_ASSERT_TRUE(maxError < 15.0f);
+    // 餐后约40分钟达到峰值 (基线 100 + 60)
+    TEST_ASSERT_FLOAT_WITHIN(10.0f, 160.0f, peak);
+    TEST_ASSERT_EQUAL(0, countLines("No finger detected", first + 1));
+}
+
+void test_connected_client_receives_vitals_and_predictions() {
+    SimBleTransport& phone = SimBleTransport::getInstance();
+    phone.resetStats();
+    TEST_ASSERT_TRUE(phone.connect(30, 247));
+    TEST_ASSERT_EQUAL_UINT16(BLE_PREFERRED_MTU, phone.getMtu());
+    size_t first = lines.size();
+    runForSeconds(120);
+
+    TEST_ASSERT_TRUE(phone.getNotificationCount(GattSink::Characteristic::VITALS) > 0);
+    const std::vector<uint8_t>& vitals = phone.getLastNotification(GattSink::Characteristic::VITALS);
+    TEST_ASSERT_TRUE(vitals.size() >= 8);
+    TEST_ASSERT_EQUAL_UINT8(0, phone.getStats().oversized);
+    TEST_ASSERT_TRUE(countLines("Glucose: ", first) > 0);
+    TEST_ASSERT_TRUE(hasLine("| Predicted: "));
+
+    // 断开后由主循环 (BLE任务关闭时) 重新开始广播
+    uint32_t advertising = phone.getStats().advertisingStarts;
+    phone.disconnect();
+    runForSeconds(5);
+    TEST_ASSERT_EQUAL_UINT32(advertising + 1, phone.getStats().advertisingStarts);
+    TEST_ASSERT_FALSE(phone.isConnected());
+}
+
+void test_finger_removed_and_placed_again() {
+    SimPhysiology& body = board().getPhysiology();
+    body.setFingerPresent(false);
+    size_t first = lines.size();
+    runForSeconds(20);
+    TEST_ASSERT_TRUE(countLines("No finger detected", first) >= 3);
+    // 自适应测量在两次测量之间关闭光路
+    TEST_ASSERT_FALSE(board().isLedOn());
+
+    body.setFingerPresent(true);
+    first = lines.size();
+    runForSeconds(20);
+    TEST_ASSERT_TRUE(countLines("Glucose: ", first) >= 3);
+}
+
+void test_checkpoint_survives_unplanned_reset() {
+    runForSeconds(60);
+    TEST_ASSERT_TRUE(GlucosePredictor::getInstance().isReadyToPredict());
+
+    // 检查点写入之后又测量了 PREDICTOR_CHECKPOINT_READINGS 个读数，最后一个还没写入检查点时意外复位
+    // (批量策略允许的最坏情况)，之后重启并初始化 (模拟中 setup() 不能重复运行，这里只推进时钟)
+    uint8_t snapshot[StateCheckpoint::kMaxSnapshotSize];
+    size_t length = RtcKeyValueStore::getInstance().getBytes("state", snapshot, sizeof(snapshot));
+    TEST_ASSERT_TRUE(length > 0);
+    size_t first = lines.size();
+    while (countLines("Glucose: ", first) < PREDICTOR_CHECKPOINT_READINGS) {
+        loop();
+    }
+    TEST_ASSERT_TRUE(RtcKeyValueStore::getInstance().putBytes("state", snapshot, length));
+    const uint32_t kBootMs = 2000;
+    board().advanceMicros(kBootMs * 1000ULL);
+
+    TEST_ASSERT_TRUE(restoreCheckpoint());
+    TEST_ASSERT_TRUE(GlucosePredictor::getInstance().isReadyToPredict());
+    // 重启后的第一个读数与恢复的历史之间的间隔不超过 PREDICTOR_MAX_GAP_MS，预测不中断
+    first = lines.size();
+    while (countLines("Glucose: ", first) < 1) {
+        loop();
+    }
+    TEST_ASSERT_TRUE(GlucosePredictor::getInstance().isReadyToPredict());
+}
+
+void test_one_hour_runs_faster_than_real_time() {
+    SimBoard::Stats before = board().getStats();
+    uint64_t startUs = board().micros();
+    auto wallStart = std::chrono::steady_clock::now();
+    runForSeconds(3600);
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+    SimBoard::Stats after = board().getStats();
+
+    double virtualMs = (board().micros() - startUs) / 1000.0;
+    char message[160];
+    snprintf(message, sizeof(message), "1 h of firmware time in %.1f ms (%.0fx real time), %u ADC conversions, "
+             "LED on %.1f%%", wallMs, virtualMs / wallMs, (unsigned)(after.analogReads - before.analogReads),
+             100.0 * (after.ledOnUs - before.ledOnUs) / (virtualMs * 1000.0));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(virtualMs / wallMs > 10.0);
+}
+
+void test_model_update_requires_a_paired_link() {
+    // 配对码在启动时打印到串口
+    unsigned passkey = 0;
+    for (const Line& line : lines) {
+        sscanf(line.text.c_str(), "BLE model update passkey: %u", &passkey);
+    }
+    TEST_ASSERT_TRUE(passkey >= 100000 && passkey <= 999999);
+
+    SimBleTransport& phone = SimBleTransport::getInstance();
+    TEST_ASSERT_TRUE(phone.connect(30, 247));
+    const uint8_t abort[] = { 0x04 };
+    uint32_t acks = phone.getNotificationCount(GattSink::Characteristic::MODEL_UPDATE);
+    TEST_ASSERT_FALSE(phone.write(GattSink::Characteristic::MODEL_UPDATE, abort, sizeof(abort)));
+    TEST_ASSERT_FALSE(phone.pair(passkey + 1));
+    TEST_ASSERT_FALSE(phone.write(GattSink::Characteristic::MODEL_UPDATE, abort, sizeof(abort)));
+    runForSeconds(1);
+    TEST_ASSERT_EQUAL_UINT32(acks, phone.getNotificationCount(GattSink::Characteristic::MODEL_UPDATE));
+
+    TEST_ASSERT_TRUE(phone.pair(passkey));
+    TEST_ASSERT_TRUE(phone.write(GattSink::Characteristic::MODEL_UPDATE, abort, sizeof(abort)));
+    runForSeconds(1);
+    TEST_ASSERT_EQUAL_UINT32(acks + 1, phone.getNotificationCount(GattSink::Characteristic::MODEL_UPDATE));
+
+    // 断开后 (重新广播后再连接) 需要重新配对
+    phone.disconnect();
+    runForSeconds(5);
+    TEST_ASSERT_TRUE(phone.connect(30, 247));
+    TEST_ASSERT_FALSE(phone.write(GattSink::Characteristic::MODEL_UPDATE, abort, sizeof(abort)));
+    phone.disconnect();
+    runForSeconds(5);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_boot_reaches_ready_with_a_model_partition);
+    RUN_TEST(test_glucose_tracks_the_physiology_model);
+    RUN_TEST(test_connected_client_receives_vitals_and_predictions);
+    RUN_TEST(test_finger_removed_and_placed_again);
+    RUN_TEST(test_checkpoint_survives_unplanned_reset);
+    RUN_TEST(test_one_hour_runs_faster_than_real_time);
+    RUN_TEST(test_model_update_requires_a_paired_link);
+    return UNITY_END();
+}
+
+int main(void) {
+    return runUnityTests();
+}
@@ -0,0 +1,80 @@
+#include <unity.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <SimBoard.h>
+#include <SimBleTransport.h>
+#include <config.h>
+
+// 没有模型分区时的启动 (单独的测试程序，固件的单例状态只能启动一次):
+// 内置模型包含没有TFLM内核的自定义算子 (model_ops.h)，与设备上一样加载失败，
+// 固件不停在启动中，测量、BLE与历史记录照常运行，只是不预测。
+//   pio test -e native-sim -f test_simulation_no_model
+
+void setup();
+void loop();
+
+namespace {
+    std::vector<std::string> lines;
+
+    void captureLine(const char* line) {
+        lines.push_back(line);
+    }
+
+    SimBoard& board() {
+        return SimBoard::getInstance();
+    }
+
+    void runForSeconds(uint32_t seconds) {
+        uint64_t end = board().micros() + (uint64_t)seconds * 1000000ULL;
+        while (board().micros() < end) {
+            loop();
+        }
+    }
+
+    int countLines(const char* text) {
+        int count = 0;
+        for (const std::string& line : lines) {
+            if (line.find(text) != std::string::npos) {
+                count++;
+            }
+        }
+        return count;
+    }
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_boot_without_a_loadable_model_skips_prediction() {
+    board().setSerialSink(captureLine);
+    board().getPhysiology().reset(SimPhysiology::defaultProfile());
+    setup();
+
+    TEST_ASSERT_EQUAL(1, countLines("WARNING: No valid model partition found."));
+    TEST_ASSERT_EQUAL(1, countLines("Model requires custom op 'FlexTensorListReserve' which has no TFLM kernel."));
+    TEST_ASSERT_EQUAL(1, countLines("running without prediction"));
+    TEST_ASSERT_EQUAL(0, countLines("FATAL"));
+    TEST_ASSERT_EQUAL(1, countLines("System ready"));
+    TEST_ASSERT_TRUE(SimBleTransport::getInstance().isStarted());
+}
+
+void test_measurements_continue_without_prediction() {
+    runForSeconds(120);
+
+    int readings = countLines("Glucose: ");
+    TEST_ASSERT_TRUE(readings > 20);
+    TEST_ASSERT_EQUAL(readings, countLines("| Prediction unavailable"));
+    TEST_ASSERT_EQUAL(0, countLines("Predicted: "));
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_boot_without_a_loadable_model_skips_prediction);
+    RUN_TEST(test_measurements_continue_without_prediction);
+    return UNITY_END();
+}
+
+int main(void) {
+    return runUnityTests();
+}
@@ -0,0 +1,152 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <SimBoard.h>
+#include <ReplayDriver.h>
+#include <ModelImage.h>
+#include <esp_partition.h>
+#include <config.h>
+
+// 整个固件的录制与回放: 录制一段模拟的测量 (原始传感器输入写入 capture 分区)，之后从同一个分区镜像回放两次。
+// 回放的输出CRC32 必须与录制时相同，两次回放之间也相同，说明处理链路 (SpO2、自适应测量、滤波与预测)
+// 逐位重现了录制时的结果:
+//   pio test -e native-sim -f test_simulation_replay
+// 固件的单例状态只能 setup() 一次，每次运行都放在 fork() 出的子进程中，结果通过管道传回。
+
+void setup();
+void loop();
+
+namespace {
+    const char* kImagePath = "test_simulation_replay.bin";
+    const uint32_t kRecordSeconds = 600;
+
+    struct RunResult {
+        uint32_t digest;
+        uint32_t rounds;
+        bool finished;      // 回放完整结束 (没有与录制的调用顺序不一致)
+    };
+
+    bool replayFinished = false;
+
+    void captureLine(const char* line) {
+        if (strstr(line, "Replay of session") != nullptr && strstr(line, " finished:") != nullptr) {
+            replayFinished = true;
+        }
+    }
+
+    SimBoard& board() {
+        return SimBoard::getInstance();
+    }
+
+    // 在 model_a 分区写入一个模型镜像，预测的输出也计入CRC (模拟中分区模型按加载成功处理)
+    void flashModelImage() {
+        uint8_t payload[256];
+        for (size_t i = 0; i < sizeof(payload); i++) {
+            payload[i] = (uint8_t)i;
+        }
+        ModelImage::Header header = {};
+        header.modelVersion = 1;
+        header.modelSize = sizeof(payload);
+        header.modelCrc32 = ModelImage::crc32(payload, sizeof(payload));
+        header.flags = (uint32_t)ModelImage::ModelFormat::FLOAT32;
+        uint8_t raw[ModelImage::kHeaderSize];
+        ModelImage::serializeHeader(header, raw);
+        SimBoard::Partition* partition = board().findPartition(ESP_PARTITION_TYPE_DATA, MODEL_PARTITION_SUBTYPE,
+                                                               MODEL_PARTITION_LABEL_A);
+        memcpy(partition->data.data(), raw, sizeof(raw));
+        memcpy(partition->data.data() + sizeof(raw), payload, sizeof(payload));
+    }
+
+    // 子进程中的一次运行
+    RunResult runFirmware(int mode) {
+        board().setSerialSink(captureLine);
+        board().getPhysiology().reset(SimPhysiology::defaultProfile());
+        flashModelImage();
+        if (mode == SENSOR_CAPTURE_REPLAY) {
+            board().loadPartition(SENSOR_CAPTURE_PARTITION_LABEL, kImagePath);
+        }
+        ReplayDriver& driver = ReplayDriver::getInstance();
+        driver.setMode(mode);
+        setup();
+        if (mode == SENSOR_CAPTURE_RECORD) {
+            uint64_t end = board().micros() + kRecordSeconds * 1000000ULL;
+            while (board().micros() < end) {
+                loop();
+            }
+            driver.flush();
+            board().savePartition(SENSOR_CAPTURE_PARTITION_LABEL, kImagePath);
+        } else {
+            // 回放不等待，虚拟时间只按处理本身的耗时前进
+            uint64_t end = board().micros() + kRecordSeconds * 1000000ULL;
+            while (driver.isReplaying() && board().micros() < end) {
+                loop();
+            }
+        }
+        return RunResult{ driver.getDigest(), driver.getRounds(), replayFinished };
+    }
+
+    bool runInChild(int mode, RunResult* result) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            return false;
+        }
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0) {
+            return false;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            RunResult r = runFirmware(mode);
+            bool ok = write(fds[1], &r, sizeof(r)) == (ssize_t)sizeof(r);
+            _exit(ok ? 0 : 1);
+        }
+        close(fds[1]);
+        bool ok = read(fds[0], result, sizeof(*result)) == (ssize_t)sizeof(*result);
+        close(fds[0]);
+        int status = 0;
+        waitpid(pid, &status, 0);
+        return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {
+    remove(kImagePath);
+}
+
+void test_replay_reproduces_the_recorded_outputs() {
+    RunResult recorded, first, second;
+    TEST_ASSERT_TRUE(runInChild(SENSOR_CAPTURE_RECORD, &recorded));
+    TEST_ASSERT_TRUE(runInChild(SENSOR_CAPTURE_REPLAY, &first));
+    TEST_ASSERT_TRUE(runInChild(SENSOR_CAPTURE_REPLAY, &second));
+
+    char message[160];
+    snprintf(message, sizeof(message), "%u s recorded: %u rounds, output CRC32 %08X; replays %08X, %08X",
+             (unsigned)kRecordSeconds, (unsigned)recorded.rounds, (unsigned)recorded.digest,
+             (unsigned)first.digest, (unsigned)second.digest);
+    TEST_MESSAGE(message);
+
+    // 测量间隔最长4秒，加上测量本身的耗时
+    TEST_ASSERT_TRUE(recorded.rounds > kRecordSeconds / 5);
+    TEST_ASSERT_TRUE(first.finished);
+    TEST_ASSERT_TRUE(second.finished);
+    TEST_ASSERT_EQUAL_UINT32(recorded.rounds, first.rounds);
+    TEST_ASSERT_EQUAL_HEX32(recorded.digest, first.digest);
+    TEST_ASSERT_EQUAL_UINT32(first.rounds, second.rounds);
+    TEST_ASSERT_EQUAL_HEX32(first.digest, second.digest);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_reproduces_the_recorded_outputs);
+    return UNITY_END();
+}
+
+int main(void) {
+    return runUnityTests();
+}
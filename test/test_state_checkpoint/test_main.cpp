@@ -0,0 +1,249 @@
+#include <unity.h>
+#include <string.h>
+#include <StateCheckpoint.h>
+
+// 预测历史与滤波器状态的断电保存/恢复测试 (时间轴换算、批量写入、过期与损坏快照):
+//   pio test -e native -f test_state_checkpoint
+
+namespace {
+    // 内存中的键值存储，只保存一个键，并统计写入次数
+    class MemoryStore : public KeyValueStore {
+    public:
+        MemoryStore() : length(0), writes(0) {}
+
+        size_t getBytes(const char*, void* out, size_t capacity) override {
+            if (length == 0 || length > capacity) return 0;
+            memcpy(out, data, length);
+            return length;
+        }
+        bool putBytes(const char*, const void* src, size_t len) override {
+            if (len > sizeof(data)) return false;
+            memcpy(data, src, len);
+            length = len;
+            writes++;
+            return true;
+        }
+        bool remove(const char*) override {
+            length = 0;
+            return true;
+        }
+
+        uint8_t data[StateCheckpoint::kMaxSnapshotSize];
+        size_t length;
+        int writes;
+    };
+
+    StateCheckpoint::Policy policy() {
+        StateCheckpoint::Policy p;
+        p.minReadings = 5;
+        p.maxIntervalMs = 60000;
+        p.maxAgeMs = 60000;
+        return p;
+    }
+
+    HistoryResampler::Config historyConfig() {
+        HistoryResampler::Config c;
+        c.gridStepMs = 2000;
+        c.gridSize = 10;
+        c.maxGapMs = 10000;
+        c.maxStalenessMs = 15000;
+        c.minQuality = 0.2f;
+        return c;
+    }
+
+    // 从 start 开始每2秒一个读数，共 count 个
+    void fill(HistoryResampler* h, uint32_t start, int count) {
+        for (int i = 0; i < count; i++) {
+            h->add(start + 2000u * i, 100.0f + i, 0.9f);
+        }
+    }
+
+    GlucoseFilter::State filterState(uint32_t lastTimestampMs) {
+        GlucoseFilter::State s = { true, 123.5f, -1.25f, 4.0f, 0.5f, 0.25f, lastTimestampMs, 42 };
+        return s;
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_restore_translates_timestamps_to_new_boot(void) {
+    MemoryStore store;
+    HistoryResampler before(historyConfig());
+    fill(&before, 500000, 12);                      // 最新读数在 522000
+    StateCheckpoint writer(store, "state", policy());
+    TEST_ASSERT_TRUE(writer.save(before, filterState(522000), 523000, 1000000000ULL));
+
+    // 重启: millis() 从0开始，RTC 经过了4秒
+    StateCheckpoint reader(store, "state", policy());
+    HistoryResampler after(historyConfig());
+    GlucoseFilter::State restored;
+    TEST_ASSERT_TRUE(reader.restore(&after, &restored, 2000, 1000004000ULL) == StateCheckpoint::RestoreResult::OK);
+
+    TEST_ASSERT_EQUAL_INT(12, after.size());
+    // 最新读数在保存时已有1秒，加上重启经过的4秒，共5秒前
+    TEST_ASSERT_EQUAL_UINT32(2000u - 5000u, after.newest()->timestampMs);
+    for (int i = 0; i < 12; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(100.0f + i, after.at(i).value);
+        TEST_ASSERT_EQUAL_UINT32(before.at(i).timestampMs - before.newest()->timestampMs,
+                                 after.at(i).timestampMs - after.newest()->timestampMs);
+    }
+
+    // 新时间轴上窗口立即可用，与重启前相同
+    HistoryResampler::Window w1, w2;
+    TEST_ASSERT_TRUE(before.resample(523000, &w1) == HistoryResampler::Status::OK);
+    TEST_ASSERT_TRUE(after.resample(2000, &w2) == HistoryResampler::Status::OK);
+    for (int k = 0; k < 10; k++) {
+        TEST_ASSERT_EQUAL_FLOAT(w1.values[k], w2.values[k]);
+    }
+
+    // 新读数接在恢复的历史之后
+    TEST_ASSERT_TRUE(after.add(3000, 112.0f, 0.9f));
+
+    TEST_ASSERT_TRUE(restored.initialized);
+    TEST_ASSERT_EQUAL_FLOAT(123.5f, restored.glucose);
+    TEST_ASSERT_EQUAL_FLOAT(-1.25f, restored.velocity);
+    TEST_ASSERT_EQUAL_FLOAT(4.0f, restored.p00);
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, restored.p01);
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, restored.p11);
+    TEST_ASSERT_EQUAL_UINT32(2000u - 5000u, restored.lastTimestampMs);
+    TEST_ASSERT_EQUAL_UINT32(42, restored.updateCount);
+}
+
+void test_restored_filter_continues_smoothly(void) {
+    GlucoseFilter original;
+    for (uint32_t t = 0; t <= 60000; t += 2000) original.update(120.0f + t / 6000.0f, t);
+
+    MemoryStore store;
+    HistoryResampler history(historyConfig());
+    StateCheckpoint writer(store, "state", policy());
+    TEST_ASSERT_TRUE(writer.save(history, original.getState(), 60000, 5000000ULL));
+
+    StateCheckpoint reader(store, "state", policy());
+    HistoryResampler restoredHistory(historyConfig());
+    GlucoseFilter::State state;
+    TEST_ASSERT_TRUE(reader.restore(&restoredHistory, &state, 1000, 5003000ULL) == StateCheckpoint::RestoreResult::OK);
+    GlucoseFilter resumed;
+    resumed.setState(state);
+
+    // 同样的下一次读数 (距上次5秒) 在两个时间轴上给出相同结果，而不是重新初始化
+    original.update(131.0f, 65000);
+    resumed.update(131.0f, 3000);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, original.getGlucose(), resumed.getGlucose());
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, original.getVelocity(), resumed.getVelocity());
+    TEST_ASSERT_EQUAL_UINT32(original.getUpdateCount(), resumed.getUpdateCount());
+}
+
+void test_writes_are_batched(void) {
+    MemoryStore store;
+    HistoryResampler history(historyConfig());
+    StateCheckpoint checkpoint(store, "state", policy());
+
+    uint64_t rtc = 1000000;
+    for (int i = 0; i < 20; i++, rtc += 2000) {
+        history.add((uint32_t)rtc, 100.0f, 1.0f);
+        checkpoint.noteReading(rtc);
+        if (checkpoint.shouldSave(rtc)) {
+            checkpoint.save(history, filterState(0), (uint32_t)rtc, rtc);
+        }
+    }
+    // 每5个读数写一次
+    TEST_ASSERT_EQUAL_INT(4, store.writes);
+    TEST_ASSERT_EQUAL_UINT32(4, checkpoint.getWriteCount());
+
+    // 读数稀疏时，未保存的读数最多等待 maxIntervalMs
+    checkpoint.noteReading(rtc);
+    TEST_ASSERT_FALSE(checkpoint.shouldSave(rtc + 59999));
+    TEST_ASSERT_TRUE(checkpoint.shouldSave(rtc + 60000));
+}
+
+void test_save_without_new_readings_is_skipped(void) {
+    MemoryStore store;
+    HistoryResampler history(historyConfig());
+    fill(&history, 0, 5);
+    StateCheckpoint checkpoint(store, "state", policy());
+
+    TEST_ASSERT_FALSE(checkpoint.shouldSave(0));
+    TEST_ASSERT_TRUE(checkpoint.save(history, filterState(8000), 9000, 100000));
+    TEST_ASSERT_EQUAL_INT(1, store.writes);
+
+    // 例如重启前的强制保存: 没有新读数时不再写flash
+    TEST_ASSERT_TRUE(checkpoint.save(history, filterState(8000), 9500, 100500));
+    TEST_ASSERT_EQUAL_INT(1, store.writes);
+
+    checkpoint.noteReading(101000);
+    TEST_ASSERT_TRUE(checkpoint.save(history, filterState(8000), 10000, 101000));
+    TEST_ASSERT_EQUAL_INT(2, store.writes);
+
+    // 恢复后存储已是最新，同样不需要重写
+    StateCheckpoint restored(store, "state", policy());
+    HistoryResampler h(historyConfig());
+    GlucoseFilter::State s;
+    TEST_ASSERT_TRUE(restored.restore(&h, &s, 100, 102000) == StateCheckpoint::RestoreResult::OK);
+    TEST_ASSERT_TRUE(restored.save(h, s, 200, 102100));
+    TEST_ASSERT_EQUAL_INT(2, store.writes);
+}
+
+void test_stale_or_clock_reset_is_rejected(void) {
+    MemoryStore store;
+    HistoryResampler history(historyConfig());
+    fill(&history, 0, 5);
+    StateCheckpoint writer(store, "state", policy());
+    TEST_ASSERT_TRUE(writer.save(history, filterState(8000), 9000, 5000000ULL));
+
+    StateCheckpoint reader(store, "state", policy());
+    HistoryResampler h(historyConfig());
+    GlucoseFilter::State s;
+    // 超过 maxAgeMs
+    TEST_ASSERT_TRUE(reader.restore(&h, &s, 100, 5060001ULL) == StateCheckpoint::RestoreResult::STALE);
+    // 断电后RTC从0重新计时，无法得知经过了多久
+    TEST_ASSERT_TRUE(reader.restore(&h, &s, 100, 1000ULL) == StateCheckpoint::RestoreResult::STALE);
+    TEST_ASSERT_EQUAL_INT(0, h.size());
+}
+
+void test_missing_or_corrupt_snapshot(void) {
+    MemoryStore store;
+    StateCheckpoint checkpoint(store, "state", policy());
+    HistoryResampler h(historyConfig());
+    GlucoseFilter::State s;
+    TEST_ASSERT_TRUE(checkpoint.restore(&h, &s, 0, 1000) == StateCheckpoint::RestoreResult::NONE);
+
+    HistoryResampler history(historyConfig());
+    fill(&history, 0, 8);
+    TEST_ASSERT_TRUE(checkpoint.save(history, filterState(14000), 15000, 20000));
+
+    store.data[60] ^= 0x01;
+    TEST_ASSERT_TRUE(checkpoint.restore(&h, &s, 0, 21000) == StateCheckpoint::RestoreResult::CORRUPT);
+    store.data[60] ^= 0x01;
+
+    store.length -= 12; // 截断
+    TEST_ASSERT_TRUE(checkpoint.restore(&h, &s, 0, 21000) == StateCheckpoint::RestoreResult::CORRUPT);
+    TEST_ASSERT_EQUAL_INT(0, h.size());
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_restore_translates_timestamps_to_new_boot);
+    RUN_TEST(test_restored_filter_continues_smoothly);
+    RUN_TEST(test_writes_are_batched);
+    RUN_TEST(test_save_without_new_readings_is_skipped);
+    RUN_TEST(test_stale_or_clock_reset_is_rejected);
+    RUN_TEST(test_missing_or_corrupt_snapshot);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
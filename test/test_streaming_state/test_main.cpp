@@ -0,0 +1,228 @@
+#include <unity.h>
+#include <string.h>
+#include <StreamingState.h>
+#include <HistoryResampler.h>
+
+// 流式模型状态的测试: StreamingState::feed() 按网格步进 (每个读数一步，间隔时插值) 的结果与
+// HistoryResampler 重采样整窗口后重算的结果一致，以及快照的保存与恢复:
+//   pio test -e native -f test_streaming_state
+
+namespace {
+    constexpr int kMaxWindow = 32;
+    constexpr uint32_t kModelId = 0x1234ABCD;
+    constexpr uint32_t kGridStepMs = 2000;
+    constexpr uint32_t kMaxGapMs = 10000;
+
+    // 桩模型: 长度为 window 的一维卷积 (流式卷积的最简形式)，输出两步预测
+    struct StubConvModel {
+        int window;
+        float weights[kMaxWindow];
+
+        explicit StubConvModel(int w) : window(w) {
+            for (int i = 0; i < w; i++) weights[i] = 0.02f * (i + 1) / w + (i == w - 1 ? 0.9f : 0.0f);
+        }
+
+        // 整窗口模式: 每次对完整的 window 个历史读数重新计算
+        void full(const float* x, float* out) const {
+            float acc = 0.0f;
+            for (int i = 0; i < window; i++) acc += weights[i] * x[i];
+            out[0] = acc;
+            out[1] = acc + (x[window - 1] - x[window - 2]);
+        }
+
+        // 流式模式: 状态为最近 window-1 个读数，每个新读数只计算一步
+        void step(float x, const float* stateIn, float* out, float* stateOut) const {
+            float acc = weights[window - 1] * x;
+            for (int i = 0; i < window - 1; i++) acc += weights[i] * stateIn[i];
+            out[0] = acc;
+            out[1] = acc + (x - stateIn[window - 2]);
+            for (int i = 0; i < window - 2; i++) stateOut[i] = stateIn[i + 1];
+            stateOut[window - 2] = x;
+        }
+    };
+
+    // feed() 的回调: 运行桩模型一步并提交新状态，记下最近一步的输出
+    struct Stepper {
+        const StubConvModel* model;
+        StreamingState* state;
+        float output[2];
+        int steps;
+    };
+
+    void stubStep(void* context, float value) {
+        Stepper* s = static_cast<Stepper*>(context);
+        float next[kMaxWindow];
+        s->model->step(value, s->state->data(), s->output, next);
+        s->state->commit(next);
+        s->steps++;
+    }
+
+    // 记下提交的采样值 (快照测试用，状态只有1个元素)
+    void recordStep(void* context, float value) {
+        StreamingState* state = static_cast<StreamingState*>(context);
+        state->commit(&value);
+    }
+
+    float reading(int t) {
+        // 带餐后峰值的血糖曲线
+        float base = 100.0f + 0.3f * t;
+        return t > 40 && t < 70 ? base + 2.0f * (t - 40) : base;
+    }
+
+    // 读数落在网格上，但间隔不均匀: 偶尔漏掉一两个读数 (插值补齐)，中间有一次超过 kMaxGapMs 的中断 (重新积累)
+    bool skipped(int t) {
+        return t % 7 == 3 || t % 11 == 5 || t % 11 == 6 || (t >= 120 && t < 126);
+    }
+
+    void checkEquivalence(int window) {
+        StubConvModel model(window);
+        StreamingState state;
+        TEST_ASSERT_TRUE(state.begin(window - 1, kModelId, kGridStepMs, kMaxGapMs));
+        HistoryResampler history(HistoryResampler::Config{ kGridStepMs, window, kMaxGapMs, 15000, 0.0f });
+        Stepper stepper = { &model, &state, { 0.0f, 0.0f }, 0 };
+
+        int compared = 0;
+        for (int t = 0; t < 240; t++) {
+            if (skipped(t)) continue;
+            uint32_t timestampMs = 5000 + t * kGridStepMs;
+            TEST_ASSERT_TRUE(history.add(timestampMs, reading(t)));
+            state.feed(timestampMs, reading(t), stubStep, &stepper);
+
+            // 两种方式同时可用: 流式状态积累了整个窗口 ⇔ 重采样得到完整且没有过长间隔的窗口
+            HistoryResampler::Window resampled;
+            bool ready = history.resample(timestampMs, &resampled) == HistoryResampler::Status::OK;
+            TEST_ASSERT_EQUAL(ready, state.isWarm(window));
+            if (!ready) continue;
+
+            float full[2];
+            model.full(resampled.values, full);
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, full[0], stepper.output[0]);
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, full[1], stepper.output[1]);
+            compared++;
+        }
+        // 每个网格点运行一步，包括漏掉的读数
+        TEST_ASSERT_TRUE(stepper.steps > 200);
+        TEST_ASSERT_TRUE(compared > 100);
+    }
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_streaming_matches_full_window(void) {
+    checkEquivalence(10);
+}
+
+void test_streaming_matches_longer_window(void) {
+    // 窗口越长，每个读数节省的计算越多，结果仍然一致
+    checkEquivalence(kMaxWindow);
+}
+
+void test_snapshot_round_trip(void) {
+    StreamingState a;
+    a.begin(1, kModelId, kGridStepMs, kMaxGapMs);
+    for (int t = 0; t < 12; t++) {
+        a.feed(1000 + t * kGridStepMs, 100.0f + t, recordStep, &a);
+    }
+
+    // 最后一个读数之后3秒保存，重启后又过了4秒恢复 (millis() 从0开始)
+    uint8_t buf[256];
+    uint32_t lastMs = 1000 + 11 * kGridStepMs;
+    size_t len = a.saveSnapshot(buf, sizeof(buf), lastMs + 3000, 50000);
+    TEST_ASSERT_EQUAL_size_t(a.snapshotSize(), len);
+
+    StreamingState b;
+    b.begin(1, kModelId, kGridStepMs, kMaxGapMs);
+    TEST_ASSERT_TRUE(b.restoreSnapshot(buf, len, 800, 54000));
+    TEST_ASSERT_EQUAL_UINT32(12, b.getSteps());
+    TEST_ASSERT_TRUE(b.isWarm(10));
+    TEST_ASSERT_EQUAL_FLOAT(111.0f, b.data()[0]);
+
+    // 新的时间轴上最后一个读数在 800 - 7000；下一个读数在其后 3 个网格处，中间两个网格点按插值补齐
+    b.feed(800 - 7000 + 3 * kGridStepMs, 114.0f, recordStep, &b);
+    TEST_ASSERT_EQUAL_UINT32(15, b.getSteps());
+    TEST_ASSERT_EQUAL_FLOAT(114.0f, b.data()[0]);
+}
+
+void test_snapshot_rejected_when_invalid(void) {
+    StreamingState a;
+    a.begin(1, kModelId, kGridStepMs, kMaxGapMs);
+    uint8_t buf[256];
+    TEST_ASSERT_EQUAL_size_t(0, a.saveSnapshot(buf, sizeof(buf), 0, 5000)); // 还没有读数
+    a.feed(1000, 100.0f, recordStep, &a);
+    size_t len = a.saveSnapshot(buf, sizeof(buf), 1000, 5000);
+    TEST_ASSERT_EQUAL_size_t(0, a.saveSnapshot(buf, len - 1, 1000, 5000)); // 容量不足
+
+    StreamingState b;
+
+    // 其他模型的快照
+    b.begin(1, kModelId + 1, kGridStepMs, kMaxGapMs);
+    TEST_ASSERT_FALSE(b.restoreSnapshot(buf, len, 0, 5000));
+
+    // 状态长度不同
+    b.begin(2, kModelId, kGridStepMs, kMaxGapMs);
+    TEST_ASSERT_FALSE(b.restoreSnapshot(buf, len, 0, 5000));
+
+    // 最后一个读数距今超过 kMaxGapMs，或时钟早于保存时刻 (断电后时钟复位)
+    b.begin(1, kModelId, kGridStepMs, kMaxGapMs);
+    TEST_ASSERT_FALSE(b.restoreSnapshot(buf, len, 0, 5000 + kMaxGapMs + 1));
+    TEST_ASSERT_FALSE(b.restoreSnapshot(buf, len, 0, 10));
+    TEST_ASSERT_TRUE(b.restoreSnapshot(buf, len, 0, 5000 + kMaxGapMs));
+
+    // 数据损坏
+    buf[StreamingState::kSnapshotHeaderSize] ^= 0x01;
+    b.begin(1, kModelId, kGridStepMs, kMaxGapMs);
+    TEST_ASSERT_FALSE(b.restoreSnapshot(buf, len, 0, 5000));
+    TEST_ASSERT_EQUAL_UINT32(0, b.getSteps());
+}
+
+void test_snapshot_older_than_gap_is_not_continued(void) {
+    // 周期性快照比最后一个读数早很多 (例如看门狗复位前写入的): 恢复时拒绝，第一个读数从头积累
+    StreamingState a;
+    a.begin(1, kModelId, kGridStepMs, kMaxGapMs);
+    for (int t = 0; t < 20; t++) {
+        a.feed(1000 + t * kGridStepMs, 100.0f, recordStep, &a);
+    }
+    uint8_t buf[256];
+    size_t len = a.saveSnapshot(buf, sizeof(buf), 1000 + 19 * kGridStepMs, 100000);
+
+    StreamingState b;
+    b.begin(1, kModelId, kGridStepMs, kMaxGapMs);
+    TEST_ASSERT_FALSE(b.restoreSnapshot(buf, len, 500, 100000 + 150 * kGridStepMs));
+    b.feed(2000, 120.0f, recordStep, &b);
+    TEST_ASSERT_EQUAL_UINT32(1, b.getSteps());
+
+    // 恢复后第一个读数来得太晚时同样从头积累
+    StreamingState c;
+    c.begin(1, kModelId, kGridStepMs, kMaxGapMs);
+    TEST_ASSERT_TRUE(c.restoreSnapshot(buf, len, 500, 105000));
+    TEST_ASSERT_EQUAL_UINT32(20, c.getSteps());
+    c.feed(500 + 6000, 120.0f, recordStep, &c);
+    TEST_ASSERT_EQUAL_UINT32(1, c.getSteps());
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_streaming_matches_full_window);
+    RUN_TEST(test_streaming_matches_longer_window);
+    RUN_TEST(test_snapshot_round_trip);
+    RUN_TEST(test_snapshot_rejected_when_invalid);
+    RUN_TEST(test_snapshot_older_than_gap_is_not_continued);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,354 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <FilePartition.h>
+#include <TimeSeriesStore.h>
+#include <ReadingLog.h>
+
+// flash时间序列存储的测试: 在主机上用分区镜像文件 (FilePartition) 代替 spiffs 分区，
+// 注入掉电检查崩溃后的恢复:
+//   pio test -e native -f test_time_series_store
+
+namespace {
+    const char* kImagePath = "test_time_series_store.bin";
+    const uint32_t kSmallPartition = 8 * FlashPartition::kSectorSize;
+
+    // 记录内容由序号确定，读回时可以逐字节校验
+    size_t makePayload(uint32_t index, uint8_t* out) {
+        size_t length = 20 + index % 80;
+        for (size_t i = 0; i < length; i++) {
+            out[i] = (uint8_t)(index * 31 + i);
+        }
+        return length;
+    }
+
+    bool appendIndexed(TimeSeriesStore& store, uint32_t index) {
+        uint8_t payload[128];
+        size_t length = makePayload(index, payload);
+        return store.append(1, 1000 + index * 10, 1000 + index * 10 + 9, payload, length);
+    }
+
+    void checkIndexed(const TimeSeriesStore::RecordInfo& info, const uint8_t* payload, uint32_t index) {
+        uint8_t expected[128];
+        size_t length = makePayload(index, expected);
+        TEST_ASSERT_EQUAL_UINT32(1000 + index * 10, info.firstTimestamp);
+        TEST_ASSERT_EQUAL_UINT32(length, info.length);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, payload, length);
+    }
+
+    // 按时间顺序读出全部记录，返回第一条记录的序号与条数
+    int readAll(TimeSeriesStore& store, uint32_t* firstIndex) {
+        TimeSeriesStore::Cursor cursor = store.first();
+        TimeSeriesStore::RecordInfo info;
+        uint8_t payload[TimeSeriesStore::kMaxPayloadSize];
+        int count = 0;
+        uint32_t index = 0;
+        while (store.next(&cursor, &info, payload, sizeof(payload))) {
+            uint32_t current = (info.firstTimestamp - 1000) / 10;
+            if (count == 0) {
+                *firstIndex = current;
+            } else {
+                TEST_ASSERT_EQUAL_UINT32(index + 1, current);
+            }
+            checkIndexed(info, payload, current);
+            index = current;
+            count++;
+        }
+        return count;
+    }
+}
+
+void setUp(void) {
+    remove(kImagePath);
+}
+
+void tearDown(void) {
+    remove(kImagePath);
+}
+
+void test_file_partition_has_nor_semantics(void) {
+    FilePartition part(kImagePath, kSmallPartition);
+    TEST_ASSERT_TRUE(part.open());
+    uint8_t data[4] = { 0xF0, 0x0F, 0xAA, 0x55 };
+    uint8_t more[4] = { 0xCC, 0xCC, 0xFF, 0x00 };
+    uint8_t out[4];
+    TEST_ASSERT_TRUE(part.read(0, out, 4));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, out[0]);
+    TEST_ASSERT_TRUE(part.write(0, data, 4));
+    TEST_ASSERT_TRUE(part.write(0, more, 4));
+    TEST_ASSERT_TRUE(part.read(0, out, 4));
+    uint8_t expected[4] = { 0xC0, 0x0C, 0xAA, 0x00 };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, out, 4);
+    TEST_ASSERT_TRUE(part.eraseSector(0));
+    TEST_ASSERT_TRUE(part.read(0, out, 4));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, out[3]);
+
+    // 掉电: 只写入前3个字节，之后所有操作失败
+    part.setPowerLossAfter(3);
+    TEST_ASSERT_FALSE(part.write(0, data, 4));
+    TEST_ASSERT_TRUE(part.isPoweredOff());
+    TEST_ASSERT_FALSE(part.read(0, out, 4));
+    part.powerCycle();
+    TEST_ASSERT_TRUE(part.read(0, out, 4));
+    TEST_ASSERT_EQUAL_HEX8(0xAA, out[2]);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, out[3]);
+}
+
+void test_append_read_and_remount(void) {
+    FilePartition part(kImagePath, kSmallPartition);
+    TEST_ASSERT_TRUE(part.open());
+    {
+        TimeSeriesStore store(part);
+        TEST_ASSERT_TRUE(store.begin());
+        for (uint32_t i = 0; i < 100; i++) {
+            TEST_ASSERT_TRUE(appendIndexed(store, i));
+        }
+        // 时间倒退的记录被拒绝
+        uint8_t payload[4] = { 0 };
+        TEST_ASSERT_FALSE(store.append(1, 500, 600, payload, sizeof(payload)));
+    }
+
+    // 重新挂载: 索引与写入位置从flash恢复，继续追加
+    TimeSeriesStore store(part);
+    TEST_ASSERT_TRUE(store.begin());
+    TimeSeriesStore::Stats stats = store.getStats();
+    TEST_ASSERT_EQUAL_UINT32(1000, stats.oldestTimestamp);
+    TEST_ASSERT_EQUAL_UINT32(1000 + 99 * 10 + 9, stats.newestTimestamp);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.recoveredTornRecords);
+    TEST_ASSERT_TRUE(stats.segments > 1);
+    TEST_ASSERT_TRUE(appendIndexed(store, 100));
+
+    uint32_t first = 0;
+    TEST_ASSERT_EQUAL_INT(101, readAll(store, &first));
+    TEST_ASSERT_EQUAL_UINT32(0, first);
+}
+
+void test_seek_finds_covering_record(void) {
+    FilePartition part(kImagePath, kSmallPartition);
+    TEST_ASSERT_TRUE(part.open());
+    TimeSeriesStore store(part);
+    TEST_ASSERT_TRUE(store.begin());
+    for (uint32_t i = 0; i < 150; i++) {
+        TEST_ASSERT_TRUE(appendIndexed(store, i));
+    }
+
+    TimeSeriesStore::RecordInfo info;
+    uint8_t payload[TimeSeriesStore::kMaxPayloadSize];
+    // 每条记录覆盖 [1000 + 10i, 1000 + 10i + 9]
+    uint32_t targets[5] = { 0, 1000, 1455, 1999, 2499 };
+    uint32_t expected[5] = { 0, 0, 45, 99, 149 };
+    for (int t = 0; t < 5; t++) {
+        TimeSeriesStore::Cursor cursor = store.seek(targets[t]);
+        TEST_ASSERT_TRUE(store.next(&cursor, &info, payload, sizeof(payload)));
+        checkIndexed(info, payload, expected[t]);
+    }
+    // 晚于最新的记录: 没有结果，之后追加的记录从该游标处可以读到
+    TimeSeriesStore::Cursor tail = store.seek(5000);
+    TEST_ASSERT_FALSE(store.next(&tail, &info, payload, sizeof(payload)));
+    TEST_ASSERT_TRUE(appendIndexed(store, 500));
+    TEST_ASSERT_TRUE(store.next(&tail, &info, payload, sizeof(payload)));
+    checkIndexed(info, payload, 500);
+}
+
+void test_ring_overwrites_oldest_and_levels_wear(void) {
+    FilePartition part(kImagePath, kSmallPartition);
+    TEST_ASSERT_TRUE(part.open());
+    TimeSeriesStore store(part);
+    TEST_ASSERT_TRUE(store.begin());
+    const uint32_t kRecords = 3000;   // 约绕分区10圈
+    for (uint32_t i = 0; i < kRecords; i++) {
+        TEST_ASSERT_TRUE(appendIndexed(store, i));
+    }
+
+    uint32_t first = 0;
+    int count = readAll(store, &first);
+    TEST_ASSERT_EQUAL_UINT32(kRecords, first + count);
+    TEST_ASSERT_TRUE(count > 100);
+
+    // 各扇区的擦除次数最多相差1
+    uint32_t minErase = 0xFFFFFFFF;
+    uint32_t maxErase = 0;
+    for (uint32_t s = 0; s < kSmallPartition / FlashPartition::kSectorSize; s++) {
+        uint32_t e = part.getEraseCount(s);
+        if (e < minErase) minErase = e;
+        if (e > maxErase) maxErase = e;
+    }
+    TEST_ASSERT_TRUE(maxErase - minErase <= 1);
+    TEST_ASSERT_EQUAL_UINT32(maxErase, store.getStats().maxEraseCount);
+
+    // 早于保留范围的 seek 从最旧的记录开始
+    TimeSeriesStore::Cursor cursor = store.seek(0);
+    TimeSeriesStore::RecordInfo info;
+    uint8_t payload[TimeSeriesStore::kMaxPayloadSize];
+    TEST_ASSERT_TRUE(store.next(&cursor, &info, payload, sizeof(payload)));
+    checkIndexed(info, payload, first);
+}
+
+void test_power_loss_at_every_point_keeps_committed_records(void) {
+    // 在不同的字节处掉电 (包括写记录、擦除下一段与写段头的过程中)，
+    // 重启后所有已确认的记录完好且连续，并且可以继续写入
+    int recoveries = 0;
+    for (uint32_t budget = 0; budget < 9000; budget += 37) {
+        remove(kImagePath);
+        FilePartition part(kImagePath, 3 * FlashPartition::kSectorSize);
+        TEST_ASSERT_TRUE(part.open());
+        uint32_t committed = 0;
+        {
+            TimeSeriesStore store(part);
+            TEST_ASSERT_TRUE(store.begin());
+            for (; committed < 40; committed++) {
+                TEST_ASSERT_TRUE(appendIndexed(store, committed));
+            }
+            part.setPowerLossAfter(budget);
+            while (appendIndexed(store, committed)) {
+                committed++;
+            }
+        }
+        part.powerCycle();
+
+        TimeSeriesStore store(part);
+        TEST_ASSERT_TRUE(store.begin());
+        uint32_t first = 0;
+        int count = readAll(store, &first);
+        // 读到的是以最后一条已确认记录结尾的连续区间 (更早的可能已被环形覆盖)
+        TEST_ASSERT_TRUE(count > 0);
+        TEST_ASSERT_EQUAL_UINT32(committed, first + count);
+        recoveries += store.getStats().recoveredTornRecords > 0 ? 1 : 0;
+
+        // 恢复后继续写入并能读回
+        for (uint32_t i = 0; i < 30; i++) {
+            TEST_ASSERT_TRUE(appendIndexed(store, committed + i));
+        }
+        count = readAll(store, &first);
+        TEST_ASSERT_EQUAL_UINT32(committed + 30, first + count);
+    }
+    TEST_ASSERT_TRUE(recoveries > 0);
+}
+
+namespace {
+    // 2秒一次、缓慢变化加噪声的读数
+    ReadingLog::Reading makeReading(uint32_t start, int i) {
+        ReadingLog::Reading reading;
+        reading.timestamp = start + i * 2;
+        reading.glucose = 110.0f + 20.0f * sinf(i / 300.0f) + ((i * 7) % 5 - 2) * 0.3f;
+        reading.heartRate = 72.0f + 5.0f * sinf(i / 50.0f) + ((i * 3) % 7 - 3) * 0.2f;
+        reading.spo2 = 97.0f + ((i * 5) % 3 - 1) * 0.5f;
+        reading.temperature = 31.5f + (i / 400) * 0.1f;
+        reading.humidity = i < 100 ? NAN : 45.0f + ((i / 50) % 3) * 0.1f;
+        reading.quality = 0.9f + ((i * 11) % 9 - 4) * 0.01f;
+        return reading;
+    }
+
+    ReadingLog::Reading simpleReading(uint32_t timestamp, float glucose) {
+        ReadingLog::Reading reading = { timestamp, glucose, 70.0f, 98.0f, 30.0f, 50.0f, 1.0f };
+        return reading;
+    }
+}
+
+void test_reading_log_round_trip_and_density(void) {
+    FilePartition part(kImagePath, kSmallPartition);
+    TEST_ASSERT_TRUE(part.open());
+    TimeSeriesStore store(part);
+    TEST_ASSERT_TRUE(store.begin());
+    ReadingLog log(store, 492);
+
+    const int kReadings = 1000;
+    uint32_t start = 1700000000;
+    for (int i = 0; i < kReadings; i++) {
+        TEST_ASSERT_TRUE(log.add(makeReading(start, i)));
+    }
+    TEST_ASSERT_TRUE(log.pending() > 0);
+
+    static ReadingLog::Reading out[kReadings];
+    TEST_ASSERT_EQUAL_INT(kReadings, log.read(start, start + kReadings * 2, out, kReadings));
+    for (int i = 0; i < kReadings; i++) {
+        ReadingLog::Reading expected = makeReading(start, i);
+        TEST_ASSERT_EQUAL_UINT32(expected.timestamp, out[i].timestamp);
+        TEST_ASSERT_FLOAT_WITHIN(0.051f, expected.glucose, out[i].glucose);
+        TEST_ASSERT_FLOAT_WITHIN(0.051f, expected.heartRate, out[i].heartRate);
+        TEST_ASSERT_FLOAT_WITHIN(0.051f, expected.spo2, out[i].spo2);
+        TEST_ASSERT_FLOAT_WITHIN(0.051f, expected.temperature, out[i].temperature);
+        if (i < 100) {
+            TEST_ASSERT_FLOAT_IS_NAN(out[i].humidity);
+        } else {
+            TEST_ASSERT_FLOAT_WITHIN(0.051f, expected.humidity, out[i].humidity);
+        }
+        TEST_ASSERT_FLOAT_WITHIN(0.0051f, expected.quality, out[i].quality);
+    }
+    // 时间范围查询
+    TEST_ASSERT_EQUAL_INT(11, log.read(start + 200, start + 220, out, kReadings));
+    TEST_ASSERT_EQUAL_UINT32(start + 200, out[0].timestamp);
+
+    // 编码密度: 估算 444 KB 的 spiffs 分区能保存多久的2秒读数 (每段8条492字节的记录)
+    static ReadingLog::Reading block[kReadings];
+    TEST_ASSERT_EQUAL_INT(kReadings, log.read(start, start + kReadings * 2, block, kReadings));
+    uint8_t encoded[492];
+    int count = 1;
+    while (count < kReadings && ReadingLog::encodeBlock(block, count + 1, encoded, sizeof(encoded)) > 0) {
+        count++;
+    }
+    TEST_ASSERT_EQUAL_INT(count, ReadingLog::decodeBlock(encoded, ReadingLog::encodeBlock(block, count, encoded, sizeof(encoded)),
+                                                         out, kReadings));
+    TEST_ASSERT_EQUAL_UINT32(block[count - 1].timestamp, out[count - 1].timestamp);
+    float bytesPerReading = (float)FlashPartition::kSectorSize / (8 * count);
+    float days = 444.0f * 1024 / bytesPerReading * 2 / 86400;
+    char message[128];
+    snprintf(message, sizeof(message), "%d readings/block, %.2f bytes/reading (raw 28), 444 KB holds %.1f days of 2 s readings",
+             count, bytesPerReading, days);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(bytesPerReading < 28.0f / 5);
+}
+
+void test_reading_log_survives_rtc_reset(void) {
+    FilePartition part(kImagePath, kSmallPartition);
+    TEST_ASSERT_TRUE(part.open());
+    {
+        TimeSeriesStore store(part);
+        TEST_ASSERT_TRUE(store.begin());
+        ReadingLog log(store, 64);
+        for (int i = 0; i < 20; i++) {
+            TEST_ASSERT_TRUE(log.add(simpleReading(5000 + i * 2, 100.0f + i)));
+        }
+        TEST_ASSERT_TRUE(log.flush());
+    }
+
+    // 断电重启后 RTC 从0开始: 读数平移到已存储的最新时间之后，间隔不变
+    TimeSeriesStore store(part);
+    TEST_ASSERT_TRUE(store.begin());
+    ReadingLog log(store, 64);
+    TEST_ASSERT_TRUE(log.add(simpleReading(10, 150.0f)));
+    TEST_ASSERT_TRUE(log.add(simpleReading(12, 151.0f)));
+    ReadingLog::Reading out[32];
+    int n = log.read(0, 0xFFFFFFFF, out, 32);
+    TEST_ASSERT_EQUAL_INT(22, n);
+    TEST_ASSERT_EQUAL_UINT32(5038, out[19].timestamp);
+    TEST_ASSERT_EQUAL_UINT32(5038, out[20].timestamp);
+    TEST_ASSERT_EQUAL_UINT32(5040, out[21].timestamp);
+    TEST_ASSERT_EQUAL_FLOAT(151.0f, out[21].glucose);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_file_partition_has_nor_semantics);
+    RUN_TEST(test_append_read_and_remount);
+    RUN_TEST(test_seek_finds_covering_record);
+    RUN_TEST(test_ring_overwrites_oldest_and_levels_wear);
+    RUN_TEST(test_power_loss_at_every_point_keeps_committed_records);
+    RUN_TEST(test_reading_log_round_trip_and_density);
+    RUN_TEST(test_reading_log_survives_rtc_reset);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,307 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <TraceLog.h>
+
+// 追踪事件日志的测试: 嵌套作用域、环形缓冲区覆盖、按核心分开记录、任务登记与 Chrome trace JSON 输出。
+// 最后一个测试用 std::thread 同时写入与读取，应在 ThreadSanitizer 下运行:
+//   pio test -e native-tsan -f test_trace
+// 不带 TSan 也可以运行:
+//   pio test -e native -f test_trace
+
+namespace {
+    unsigned long fakeNowUs = 0;
+
+    unsigned long fakeClock() {
+        return fakeNowUs;
+    }
+
+    std::vector<std::string> lines;
+
+    void captureLine(const char* line) {
+        lines.push_back(line);
+    }
+
+    std::string joinedJson() {
+        std::string json;
+        for (const std::string& line : lines) {
+            json += line;
+        }
+        return json;
+    }
+
+    TraceLog::Event events[TraceLog::kRingSize];
+
+    // 多线程测试中每个线程自己的时钟，时间戳与参数相同，用于检查读出的事件是否完整
+    thread_local unsigned long threadNowUs = 0;
+
+    unsigned long threadClock() {
+        return threadNowUs;
+    }
+}
+
+void setUp(void) {
+    TraceLog::getInstance().clear();
+    TraceLog::getInstance().begin(fakeClock);
+    fakeNowUs = 1000;
+    lines.clear();
+}
+
+void tearDown(void) {
+    TraceLog::getInstance().begin(nullptr);
+}
+
+void test_scopes_record_begin_and_end_in_order() {
+    TraceLog& log = TraceLog::getInstance();
+    {
+        TraceLog::Scope measurement(TraceLog::MEASUREMENT, 0);
+        fakeNowUs = 1200;
+        {
+            TraceLog::Scope read(TraceLog::SIGNAL_READ, 16);
+            fakeNowUs = 1500;
+        }
+        fakeNowUs = 2000;
+    }
+
+    int core = TraceLog::currentCore();
+    TEST_ASSERT_EQUAL(4, log.snapshot(core, events, TraceLog::kRingSize));
+    TEST_ASSERT_EQUAL_UINT16(TraceLog::MEASUREMENT, events[0].id);
+    TEST_ASSERT_EQUAL_UINT8(TraceLog::BEGIN, events[0].phase);
+    TEST_ASSERT_EQUAL_UINT32(1000, events[0].timestampUs);
+    TEST_ASSERT_EQUAL_UINT16(TraceLog::SIGNAL_READ, events[1].id);
+    TEST_ASSERT_EQUAL_UINT32(16, events[1].arg);
+    TEST_ASSERT_EQUAL_UINT32(1200, events[1].timestampUs);
+    TEST_ASSERT_EQUAL_UINT16(TraceLog::SIGNAL_READ, events[2].id);
+    TEST_ASSERT_EQUAL_UINT8(TraceLog::END, events[2].phase);
+    TEST_ASSERT_EQUAL_UINT32(1500, events[2].timestampUs);
+    TEST_ASSERT_EQUAL_UINT16(TraceLog::MEASUREMENT, events[3].id);
+    TEST_ASSERT_EQUAL_UINT8(TraceLog::END, events[3].phase);
+    TEST_ASSERT_EQUAL_UINT32(2000, events[3].timestampUs);
+    TEST_ASSERT_EQUAL_UINT8(core, events[3].core);
+    TEST_ASSERT_EQUAL_UINT8(log.currentTask(), events[3].task);
+}
+
+void test_nothing_is_recorded_without_a_clock() {
+    TraceLog& log = TraceLog::getInstance();
+    log.begin(nullptr);
+    log.record(TraceLog::DHT_READ, TraceLog::INSTANT, 1);
+    TEST_ASSERT_EQUAL_UINT32(0, log.getRecordedCount(TraceLog::currentCore()));
+}
+
+void test_ring_keeps_the_newest_events() {
+    TraceLog& log = TraceLog::getInstance();
+    const uint32_t total = TraceLog::kRingSize * 3 + 7;
+    for (uint32_t i = 0; i < total; i++) {
+        fakeNowUs = i;
+        log.record(TraceLog::PPG_UPDATE, TraceLog::INSTANT, i, 0);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(total, log.getRecordedCount(0));
+    TEST_ASSERT_EQUAL((int)TraceLog::kRingSize, log.snapshot(0, events, TraceLog::kRingSize));
+    for (uint32_t i = 0; i < TraceLog::kRingSize; i++) {
+        TEST_ASSERT_EQUAL_UINT32(total - TraceLog::kRingSize + i, events[i].arg);
+    }
+    // 容量不足时保留最新的
+    TEST_ASSERT_EQUAL(10, log.snapshot(0, events, 10));
+    TEST_ASSERT_EQUAL_UINT32(total - 10, events[0].arg);
+    TEST_ASSERT_EQUAL_UINT32(total - 1, events[9].arg);
+}
+
+void test_cores_are_recorded_separately() {
+    TraceLog& log = TraceLog::getInstance();
+    log.record(TraceLog::BLE_NOTIFY, TraceLog::BEGIN, 0x00020008, 0);
+    log.record(TraceLog::BLE_NOTIFY, TraceLog::END, 0, 0);
+    log.record(TraceLog::PREDICT, TraceLog::BEGIN, 0, 1);
+    // 不存在的核心被忽略
+    log.record(TraceLog::PREDICT, TraceLog::BEGIN, 0, TraceLog::kCores);
+
+    TEST_ASSERT_EQUAL(2, log.snapshot(0, events, TraceLog::kRingSize));
+    TEST_ASSERT_EQUAL_UINT16(TraceLog::BLE_NOTIFY, events[0].id);
+    TEST_ASSERT_EQUAL_UINT32(0x00020008, events[0].arg);
+    TEST_ASSERT_EQUAL(1, log.snapshot(1, events, TraceLog::kRingSize));
+    TEST_ASSERT_EQUAL_UINT16(TraceLog::PREDICT, events[0].id);
+    TEST_ASSERT_EQUAL_UINT8(1, events[0].core);
+}
+
+void test_tasks_are_registered_once_per_thread() {
+    TraceLog& log = TraceLog::getInstance();
+    TEST_ASSERT_EQUAL(1, log.currentTask());
+    TEST_ASSERT_EQUAL(1, log.currentTask());
+    TEST_ASSERT_EQUAL_STRING("thread 1", log.getTaskName(1));
+    TEST_ASSERT_NULL(log.getTaskName(2));
+
+    // 登记满之后的任务记为0。线程都等到最后才退出: 退出的线程的地址可能被新线程复用 (与设备上复用任务句柄相同)
+    std::vector<int> tasks(TraceLog::kMaxTasks);
+    std::atomic<int> registered(0);
+    std::atomic<bool> release(false);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < TraceLog::kMaxTasks; i++) {
+        threads.emplace_back([&, i]() {
+            tasks[i] = log.currentTask();
+            registered.store(i + 1);
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+        });
+        while (registered.load() != i + 1) {
+            std::this_thread::yield();
+        }
+    }
+    release.store(true);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < TraceLog::kMaxTasks - 1; i++) {
+        TEST_ASSERT_EQUAL(i + 2, tasks[i]);
+    }
+    TEST_ASSERT_EQUAL(0, tasks[TraceLog::kMaxTasks - 1]);
+    TEST_ASSERT_EQUAL(1, log.currentTask());
+}
+
+void test_chrome_json_lines() {
+    // 同一核心上的两个任务: 推理被另一个任务的读取打断，各自的 B/E 在自己的时间线上配对
+    TraceLog& log = TraceLog::getInstance();
+    fakeNowUs = 5000;
+    log.record(TraceLog::INFERENCE, TraceLog::BEGIN, 0);
+    std::thread([&]() {
+        fakeNowUs = 5100;
+        log.record(TraceLog::DHT_READ, TraceLog::BEGIN, 0);
+        fakeNowUs = 5150;
+        log.record(TraceLog::DHT_READ, TraceLog::END, 0);
+    }).join();
+    fakeNowUs = 5200;
+    log.record(TraceLog::BLE_NOTIFY, TraceLog::INSTANT, 3);
+    fakeNowUs = 5250;
+    log.record(TraceLog::INFERENCE, TraceLog::END, 0);
+    log.writeChromeJson(captureLine);
+
+    // 开头、两个任务的名称、五个事件、结尾
+    TEST_ASSERT_EQUAL(9, (int)lines.size());
+    TEST_ASSERT_EQUAL_STRING("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", lines[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"thread 1\"}}",
+                             lines[1].c_str());
+    TEST_ASSERT_EQUAL_STRING(",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"thread 2\"}}",
+                             lines[2].c_str());
+    // 时间戳相对最早的事件
+    TEST_ASSERT_EQUAL_STRING(",{\"name\":\"GlucosePredictor::runInference\",\"ph\":\"B\",\"ts\":0,\"pid\":1,\"tid\":1,"
+                             "\"args\":{\"arg\":0,\"core\":1}}", lines[3].c_str());
+    TEST_ASSERT_EQUAL_STRING(",{\"name\":\"Dht22Controller::readData\",\"ph\":\"B\",\"ts\":100,\"pid\":1,\"tid\":2,"
+                             "\"args\":{\"arg\":0,\"core\":1}}", lines[4].c_str());
+    TEST_ASSERT_EQUAL_STRING(",{\"name\":\"Dht22Controller::readData\",\"ph\":\"E\",\"ts\":150,\"pid\":1,\"tid\":2,"
+                             "\"args\":{\"arg\":0,\"core\":1}}", lines[5].c_str());
+    TEST_ASSERT_EQUAL_STRING(",{\"name\":\"BleTransport::send\",\"ph\":\"i\",\"ts\":200,\"pid\":1,\"tid\":1,"
+                             "\"s\":\"t\",\"args\":{\"arg\":3,\"core\":1}}", lines[6].c_str());
+    TEST_ASSERT_EQUAL_STRING(",{\"name\":\"GlucosePredictor::runInference\",\"ph\":\"E\",\"ts\":250,\"pid\":1,\"tid\":1,"
+                             "\"args\":{\"arg\":0,\"core\":1}}", lines[7].c_str());
+    TEST_ASSERT_EQUAL_STRING("]}", lines[8].c_str());
+}
+
+void test_chrome_json_timestamps_across_clock_wrap() {
+    TraceLog& log = TraceLog::getInstance();
+    fakeNowUs = 0xFFFFFF00UL;
+    log.record(TraceLog::MEASUREMENT, TraceLog::BEGIN, 0, 1);
+    fakeNowUs = 0x100;
+    log.record(TraceLog::MEASUREMENT, TraceLog::END, 0, 1);
+    log.writeChromeJson(captureLine);
+
+    std::string json = joinedJson();
+    TEST_ASSERT_TRUE(json.find("\"ph\":\"B\",\"ts\":0,") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ph\":\"E\",\"ts\":512,") != std::string::npos);
+}
+
+void test_empty_log_is_valid_json() {
+    TraceLog::getInstance().writeChromeJson(captureLine);
+    TEST_ASSERT_EQUAL(2, (int)lines.size());
+    TEST_ASSERT_EQUAL_STRING("]}", lines[1].c_str());
+}
+
+void test_concurrent_writers_and_reader_never_see_torn_events() {
+    // 每个核心一个写入线程 (与设备上每个核心同一时刻只有一个任务在运行相同)，另一个线程反复读取
+    static TraceLog log;
+    log.begin(threadClock);
+    const uint32_t perCore = 200000;
+    std::atomic<bool> done(false);
+    std::vector<std::thread> writers;
+    for (int core = 0; core < TraceLog::kCores; core++) {
+        writers.emplace_back([core, perCore]() {
+            for (uint32_t i = 0; i < perCore; i++) {
+                uint32_t arg = ((uint32_t)core << 24) | i;
+                threadNowUs = arg;
+                log.record((TraceLog::Id)(arg % TraceLog::ID_COUNT), (TraceLog::Phase)(arg % 3), arg, core, core + 1);
+            }
+        });
+    }
+
+    // Unity 的断言只能在主线程中使用，读取线程只计数
+    static TraceLog::Event seen[TraceLog::kRingSize];
+    uint32_t snapshots = 0;
+    uint32_t checked = 0;
+    uint32_t torn = 0;
+    std::thread reader([&]() {
+        while (!done.load()) {
+            for (int core = 0; core < TraceLog::kCores; core++) {
+                int n = log.snapshot(core, seen, TraceLog::kRingSize);
+                for (int i = 0; i < n; i++) {
+                    const TraceLog::Event& e = seen[i];
+                    bool complete = e.timestampUs == e.arg && e.id == e.arg % TraceLog::ID_COUNT &&
+                                    e.phase == e.arg % 3 && e.core == core && e.task == core + 1 && (e.arg >> 24) == (uint32_t)core;
+                    // 按写入的顺序
+                    bool ordered = i == 0 || e.arg > seen[i - 1].arg;
+                    if (!complete || !ordered) {
+                        torn++;
+                    }
+                }
+                checked += n;
+            }
+            snapshots++;
+        }
+    });
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    done.store(true);
+    reader.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+
+    for (int core = 0; core < TraceLog::kCores; core++) {
+        TEST_ASSERT_EQUAL_UINT32(perCore, log.getRecordedCount(core));
+        // 写入结束后最新的 kRingSize 个事件都完整
+        TEST_ASSERT_EQUAL((int)TraceLog::kRingSize, log.snapshot(core, seen, TraceLog::kRingSize));
+        TEST_ASSERT_EQUAL_UINT32(((uint32_t)core << 24) | (perCore - 1), seen[TraceLog::kRingSize - 1].arg);
+    }
+    char message[96];
+    snprintf(message, sizeof(message), "%u snapshots, %u events checked", (unsigned)snapshots, (unsigned)checked);
+    TEST_MESSAGE(message);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_scopes_record_begin_and_end_in_order);
+    RUN_TEST(test_nothing_is_recorded_without_a_clock);
+    RUN_TEST(test_ring_keeps_the_newest_events);
+    RUN_TEST(test_cores_are_recorded_separately);
+    RUN_TEST(test_tasks_are_registered_once_per_thread);
+    RUN_TEST(test_chrome_json_lines);
+    RUN_TEST(test_chrome_json_timestamps_across_clock_wrap);
+    RUN_TEST(test_empty_log_is_valid_json);
+    RUN_TEST(test_concurrent_writers_and_reader_never_see_torn_events);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,214 @@
+#include <unity.h>
+#include <string.h>
+#include <math.h>
+#include <VitalsPublisher.h>
+
+// 合并通知的测试 (死区、限速、MTU放不下时的降级)，用假的GATT层记录发出的通知:
+//   pio test -e native -f test_vitals_publisher
+
+namespace {
+    class FakeGatt : public GattSink {
+    public:
+        uint8_t last[256];
+        size_t lastLength = 0;
+        int count = 0;
+        bool connected = true;
+
+        bool send(Characteristic characteristic, const uint8_t* data, size_t length) override {
+            if (!connected || characteristic != Characteristic::VITALS) {
+                return false;
+            }
+            memcpy(last, data, length);
+            lastLength = length;
+            count++;
+            return true;
+        }
+
+        VitalsPublisher::Decoded decoded() const {
+            VitalsPublisher::Decoded d;
+            TEST_ASSERT_TRUE(VitalsPublisher::decode(last, lastLength, &d));
+            return d;
+        }
+    };
+
+    FakeGatt gatt;
+
+    VitalsPublisher::Config config() {
+        VitalsPublisher::Config c;
+        c.glucoseDeadband = 1.0f;
+        c.heartRateDeadband = 1.0f;
+        c.spO2Deadband = 0.5f;
+        c.curveDeadband = 2.0f;
+        c.minIntervalMs = 1000;
+        c.maxSilenceMs = 30000;
+        c.curveStepMinutes = 5;
+        return c;
+    }
+
+    void setVitals(VitalsPublisher& p, float glucose, float hr, float spo2) {
+        p.setGlucose(glucose);
+        p.setHeartRate(hr);
+        p.setSpO2(spo2);
+    }
+
+    float curve[12];
+    void makeCurve(float start) {
+        for (int i = 0; i < 12; i++) curve[i] = start + i;
+    }
+}
+
+void setUp(void) {
+    gatt = FakeGatt();
+}
+
+void tearDown(void) {
+}
+
+void test_first_poll_sends_all_fields_in_one_notification(void) {
+    VitalsPublisher p(config());
+    p.setMtu(247);
+    setVitals(p, 105.3f, 72.0f, 98.0f);
+    makeCurve(105.0f);
+    p.setCurve(curve, 12);
+
+    TEST_ASSERT_TRUE(p.poll(0, 1234, gatt));
+    TEST_ASSERT_EQUAL_INT(1, gatt.count);
+    VitalsPublisher::Decoded d = gatt.decoded();
+    TEST_ASSERT_EQUAL_HEX8(0x0F, d.fields);
+    TEST_ASSERT_EQUAL_UINT32(1234, d.timestamp);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 105.3f, d.glucose);
+    TEST_ASSERT_EQUAL_FLOAT(72.0f, d.heartRate);
+    TEST_ASSERT_EQUAL_FLOAT(98.0f, d.spO2);
+    TEST_ASSERT_EQUAL_INT(12, d.curveCount);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 116.0f, d.curve[11]);
+}
+
+void test_deadband_suppresses_unchanged_fields(void) {
+    VitalsPublisher p(config());
+    p.setMtu(247);
+    setVitals(p, 100.0f, 70.0f, 97.0f);
+    TEST_ASSERT_TRUE(p.poll(0, 0, gatt));
+
+    // 变化都在死区内: 不发送
+    setVitals(p, 100.8f, 70.5f, 97.4f);
+    TEST_ASSERT_FALSE(p.poll(2000, 0, gatt));
+    TEST_ASSERT_EQUAL_INT(1, gatt.count);
+
+    // 只有血糖超出死区: 包中只有血糖 (与上次发出的值比较，小变化不会累积漏报)
+    p.setGlucose(101.2f);
+    TEST_ASSERT_TRUE(p.poll(4000, 0, gatt));
+    VitalsPublisher::Decoded d = gatt.decoded();
+    TEST_ASSERT_EQUAL_HEX8(VitalsPublisher::FIELD_GLUCOSE, d.fields);
+    TEST_ASSERT_EQUAL_UINT16(1, d.sequence);
+    TEST_ASSERT_TRUE(isnan(d.heartRate));
+
+    // 超过 maxSilenceMs 没有发送: 全量发送一次
+    TEST_ASSERT_TRUE(p.poll(40000, 0, gatt));
+    TEST_ASSERT_EQUAL_HEX8(0x07, gatt.decoded().fields);
+    TEST_ASSERT_EQUAL_UINT32(1, p.getSuppressedCount());
+}
+
+void test_rate_limited_by_connection_interval(void) {
+    VitalsPublisher p(config());
+    p.setMtu(247);
+    p.setGlucose(100.0f);
+    TEST_ASSERT_TRUE(p.poll(0, 0, gatt));
+
+    p.setGlucose(120.0f);
+    TEST_ASSERT_FALSE(p.poll(500, 0, gatt));        // 小于 minIntervalMs
+    TEST_ASSERT_TRUE(p.poll(1000, 0, gatt));
+
+    // 连接间隔大于 minIntervalMs 时按连接间隔限速
+    p.setConnectionIntervalMs(4000);
+    p.setGlucose(140.0f);
+    TEST_ASSERT_FALSE(p.poll(3000, 0, gatt));
+    TEST_ASSERT_TRUE(p.poll(5000, 0, gatt));
+    TEST_ASSERT_EQUAL_INT(3, gatt.count);
+}
+
+void test_curve_deadband_and_interval(void) {
+    VitalsPublisher p(config());
+    p.setMtu(247);
+    makeCurve(100.0f);
+    float lower[12], upper[12];
+    for (int i = 0; i < 12; i++) { lower[i] = curve[i] - 5; upper[i] = curve[i] + 5; }
+    p.setCurve(curve, 12, lower, upper);
+    TEST_ASSERT_TRUE(p.poll(0, 0, gatt));
+    VitalsPublisher::Decoded d = gatt.decoded();
+    TEST_ASSERT_TRUE(d.curveHasInterval);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 95.0f, d.lower[0]);
+
+    // 所有点的变化都不超过 curveDeadband: 不发送
+    makeCurve(101.5f);
+    p.setCurve(curve, 12, lower, upper);
+    TEST_ASSERT_FALSE(p.poll(2000, 0, gatt));
+    makeCurve(103.0f);
+    p.setCurve(curve, 12, lower, upper);
+    TEST_ASSERT_TRUE(p.poll(3000, 0, gatt));
+}
+
+void test_packet_fits_negotiated_mtu(void) {
+    VitalsPublisher p(config());
+    setVitals(p, 100.0f, 70.0f, 97.0f);
+    makeCurve(100.0f);
+    float lower[12], upper[12];
+    for (int i = 0; i < 12; i++) { lower[i] = curve[i] - 5; upper[i] = curve[i] + 5; }
+    p.setCurve(curve, 12, lower, upper);
+
+    // 默认 MTU 23: 20字节 = 头8 + 标量6 + 曲线头4 + 1个点
+    TEST_ASSERT_TRUE(p.poll(0, 0, gatt));
+    TEST_ASSERT_EQUAL_UINT32(20, gatt.lastLength);
+    VitalsPublisher::Decoded d = gatt.decoded();
+    TEST_ASSERT_EQUAL_INT(1, d.curveCount);
+    TEST_ASSERT_FALSE(d.curveHasInterval);
+
+    // MTU 64: 放得下整条曲线但放不下区间 (新的连接上全量发送)
+    p.onConnect();
+    p.setMtu(64);
+    TEST_ASSERT_TRUE(p.poll(1000, 0, gatt));
+    d = gatt.decoded();
+    TEST_ASSERT_EQUAL_INT(12, d.curveCount);
+    TEST_ASSERT_FALSE(d.curveHasInterval);
+    TEST_ASSERT_TRUE(gatt.lastLength <= 61);
+
+    // MTU 96: 全部放得下
+    p.onConnect();
+    p.setMtu(96);
+    TEST_ASSERT_TRUE(p.poll(2000, 0, gatt));
+    TEST_ASSERT_TRUE(gatt.decoded().curveHasInterval);
+}
+
+void test_failed_send_is_retried(void) {
+    VitalsPublisher p(config());
+    p.setGlucose(100.0f);
+    gatt.connected = false;
+    TEST_ASSERT_FALSE(p.poll(0, 0, gatt));
+    gatt.connected = true;
+    TEST_ASSERT_TRUE(p.poll(10, 0, gatt));
+    TEST_ASSERT_EQUAL_UINT16(0, gatt.decoded().sequence);
+    TEST_ASSERT_EQUAL_UINT32(1, p.getSentCount());
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_poll_sends_all_fields_in_one_notification);
+    RUN_TEST(test_deadband_suppresses_unchanged_fields);
+    RUN_TEST(test_rate_limited_by_connection_interval);
+    RUN_TEST(test_curve_deadband_and_interval);
+    RUN_TEST(test_packet_fits_negotiated_mtu);
+    RUN_TEST(test_failed_send_is_retried);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,243 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <WaveformCodec.h>
+#include <WaveformStreamer.h>
+
+// 原始波形流的测试: varint/zig-zag、帧的往返编解码、背压与丢样本计数，并打印PPG波形的压缩率:
+//   pio test -e native -f test_waveform_codec
+
+namespace {
+    // 假的GATT层: 保存发出的帧；budget 为还能发送的帧数 (<0 表示不限)，用完后模拟通知队列已满
+    class FakeGatt : public GattSink {
+    public:
+        uint8_t frames[256][WaveformStreamer::kMaxFrameSize];
+        size_t lengths[256];
+        int count = 0;
+        int budget = -1;
+
+        bool send(Characteristic characteristic, const uint8_t* data, size_t length) override {
+            if (characteristic != Characteristic::WAVEFORM || budget == 0 || count == 256) {
+                return false;
+            }
+            if (budget > 0) budget--;
+            memcpy(frames[count], data, length);
+            lengths[count++] = length;
+            return true;
+        }
+    };
+
+    FakeGatt* gatt;
+
+    // 合成的 MAX30102 PPG (IR, Red): 18位ADC、约1.2Hz的脉搏波、呼吸引起的基线漂移与噪声。
+    // 仓库中没有录制的波形，形状与幅度按指尖佩戴时的典型读数设定。
+    constexpr int kTraceLength = 1000;
+    int32_t trace[kTraceLength][2];
+
+    void makePpgTrace(float sampleRateHz) {
+        uint32_t seed = 12345;
+        for (int i = 0; i < kTraceLength; i++) {
+            float t = i / sampleRateHz;
+            float phase = fmodf(t * 1.2f, 1.0f);
+            // 收缩期快速上升、舒张期缓慢下降，带重搏切迹
+            float pulse = phase < 0.15f ? phase / 0.15f : expf(-(phase - 0.15f) * 3.0f) + 0.1f * sinf(phase * 12.0f);
+            float baseline = 300.0f * sinf(t * 2.0f * 3.14159f * 0.25f);
+            seed = seed * 1103515245u + 12345u;
+            float noise = (float)((seed >> 16) % 41) - 20.0f;
+            trace[i][0] = (int32_t)(120000.0f + baseline - 900.0f * pulse + noise);
+            trace[i][1] = (int32_t)(95000.0f + 0.8f * baseline - 600.0f * pulse + noise * 0.7f);
+        }
+    }
+
+    WaveformStreamer::Config ppgConfig(int framesPerPoll) {
+        WaveformStreamer::Config c = { WaveformCodec::STREAM_PPG, 2, 10, framesPerPoll };
+        return c;
+    }
+}
+
+void setUp(void) {
+    gatt = new FakeGatt();
+}
+
+void tearDown(void) {
+    delete gatt;
+}
+
+void test_varint_and_zigzag_round_trip(void) {
+    const int32_t values[] = { 0, 1, -1, 63, -64, 64, 300, -300, 131071, -131072, INT32_MAX, INT32_MIN };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        uint8_t buffer[WaveformCodec::kMaxVarintSize];
+        size_t n = WaveformCodec::writeVarint(WaveformCodec::zigzag(values[i]), buffer);
+        uint32_t decoded;
+        TEST_ASSERT_EQUAL_UINT32(n, WaveformCodec::readVarint(buffer, n, &decoded));
+        TEST_ASSERT_EQUAL_INT32(values[i], WaveformCodec::unzigzag(decoded));
+    }
+    // 小的差值只占1字节，18位的绝对值占3字节
+    uint8_t buffer[WaveformCodec::kMaxVarintSize];
+    TEST_ASSERT_EQUAL_UINT32(1, WaveformCodec::writeVarint(WaveformCodec::zigzag(-64), buffer));
+    TEST_ASSERT_EQUAL_UINT32(3, WaveformCodec::writeVarint(WaveformCodec::zigzag(262143), buffer));
+    // 不完整的 varint
+    buffer[0] = 0x80;
+    uint32_t v;
+    TEST_ASSERT_EQUAL_UINT32(0, WaveformCodec::readVarint(buffer, 1, &v));
+}
+
+void test_frame_round_trip_respects_capacity(void) {
+    makePpgTrace(100.0f);
+    WaveformCodec::FrameHeader header = { WaveformCodec::STREAM_PPG, 2, 7, 1000, 123456, 10, 0 };
+    uint8_t frame[64];
+    WaveformCodec::FrameEncoder encoder;
+    TEST_ASSERT_TRUE(encoder.begin(header, frame, sizeof(frame)));
+    int n = 0;
+    while (n < kTraceLength && encoder.addSample(trace[n])) n++;
+    size_t length = encoder.finish();
+    TEST_ASSERT_TRUE(length <= sizeof(frame));
+    TEST_ASSERT_TRUE(n > 10);
+
+    WaveformCodec::FrameHeader decoded;
+    int32_t samples[WaveformCodec::kMaxSamplesPerFrame * 2];
+    TEST_ASSERT_EQUAL_INT(n, WaveformCodec::decodeFrame(frame, length, &decoded, samples, WaveformCodec::kMaxSamplesPerFrame));
+    TEST_ASSERT_EQUAL_UINT8(WaveformCodec::STREAM_PPG, decoded.stream);
+    TEST_ASSERT_EQUAL_UINT8(2, decoded.channels);
+    TEST_ASSERT_EQUAL_UINT16(7, decoded.sequence);
+    TEST_ASSERT_EQUAL_UINT32(1000, decoded.firstSample);
+    TEST_ASSERT_EQUAL_UINT32(123456, decoded.timestampMs);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(&trace[0][0], samples, n * 2);
+
+    // 截断的帧被拒绝
+    TEST_ASSERT_EQUAL_INT(-1, WaveformCodec::decodeFrame(frame, length - 1, &decoded, samples, WaveformCodec::kMaxSamplesPerFrame));
+}
+
+void test_stream_round_trip_and_compression_ratio(void) {
+    makePpgTrace(100.0f);
+    WaveformStreamer streamer(ppgConfig(64));
+    streamer.setMtu(247);
+    streamer.setEnabled(true);
+
+    // 每次主循环读出一批 FIFO 样本后发送
+    int32_t received[kTraceLength][2];
+    int receivedCount = 0;
+    for (int i = 0; i < kTraceLength; i++) {
+        streamer.addSample(trace[i], (uint32_t)(i * 10));
+        if (i % 32 == 31 || i == kTraceLength - 1) {
+            streamer.poll(*gatt);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(0, streamer.pending());
+
+    uint32_t bytes = 0;
+    for (int f = 0; f < gatt->count; f++) {
+        WaveformCodec::FrameHeader h;
+        int n = WaveformCodec::decodeFrame(gatt->frames[f], gatt->lengths[f], &h, &received[receivedCount][0],
+                                           kTraceLength - receivedCount);
+        TEST_ASSERT_TRUE(n > 0);
+        TEST_ASSERT_EQUAL_UINT16(f, h.sequence);
+        TEST_ASSERT_EQUAL_UINT32(receivedCount, h.firstSample);
+        TEST_ASSERT_EQUAL_UINT32(receivedCount * 10, h.timestampMs);
+        receivedCount += n;
+        bytes += gatt->lengths[f];
+    }
+    TEST_ASSERT_EQUAL_INT(kTraceLength, receivedCount);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(&trace[0][0], &received[0][0], kTraceLength * 2);
+    TEST_ASSERT_EQUAL_UINT32(bytes, streamer.getStats().bytes);
+
+    // 与18位打包 (每通道3字节) 的原始数据相比
+    float packedBytes = kTraceLength * 2 * 3.0f;
+    float ratio = packedBytes / bytes;
+    char line[128];
+    snprintf(line, sizeof(line), "ppg: %d samples x 2 ch, %u bytes in %d frames, ratio %.2f vs 18-bit packed, %.0f B/s at 100 sps",
+             kTraceLength, (unsigned)bytes, gatt->count, ratio, bytes * 100.0f / kTraceLength);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(ratio > 1.5f);
+}
+
+void test_backpressure_retries_then_drops_oldest(void) {
+    makePpgTrace(100.0f);
+    WaveformStreamer streamer(ppgConfig(4));
+    streamer.setMtu(64);
+    streamer.setEnabled(true);
+
+    // 通知队列满: 帧留在缓冲区，序号不前进
+    for (int i = 0; i < 20; i++) streamer.addSample(trace[i], i);
+    gatt->budget = 0;
+    TEST_ASSERT_EQUAL_INT(0, streamer.poll(*gatt));
+    TEST_ASSERT_EQUAL_INT(20, streamer.pending());
+    gatt->budget = -1;
+    TEST_ASSERT_TRUE(streamer.poll(*gatt) > 0);
+    WaveformCodec::FrameHeader h;
+    int32_t samples[WaveformCodec::kMaxSamplesPerFrame * 2];
+    TEST_ASSERT_TRUE(WaveformCodec::decodeFrame(gatt->frames[0], gatt->lengths[0], &h, samples, WaveformCodec::kMaxSamplesPerFrame) > 0);
+    TEST_ASSERT_EQUAL_UINT16(0, h.sequence);
+    TEST_ASSERT_EQUAL_UINT32(0, h.firstSample);
+
+    // 缓冲区溢出: 丢弃最旧的样本，下一帧的 firstSample 出现缺口
+    while (streamer.pending() > 0) streamer.poll(*gatt);
+    int sent = gatt->count;
+    for (int i = 0; i < WaveformStreamer::kCapacity + 10; i++) streamer.addSample(trace[i % kTraceLength], i);
+    TEST_ASSERT_EQUAL_UINT32(10, streamer.getStats().dropped);
+    TEST_ASSERT_EQUAL_INT(WaveformStreamer::kCapacity, streamer.pending());
+    streamer.poll(*gatt);
+    TEST_ASSERT_TRUE(WaveformCodec::decodeFrame(gatt->frames[sent], gatt->lengths[sent], &h, samples, WaveformCodec::kMaxSamplesPerFrame) > 0);
+    TEST_ASSERT_EQUAL_UINT32(20 + 10, h.firstSample);
+}
+
+void test_default_mtu_fits_one_absolute_sample(void) {
+    // MTU 23: 数据区6字节放得下第一个样本的两个18位绝对值，之后的差分样本也能继续放入
+    WaveformStreamer streamer(ppgConfig(8));
+    streamer.setEnabled(true);
+    int32_t fullScale[2] = { 262143, 262143 };
+    streamer.addSample(fullScale, 0);
+    streamer.addSample(fullScale, 10);
+    TEST_ASSERT_TRUE(streamer.poll(*gatt) > 0);
+    TEST_ASSERT_EQUAL_INT(0, streamer.pending());
+    TEST_ASSERT_TRUE(gatt->lengths[0] <= 20);
+    TEST_ASSERT_EQUAL_UINT32(0, streamer.getStats().dropped);
+
+    // 连一个样本都放不下时丢弃该样本，而不是卡住
+    int32_t huge[2] = { INT32_MIN, INT32_MIN };
+    streamer.addSample(huge, 20);
+    streamer.addSample(fullScale, 30);
+    streamer.poll(*gatt);
+    TEST_ASSERT_EQUAL_INT(0, streamer.pending());
+    TEST_ASSERT_EQUAL_UINT32(1, streamer.getStats().dropped);
+}
+
+void test_disabled_stream_discards_samples(void) {
+    makePpgTrace(100.0f);
+    WaveformStreamer streamer(ppgConfig(4));
+    streamer.addSample(trace[0], 0);
+    TEST_ASSERT_EQUAL_INT(0, streamer.pending());
+
+    streamer.setEnabled(true);
+    streamer.addSample(trace[0], 0);
+    streamer.addSample(trace[1], 10);
+    streamer.setEnabled(false);
+    TEST_ASSERT_EQUAL_INT(0, streamer.poll(*gatt));
+    TEST_ASSERT_EQUAL_INT(0, streamer.pending());
+    TEST_ASSERT_EQUAL_INT(0, gatt->count);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_varint_and_zigzag_round_trip);
+    RUN_TEST(test_frame_round_trip_respects_capacity);
+    RUN_TEST(test_stream_round_trip_and_compression_ratio);
+    RUN_TEST(test_backpressure_retries_then_drops_oldest);
+    RUN_TEST(test_default_mtu_fits_one_absolute_sample);
+    RUN_TEST(test_disabled_stream_discards_samples);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+void setup() {
+    delay(2000); // 等待串口监视器连接
+    runUnityTests();
+}
+void loop() {}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
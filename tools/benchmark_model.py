@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""在电脑上用与 env:esp32-s3-benchmark 相同的固定输入运行模型，输出 Invoke() 耗时分位数。
+
+用法:
+    python tools/benchmark_model.py include/model_data.h
+    python tools/benchmark_model.py model_int8.tflite --runs 2000 --warmup 50 --json
+
+模型可以是 .tflite 文件、model_data.h 这类C数组头文件，或 make_model_image.py 生成的分区镜像。
+分位数按 nearest-rank 计算，与固件中的 LatencyStats 一致，两边的输出可以直接对照。
+主机上的 TFLite 解释器支持 Flex 算子，因此内置模型在设备上无法运行时，这里仍能测得基准。
+
+需要 tflite_runtime 或 tensorflow。
+"""
+import argparse
+import json
+import math
+import os
+import sys
+import time
+
+import numpy as np
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from gen_op_resolver import load_flatbuffer  # noqa: E402
+
+try:
+    from tflite_runtime.interpreter import Interpreter
+except ImportError:
+    try:
+        from tensorflow.lite import Interpreter
+    except ImportError:
+        sys.exit("error: install tflite_runtime or tensorflow")
+
+
+def fixed_input(detail):
+    """与 benchmark_main.cpp 的 fillInputs() 相同: 100 + 2 * (i % 10)，int8张量按量化参数换算。"""
+    count = int(np.prod(detail["shape"]))
+    values = np.array([100.0 + 2.0 * (i % 10) for i in range(count)], dtype=np.float32)
+    if detail["dtype"] == np.float32:
+        data = values
+    elif detail["dtype"] == np.int8:
+        scale, zero_point = detail["quantization"]
+        data = np.clip(np.round(values / scale) + zero_point, -128, 127).astype(np.int8)
+    else:
+        data = np.zeros(count, dtype=detail["dtype"])
+    return data.reshape(detail["shape"])
+
+
+def percentile(ordered, p):
+    rank = min(len(ordered), max(1, int(math.ceil(p / 100.0 * len(ordered)))))
+    return ordered[rank - 1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("model", help=".tflite / model_data.h / 分区镜像")
+    parser.add_argument("--runs", type=int, default=500, help="计时的 Invoke() 次数 (默认与 BENCHMARK_ITERATIONS 相同)")
+    parser.add_argument("--warmup", type=int, default=10, help="预热次数")
+    parser.add_argument("--threads", type=int, default=1, help="解释器线程数 (默认单线程，便于与MCU对照)")
+    parser.add_argument("--json", action="store_true", help="以JSON输出结果")
+    args = parser.parse_args()
+
+    data = load_flatbuffer(args.model)
+    interpreter = Interpreter(model_content=bytes(data), num_threads=args.threads)
+    interpreter.allocate_tensors()
+    for detail in interpreter.get_input_details():
+        interpreter.set_tensor(detail["index"], fixed_input(detail))
+
+    for _ in range(args.warmup):
+        interpreter.invoke()
+    samples = []
+    for _ in range(args.runs):
+        start = time.perf_counter()
+        interpreter.invoke()
+        samples.append((time.perf_counter() - start) * 1e6)
+    samples.sort()
+
+    result = {
+        "model_bytes": len(data),
+        "runs": len(samples),
+        "min_us": samples[0],
+        "p50_us": percentile(samples, 50),
+        "p90_us": percentile(samples, 90),
+        "p99_us": percentile(samples, 99),
+        "max_us": samples[-1],
+        "mean_us": sum(samples) / len(samples),
+    }
+    if args.json:
+        print(json.dumps(result))
+        return
+    print("Model: %d bytes" % result["model_bytes"])
+    print("Invoke x%d: min %.1f, p50 %.1f, p90 %.1f, p99 %.1f, max %.1f, mean %.1f us" % (
+        result["runs"], result["min_us"], result["p50_us"], result["p90_us"],
+        result["p99_us"], result["max_us"], result["mean_us"]))
+
+
+if __name__ == "__main__":
+    main()
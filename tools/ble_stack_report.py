@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""比较 Bluedroid 与 NimBLE 两种BLE协议栈的固件体积、初始化耗时与初始化后的空闲堆。
+
+用法:
+    python tools/ble_stack_report.py                      # 只比较体积 (编译两个环境)
+    python tools/ble_stack_report.py --port /dev/ttyUSB0  # 同时烧录并读取串口上的
+                                                          # "BLE <stack> init: N us, heap used M bytes, free F bytes"
+
+需要安装 PlatformIO；读取启动日志需要 pyserial。
+"""
+import argparse
+import re
+import subprocess
+import time
+
+from size_report import build_size
+
+ENVS = [("Bluedroid", "esp32-s3-bluedroid"), ("NimBLE", "esp32-s3-devkitc-1")]
+
+INIT_LINE = re.compile(r"BLE \S+ init: (\d+) us, heap used (\d+) bytes, free (\d+) bytes")
+
+
+def boot_report(env, port, timeout=30):
+    """烧录并复位开发板，返回 (初始化耗时 us, 初始化占用的堆, 初始化后的空闲堆)。"""
+    import serial  # pyserial
+
+    subprocess.run(["pio", "run", "-e", env, "-t", "upload", "--upload-port", port], check=True,
+                   capture_output=True)
+    with serial.Serial(port, 115200, timeout=1) as ser:
+        ser.dtr = False  # 复位开发板，从头读取启动日志
+        ser.rts = True
+        time.sleep(0.1)
+        ser.rts = False
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            line = ser.readline().decode(errors="ignore")
+            m = INIT_LINE.search(line)
+            if m:
+                return tuple(int(g) for g in m.groups())
+    return None
+
+
+def fmt(value):
+    return value if value is not None else "-"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", help="开发板串口，用于测量初始化耗时与空闲堆")
+    args = parser.parse_args()
+
+    rows = []
+    for label, env in ENVS:
+        ram, flash = build_size(env)
+        boot = boot_report(env, args.port) if args.port else None
+        init_us, heap_used, heap_free = boot if boot else (None, None, None)
+        rows.append((label, ram, flash, init_us, heap_used, heap_free))
+
+    print("%-10s %10s %10s %12s %12s %12s" % ("stack", "RAM", "Flash", "init (us)", "heap used", "heap free"))
+    for label, ram, flash, init_us, heap_used, heap_free in rows:
+        print("%-10s %10d %10d %12s %12s %12s" % (label, ram, flash, fmt(init_us), fmt(heap_used), fmt(heap_free)))
+
+    def delta(i):
+        a, b = rows[0][i], rows[1][i]
+        return a - b if a is not None and b is not None else "-"
+
+    # 正数表示 NimBLE 更少 (空闲堆一列为负数表示 NimBLE 更多)
+    print("savings:   %10s %10s %12s %12s %12s" % (delta(1), delta(2), delta(3), delta(4), delta(5)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""在电脑上比较浮点模型与int8量化模型的预测结果，并测量 Invoke() 耗时。
+
+用法:
+    python tools/compare_quantized.py model_float.tflite model_int8.tflite readings.csv
+    python tools/compare_quantized.py model_float.tflite model_int8.tflite readings.csv --column glucose --runs 500
+
+readings.csv 为记录下来的血糖序列 (例如串口日志整理得到)，按时间顺序每行一个读数；
+有表头时用 --column 指定列名，否则取第一列。与固件相同，每次用最近 10 个读数作为输入
+(见 GlucosePredictor::kHistorySize)，int8 模型按张量的 scale/zero_point 量化输入、反量化输出。
+
+需要 tflite_runtime 或 tensorflow。主机上的耗时只用于比较两种模型的相对快慢，
+ESP32-S3 上的实际耗时见串口输出的 "invoke ... us"。
+"""
+import argparse
+import csv
+import statistics
+import sys
+import time
+
+import numpy as np
+
+try:
+    from tflite_runtime.interpreter import Interpreter
+except ImportError:
+    try:
+        from tensorflow.lite import Interpreter
+    except ImportError:
+        sys.exit("error: install tflite_runtime or tensorflow")
+
+HISTORY_SIZE = 10  # 与 GlucosePredictor::kHistorySize 一致
+
+
+def load_readings(path, column):
+    with open(path, newline="", encoding="utf-8") as f:
+        rows = list(csv.reader(f))
+    if not rows:
+        sys.exit("error: %s is empty" % path)
+    index = 0
+    try:
+        float(rows[0][0])
+    except ValueError:
+        header, rows = rows[0], rows[1:]
+        if column is not None:
+            if column not in header:
+                sys.exit("error: column '%s' not found in %s" % (column, path))
+            index = header.index(column)
+    return [float(r[index]) for r in rows if r and r[index].strip()]
+
+
+class Model:
+    def __init__(self, path):
+        self.interpreter = Interpreter(model_path=path)
+        self.interpreter.allocate_tensors()
+        self.input = self.interpreter.get_input_details()[0]
+        self.output = self.interpreter.get_output_details()[0]
+        if list(self.input["shape"]) != [1, HISTORY_SIZE]:
+            sys.exit("error: %s input shape %s, expected [1, %d]" % (path, list(self.input["shape"]), HISTORY_SIZE))
+        self.quantized = self.input["dtype"] == np.int8
+        self.invoke_us = []
+
+    def predict(self, window):
+        x = np.asarray(window, dtype=np.float32).reshape(1, HISTORY_SIZE)
+        if self.quantized:
+            scale, zero_point = self.input["quantization"]
+            x = np.clip(np.round(x / scale) + zero_point, -128, 127).astype(np.int8)
+        self.interpreter.set_tensor(self.input["index"], x)
+        start = time.perf_counter()
+        self.interpreter.invoke()
+        self.invoke_us.append((time.perf_counter() - start) * 1e6)
+        y = self.interpreter.get_tensor(self.output["index"]).reshape(-1)[0]
+        if self.quantized:
+            scale, zero_point = self.output["quantization"]
+            return scale * (float(y) - zero_point)
+        return float(y)
+
+
+def percentile(values, p):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(round(p / 100.0 * (len(ordered) - 1))))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("float_model", help="浮点 .tflite")
+    parser.add_argument("int8_model", help="全整数int8量化 .tflite")
+    parser.add_argument("readings", help="记录的血糖序列 CSV")
+    parser.add_argument("--column", help="CSV 中血糖值所在的列名")
+    parser.add_argument("--runs", type=int, default=200, help="额外的 Invoke() 计时次数")
+    args = parser.parse_args()
+
+    readings = load_readings(args.readings, args.column)
+    if len(readings) < HISTORY_SIZE:
+        sys.exit("error: need at least %d readings, got %d" % (HISTORY_SIZE, len(readings)))
+
+    ref, quant = Model(args.float_model), Model(args.int8_model)
+    if not quant.quantized:
+        print("warning: %s has a float input tensor" % args.int8_model, file=sys.stderr)
+
+    errors = []
+    for i in range(len(readings) - HISTORY_SIZE + 1):
+        window = readings[i:i + HISTORY_SIZE]
+        errors.append(quant.predict(window) - ref.predict(window))
+
+    abs_errors = [abs(e) for e in errors]
+    print("windows:        %d" % len(errors))
+    print("MAE:            %.3f mg/dL" % statistics.mean(abs_errors))
+    print("RMSE:           %.3f mg/dL" % (statistics.mean(e * e for e in errors) ** 0.5))
+    print("max |error|:    %.3f mg/dL" % max(abs_errors))
+    print("bias:           %+.3f mg/dL" % statistics.mean(errors))
+
+    # 单独计时: 重复调用同一窗口，排除数据准备的开销
+    window = readings[-HISTORY_SIZE:]
+    for model in (ref, quant):
+        model.invoke_us = []
+        for _ in range(args.runs):
+            model.predict(window)
+    print("")
+    print("%-8s %10s %10s %10s" % ("Invoke()", "p50 us", "p95 us", "max us"))
+    for name, model in (("float32", ref), ("int8", quant)):
+        print("%-8s %10.1f %10.1f %10.1f" % (name, percentile(model.invoke_us, 50),
+                                            percentile(model.invoke_us, 95), max(model.invoke_us)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""根据 AllocateTensors() 的实测用量生成 include/model_arena.h (Tensor Arena 大小)。
+
+推荐流程 (dry run):
+    pio test -e esp32-s3-devkitc-1 -f test_predictor_arena -v > arena.log
+    python tools/gen_arena_size.py --from-log arena.log
+
+也可以直接给出实测值，或在无法运行解释器时根据模型做静态估算 (所有激活张量之和，
+不考虑内存复用，是偏大的上界):
+    python tools/gen_arena_size.py --measured 12345
+    python tools/gen_arena_size.py --estimate include/model_data.h
+
+dry run 在模型含有没有TFLM内核的算子 (如 Flex 算子，见 include/model_ops.h) 时失败，
+此时只能使用静态估算，生成的文件中 kModelArenaMeasured 为 false，固件启动时打印警告。
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from gen_op_resolver import FlatTable, load_flatbuffer  # noqa: E402
+
+# TensorType -> 元素字节数
+TYPE_SIZES = {0: 4, 1: 2, 2: 4, 3: 1, 4: 8, 5: 8, 6: 1, 7: 2, 9: 1, 10: 8, 11: 16, 16: 4}
+# arena 中除张量外的固定开销 (解释器/分配器的运行时结构)
+RUNTIME_OVERHEAD = 1024
+
+
+def estimate(model_path):
+    data = load_flatbuffer(model_path)
+    model = FlatTable(data, struct.unpack_from("<I", data, 0)[0])
+    buffers = model.tables(4)  # Model.buffers
+
+    def is_constant(index):
+        off = buffers[index].indirect(0) if index < len(buffers) else None
+        return off is not None and struct.unpack_from("<I", data, off)[0] > 0
+
+    total = 0
+    for subgraph in model.tables(2):  # Model.subgraphs
+        for tensor in subgraph.tables(0):  # SubGraph.tensors
+            if is_constant(tensor.scalar(2, "<I")):
+                continue  # 权重留在flash中，不占用arena
+            size = TYPE_SIZES.get(tensor.scalar(1, "<b"), 4)
+            shape = tensor.indirect(0)
+            if shape is not None:
+                for k in range(struct.unpack_from("<I", data, shape)[0]):
+                    size *= max(struct.unpack_from("<i", data, shape + 4 + 4 * k)[0], 1)
+            total += (size + 15) & ~15  # 每个张量按16字节对齐
+    return total + RUNTIME_OVERHEAD
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument("--from-log", help="包含 'arena_used_bytes=N' 的测试日志")
+    src.add_argument("--measured", type=int, help="实测的 arena_used_bytes()")
+    src.add_argument("--estimate", metavar="MODEL", help="根据模型静态估算")
+    parser.add_argument("--margin", type=float, default=0.15, help="安全余量比例 (默认 0.15)")
+    parser.add_argument("-o", "--output", default="include/model_arena.h")
+    args = parser.parse_args()
+
+    if args.from_log:
+        m = re.search(r"arena_used_bytes=(\d+)", open(args.from_log, errors="ignore").read())
+        if not m:
+            sys.exit("error: no 'arena_used_bytes=' line in %s" % args.from_log)
+        used, measured, source = int(m.group(1)), True, "dry run (AllocateTensors)"
+    elif args.measured is not None:
+        used, measured, source = args.measured, True, "dry run (AllocateTensors)"
+    else:
+        used, measured, source = estimate(args.estimate), False, "static estimate of %s" % args.estimate
+
+    size = (int(used * (1.0 + args.margin)) + 15) & ~15
+    if measured:
+        note = "模型更换后请重新运行 dry run (见脚本说明) 以更新此文件。"
+    else:
+        note = ("未实测: 这是静态估算的上界，没有经过 AllocateTensors() 验证。dry run 成功后\n"
+                "// 请用 --from-log 重新生成此文件。")
+
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write("""#ifndef MODEL_ARENA_H
+#define MODEL_ARENA_H
+
+// =============================================================================
+// == 这是由 tools/gen_arena_size.py 自动生成的文件，请勿手动修改。           ==
+// =============================================================================
+// 来源: %s
+// %s
+
+#include <stddef.h>
+
+// AllocateTensors() 之后 interpreter->arena_used_bytes() 的实测值，或静态估算值
+constexpr size_t kModelArenaUsedBytes = %d;
+// true: 实测值; false: 静态估算的上界 (未考虑内存复用)
+constexpr bool kModelArenaMeasured = %s;
+// 实际分配的 Tensor Arena 大小 (含 %d%% 安全余量，16字节对齐)
+constexpr size_t kTensorArenaSize = %d;
+
+#endif // MODEL_ARENA_H
+""" % (source, note, used, "true" if measured else "false", round(args.margin * 100), size))
+    print("%s: used %d bytes -> arena %d bytes (%s)" % (args.output, used, size, source))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""扫描 .tflite 模型，生成只注册模型所需算子的 MicroMutableOpResolver 头文件。
+
+用法:
+    python tools/gen_op_resolver.py include/model_data.h -o include/model_ops.h
+    python tools/gen_op_resolver.py a.tflite b.tflite -o include/model_ops.h   # 多个模型取并集
+
+输入可以是 .tflite 文件、model_data.h 这类C数组头文件，或 make_model_image.py 生成的分区镜像。
+集成模型 (多个成员打包在一个镜像中) 取所有成员的算子并集。
+模型中的自定义算子 (CUSTOM，例如 Flex*) 无法自动注册，会在生成的头文件中列出，
+并在运行时由 GlucosePredictor 的算子检查给出明确的错误。加上 --strict 时直接报错退出。
+
+PlatformIO 构建前会通过 tools/pio_gen_op_resolver.py 自动运行本脚本。
+"""
+import argparse
+import re
+import struct
+import sys
+
+# schema.fbs 中 BuiltinOperator 的编号 -> MicroMutableOpResolver 的注册方法名
+# 值为 None 表示 TFLM 没有对应的内核
+BUILTIN_OPS = {
+    0: "AddAdd", 1: "AddAveragePool2D", 2: "AddConcatenation", 3: "AddConv2D",
+    4: "AddDepthwiseConv2D", 5: "AddDepthToSpace", 6: "AddDequantize", 7: None,
+    8: "AddFloor", 9: "AddFullyConnected", 10: None, 11: "AddL2Normalization",
+    12: "AddL2Pool2D", 13: None, 14: "AddLogistic", 15: None, 16: None,
+    17: "AddMaxPool2D", 18: "AddMul", 19: "AddRelu", 20: None, 21: "AddRelu6",
+    22: "AddReshape", 23: "AddResizeBilinear", 24: None, 25: "AddSoftmax",
+    26: "AddSpaceToDepth", 27: "AddSvdf", 28: "AddTanh", 29: None, 30: None,
+    31: None, 32: None, 33: None, 34: "AddPad", 35: None, 36: "AddGather",
+    37: "AddBatchToSpaceNd", 38: "AddSpaceToBatchNd", 39: "AddTranspose",
+    40: "AddMean", 41: "AddSub", 42: "AddDiv", 43: "AddSqueeze",
+    44: "AddUnidirectionalSequenceLSTM", 45: "AddStridedSlice", 46: None,
+    47: "AddExp", 48: None, 49: "AddSplit", 50: "AddLogSoftmax", 51: None,
+    52: None, 53: "AddCast", 54: "AddPrelu", 55: "AddMaximum", 56: "AddArgMax",
+    57: "AddMinimum", 58: "AddLess", 59: "AddNeg", 60: "AddPadV2",
+    61: "AddGreater", 62: "AddGreaterEqual", 63: "AddLessEqual", 64: None,
+    65: "AddSlice", 66: "AddSin", 67: "AddTransposeConv", 68: None, 69: None,
+    70: "AddExpandDims", 71: "AddEqual", 72: "AddNotEqual", 73: "AddLog",
+    74: "AddSum", 75: "AddSqrt", 76: "AddRsqrt", 77: "AddShape", 78: None,
+    79: "AddArgMin", 80: None, 81: None, 82: "AddReduceMax", 83: "AddPack",
+    84: "AddLogicalOr", 85: None, 86: "AddLogicalAnd", 87: "AddLogicalNot",
+    88: "AddUnpack", 89: None, 90: "AddFloorDiv", 91: None, 92: "AddSquare",
+    93: "AddZerosLike", 94: "AddFill", 95: "AddFloorMod", 96: None,
+    97: "AddResizeNearestNeighbor", 98: "AddLeakyRelu", 99: "AddSquaredDifference",
+    100: "AddMirrorPad", 101: "AddAbs", 102: "AddSplitV", 103: None, 104: "AddCeil",
+    105: None, 106: "AddAddN", 107: "AddGatherNd", 108: "AddCos", 109: None,
+    110: None, 111: "AddElu", 112: None, 113: None, 114: "AddQuantize", 115: None,
+    116: "AddRound", 117: "AddHardSwish", 118: "AddIf", 119: "AddWhile",
+    120: None, 121: None, 122: None, 123: "AddSelectV2", 124: None, 125: None,
+    126: "AddBatchMatMul", 127: None, 128: "AddCumSum", 129: "AddCallOnce",
+    130: "AddBroadcastTo", 131: None, 132: None, 133: None, 134: None, 135: None,
+    136: None, 137: None, 138: None, 139: None, 140: None, 141: None,
+    142: "AddVarHandle", 143: "AddReadVariable", 144: "AddAssignVariable",
+    145: "AddBroadcastArgs",
+}
+CUSTOM = 32
+# 旧版模型中 deprecated_builtin_code 的上限 (int8)
+PLACEHOLDER_FOR_GREATER_OP_CODES = 127
+
+
+def load_flatbuffers(path):
+    """读取模型，返回其中的 flatbuffer 列表 (集成模型按 ModelImage.h 中的目录拆分为各成员)。"""
+    if path.endswith((".h", ".cc", ".cpp")):
+        text = open(path, encoding="utf-8").read()
+        body = text[text.index("{") + 1:text.index("};")]
+        data = bytes(int(b, 16) for b in re.findall(r"0x([0-9a-fA-F]{2})", body))
+    else:
+        data = open(path, "rb").read()
+    if data[:4] == b"GMDL":  # 分区镜像，跳过32字节头
+        data = data[32:]
+    if data[:4] == b"GENS":  # 集成模型: count 后为 {offset, size} 目录
+        count = struct.unpack_from("<I", data, 4)[0]
+        members = []
+        for i in range(count):
+            offset, size = struct.unpack_from("<II", data, 8 + 8 * i)
+            members.append(data[offset:offset + size])
+    else:
+        members = [data]
+    for member in members:
+        if member[4:8] != b"TFL3":
+            sys.exit("error: %s is not a TFLite flatbuffer" % path)
+    return members
+
+
+def load_flatbuffer(path):
+    """读取模型，集成模型返回主模型 (第一个成员)。"""
+    return load_flatbuffers(path)[0]
+
+
+class FlatTable:
+    """最小化的 flatbuffer 表读取器，只够读取 Model.operator_codes。"""
+
+    def __init__(self, buf, pos):
+        self.buf = buf
+        self.pos = pos
+        vtable = pos - struct.unpack_from("<i", buf, pos)[0]
+        vt_len = struct.unpack_from("<H", buf, vtable)[0]
+        self.fields = [struct.unpack_from("<H", buf, vtable + 4 + 2 * i)[0]
+                       for i in range((vt_len - 4) // 2)]
+
+    def offset(self, field):
+        if field < len(self.fields) and self.fields[field]:
+            return self.pos + self.fields[field]
+        return None
+
+    def scalar(self, field, fmt, default=0):
+        off = self.offset(field)
+        return struct.unpack_from(fmt, self.buf, off)[0] if off is not None else default
+
+    def indirect(self, field):
+        off = self.offset(field)
+        return None if off is None else off + struct.unpack_from("<I", self.buf, off)[0]
+
+    def string(self, field):
+        off = self.indirect(field)
+        if off is None:
+            return None
+        length = struct.unpack_from("<I", self.buf, off)[0]
+        return self.buf[off + 4:off + 4 + length].decode("utf-8")
+
+    def ints(self, field):
+        off = self.indirect(field)
+        if off is None:
+            return []
+        count = struct.unpack_from("<I", self.buf, off)[0]
+        return list(struct.unpack_from("<%di" % count, self.buf, off + 4))
+
+    def tables(self, field):
+        off = self.indirect(field)
+        if off is None:
+            return []
+        count = struct.unpack_from("<I", self.buf, off)[0]
+        result = []
+        for i in range(count):
+            elem = off + 4 + 4 * i
+            result.append(FlatTable(self.buf, elem + struct.unpack_from("<I", self.buf, elem)[0]))
+        return result
+
+
+def model_ops(data):
+    """返回 (内置算子编号集合, 自定义算子名集合)。"""
+    model = FlatTable(data, struct.unpack_from("<I", data, 0)[0])
+    builtins, customs = set(), set()
+    for opcode in model.tables(1):  # Model.operator_codes
+        # OperatorCode: 0 deprecated_builtin_code(int8), 1 custom_code, 2 version, 3 builtin_code(int32)
+        code = max(opcode.scalar(0, "<b"), opcode.scalar(3, "<i"))
+        if code == CUSTOM:
+            customs.add(opcode.string(1))
+        else:
+            builtins.add(code)
+    return builtins, customs
+
+
+# schema.fbs 中 TensorType 的编号
+TENSOR_TYPE_FLOAT32 = 0
+TENSOR_TYPE_INT8 = 9
+
+
+def input_tensor_type(data):
+    """返回主子图第一个输入张量的 TensorType 编号。"""
+    model = FlatTable(data, struct.unpack_from("<I", data, 0)[0])
+    subgraph = model.tables(2)[0]           # Model.subgraphs[0]
+    tensors = subgraph.tables(0)            # SubGraph.tensors
+    return tensors[subgraph.ints(1)[0]].scalar(1, "<b")  # SubGraph.inputs[0] -> Tensor.type
+
+
+def render(sources, builtins, customs):
+    methods = sorted(BUILTIN_OPS[c] for c in builtins)
+    lines = [
+        "#ifndef MODEL_OPS_H",
+        "#define MODEL_OPS_H",
+        "",
+        "// =============================================================================",
+        "// ==                             重要说明                                   ==",
+        "// =============================================================================",
+        "// == 这是由 tools/gen_op_resolver.py 自动生成的文件，请勿手动修改。           ==",
+        "// =============================================================================",
+        "// 来源模型: %s" % ", ".join(sources),
+        "// 只注册模型实际使用的算子，替代链接全部内核的 AllOpsResolver。",
+        "",
+    ]
+    lines.append("// 以下自定义算子没有TFLM内核，无法注册。包含它们的模型会在加载时被拒绝 (主机模拟据此与设备一样拒绝内置模型):")
+    lines.append("constexpr const char* kModelUnsupportedOps[] = {")
+    for name in sorted(customs):
+        lines.append('    "%s",' % name)
+    lines += [
+        "    nullptr",
+        "};",
+        "",
+        "// 主机模拟中没有 TFLite Micro",
+        "#if !SIMULATOR",
+        '#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"',
+        "",
+        "constexpr int kModelOpCount = %d;" % len(methods),
+        "using ModelOpResolver = tflite::MicroMutableOpResolver<kModelOpCount>;",
+        "",
+        "inline bool registerModelOps(ModelOpResolver& resolver) {",
+    ]
+    for m in methods:
+        lines.append("    if (resolver.%s() != kTfLiteOk) return false;" % m)
+    lines += [
+        "    return true;",
+        "}",
+        "#endif // !SIMULATOR",
+        "",
+        "#endif // MODEL_OPS_H",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("models", nargs="+", help=".tflite / model_data.h / 分区镜像")
+    parser.add_argument("-o", "--output", required=True, help="生成的头文件路径")
+    parser.add_argument("--strict", action="store_true", help="模型包含无法注册的算子时报错退出")
+    args = parser.parse_args()
+
+    builtins, customs = set(), set()
+    for path in args.models:
+        for data in load_flatbuffers(path):
+            b, c = model_ops(data)
+            builtins |= b
+            customs |= c
+
+    unsupported = sorted(c for c in builtins if BUILTIN_OPS.get(c) is None)
+    if unsupported:
+        sys.exit("error: builtin ops without a TFLM kernel: %s" % ", ".join(map(str, unsupported)))
+    if customs:
+        msg = "custom ops cannot be registered automatically: %s" % ", ".join(sorted(customs))
+        if args.strict:
+            sys.exit("error: " + msg)
+        print("warning: " + msg, file=sys.stderr)
+
+    content = render([p.replace("\\", "/") for p in args.models], builtins, customs)
+    try:
+        if open(args.output, encoding="utf-8").read() == content:
+            return  # 内容未变化时不重写，避免触发重新编译
+    except FileNotFoundError:
+        pass
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(content)
+    print("%s: %d builtin ops" % (args.output, len(builtins)))
+
+
+if __name__ == "__main__":
+    main()
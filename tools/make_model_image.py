@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""将 .tflite 模型打包为模型分区镜像 (格式见 include/ModelImage.h)。
+
+用法:
+    python tools/make_model_image.py model.tflite --version 3 -o model.bin
+    python tools/make_model_image.py include/model_data.h --version 1 -o model.bin
+    python tools/make_model_image.py model_int8.tflite --version 4 --format int8 -o model.bin
+    python tools/make_model_image.py m0.tflite m1.tflite m2.tflite --version 5 -o model.bin   # 集成模型
+
+给出多个模型时打包为集成模型: 所有成员读取同一个输入窗口，固件合并为均值与预测区间
+(第一个为主模型，格式见 ModelImage.h 中的集成目录)。成员的输入输出格式必须一致。
+
+--format 缺省为 auto: 根据 (主) 模型输入张量的类型识别浮点模型或全整数int8量化模型，
+写入头部 flags (启动时 ModelStore 按精度偏好选择槽位，见 SELECT_FORMAT 命令)。
+
+烧写到分区 (无需重新烧写固件):
+    parttool.py --port /dev/ttyUSB0 --partition-table-file custom.csv \\
+        write_partition --partition-name model_a --input model.bin
+
+也可以通过BLE的模型更新特征值按 ModelStore.h 中描述的协议上传模型数据。
+"""
+import argparse
+import re
+import struct
+import sys
+import zlib
+
+from gen_op_resolver import TENSOR_TYPE_FLOAT32, TENSOR_TYPE_INT8, input_tensor_type
+
+MAGIC = 0x4C444D47  # "GMDL"
+HEADER_VERSION = 1
+HEADER_SIZE = 32
+SLOT_SIZE = 256 * 1024  # 与 custom.csv 中 model_a/model_b 的大小一致
+FORMATS = {"float32": 0, "int8": 1}  # 与 ModelImage::ModelFormat 一致
+ENSEMBLE_MAGIC = 0x534E4547  # "GENS"
+ENSEMBLE_ALIGN = 16  # 成员偏移的对齐 (flatbuffer 要求)
+
+
+def load_model(path):
+    """读取 .tflite 文件，或从 model_data.h 这类C数组头文件中提取字节。"""
+    if path.endswith(".h") or path.endswith(".cc") or path.endswith(".cpp"):
+        text = open(path, encoding="utf-8").read()
+        body = text[text.index("{") + 1:text.index("};")]
+        return bytes(int(b, 16) for b in re.findall(r"0x([0-9a-fA-F]{2})", body))
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def pack_ensemble(members):
+    """按 ModelImage.h 中的集成目录打包多个成员，每个成员的偏移按 ENSEMBLE_ALIGN 对齐。"""
+    offset = 8 + 8 * len(members)
+    directory = struct.pack("<II", ENSEMBLE_MAGIC, len(members))
+    body = b""
+    for member in members:
+        pad = -(offset + len(body)) % ENSEMBLE_ALIGN
+        body += b"\0" * pad
+        directory += struct.pack("<II", offset + len(body), len(member))
+        body += member
+    return directory + body
+
+
+def build_header(model, version, flags=0):
+    head = struct.pack("<IHHIIII", MAGIC, HEADER_VERSION, HEADER_SIZE, version,
+                       len(model), zlib.crc32(model) & 0xFFFFFFFF, flags)
+    head += struct.pack("<I", 0)  # reserved
+    return head + struct.pack("<I", zlib.crc32(head) & 0xFFFFFFFF)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("models", nargs="+", help=".tflite 文件或 model_data.h (多个时打包为集成模型)")
+    parser.add_argument("--version", type=int, required=True, help="模型版本号 (单调递增)")
+    parser.add_argument("--format", choices=["auto"] + sorted(FORMATS), default="auto", help="模型精度 (默认自动识别)")
+    parser.add_argument("-o", "--output", required=True, help="输出的分区镜像")
+    args = parser.parse_args()
+
+    members = [load_model(path) for path in args.models]
+    for path, member in zip(args.models, members):
+        if member[4:8] != b"TFL3":
+            sys.exit("error: %s is not a TFLite flatbuffer" % path)
+    model = members[0] if len(members) == 1 else pack_ensemble(members)
+    if HEADER_SIZE + len(model) > SLOT_SIZE:
+        sys.exit("error: model (%d bytes) does not fit in a %d KB slot" % (len(model), SLOT_SIZE // 1024))
+
+    fmt = args.format
+    if fmt == "auto":
+        tensor_type = input_tensor_type(members[0])
+        if tensor_type not in (TENSOR_TYPE_FLOAT32, TENSOR_TYPE_INT8):
+            sys.exit("error: unsupported input tensor type %d (expected float32 or int8)" % tensor_type)
+        fmt = "int8" if tensor_type == TENSOR_TYPE_INT8 else "float32"
+
+    image = build_header(model, args.version, FORMATS[fmt]) + model
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print("%s: version %d, %s model%s %d bytes, crc32 0x%08x" %
+          (args.output, args.version, fmt, " (ensemble of %d)" % len(members) if len(members) > 1 else "",
+           len(model), zlib.crc32(model) & 0xFFFFFFFF))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,15 @@
+# PlatformIO 构建前脚本: 从内置模型重新生成 include/model_ops.h
+# 在 platformio.ini 中通过 extra_scripts = pre:tools/pio_gen_op_resolver.py 启用
+import os
+import subprocess
+import sys
+
+Import("env")  # noqa: F821 (由 SCons 注入)
+
+project_dir = env.subst("$PROJECT_DIR")  # noqa: F821
+subprocess.check_call([
+    sys.executable,
+    os.path.join(project_dir, "tools", "gen_op_resolver.py"),
+    os.path.join(project_dir, "include", "model_data.h"),
+    "-o", os.path.join(project_dir, "include", "model_ops.h"),
+])
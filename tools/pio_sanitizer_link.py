@@ -0,0 +1,9 @@
+# PlatformIO 脚本: 把 build_flags 中的 -fsanitize=... 同时加到链接选项 (native-tsan 环境)
+# SCons 只把未知的 -f 选项当作编译选项，不加到链接时会缺少 sanitizer 运行库
+Import("env")  # noqa: F821 (由 SCons 注入)
+
+build_flags = env.GetProjectOption("build_flags", "")  # noqa: F821
+if not isinstance(build_flags, str):
+    build_flags = " ".join(build_flags)
+sanitizers = [f for f in build_flags.split() if f.startswith("-fsanitize=")]
+env.Append(LINKFLAGS=sanitizers)  # noqa: F821
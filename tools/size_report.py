@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""比较生成的 OpResolver 与 AllOpsResolver 的固件体积与预测器启动耗时。
+
+用法:
+    python tools/size_report.py                      # 只比较体积 (编译两个环境)
+    python tools/size_report.py --port /dev/ttyUSB0  # 同时烧录并读取串口上的 "Predictor init: N us"
+
+需要安装 PlatformIO；读取启动耗时需要 pyserial。
+"""
+import argparse
+import re
+import subprocess
+import sys
+import time
+
+ENVS = [("generated", "esp32-s3-devkitc-1"), ("all ops", "esp32-s3-allops")]
+
+
+def build_size(env):
+    out = subprocess.run(["pio", "run", "-e", env, "-t", "size"], capture_output=True, text=True)
+    if out.returncode != 0:
+        sys.exit(out.stdout + out.stderr)
+    ram = re.search(r"RAM:.*used (\d+) bytes", out.stdout)
+    flash = re.search(r"Flash:.*used (\d+) bytes", out.stdout)
+    return int(ram.group(1)), int(flash.group(1))
+
+
+def boot_time(env, port, timeout=30):
+    import serial  # pyserial
+
+    subprocess.run(["pio", "run", "-e", env, "-t", "upload", "--upload-port", port], check=True,
+                   capture_output=True)
+    with serial.Serial(port, 115200, timeout=1) as ser:
+        ser.dtr = False  # 复位开发板，从头读取启动日志
+        ser.rts = True
+        time.sleep(0.1)
+        ser.rts = False
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            line = ser.readline().decode(errors="ignore")
+            m = re.search(r"Predictor init: (\d+) us", line)
+            if m:
+                return int(m.group(1))
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", help="开发板串口，用于测量启动耗时")
+    args = parser.parse_args()
+
+    rows = []
+    for label, env in ENVS:
+        ram, flash = build_size(env)
+        init_us = boot_time(env, args.port) if args.port else None
+        rows.append((label, ram, flash, init_us))
+
+    print("%-10s %10s %10s %14s" % ("resolver", "RAM", "Flash", "init (us)"))
+    for label, ram, flash, init_us in rows:
+        print("%-10s %10d %10d %14s" % (label, ram, flash, init_us if init_us is not None else "-"))
+    (_, ram0, flash0, init0), (_, ram1, flash1, init1) = rows
+    print("savings:   %10d %10d %14s" % (ram1 - ram0, flash1 - flash0,
+                                          init1 - init0 if init0 is not None and init1 is not None else "-"))
+
+
+if __name__ == "__main__":
+    main()